@@ -0,0 +1,73 @@
+/**
+ * @file audio_dsp.h
+ * @brief Fixed-point sample kernels: gain, gain ramps, mixing, conversion
+ *
+ * Samples are signed 16-bit; gains are Q15 with AUDIO_DSP_UNITY meaning
+ * 1.0. On the ESP32-S3 (CONFIG_AUDIO_DSP_SIMD) gain and mixing run eight
+ * samples per instruction on the PIE vector unit when every buffer is
+ * 16-byte aligned (AUDIO_DSP_ALIGNED); other buffers and trailing samples
+ * go through the scalar reference kernels, which give identical results.
+ *
+ * Kernels work in place where a source and destination are the same
+ * buffer, and never allocate.
+ */
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIO_DSP_UNITY             32768
+#define AUDIO_DSP_ALIGNED           __attribute__((aligned(16)))
+
+// Samples per step of a gain ramp: 8 stereo frames, two vectors
+#define AUDIO_DSP_RAMP_SEGMENT      16
+
+// buf *= gain
+void audio_dsp_gain_s16(int16_t *buf, size_t count, uint16_t gain_q15);
+
+/*
+ * Linear ramp from `from` to `to` across the buffer, ending exactly on
+ * `to`. The gain changes every AUDIO_DSP_RAMP_SEGMENT samples, so the two
+ * samples of a stereo frame always share one.
+ */
+void audio_dsp_gain_ramp_s16(int16_t *buf, size_t count, uint16_t from, uint16_t to);
+
+// dst = saturate(dst + src)
+void audio_dsp_mix_s16(int16_t *dst, const int16_t *src, size_t count);
+
+// dst = saturate(dst + src * gain)
+void audio_dsp_mix_gain_s16(int16_t *dst, const int16_t *src, size_t count, uint16_t gain_q15);
+
+// Left-justify: dst = src << 16
+void audio_dsp_s16_to_s32(const int16_t *src, int32_t *dst, size_t count);
+
+// Round to the top 16 bits, saturating
+void audio_dsp_s32_to_s16(const int32_t *src, int16_t *dst, size_t count);
+
+// Scalar reference kernels, always built
+void audio_dsp_gain_s16_ref(int16_t *buf, size_t count, uint16_t gain_q15);
+void audio_dsp_mix_s16_ref(int16_t *dst, const int16_t *src, size_t count);
+void audio_dsp_mix_gain_s16_ref(int16_t *dst, const int16_t *src, size_t count, uint16_t gain_q15);
+
+/**
+ * @brief Time every kernel against its scalar reference
+ *
+ * Logs cycles per sample for both on a 1024-sample buffer and checks that
+ * the outputs match. Runs at boot with CONFIG_AUDIO_DSP_BENCHMARK.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM, or ESP_FAIL if any output differed
+ */
+esp_err_t audio_dsp_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
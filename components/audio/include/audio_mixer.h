@@ -0,0 +1,84 @@
+/**
+ * @file audio_mixer.h
+ * @brief UI sounds mixed over the playback stream
+ *
+ * Short PCM clips are loaded once into PSRAM and played on one of
+ * CONFIG_AUDIO_MIXER_VOICES voice slots, each with its own gain, on top
+ * of the stream from audio_stream.h, which is one more voice. The mix is
+ * built block by block in the decoder task, right after a DMA buffer
+ * frees, and the master volume is applied to the sum.
+ *
+ * audio_mixer_play() is a lock-free enqueue that never blocks and may be
+ * called from any task or ISR, a display button callback for instance:
+ *
+ *     static audio_clip_id_t s_click;
+ *     audio_mixer_load_clip(click_pcm, click_frames, 1, 22050, &s_click);
+ *     ...
+ *     audio_mixer_play(s_click, AUDIO_DSP_UNITY / 2);
+ *
+ * A trigger is heard within two output blocks, about 9 ms with the
+ * default CONFIG_AUDIO_DMA_FRAMES. When every voice is busy, the one that
+ * started first is cut off.
+ */
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint8_t audio_clip_id_t;
+
+typedef struct {
+    uint32_t triggers;              // Voices started
+    uint32_t dropped_triggers;      // Trigger queue full
+    uint32_t voice_steals;          // Voices cut off for a newer trigger
+    uint8_t active_voices;
+    uint8_t clips_loaded;
+    uint32_t last_latency_us;       // Trigger to speaker, upper bound
+    uint32_t max_latency_us;
+} audio_mixer_stats_t;
+
+/**
+ * @brief Copy a clip into PSRAM
+ *
+ * Clips stay loaded for the life of the system. A clip whose rate differs
+ * from the output is resampled as it plays.
+ *
+ * @param pcm 16-bit samples, interleaved if stereo
+ * @param frames Length in frames
+ * @param channels 1 or 2
+ * @param sample_rate Clip rate, 8000 to 48000
+ * @param[out] id Handle for audio_mixer_play()
+ * @return ESP_OK, ESP_ERR_NO_MEM if PSRAM or the clip table
+ *         (CONFIG_AUDIO_MIXER_CLIPS) is full, ESP_ERR_NOT_SUPPORTED if
+ *         playback is disabled
+ */
+esp_err_t audio_mixer_load_clip(const int16_t *pcm, size_t frames, uint8_t channels,
+                                uint32_t sample_rate, audio_clip_id_t *id);
+
+/**
+ * @brief Start a clip on a free voice
+ *
+ * @param clip From audio_mixer_load_clip()
+ * @param gain_q15 Voice gain, AUDIO_DSP_UNITY for full level
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an unknown clip, ESP_ERR_NO_MEM
+ *         if the trigger queue is full
+ */
+esp_err_t audio_mixer_play(audio_clip_id_t clip, uint16_t gain_q15);
+
+// Gain of the stream voice, before the master volume
+void audio_mixer_set_stream_gain(uint16_t gain_q15);
+
+esp_err_t audio_mixer_get_stats(audio_mixer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_MIXER_H
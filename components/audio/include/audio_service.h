@@ -3,20 +3,12 @@
 
 #include "esp_err.h"
 #include "system_service/system_types.h"
+#include "system_service/event_schema.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef enum {
-    AUDIO_EVENT_REGISTERED = 0,
-    AUDIO_EVENT_STARTED,
-    AUDIO_EVENT_STOPPED,
-    AUDIO_EVENT_VOLUME_CHANGED,
-    AUDIO_EVENT_PLAYBACK_STATE,
-    AUDIO_EVENT_ERROR,
-} audio_event_id_t;
-
 typedef struct {
     uint8_t volume;
     bool muted;
@@ -28,6 +20,17 @@ typedef struct {
     uint32_t duration_ms;
 } audio_playback_event_t;
 
+/* Volume is state: a newer value supersedes a pending one */
+#define AUDIO_EVENT_SCHEMA(X) \
+    X(AUDIO_EVENT_REGISTERED,       "audio.registered",     system_event_no_payload_t, 1, QUEUED) \
+    X(AUDIO_EVENT_STARTED,          "audio.started",        system_event_no_payload_t, 1, QUEUED) \
+    X(AUDIO_EVENT_STOPPED,          "audio.stopped",        system_event_no_payload_t, 1, QUEUED) \
+    X(AUDIO_EVENT_VOLUME_CHANGED,   "audio.volume_changed", audio_volume_event_t,      1, LATEST) \
+    X(AUDIO_EVENT_PLAYBACK_STATE,   "audio.playback_state", audio_playback_event_t,    1, QUEUED) \
+    X(AUDIO_EVENT_ERROR,            "audio.error",          system_event_bytes_t,      1, QUEUED)
+
+SYSTEM_EVENT_SCHEMA_DECLARE(AUDIO_EVENT_SCHEMA, AUDIO_EVENT, SYSTEM_EVENT_RANGE_AUDIO);
+
 esp_err_t audio_service_init(void);
 
 esp_err_t audio_service_deinit(void);
@@ -0,0 +1,97 @@
+/**
+ * @file audio_stream.h
+ * @brief Streaming playback: PSRAM ring buffer, decoder task, I2S DMA
+ *
+ * One stream plays at a time. Its owner writes PCM or IMA ADPCM into a
+ * ring buffer in PSRAM; a decoder task pinned to
+ * CONFIG_AUDIO_DECODER_CORE turns it into 16-bit stereo blocks of
+ * CONFIG_AUDIO_DMA_FRAMES frames and feeds them to the two I2S DMA
+ * buffers. Writers block only on the ring buffer, never on the event bus.
+ *
+ * If the ring runs dry while a stream plays, the block is completed with
+ * silence and counted as starved; if the decoder misses a DMA deadline,
+ * the DMA repeats silence and counts an underrun.
+ *
+ * Apps reach the same functions through app_context_t::audio.
+ */
+
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUDIO_CODEC_PCM_S16 = 0,        // Little-endian 16-bit, interleaved if stereo
+    AUDIO_CODEC_IMA_ADPCM,          // Headerless 4-bit IMA ADPCM, see below
+} audio_codec_t;
+
+/*
+ * IMA ADPCM streams carry no block headers: the predictor starts at 0 with
+ * step index 0 when the stream opens. Mono packs two samples per byte, low
+ * nibble first; stereo packs one left (low nibble) and one right sample per
+ * byte.
+ */
+typedef struct {
+    audio_codec_t codec;
+    uint32_t sample_rate;           // 8000 to 48000
+    uint8_t channels;               // 1 or 2
+} audio_stream_format_t;
+
+typedef struct {
+    bool active;                    // A stream is open or draining
+    uint32_t sample_rate;
+    uint32_t frames_played;         // Since the stream opened
+    uint32_t starved_blocks;        // Blocks padded with silence, ring empty
+    uint32_t dma_underruns;         // DMA buffers sent before they were refilled
+    uint32_t buffered_bytes;        // Input waiting in the ring
+    uint32_t buffered_ms;           // Same, as play time
+    uint32_t latency_ms;            // Write to speaker: ring plus DMA buffers
+} audio_stream_stats_t;
+
+// Allocate the ring and the I2S channel; called by audio_service_init()
+esp_err_t audio_stream_init(void);
+
+/**
+ * @brief Start a stream
+ *
+ * @param owner Service or app the stream belongs to
+ * @param format Input encoding, rate and channel count
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if another stream is open or
+ *         draining, ESP_ERR_NOT_SUPPORTED if no I2S pins are configured
+ */
+esp_err_t audio_stream_open(system_service_id_t owner, const audio_stream_format_t *format);
+
+/**
+ * @brief Queue encoded input
+ *
+ * Blocks up to timeout_ms while the ring is full. Partial writes are
+ * reported through written; ESP_ERR_TIMEOUT means not everything fit.
+ */
+esp_err_t audio_stream_write(system_service_id_t owner, const void *data, size_t len,
+                             size_t *written, uint32_t timeout_ms);
+
+/**
+ * @brief End the owner's stream
+ *
+ * @param drain true to play what is queued first, false to stop now
+ */
+esp_err_t audio_stream_close(system_service_id_t owner, bool drain);
+
+// Output gain, Q15 (32768 = unity), ramped to over one block; set by audio_set_volume()
+void audio_stream_set_gain(uint16_t gain_q15);
+
+esp_err_t audio_stream_get_stats(audio_stream_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_STREAM_H
@@ -0,0 +1,50 @@
+/**
+ * @file audio_internal.h
+ * @brief Glue between the stream decoder task and the mixer
+ */
+
+#ifndef AUDIO_INTERNAL_H
+#define AUDIO_INTERNAL_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Provided by audio_stream.c
+ * ============================================================================ */
+
+/** Wake the decoder task to start output; safe from ISRs */
+void audio_stream_wake(void);
+
+/* ============================================================================
+ * Provided by audio_mixer.c
+ * ============================================================================ */
+
+/** Enable clips and triggers; called once the decoder task exists */
+esp_err_t audio_mixer_init(void);
+
+/** Voices are playing or triggers are waiting, so output must run */
+bool audio_mixer_busy(void);
+
+/**
+ * @brief Build the mix in one output block; decoder task only
+ *
+ * @param block Stereo block holding the decoded stream, or silence
+ * @param frames Frames in the block
+ * @param sample_rate Output rate
+ * @param stream true if the block carries stream audio to scale by the
+ *               stream voice gain
+ */
+void audio_mixer_render(int16_t *block, size_t frames, uint32_t sample_rate, bool stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_INTERNAL_H
@@ -0,0 +1,288 @@
+#include "audio_dsp.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "audio_dsp";
+
+#define IS_ALIGNED(p)           ((((uintptr_t)(p)) & 15) == 0)
+#define VECTOR_SAMPLES          8
+#define BENCH_SAMPLES           1024
+#define BENCH_ROUNDS            16
+
+#if CONFIG_AUDIO_DSP_SIMD
+#define DSP_BACKEND             "PIE SIMD"
+#else
+#define DSP_BACKEND             "scalar"
+#endif
+
+static inline int16_t saturate_s16(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+/* ============================================================================
+ * Scalar reference
+ * ============================================================================ */
+
+void audio_dsp_gain_s16_ref(int16_t *buf, size_t count, uint16_t gain_q15)
+{
+    if (gain_q15 >= AUDIO_DSP_UNITY) {
+        return;
+    }
+    int32_t gain = gain_q15;
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = (int16_t)((buf[i] * gain) >> 15);
+    }
+}
+
+void audio_dsp_mix_s16_ref(int16_t *dst, const int16_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = saturate_s16((int32_t)dst[i] + src[i]);
+    }
+}
+
+void audio_dsp_mix_gain_s16_ref(int16_t *dst, const int16_t *src, size_t count, uint16_t gain_q15)
+{
+    if (gain_q15 >= AUDIO_DSP_UNITY) {
+        audio_dsp_mix_s16_ref(dst, src, count);
+        return;
+    }
+    int32_t gain = gain_q15;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = saturate_s16((int32_t)dst[i] + ((src[i] * gain) >> 15));
+    }
+}
+
+/* ============================================================================
+ * Dispatch
+ * ============================================================================ */
+
+#if CONFIG_AUDIO_DSP_SIMD
+// audio_dsp_aes3.S; counts are in vectors of 8 samples, gains below unity
+void audio_dsp_gain_s16_aes3(int16_t *buf, size_t vectors, int16_t gain_q15);
+void audio_dsp_mix_s16_aes3(int16_t *dst, const int16_t *src, size_t vectors);
+void audio_dsp_mix_gain_s16_aes3(int16_t *dst, const int16_t *src, size_t vectors, int16_t gain_q15);
+#endif
+
+void audio_dsp_gain_s16(int16_t *buf, size_t count, uint16_t gain_q15)
+{
+    if (gain_q15 >= AUDIO_DSP_UNITY) {
+        return;
+    }
+#if CONFIG_AUDIO_DSP_SIMD
+    if (IS_ALIGNED(buf) && count >= VECTOR_SAMPLES) {
+        size_t vectors = count / VECTOR_SAMPLES;
+        audio_dsp_gain_s16_aes3(buf, vectors, (int16_t)gain_q15);
+        buf += vectors * VECTOR_SAMPLES;
+        count -= vectors * VECTOR_SAMPLES;
+    }
+#endif
+    audio_dsp_gain_s16_ref(buf, count, gain_q15);
+}
+
+void audio_dsp_gain_ramp_s16(int16_t *buf, size_t count, uint16_t from, uint16_t to)
+{
+    if (from == to) {
+        audio_dsp_gain_s16(buf, count, to);
+        return;
+    }
+    
+    size_t segments = (count + AUDIO_DSP_RAMP_SEGMENT - 1) / AUDIO_DSP_RAMP_SEGMENT;
+    int32_t delta = (int32_t)to - (int32_t)from;
+    for (size_t i = 0; i < segments; i++) {
+        size_t offset = i * AUDIO_DSP_RAMP_SEGMENT;
+        size_t len = count - offset;
+        if (len > AUDIO_DSP_RAMP_SEGMENT) {
+            len = AUDIO_DSP_RAMP_SEGMENT;
+        }
+        int32_t gain = from + delta * (int32_t)(i + 1) / (int32_t)segments;
+        audio_dsp_gain_s16(buf + offset, len, (uint16_t)gain);
+    }
+}
+
+void audio_dsp_mix_s16(int16_t *dst, const int16_t *src, size_t count)
+{
+#if CONFIG_AUDIO_DSP_SIMD
+    if (IS_ALIGNED(dst) && IS_ALIGNED(src) && count >= VECTOR_SAMPLES) {
+        size_t vectors = count / VECTOR_SAMPLES;
+        audio_dsp_mix_s16_aes3(dst, src, vectors);
+        dst += vectors * VECTOR_SAMPLES;
+        src += vectors * VECTOR_SAMPLES;
+        count -= vectors * VECTOR_SAMPLES;
+    }
+#endif
+    audio_dsp_mix_s16_ref(dst, src, count);
+}
+
+void audio_dsp_mix_gain_s16(int16_t *dst, const int16_t *src, size_t count, uint16_t gain_q15)
+{
+    if (gain_q15 >= AUDIO_DSP_UNITY) {
+        audio_dsp_mix_s16(dst, src, count);
+        return;
+    }
+    if (gain_q15 == 0) {
+        return;
+    }
+#if CONFIG_AUDIO_DSP_SIMD
+    if (IS_ALIGNED(dst) && IS_ALIGNED(src) && count >= VECTOR_SAMPLES) {
+        size_t vectors = count / VECTOR_SAMPLES;
+        audio_dsp_mix_gain_s16_aes3(dst, src, vectors, (int16_t)gain_q15);
+        dst += vectors * VECTOR_SAMPLES;
+        src += vectors * VECTOR_SAMPLES;
+        count -= vectors * VECTOR_SAMPLES;
+    }
+#endif
+    audio_dsp_mix_gain_s16_ref(dst, src, count, gain_q15);
+}
+
+/*
+ * Conversions are one shift per sample and bound by memory, not
+ * arithmetic; unrolled C keeps the load/store pipeline as busy as the
+ * vector unit would.
+ */
+void audio_dsp_s16_to_s32(const int16_t *src, int32_t *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        dst[i] = (int32_t)src[i] << 16;
+        dst[i + 1] = (int32_t)src[i + 1] << 16;
+        dst[i + 2] = (int32_t)src[i + 2] << 16;
+        dst[i + 3] = (int32_t)src[i + 3] << 16;
+    }
+    for (; i < count; i++) {
+        dst[i] = (int32_t)src[i] << 16;
+    }
+}
+
+void audio_dsp_s32_to_s16(const int32_t *src, int16_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = saturate_s16(((src[i] >> 15) + 1) >> 1);
+    }
+}
+
+/* ============================================================================
+ * Benchmark
+ * ============================================================================ */
+
+typedef struct {
+    int16_t *input;
+    int16_t *other;
+    int16_t *ref;
+    int16_t *out;
+} bench_bufs_t;
+
+// A ramp is a run of constant-gain segments; build it from the reference
+static void ramp_ref(int16_t *buf, size_t count, uint16_t from, uint16_t to)
+{
+    size_t segments = count / AUDIO_DSP_RAMP_SEGMENT;
+    for (size_t i = 0; i < segments; i++) {
+        int32_t gain = from + ((int32_t)to - from) * (int32_t)(i + 1) / (int32_t)segments;
+        audio_dsp_gain_s16_ref(buf + i * AUDIO_DSP_RAMP_SEGMENT, AUDIO_DSP_RAMP_SEGMENT, (uint16_t)gain);
+    }
+}
+
+static void bench_report(const char *name, uint32_t ref_cycles, uint32_t cycles, bool match)
+{
+    uint32_t samples = BENCH_SAMPLES * BENCH_ROUNDS;
+    ESP_LOGI(TAG, "  %-16s ref %3lu.%02lu  dispatch %3lu.%02lu cycles/sample%s", name,
+             (unsigned long)(ref_cycles / samples), (unsigned long)(ref_cycles % samples * 100 / samples),
+             (unsigned long)(cycles / samples), (unsigned long)(cycles % samples * 100 / samples),
+             match ? "" : "  MISMATCH");
+}
+
+esp_err_t audio_dsp_benchmark(void)
+{
+    bench_bufs_t b = {
+        .input = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        .other = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        .ref = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+        .out = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL),
+    };
+    int32_t *wide = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    esp_err_t result = ESP_OK;
+    
+    if (b.input == NULL || b.other == NULL || b.ref == NULL || b.out == NULL || wide == NULL) {
+        result = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+    
+    // Full-scale pseudo-random input so the mixes saturate now and then
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        seed = seed * 1664525 + 1013904223;
+        b.input[i] = (int16_t)(seed >> 16);
+        b.other[i] = (int16_t)(seed & 0xFFFF);
+    }
+    
+    const uint16_t gain = 23170;    // -3 dB
+    uint32_t start, ref_cycles, cycles;
+    bool match;
+    
+    ESP_LOGI(TAG, "Kernel benchmark, %d samples x %d (%s)", BENCH_SAMPLES, BENCH_ROUNDS, DSP_BACKEND);
+    
+#define BENCH(expr_ref, expr)                                               \
+    do {                                                                    \
+        ref_cycles = 0;                                                     \
+        cycles = 0;                                                         \
+        for (int r = 0; r < BENCH_ROUNDS; r++) {                            \
+            memcpy(b.ref, b.input, BENCH_SAMPLES * sizeof(int16_t));        \
+            memcpy(b.out, b.input, BENCH_SAMPLES * sizeof(int16_t));        \
+            start = esp_cpu_get_cycle_count();                              \
+            expr_ref;                                                       \
+            ref_cycles += esp_cpu_get_cycle_count() - start;                \
+            start = esp_cpu_get_cycle_count();                              \
+            expr;                                                           \
+            cycles += esp_cpu_get_cycle_count() - start;                    \
+        }                                                                   \
+        match = memcmp(b.ref, b.out, BENCH_SAMPLES * sizeof(int16_t)) == 0; \
+    } while (0)
+    
+    BENCH(audio_dsp_gain_s16_ref(b.ref, BENCH_SAMPLES, gain),
+          audio_dsp_gain_s16(b.out, BENCH_SAMPLES, gain));
+    bench_report("gain", ref_cycles, cycles, match);
+    result = match ? result : ESP_FAIL;
+    
+    BENCH(audio_dsp_mix_s16_ref(b.ref, b.other, BENCH_SAMPLES),
+          audio_dsp_mix_s16(b.out, b.other, BENCH_SAMPLES));
+    bench_report("mix", ref_cycles, cycles, match);
+    result = match ? result : ESP_FAIL;
+    
+    BENCH(audio_dsp_mix_gain_s16_ref(b.ref, b.other, BENCH_SAMPLES, gain),
+          audio_dsp_mix_gain_s16(b.out, b.other, BENCH_SAMPLES, gain));
+    bench_report("mix_gain", ref_cycles, cycles, match);
+    result = match ? result : ESP_FAIL;
+    
+    BENCH(ramp_ref(b.ref, BENCH_SAMPLES, AUDIO_DSP_UNITY, 0),
+          audio_dsp_gain_ramp_s16(b.out, BENCH_SAMPLES, AUDIO_DSP_UNITY, 0));
+    bench_report("gain_ramp", ref_cycles, cycles, match);
+    result = match ? result : ESP_FAIL;
+    
+    // Round trip must be lossless
+    BENCH((void)0,
+          audio_dsp_s16_to_s32(b.input, wide, BENCH_SAMPLES);
+          audio_dsp_s32_to_s16(wide, b.out, BENCH_SAMPLES));
+    bench_report("s16<->s32", ref_cycles, cycles, match);
+    result = match ? result : ESP_FAIL;
+    
+#undef BENCH
+    
+cleanup:
+    heap_caps_free(b.input);
+    heap_caps_free(b.other);
+    heap_caps_free(b.ref);
+    heap_caps_free(b.out);
+    heap_caps_free(wide);
+    return result;
+}
@@ -0,0 +1,391 @@
+/**
+ * @file audio_mixer.c
+ * @brief Clip voices mixed into the decoder task's output blocks
+ *
+ * Triggers travel through a bounded MPSC ring with per-slot sequence
+ * numbers, the same scheme as the display's UI queue: a producer claims a
+ * slot with a compare-and-swap on the write position, fills it and
+ * publishes it by advancing the slot sequence. The decoder task is the
+ * only consumer and owns the voices, so rendering takes no lock.
+ */
+
+#include "audio_mixer.h"
+#include "audio_dsp.h"
+#include "audio_internal.h"
+#include "system_service/static_alloc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "audio_mixer";
+
+#define MIXER_VOICES                CONFIG_AUDIO_MIXER_VOICES
+#define MIXER_CLIPS                 CONFIG_AUDIO_MIXER_CLIPS
+#define TRIGGER_RING_SIZE           CONFIG_AUDIO_MIXER_TRIGGER_QUEUE
+#define TRIGGER_RING_MASK           (TRIGGER_RING_SIZE - 1)
+
+_Static_assert((TRIGGER_RING_SIZE & TRIGGER_RING_MASK) == 0,
+               "AUDIO_MIXER_TRIGGER_QUEUE must be a power of two");
+
+typedef struct {
+    int16_t *pcm;                   // PSRAM, 16-byte aligned
+    uint32_t frames;
+    uint32_t sample_rate;
+    uint8_t channels;
+    volatile bool ready;            // Published after the fields above
+} clip_t;
+
+typedef struct {
+    bool active;
+    audio_clip_id_t clip;
+    uint16_t gain_q15;
+    uint32_t pos;                   // Next clip frame
+    uint32_t frac;                  // Position between frames, Q16
+    uint32_t started;               // Trigger order, to pick a voice to steal
+} voice_t;
+
+typedef struct {
+    audio_clip_id_t clip;
+    uint16_t gain_q15;
+    int64_t queued_us;
+} trigger_t;
+
+typedef struct {
+    volatile uint32_t sequence;     // Publication state of this slot
+    trigger_t trigger;
+} trigger_slot_t;
+
+typedef struct {
+    bool initialized;
+    SemaphoreHandle_t load_mutex;   // Serialises clip loads
+    clip_t clips[MIXER_CLIPS];
+    uint8_t clip_count;
+    
+    trigger_slot_t slots[TRIGGER_RING_SIZE];
+    volatile uint32_t write_pos;    // Next position producers claim
+    uint32_t read_pos;              // Next position the decoder task reads
+    
+    // Decoder task only
+    voice_t voices[MIXER_VOICES];
+    uint32_t started;
+    
+    volatile uint16_t stream_gain;
+    volatile uint32_t dropped_triggers;
+    uint32_t triggers;
+    uint32_t voice_steals;
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+} mixer_t;
+
+static mixer_t s_mixer = {
+    .stream_gain = AUDIO_DSP_UNITY,
+};
+
+// Resampled or upmixed voice block; internal RAM, aligned for the kernels
+static int16_t s_scratch[CONFIG_AUDIO_DMA_FRAMES * 2] AUDIO_DSP_ALIGNED;
+
+SYSTEM_MUTEX_DEFINE(s_load_mutex);
+
+/* ============================================================================
+ * Trigger Ring
+ * ============================================================================ */
+
+/* Claim a slot; returns NULL and counts a drop if the ring is full */
+static trigger_slot_t* claim_slot(uint32_t *out_pos)
+{
+    uint32_t pos = __atomic_load_n(&s_mixer.write_pos, __ATOMIC_RELAXED);
+    
+    while (true) {
+        trigger_slot_t *slot = &s_mixer.slots[pos & TRIGGER_RING_MASK];
+        uint32_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+    
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_mixer.write_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *out_pos = pos;
+                return slot;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            __atomic_add_fetch(&s_mixer.dropped_triggers, 1, __ATOMIC_RELAXED);
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&s_mixer.write_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static bool pop_trigger(trigger_t *trigger)
+{
+    uint32_t pos = s_mixer.read_pos;
+    trigger_slot_t *slot = &s_mixer.slots[pos & TRIGGER_RING_MASK];
+    
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1) {
+        return false;
+    }
+    
+    *trigger = slot->trigger;
+    s_mixer.read_pos = pos + 1;
+    __atomic_store_n(&slot->sequence, pos + TRIGGER_RING_SIZE, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool trigger_pending(void)
+{
+    uint32_t pos = s_mixer.read_pos;
+    trigger_slot_t *slot = &s_mixer.slots[pos & TRIGGER_RING_MASK];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) == pos + 1;
+}
+
+/* ============================================================================
+ * Voices
+ * ============================================================================ */
+
+static void start_voice(const trigger_t *trigger, uint32_t block_us)
+{
+    voice_t *voice = NULL;
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        if (!s_mixer.voices[i].active) {
+            voice = &s_mixer.voices[i];
+            break;
+        }
+        if (voice == NULL || s_mixer.voices[i].started - voice->started > UINT32_MAX / 2) {
+            voice = &s_mixer.voices[i];     // Oldest so far
+        }
+    }
+    if (voice->active) {
+        s_mixer.voice_steals++;
+    }
+    
+    *voice = (voice_t){
+        .active = true,
+        .clip = trigger->clip,
+        .gain_q15 = trigger->gain_q15,
+        .started = s_mixer.started++,
+    };
+    s_mixer.triggers++;
+    
+    // This block plays once the buffer ahead of it has been sent
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - trigger->queued_us) + block_us;
+    s_mixer.last_latency_us = latency;
+    if (latency > s_mixer.max_latency_us) {
+        s_mixer.max_latency_us = latency;
+    }
+}
+
+/* Upmix and resample into s_scratch with linear interpolation */
+static size_t render_converted(voice_t *voice, const clip_t *clip, size_t frames, uint32_t sample_rate)
+{
+    uint32_t step = (uint32_t)(((uint64_t)clip->sample_rate << 16) / sample_rate);
+    uint32_t last = clip->frames - 1;
+    size_t n = 0;
+    
+    while (n < frames && voice->pos < clip->frames) {
+        uint32_t next = (voice->pos < last) ? voice->pos + 1 : last;
+        int32_t frac = (int32_t)(voice->frac >> 1);     // Q15 keeps the product in range
+        int32_t left, right;
+    
+        if (clip->channels == 2) {
+            const int16_t *a = &clip->pcm[voice->pos * 2];
+            const int16_t *b = &clip->pcm[next * 2];
+            left = a[0] + (((b[0] - a[0]) * frac) >> 15);
+            right = a[1] + (((b[1] - a[1]) * frac) >> 15);
+        } else {
+            int32_t a = clip->pcm[voice->pos];
+            int32_t b = clip->pcm[next];
+            left = a + (((b - a) * frac) >> 15);
+            right = left;
+        }
+        s_scratch[2 * n] = (int16_t)left;
+        s_scratch[2 * n + 1] = (int16_t)right;
+        n++;
+    
+        voice->frac += step;
+        voice->pos += voice->frac >> 16;
+        voice->frac &= 0xFFFF;
+    }
+    return n;
+}
+
+static void render_voice(voice_t *voice, int16_t *block, size_t frames, uint32_t sample_rate)
+{
+    const clip_t *clip = &s_mixer.clips[voice->clip];
+    
+    if (clip->channels == 2 && clip->sample_rate == sample_rate) {
+        // Straight from PSRAM
+        size_t n = clip->frames - voice->pos;
+        if (n > frames) {
+            n = frames;
+        }
+        audio_dsp_mix_gain_s16(block, &clip->pcm[voice->pos * 2], n * 2, voice->gain_q15);
+        voice->pos += n;
+    } else {
+        size_t n = render_converted(voice, clip, frames, sample_rate);
+        audio_dsp_mix_gain_s16(block, s_scratch, n * 2, voice->gain_q15);
+    }
+    
+    if (voice->pos >= clip->frames) {
+        voice->active = false;
+    }
+}
+
+/* ============================================================================
+ * Decoder Task Side
+ * ============================================================================ */
+
+esp_err_t audio_mixer_init(void)
+{
+    if (s_mixer.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_mixer.load_mutex = SYSTEM_MUTEX_CREATE(s_load_mutex);
+    if (s_mixer.load_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t i = 0; i < TRIGGER_RING_SIZE; i++) {
+        s_mixer.slots[i].sequence = i;
+    }
+    
+    s_mixer.initialized = true;
+    ESP_LOGI(TAG, "✓ Mixer ready (%d voices, %d clips)", MIXER_VOICES, MIXER_CLIPS);
+    return ESP_OK;
+}
+
+bool audio_mixer_busy(void)
+{
+    if (!s_mixer.initialized) {
+        return false;
+    }
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        if (s_mixer.voices[i].active) {
+            return true;
+        }
+    }
+    return trigger_pending();
+}
+
+void audio_mixer_render(int16_t *block, size_t frames, uint32_t sample_rate, bool stream)
+{
+    if (stream) {
+        audio_dsp_gain_s16(block, frames * 2, s_mixer.stream_gain);
+    }
+    if (!s_mixer.initialized) {
+        return;
+    }
+    
+    uint32_t block_us = (uint32_t)((uint64_t)frames * 1000000 / sample_rate);
+    trigger_t trigger;
+    while (pop_trigger(&trigger)) {
+        start_voice(&trigger, block_us);
+    }
+    
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        if (s_mixer.voices[i].active) {
+            render_voice(&s_mixer.voices[i], block, frames, sample_rate);
+        }
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t audio_mixer_load_clip(const int16_t *pcm, size_t frames, uint8_t channels,
+                                uint32_t sample_rate, audio_clip_id_t *id)
+{
+    if (pcm == NULL || id == NULL || frames == 0 || frames > UINT32_MAX / 4 ||
+        channels < 1 || channels > 2 || sample_rate < 8000 || sample_rate > 48000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_mixer.initialized) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    xSemaphoreTake(s_mixer.load_mutex, portMAX_DELAY);
+    
+    esp_err_t ret = ESP_OK;
+    if (s_mixer.clip_count >= MIXER_CLIPS) {
+        ESP_LOGE(TAG, "Clip table full (%d)", MIXER_CLIPS);
+        ret = ESP_ERR_NO_MEM;
+        goto out;
+    }
+    
+    size_t bytes = frames * channels * sizeof(int16_t);
+    int16_t *copy = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (copy == NULL) {
+        ESP_LOGE(TAG, "No PSRAM for a %u byte clip", (unsigned)bytes);
+        ret = ESP_ERR_NO_MEM;
+        goto out;
+    }
+    memcpy(copy, pcm, bytes);
+    
+    clip_t *clip = &s_mixer.clips[s_mixer.clip_count];
+    clip->pcm = copy;
+    clip->frames = frames;
+    clip->sample_rate = sample_rate;
+    clip->channels = channels;
+    __atomic_store_n(&clip->ready, true, __ATOMIC_RELEASE);
+    
+    *id = s_mixer.clip_count++;
+    ESP_LOGD(TAG, "Clip %d: %u frames, %d ch, %lu Hz", *id, (unsigned)frames, channels,
+             (unsigned long)sample_rate);
+    
+out:
+    xSemaphoreGive(s_mixer.load_mutex);
+    return ret;
+}
+
+esp_err_t audio_mixer_play(audio_clip_id_t clip, uint16_t gain_q15)
+{
+    if (!s_mixer.initialized) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (clip >= MIXER_CLIPS || !__atomic_load_n(&s_mixer.clips[clip].ready, __ATOMIC_ACQUIRE)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint32_t pos;
+    trigger_slot_t *slot = claim_slot(&pos);
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    slot->trigger = (trigger_t){
+        .clip = clip,
+        .gain_q15 = gain_q15 > AUDIO_DSP_UNITY ? AUDIO_DSP_UNITY : gain_q15,
+        .queued_us = esp_timer_get_time(),
+    };
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    
+    audio_stream_wake();
+    return ESP_OK;
+}
+
+void audio_mixer_set_stream_gain(uint16_t gain_q15)
+{
+    s_mixer.stream_gain = gain_q15 > AUDIO_DSP_UNITY ? AUDIO_DSP_UNITY : gain_q15;
+}
+
+esp_err_t audio_mixer_get_stats(audio_mixer_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->triggers = s_mixer.triggers;
+    stats->dropped_triggers = __atomic_load_n(&s_mixer.dropped_triggers, __ATOMIC_RELAXED);
+    stats->voice_steals = s_mixer.voice_steals;
+    for (int i = 0; i < MIXER_VOICES; i++) {
+        stats->active_voices += s_mixer.voices[i].active ? 1 : 0;
+    }
+    stats->clips_loaded = s_mixer.clip_count;
+    stats->last_latency_us = s_mixer.last_latency_us;
+    stats->max_latency_us = s_mixer.max_latency_us;
+    return ESP_OK;
+}
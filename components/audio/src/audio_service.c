@@ -1,7 +1,10 @@
 #include "audio_service.h"
+#include "audio_stream.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/system_log.h"
+#include "system_service/system_settings.h"
 #include "service_watchdog.h"
 #include "resource_quota.h"
 #include "esp_log.h"
@@ -10,32 +13,21 @@
 
 static const char *TAG = "audio_service";
 
+SYSTEM_EVENT_SCHEMA_DEFINE(AUDIO_EVENT_SCHEMA, AUDIO_EVENT);
+
 static system_service_id_t audio_service_id = 0;
-static system_event_type_t audio_events[8];
 static bool initialized = false;
-static bool running = false;
 static uint8_t current_volume = 50;
 static bool is_muted = false;
-static TaskHandle_t heartbeat_task_handle = NULL;
+static system_setting_id_t volume_setting = SYSTEM_SETTING_ID_INVALID;
 
-/* Heartbeat task - sends periodic heartbeats to watchdog */
-static void audio_heartbeat_task(void *arg)
+// Loudness roughly follows the square of the 0-100 volume
+static uint16_t volume_to_gain(uint8_t volume, bool muted)
 {
-    ESP_LOGI(TAG, "Heartbeat task started");
-    
-    while (running) {
-        // Send heartbeat every 10 seconds (watchdog timeout is 30s)
-        vTaskDelay(pdMS_TO_TICKS(10000));
-        
-        if (running) {
-            system_service_heartbeat(audio_service_id);
-            ESP_LOGI(TAG, "Heartbeat sent (service_id=%d)", audio_service_id);
-        }
+    if (muted) {
+        return 0;
     }
-    
-    ESP_LOGI(TAG, "Heartbeat task exiting");
-    heartbeat_task_handle = NULL;
-    vTaskDelete(NULL);
+    return (uint16_t)((uint32_t)volume * volume * 32768 / (100 * 100));
 }
 
 esp_err_t audio_service_init(void)
@@ -59,25 +51,23 @@ esp_err_t audio_service_init(void)
     ESP_LOGI(TAG, "✓ Registered with system service (ID: %d)", audio_service_id);
     
     // Register event types
-    const char *event_names[] = {
-        "audio.registered",
-        "audio.started",
-        "audio.stopped",
-        "audio.volume_changed",
-        "audio.playback_state",
-        "audio.error"
-    };
+    ret = SYSTEM_EVENT_SCHEMA_REGISTER(AUDIO_EVENT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register event types: %s", esp_err_to_name(ret));
+        return ret;
+    }
     
-    for (int i = 0; i < 6; i++) {
-        ret = system_event_register_type(event_names[i], &audio_events[i]);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to register event type '%s'", event_names[i]);
-            return ret;
+    ESP_LOGI(TAG, "✓ Registered %d event types", AUDIO_EVENT_COUNT);
+    
+    // Volume survives restarts; loaded before the gain is first set below
+    if (system_setting_register(audio_service_id, "audio.volume", SYSTEM_SETTING_U8,
+                                current_volume, &volume_setting) == ESP_OK) {
+        current_volume = system_setting_u8(volume_setting);
+        if (current_volume > 100) {
+            current_volume = 100;
         }
     }
     
-    ESP_LOGI(TAG, "✓ Registered %d event types", 6);
-    
     // Register with watchdog
     service_watchdog_config_t watchdog_config = {
         .timeout_ms = 30000,              // 30 second timeout
@@ -98,16 +88,21 @@ esp_err_t audio_service_init(void)
     quota_set(audio_service_id, &quota);
     ESP_LOGI(TAG, "✓ Resource quotas set (50 events/s, 32KB memory)");
     
+    // Output pipeline; without I2S pins it only installs the app API
+    ret = audio_stream_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init audio output: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    audio_stream_set_gain(volume_to_gain(current_volume, is_muted));
+    
     // Set service state
     system_service_set_state(audio_service_id, SYSTEM_SERVICE_STATE_REGISTERED);
     
     initialized = true;
     
     // Post registration event
-    system_event_post(audio_service_id, 
-                     audio_events[AUDIO_EVENT_REGISTERED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(audio_service_id, AUDIO_EVENT_REGISTERED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Audio service initialized successfully");
     ESP_LOGI(TAG, "  → Posted AUDIO_EVENT_REGISTERED");
@@ -144,30 +139,15 @@ esp_err_t audio_service_start(void)
     // Send immediate heartbeat to reset watchdog timer
     system_service_heartbeat(audio_service_id);
     
-    // Start heartbeat task
-    running = true;
-    BaseType_t task_ret = xTaskCreate(
-        audio_heartbeat_task,
-        "audio_heartbeat",
-        4096,  // Increased stack size to prevent overflow
-        NULL,
-        3,
-        &heartbeat_task_handle
-    );
-    
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create heartbeat task");
-        running = false;
-        return ESP_FAIL;
+    // Periodic heartbeats from the shared system timer
+    esp_err_t ret = system_service_enable_auto_heartbeat(audio_service_id, NULL, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable heartbeats: %s", esp_err_to_name(ret));
+        return ret;
     }
     
-    ESP_LOGI(TAG, "✓ Heartbeat task created successfully");
-    
     // Post started event
-    system_event_post(audio_service_id,
-                     audio_events[AUDIO_EVENT_STARTED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(audio_service_id, AUDIO_EVENT_STARTED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     // Send heartbeat to watchdog
     system_service_heartbeat(audio_service_id);
@@ -186,19 +166,13 @@ esp_err_t audio_service_stop(void)
     
     ESP_LOGI(TAG, "Stopping audio service...");
     
-    // Stop heartbeat task
-    running = false;
-    if (heartbeat_task_handle != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(100));  // Give task time to exit
-    }
+    // Stop periodic heartbeats
+    system_service_disable_auto_heartbeat(audio_service_id);
     
     system_service_set_state(audio_service_id, SYSTEM_SERVICE_STATE_STOPPING);
     
     // Post stopped event
-    system_event_post(audio_service_id,
-                     audio_events[AUDIO_EVENT_STOPPED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(audio_service_id, AUDIO_EVENT_STOPPED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Audio service stopped");
     
@@ -216,21 +190,20 @@ esp_err_t audio_set_volume(uint8_t volume)
     }
     
     current_volume = volume;
+    audio_stream_set_gain(volume_to_gain(volume, is_muted));
+    system_setting_set_u8(volume_setting, volume);
     
     audio_volume_event_t event_data = {
         .volume = volume,
         .muted = is_muted
     };
     
-    system_event_post(audio_service_id,
-                     audio_events[AUDIO_EVENT_VOLUME_CHANGED],
-                     &event_data,
-                     sizeof(event_data),
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_TYPED(audio_service_id, AUDIO_EVENT_VOLUME_CHANGED,
+                            &event_data, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     system_service_heartbeat(audio_service_id);
     
-    ESP_LOGI(TAG, "Volume changed: %d%%", volume);
+    SYSTEM_LOGI(audio_service_id, TAG, "Volume changed: %d%%", volume);
     
     return ESP_OK;
 }
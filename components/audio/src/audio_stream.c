@@ -0,0 +1,625 @@
+#include "audio_stream.h"
+#include "audio_dsp.h"
+#include "audio_mixer.h"
+#include "audio_internal.h"
+#include "audio_service.h"
+#include "system_service/app_manager.h"
+#include "system_service/event_bus.h"
+#include "system_service/memory_utils.h"
+#include "system_service/static_alloc.h"
+#include "system_service/power_lock.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "driver/i2s_std.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include <string.h>
+
+static const char *TAG = "audio_stream";
+
+#define STREAM_RING_SIZE        (CONFIG_AUDIO_RING_KB * 1024)
+#define STREAM_BLOCK_FRAMES     CONFIG_AUDIO_DMA_FRAMES
+#define STREAM_DMA_DESC         2       // Decoder fills one while DMA sends the other
+#define STREAM_TASK_STACK       4096
+#define STREAM_TASK_PRIO        10
+#define STREAM_OUTPUT_ENABLED   (CONFIG_AUDIO_I2S_BCLK_GPIO >= 0 && \
+                                 CONFIG_AUDIO_I2S_WS_GPIO >= 0 && \
+                                 CONFIG_AUDIO_I2S_DOUT_GPIO >= 0)
+
+typedef enum {
+    STREAM_IDLE = 0,
+    STREAM_PLAYING,
+    STREAM_DRAINING,                // Closed, playing out the ring
+    STREAM_STOPPING,                // Closed, ring discarded
+} stream_state_t;
+
+typedef struct {
+    int32_t predictor;
+    int8_t index;
+} adpcm_state_t;
+
+typedef struct {
+    i2s_chan_handle_t tx;
+    uint32_t i2s_rate;
+    bool i2s_enabled;
+    system_power_lock_t power_lock; // APB_MAX while enabled, for the residency report
+    
+    StreamBufferHandle_t ring;
+    StaticStreamBuffer_t ring_struct;
+    TaskHandle_t task;
+    SemaphoreHandle_t dma_free;     // Given each time a DMA buffer has been sent
+    TickType_t dma_wait;            // Safety timeout for dma_free
+    
+    portMUX_TYPE lock;              // Guards state and owner
+    volatile stream_state_t state;
+    system_service_id_t owner;
+    audio_stream_format_t format;
+    size_t in_unit;                 // Smallest whole input unit, bytes
+    size_t in_block;                // Input bytes for one output block
+    uint32_t in_bytes_per_s;
+    
+    // Decoder task only
+    adpcm_state_t adpcm[2];
+    size_t carry;                   // Partial unit kept from the last read
+    
+    volatile uint16_t gain_q15;     // Target, set by audio_set_volume()
+    uint16_t gain_applied;          // Reached by the last block
+    volatile uint32_t dma_underruns;
+    uint32_t frames_played;
+    uint32_t starved_blocks;
+} stream_t;
+
+static stream_t s_stream = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+    .gain_q15 = AUDIO_DSP_UNITY,
+    .gain_applied = AUDIO_DSP_UNITY,
+};
+
+// Internal RAM: touched on every sample; aligned for the vector kernels
+static uint8_t s_in[STREAM_BLOCK_FRAMES * 2 * sizeof(int16_t)] AUDIO_DSP_ALIGNED;
+static int16_t s_out[STREAM_BLOCK_FRAMES * 2] AUDIO_DSP_ALIGNED;
+
+SYSTEM_TASK_DEFINE(s_stream_task, STREAM_TASK_STACK);
+SYSTEM_SEMAPHORE_DEFINE(s_dma_free_sem);
+
+// Whole vectors per block, and whole bytes of mono ADPCM
+_Static_assert(STREAM_BLOCK_FRAMES % 8 == 0, "AUDIO_DMA_FRAMES must be a multiple of 8");
+
+/* ============================================================================
+ * IMA ADPCM
+ * ============================================================================ */
+
+static const int16_t ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+};
+
+static const int8_t ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static inline int16_t adpcm_decode_nibble(adpcm_state_t *st, uint8_t nibble)
+{
+    int32_t step = ima_step_table[st->index];
+    int32_t diff = step >> 3;
+    if (nibble & 1) {
+        diff += step >> 2;
+    }
+    if (nibble & 2) {
+        diff += step >> 1;
+    }
+    if (nibble & 4) {
+        diff += step;
+    }
+    
+    st->predictor += (nibble & 8) ? -diff : diff;
+    if (st->predictor > INT16_MAX) {
+        st->predictor = INT16_MAX;
+    } else if (st->predictor < INT16_MIN) {
+        st->predictor = INT16_MIN;
+    }
+    
+    st->index += ima_index_table[nibble];
+    if (st->index < 0) {
+        st->index = 0;
+    } else if (st->index > 88) {
+        st->index = 88;
+    }
+    return (int16_t)st->predictor;
+}
+
+/* ============================================================================
+ * Decoder
+ * ============================================================================ */
+
+/* Decode whole input units into stereo frames; returns frames produced */
+static size_t decode(const uint8_t *in, size_t len, int16_t *out)
+{
+    size_t frames = 0;
+    
+    switch (s_stream.format.codec) {
+    case AUDIO_CODEC_PCM_S16: {
+        const int16_t *pcm = (const int16_t *)in;
+        if (s_stream.format.channels == 2) {
+            frames = len / 4;
+            memcpy(out, pcm, frames * 4);
+        } else {
+            frames = len / 2;
+            for (size_t i = 0; i < frames; i++) {
+                out[2 * i] = pcm[i];
+                out[2 * i + 1] = pcm[i];
+            }
+        }
+        break;
+    }
+    
+    case AUDIO_CODEC_IMA_ADPCM:
+        if (s_stream.format.channels == 2) {
+            for (size_t i = 0; i < len; i++) {
+                out[2 * i] = adpcm_decode_nibble(&s_stream.adpcm[0], in[i] & 0x0F);
+                out[2 * i + 1] = adpcm_decode_nibble(&s_stream.adpcm[1], in[i] >> 4);
+            }
+            frames = len;
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                int16_t a = adpcm_decode_nibble(&s_stream.adpcm[0], in[i] & 0x0F);
+                int16_t b = adpcm_decode_nibble(&s_stream.adpcm[0], in[i] >> 4);
+                out[4 * i] = a;
+                out[4 * i + 1] = a;
+                out[4 * i + 2] = b;
+                out[4 * i + 3] = b;
+            }
+            frames = len * 2;
+        }
+        break;
+    }
+    
+    return frames;
+}
+
+/*
+ * A volume change ramps across one block (about 10 ms) instead of
+ * stepping, which would click.
+ */
+static void apply_gain(int16_t *samples, size_t count)
+{
+    uint16_t target = s_stream.gain_q15;
+    if (target != s_stream.gain_applied) {
+        audio_dsp_gain_ramp_s16(samples, count, s_stream.gain_applied, target);
+        s_stream.gain_applied = target;
+    } else {
+        audio_dsp_gain_s16(samples, count, target);
+    }
+}
+
+static void ring_discard(void)
+{
+    if (xStreamBufferReset(s_stream.ring) == pdPASS) {
+        return;
+    }
+    
+    // A writer is still blocked on the ring; drain it by hand instead
+    while (xStreamBufferReceive(s_stream.ring, s_in, sizeof(s_in), 0) > 0) {
+    }
+}
+
+static void post_playback_state(bool playing)
+{
+    audio_playback_event_t event = {
+        .playing = playing,
+        .position_ms = (uint32_t)((uint64_t)s_stream.frames_played * 1000 / s_stream.i2s_rate),
+        .duration_ms = 0,
+    };
+    SYSTEM_EVENT_POST_TYPED(audio_service_get_id(), AUDIO_EVENT_PLAYBACK_STATE,
+                            &event, SYSTEM_EVENT_PRIORITY_NORMAL);
+}
+
+static esp_err_t output_begin(void)
+{
+    // Clips alone play at whatever rate the last stream left behind
+    uint32_t rate = (s_stream.state != STREAM_IDLE) ? s_stream.format.sample_rate : s_stream.i2s_rate;
+    if (rate != s_stream.i2s_rate) {
+        i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(rate);
+        esp_err_t ret = i2s_channel_reconfig_std_clock(s_stream.tx, &clk_cfg);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set %lu Hz: %s", (unsigned long)rate, esp_err_to_name(ret));
+            return ret;
+        }
+        s_stream.i2s_rate = rate;
+    }
+    
+    while (xSemaphoreTake(s_stream.dma_free, 0) == pdTRUE) {
+    }
+    // The I2S driver holds its own esp_pm lock while enabled as well
+    system_power_lock_acquire(s_stream.power_lock);
+    esp_err_t ret = i2s_channel_enable(s_stream.tx);
+    if (ret == ESP_OK) {
+        s_stream.i2s_enabled = true;
+    } else {
+        system_power_lock_release(s_stream.power_lock);
+    }
+    return ret;
+}
+
+static void output_stop(bool play_out)
+{
+    if (play_out) {
+        // Let the blocks already in the DMA buffers reach the speaker
+        for (int i = 0; i < STREAM_DMA_DESC; i++) {
+            xSemaphoreTake(s_stream.dma_free, s_stream.dma_wait);
+        }
+    }
+    i2s_channel_disable(s_stream.tx);
+    s_stream.i2s_enabled = false;
+    system_power_lock_release(s_stream.power_lock);
+}
+
+static void stream_end(void)
+{
+    ring_discard();
+    s_stream.carry = 0;
+    
+    portENTER_CRITICAL(&s_stream.lock);
+    s_stream.state = STREAM_IDLE;
+    s_stream.owner = SYSTEM_SERVICE_ID_INVALID;
+    portEXIT_CRITICAL(&s_stream.lock);
+    
+    ESP_LOGI(TAG, "Stream ended: %lu frames, %lu starved blocks, %lu DMA underruns",
+             (unsigned long)s_stream.frames_played, (unsigned long)s_stream.starved_blocks,
+             (unsigned long)s_stream.dma_underruns);
+    post_playback_state(false);
+}
+
+/* Decode up to one block of stream input into s_out; returns frames */
+static size_t stream_fill(stream_state_t state)
+{
+    // Never wait: the ring is the stream's slack, the deadline is the DMA's
+    size_t got = xStreamBufferReceive(s_stream.ring, s_in + s_stream.carry,
+                                      s_stream.in_block - s_stream.carry, 0);
+    size_t avail = s_stream.carry + got;
+    size_t usable = avail - (avail % s_stream.in_unit);
+    
+    size_t frames = decode(s_in, usable, s_out);
+    s_stream.carry = avail - usable;
+    memmove(s_in, s_in + usable, s_stream.carry);
+    
+    if (frames < STREAM_BLOCK_FRAMES && state == STREAM_PLAYING) {
+        s_stream.starved_blocks++;
+    }
+    s_stream.frames_played += frames;
+    return frames;
+}
+
+/*
+ * Produce one block each time a DMA buffer has been sent, and only then,
+ * so the block is built as late as possible: the buffer just freed plays
+ * next after the one now on the wire. A UI sound triggered in between is
+ * mixed into it and heard within two blocks.
+ */
+static void stream_task(void *arg)
+{
+    while (true) {
+        stream_state_t state = s_stream.state;
+        bool voices = audio_mixer_busy();
+    
+        if (state == STREAM_STOPPING) {
+            stream_end();
+            if (s_stream.i2s_enabled && !voices) {
+                output_stop(false);
+            }
+            continue;
+        }
+        if (state == STREAM_IDLE && !voices) {
+            if (s_stream.i2s_enabled) {
+                output_stop(true);
+            } else {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            continue;
+        }
+        if (state != STREAM_IDLE && s_stream.i2s_enabled &&
+            s_stream.format.sample_rate != s_stream.i2s_rate) {
+            output_stop(false);     // Clips were playing at the old rate
+        }
+        if (!s_stream.i2s_enabled && output_begin() != ESP_OK) {
+            if (state != STREAM_IDLE) {
+                stream_end();
+            }
+            vTaskDelay(s_stream.dma_wait);
+            continue;
+        }
+    
+        xSemaphoreTake(s_stream.dma_free, s_stream.dma_wait);
+    
+        size_t frames = 0;
+        if (state != STREAM_IDLE) {
+            frames = stream_fill(state);
+            if (frames == 0 && state == STREAM_DRAINING &&
+                xStreamBufferIsEmpty(s_stream.ring) == pdTRUE) {
+                stream_end();
+            }
+        }
+        if (frames < STREAM_BLOCK_FRAMES) {
+            memset(&s_out[frames * 2], 0, (STREAM_BLOCK_FRAMES - frames) * 2 * sizeof(int16_t));
+        }
+    
+        audio_mixer_render(s_out, STREAM_BLOCK_FRAMES, s_stream.i2s_rate, frames > 0);
+        apply_gain(s_out, STREAM_BLOCK_FRAMES * 2);
+    
+        size_t written = 0;
+        i2s_channel_write(s_stream.tx, s_out, sizeof(s_out), &written, portMAX_DELAY);
+    }
+}
+
+static bool IRAM_ATTR on_dma_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_stream.dma_free, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR on_dma_underrun(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    s_stream.dma_underruns++;
+    return false;
+}
+
+/* ============================================================================
+ * App API (app_context_t::audio)
+ * ============================================================================ */
+
+static esp_err_t app_audio_open(app_context_t *ctx, uint32_t sample_rate, uint8_t channels, uint8_t codec)
+{
+    audio_stream_format_t format = {
+        .codec = (audio_codec_t)codec,
+        .sample_rate = sample_rate,
+        .channels = channels,
+    };
+    return audio_stream_open(ctx->service_id, &format);
+}
+
+static esp_err_t app_audio_write(app_context_t *ctx, const void *data, size_t len,
+                                 size_t *written, uint32_t timeout_ms)
+{
+    return audio_stream_write(ctx->service_id, data, len, written, timeout_ms);
+}
+
+static esp_err_t app_audio_close(app_context_t *ctx, bool drain)
+{
+    return audio_stream_close(ctx->service_id, drain);
+}
+
+static const app_audio_ops_t s_app_audio_ops = {
+    .open = app_audio_open,
+    .write = app_audio_write,
+    .close = app_audio_close,
+};
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+esp_err_t audio_stream_init(void)
+{
+    s_stream.owner = SYSTEM_SERVICE_ID_INVALID;
+    app_manager_set_audio_ops(&s_app_audio_ops);
+    
+#if CONFIG_AUDIO_DSP_BENCHMARK
+    if (audio_dsp_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Sample kernels disagree with the scalar reference");
+    }
+#endif
+
+    if (!STREAM_OUTPUT_ENABLED) {
+        ESP_LOGW(TAG, "No I2S pins configured, playback disabled");
+        return ESP_OK;
+    }
+    
+    // Input waits in PSRAM; only the decoder's working blocks are internal
+    uint8_t *storage = memory_alloc_psram_only(STREAM_RING_SIZE + 1);
+    if (storage == NULL) {
+        ESP_LOGE(TAG, "No PSRAM for the %d KB ring", CONFIG_AUDIO_RING_KB);
+        return ESP_ERR_NO_MEM;
+    }
+    s_stream.ring = xStreamBufferCreateStatic(STREAM_RING_SIZE, 1, storage, &s_stream.ring_struct);
+    
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = STREAM_DMA_DESC;
+    chan_cfg.dma_frame_num = STREAM_BLOCK_FRAMES;
+    chan_cfg.auto_clear = true;     // Silence, not a repeated block, on underrun
+    esp_err_t ret = i2s_new_channel(&chan_cfg, &s_stream.tx, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create I2S channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(CONFIG_AUDIO_SAMPLE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = CONFIG_AUDIO_I2S_BCLK_GPIO,
+            .ws = CONFIG_AUDIO_I2S_WS_GPIO,
+            .dout = CONFIG_AUDIO_I2S_DOUT_GPIO,
+            .din = I2S_GPIO_UNUSED,
+        },
+    };
+    ret = i2s_channel_init_std_mode(s_stream.tx, &std_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init I2S: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_stream.i2s_rate = CONFIG_AUDIO_SAMPLE_RATE;
+    
+    s_stream.dma_free = SYSTEM_COUNTING_CREATE(s_dma_free_sem, STREAM_DMA_DESC, 0);
+    if (s_stream.dma_free == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_stream.dma_wait = pdMS_TO_TICKS(100);
+    
+    ret = system_power_lock_create(SYSTEM_POWER_LOCK_APB_MAX, "audio", &s_stream.power_lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    i2s_event_callbacks_t callbacks = {
+        .on_sent = on_dma_sent,
+        .on_send_q_ovf = on_dma_underrun,
+    };
+    i2s_channel_register_event_callback(s_stream.tx, &callbacks, NULL);
+    
+    BaseType_t created = SYSTEM_TASK_CREATE_PINNED(s_stream_task, stream_task, "audio_dec",
+                                                   STREAM_TASK_STACK, NULL, STREAM_TASK_PRIO,
+                                                   &s_stream.task, CONFIG_AUDIO_DECODER_CORE);
+    if (created != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ret = audio_mixer_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "✓ Audio output ready (%d KB ring, %d x %d frame DMA buffers)",
+             CONFIG_AUDIO_RING_KB, STREAM_DMA_DESC, STREAM_BLOCK_FRAMES);
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_open(system_service_id_t owner, const audio_stream_format_t *format)
+{
+    if (format == NULL || format->channels < 1 || format->channels > 2 ||
+        format->sample_rate < 8000 || format->sample_rate > 48000 ||
+        format->codec > AUDIO_CODEC_IMA_ADPCM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_stream.task == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    portENTER_CRITICAL(&s_stream.lock);
+    bool busy = s_stream.state != STREAM_IDLE;
+    if (!busy) {
+        s_stream.owner = owner;
+    }
+    portEXIT_CRITICAL(&s_stream.lock);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // The decoder task is idle until the state changes below
+    s_stream.format = *format;
+    if (format->codec == AUDIO_CODEC_PCM_S16) {
+        s_stream.in_unit = format->channels * sizeof(int16_t);
+        s_stream.in_block = STREAM_BLOCK_FRAMES * s_stream.in_unit;
+        s_stream.in_bytes_per_s = format->sample_rate * s_stream.in_unit;
+    } else {
+        s_stream.in_unit = 1;
+        s_stream.in_block = (format->channels == 2) ? STREAM_BLOCK_FRAMES : STREAM_BLOCK_FRAMES / 2;
+        s_stream.in_bytes_per_s = format->sample_rate * format->channels / 2;
+    }
+    memset(s_stream.adpcm, 0, sizeof(s_stream.adpcm));
+    s_stream.carry = 0;
+    s_stream.frames_played = 0;
+    s_stream.starved_blocks = 0;
+    s_stream.dma_underruns = 0;
+    ring_discard();
+    
+    portENTER_CRITICAL(&s_stream.lock);
+    s_stream.state = STREAM_PLAYING;
+    portEXIT_CRITICAL(&s_stream.lock);
+    xTaskNotifyGive(s_stream.task);
+    
+    ESP_LOGI(TAG, "Stream opened: %s, %lu Hz, %d ch",
+             format->codec == AUDIO_CODEC_PCM_S16 ? "PCM" : "IMA ADPCM",
+             (unsigned long)format->sample_rate, format->channels);
+    post_playback_state(true);
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_write(system_service_id_t owner, const void *data, size_t len,
+                             size_t *written, uint32_t timeout_ms)
+{
+    if (written != NULL) {
+        *written = 0;
+    }
+    if (data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_stream.state != STREAM_PLAYING || s_stream.owner != owner) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // One writer per stream: the owner
+    size_t sent = xStreamBufferSend(s_stream.ring, data, len, pdMS_TO_TICKS(timeout_ms));
+    if (written != NULL) {
+        *written = sent;
+    }
+    return (sent == len) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t audio_stream_close(system_service_id_t owner, bool drain)
+{
+    portENTER_CRITICAL(&s_stream.lock);
+    bool mine = s_stream.state == STREAM_PLAYING && s_stream.owner == owner;
+    if (mine) {
+        s_stream.state = drain ? STREAM_DRAINING : STREAM_STOPPING;
+    }
+    portEXIT_CRITICAL(&s_stream.lock);
+    
+    if (!mine) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(s_stream.task);
+    return ESP_OK;
+}
+
+void audio_stream_wake(void)
+{
+    if (s_stream.task == NULL) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_stream.task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(s_stream.task);
+    }
+}
+
+void audio_stream_set_gain(uint16_t gain_q15)
+{
+    s_stream.gain_q15 = gain_q15 > AUDIO_DSP_UNITY ? AUDIO_DSP_UNITY : gain_q15;
+}
+
+esp_err_t audio_stream_get_stats(audio_stream_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->active = s_stream.state != STREAM_IDLE;
+    stats->sample_rate = s_stream.i2s_rate;
+    stats->frames_played = s_stream.frames_played;
+    stats->starved_blocks = s_stream.starved_blocks;
+    stats->dma_underruns = s_stream.dma_underruns;
+    if (s_stream.ring != NULL) {
+        stats->buffered_bytes = xStreamBufferBytesAvailable(s_stream.ring);
+    }
+    if (stats->active && s_stream.in_bytes_per_s > 0) {
+        stats->buffered_ms = (uint32_t)((uint64_t)stats->buffered_bytes * 1000 / s_stream.in_bytes_per_s);
+    }
+    if (s_stream.i2s_rate > 0) {
+        stats->latency_ms = stats->buffered_ms +
+                            STREAM_DMA_DESC * STREAM_BLOCK_FRAMES * 1000 / s_stream.i2s_rate;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file bluetooth_bulk.h
+ * @brief BLE bulk transfer of apps and assets straight into flash
+ *
+ * Two characteristics of the Kraken-OS GATT service carry an upload:
+ *
+ *   0xFF03 control  write with response + notify: bt_bulk_request_t in,
+ *                   bt_bulk_reply_t out
+ *   0xFF04 data     write without response: bt_bulk_data_t
+ *
+ * The client sends START, then streams data writes for one block
+ * (BT_BULK_BLOCK_SIZE bytes, one flash sector) followed by a BLOCK_CRC
+ * request, and may run up to `window` blocks ahead of the last
+ * acknowledged one. Each verified block is acknowledged with the offset to
+ * continue from; a lost write or a CRC mismatch is answered with the
+ * offset to resend from, and data past that offset is ignored until the
+ * client rewinds. Acknowledgements and resend requests both arrive as
+ * BLOCK_CRC replies. A data write never extends past its block; anything
+ * beyond the block end is dropped and requested again. CRCs are CRC-32
+ * (IEEE 802.3, as zlib's crc32()).
+ *
+ * Chunks are erased and written into the target partition as they
+ * arrive, so nothing larger than one write is held in RAM. App partitions
+ * are refused; firmware goes through OTA.
+ *
+ * The verified offset is kept across disconnects and reboots: a START for
+ * the same target, size and CRC resumes where the last one stopped.
+ *
+ * Progress is published as "bluetooth.bulk_progress" (latest value only)
+ * and the outcome as "bluetooth.bulk_done", both carrying a
+ * bt_bulk_status_t. All wire structures are little endian.
+ *
+ * The other direction carries the flight recorder's log: a FLIGHT_LOG
+ * request streams flight_recorder_read() for the last `minutes` as
+ * notifications on 0xFF01, the service's byte stream, then replies on
+ * the control characteristic with the byte count in next_offset.
+ */
+
+#ifndef BLUETOOTH_BULK_H
+#define BLUETOOTH_BULK_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BT_BULK_BLOCK_SIZE          4096
+#define BT_BULK_WINDOW              4       // Blocks a client may send ahead
+#define BT_BULK_PARTITION_LEN       16
+
+typedef enum {
+    BT_BULK_OP_START = 0x01,
+    BT_BULK_OP_BLOCK_CRC = 0x02,
+    BT_BULK_OP_FINISH = 0x03,
+    BT_BULK_OP_ABORT = 0x04,
+    BT_BULK_OP_FLIGHT_LOG = 0x05,
+    BT_BULK_OP_REPLY = 0x80,        // OR'ed into the op of a reply
+} bt_bulk_op_t;
+
+typedef enum {
+    BT_BULK_OK = 0,
+    BT_BULK_ERR_BAD_REQUEST,
+    BT_BULK_ERR_NO_PARTITION,
+    BT_BULK_ERR_TOO_LARGE,
+    BT_BULK_ERR_RESEND,             // Lost data or bad block CRC, resend from next_offset
+    BT_BULK_ERR_FLASH,
+    BT_BULK_ERR_IMAGE_CRC,          // Whole-image CRC mismatch at FINISH
+    BT_BULK_ERR_NOT_STARTED,
+    BT_BULK_ERR_ABORTED,
+    BT_BULK_ERR_NO_LOG,             // Flight recorder disabled or not running
+} bt_bulk_result_t;
+
+#define BT_BULK_START_FLAG_RESTART  (1 << 0)    // Ignore a resumable upload
+
+typedef struct __attribute__((packed)) {
+    uint8_t op;                     // bt_bulk_op_t
+    uint8_t flags;                  // START: BT_BULK_START_FLAG_*
+    uint16_t reserved;
+    union {
+        struct __attribute__((packed)) {
+            char partition[BT_BULK_PARTITION_LEN];  // Label, NUL padded
+            uint32_t offset;        // Within the partition, sector aligned
+            uint32_t size;
+            uint32_t crc32;         // Of the whole image, 0 to skip
+        } start;
+        struct __attribute__((packed)) {
+            uint32_t offset;        // Block start, relative to the upload
+            uint32_t crc32;         // Of the block's bytes
+        } block;
+        struct __attribute__((packed)) {
+            uint16_t minutes;       // 0 for the whole log
+        } flight;
+    };
+} bt_bulk_request_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t op;                     // Request op | BT_BULK_OP_REPLY
+    uint8_t result;                 // bt_bulk_result_t
+    uint16_t window;                // Blocks the client may send ahead
+    uint32_t next_offset;           // Send from here
+    uint16_t block_size;
+    uint16_t reserved;
+} bt_bulk_reply_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t offset;                // Relative to the upload
+    uint8_t data[];
+} bt_bulk_data_t;
+
+typedef enum {
+    BT_BULK_IDLE = 0,
+    BT_BULK_RUNNING,
+    BT_BULK_DONE,
+    BT_BULK_FAILED,
+} bt_bulk_state_t;
+
+typedef struct {
+    bt_bulk_state_t state;
+    bt_bulk_result_t result;        // Why an upload failed
+    char partition[BT_BULK_PARTITION_LEN + 1];
+    uint32_t offset;
+    uint32_t size;
+    uint32_t verified;              // Bytes acknowledged
+    uint32_t bytes_per_s;           // Average since START
+    uint32_t resends;               // Rewinds requested from the client
+    uint32_t dropped_writes;        // RX backlog full
+} bt_bulk_status_t;
+
+esp_err_t bluetooth_bulk_get_status(bt_bulk_status_t *status);
+
+// Drop the upload in progress and its resume point; it finishes as ABORTED
+esp_err_t bluetooth_bulk_abort(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLUETOOTH_BULK_H
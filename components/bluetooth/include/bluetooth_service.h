@@ -3,22 +3,12 @@
 
 #include "esp_err.h"
 #include "system_service/system_types.h"
+#include "system_service/event_schema.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef enum {
-    BT_EVENT_REGISTERED = 0,
-    BT_EVENT_STARTED,
-    BT_EVENT_STOPPED,
-    BT_EVENT_CONNECTED,
-    BT_EVENT_DISCONNECTED,
-    BT_EVENT_PAIRING_REQUEST,
-    BT_EVENT_DATA_RECEIVED,
-    BT_EVENT_ERROR,
-} bluetooth_event_id_t;
-
 typedef struct {
     uint8_t address[6];
     char name[32];
@@ -30,12 +20,66 @@ typedef struct {
     bool connected;
 } bt_connection_event_t;
 
+/*
+ * Payload of BT_EVENT_DATA_RECEIVED. The written bytes follow the struct
+ * in the same pool block and .data points at them, so the event is posted
+ * without a second copy. A subscriber that needs the bytes after its
+ * handler returns takes system_event_data_retain(event) and later calls
+ * system_event_data_release(event->data).
+ */
 typedef struct {
-    uint8_t *data;
+    const uint8_t *data;
     size_t length;
+    uint16_t handle;            // Attribute written
     bt_device_info_t device;
 } bt_data_event_t;
 
+#define BT_EVENT_SCHEMA(X) \
+    X(BT_EVENT_REGISTERED,          "bluetooth.registered",      system_event_no_payload_t, 1, QUEUED) \
+    X(BT_EVENT_STARTED,             "bluetooth.started",         system_event_no_payload_t, 1, QUEUED) \
+    X(BT_EVENT_STOPPED,             "bluetooth.stopped",         system_event_no_payload_t, 1, QUEUED) \
+    X(BT_EVENT_CONNECTED,           "bluetooth.connected",       bt_connection_event_t,     1, QUEUED) \
+    X(BT_EVENT_DISCONNECTED,        "bluetooth.disconnected",    system_event_no_payload_t, 1, QUEUED) \
+    X(BT_EVENT_PAIRING_REQUEST,     "bluetooth.pairing_request", bt_device_info_t,          1, QUEUED) \
+    X(BT_EVENT_DATA_RECEIVED,       "bluetooth.data_received",   bt_data_event_t,           1, QUEUED) \
+    X(BT_EVENT_ERROR,               "bluetooth.error",           system_event_bytes_t,      1, QUEUED)
+
+SYSTEM_EVENT_SCHEMA_DECLARE(BT_EVENT_SCHEMA, BT_EVENT, SYSTEM_EVENT_RANGE_BLUETOOTH);
+
+/*
+ * Connection parameter profiles. With auto selection on (the default) the
+ * service requests LOW_LATENCY while notifications are queued or writes
+ * arrive, INTERACTIVE on connect, and LOW_POWER after a few idle seconds.
+ */
+typedef enum {
+    BT_CONN_PROFILE_LOW_LATENCY = 0,    // 7.5-15 ms, no slave latency
+    BT_CONN_PROFILE_INTERACTIVE,        // 20-40 ms, no slave latency
+    BT_CONN_PROFILE_LOW_POWER,          // 100-200 ms, slave latency 4
+    BT_CONN_PROFILE_COUNT,
+} bt_conn_profile_t;
+
+/*
+ * Advertising interval profiles. With auto selection on, advertising
+ * starts FAST and drops to SLOW when nobody connects within 30 seconds.
+ */
+typedef enum {
+    BT_ADV_PROFILE_FAST = 0,            // 20-40 ms
+    BT_ADV_PROFILE_BALANCED,            // 100-150 ms
+    BT_ADV_PROFILE_SLOW,                // 1-1.28 s
+    BT_ADV_PROFILE_COUNT,
+} bt_adv_profile_t;
+
+typedef struct {
+    uint32_t bytes_per_s;       // Over the last second
+    uint32_t bytes_sent;
+    uint32_t packets_sent;
+    uint32_t queued_bytes;      // Waiting for the link
+    uint32_t rejected_bytes;    // Refused because the queue was full
+    uint32_t congestion_events;
+    uint16_t in_flight;         // Notifications not yet confirmed by the stack
+    uint16_t mtu;
+} bt_tx_stats_t;
+
 // Core service functions
 esp_err_t bluetooth_service_init(void);
 esp_err_t bluetooth_service_deinit(void);
@@ -45,13 +89,22 @@ esp_err_t bluetooth_service_stop(void);
 // Service information
 system_service_id_t bluetooth_service_get_id(void);
 bool bluetooth_service_is_connected(void);
+bool bluetooth_service_is_advertising(void);
 
 // Advertising control
 esp_err_t bluetooth_service_start_advertising(void);
 esp_err_t bluetooth_service_stop_advertising(void);
 
-// Data transfer
+/*
+ * Data transfer. Notifications are a byte stream: send_notification()
+ * queues the bytes and returns at once, and the TX task packs queued bytes
+ * into MTU-sized notifications while only a few are in flight. Message
+ * boundaries are not preserved. Returns ESP_ERR_NO_MEM when the queue has
+ * no room for all of len (nothing is queued), ESP_ERR_INVALID_STATE when
+ * no client has notifications enabled.
+ */
 esp_err_t bluetooth_service_send_notification(const uint8_t *data, uint16_t len);
+esp_err_t bluetooth_service_get_tx_stats(bt_tx_stats_t *stats);
 
 #ifdef __cplusplus
 }
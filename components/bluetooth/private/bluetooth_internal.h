@@ -0,0 +1,58 @@
+/**
+ * @file bluetooth_internal.h
+ * @brief Glue between the GATT server and the bulk transfer channel
+ */
+
+#ifndef BLUETOOTH_INTERNAL_H
+#define BLUETOOTH_INTERNAL_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Provided by bluetooth_service.c
+ * ============================================================================ */
+
+/**
+ * @brief Send one notification right away, bypassing the TX queue
+ *
+ * For small protocol replies that must not wait behind streamed data.
+ */
+esp_err_t bt_gatts_notify(uint16_t attr_handle, const uint8_t *data, uint16_t len);
+
+/** Count data moving over the link towards automatic profile selection */
+void bt_link_note_traffic(void);
+
+/* ============================================================================
+ * Provided by bluetooth_bulk.c
+ * ============================================================================ */
+
+/** Create the bulk writer task and register its topics */
+esp_err_t bt_bulk_init(void);
+
+/** Attribute handles of the control and data characteristics */
+void bt_bulk_set_handles(uint16_t control_handle, uint16_t data_handle);
+
+/**
+ * @brief Offer a client write to the bulk channel
+ *
+ * Called from the Bluedroid callback. The write is copied into a pool
+ * block and handed to the writer task; flash is never touched here.
+ *
+ * @return true if the write was for a bulk characteristic
+ */
+bool bt_bulk_on_write(uint16_t handle, const uint8_t *value, uint16_t len);
+
+/** The link is gone; keep the resume point, drop pending writes */
+void bt_bulk_on_disconnect(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLUETOOTH_INTERNAL_H
@@ -0,0 +1,731 @@
+#include "bluetooth_bulk.h"
+#include "bluetooth_internal.h"
+#include "bluetooth_service.h"
+#include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "system_service/power_lock.h"
+#include "system_service/flight_recorder.h"
+#include "memory_pool.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "spi_flash_mmap.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+
+static const char *TAG = "bluetooth_bulk";
+
+/* Writes are copied out of the Bluedroid callback into pool blocks and
+ * queued, in arrival order, for the writer task, which is the only place
+ * flash is erased or written. The queue covers a full window of blocks
+ * at the largest MTU. */
+#define BULK_QUEUE_LEN          40
+#if CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+#define BULK_TASK_STACK         4096    // Flight log reads drain the recorder on this stack
+#else
+#define BULK_TASK_STACK         3072
+#endif
+#define BULK_CONTROL_TIMEOUT_MS 100
+#define BULK_SAVE_BLOCKS        16      // Persist the resume point this often
+#define BULK_VERIFY_CHUNK       1024
+#define BULK_PROGRESS_US        250000
+#define BULK_NO_OFFSET          UINT32_MAX
+#define BULK_FLIGHT_CHUNK       512     // Per send_notification() call
+#define BULK_FLIGHT_RETRY_MS    10
+#define BULK_FLIGHT_STALL_MS    5000    // TX ring full this long: give up
+
+#define BULK_NVS_NAMESPACE      "bt_bulk"
+#define BULK_NVS_KEY            "resume"
+#define BULK_RESUME_VERSION     1
+
+_Static_assert(BT_BULK_BLOCK_SIZE % SPI_FLASH_SEC_SIZE == 0,
+               "bulk blocks must be whole flash sectors");
+
+typedef enum {
+    BULK_MSG_CONTROL = 0,
+    BULK_MSG_DATA,
+    BULK_MSG_DISCONNECT,
+    BULK_MSG_ABORT,
+} bulk_msg_kind_t;
+
+typedef struct {
+    uint8_t kind;                   // bulk_msg_kind_t
+    uint16_t len;
+    uint8_t *buf;                   // Pool block, freed by the writer task
+} bulk_msg_t;
+
+// Where an interrupted upload can continue, kept in NVS
+typedef struct {
+    uint8_t version;
+    char partition[BT_BULK_PARTITION_LEN + 1];
+    uint32_t offset;
+    uint32_t size;
+    uint32_t crc32;
+    uint32_t verified;
+} bulk_resume_t;
+
+typedef struct {
+    uint16_t control_handle;
+    uint16_t data_handle;
+    QueueHandle_t queue;
+    TaskHandle_t task;
+    
+    // Writer task only
+    bool active;
+    const esp_partition_t *partition;
+    uint32_t base;                  // Upload start within the partition
+    uint32_t size;
+    uint32_t image_crc;
+    uint32_t verified;              // Acknowledged, block aligned except at the end
+    uint32_t next_expected;         // Next data offset accepted
+    uint32_t erased_end;            // Relative to the upload
+    uint32_t block_crc;             // Of [verified, next_expected)
+    uint32_t nak_offset;            // Resend already requested from here
+    uint32_t unsaved_blocks;
+    uint32_t start_verified;
+    int64_t start_us;
+    int64_t progress_us;
+    bulk_resume_t resume;
+    system_power_lock_t power_lock; // CPU_MAX while active: CRCs and flash writes
+    bool power_held;
+    
+    bt_bulk_status_t status;
+    portMUX_TYPE lock;              // Guards status
+} bulk_t;
+
+static bulk_t s_bulk = {
+    .nak_offset = BULK_NO_OFFSET,
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static system_event_type_t s_progress_event = SYSTEM_EVENT_TYPE_INVALID;
+static system_event_type_t s_done_event = SYSTEM_EVENT_TYPE_INVALID;
+
+SYSTEM_TASK_DEFINE(s_bulk_task_storage, BULK_TASK_STACK);
+SYSTEM_QUEUE_DEFINE(s_bulk_queue_storage, BULK_QUEUE_LEN, sizeof(bulk_msg_t));
+
+static void publish_status(system_event_type_t type)
+{
+    bt_bulk_status_t status;
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    status = s_bulk.status;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    
+    if (type != SYSTEM_EVENT_TYPE_INVALID) {
+        system_event_post(bluetooth_service_get_id(), type, &status, sizeof(status),
+                          SYSTEM_EVENT_PRIORITY_NORMAL);
+    }
+}
+
+static void update_status(void)
+{
+    int64_t elapsed_us = esp_timer_get_time() - s_bulk.start_us;
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    s_bulk.status.verified = s_bulk.verified;
+    if (elapsed_us > 0) {
+        s_bulk.status.bytes_per_s = (uint32_t)((int64_t)(s_bulk.verified - s_bulk.start_verified) *
+                                               1000000LL / elapsed_us);
+    }
+    portEXIT_CRITICAL(&s_bulk.lock);
+}
+
+static void reply(uint8_t op, bt_bulk_result_t result, uint32_t next_offset)
+{
+    bt_bulk_reply_t r = {
+        .op = op | BT_BULK_OP_REPLY,
+        .result = result,
+        .window = BT_BULK_WINDOW,
+        .next_offset = next_offset,
+        .block_size = BT_BULK_BLOCK_SIZE,
+    };
+    
+    esp_err_t ret = bt_gatts_notify(s_bulk.control_handle, (const uint8_t *)&r, sizeof(r));
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send reply: %s", esp_err_to_name(ret));
+    }
+}
+
+/* ============================================================================
+ * Resume point
+ * ============================================================================ */
+
+static void resume_load(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(BULK_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    
+    size_t size = sizeof(s_bulk.resume);
+    esp_err_t ret = nvs_get_blob(nvs, BULK_NVS_KEY, &s_bulk.resume, &size);
+    nvs_close(nvs);
+    
+    if (ret != ESP_OK || size != sizeof(s_bulk.resume) ||
+        s_bulk.resume.version != BULK_RESUME_VERSION) {
+        memset(&s_bulk.resume, 0, sizeof(s_bulk.resume));
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Resumable upload to %s: %lu of %lu bytes", s_bulk.resume.partition,
+             (unsigned long)s_bulk.resume.verified, (unsigned long)s_bulk.resume.size);
+}
+
+static void resume_save(void)
+{
+    s_bulk.unsaved_blocks = 0;
+    
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(BULK_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        if (s_bulk.resume.version == BULK_RESUME_VERSION) {
+            ret = nvs_set_blob(nvs, BULK_NVS_KEY, &s_bulk.resume, sizeof(s_bulk.resume));
+        } else {
+            ret = nvs_erase_key(nvs, BULK_NVS_KEY);
+            if (ret == ESP_ERR_NVS_NOT_FOUND) {
+                ret = ESP_OK;
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save resume point: %s", esp_err_to_name(ret));
+    }
+}
+
+static void resume_clear(void)
+{
+    memset(&s_bulk.resume, 0, sizeof(s_bulk.resume));
+    resume_save();
+}
+
+/* ============================================================================
+ * Writer task
+ * ============================================================================ */
+
+static void finish(bt_bulk_state_t state, bt_bulk_result_t result)
+{
+    s_bulk.active = false;
+    update_status();
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    s_bulk.status.state = state;
+    s_bulk.status.result = result;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    
+    if (state == BT_BULK_DONE) {
+        ESP_LOGI(TAG, "✓ Uploaded %lu bytes to %s at %lu B/s (%lu resends)",
+                 (unsigned long)s_bulk.size, s_bulk.partition->label,
+                 (unsigned long)s_bulk.status.bytes_per_s, (unsigned long)s_bulk.status.resends);
+    } else {
+        ESP_LOGE(TAG, "Upload failed: %d", result);
+    }
+    publish_status(s_done_event);
+}
+
+/* Ask the client to continue from `offset`; a gap is reported once */
+static void request_resend(uint32_t offset, bool once)
+{
+    if (once && s_bulk.nak_offset == offset) {
+        return;
+    }
+    
+    s_bulk.nak_offset = offset;
+    portENTER_CRITICAL(&s_bulk.lock);
+    s_bulk.status.resends++;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_ERR_RESEND, offset);
+}
+
+static void handle_start(const bt_bulk_request_t *req, uint8_t flags)
+{
+    char label[BT_BULK_PARTITION_LEN + 1] = {0};
+    memcpy(label, req->start.partition, BT_BULK_PARTITION_LEN);
+    
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_ANY,
+                                                                ESP_PARTITION_SUBTYPE_ANY, label);
+    // Firmware goes through OTA, never through a raw partition write
+    if (partition == NULL || partition->type == ESP_PARTITION_TYPE_APP) {
+        reply(BT_BULK_OP_START, BT_BULK_ERR_NO_PARTITION, 0);
+        return;
+    }
+    if (req->start.size == 0 || req->start.offset % SPI_FLASH_SEC_SIZE != 0) {
+        reply(BT_BULK_OP_START, BT_BULK_ERR_BAD_REQUEST, 0);
+        return;
+    }
+    if ((uint64_t)req->start.offset + req->start.size > partition->size) {
+        reply(BT_BULK_OP_START, BT_BULK_ERR_TOO_LARGE, 0);
+        return;
+    }
+    
+    bool resumable = !(flags & BT_BULK_START_FLAG_RESTART) &&
+                     s_bulk.resume.version == BULK_RESUME_VERSION &&
+                     strcmp(s_bulk.resume.partition, label) == 0 &&
+                     s_bulk.resume.offset == req->start.offset &&
+                     s_bulk.resume.size == req->start.size &&
+                     s_bulk.resume.crc32 == req->start.crc32;
+    
+    s_bulk.partition = partition;
+    s_bulk.base = req->start.offset;
+    s_bulk.size = req->start.size;
+    s_bulk.image_crc = req->start.crc32;
+    s_bulk.verified = resumable ? s_bulk.resume.verified : 0;
+    s_bulk.next_expected = s_bulk.verified;
+    s_bulk.erased_end = s_bulk.verified;
+    s_bulk.block_crc = 0;
+    s_bulk.nak_offset = BULK_NO_OFFSET;
+    s_bulk.start_verified = s_bulk.verified;
+    s_bulk.start_us = esp_timer_get_time();
+    s_bulk.progress_us = s_bulk.start_us;
+    s_bulk.active = true;
+    
+    if (!resumable) {
+        s_bulk.resume = (bulk_resume_t){
+            .version = BULK_RESUME_VERSION,
+            .offset = req->start.offset,
+            .size = req->start.size,
+            .crc32 = req->start.crc32,
+        };
+        strcpy(s_bulk.resume.partition, label);
+        resume_save();
+    }
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    memset(&s_bulk.status, 0, sizeof(s_bulk.status));
+    s_bulk.status.state = BT_BULK_RUNNING;
+    strcpy(s_bulk.status.partition, label);
+    s_bulk.status.offset = s_bulk.base;
+    s_bulk.status.size = s_bulk.size;
+    s_bulk.status.verified = s_bulk.verified;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    
+    ESP_LOGI(TAG, "Upload of %lu bytes to %s+0x%lx %s at %lu", (unsigned long)s_bulk.size,
+             label, (unsigned long)s_bulk.base, resumable ? "resumed" : "started",
+             (unsigned long)s_bulk.verified);
+    reply(BT_BULK_OP_START, BT_BULK_OK, s_bulk.verified);
+    publish_status(s_progress_event);
+}
+
+static void handle_data(const uint8_t *buf, uint16_t len)
+{
+    if (!s_bulk.active || len <= sizeof(bt_bulk_data_t)) {
+        return;
+    }
+    
+    const bt_bulk_data_t *chunk = (const bt_bulk_data_t *)buf;
+    uint32_t offset = chunk->offset;
+    if (offset != s_bulk.next_expected) {
+        // Earlier data is a duplicate; later data means a write was lost
+        if (offset > s_bulk.next_expected) {
+            request_resend(s_bulk.next_expected, true);
+        }
+        return;
+    }
+    
+    // Never past the current block or the image; the client resends the rest
+    uint32_t block_end = s_bulk.verified + BT_BULK_BLOCK_SIZE;
+    if (block_end > s_bulk.size) {
+        block_end = s_bulk.size;
+    }
+    uint32_t n = len - sizeof(bt_bulk_data_t);
+    if (offset + n > block_end) {
+        n = block_end - offset;
+    }
+    if (n == 0) {
+        return;
+    }
+    
+    if (offset + n > s_bulk.erased_end) {
+        esp_err_t ret = esp_partition_erase_range(s_bulk.partition, s_bulk.base + s_bulk.erased_end,
+                                                  BT_BULK_BLOCK_SIZE);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Erase at 0x%lx failed: %s", (unsigned long)s_bulk.erased_end,
+                     esp_err_to_name(ret));
+            finish(BT_BULK_FAILED, BT_BULK_ERR_FLASH);
+            reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_ERR_FLASH, s_bulk.verified);
+            return;
+        }
+        s_bulk.erased_end += BT_BULK_BLOCK_SIZE;
+    }
+    
+    esp_err_t ret = esp_partition_write(s_bulk.partition, s_bulk.base + offset, chunk->data, n);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Write at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(ret));
+        finish(BT_BULK_FAILED, BT_BULK_ERR_FLASH);
+        reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_ERR_FLASH, s_bulk.verified);
+        return;
+    }
+    
+    s_bulk.block_crc = esp_rom_crc32_le(s_bulk.block_crc, chunk->data, n);
+    s_bulk.next_expected += n;
+    s_bulk.nak_offset = BULK_NO_OFFSET;
+    bt_link_note_traffic();
+}
+
+static void handle_block_crc(const bt_bulk_request_t *req)
+{
+    if (!s_bulk.active) {
+        reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_ERR_NOT_STARTED, 0);
+        return;
+    }
+    if (req->block.offset > s_bulk.verified) {
+        // Sent ahead of data that is being resent; the client sends it again
+        return;
+    }
+    if (req->block.offset < s_bulk.verified) {
+        reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_OK, s_bulk.verified);
+        return;
+    }
+    
+    uint32_t block_end = s_bulk.verified + BT_BULK_BLOCK_SIZE;
+    if (block_end > s_bulk.size) {
+        block_end = s_bulk.size;
+    }
+    if (s_bulk.next_expected != block_end) {
+        request_resend(s_bulk.next_expected, false);
+        return;
+    }
+    
+    if (req->block.crc32 != s_bulk.block_crc) {
+        ESP_LOGW(TAG, "Block at 0x%lx failed its CRC", (unsigned long)s_bulk.verified);
+        // Erase and write the block again
+        s_bulk.next_expected = s_bulk.verified;
+        s_bulk.erased_end = s_bulk.verified;
+        s_bulk.block_crc = 0;
+        request_resend(s_bulk.verified, false);
+        return;
+    }
+    
+    s_bulk.verified = block_end;
+    s_bulk.block_crc = 0;
+    s_bulk.resume.verified = s_bulk.verified;
+    if (++s_bulk.unsaved_blocks >= BULK_SAVE_BLOCKS) {
+        resume_save();
+    }
+    reply(BT_BULK_OP_BLOCK_CRC, BT_BULK_OK, s_bulk.verified);
+    
+    update_status();
+    int64_t now = esp_timer_get_time();
+    if (now - s_bulk.progress_us >= BULK_PROGRESS_US) {
+        s_bulk.progress_us = now;
+        publish_status(s_progress_event);
+    }
+}
+
+/* CRC of the whole image as it reads back from flash */
+static esp_err_t image_crc(uint32_t *out)
+{
+    uint8_t *buf = memory_pool_alloc(BULK_VERIFY_CHUNK);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    uint32_t crc = 0;
+    esp_err_t ret = ESP_OK;
+    for (uint32_t pos = 0; pos < s_bulk.size && ret == ESP_OK; pos += BULK_VERIFY_CHUNK) {
+        uint32_t n = s_bulk.size - pos;
+        if (n > BULK_VERIFY_CHUNK) {
+            n = BULK_VERIFY_CHUNK;
+        }
+        ret = esp_partition_read(s_bulk.partition, s_bulk.base + pos, buf, n);
+        crc = esp_rom_crc32_le(crc, buf, n);
+    }
+    
+    memory_pool_free(buf);
+    *out = crc;
+    return ret;
+}
+
+static void handle_finish(void)
+{
+    if (!s_bulk.active) {
+        reply(BT_BULK_OP_FINISH, BT_BULK_ERR_NOT_STARTED, 0);
+        return;
+    }
+    if (s_bulk.verified != s_bulk.size) {
+        reply(BT_BULK_OP_FINISH, BT_BULK_ERR_RESEND, s_bulk.verified);
+        return;
+    }
+    
+    if (s_bulk.image_crc != 0) {
+        uint32_t crc = 0;
+        esp_err_t ret = image_crc(&crc);
+        if (ret != ESP_OK || crc != s_bulk.image_crc) {
+            ESP_LOGE(TAG, "Image CRC 0x%08lx, expected 0x%08lx", (unsigned long)crc,
+                     (unsigned long)s_bulk.image_crc);
+            resume_clear();
+            finish(BT_BULK_FAILED, ret == ESP_OK ? BT_BULK_ERR_IMAGE_CRC : BT_BULK_ERR_FLASH);
+            reply(BT_BULK_OP_FINISH, BT_BULK_ERR_IMAGE_CRC, 0);
+            return;
+        }
+    }
+    
+    resume_clear();
+    finish(BT_BULK_DONE, BT_BULK_OK);
+    reply(BT_BULK_OP_FINISH, BT_BULK_OK, s_bulk.size);
+}
+
+static void handle_abort(void)
+{
+    bool was_active = s_bulk.active;
+    
+    s_bulk.active = false;
+    resume_clear();
+    if (was_active) {
+        finish(BT_BULK_FAILED, BT_BULK_ERR_ABORTED);
+    }
+}
+
+/* ============================================================================
+ * Flight log download
+ * ============================================================================ */
+
+/**
+ * @brief flight_recorder_read() sink: queue the bytes as notifications
+ *
+ * Waits while the TX ring is full, so the read goes at the link's pace.
+ */
+static esp_err_t flight_send(const void *data, size_t len, void *user_data)
+{
+    uint32_t *total = (uint32_t *)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+    while (len > 0) {
+        uint16_t n = len < BULK_FLIGHT_CHUNK ? (uint16_t)len : BULK_FLIGHT_CHUNK;
+        esp_err_t ret = bluetooth_service_send_notification(bytes, n);
+        for (int waited = 0; ret == ESP_ERR_NO_MEM && waited < BULK_FLIGHT_STALL_MS;
+             waited += BULK_FLIGHT_RETRY_MS) {
+            vTaskDelay(pdMS_TO_TICKS(BULK_FLIGHT_RETRY_MS));
+            ret = bluetooth_service_send_notification(bytes, n);
+        }
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        bytes += n;
+        len -= n;
+        *total += n;
+    }
+    return ESP_OK;
+}
+
+static void handle_flight_log(const bt_bulk_request_t *req)
+{
+    if (s_bulk.active) {
+        reply(BT_BULK_OP_FLIGHT_LOG, BT_BULK_ERR_BAD_REQUEST, 0);
+        return;
+    }
+    
+    uint32_t total = 0;
+    esp_err_t ret = flight_recorder_read(req->flight.minutes, flight_send, &total);
+    
+    bt_bulk_result_t result = BT_BULK_OK;
+    if (ret == ESP_ERR_NOT_SUPPORTED || ret == ESP_ERR_INVALID_STATE) {
+        result = BT_BULK_ERR_NO_LOG;
+    } else if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Flight log stopped after %lu bytes: %s", (unsigned long)total,
+                 esp_err_to_name(ret));
+        result = BT_BULK_ERR_ABORTED;
+    } else {
+        ESP_LOGI(TAG, "Flight log sent, %lu bytes", (unsigned long)total);
+    }
+    reply(BT_BULK_OP_FLIGHT_LOG, result, total);
+}
+
+static void handle_control(const uint8_t *buf, uint16_t len)
+{
+    bt_bulk_request_t req = {0};
+    memcpy(&req, buf, len < sizeof(req) ? len : sizeof(req));
+    
+    switch (req.op) {
+    case BT_BULK_OP_START:
+        handle_start(&req, req.flags);
+        break;
+    
+    case BT_BULK_OP_BLOCK_CRC:
+        handle_block_crc(&req);
+        break;
+    
+    case BT_BULK_OP_FINISH:
+        handle_finish();
+        break;
+    
+    case BT_BULK_OP_ABORT:
+        handle_abort();
+        reply(BT_BULK_OP_ABORT, BT_BULK_OK, 0);
+        break;
+    
+    case BT_BULK_OP_FLIGHT_LOG:
+        handle_flight_log(&req);
+        break;
+    
+    default:
+        reply(req.op, BT_BULK_ERR_BAD_REQUEST, 0);
+        break;
+    }
+}
+
+static void bulk_task(void *arg)
+{
+    bulk_msg_t msg;
+    
+    while (xQueueReceive(s_bulk.queue, &msg, portMAX_DELAY) == pdTRUE) {
+        switch (msg.kind) {
+        case BULK_MSG_CONTROL:
+            handle_control(msg.buf, msg.len);
+            break;
+    
+        case BULK_MSG_DATA:
+            handle_data(msg.buf, msg.len);
+            break;
+    
+        case BULK_MSG_DISCONNECT:
+            if (s_bulk.active) {
+                // The client resumes with a new START after reconnecting
+                s_bulk.active = false;
+                resume_save();
+                update_status();
+                ESP_LOGI(TAG, "Upload paused at %lu bytes", (unsigned long)s_bulk.verified);
+            }
+            break;
+    
+        case BULK_MSG_ABORT:
+            handle_abort();
+            break;
+        }
+        memory_pool_free(msg.buf);
+    
+        if (s_bulk.power_held != s_bulk.active) {
+            s_bulk.power_held = s_bulk.active;
+            if (s_bulk.active) {
+                system_power_lock_acquire(s_bulk.power_lock);
+            } else {
+                system_power_lock_release(s_bulk.power_lock);
+            }
+        }
+    }
+}
+
+/* ============================================================================
+ * Glue and public API
+ * ============================================================================ */
+
+esp_err_t bt_bulk_init(void)
+{
+    esp_err_t ret = system_event_register_topic("bluetooth.bulk_progress",
+                                                SYSTEM_EVENT_TOPIC_LATEST, &s_progress_event);
+    if (ret == ESP_OK) {
+        ret = system_event_register_topic("bluetooth.bulk_done",
+                                          SYSTEM_EVENT_TOPIC_QUEUED, &s_done_event);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    resume_load();
+    
+    // Created once, the task outlives a deinit of the service
+    if (s_bulk.task != NULL) {
+        return ESP_OK;
+    }
+    
+    ret = system_power_lock_create(SYSTEM_POWER_LOCK_CPU_MAX, "bt_bulk", &s_bulk.power_lock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    s_bulk.queue = SYSTEM_QUEUE_CREATE(s_bulk_queue_storage, BULK_QUEUE_LEN, sizeof(bulk_msg_t));
+    if (s_bulk.queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Above the TX task: acknowledgements pace the client
+    BaseType_t created = SYSTEM_TASK_CREATE(s_bulk_task_storage, bulk_task, "bt_bulk",
+                                            BULK_TASK_STACK, NULL, 7, &s_bulk.task);
+    return created == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void bt_bulk_set_handles(uint16_t control_handle, uint16_t data_handle)
+{
+    s_bulk.control_handle = control_handle;
+    s_bulk.data_handle = data_handle;
+}
+
+bool bt_bulk_on_write(uint16_t handle, const uint8_t *value, uint16_t len)
+{
+    bulk_msg_kind_t kind;
+    if (handle == s_bulk.data_handle && handle != 0) {
+        kind = BULK_MSG_DATA;
+    } else if (handle == s_bulk.control_handle && handle != 0) {
+        kind = BULK_MSG_CONTROL;
+    } else {
+        return false;
+    }
+    if (s_bulk.queue == NULL || len == 0) {
+        return true;
+    }
+    
+    bulk_msg_t msg = {
+        .kind = kind,
+        .len = len,
+        .buf = memory_pool_alloc(len),
+    };
+    if (msg.buf != NULL) {
+        memcpy(msg.buf, value, len);
+        // Data is resent on a gap; a control request must not be lost
+        TickType_t wait = (kind == BULK_MSG_CONTROL) ? pdMS_TO_TICKS(BULK_CONTROL_TIMEOUT_MS) : 0;
+        if (xQueueSend(s_bulk.queue, &msg, wait) == pdTRUE) {
+            return true;
+        }
+        memory_pool_free(msg.buf);
+    }
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    s_bulk.status.dropped_writes++;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    return true;
+}
+
+void bt_bulk_on_disconnect(void)
+{
+    if (s_bulk.queue == NULL) {
+        return;
+    }
+    
+    // Queued behind the writes already received, so they are flashed first
+    bulk_msg_t msg = { .kind = BULK_MSG_DISCONNECT };
+    xQueueSend(s_bulk.queue, &msg, pdMS_TO_TICKS(BULK_CONTROL_TIMEOUT_MS));
+}
+
+esp_err_t bluetooth_bulk_get_status(bt_bulk_status_t *status)
+{
+    if (status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_bulk.lock);
+    *status = s_bulk.status;
+    portEXIT_CRITICAL(&s_bulk.lock);
+    return ESP_OK;
+}
+
+esp_err_t bluetooth_bulk_abort(void)
+{
+    if (s_bulk.queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Through the writer task, behind any writes already queued
+    bulk_msg_t msg = { .kind = BULK_MSG_ABORT };
+    if (xQueueSend(s_bulk.queue, &msg, pdMS_TO_TICKS(BULK_CONTROL_TIMEOUT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
@@ -1,20 +1,30 @@
 #include "bluetooth_service.h"
+#include "bluetooth_internal.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/boot_trace.h"
+#include "system_service/system_log.h"
 #include "service_watchdog.h"
 #include "resource_quota.h"
+#include "system_service/static_alloc.h"
 #include "esp_log.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
 #include "esp_gap_ble_api.h"
 #include "esp_gatts_api.h"
 #include "esp_gatt_common_api.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <inttypes.h>
 
 static const char *TAG = "bluetooth_service";
 
+SYSTEM_EVENT_SCHEMA_DEFINE(BT_EVENT_SCHEMA, BT_EVENT);
+
 // BLE configuration
 #define DEVICE_NAME             "Kraken-OS"
 
@@ -22,41 +32,71 @@ static const char *TAG = "bluetooth_service";
 #define GATTS_SERVICE_UUID      0x00FF  // Custom service
 #define GATTS_CHAR_UUID_NOTIFY  0xFF01  // Notify characteristic
 #define GATTS_CHAR_UUID_WRITE   0xFF02  // Write characteristic
+#define GATTS_CHAR_UUID_BULK_CTRL 0xFF03  // Bulk transfer control, see bluetooth_bulk.h
+#define GATTS_CHAR_UUID_BULK_DATA 0xFF04  // Bulk transfer data
 
-#define GATTS_NUM_HANDLE        4
+// Service + 2 handles per characteristic + 1 per CCCD
+#define GATTS_NUM_HANDLE        11
 #define GATTS_DEMO_CHAR_VAL_LEN_MAX 0x40
 
+// Notification TX queue
+#define BT_LOCAL_MTU            500
+#define BT_ATT_HEADER_LEN       3
+#define BT_TX_RING_SIZE         (8 * 1024)
+#define BT_TX_MAX_IN_FLIGHT     4       // Unconfirmed notifications handed to the stack
+#define BT_TX_TASK_STACK        3072
+#define BT_TX_RATE_WINDOW_MS    1000
+#define BT_LE_DATA_LEN_MAX      251     // Longest link-layer payload (DLE)
+
+// Automatic link profile selection
+#define BT_BUSY_HOLD_MS         1000    // Traffic this recent keeps LOW_LATENCY
+#define BT_IDLE_TIMEOUT_MS      5000    // No traffic this long selects LOW_POWER
+#define BT_ADV_FAST_WINDOW_MS   30000   // FAST advertising before dropping to SLOW
+
 static system_service_id_t bt_service_id = 0;
-static system_event_type_t bt_events[8];
 static bool initialized = false;
-static bool running = false;
 static bool is_connected = false;
 static uint16_t gatts_if_handle = ESP_GATT_IF_NONE;
 static uint16_t conn_id = 0;
 static uint16_t service_handle = 0;
 static uint16_t notify_handle = 0;
-static TaskHandle_t heartbeat_task_handle = NULL;
+static uint16_t notify_cccd_handle = 0;
+static uint16_t write_handle = 0;
+static uint16_t bulk_ctrl_handle = 0;
+static uint16_t bulk_ctrl_cccd_handle = 0;
+static uint16_t bulk_data_handle = 0;
 
-/* Heartbeat task - sends periodic heartbeats to watchdog */
-static void bt_heartbeat_task(void *arg)
-{
-    ESP_LOGI(TAG, "Heartbeat task started");
-    
-    while (running) {
-        // Send heartbeat every 10 seconds (watchdog timeout is 45s)
-        vTaskDelay(pdMS_TO_TICKS(10000));
-        
-        if (running) {
-            system_service_heartbeat(bt_service_id);
-            ESP_LOGI(TAG, "Heartbeat sent (service_id=%d)", bt_service_id);
-        }
-    }
-    
-    ESP_LOGI(TAG, "Heartbeat task exiting");
-    heartbeat_task_handle = NULL;
-    vTaskDelete(NULL);
-}
+/*
+ * Characteristics of the service, added one at a time: each ADD_CHAR (or
+ * ADD_CHAR_DESCR for those with a CCCD) event adds the next one.
+ */
+typedef struct {
+    uint16_t uuid;
+    esp_gatt_perm_t perm;
+    esp_gatt_char_prop_t prop;
+    uint16_t *handle;
+    uint16_t *cccd_handle;          // NULL for no CCCD
+} gatt_char_def_t;
 
+static const gatt_char_def_t gatt_chars[] = {
+    { GATTS_CHAR_UUID_NOTIFY, ESP_GATT_PERM_READ,
+      ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY,
+      &notify_handle, &notify_cccd_handle },
+    { GATTS_CHAR_UUID_WRITE, ESP_GATT_PERM_WRITE,
+      ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR,
+      &write_handle, NULL },
+    { GATTS_CHAR_UUID_BULK_CTRL, ESP_GATT_PERM_WRITE,
+      ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_NOTIFY,
+      &bulk_ctrl_handle, &bulk_ctrl_cccd_handle },
+    { GATTS_CHAR_UUID_BULK_DATA, ESP_GATT_PERM_WRITE,
+      ESP_GATT_CHAR_PROP_BIT_WRITE_NR,
+      &bulk_data_handle, NULL },
+};
+
+#define GATT_CHAR_COUNT         (sizeof(gatt_chars) / sizeof(gatt_chars[0]))
+
+static size_t gatt_char_step = 0;
+static bt_device_info_t peer_info = {0};
 // Advertising configuration flags
 static uint8_t adv_config_done = 0;
 #define adv_config_flag      (1 << 0)
@@ -103,16 +143,88 @@ static esp_ble_adv_data_t scan_rsp_data = {
     .flag = (ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT),
 };
 
-// Advertising parameters
+// Advertising parameters; intervals come from the advertising profile
 static esp_ble_adv_params_t adv_params = {
     .adv_int_min = 0x20,   // 20ms
-    .adv_int_max = 0x40,   // 40ms  
+    .adv_int_max = 0x40,   // 40ms
     .adv_type = ADV_TYPE_IND,
     .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
     .channel_map = ADV_CHNL_ALL,
     .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
 };
 
+// Connection intervals in 1.25 ms units, supervision timeout in 10 ms units
+typedef struct {
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+} conn_profile_params_t;
+
+static const conn_profile_params_t conn_profiles[BT_CONN_PROFILE_COUNT] = {
+    [BT_CONN_PROFILE_LOW_LATENCY] = { .min_int = 0x06, .max_int = 0x0C, .latency = 0, .timeout = 400 },
+    [BT_CONN_PROFILE_INTERACTIVE] = { .min_int = 0x10, .max_int = 0x20, .latency = 0, .timeout = 400 },
+    [BT_CONN_PROFILE_LOW_POWER]   = { .min_int = 0x50, .max_int = 0xA0, .latency = 4, .timeout = 600 },
+};
+
+static const char *const conn_profile_names[BT_CONN_PROFILE_COUNT] = {
+    "low-latency", "interactive", "low-power",
+};
+
+// Advertising intervals in 0.625 ms units
+static const uint16_t adv_profiles[BT_ADV_PROFILE_COUNT][2] = {
+    [BT_ADV_PROFILE_FAST]     = { 0x20, 0x40 },
+    [BT_ADV_PROFILE_BALANCED] = { 0xA0, 0xF0 },
+    [BT_ADV_PROFILE_SLOW]     = { 0x640, 0x800 },
+};
+
+static struct {
+    bt_conn_profile_t conn_profile;
+    bt_adv_profile_t adv_profile;
+    bool conn_auto;
+    bool adv_auto;
+    bool advertising;
+    bool adv_restart;               // Start again with new intervals once stopped
+    int64_t adv_start_us;
+    int64_t connected_us;
+    int64_t last_traffic_us;
+} s_link = {
+    .conn_profile = BT_CONN_PROFILE_INTERACTIVE,
+    .adv_profile = BT_ADV_PROFILE_FAST,
+    .conn_auto = true,
+    .adv_auto = true,
+};
+
+/*
+ * Notification TX state. The ring is filled by senders under ring_lock and
+ * drained by the TX task; the flow-control fields are updated from the
+ * Bluedroid callback under flow_lock.
+ */
+static struct {
+    uint8_t ring[BT_TX_RING_SIZE];
+    size_t head;                    // Next byte to send
+    size_t used;
+    SemaphoreHandle_t ring_lock;
+    
+    portMUX_TYPE flow_lock;
+    uint16_t mtu;
+    uint16_t in_flight;
+    bool congested;
+    bool notify_enabled;
+    
+    TaskHandle_t task;
+    uint8_t packet[BT_LOCAL_MTU - BT_ATT_HEADER_LEN];
+    int64_t window_start_us;
+    uint32_t window_bytes;
+    bt_tx_stats_t stats;
+} s_tx = {
+    .flow_lock = portMUX_INITIALIZER_UNLOCKED,
+    .mtu = ESP_GATT_DEF_BLE_MTU_SIZE,
+};
+
+SYSTEM_TASK_DEFINE(s_tx_task, BT_TX_TASK_STACK);
+SYSTEM_MUTEX_DEFINE(s_tx_ring_lock);
+
 // Characteristic value
 static uint8_t char_value[GATTS_DEMO_CHAR_VAL_LEN_MAX] = {0};
 static uint8_t char_value_len = 0;
@@ -120,6 +232,7 @@ static uint8_t char_value_len = 0;
 // Forward declarations
 static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
 static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+static void adv_start(void);
 
 // GAP event handler
 static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
@@ -129,7 +242,7 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         adv_config_done &= (~adv_config_flag);
         if (adv_config_done == 0) {
             ESP_LOGI(TAG, "✓ Advertising data set, starting advertising...");
-            esp_ble_gap_start_advertising(&adv_params);
+            adv_start();
         }
         break;
         
@@ -137,14 +250,19 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         adv_config_done &= (~scan_rsp_config_flag);
         if (adv_config_done == 0) {
             ESP_LOGI(TAG, "✓ Scan response data set, starting advertising...");
-            esp_ble_gap_start_advertising(&adv_params);
+            adv_start();
         }
         break;
         
     case ESP_GAP_BLE_ADV_START_COMPLETE_EVT:
         if (param->adv_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
             ESP_LOGE(TAG, "Advertising start failed: %d", param->adv_start_cmpl.status);
+        } else if (s_link.advertising) {
+            ESP_LOGI(TAG, "Advertising every %d-%d ms",
+                     adv_params.adv_int_min * 5 / 8, adv_params.adv_int_max * 5 / 8);
         } else {
+            s_link.advertising = true;
+            s_link.adv_start_us = esp_timer_get_time();
             ESP_LOGI(TAG, "╔════════════════════════════════════════╗");
             ESP_LOGI(TAG, "║  BLUETOOTH ADVERTISING ACTIVE!         ║");
             ESP_LOGI(TAG, "╚════════════════════════════════════════╝");
@@ -156,9 +274,23 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         break;
         
     case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT:
+        if (s_link.adv_restart) {
+            s_link.adv_restart = false;
+            adv_start();
+            break;
+        }
+        s_link.advertising = false;
         ESP_LOGI(TAG, "Advertising stopped");
         break;
         
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+        ESP_LOGD(TAG, "Connection interval %d.%02d ms, latency %d, timeout %d ms",
+                 param->update_conn_params.conn_int * 5 / 4,
+                 param->update_conn_params.conn_int * 125 % 100,
+                 param->update_conn_params.latency,
+                 param->update_conn_params.timeout * 10);
+        break;
+        
     case ESP_GAP_BLE_PASSKEY_REQ_EVT:
         ESP_LOGI(TAG, "Passkey request");
         // Auto-accept for now (you can implement custom passkey here)
@@ -192,6 +324,270 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
     }
 }
 
+/* Copy out up to max queued bytes without consuming them */
+static size_t tx_ring_peek(uint8_t *out, size_t max)
+{
+    size_t n = s_tx.used < max ? s_tx.used : max;
+    size_t first = BT_TX_RING_SIZE - s_tx.head;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, &s_tx.ring[s_tx.head], first);
+    memcpy(out + first, s_tx.ring, n - first);
+    return n;
+}
+
+static void tx_ring_consume(size_t n)
+{
+    s_tx.head = (s_tx.head + n) % BT_TX_RING_SIZE;
+    s_tx.used -= n;
+}
+
+static void tx_wake(void)
+{
+    if (s_tx.task != NULL) {
+        xTaskNotifyGive(s_tx.task);
+    }
+}
+
+/* Forget queued data and flow state when the link goes away */
+static void tx_reset(void)
+{
+    if (s_tx.ring_lock != NULL) {
+        xSemaphoreTake(s_tx.ring_lock, portMAX_DELAY);
+        s_tx.head = 0;
+        s_tx.used = 0;
+        xSemaphoreGive(s_tx.ring_lock);
+    }
+    
+    portENTER_CRITICAL(&s_tx.flow_lock);
+    s_tx.mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
+    s_tx.in_flight = 0;
+    s_tx.congested = false;
+    s_tx.notify_enabled = false;
+    portEXIT_CRITICAL(&s_tx.flow_lock);
+}
+
+/* Room for one more notification, and how large it may be */
+static size_t tx_slot(void)
+{
+    size_t payload = 0;
+    
+    portENTER_CRITICAL(&s_tx.flow_lock);
+    if (is_connected && s_tx.notify_enabled && !s_tx.congested &&
+        s_tx.in_flight < BT_TX_MAX_IN_FLIGHT) {
+        payload = s_tx.mtu - BT_ATT_HEADER_LEN;
+        s_tx.in_flight++;
+    }
+    portEXIT_CRITICAL(&s_tx.flow_lock);
+    
+    if (payload > sizeof(s_tx.packet)) {
+        payload = sizeof(s_tx.packet);
+    }
+    return payload;
+}
+
+static void tx_slot_return(void)
+{
+    portENTER_CRITICAL(&s_tx.flow_lock);
+    if (s_tx.in_flight > 0) {
+        s_tx.in_flight--;
+    }
+    portEXIT_CRITICAL(&s_tx.flow_lock);
+}
+
+static void tx_update_rate(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - s_tx.window_start_us;
+    if (elapsed < BT_TX_RATE_WINDOW_MS * 1000LL) {
+        return;
+    }
+    
+    s_tx.stats.bytes_per_s = (uint32_t)(s_tx.window_bytes * 1000000LL / elapsed);
+    s_tx.window_bytes = 0;
+    s_tx.window_start_us = now;
+}
+
+static void link_apply_conn_profile(bt_conn_profile_t profile)
+{
+    s_link.conn_profile = profile;
+    if (!is_connected) {
+        return;
+    }
+    
+    const conn_profile_params_t *p = &conn_profiles[profile];
+    esp_ble_conn_update_params_t conn_params = {
+        .min_int = p->min_int,
+        .max_int = p->max_int,
+        .latency = p->latency,
+        .timeout = p->timeout,
+    };
+    memcpy(conn_params.bda, peer_info.address, sizeof(esp_bd_addr_t));
+    
+    esp_err_t ret = esp_ble_gap_update_conn_params(&conn_params);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Connection update to %s failed: %s",
+                 conn_profile_names[profile], esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGD(TAG, "Requested %s connection parameters", conn_profile_names[profile]);
+}
+
+static void adv_start(void)
+{
+    adv_params.adv_int_min = adv_profiles[s_link.adv_profile][0];
+    adv_params.adv_int_max = adv_profiles[s_link.adv_profile][1];
+    esp_ble_gap_start_advertising(&adv_params);
+}
+
+static void link_apply_adv_profile(bt_adv_profile_t profile)
+{
+    if (profile == s_link.adv_profile) {
+        return;
+    }
+    
+    s_link.adv_profile = profile;
+    if (s_link.advertising) {
+        // Intervals only change on a fresh start; STOP_COMPLETE restarts
+        s_link.adv_restart = true;
+        esp_ble_gap_stop_advertising();
+    }
+}
+
+/* Note data moving over the link; the TX task picks the profile */
+static void link_note_traffic(void)
+{
+    s_link.last_traffic_us = esp_timer_get_time();
+    if (s_link.conn_auto && s_link.conn_profile != BT_CONN_PROFILE_LOW_LATENCY) {
+        tx_wake();
+    }
+}
+
+/*
+ * Automatic profile selection, run by the TX task on every wake: fast
+ * intervals while data moves, long ones once the link has been idle.
+ */
+static void link_auto_update(void)
+{
+    int64_t now = esp_timer_get_time();
+    
+    if (is_connected && s_link.conn_auto) {
+        int64_t quiet_since = s_link.last_traffic_us > s_link.connected_us ?
+                              s_link.last_traffic_us : s_link.connected_us;
+        bool busy = s_tx.used > 0 || s_tx.in_flight > 0 ||
+                    now - s_link.last_traffic_us < BT_BUSY_HOLD_MS * 1000LL;
+        
+        bt_conn_profile_t want = s_link.conn_profile;
+        if (busy) {
+            want = BT_CONN_PROFILE_LOW_LATENCY;
+        } else if (now - quiet_since >= BT_IDLE_TIMEOUT_MS * 1000LL) {
+            want = BT_CONN_PROFILE_LOW_POWER;
+        }
+        if (want != s_link.conn_profile) {
+            link_apply_conn_profile(want);
+        }
+    }
+    
+    if (s_link.advertising && s_link.adv_auto && s_link.adv_profile == BT_ADV_PROFILE_FAST &&
+        now - s_link.adv_start_us >= BT_ADV_FAST_WINDOW_MS * 1000LL) {
+        ESP_LOGI(TAG, "No connection after %d s, advertising slowly", BT_ADV_FAST_WINDOW_MS / 1000);
+        link_apply_adv_profile(BT_ADV_PROFILE_SLOW);
+    }
+}
+
+/*
+ * Drain the ring into notifications. Each one carries as many queued bytes
+ * as the MTU allows, so bursts of small sends leave as a few full packets.
+ * CONF and CONGEST events wake the task when a slot frees up.
+ */
+static void tx_task(void *arg)
+{
+    s_tx.window_start_us = esp_timer_get_time();
+    
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BT_TX_RATE_WINDOW_MS));
+        tx_update_rate();
+        link_auto_update();
+        
+        size_t payload;
+        while ((payload = tx_slot()) > 0) {
+            xSemaphoreTake(s_tx.ring_lock, portMAX_DELAY);
+            size_t n = tx_ring_peek(s_tx.packet, payload);
+            xSemaphoreGive(s_tx.ring_lock);
+            if (n == 0) {
+                tx_slot_return();
+                break;
+            }
+            
+            // The stack copies the packet, so it can be reused right away
+            esp_err_t ret = esp_ble_gatts_send_indicate(gatts_if_handle, conn_id, notify_handle,
+                                                        n, s_tx.packet, false);
+            if (ret != ESP_OK) {
+                tx_slot_return();
+                ESP_LOGD(TAG, "Notification deferred: %s", esp_err_to_name(ret));
+                break;
+            }
+            
+            xSemaphoreTake(s_tx.ring_lock, portMAX_DELAY);
+            tx_ring_consume(n);
+            xSemaphoreGive(s_tx.ring_lock);
+            
+            s_tx.stats.bytes_sent += n;
+            s_tx.stats.packets_sent++;
+            s_tx.window_bytes += n;
+        }
+    }
+}
+
+/*
+ * Move a client write into a pool block owned by the event bus. The
+ * bt_data_event_t header and the bytes share the block, so this memcpy out
+ * of the stack's buffer is the only copy between the link and subscribers.
+ */
+static void post_rx_data(const esp_ble_gatts_cb_param_t *param)
+{
+    bt_data_event_t *rx = NULL;
+    esp_err_t ret = system_event_loan(sizeof(*rx) + param->write.len, (void **)&rx);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Dropped %d byte write: %s", param->write.len, esp_err_to_name(ret));
+        return;
+    }
+    
+    uint8_t *bytes = (uint8_t *)(rx + 1);
+    memcpy(bytes, param->write.value, param->write.len);
+    rx->data = bytes;
+    rx->length = param->write.len;
+    rx->handle = param->write.handle;
+    rx->device = peer_info;
+    
+    system_event_post_loaned(bt_service_id,
+                             BT_EVENT_DATA_RECEIVED,
+                             rx, sizeof(*rx) + param->write.len,
+                             SYSTEM_EVENT_PRIORITY_NORMAL);
+}
+
+/* Add the next characteristic of gatt_chars[], or finish the table */
+static void gatt_add_next_char(void)
+{
+    if (gatt_char_step >= GATT_CHAR_COUNT) {
+        ESP_LOGI(TAG, "✓ Characteristics added (notify %d, write %d, bulk %d/%d)",
+                 notify_handle, write_handle, bulk_ctrl_handle, bulk_data_handle);
+        bt_bulk_set_handles(bulk_ctrl_handle, bulk_data_handle);
+        return;
+    }
+    
+    const gatt_char_def_t *def = &gatt_chars[gatt_char_step];
+    esp_bt_uuid_t uuid = {
+        .len = ESP_UUID_LEN_16,
+        .uuid.uuid16 = def->uuid,
+    };
+    esp_err_t ret = esp_ble_gatts_add_char(service_handle, &uuid, def->perm, def->prop, NULL, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add characteristic 0x%04x: %s", def->uuid, esp_err_to_name(ret));
+    }
+}
+
 // GATTS event handler
 static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
 {
@@ -234,6 +630,65 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
         ESP_LOGI(TAG, "✓ Service created, handle: %d", param->create.service_handle);
         service_handle = param->create.service_handle;
         esp_ble_gatts_start_service(service_handle);
+        
+        gatt_char_step = 0;
+        gatt_add_next_char();
+        break;
+        
+    case ESP_GATTS_ADD_CHAR_EVT:
+        if (param->add_char.status != ESP_GATT_OK || gatt_char_step >= GATT_CHAR_COUNT) {
+            ESP_LOGE(TAG, "Add characteristic failed: %d", param->add_char.status);
+            break;
+        }
+        *gatt_chars[gatt_char_step].handle = param->add_char.attr_handle;
+        if (gatt_chars[gatt_char_step].cccd_handle != NULL) {
+            esp_bt_uuid_t cccd_uuid = {
+                .len = ESP_UUID_LEN_16,
+                .uuid.uuid16 = ESP_GATT_UUID_CHAR_CLIENT_CONFIG,
+            };
+            esp_ble_gatts_add_char_descr(service_handle, &cccd_uuid,
+                                         ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+                                         NULL, NULL);
+        } else {
+            gatt_char_step++;
+            gatt_add_next_char();
+        }
+        break;
+        
+    case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+        if (param->add_char_descr.status != ESP_GATT_OK || gatt_char_step >= GATT_CHAR_COUNT) {
+            ESP_LOGE(TAG, "Add descriptor failed: %d", param->add_char_descr.status);
+            break;
+        }
+        *gatt_chars[gatt_char_step].cccd_handle = param->add_char_descr.attr_handle;
+        gatt_char_step++;
+        gatt_add_next_char();
+        break;
+        
+    case ESP_GATTS_MTU_EVT:
+        ESP_LOGI(TAG, "MTU negotiated: %d", param->mtu.mtu);
+        portENTER_CRITICAL(&s_tx.flow_lock);
+        s_tx.mtu = param->mtu.mtu;
+        portEXIT_CRITICAL(&s_tx.flow_lock);
+        break;
+        
+    case ESP_GATTS_CONF_EVT:
+        // One queued notification left the stack; direct replies hold no slot
+        if (param->conf.handle == notify_handle) {
+            tx_slot_return();
+            tx_wake();
+        }
+        break;
+        
+    case ESP_GATTS_CONGEST_EVT:
+        portENTER_CRITICAL(&s_tx.flow_lock);
+        s_tx.congested = param->congest.congested;
+        portEXIT_CRITICAL(&s_tx.flow_lock);
+        if (param->congest.congested) {
+            s_tx.stats.congestion_events++;
+        } else {
+            tx_wake();
+        }
         break;
         
     case ESP_GATTS_START_EVT:
@@ -253,31 +708,35 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
         conn_id = param->connect.conn_id;
         is_connected = true;
         
+        memcpy(peer_info.address, param->connect.remote_bda, 6);
+        snprintf(peer_info.name, sizeof(peer_info.name), "Phone");
+        peer_info.rssi = -50;
+        
         // Send heartbeat on connection
         system_service_heartbeat(bt_service_id);
         
         // Post connection event
         bt_connection_event_t event_data = {
+            .device = peer_info,
             .connected = true
         };
-        memcpy(event_data.device.address, param->connect.remote_bda, 6);
-        snprintf(event_data.device.name, sizeof(event_data.device.name), "Phone");
-        event_data.device.rssi = -50;
-        
-        system_event_post(bt_service_id,
-                         bt_events[BT_EVENT_CONNECTED],
-                         &event_data,
-                         sizeof(event_data),
-                         SYSTEM_EVENT_PRIORITY_HIGH);
-        
-        // Update connection parameters
-        esp_ble_conn_update_params_t conn_params = {0};
-        memcpy(conn_params.bda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
-        conn_params.latency = 0;
-        conn_params.max_int = 0x20;    // max_int = 0x20*1.25ms = 40ms
-        conn_params.min_int = 0x10;    // min_int = 0x10*1.25ms = 20ms
-        conn_params.timeout = 400;     // timeout = 400*10ms = 4000ms
-        esp_ble_gap_update_conn_params(&conn_params);
+        
+        SYSTEM_EVENT_POST_TYPED(bt_service_id, BT_EVENT_CONNECTED,
+                                &event_data, SYSTEM_EVENT_PRIORITY_HIGH);
+        
+        // Advertising stops with the connection; start on the interactive profile
+        s_link.advertising = false;
+        s_link.adv_restart = false;
+        s_link.connected_us = esp_timer_get_time();
+        link_apply_conn_profile(s_link.conn_auto ? BT_CONN_PROFILE_INTERACTIVE : s_link.conn_profile);
+        
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+        // 2M PHY and long link-layer packets carry bulk transfers at full speed
+        esp_ble_gap_set_preferred_phy(param->connect.remote_bda, ESP_BLE_GAP_NO_PREFER_TRANSMIT_PHY,
+                                      ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                      ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+        esp_ble_gap_set_pkt_data_len(param->connect.remote_bda, BT_LE_DATA_LEN_MAX);
         break;
         
     case ESP_GATTS_DISCONNECT_EVT:
@@ -287,23 +746,51 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
         ESP_LOGI(TAG, "  Reason: %d", param->disconnect.reason);
         
         is_connected = false;
+        tx_reset();
+        bt_bulk_on_disconnect();
         
         // Post disconnection event
-        system_event_post(bt_service_id,
-                         bt_events[BT_EVENT_DISCONNECTED],
-                         NULL, 0,
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
+        SYSTEM_EVENT_POST_EMPTY(bt_service_id, BT_EVENT_DISCONNECTED, SYSTEM_EVENT_PRIORITY_NORMAL);
         
         // Restart advertising
-        esp_ble_gap_start_advertising(&adv_params);
+        if (s_link.adv_auto) {
+            s_link.adv_profile = BT_ADV_PROFILE_FAST;
+        }
+        adv_start();
         ESP_LOGI(TAG, "✓ Restarted advertising");
         break;
         
     case ESP_GATTS_WRITE_EVT:
-        ESP_LOGI(TAG, "Data received from client:");
-        ESP_LOGI(TAG, "  Handle: %d", param->write.handle);
-        ESP_LOGI(TAG, "  Length: %d bytes", param->write.len);
-        ESP_LOG_BUFFER_HEX(TAG, param->write.value, param->write.len);
+        // Bulk writes bypass the event bus and go straight to the flash writer
+        if (param->write.handle == bulk_ctrl_cccd_handle ||
+            bt_bulk_on_write(param->write.handle, param->write.value, param->write.len)) {
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                           param->write.trans_id, ESP_GATT_OK, NULL);
+            }
+            break;
+        }
+        
+        if (param->write.handle == notify_cccd_handle && param->write.len == 2) {
+            bool enabled = (param->write.value[0] & 0x01) != 0;
+            ESP_LOGI(TAG, "Notifications %s", enabled ? "enabled" : "disabled");
+            portENTER_CRITICAL(&s_tx.flow_lock);
+            s_tx.notify_enabled = enabled;
+            portEXIT_CRITICAL(&s_tx.flow_lock);
+            tx_wake();
+            if (param->write.need_rsp) {
+                esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+                                           param->write.trans_id, ESP_GATT_OK, NULL);
+            }
+            break;
+        }
+        
+        // Deferred and rate limited: the buffer is gone by the time the
+        // message is formatted, so only its first bytes are carried along
+        uint8_t head[4] = {0};
+        memcpy(head, param->write.value, param->write.len < sizeof(head) ? param->write.len : sizeof(head));
+        SYSTEM_LOGD(bt_service_id, TAG, "Write: handle %d, %d bytes: %02x %02x %02x %02x...",
+                    param->write.handle, param->write.len, head[0], head[1], head[2], head[3]);
         
         // Store the value
         if (param->write.len <= GATTS_DEMO_CHAR_VAL_LEN_MAX) {
@@ -311,17 +798,8 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
             char_value_len = param->write.len;
         }
         
-        // Post data received event
-        bt_data_event_t data_event = {
-            .data = param->write.value,
-            .length = param->write.len
-        };
-        
-        system_event_post(bt_service_id,
-                         bt_events[BT_EVENT_DATA_RECEIVED],
-                         &data_event,
-                         sizeof(data_event),
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
+        post_rx_data(param);
+        link_note_traffic();
         
         // Send response if needed
         if (param->write.need_rsp) {
@@ -370,26 +848,13 @@ esp_err_t bluetooth_service_init(void)
     ESP_LOGI(TAG, "✓ Registered with system service (ID: %d)", bt_service_id);
     
     // Register event types
-    const char *event_names[] = {
-        "bluetooth.registered",
-        "bluetooth.started",
-        "bluetooth.stopped",
-        "bluetooth.connected",
-        "bluetooth.disconnected",
-        "bluetooth.pairing_request",
-        "bluetooth.data_received",
-        "bluetooth.error"
-    };
-    
-    for (int i = 0; i < 8; i++) {
-        ret = system_event_register_type(event_names[i], &bt_events[i]);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to register event type '%s'", event_names[i]);
-            return ret;
-        }
+    ret = SYSTEM_EVENT_SCHEMA_REGISTER(BT_EVENT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register event types: %s", esp_err_to_name(ret));
+        goto fail_registered;
     }
     
-    ESP_LOGI(TAG, "✓ Registered %d event types", 8);
+    ESP_LOGI(TAG, "✓ Registered %d event types", BT_EVENT_COUNT);
     
     // Register with watchdog
     service_watchdog_config_t watchdog_config = {
@@ -403,20 +868,21 @@ esp_err_t bluetooth_service_init(void)
     
     // Set resource quotas
     service_quota_t quota = {
-        .max_events_per_sec = 30,         // Max 30 events/sec
+        .max_events_per_sec = 200,        // Every client write is an event
         .max_subscriptions = 12,          // Max 12 subscriptions
-        .max_event_data_size = 512,       // Max 512 bytes per event
+        .max_event_data_size = 1024,      // A full 512-byte write plus its header
         .max_memory_bytes = 128 * 1024    // Max 128KB memory
     };
     quota_set(bt_service_id, &quota);
-    ESP_LOGI(TAG, "✓ Resource quotas set (30 events/s, 128KB memory)");
+    ESP_LOGI(TAG, "✓ Resource quotas set (200 events/s, 128KB memory)");
     
     // Initialize Bluetooth controller
+    boot_trace_id_t phase = boot_trace_begin("bt_controller");
     esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
     ret = esp_bt_controller_init(&bt_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize BT controller: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_watchdog;
     }
     ESP_LOGI(TAG, "✓ BT controller initialized");
     
@@ -424,23 +890,26 @@ esp_err_t bluetooth_service_init(void)
     ret = esp_bt_controller_enable(ESP_BT_MODE_BLE);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to enable BT controller: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_controller;
     }
+    boot_trace_end(phase);
     ESP_LOGI(TAG, "✓ BT controller enabled (BLE mode)");
     
     // Initialize Bluedroid stack
+    phase = boot_trace_begin("bluedroid");
     ret = esp_bluedroid_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to init bluedroid: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_enabled;
     }
     ESP_LOGI(TAG, "✓ Bluedroid initialized");
     
     ret = esp_bluedroid_enable();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to enable bluedroid: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_bluedroid;
     }
+    boot_trace_end(phase);
     ESP_LOGI(TAG, "✓ Bluedroid enabled");
     
     // Configure BLE security for pairing/bonding (matching official HID example)
@@ -464,7 +933,7 @@ esp_err_t bluetooth_service_init(void)
     ret = esp_ble_gap_register_callback(gap_event_handler);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register GAP callback: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_stack;
     }
     ESP_LOGI(TAG, "✓ GAP callback registered");
     
@@ -472,16 +941,34 @@ esp_err_t bluetooth_service_init(void)
     ret = esp_ble_gatts_register_callback(gatts_event_handler);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register GATTS callback: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_stack;
     }
     ESP_LOGI(TAG, "✓ GATT server callback registered");
     
     // Set MTU early for better compatibility
-    ret = esp_ble_gatt_set_local_mtu(500);
+    ret = esp_ble_gatt_set_local_mtu(BT_LOCAL_MTU);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to set MTU: %s", esp_err_to_name(ret));
     } else {
-        ESP_LOGI(TAG, "✓ MTU set to 500");
+        ESP_LOGI(TAG, "✓ MTU set to %d", BT_LOCAL_MTU);
+    }
+    
+    // Notification TX queue, kept across deinit like the bulk task
+    if (s_tx.task == NULL) {
+        s_tx.ring_lock = SYSTEM_MUTEX_CREATE(s_tx_ring_lock);
+        BaseType_t created = SYSTEM_TASK_CREATE(s_tx_task, tx_task, "bt_tx", BT_TX_TASK_STACK,
+                                                NULL, 6, &s_tx.task);
+        if (s_tx.ring_lock == NULL || created != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create TX task");
+            ret = ESP_ERR_NO_MEM;
+            goto fail_stack;
+        }
+    }
+    
+    ret = bt_bulk_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init bulk transfer: %s", esp_err_to_name(ret));
+        goto fail_stack;
     }
     
     // Set service state
@@ -490,15 +977,27 @@ esp_err_t bluetooth_service_init(void)
     initialized = true;
     
     // Post registration event
-    system_event_post(bt_service_id,
-                     bt_events[BT_EVENT_REGISTERED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(bt_service_id, BT_EVENT_REGISTERED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Bluetooth service initialized successfully");
     ESP_LOGI(TAG, "  → Posted BT_EVENT_REGISTERED");
     
     return ESP_OK;
+    
+    // Undo what was brought up, so a later init (an activation retry) starts clean
+fail_stack:
+    esp_bluedroid_disable();
+fail_bluedroid:
+    esp_bluedroid_deinit();
+fail_enabled:
+    esp_bt_controller_disable();
+fail_controller:
+    esp_bt_controller_deinit();
+fail_watchdog:
+    watchdog_unregister_service(bt_service_id);
+fail_registered:
+    system_service_unregister(bt_service_id);
+    return ret;
 }
 
 esp_err_t bluetooth_service_deinit(void)
@@ -509,6 +1008,32 @@ esp_err_t bluetooth_service_deinit(void)
     
     ESP_LOGI(TAG, "Deinitializing bluetooth service...");
     
+    // The controller and Bluedroid hold nearly all of the service's RAM
+    if (s_link.advertising) {
+        esp_ble_gap_stop_advertising();
+    }
+    esp_bluedroid_disable();
+    esp_bluedroid_deinit();
+    esp_bt_controller_disable();
+    esp_bt_controller_deinit();
+    
+    is_connected = false;
+    s_link.advertising = false;
+    s_link.adv_restart = false;
+    adv_config_done = 0;
+    gatts_if_handle = ESP_GATT_IF_NONE;
+    service_handle = 0;
+    notify_handle = 0;
+    notify_cccd_handle = 0;
+    write_handle = 0;
+    bulk_ctrl_handle = 0;
+    bulk_ctrl_cccd_handle = 0;
+    bulk_data_handle = 0;
+    bt_bulk_set_handles(0, 0);
+    tx_reset();
+    
+    // It would restart the service for missing heartbeats
+    watchdog_unregister_service(bt_service_id);
     system_service_unregister(bt_service_id);
     initialized = false;
     
@@ -535,28 +1060,15 @@ esp_err_t bluetooth_service_start(void)
     // Send immediate heartbeat to reset watchdog timer
     system_service_heartbeat(bt_service_id);
     
-    // Start heartbeat task
-    running = true;
-    BaseType_t task_ret = xTaskCreate(
-        bt_heartbeat_task,
-        "bt_heartbeat",
-        4096,  // Increased stack size to prevent overflow
-        NULL,
-        3,
-        &heartbeat_task_handle
-    );
-    
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create heartbeat task");
-        running = false;
-        return ESP_FAIL;
+    // Periodic heartbeats from the shared system timer
+    esp_err_t ret = system_service_enable_auto_heartbeat(bt_service_id, NULL, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable heartbeats: %s", esp_err_to_name(ret));
+        return ret;
     }
     
     // Post started event
-    system_event_post(bt_service_id,
-                     bt_events[BT_EVENT_STARTED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(bt_service_id, BT_EVENT_STARTED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     // Send heartbeat to watchdog
     system_service_heartbeat(bt_service_id);
@@ -577,19 +1089,16 @@ esp_err_t bluetooth_service_stop(void)
     
     ESP_LOGI(TAG, "Stopping bluetooth service...");
     
-    // Stop heartbeat task
-    running = false;
-    if (heartbeat_task_handle != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(100));  // Give task time to exit
-    }
+    // Stop periodic heartbeats
+    system_service_disable_auto_heartbeat(bt_service_id);
+    
+    // Queued notifications are not sent after stop
+    tx_reset();
     
     system_service_set_state(bt_service_id, SYSTEM_SERVICE_STATE_STOPPING);
     
     // Post stopped event
-    system_event_post(bt_service_id,
-                     bt_events[BT_EVENT_STOPPED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(bt_service_id, BT_EVENT_STOPPED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Bluetooth service stopped");
     
@@ -606,28 +1115,96 @@ bool bluetooth_service_is_connected(void)
     return is_connected;
 }
 
+bool bluetooth_service_is_advertising(void)
+{
+    return s_link.advertising;
+}
+
 esp_err_t bluetooth_service_send_notification(const uint8_t *data, uint16_t len)
 {
-    if (!initialized || !is_connected) {
+    if (!initialized || !is_connected || !s_tx.notify_enabled) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    if (notify_handle == 0) {
-        ESP_LOGW(TAG, "Notify characteristic not created yet");
-        return ESP_ERR_INVALID_STATE;
+    xSemaphoreTake(s_tx.ring_lock, portMAX_DELAY);
+    if (BT_TX_RING_SIZE - s_tx.used < len) {
+        xSemaphoreGive(s_tx.ring_lock);
+        s_tx.stats.rejected_bytes += len;
+        return ESP_ERR_NO_MEM;
     }
     
-    esp_err_t ret = esp_ble_gatts_send_indicate(gatts_if_handle, conn_id, notify_handle,
-                                                len, (uint8_t*)data, false);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to send notification: %s", esp_err_to_name(ret));
-        return ret;
+    size_t tail = (s_tx.head + s_tx.used) % BT_TX_RING_SIZE;
+    size_t first = BT_TX_RING_SIZE - tail;
+    if (first > len) {
+        first = len;
     }
+    memcpy(&s_tx.ring[tail], data, first);
+    memcpy(s_tx.ring, data + first, len - first);
+    s_tx.used += len;
+    xSemaphoreGive(s_tx.ring_lock);
     
-    ESP_LOGI(TAG, "✓ Sent notification to client (%d bytes)", len);
+    s_link.last_traffic_us = esp_timer_get_time();
+    tx_wake();
     return ESP_OK;
 }
 
+esp_err_t bluetooth_service_get_tx_stats(bt_tx_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *stats = s_tx.stats;
+    stats->queued_bytes = s_tx.used;
+    portENTER_CRITICAL(&s_tx.flow_lock);
+    stats->in_flight = s_tx.in_flight;
+    stats->mtu = s_tx.mtu;
+    portEXIT_CRITICAL(&s_tx.flow_lock);
+    return ESP_OK;
+}
+
+esp_err_t bluetooth_service_set_conn_profile(bt_conn_profile_t profile)
+{
+    if (profile >= BT_CONN_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_link.conn_auto = false;
+    link_apply_conn_profile(profile);
+    return ESP_OK;
+}
+
+bt_conn_profile_t bluetooth_service_get_conn_profile(void)
+{
+    return s_link.conn_profile;
+}
+
+esp_err_t bluetooth_service_set_adv_profile(bt_adv_profile_t profile)
+{
+    if (profile >= BT_ADV_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_link.adv_auto = false;
+    link_apply_adv_profile(profile);
+    return ESP_OK;
+}
+
+bt_adv_profile_t bluetooth_service_get_adv_profile(void)
+{
+    return s_link.adv_profile;
+}
+
+void bluetooth_service_set_auto_profiles(bool enable)
+{
+    s_link.conn_auto = enable;
+    s_link.adv_auto = enable;
+    tx_wake();
+}
+
 esp_err_t bluetooth_service_start_advertising(void)
 {
     if (!initialized) {
@@ -668,3 +1245,18 @@ esp_err_t bluetooth_service_stop_advertising(void)
     
     return ESP_OK;
 }
+
+esp_err_t bt_gatts_notify(uint16_t attr_handle, const uint8_t *data, uint16_t len)
+{
+    if (!is_connected || attr_handle == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    return esp_ble_gatts_send_indicate(gatts_if_handle, conn_id, attr_handle,
+                                       len, (uint8_t *)data, false);
+}
+
+void bt_link_note_traffic(void)
+{
+    link_note_traffic();
+}
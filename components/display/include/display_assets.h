@@ -0,0 +1,76 @@
+/**
+ * @file display_assets.h
+ * @brief Flash-mapped UI assets and glyph bitmap cache
+ *
+ * Images and glyph atlases are pre-converted on the host (tools/mkassets.py)
+ * into an asset pack, flashed to the "assets" partition and memory-mapped at
+ * boot. Images are served as lv_image_dsc_t pointing straight into flash, so
+ * LVGL blits them without decoding or copying.
+ *
+ * Text goes through wrapper fonts. A glyph found in the font's atlas is
+ * drawn from its pre-rendered A8 bitmap in flash; any other glyph is
+ * rasterised once by the built-in font into a PSRAM cache and reused from
+ * there. Layout and kerning always come from the built-in font.
+ */
+
+#ifndef DISPLAY_ASSETS_H
+#define DISPLAY_ASSETS_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t images;                // Images in the mapped pack
+    uint32_t atlas_glyphs;          // Glyphs served from flash atlases
+    uint32_t glyph_hits;            // Cached glyph bitmaps reused
+    uint32_t glyph_misses;          // Glyphs rasterised into the cache
+    uint32_t glyph_evictions;
+    uint32_t cache_bytes;           // PSRAM held by cached bitmaps
+} display_asset_stats_t;
+
+/**
+ * @brief Map the asset partition and allocate the glyph cache
+ *
+ * Called by the display service before the UI is built. A missing or
+ * invalid pack is not an error: fonts still get the glyph cache and
+ * display_assets_get_image() returns NULL.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the cache can't be allocated
+ */
+esp_err_t display_assets_init(void);
+
+// Drop the cache and unmap the pack; called after LVGL has been stopped
+void display_assets_deinit(void);
+
+/**
+ * @brief Look up an image in the asset pack
+ *
+ * @param name Asset name as given to mkassets.py
+ * @return Image descriptor for lv_image_set_src(), NULL if not in the pack
+ */
+const lv_image_dsc_t *display_assets_get_image(const char *name);
+
+/**
+ * @brief Get the cached, atlas-backed variant of a built-in font
+ *
+ * Wrappers are created on first use and live forever. Call with the
+ * display lock held.
+ *
+ * @param base Built-in font to wrap
+ * @param atlas Name of its glyph atlas in the pack, NULL for cache only
+ * @return Wrapper font, or base if all wrapper slots are taken
+ */
+const lv_font_t *display_assets_font(const lv_font_t *base, const char *atlas);
+
+void display_assets_get_stats(display_asset_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_ASSETS_H
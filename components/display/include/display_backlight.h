@@ -0,0 +1,65 @@
+/**
+ * @file display_backlight.h
+ * @brief PWM backlight with hardware fades and idle auto-dim
+ *
+ * The backlight runs on an LEDC channel and every level change is a
+ * hardware fade, so ramps cost no CPU time. An idle timer dims the
+ * backlight after a period without touch or key activity and later fades
+ * it out and turns the screen off; the next activity brings it back.
+ */
+
+#ifndef DISPLAY_BACKLIGHT_H
+#define DISPLAY_BACKLIGHT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set up the LEDC channel on pin at brightness percent; called by the display service
+esp_err_t display_backlight_init(int pin, uint8_t brightness);
+
+void display_backlight_deinit(void);
+
+// Set the user brightness (0-100) and fade to it; counts as activity
+esp_err_t display_backlight_set_brightness(uint8_t brightness);
+
+/**
+ * @brief Report user activity
+ *
+ * Restores full brightness if dimmed, turns the screen back on if the
+ * idle timer turned it off, and restarts the idle timer. Cheap when the
+ * backlight is already at full brightness; safe from any task.
+ */
+void display_backlight_notify_activity(void);
+
+/**
+ * @brief Set the idle timeouts
+ * @param dim_ms Inactivity before dimming, 0 never dims
+ * @param off_ms Inactivity before the screen turns off, 0 never turns off
+ * @return ESP_OK on success
+ */
+esp_err_t display_backlight_set_idle_timeouts(uint32_t dim_ms, uint32_t off_ms);
+
+/**
+ * @brief Switch to the shorter power-save timeouts
+ *
+ * Used by the power service while running on a low battery.
+ *
+ * @param enable true for the power-save timeouts, false for the normal ones
+ */
+void display_backlight_set_power_save(bool enable);
+
+// Called by display_screen_on()/display_screen_off()
+void display_backlight_screen_on(void);
+
+void display_backlight_screen_off(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_BACKLIGHT_H
@@ -0,0 +1,113 @@
+/**
+ * @file display_latency.h
+ * @brief Touch-to-photon latency tracer
+ *
+ * With CONFIG_DISPLAY_SERVICE_LATENCY_TRACE, every tap is a trace. The
+ * trace is stamped as it passes each stage:
+ *   - the touch INT edge
+ *   - the LVGL reads of the press and the release
+ *   - the menu callback
+ *   - the menu.*_clicked event arriving from the bus
+ *   - nav_push()
+ *   - the end of the first frame flushed after it
+ * The menu event carries the trace tag, so the bus stage is matched to
+ * its own tap. Taps that open no screen within a second are counted as
+ * incomplete and dropped.
+ *
+ * The scripted mode taps one main menu item through a virtual pointer
+ * device, waits for the screen, goes back and repeats, so runs can be
+ * compared between builds:
+ *
+ *     display_latency_run_script(20);
+ *     ...
+ *     display_latency_report_t report;
+ *     display_latency_get_report(&report);
+ *
+ * A report is also logged and posted on display.latency_report at the
+ * end of every run.
+ */
+
+#ifndef DISPLAY_LATENCY_H
+#define DISPLAY_LATENCY_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "system_service/system_types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DISPLAY_LATENCY_STAGE_TOUCH = 0,    // INT edge, or injection; the trace origin
+    DISPLAY_LATENCY_STAGE_PRESS,        // LVGL read the press
+    DISPLAY_LATENCY_STAGE_RELEASE,      // LVGL read the release, which clicks
+    DISPLAY_LATENCY_STAGE_CLICK,        // Menu item callback
+    DISPLAY_LATENCY_STAGE_BUS,          // menu.*_clicked delivered
+    DISPLAY_LATENCY_STAGE_NAV,          // nav_push() of the new screen
+    DISPLAY_LATENCY_STAGE_FLUSH,        // New screen flushed to the panel
+    DISPLAY_LATENCY_STAGE_COUNT,
+} display_latency_stage_t;
+
+typedef struct {
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} display_latency_percentiles_t;
+
+typedef struct {
+    uint32_t samples;               // Complete traces in the window
+    uint32_t incomplete;            // Traces dropped since the last reset
+    // Time from the previous stamped stage; TOUCH is always 0
+    display_latency_percentiles_t stage[DISPLAY_LATENCY_STAGE_COUNT];
+    display_latency_percentiles_t end_to_end;   // TOUCH to FLUSH
+} display_latency_report_t;
+
+/* ---- Hooks for the display service ---- */
+
+// Subscribe to the menu events; events are the menu.*_clicked types, back is menu.back_clicked
+esp_err_t display_latency_init(system_service_id_t service_id, lv_display_t *disp,
+                               const system_event_type_t *events, size_t event_count,
+                               system_event_type_t back_event);
+
+// Main menu container, whose CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_ITEM child the script taps
+void display_latency_set_menu(lv_obj_t *menu);
+
+// A finger went down at at_us; starts a trace unless one is running
+void display_latency_touch(int64_t at_us);
+
+// Stamp a stage of the running trace, once; LVGL task
+void display_latency_stamp(display_latency_stage_t stage);
+
+// Tag of the running trace for the menu event payload, 0 if none
+uint32_t display_latency_tag(void);
+
+// End of a refresh; completes a trace that reached NAV when it drew something
+void display_latency_frame_done(bool rendered, int64_t now_us);
+
+/* ---- Public API ---- */
+
+/**
+ * @brief Tap the configured menu item taps times
+ *
+ * Returns at once; the run completes in the LVGL task.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE while a run is in progress,
+ *         ESP_ERR_NOT_SUPPORTED without CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+ */
+esp_err_t display_latency_run_script(uint16_t taps);
+
+// Percentiles over the last CONFIG_DISPLAY_SERVICE_LATENCY_SAMPLES complete traces
+esp_err_t display_latency_get_report(display_latency_report_t *report);
+
+void display_latency_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_LATENCY_H
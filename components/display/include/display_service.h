@@ -18,6 +18,8 @@ typedef enum {
     DISPLAY_EVENT_SCREEN_OFF,
     DISPLAY_EVENT_ORIENTATION_CHANGED,
     DISPLAY_EVENT_ERROR,
+    DISPLAY_EVENT_FRAME_STATS,
+    DISPLAY_EVENT_COUNT,
 } display_event_id_t;
 
 typedef enum {
@@ -35,6 +37,27 @@ typedef struct {
     display_orientation_t orientation;
 } display_orientation_event_t;
 
+// Frame timing over one stats window, payload of DISPLAY_EVENT_FRAME_STATS
+typedef struct {
+    uint32_t window_ms;
+    uint32_t frames;
+    uint32_t fps;
+    uint32_t render_avg_us;
+    uint32_t render_max_us;
+    uint32_t flush_avg_us;          // Flush callback plus waiting for SPI DMA
+    uint32_t flush_max_us;
+    uint32_t area_avg_px;           // Invalidated pixels per frame (upper bound)
+    uint32_t lock_waits;            // display service lvgl_port_lock() calls
+    uint32_t lock_wait_avg_us;
+    uint32_t lock_wait_max_us;
+    uint32_t te_wait_avg_us;        // Waiting for the panel TE pulse per frame
+    uint32_t te_wait_max_us;
+    uint32_t te_missed;             // Frames flushed after the TE wait timed out
+    uint32_t touch_responses;       // Frames that answered a touch
+    uint32_t touch_latency_avg_us;  // Touch INT (or drag read) to end of that frame
+    uint32_t touch_latency_max_us;
+} display_frame_stats_t;
+
 esp_err_t display_service_init(void);
 
 esp_err_t display_service_deinit(void);
@@ -53,6 +76,20 @@ esp_err_t display_screen_off(void);
 
 esp_err_t display_set_orientation(display_orientation_t orientation);
 
+/**
+ * @brief Get the frame rate of the last stats window
+ * @param fps Output frames per second, 0 while the screen is static
+ * @return ESP_OK on success
+ */
+esp_err_t display_get_fps(uint32_t *fps);
+
+/**
+ * @brief Get the frame timing of the last stats window
+ * @param stats Output stats
+ * @return ESP_OK on success
+ */
+esp_err_t display_get_frame_stats(display_frame_stats_t *stats);
+
 system_service_id_t display_service_get_id(void);
 
 /**
@@ -62,6 +99,31 @@ system_service_id_t display_service_get_id(void);
  */
 esp_err_t display_service_load_screen(lv_obj_t *content);
 
+/**
+ * @brief Load screen content that is kept warm when popped
+ * 
+ * Going back hides the content instead of deleting it and keeps it in a
+ * small LRU screen cache under key. Cached screens may be deleted at any
+ * time to bound the cache or free LVGL memory, so watch LV_EVENT_DELETE
+ * before holding on to the pointer.
+ * 
+ * An app's screens should use the app name, or "name/..." keys: they are
+ * deleted, on the stack or cached, when the app hibernates.
+ * 
+ * @param content Content container to display
+ * @param key Cache key; must outlive the content (use a string literal)
+ * @return ESP_OK on success
+ */
+esp_err_t display_service_load_screen_cached(lv_obj_t *content, const char *key);
+
+/**
+ * @brief Take a screen out of the screen cache
+ * @param key Key it was loaded with
+ * @return The content, ready for display_service_load_screen_cached(), or
+ *         NULL if it is not cached and has to be built again
+ */
+lv_obj_t* display_service_take_cached_screen(const char *key);
+
 /**
  * @brief Get the main LVGL screen object for creating content
  * @return LVGL screen object or NULL
@@ -0,0 +1,83 @@
+/**
+ * @file display_ui_queue.h
+ * @brief Lock-free UI command queue into the LVGL task
+ *
+ * Any task can post small widget updates here without taking the LVGL
+ * port lock. The LVGL task applies everything queued at the start of each
+ * refresh, so updates posted between two frames land in the same frame.
+ * Commands that do not fit are dropped and counted.
+ */
+
+#ifndef DISPLAY_UI_QUEUE_H
+#define DISPLAY_UI_QUEUE_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest text a SET_TEXT command carries, including the terminator
+#define DISPLAY_UI_TEXT_MAX 32
+
+// Function run in the LVGL task with the port lock held
+typedef void (*display_ui_fn_t)(void *arg);
+
+// Attach the queue to the display / detach it; called by the display service
+esp_err_t display_ui_queue_init(lv_display_t *disp);
+
+void display_ui_queue_deinit(void);
+
+/**
+ * @brief Set a label's text
+ * @param label Label object
+ * @param text Text, truncated to DISPLAY_UI_TEXT_MAX - 1 characters
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t display_ui_set_text(lv_obj_t *label, const char *text);
+
+/**
+ * @brief Set the value of a bar, slider or arc
+ * @param obj Widget
+ * @param value New value
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t display_ui_set_value(lv_obj_t *obj, int32_t value);
+
+/**
+ * @brief Show or hide an object
+ * @param obj Object
+ * @param hidden true to hide
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t display_ui_set_hidden(lv_obj_t *obj, bool hidden);
+
+/**
+ * @brief Push screen content on the navigation stack
+ * @param content Content container
+ * @param cache_key Screen cache key, or NULL to delete the content when popped
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t display_ui_load_screen(lv_obj_t *content, const char *cache_key);
+
+/**
+ * @brief Run a function in the LVGL task
+ *
+ * For updates that are more than one widget call. fn must not block.
+ *
+ * @param fn Function to run
+ * @param arg Passed to fn
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t display_ui_call(display_ui_fn_t fn, void *arg);
+
+// Number of commands dropped because the queue was full
+uint32_t display_ui_get_drops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DISPLAY_UI_QUEUE_H
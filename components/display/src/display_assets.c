@@ -0,0 +1,495 @@
+/**
+ * @file display_assets.c
+ * @brief Flash-mapped UI assets and glyph bitmap cache
+ *
+ * Asset pack layout (little endian, all data 4-byte aligned so LVGL can
+ * use it in place):
+ *
+ *   pack_header_t | pack_entry_t[entry_count] | entry data ...
+ *
+ * Image data is RGB565 pixels, for RGB565A8 followed by the alpha plane.
+ * Atlas data is a glyph count, an atlas_glyph_t table sorted by codepoint
+ * and the A8 bitmaps it points at.
+ *
+ * The glyph cache is 2-way set associative, keyed by (wrapper font, glyph
+ * id). Only the LVGL task draws (one SW draw unit) and a glyph bitmap is
+ * used only until the next glyph is fetched, so a miss may evict freely.
+ */
+
+#include "display_assets.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "display_assets";
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+#define ASSET_PARTITION         CONFIG_DISPLAY_SERVICE_ASSET_PARTITION
+#define GLYPH_CACHE_WAYS        2
+#define GLYPH_CACHE_SETS        (CONFIG_DISPLAY_SERVICE_GLYPH_CACHE_ENTRIES / GLYPH_CACHE_WAYS)
+#define MAX_ASSET_FONTS         6
+#define ATLAS_GLYPH_FLAG        0x80000000u     // gid.index refers to the atlas
+
+/* ============================================================================
+ * Pack Format (mirrors tools/mkassets.py)
+ * ============================================================================ */
+
+#define PACK_MAGIC              0x3153414B      // "KAS1"
+#define PACK_VERSION            1
+#define ASSET_NAME_LEN          24
+
+typedef enum {
+    ASSET_TYPE_IMAGE = 1,
+    ASSET_TYPE_GLYPHS = 2,
+} asset_type_t;
+
+typedef enum {
+    ASSET_FMT_RGB565 = 1,
+    ASSET_FMT_RGB565A8 = 2,
+} asset_format_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_count;
+    uint32_t total_size;            // Header, table and data
+    uint32_t reserved;
+} pack_header_t;
+
+typedef struct {
+    char name[ASSET_NAME_LEN];      // NUL padded
+    uint8_t type;                   // asset_type_t
+    uint8_t format;                 // asset_format_t, images only
+    uint16_t reserved;
+    uint16_t width;                 // Images only
+    uint16_t height;
+    uint32_t offset;                // From the start of the pack
+    uint32_t size;
+} pack_entry_t;
+
+typedef struct {
+    uint32_t codepoint;
+    uint32_t offset;                // From the start of the atlas data
+    uint16_t box_w;                 // Bitmap stride is box_w
+    uint16_t box_h;
+} atlas_glyph_t;
+
+_Static_assert(sizeof(pack_header_t) == 16, "pack header layout");
+_Static_assert(sizeof(pack_entry_t) == 40, "pack entry layout");
+_Static_assert(sizeof(atlas_glyph_t) == 12, "atlas glyph layout");
+
+/* ============================================================================
+ * State
+ * ============================================================================ */
+
+typedef struct {
+    lv_font_t font;                 // First: LVGL hands back &font
+    const lv_font_t *base;
+    const atlas_glyph_t *glyphs;    // In flash, NULL without an atlas
+    uint32_t glyph_count;
+    lv_draw_buf_t *glyph_bufs;      // One per atlas glyph, data in flash
+} asset_font_t;
+
+typedef struct {
+    const lv_font_t *font;          // NULL while empty
+    uint32_t index;
+    lv_draw_buf_t buf;
+    uint8_t *mem;                   // PSRAM behind buf, kept across refills
+    uint32_t capacity;
+} glyph_slot_t;
+
+typedef struct {
+    glyph_slot_t way[GLYPH_CACHE_WAYS];
+    uint8_t victim;                 // Least recently used way
+} glyph_set_t;
+
+typedef struct {
+    bool initialized;
+    const uint8_t *pack;            // NULL if no valid pack is mapped
+    esp_partition_mmap_handle_t mmap_handle;
+    const pack_entry_t *entries;
+    uint16_t entry_count;
+    lv_image_dsc_t *images;         // Parallel to entries
+    glyph_set_t *cache;             // NULL when not initialized
+    display_asset_stats_t stats;
+} assets_t;
+
+static assets_t s_assets = {0};
+
+// Wrappers outlive deinit: labels may still point at them
+static asset_font_t s_fonts[MAX_ASSET_FONTS];
+static uint8_t s_font_count = 0;
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static void *psram_alloc(size_t size)
+{
+    void *ptr = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ptr == NULL) {
+        ptr = heap_caps_calloc(1, size, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+static const pack_entry_t *find_entry(const char *name, asset_type_t type)
+{
+    if (s_assets.pack == NULL || name == NULL) {
+        return NULL;
+    }
+    
+    for (uint16_t i = 0; i < s_assets.entry_count; i++) {
+        const pack_entry_t *entry = &s_assets.entries[i];
+        if (entry->type == type && strncmp(entry->name, name, ASSET_NAME_LEN) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* Build the image descriptors; entries that don't add up are skipped */
+static void load_images(void)
+{
+    for (uint16_t i = 0; i < s_assets.entry_count; i++) {
+        const pack_entry_t *entry = &s_assets.entries[i];
+        if (entry->type != ASSET_TYPE_IMAGE) {
+            continue;
+        }
+    
+        uint32_t pixels = (uint32_t)entry->width * entry->height;
+        uint32_t needed = entry->format == ASSET_FMT_RGB565A8 ? pixels * 3 : pixels * 2;
+        if ((entry->format != ASSET_FMT_RGB565 && entry->format != ASSET_FMT_RGB565A8) ||
+            pixels == 0 || entry->size < needed) {
+            ESP_LOGW(TAG, "Skipping malformed image '%.*s'", ASSET_NAME_LEN, entry->name);
+            continue;
+        }
+    
+        lv_image_dsc_t *img = &s_assets.images[i];
+        img->header.magic = LV_IMAGE_HEADER_MAGIC;
+        img->header.cf = entry->format == ASSET_FMT_RGB565A8 ?
+                         LV_COLOR_FORMAT_RGB565A8 : LV_COLOR_FORMAT_RGB565;
+        img->header.w = entry->width;
+        img->header.h = entry->height;
+        img->header.stride = entry->width * 2;
+        img->data_size = entry->size;
+        img->data = s_assets.pack + entry->offset;
+        s_assets.stats.images++;
+    }
+}
+
+/* Map the asset partition and check the pack; no pack is not an error */
+static void map_pack(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           ASSET_PARTITION);
+    if (part == NULL) {
+        ESP_LOGI(TAG, "No '%s' partition, fonts use the glyph cache only", ASSET_PARTITION);
+        return;
+    }
+    
+    const void *ptr = NULL;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to map '%s': %s", ASSET_PARTITION, esp_err_to_name(ret));
+        return;
+    }
+    
+    const pack_header_t *header = ptr;
+    size_t table_end = sizeof(*header) + (size_t)header->entry_count * sizeof(pack_entry_t);
+    bool valid = header->magic == PACK_MAGIC && header->version == PACK_VERSION &&
+                 header->total_size <= part->size && table_end <= header->total_size;
+    
+    const pack_entry_t *entries = (const pack_entry_t *)(header + 1);
+    for (uint16_t i = 0; valid && i < header->entry_count; i++) {
+        valid = entries[i].offset >= table_end && (entries[i].offset & 3) == 0 &&
+                entries[i].size <= header->total_size - entries[i].offset;
+    }
+    if (!valid) {
+        // Also the case for a freshly erased partition
+        ESP_LOGW(TAG, "No valid asset pack in '%s'", ASSET_PARTITION);
+        esp_partition_munmap(handle);
+        return;
+    }
+    
+    s_assets.images = calloc(header->entry_count, sizeof(lv_image_dsc_t));
+    if (header->entry_count > 0 && s_assets.images == NULL) {
+        ESP_LOGW(TAG, "No memory for image descriptors");
+        esp_partition_munmap(handle);
+        return;
+    }
+    
+    s_assets.pack = ptr;
+    s_assets.mmap_handle = handle;
+    s_assets.entries = entries;
+    s_assets.entry_count = header->entry_count;
+    load_images();
+}
+
+/* Point the wrapper at its atlas; glyphs outside it fall back to the cache */
+static void bind_atlas(asset_font_t *af, const char *name)
+{
+    const pack_entry_t *entry = find_entry(name, ASSET_TYPE_GLYPHS);
+    if (entry == NULL) {
+        return;
+    }
+    
+    const uint8_t *data = s_assets.pack + entry->offset;
+    uint32_t count = entry->size >= 4 ? *(const uint32_t *)data : 0;
+    if (count == 0 || count > (entry->size - 4) / sizeof(atlas_glyph_t)) {
+        ESP_LOGW(TAG, "Skipping malformed atlas '%s'", name);
+        return;
+    }
+    
+    lv_draw_buf_t *bufs = psram_alloc(count * sizeof(lv_draw_buf_t));
+    if (bufs == NULL) {
+        ESP_LOGW(TAG, "No memory for atlas '%s'", name);
+        return;
+    }
+    
+    const atlas_glyph_t *glyphs = (const atlas_glyph_t *)(data + 4);
+    for (uint32_t i = 0; i < count; i++) {
+        const atlas_glyph_t *g = &glyphs[i];
+        uint32_t size = (uint32_t)g->box_w * g->box_h;
+        bool fits = (g->offset & 3) == 0 && g->offset <= entry->size && size <= entry->size - g->offset;
+        if (!fits || size == 0 ||
+            lv_draw_buf_width_to_stride(g->box_w, LV_COLOR_FORMAT_A8) != g->box_w ||
+            lv_draw_buf_init(&bufs[i], g->box_w, g->box_h, LV_COLOR_FORMAT_A8, g->box_w,
+                             (void *)(data + g->offset), size) != LV_RESULT_OK) {
+            ESP_LOGW(TAG, "Skipping malformed atlas '%s'", name);
+            heap_caps_free(bufs);
+            return;
+        }
+    }
+    
+    af->glyphs = glyphs;
+    af->glyph_count = count;
+    af->glyph_bufs = bufs;
+    ESP_LOGI(TAG, "Font atlas '%s': %lu glyphs", name, (unsigned long)count);
+}
+
+static const atlas_glyph_t *atlas_find(const asset_font_t *af, uint32_t letter)
+{
+    uint32_t lo = 0;
+    uint32_t hi = af->glyph_count;
+    
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (af->glyphs[mid].codepoint < letter) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < af->glyph_count && af->glyphs[lo].codepoint == letter) ? &af->glyphs[lo] : NULL;
+}
+
+static uint32_t glyph_hash(const lv_font_t *font, uint32_t index)
+{
+    uint32_t h = (uint32_t)(uintptr_t)font * 2654435761u;
+    return (h ^ (index * 0x9E3779B1u)) % GLYPH_CACHE_SETS;
+}
+
+/* The base font reads its own glyph data through resolved_font */
+static const void *base_glyph_bitmap(const asset_font_t *af, lv_font_glyph_dsc_t *g,
+                                     lv_draw_buf_t *draw_buf)
+{
+    g->resolved_font = af->base;
+    const void *bitmap = af->base->get_glyph_bitmap(g, draw_buf);
+    g->resolved_font = &af->font;
+    return bitmap;
+}
+
+/* ============================================================================
+ * Wrapper Font Callbacks
+ * ============================================================================ */
+
+static bool asset_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc,
+                                uint32_t letter, uint32_t letter_next)
+{
+    const asset_font_t *af = (const asset_font_t *)font;
+    
+    // Metrics and kerning stay exactly the built-in font's
+    if (!af->base->get_glyph_dsc(af->base, dsc, letter, letter_next)) {
+        return false;
+    }
+    
+    if (af->glyph_count > 0 && !dsc->is_placeholder) {
+        const atlas_glyph_t *g = atlas_find(af, letter);
+        if (g != NULL && g->box_w == dsc->box_w && g->box_h == dsc->box_h) {
+            dsc->gid.index = ATLAS_GLYPH_FLAG | (uint32_t)(g - af->glyphs);
+        }
+    }
+    return true;
+}
+
+static const void *asset_get_glyph_bitmap(lv_font_glyph_dsc_t *g, lv_draw_buf_t *draw_buf)
+{
+    const asset_font_t *af = (const asset_font_t *)g->resolved_font;
+    uint32_t index = g->gid.index;
+    
+    if (index & ATLAS_GLYPH_FLAG) {
+        // Read-only A8 mask straight from flash
+        s_assets.stats.atlas_glyphs++;
+        return &af->glyph_bufs[index & ~ATLAS_GLYPH_FLAG];
+    }
+    
+    if (s_assets.cache == NULL || g->req_raw_bitmap || g->box_w == 0 || g->box_h == 0) {
+        return base_glyph_bitmap(af, g, draw_buf);
+    }
+    
+    glyph_set_t *set = &s_assets.cache[glyph_hash(&af->font, index)];
+    for (int way = 0; way < GLYPH_CACHE_WAYS; way++) {
+        glyph_slot_t *slot = &set->way[way];
+        if (slot->font == &af->font && slot->index == index) {
+            set->victim = way ^ 1;
+            s_assets.stats.glyph_hits++;
+            return &slot->buf;
+        }
+    }
+    
+    glyph_slot_t *slot = &set->way[set->victim];
+    set->victim ^= 1;
+    if (slot->font != NULL) {
+        s_assets.stats.glyph_evictions++;
+        slot->font = NULL;
+    }
+    
+    uint32_t stride = lv_draw_buf_width_to_stride(g->box_w, LV_COLOR_FORMAT_A8);
+    uint32_t size = stride * g->box_h;
+    if (size > slot->capacity) {
+        heap_caps_free(slot->mem);
+        s_assets.stats.cache_bytes -= slot->capacity;
+        slot->capacity = 0;
+        slot->mem = psram_alloc(size);
+        if (slot->mem == NULL) {
+            return base_glyph_bitmap(af, g, draw_buf);
+        }
+        slot->capacity = size;
+        s_assets.stats.cache_bytes += size;
+    }
+    
+    if (lv_draw_buf_init(&slot->buf, g->box_w, g->box_h, LV_COLOR_FORMAT_A8, stride,
+                         slot->mem, slot->capacity) != LV_RESULT_OK) {
+        return base_glyph_bitmap(af, g, draw_buf);
+    }
+    
+    const void *bitmap = base_glyph_bitmap(af, g, &slot->buf);
+    if (bitmap == &slot->buf) {
+        slot->font = &af->font;
+        slot->index = index;
+        s_assets.stats.glyph_misses++;
+    }
+    // Anything else came from the base font's own storage: pass it through
+    return bitmap;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+esp_err_t display_assets_init(void)
+{
+    if (s_assets.initialized) {
+        return ESP_OK;
+    }
+    
+    s_assets.cache = psram_alloc(GLYPH_CACHE_SETS * sizeof(glyph_set_t));
+    if (s_assets.cache == NULL) {
+        ESP_LOGE(TAG, "No memory for the glyph cache");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    map_pack();
+    s_assets.initialized = true;
+    
+    ESP_LOGI(TAG, "✓ UI assets: %lu images, %d-entry glyph cache",
+             (unsigned long)s_assets.stats.images, GLYPH_CACHE_SETS * GLYPH_CACHE_WAYS);
+    return ESP_OK;
+}
+
+void display_assets_deinit(void)
+{
+    if (!s_assets.initialized) {
+        return;
+    }
+    
+    // Wrappers go back to rasterising through the base font
+    for (uint8_t i = 0; i < s_font_count; i++) {
+        heap_caps_free(s_fonts[i].glyph_bufs);
+        s_fonts[i].glyph_bufs = NULL;
+        s_fonts[i].glyphs = NULL;
+        s_fonts[i].glyph_count = 0;
+    }
+    
+    if (s_assets.cache) {
+        for (int set = 0; set < GLYPH_CACHE_SETS; set++) {
+            for (int way = 0; way < GLYPH_CACHE_WAYS; way++) {
+                heap_caps_free(s_assets.cache[set].way[way].mem);
+            }
+        }
+        heap_caps_free(s_assets.cache);
+    }
+    
+    free(s_assets.images);
+    if (s_assets.pack) {
+        esp_partition_munmap(s_assets.mmap_handle);
+    }
+    
+    memset(&s_assets, 0, sizeof(s_assets));
+}
+
+const lv_image_dsc_t *display_assets_get_image(const char *name)
+{
+    const pack_entry_t *entry = find_entry(name, ASSET_TYPE_IMAGE);
+    if (entry == NULL) {
+        return NULL;
+    }
+    
+    const lv_image_dsc_t *img = &s_assets.images[entry - s_assets.entries];
+    return img->data != NULL ? img : NULL;
+}
+
+const lv_font_t *display_assets_font(const lv_font_t *base, const char *atlas)
+{
+    if (base == NULL) {
+        return NULL;
+    }
+    
+    for (uint8_t i = 0; i < s_font_count; i++) {
+        if (s_fonts[i].base == base) {
+            return &s_fonts[i].font;
+        }
+    }
+    
+    if (s_font_count >= MAX_ASSET_FONTS) {
+        ESP_LOGW(TAG, "Out of font wrappers, drawing uncached");
+        return base;
+    }
+    
+    asset_font_t *af = &s_fonts[s_font_count++];
+    af->font = *base;
+    af->font.get_glyph_dsc = asset_get_glyph_dsc;
+    af->font.get_glyph_bitmap = asset_get_glyph_bitmap;
+    af->font.release_glyph = NULL;
+    af->base = base;
+    
+    if (atlas != NULL) {
+        bind_atlas(af, atlas);
+    }
+    return &af->font;
+}
+
+void display_assets_get_stats(display_asset_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_assets.stats;
+    }
+}
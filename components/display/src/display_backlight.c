@@ -0,0 +1,361 @@
+/**
+ * @file display_backlight.c
+ * @brief PWM backlight with hardware fades and idle auto-dim
+ * 
+ * One esp_timer drives the idle state machine:
+ * 
+ *   ACTIVE --dim timeout--> DIMMED --off timeout--> FADING_OFF --fade--> OFF
+ * 
+ * and any activity returns to ACTIVE. All level changes are LEDC hardware
+ * fades; nothing runs while the backlight ramps.
+ */
+
+#include "display_backlight.h"
+#include "display_service.h"
+#include "driver/ledc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "display_backlight";
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+#define BL_LEDC_MODE            LEDC_LOW_SPEED_MODE
+#define BL_LEDC_TIMER           LEDC_TIMER_0
+#define BL_LEDC_CHANNEL         LEDC_CHANNEL_0
+#define BL_LEDC_RESOLUTION      LEDC_TIMER_10_BIT
+#define BL_LEDC_FREQ_HZ         20000   // Above audible range
+#define BL_DUTY_MAX             ((1 << 10) - 1)
+
+#define BL_FADE_MS              CONFIG_DISPLAY_SERVICE_BACKLIGHT_FADE_MS
+#define BL_DIM_PERCENT          CONFIG_DISPLAY_SERVICE_BACKLIGHT_DIM_PERCENT
+
+/* ============================================================================
+ * State
+ * ============================================================================ */
+
+typedef enum {
+    BL_ACTIVE = 0,
+    BL_DIMMED,
+    BL_FADING_OFF,
+    BL_OFF,
+} bl_state_t;
+
+typedef struct {
+    bool initialized;
+    uint8_t brightness;             // User level, percent
+    bl_state_t state;
+    uint32_t dim_ms;                // Normal timeouts, 0 disables
+    uint32_t off_ms;
+    bool power_save;
+    esp_timer_handle_t idle_timer;
+    SemaphoreHandle_t lock;
+} backlight_t;
+
+static backlight_t s_bl = {0};
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+/* Perceived brightness is roughly quadratic in duty */
+static uint32_t percent_to_duty(uint8_t percent)
+{
+    return (uint32_t)BL_DUTY_MAX * percent * percent / 10000;
+}
+
+/* Move to percent, fading over fade_ms (0 = at once) */
+static void apply_level(uint8_t percent, uint32_t fade_ms)
+{
+    uint32_t duty = percent_to_duty(percent);
+    
+    // A fade still running would make the next one wait for it
+    ledc_fade_stop(BL_LEDC_MODE, BL_LEDC_CHANNEL);
+    
+    if (fade_ms == 0) {
+        ledc_set_duty(BL_LEDC_MODE, BL_LEDC_CHANNEL, duty);
+        ledc_update_duty(BL_LEDC_MODE, BL_LEDC_CHANNEL);
+    } else {
+        ledc_set_fade_time_and_start(BL_LEDC_MODE, BL_LEDC_CHANNEL, duty, fade_ms,
+                                     LEDC_FADE_NO_WAIT);
+    }
+}
+
+static void effective_timeouts(uint32_t *dim_ms, uint32_t *off_ms)
+{
+    if (s_bl.power_save) {
+        *dim_ms = CONFIG_DISPLAY_SERVICE_BACKLIGHT_SAVE_DIM_MS;
+        *off_ms = CONFIG_DISPLAY_SERVICE_BACKLIGHT_SAVE_OFF_MS;
+    } else {
+        *dim_ms = s_bl.dim_ms;
+        *off_ms = s_bl.off_ms;
+    }
+}
+
+static void arm_timer(uint32_t ms)
+{
+    esp_timer_stop(s_bl.idle_timer);
+    if (ms > 0) {
+        esp_timer_start_once(s_bl.idle_timer, (uint64_t)ms * 1000);
+    }
+}
+
+/* Back to full brightness and restart the idle countdown (lock held) */
+static void enter_active_locked(uint32_t fade_ms)
+{
+    uint32_t dim_ms, off_ms;
+    effective_timeouts(&dim_ms, &off_ms);
+    
+    s_bl.state = BL_ACTIVE;
+    apply_level(s_bl.brightness, fade_ms);
+    arm_timer(dim_ms > 0 ? dim_ms : off_ms);
+}
+
+static void idle_timer_cb(void *arg)
+{
+    (void)arg;
+    bool turn_off = false;
+    uint32_t dim_ms, off_ms;
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    effective_timeouts(&dim_ms, &off_ms);
+    
+    switch (s_bl.state) {
+        case BL_ACTIVE:
+            if (dim_ms > 0) {
+                s_bl.state = BL_DIMMED;
+                uint8_t dim = (s_bl.brightness < BL_DIM_PERCENT) ? s_bl.brightness : BL_DIM_PERCENT;
+                apply_level(dim, BL_FADE_MS);
+                if (off_ms > dim_ms) {
+                    arm_timer(off_ms - dim_ms);
+                }
+                break;
+            }
+            // No dim step: straight to fading out
+            // fall through
+        case BL_DIMMED:
+            if (off_ms > 0) {
+                s_bl.state = BL_FADING_OFF;
+                apply_level(0, BL_FADE_MS);
+                arm_timer(BL_FADE_MS);
+            }
+            break;
+    
+        case BL_FADING_OFF:
+            turn_off = true;
+            break;
+    
+        default:
+            break;
+    }
+    
+    xSemaphoreGive(s_bl.lock);
+    
+    // Stops LVGL too; display_backlight_screen_off() takes the lock
+    if (turn_off) {
+        ESP_LOGI(TAG, "Idle: screen off");
+        display_screen_off();
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t display_backlight_init(int pin, uint8_t brightness)
+{
+    if (s_bl.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (pin < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_bl.brightness = (brightness > 100) ? 100 : brightness;
+    s_bl.dim_ms = CONFIG_DISPLAY_SERVICE_BACKLIGHT_DIM_MS;
+    s_bl.off_ms = CONFIG_DISPLAY_SERVICE_BACKLIGHT_OFF_MS;
+    s_bl.power_save = false;
+    
+    const ledc_timer_config_t timer_cfg = {
+        .speed_mode = BL_LEDC_MODE,
+        .duty_resolution = BL_LEDC_RESOLUTION,
+        .timer_num = BL_LEDC_TIMER,
+        .freq_hz = BL_LEDC_FREQ_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    esp_err_t ret = ledc_timer_config(&timer_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure LEDC timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    const ledc_channel_config_t channel_cfg = {
+        .gpio_num = pin,
+        .speed_mode = BL_LEDC_MODE,
+        .channel = BL_LEDC_CHANNEL,
+        .timer_sel = BL_LEDC_TIMER,
+        .duty = 0,
+        .hpoint = 0,
+    };
+    ret = ledc_channel_config(&channel_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure LEDC channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install LEDC fade: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    s_bl.lock = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t timer_args = {
+        .callback = idle_timer_cb,
+        .name = "backlight_idle",
+    };
+    if (s_bl.lock == NULL || esp_timer_create(&timer_args, &s_bl.idle_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create backlight timer");
+        if (s_bl.lock != NULL) {
+            vSemaphoreDelete(s_bl.lock);
+            s_bl.lock = NULL;
+        }
+        ledc_fade_func_uninstall();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    s_bl.initialized = true;
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    enter_active_locked(BL_FADE_MS);
+    xSemaphoreGive(s_bl.lock);
+    
+    ESP_LOGI(TAG, "✓ PWM backlight on pin %d (%d%%, dim after %lu ms, off after %lu ms)",
+             pin, s_bl.brightness, s_bl.dim_ms, s_bl.off_ms);
+    return ESP_OK;
+}
+
+void display_backlight_deinit(void)
+{
+    if (!s_bl.initialized) {
+        return;
+    }
+    
+    s_bl.initialized = false;
+    esp_timer_stop(s_bl.idle_timer);
+    esp_timer_delete(s_bl.idle_timer);
+    s_bl.idle_timer = NULL;
+    
+    apply_level(0, 0);
+    ledc_fade_func_uninstall();
+    
+    vSemaphoreDelete(s_bl.lock);
+    s_bl.lock = NULL;
+}
+
+esp_err_t display_backlight_set_brightness(uint8_t brightness)
+{
+    if (!s_bl.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    s_bl.brightness = (brightness > 100) ? 100 : brightness;
+    if (s_bl.state != BL_OFF) {
+        enter_active_locked(BL_FADE_MS);
+    }
+    xSemaphoreGive(s_bl.lock);
+    
+    return ESP_OK;
+}
+
+void display_backlight_notify_activity(void)
+{
+    if (!s_bl.initialized) {
+        return;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    bl_state_t prev = s_bl.state;
+    if (prev == BL_ACTIVE || prev == BL_DIMMED || prev == BL_FADING_OFF) {
+        uint32_t dim_ms, off_ms;
+        effective_timeouts(&dim_ms, &off_ms);
+    
+        if (prev == BL_ACTIVE) {
+            arm_timer(dim_ms > 0 ? dim_ms : off_ms);
+        } else {
+            enter_active_locked(BL_FADE_MS);
+        }
+    }
+    xSemaphoreGive(s_bl.lock);
+    
+    // The screen was turned off: display_screen_on() restores the backlight
+    if (prev == BL_OFF) {
+        display_screen_on();
+    }
+}
+
+esp_err_t display_backlight_set_idle_timeouts(uint32_t dim_ms, uint32_t off_ms)
+{
+    if (!s_bl.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    s_bl.dim_ms = dim_ms;
+    s_bl.off_ms = off_ms;
+    if (s_bl.state != BL_OFF) {
+        enter_active_locked(BL_FADE_MS);
+    }
+    xSemaphoreGive(s_bl.lock);
+    
+    return ESP_OK;
+}
+
+void display_backlight_set_power_save(bool enable)
+{
+    if (!s_bl.initialized) {
+        return;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    if (s_bl.power_save != enable) {
+        s_bl.power_save = enable;
+        ESP_LOGI(TAG, "Power-save timeouts %s", enable ? "on" : "off");
+        if (s_bl.state == BL_ACTIVE) {
+            // Restart the countdown with the new timeouts, level unchanged
+            uint32_t dim_ms, off_ms;
+            effective_timeouts(&dim_ms, &off_ms);
+            arm_timer(dim_ms > 0 ? dim_ms : off_ms);
+        }
+    }
+    xSemaphoreGive(s_bl.lock);
+}
+
+void display_backlight_screen_on(void)
+{
+    if (!s_bl.initialized) {
+        return;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    enter_active_locked(BL_FADE_MS);
+    xSemaphoreGive(s_bl.lock);
+}
+
+void display_backlight_screen_off(void)
+{
+    if (!s_bl.initialized) {
+        return;
+    }
+    
+    xSemaphoreTake(s_bl.lock, portMAX_DELAY);
+    s_bl.state = BL_OFF;
+    esp_timer_stop(s_bl.idle_timer);
+    apply_level(0, 0);
+    xSemaphoreGive(s_bl.lock);
+}
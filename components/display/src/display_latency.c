@@ -0,0 +1,493 @@
+/**
+ * @file display_latency.c
+ * @brief Touch-to-photon latency tracer implementation
+ *
+ * One trace runs at a time: stamps are absolute times kept until the
+ * trace completes, then stored as offsets from the touch in a ring of the
+ * last CONFIG_DISPLAY_SERVICE_LATENCY_SAMPLES traces. Stages are stamped
+ * from the LVGL task, except the bus stage, which arrives on a dispatch
+ * worker; a spinlock covers both. Percentiles are computed on request.
+ *
+ * The script drives a virtual pointer in event mode, so it costs nothing
+ * between runs: an LVGL timer steps through press, hold, release, wait for
+ * the screen, back and settle, and reads the pointer right after each
+ * change.
+ */
+
+#include "display_latency.h"
+#include "display_ui_queue.h"
+#include "system_service/event_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "display_latency";
+
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+
+/* ============================================================================
+ * Trace State
+ * ============================================================================ */
+
+#define LATENCY_SAMPLES         CONFIG_DISPLAY_SERVICE_LATENCY_SAMPLES
+#define TRACE_TIMEOUT_US        1000000     // Taps that open nothing expire
+#define SCRIPT_STEP_MS          5
+#define SCRIPT_HOLD_US          60000       // Between injected press and release
+#define SCRIPT_SETTLE_US        300000      // After going back, before the next tap
+
+typedef enum {
+    SCRIPT_IDLE = 0,
+    SCRIPT_HOLD,                    // Pressed, waiting to release
+    SCRIPT_WAIT,                    // Released, waiting for the trace to finish
+    SCRIPT_SETTLE,                  // Back posted, letting the menu redraw
+} script_phase_t;
+
+typedef struct {
+    portMUX_TYPE lock;
+    uint32_t next_tag;
+    uint32_t tag;                   // Running trace, 0 if none
+    int64_t stamp_us[DISPLAY_LATENCY_STAGE_COUNT];     // 0 until stamped
+    
+    uint32_t samples[LATENCY_SAMPLES][DISPLAY_LATENCY_STAGE_COUNT];    // From TOUCH
+    uint32_t sample_head;
+    uint32_t sample_count;
+    uint32_t completed;             // Since boot, for the script
+    uint32_t incomplete;
+    
+    // Script, LVGL task only
+    system_service_id_t service_id;
+    system_event_type_t back_event;
+    system_event_type_t report_event;
+    lv_indev_t *indev;
+    lv_obj_t *menu;
+    lv_timer_t *timer;
+    script_phase_t phase;
+    int64_t phase_us;
+    uint16_t taps_left;
+    uint32_t completed_before;
+    lv_point_t point;
+    bool pressed;
+    bool reported_pressed;
+    volatile bool running;
+} latency_trace_t;
+
+static latency_trace_t s_trace = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static const char *const stage_names[DISPLAY_LATENCY_STAGE_COUNT] = {
+    "touch", "press", "release", "click", "bus", "nav", "flush",
+};
+
+/* ============================================================================
+ * Tracing
+ * ============================================================================ */
+
+/* Drop a trace that has run too long; lock held */
+static void trace_expire(int64_t now_us)
+{
+    if (s_trace.tag != 0 && now_us - s_trace.stamp_us[DISPLAY_LATENCY_STAGE_TOUCH] > TRACE_TIMEOUT_US) {
+        s_trace.tag = 0;
+        s_trace.incomplete++;
+    }
+}
+
+/* Stamp a stage of the trace tagged tag; lock held */
+static void trace_stamp(uint32_t tag, display_latency_stage_t stage, int64_t now_us)
+{
+    trace_expire(now_us);
+    if (s_trace.tag != 0 && s_trace.tag == tag && s_trace.stamp_us[stage] == 0) {
+        s_trace.stamp_us[stage] = now_us;
+    }
+}
+
+/* Move the finished trace into the sample ring; lock held */
+static void trace_complete(void)
+{
+    uint32_t *sample = s_trace.samples[s_trace.sample_head];
+    int64_t origin = s_trace.stamp_us[DISPLAY_LATENCY_STAGE_TOUCH];
+    
+    for (int i = 0; i < DISPLAY_LATENCY_STAGE_COUNT; i++) {
+        int64_t at = s_trace.stamp_us[i];
+        sample[i] = (at >= origin) ? (uint32_t)(at - origin) : UINT32_MAX;
+    }
+    s_trace.sample_head = (s_trace.sample_head + 1) % LATENCY_SAMPLES;
+    if (s_trace.sample_count < LATENCY_SAMPLES) {
+        s_trace.sample_count++;
+    }
+    s_trace.completed++;
+    s_trace.tag = 0;
+}
+
+void display_latency_touch(int64_t at_us)
+{
+    portENTER_CRITICAL(&s_trace.lock);
+    trace_expire(at_us);
+    if (s_trace.tag == 0) {
+        if (++s_trace.next_tag == 0) {
+            s_trace.next_tag = 1;
+        }
+        s_trace.tag = s_trace.next_tag;
+        memset(s_trace.stamp_us, 0, sizeof(s_trace.stamp_us));
+        s_trace.stamp_us[DISPLAY_LATENCY_STAGE_TOUCH] = at_us;
+    }
+    portEXIT_CRITICAL(&s_trace.lock);
+}
+
+void display_latency_stamp(display_latency_stage_t stage)
+{
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_trace.lock);
+    trace_stamp(s_trace.tag, stage, now_us);
+    portEXIT_CRITICAL(&s_trace.lock);
+}
+
+uint32_t display_latency_tag(void)
+{
+    return s_trace.tag;
+}
+
+void display_latency_frame_done(bool rendered, int64_t now_us)
+{
+    portENTER_CRITICAL(&s_trace.lock);
+    trace_expire(now_us);
+    if (rendered && s_trace.tag != 0 && s_trace.stamp_us[DISPLAY_LATENCY_STAGE_NAV] != 0) {
+        s_trace.stamp_us[DISPLAY_LATENCY_STAGE_FLUSH] = now_us;
+        trace_complete();
+    }
+    portEXIT_CRITICAL(&s_trace.lock);
+}
+
+/* The menu event came off the bus, carrying the tag of the tap that sent it */
+static void menu_event_handler(const system_event_t *event, void *user_data)
+{
+    (void)user_data;
+    if (event->data == NULL || event->data_size < sizeof(uint32_t)) {
+        return;
+    }
+    
+    uint32_t tag;
+    memcpy(&tag, event->data, sizeof(tag));
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_trace.lock);
+    trace_stamp(tag, DISPLAY_LATENCY_STAGE_BUS, now_us);
+    portEXIT_CRITICAL(&s_trace.lock);
+}
+
+/* ============================================================================
+ * Report
+ * ============================================================================ */
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentiles; sorts values */
+static void percentiles(uint32_t *values, uint32_t count, display_latency_percentiles_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (count == 0) {
+        return;
+    }
+    
+    qsort(values, count, sizeof(values[0]), compare_u32);
+    out->p50_us = values[(count * 50 + 99) / 100 - 1];
+    out->p90_us = values[(count * 90 + 99) / 100 - 1];
+    out->p99_us = values[(count * 99 + 99) / 100 - 1];
+    out->max_us = values[count - 1];
+}
+
+esp_err_t display_latency_get_report(display_latency_report_t *report)
+{
+    if (report == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Copied out first: sorting under the spinlock would stall the LVGL task
+    static uint32_t samples[LATENCY_SAMPLES][DISPLAY_LATENCY_STAGE_COUNT];
+    uint32_t values[LATENCY_SAMPLES];
+    uint32_t count;
+    
+    portENTER_CRITICAL(&s_trace.lock);
+    count = s_trace.sample_count;
+    memcpy(samples, s_trace.samples, sizeof(samples));
+    report->incomplete = s_trace.incomplete;
+    portEXIT_CRITICAL(&s_trace.lock);
+    
+    report->samples = count;
+    memset(&report->stage[DISPLAY_LATENCY_STAGE_TOUCH], 0, sizeof(report->stage[0]));
+    
+    for (int stage = 1; stage < DISPLAY_LATENCY_STAGE_COUNT; stage++) {
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            // From the latest earlier stage that was stamped
+            uint32_t at = samples[i][stage];
+            if (at == UINT32_MAX) {
+                continue;
+            }
+            uint32_t from = 0;
+            for (int prev = stage - 1; prev >= 0; prev--) {
+                if (samples[i][prev] != UINT32_MAX) {
+                    from = samples[i][prev];
+                    break;
+                }
+            }
+            values[n++] = (at > from) ? at - from : 0;
+        }
+        percentiles(values, n, &report->stage[stage]);
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        values[i] = samples[i][DISPLAY_LATENCY_STAGE_FLUSH];
+    }
+    percentiles(values, count, &report->end_to_end);
+    
+    return ESP_OK;
+}
+
+void display_latency_reset(void)
+{
+    portENTER_CRITICAL(&s_trace.lock);
+    s_trace.tag = 0;
+    s_trace.sample_head = 0;
+    s_trace.sample_count = 0;
+    s_trace.incomplete = 0;
+    portEXIT_CRITICAL(&s_trace.lock);
+}
+
+static void report_publish(void)
+{
+    display_latency_report_t report;
+    if (display_latency_get_report(&report) != ESP_OK || report.samples == 0) {
+        ESP_LOGW(TAG, "No complete traces (%lu incomplete)", (unsigned long)s_trace.incomplete);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Touch to photon over %lu taps (%lu incomplete): p50 %lu us, p90 %lu us, "
+             "p99 %lu us, max %lu us", (unsigned long)report.samples, (unsigned long)report.incomplete,
+             (unsigned long)report.end_to_end.p50_us, (unsigned long)report.end_to_end.p90_us,
+             (unsigned long)report.end_to_end.p99_us, (unsigned long)report.end_to_end.max_us);
+    for (int stage = 1; stage < DISPLAY_LATENCY_STAGE_COUNT; stage++) {
+        const display_latency_percentiles_t *p = &report.stage[stage];
+        ESP_LOGI(TAG, "  %-8s p50 %6lu  p90 %6lu  p99 %6lu  max %6lu us", stage_names[stage],
+                 (unsigned long)p->p50_us, (unsigned long)p->p90_us,
+                 (unsigned long)p->p99_us, (unsigned long)p->max_us);
+    }
+    
+    system_event_post(s_trace.service_id, s_trace.report_event, &report, sizeof(report),
+                      SYSTEM_EVENT_PRIORITY_LOW);
+}
+
+/* ============================================================================
+ * Scripted Taps
+ * ============================================================================ */
+
+static void inject_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+    (void)indev;
+    data->point = s_trace.point;
+    data->state = s_trace.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    
+    if (s_trace.pressed != s_trace.reported_pressed) {
+        s_trace.reported_pressed = s_trace.pressed;
+        display_latency_stamp(s_trace.pressed ? DISPLAY_LATENCY_STAGE_PRESS : DISPLAY_LATENCY_STAGE_RELEASE);
+    }
+}
+
+/* Centre of the menu item the script taps */
+static bool script_target(lv_point_t *point)
+{
+    if (s_trace.menu == NULL || !lv_obj_is_valid(s_trace.menu)) {
+        return false;
+    }
+    lv_obj_t *item = lv_obj_get_child(s_trace.menu, CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_ITEM);
+    if (item == NULL) {
+        return false;
+    }
+    
+    lv_area_t area;
+    lv_obj_get_coords(item, &area);
+    point->x = (area.x1 + area.x2) / 2;
+    point->y = (area.y1 + area.y2) / 2;
+    return true;
+}
+
+static void script_finish(void)
+{
+    lv_timer_pause(s_trace.timer);
+    s_trace.phase = SCRIPT_IDLE;
+    s_trace.running = false;
+    report_publish();
+}
+
+static void script_press(int64_t now_us)
+{
+    if (!script_target(&s_trace.point)) {
+        ESP_LOGE(TAG, "Menu item %d not found", CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_ITEM);
+        script_finish();
+        return;
+    }
+    
+    s_trace.completed_before = s_trace.completed;
+    display_latency_touch(now_us);
+    s_trace.pressed = true;
+    lv_indev_read(s_trace.indev);
+    s_trace.phase = SCRIPT_HOLD;
+    s_trace.phase_us = now_us;
+}
+
+/* LVGL timer, port lock held */
+static void script_step_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us = now_us - s_trace.phase_us;
+    
+    switch (s_trace.phase) {
+    case SCRIPT_HOLD:
+        if (elapsed_us >= SCRIPT_HOLD_US) {
+            s_trace.pressed = false;
+            lv_indev_read(s_trace.indev);
+            s_trace.phase = SCRIPT_WAIT;
+            s_trace.phase_us = now_us;
+        }
+        break;
+    
+    case SCRIPT_WAIT:
+        if (s_trace.completed != s_trace.completed_before) {
+            // The screen is up: go back the way the back button does
+            system_event_post(s_trace.service_id, s_trace.back_event, NULL, 0,
+                              SYSTEM_EVENT_PRIORITY_NORMAL);
+        } else if (elapsed_us < TRACE_TIMEOUT_US) {
+            break;
+        }
+        s_trace.phase = SCRIPT_SETTLE;
+        s_trace.phase_us = now_us;
+        break;
+    
+    case SCRIPT_SETTLE:
+        if (elapsed_us < SCRIPT_SETTLE_US) {
+            break;
+        }
+        if (--s_trace.taps_left == 0) {
+            script_finish();
+        } else {
+            script_press(now_us);
+        }
+        break;
+    
+    case SCRIPT_IDLE:
+        break;
+    }
+}
+
+/* Runs in the LVGL task via the UI queue */
+static void script_start(void *arg)
+{
+    s_trace.taps_left = (uint16_t)(uintptr_t)arg;
+    display_latency_reset();
+    lv_timer_resume(s_trace.timer);
+    ESP_LOGI(TAG, "Scripted run: %u taps on menu item %d", s_trace.taps_left,
+             CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_ITEM);
+    script_press(esp_timer_get_time());
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t display_latency_init(system_service_id_t service_id, lv_display_t *disp,
+                               const system_event_type_t *events, size_t event_count,
+                               system_event_type_t back_event)
+{
+    s_trace.service_id = service_id;
+    s_trace.back_event = back_event;
+    
+    esp_err_t ret = system_event_register_topic("display.latency_report", SYSTEM_EVENT_TOPIC_LATEST,
+                                                &s_trace.report_event);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    for (size_t i = 0; i < event_count; i++) {
+        if (events[i] != SYSTEM_EVENT_TYPE_INVALID) {
+            system_event_subscribe(service_id, events[i], menu_event_handler, NULL);
+        }
+    }
+    
+    // Event mode: read only when the script calls lv_indev_read()
+    s_trace.indev = lv_indev_create();
+    if (s_trace.indev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    lv_indev_set_type(s_trace.indev, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(s_trace.indev, inject_read_cb);
+    lv_indev_set_display(s_trace.indev, disp);
+    lv_indev_set_mode(s_trace.indev, LV_INDEV_MODE_EVENT);
+    
+    s_trace.timer = lv_timer_create(script_step_cb, SCRIPT_STEP_MS, NULL);
+    if (s_trace.timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    lv_timer_pause(s_trace.timer);
+    
+    ESP_LOGI(TAG, "✓ Latency tracing on, %d samples", LATENCY_SAMPLES);
+    return ESP_OK;
+}
+
+void display_latency_set_menu(lv_obj_t *menu)
+{
+    s_trace.menu = menu;
+}
+
+esp_err_t display_latency_run_script(uint16_t taps)
+{
+    if (taps == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_trace.timer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    bool running;
+    portENTER_CRITICAL(&s_trace.lock);
+    running = s_trace.running;
+    s_trace.running = true;
+    portEXIT_CRITICAL(&s_trace.lock);
+    if (running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    esp_err_t ret = display_ui_call(script_start, (void *)(uintptr_t)taps);
+    if (ret != ESP_OK) {
+        s_trace.running = false;
+    }
+    return ret;
+}
+
+#else // !CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+
+esp_err_t display_latency_run_script(uint16_t taps)
+{
+    (void)taps;
+    ESP_LOGW(TAG, "Latency tracing is disabled");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t display_latency_get_report(display_latency_report_t *report)
+{
+    (void)report;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void display_latency_reset(void)
+{
+}
+
+#endif // CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
@@ -1,6 +1,9 @@
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
 #include "driver/i2c.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
@@ -9,11 +12,20 @@
 #include "esp_lcd_touch.h"
 #include "esp_lcd_touch_ft5x06.h"
 #include "esp_lvgl_port.h"
+#include <string.h>
 
 #include "display_service.h"
+#include "display_ui_queue.h"
+#include "display_backlight.h"
+#include "display_assets.h"
+#include "display_latency.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/boot_trace.h"
+#include "system_service/power_lock.h"
+#include "system_service/common_events.h"
+#include "system_service/system_settings.h"
 #include "ui_topbar.h"
 #include "ui_mainmenu.h"
 #include "ui_button.h"
@@ -22,11 +34,16 @@
 static const char *TAG = "display_service";
 
 static system_service_id_t display_service_id = 0;
-static system_event_type_t display_events[8];
+static system_event_type_t display_events[DISPLAY_EVENT_COUNT];
 static bool initialized = false;
 static uint8_t current_brightness = 80;
 static bool screen_on_state = true;
+// Held while the screen is on: LEDC and the LVGL tick stop in light sleep
+static system_power_lock_t screen_power_lock = NULL;
 static display_orientation_t current_orientation = DISPLAY_ORIENTATION_0;
+// Persisted copies of brightness and orientation, see system_settings.h
+static system_setting_id_t brightness_setting = SYSTEM_SETTING_ID_INVALID;
+static system_setting_id_t orientation_setting = SYSTEM_SETTING_ID_INVALID;
 
 // Menu event types
 static system_event_type_t menu_audio_event = SYSTEM_EVENT_TYPE_INVALID;
@@ -44,12 +61,195 @@ static lv_display_t *lvgl_disp = NULL;
 static esp_lcd_panel_io_handle_t touch_io_handle = NULL;
 static esp_lcd_touch_handle_t touch_handle = NULL;
 
+// Draw buffer placement, see Kconfig
+#if CONFIG_DISPLAY_SERVICE_RENDER_DMA_SRAM
+#define DRAW_BUFF_DMA       1
+#define DRAW_BUFF_SPIRAM    0
+#else
+#define DRAW_BUFF_DMA       0
+#define DRAW_BUFF_SPIRAM    1
+#endif
+
+// Frame instrumentation. Per-frame fields are only touched by the LVGL
+// task; window totals are also fed by display_lock() callers and are
+// guarded by s_perf_lock.
+typedef struct {
+    int64_t refr_start_us;
+    int64_t flush_start_us;
+    int64_t wait_start_us;
+    uint32_t frame_flush_us;
+    uint32_t pending_area_px;
+    bool rendered;                  // This refresh drew something
+    bool te_synced;                 // First flush of this refresh waited for TE
+    bool frame_te_missed;
+    uint32_t frame_te_us;
+    
+    int64_t window_start_us;
+    uint32_t frames;
+    uint64_t render_total_us;
+    uint32_t render_max_us;
+    uint64_t flush_total_us;
+    uint32_t flush_max_us;
+    uint64_t area_total_px;
+    uint32_t lock_waits;
+    uint64_t lock_wait_total_us;
+    uint32_t lock_wait_max_us;
+    uint64_t te_wait_total_us;
+    uint32_t te_wait_max_us;
+    uint32_t te_missed_frames;
+    uint32_t touch_responses;
+    uint64_t touch_latency_total_us;
+    uint32_t touch_latency_max_us;
+    
+    display_frame_stats_t last;     // Last completed window
+    int64_t last_log_us;
+    lv_obj_t *overlay;
+} frame_perf_t;
+static frame_perf_t s_perf = {0};
+static portMUX_TYPE s_perf_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Tearing-effect sync: the panel pulses TE at the start of vertical
+// blanking, and the first flush of every frame waits for the next pulse
+#define TE_WAIT_TIMEOUT_MS  25      // Longer than one panel refresh at 40 Hz
+static SemaphoreHandle_t s_te_sem = NULL;
+
+// Interrupt-driven touch. The FT6336 holds INT low while touched: the
+// falling edge wakes the LVGL task for one read, and the read timer only
+// polls until the finger lifts. Latency runs from the edge (or the read,
+// while dragging) to the end of the frame that answered it.
+#define TOUCH_LATENCY_MAX_US  500000    // Touches that redrew nothing expire
+typedef struct {
+    lv_indev_t *indev;
+    lv_indev_read_cb_t port_read_cb;
+    lv_timer_t *read_timer;
+    bool polling;
+    volatile int64_t irq_us;        // Last INT edge, written by the ISR
+    int64_t input_us;               // Input not yet answered by a frame, 0 if none
+} touch_irq_t;
+static touch_irq_t s_touch = {0};
+
+// Takes the LVGL port lock, accounting the time spent waiting for it
+static bool display_lock(uint32_t timeout_ms)
+{
+    int64_t start = esp_timer_get_time();
+    bool locked = lvgl_port_lock(timeout_ms);
+    uint32_t waited = (uint32_t)(esp_timer_get_time() - start);
+    
+    portENTER_CRITICAL(&s_perf_lock);
+    s_perf.lock_waits++;
+    s_perf.lock_wait_total_us += waited;
+    if (waited > s_perf.lock_wait_max_us) {
+        s_perf.lock_wait_max_us = waited;
+    }
+    portEXIT_CRITICAL(&s_perf_lock);
+    
+    return locked;
+}
+
 // Navigation stack for screen management
 #define NAV_STACK_MAX 5
 static lv_obj_t *main_screen = NULL;
 static lv_obj_t *nav_stack[NAV_STACK_MAX] = {NULL};
+static const char *nav_keys[NAV_STACK_MAX] = {NULL};   // Cache key, NULL if not cacheable
 static int nav_stack_top = -1;
 
+// Screen cache: popped screens that have a key are hidden instead of
+// deleted, and the least recently used one goes first when the cache is
+// full or the LVGL heap runs low (widgets live there, not in PSRAM)
+#define SCREEN_CACHE_SLOTS CONFIG_DISPLAY_SERVICE_SCREEN_CACHE_SIZE
+typedef struct {
+    const char *key;
+    lv_obj_t *content;
+    uint32_t last_used;
+} screen_cache_entry_t;
+static screen_cache_entry_t s_screen_cache[SCREEN_CACHE_SLOTS > 0 ? SCREEN_CACHE_SLOTS : 1];
+static uint32_t s_screen_cache_clock = 0;
+
+static void screen_cache_evict(int slot)
+{
+    screen_cache_entry_t *entry = &s_screen_cache[slot];
+    ESP_LOGD(TAG, "Evicting cached screen '%s'", entry->key);
+    if (lv_obj_is_valid(entry->content)) {
+        lv_obj_del(entry->content);
+    }
+    entry->key = NULL;
+    entry->content = NULL;
+}
+
+static int screen_cache_lru(void)
+{
+    int lru = -1;
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        if (s_screen_cache[i].content != NULL &&
+            (lru < 0 || s_screen_cache[i].last_used < s_screen_cache[lru].last_used)) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+// Evict until the LVGL heap has the configured headroom again
+static void screen_cache_trim(void)
+{
+    lv_mem_monitor_t mon;
+    int lru;
+    
+    while ((lru = screen_cache_lru()) >= 0) {
+        lv_mem_monitor(&mon);
+        if (mon.free_size >= CONFIG_DISPLAY_SERVICE_SCREEN_CACHE_MIN_FREE_KB * 1024) {
+            break;
+        }
+        screen_cache_evict(lru);
+    }
+}
+
+// Hide content and keep it under key, or delete it if there is no cache
+static void screen_cache_put(const char *key, lv_obj_t *content)
+{
+    int slot = -1;
+    
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        if (s_screen_cache[i].content != NULL && strcmp(s_screen_cache[i].key, key) == 0) {
+            screen_cache_evict(i);  // Superseded by the newer instance
+        }
+        if (s_screen_cache[i].content == NULL && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        slot = screen_cache_lru();
+        if (slot >= 0) {
+            screen_cache_evict(slot);
+        }
+    }
+    if (slot < 0) {
+        lv_obj_del(content);
+        return;
+    }
+    
+    lv_obj_add_flag(content, LV_OBJ_FLAG_HIDDEN);
+    s_screen_cache[slot].key = key;
+    s_screen_cache[slot].content = content;
+    s_screen_cache[slot].last_used = ++s_screen_cache_clock;
+    
+    screen_cache_trim();
+}
+
+// Remove and return the cached content for key, or NULL
+static lv_obj_t* screen_cache_take(const char *key)
+{
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        screen_cache_entry_t *entry = &s_screen_cache[i];
+        if (entry->content != NULL && strcmp(entry->key, key) == 0) {
+            lv_obj_t *content = entry->content;
+            entry->key = NULL;
+            entry->content = NULL;
+            return lv_obj_is_valid(content) ? content : NULL;
+        }
+    }
+    return NULL;
+}
+
 // Helper to get current content
 static lv_obj_t* get_current_content(void) {
     if (nav_stack_top >= 0 && nav_stack_top < NAV_STACK_MAX) {
@@ -59,7 +259,7 @@ static lv_obj_t* get_current_content(void) {
 }
 
 // Push new content to navigation stack
-static esp_err_t nav_push(lv_obj_t *content) {
+static esp_err_t nav_push(lv_obj_t *content, const char *cache_key) {
     if (content == NULL) return ESP_ERR_INVALID_ARG;
     if (nav_stack_top >= NAV_STACK_MAX - 1) {
         ESP_LOGE(TAG, "Navigation stack full");
@@ -75,8 +275,15 @@ static esp_err_t nav_push(lv_obj_t *content) {
     // Push new content
     nav_stack_top++;
     nav_stack[nav_stack_top] = content;
+    nav_keys[nav_stack_top] = cache_key;
     lv_obj_clear_flag(content, LV_OBJ_FLAG_HIDDEN);
     
+    screen_cache_trim();
+    
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+    display_latency_stamp(DISPLAY_LATENCY_STAGE_NAV);
+#endif
+    
     ESP_LOGI(TAG, "Pushed screen to nav stack (level %d)", nav_stack_top);
     return ESP_OK;
 }
@@ -88,12 +295,17 @@ static esp_err_t nav_pop(void) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    // Delete current content
+    // Keep cacheable content warm, delete the rest
     lv_obj_t *current = nav_stack[nav_stack_top];
     if (current && lv_obj_is_valid(current)) {
-        lv_obj_del(current);
+        if (nav_keys[nav_stack_top] != NULL) {
+            screen_cache_put(nav_keys[nav_stack_top], current);
+        } else {
+            lv_obj_del(current);
+        }
     }
     nav_stack[nav_stack_top] = NULL;
+    nav_keys[nav_stack_top] = NULL;
     nav_stack_top--;
     
     // Show previous content
@@ -108,6 +320,53 @@ static esp_err_t nav_pop(void) {
     return ESP_OK;
 }
 
+// An app's screen keys are its name, or start with "name/"
+static bool key_owned_by(const char *key, const char *app)
+{
+    size_t len = strlen(app);
+    return key != NULL && strncmp(key, app, len) == 0 && (key[len] == '\0' || key[len] == '/');
+}
+
+// Delete an app's screens, on the stack or cached; returns how many went
+static int release_app_screens(const char *app)
+{
+    int released = 0;
+    int kept = -1;
+    
+    for (int i = 0; i <= nav_stack_top; i++) {
+        if (key_owned_by(nav_keys[i], app)) {
+            if (nav_stack[i] && lv_obj_is_valid(nav_stack[i])) {
+                lv_obj_del(nav_stack[i]);
+            }
+            released++;
+            continue;
+        }
+        kept++;
+        nav_stack[kept] = nav_stack[i];
+        nav_keys[kept] = nav_keys[i];
+    }
+    for (int i = kept + 1; i <= nav_stack_top; i++) {
+        nav_stack[i] = NULL;
+        nav_keys[i] = NULL;
+    }
+    nav_stack_top = kept;
+    
+    // Whatever was under the app's screen is on top now
+    lv_obj_t *current = get_current_content();
+    if (released > 0 && current && lv_obj_is_valid(current)) {
+        lv_obj_clear_flag(current, LV_OBJ_FLAG_HIDDEN);
+    }
+    
+    for (int i = 0; i < SCREEN_CACHE_SLOTS; i++) {
+        if (s_screen_cache[i].content != NULL && key_owned_by(s_screen_cache[i].key, app)) {
+            screen_cache_evict(i);
+            released++;
+        }
+    }
+    
+    return released;
+}
+
 // Display configuration structure
 typedef struct {
     spi_host_device_t host;
@@ -119,6 +378,7 @@ typedef struct {
     int pin_dc;
     int pin_rst;
     int pin_bl;
+    int pin_te;          // Panel tearing-effect output, -1 if not wired
     // Touch I2C pins
     i2c_port_t i2c_port;
     int pin_touch_sda;
@@ -139,6 +399,7 @@ static const board_display_config_t s_display_config = {
     .pin_dc = 46,        // IO46 - LCD Data/Command select
     .pin_rst = -1,       // RST - Shared with ESP32-S3 reset (hardware controlled)
     .pin_bl = 45,        // IO45 - LCD Backlight control
+    .pin_te = CONFIG_DISPLAY_SERVICE_TE_GPIO,
     // Touch I2C configuration
     .i2c_port = I2C_NUM_0,
     .pin_touch_sda = 16, // IO16 - Touch I2C SDA
@@ -150,44 +411,49 @@ static const board_display_config_t s_display_config = {
 };
 
 // Menu item callbacks
+static void menu_post(system_event_type_t event)
+{
+    if (event == SYSTEM_EVENT_TYPE_INVALID) {
+        return;
+    }
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+    // The tag lets the tracer match the delivery to this tap
+    display_latency_stamp(DISPLAY_LATENCY_STAGE_CLICK);
+    uint32_t tag = display_latency_tag();
+    system_event_post(display_service_id, event, &tag, sizeof(tag), SYSTEM_EVENT_PRIORITY_NORMAL);
+#else
+    system_event_post(display_service_id, event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
+#endif
+}
+
 static void menu_audio_clicked(void)
 {
     ESP_LOGI(TAG, "Audio menu clicked");
-    if (menu_audio_event != SYSTEM_EVENT_TYPE_INVALID) {
-        system_event_post(display_service_id, menu_audio_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
-    }
+    menu_post(menu_audio_event);
 }
 
 static void menu_network_clicked(void)
 {
     ESP_LOGI(TAG, "Network menu clicked");
-    if (menu_network_event != SYSTEM_EVENT_TYPE_INVALID) {
-        system_event_post(display_service_id, menu_network_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
-    }
+    menu_post(menu_network_event);
 }
 
 static void menu_bluetooth_clicked(void)
 {
     ESP_LOGI(TAG, "Bluetooth menu clicked");
-    if (menu_bluetooth_event != SYSTEM_EVENT_TYPE_INVALID) {
-        system_event_post(display_service_id, menu_bluetooth_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
-    }
+    menu_post(menu_bluetooth_event);
 }
 
 static void menu_display_clicked(void)
 {
     ESP_LOGI(TAG, "Display menu clicked");
-    if (menu_display_event != SYSTEM_EVENT_TYPE_INVALID) {
-        system_event_post(display_service_id, menu_display_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
-    }
+    menu_post(menu_display_event);
 }
 
 static void menu_apps_clicked(void)
 {
     ESP_LOGI(TAG, "Apps menu clicked");
-    if (menu_apps_event != SYSTEM_EVENT_TYPE_INVALID) {
-        system_event_post(display_service_id, menu_apps_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
-    }
+    menu_post(menu_apps_event);
 }
 
 static esp_err_t init_ui(void)
@@ -195,7 +461,7 @@ static esp_err_t init_ui(void)
     ESP_LOGI(TAG, "Initializing UI...");
     
     // Lock LVGL mutex
-    if (lvgl_port_lock(0)) {
+    if (display_lock(0)) {
         main_screen = lv_scr_act();
         
         // Set screen background to black
@@ -235,7 +501,10 @@ static esp_err_t init_ui(void)
         }
         
         // Push main menu to navigation stack as first screen
-        nav_push(main_menu);
+        nav_push(main_menu, NULL);
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+        display_latency_set_menu(main_menu);
+#endif
         
         ESP_LOGI(TAG, "✓ UI created successfully");
         
@@ -249,6 +518,410 @@ static esp_err_t init_ui(void)
     return ESP_FAIL;
 }
 
+/* Records the first rendered frame as a boot milestone, then unhooks itself */
+static void first_frame_cb(lv_event_t *e)
+{
+    boot_trace_mark("first_frame");
+    lv_display_remove_event_cb_with_user_data(lv_event_get_target(e), first_frame_cb, NULL);
+}
+
+/* Adaptive refresh: once nothing has been drawn for a while the refresh
+ * timer slows down, and the next invalidation, from touch or any widget
+ * change, restores the full rate and refreshes right away. Both run from
+ * display events, so in the LVGL task with the port lock held. */
+#if CONFIG_DISPLAY_SERVICE_ADAPTIVE_REFRESH
+static struct {
+    bool idle;
+    int64_t last_render_us;
+} s_refr = {0};
+
+static void refresh_set_idle(bool idle)
+{
+    lv_timer_t *refr_timer = lv_display_get_refr_timer(lvgl_disp);
+    if (refr_timer == NULL || s_refr.idle == idle) {
+        return;
+    }
+    
+    s_refr.idle = idle;
+    if (idle) {
+        lv_timer_set_period(refr_timer, CONFIG_DISPLAY_SERVICE_IDLE_REFR_PERIOD_MS);
+    } else {
+        lv_timer_set_period(refr_timer, CONFIG_LV_DEF_REFR_PERIOD);
+        lv_timer_ready(refr_timer);
+    }
+    ESP_LOGD(TAG, "Refresh %s", idle ? "backed off" : "at full rate");
+}
+
+static void refresh_policy_update(lv_event_code_t code, bool rendered, int64_t now)
+{
+    if (code == LV_EVENT_INVALIDATE_AREA) {
+        refresh_set_idle(false);
+    } else if (code == LV_EVENT_REFR_READY) {
+        if (rendered) {
+            s_refr.last_render_us = now;
+        } else if (!s_refr.idle &&
+                   now - s_refr.last_render_us >= CONFIG_DISPLAY_SERVICE_IDLE_AFTER_MS * 1000LL) {
+            refresh_set_idle(true);
+        }
+    }
+}
+#endif
+
+/* Frame timing from the display's refresh, flush and invalidate events.
+ * Flush time covers the flush callback plus LVGL waiting for the SPI DMA
+ * to hand the buffer back; render time is the rest of the refresh. The
+ * invalidated area is summed before LVGL merges overlapping areas, so it
+ * is an upper bound. */
+static void frame_event_cb(lv_event_t *e)
+{
+    int64_t now = esp_timer_get_time();
+    lv_event_code_t code = lv_event_get_code(e);
+    
+#if CONFIG_DISPLAY_SERVICE_ADAPTIVE_REFRESH
+    refresh_policy_update(code, s_perf.rendered, now);
+#endif
+    
+    switch (code) {
+        case LV_EVENT_INVALIDATE_AREA: {
+            const lv_area_t *area = lv_event_get_param(e);
+            if (area != NULL) {
+                s_perf.pending_area_px += lv_area_get_size(area);
+            }
+            break;
+        }
+        case LV_EVENT_REFR_START:
+            s_perf.refr_start_us = now;
+            s_perf.frame_flush_us = 0;
+            s_perf.rendered = false;
+            s_perf.te_synced = false;
+            s_perf.frame_te_missed = false;
+            s_perf.frame_te_us = 0;
+            break;
+        case LV_EVENT_RENDER_START:
+            s_perf.rendered = true;
+            break;
+        case LV_EVENT_FLUSH_START:
+            if (s_te_sem != NULL && !s_perf.te_synced) {
+                // Drop a pulse from before this frame, then wait for the next
+                xSemaphoreTake(s_te_sem, 0);
+                s_perf.frame_te_missed = (xSemaphoreTake(s_te_sem, pdMS_TO_TICKS(TE_WAIT_TIMEOUT_MS) + 1) != pdTRUE);
+                s_perf.te_synced = true;
+                int64_t synced = esp_timer_get_time();
+                s_perf.frame_te_us = (uint32_t)(synced - now);
+                now = synced;
+            }
+            s_perf.flush_start_us = now;
+            break;
+        case LV_EVENT_FLUSH_FINISH:
+            s_perf.frame_flush_us += (uint32_t)(now - s_perf.flush_start_us);
+            break;
+        case LV_EVENT_FLUSH_WAIT_START:
+            s_perf.wait_start_us = now;
+            break;
+        case LV_EVENT_FLUSH_WAIT_FINISH:
+            s_perf.frame_flush_us += (uint32_t)(now - s_perf.wait_start_us);
+            break;
+        case LV_EVENT_REFR_READY: {
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+            display_latency_frame_done(s_perf.rendered, now);
+#endif
+            uint32_t touch_us = 0;
+            if (s_touch.input_us != 0) {
+                touch_us = (uint32_t)(now - s_touch.input_us);
+                if (s_perf.rendered || touch_us > TOUCH_LATENCY_MAX_US) {
+                    s_touch.input_us = 0;
+                }
+            }
+            
+            // The refresh timer reports ready on every run; only count runs
+            // that had invalidated areas to draw
+            if (!s_perf.rendered) {
+                break;
+            }
+            uint32_t frame_us = (uint32_t)(now - s_perf.refr_start_us);
+            uint32_t flush_us = s_perf.frame_flush_us;
+            uint32_t waited_us = flush_us + s_perf.frame_te_us;
+            uint32_t render_us = (frame_us > waited_us) ? frame_us - waited_us : 0;
+    
+            portENTER_CRITICAL(&s_perf_lock);
+            s_perf.frames++;
+            s_perf.render_total_us += render_us;
+            s_perf.flush_total_us += flush_us;
+            s_perf.area_total_px += s_perf.pending_area_px;
+            if (render_us > s_perf.render_max_us) {
+                s_perf.render_max_us = render_us;
+            }
+            if (flush_us > s_perf.flush_max_us) {
+                s_perf.flush_max_us = flush_us;
+            }
+            s_perf.te_wait_total_us += s_perf.frame_te_us;
+            if (s_perf.frame_te_us > s_perf.te_wait_max_us) {
+                s_perf.te_wait_max_us = s_perf.frame_te_us;
+            }
+            if (s_perf.frame_te_missed) {
+                s_perf.te_missed_frames++;
+            }
+            if (touch_us != 0 && touch_us <= TOUCH_LATENCY_MAX_US) {
+                s_perf.touch_responses++;
+                s_perf.touch_latency_total_us += touch_us;
+                if (touch_us > s_perf.touch_latency_max_us) {
+                    s_perf.touch_latency_max_us = touch_us;
+                }
+            }
+            portEXIT_CRITICAL(&s_perf_lock);
+    
+            s_perf.pending_area_px = 0;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* Closes the stats window: publishes it, logs it and refreshes the overlay.
+ * An LVGL timer, so it runs in the LVGL task with the port lock held. */
+static void frame_stats_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    int64_t now = esp_timer_get_time();
+    display_frame_stats_t stats = {0};
+    
+    portENTER_CRITICAL(&s_perf_lock);
+    uint32_t window_us = (uint32_t)(now - s_perf.window_start_us);
+    uint32_t frames = s_perf.frames;
+    stats.window_ms = window_us / 1000;
+    stats.frames = frames;
+    stats.fps = (window_us > 0) ? (uint32_t)((frames * 1000000ULL + window_us / 2) / window_us) : 0;
+    if (frames > 0) {
+        stats.render_avg_us = (uint32_t)(s_perf.render_total_us / frames);
+        stats.flush_avg_us = (uint32_t)(s_perf.flush_total_us / frames);
+        stats.area_avg_px = (uint32_t)(s_perf.area_total_px / frames);
+        stats.te_wait_avg_us = (uint32_t)(s_perf.te_wait_total_us / frames);
+    }
+    stats.te_wait_max_us = s_perf.te_wait_max_us;
+    stats.te_missed = s_perf.te_missed_frames;
+    stats.touch_responses = s_perf.touch_responses;
+    if (s_perf.touch_responses > 0) {
+        stats.touch_latency_avg_us = (uint32_t)(s_perf.touch_latency_total_us / s_perf.touch_responses);
+    }
+    stats.touch_latency_max_us = s_perf.touch_latency_max_us;
+    stats.render_max_us = s_perf.render_max_us;
+    stats.flush_max_us = s_perf.flush_max_us;
+    stats.lock_waits = s_perf.lock_waits;
+    if (s_perf.lock_waits > 0) {
+        stats.lock_wait_avg_us = (uint32_t)(s_perf.lock_wait_total_us / s_perf.lock_waits);
+    }
+    stats.lock_wait_max_us = s_perf.lock_wait_max_us;
+    
+    s_perf.last = stats;
+    s_perf.window_start_us = now;
+    s_perf.frames = 0;
+    s_perf.render_total_us = 0;
+    s_perf.render_max_us = 0;
+    s_perf.flush_total_us = 0;
+    s_perf.flush_max_us = 0;
+    s_perf.area_total_px = 0;
+    s_perf.lock_waits = 0;
+    s_perf.lock_wait_total_us = 0;
+    s_perf.lock_wait_max_us = 0;
+    s_perf.te_wait_total_us = 0;
+    s_perf.te_wait_max_us = 0;
+    s_perf.te_missed_frames = 0;
+    s_perf.touch_responses = 0;
+    s_perf.touch_latency_total_us = 0;
+    s_perf.touch_latency_max_us = 0;
+    portEXIT_CRITICAL(&s_perf_lock);
+    
+    // A static screen has nothing to report
+    if (frames == 0) {
+        return;
+    }
+    
+    system_event_post(display_service_id,
+                     display_events[DISPLAY_EVENT_FRAME_STATS],
+                     &stats, sizeof(stats),
+                     SYSTEM_EVENT_PRIORITY_LOW);
+    
+#if CONFIG_DISPLAY_SERVICE_FPS_LOG_INTERVAL_MS > 0
+    if (now - s_perf.last_log_us >= CONFIG_DISPLAY_SERVICE_FPS_LOG_INTERVAL_MS * 1000LL) {
+        s_perf.last_log_us = now;
+        ESP_LOGI(TAG, "%lu fps, render %lu/%lu us, flush %lu/%lu us (avg/max), %lu px/frame",
+                 stats.fps, stats.render_avg_us, stats.render_max_us,
+                 stats.flush_avg_us, stats.flush_max_us, stats.area_avg_px);
+    }
+#endif
+    
+    // Updating the label redraws it, so the overlay itself costs a small
+    // frame per window
+    if (s_perf.overlay != NULL) {
+        lv_label_set_text_fmt(s_perf.overlay, "%lu fps  r%lu f%lu us",
+                              stats.fps, stats.render_avg_us, stats.flush_avg_us);
+    }
+}
+
+/* Hooks the instrumentation to the display (port lock held) */
+static void frame_stats_install(void)
+{
+    s_perf.window_start_us = esp_timer_get_time();
+    lv_display_add_event_cb(lvgl_disp, frame_event_cb, LV_EVENT_ALL, NULL);
+    lv_timer_create(frame_stats_timer_cb, CONFIG_DISPLAY_SERVICE_FRAME_STATS_INTERVAL_MS, NULL);
+    
+#if CONFIG_DISPLAY_SERVICE_PERF_OVERLAY
+    s_perf.overlay = lv_label_create(lv_layer_top());
+    lv_obj_set_style_text_color(s_perf.overlay, lv_color_hex(0x00FF00), 0);
+    lv_obj_set_style_bg_color(s_perf.overlay, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(s_perf.overlay, LV_OPA_70, 0);
+    lv_obj_align(s_perf.overlay, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
+    lv_label_set_text(s_perf.overlay, "-- fps");
+#endif
+}
+
+/* Touches keep the backlight up */
+static void touch_activity_cb(lv_event_t *e)
+{
+    (void)e;
+    display_backlight_notify_activity();
+}
+
+#if CONFIG_DISPLAY_SERVICE_TOUCH_IRQ
+/* Runs in the timer task: LVGL is stopped while the screen is off */
+static void touch_wake_screen(void *arg1, uint32_t arg2)
+{
+    (void)arg1;
+    (void)arg2;
+    display_backlight_notify_activity();
+}
+
+/* INT fell: a finger went down */
+static void touch_isr_handler(esp_lcd_touch_handle_t tp)
+{
+    (void)tp;
+    s_touch.irq_us = esp_timer_get_time();
+    
+    if (screen_on_state) {
+        // The port task reads the indev, which starts polling
+        lvgl_port_task_wake(LVGL_PORT_EVENT_TOUCH, s_touch.indev);
+    } else {
+        BaseType_t woken = pdFALSE;
+        xTimerPendFunctionCallFromISR(touch_wake_screen, NULL, 0, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+/* Wraps the port's read: polls while touched, goes quiet after the release */
+static void touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+    s_touch.port_read_cb(indev, data);
+    
+    if (data->state == LV_INDEV_STATE_PRESSED) {
+        if (s_touch.input_us == 0) {
+            // The first read after the edge answers the IRQ, later ones a drag
+            s_touch.input_us = (!s_touch.polling && s_touch.irq_us != 0) ?
+                               s_touch.irq_us : esp_timer_get_time();
+            s_touch.irq_us = 0;
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+            display_latency_touch(s_touch.input_us);
+            display_latency_stamp(DISPLAY_LATENCY_STAGE_PRESS);
+#endif
+        }
+        if (!s_touch.polling) {
+            lv_timer_resume(s_touch.read_timer);
+            s_touch.polling = true;
+        }
+    } else if (s_touch.polling && gpio_get_level(s_display_config.pin_touch_int) != 0) {
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+        display_latency_stamp(DISPLAY_LATENCY_STAGE_RELEASE);
+#endif
+        // LVGL has this release; nothing to read until the next edge
+        lv_timer_pause(s_touch.read_timer);
+        s_touch.polling = false;
+    }
+}
+
+/* Switch the touch indev from timer polling to the INT line. Call with the
+ * display lock held. */
+static void touch_irq_install(lv_indev_t *indev)
+{
+    s_touch.indev = indev;
+    s_touch.port_read_cb = lv_indev_get_read_cb(indev);
+    s_touch.read_timer = lv_indev_get_read_timer(indev);
+    if (s_touch.port_read_cb == NULL || s_touch.read_timer == NULL) {
+        return;
+    }
+    
+    esp_err_t ret = esp_lcd_touch_register_interrupt_callback(touch_handle, touch_isr_handler);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Touch INT unavailable, polling: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    lv_indev_set_read_cb(indev, touch_read_cb);
+    lv_indev_set_mode(indev, LV_INDEV_MODE_TIMER);
+    lv_timer_pause(s_touch.read_timer);
+    ESP_LOGI(TAG, "✓ Touch reads driven by INT (pin %d)", s_display_config.pin_touch_int);
+}
+#endif
+
+/* TE pulse: the panel just started vertical blanking */
+static void IRAM_ATTR te_isr_handler(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)arg, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/* Enable the panel's TE output and sync flushes to it. Failing leaves
+ * flushes unsynchronised, which only costs tearing. */
+static void config_te_sync(void)
+{
+    if (s_display_config.pin_te < 0) {
+        return;
+    }
+    
+    // TEON (0x35), mode 0: pulse on V-blank only; same on ILI9341 and ST7789
+    const uint8_t te_mode = 0x00;
+    esp_err_t ret = esp_lcd_panel_io_tx_param(io_handle, 0x35, &te_mode, 1);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to enable panel TE output: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary();
+    if (sem == NULL) {
+        ESP_LOGW(TAG, "No memory for TE sync");
+        return;
+    }
+    
+    const gpio_config_t te_gpio_config = {
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = 1ULL << s_display_config.pin_te,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    ret = gpio_config(&te_gpio_config);
+    if (ret == ESP_OK) {
+        // Another driver may have installed the ISR service already
+        ret = gpio_install_isr_service(0);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ret = ESP_OK;
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(s_display_config.pin_te, te_isr_handler, sem);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "TE interrupt setup failed: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(sem);
+        return;
+    }
+    
+    s_te_sem = sem;
+    ESP_LOGI(TAG, "✓ Flush synced to panel TE (pin %d)", s_display_config.pin_te);
+}
+
 /* Configure touch controller */
 static esp_err_t config_touch_controller(void)
 {
@@ -335,7 +1008,7 @@ static esp_err_t config_lcd_display(void)
         .miso_io_num = s_display_config.pin_miso,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = s_display_config.hor_res * 80 * sizeof(uint16_t),
+        .max_transfer_sz = s_display_config.hor_res * CONFIG_DISPLAY_SERVICE_BUFFER_LINES * sizeof(uint16_t),
     };
 
     ret = spi_bus_initialize(s_display_config.host, &bus_config, s_display_config.dma_channel);
@@ -349,7 +1022,7 @@ static esp_err_t config_lcd_display(void)
     const esp_lcd_panel_io_spi_config_t io_config = {
         .dc_gpio_num = s_display_config.pin_dc,
         .cs_gpio_num = s_display_config.pin_cs,
-        .pclk_hz = 40 * 1000 * 1000,  // 40 MHz for stable operation
+        .pclk_hz = CONFIG_DISPLAY_SERVICE_SPI_CLOCK_MHZ * 1000 * 1000,
         .lcd_cmd_bits = 8,
         .lcd_param_bits = 8,
         .spi_mode = 0,
@@ -393,6 +1066,8 @@ static esp_err_t config_lcd_display(void)
         goto cleanup;
     }
     ESP_LOGI(TAG, "✓ Panel reset and initialized");
+    
+    config_te_sync();
 
     // 5. Set panel orientation for vertical mode
     ret = esp_lcd_panel_swap_xy(panel_handle, false);  // No swap for portrait
@@ -415,51 +1090,55 @@ static esp_err_t config_lcd_display(void)
     }
     ESP_LOGI(TAG, "✓ Display turned ON");
 
-    // 7. Initialize backlight (simple GPIO control)
+    // 7. Initialize backlight (LEDC PWM, fades in to the current brightness)
     if (s_display_config.pin_bl >= 0) {
-        gpio_config_t bl_gpio_config = {
-            .mode = GPIO_MODE_OUTPUT,
-            .pin_bit_mask = 1ULL << s_display_config.pin_bl
-        };
-        gpio_config(&bl_gpio_config);
-        gpio_set_level(s_display_config.pin_bl, 1);  // Turn on backlight
-        ESP_LOGI(TAG, "✓ Backlight enabled (pin %d)", s_display_config.pin_bl);
+        if (display_backlight_init(s_display_config.pin_bl, current_brightness) != ESP_OK) {
+            ESP_LOGW(TAG, "Backlight PWM unavailable, screen stays dark");
+        }
     }
 
     // 8. Initialize LVGL port
     const lvgl_port_cfg_t lvgl_cfg = {
         .task_priority = configMAX_PRIORITIES - 3,
         .task_stack = 6144,
-        .task_affinity = 1,
-        .timer_period_ms = 5,
+        .task_affinity = CONFIG_SYSTEM_SERVICE_UI_CORE,
+        .timer_period_ms = CONFIG_DISPLAY_SERVICE_TICK_PERIOD_MS,
     };
     
+    boot_trace_id_t phase = boot_trace_begin("lvgl_port");
     ret = lvgl_port_init(&lvgl_cfg);
+    boot_trace_end(phase);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize LVGL port: %s", esp_err_to_name(ret));
         goto cleanup;
     }
     ESP_LOGI(TAG, "✓ LVGL port initialized");
 
-    // 9. Create LVGL display with reduced buffer size for SRAM savings
+    // 9. Create LVGL display; with both buffers DMA-capable, LVGL renders into
+    // one while the SPI DMA is still sending the other
     const lvgl_port_display_cfg_t disp_cfg = {
         .io_handle = io_handle,
         .panel_handle = panel_handle,
-        .buffer_size = s_display_config.hor_res * 20,  // Reduced from 50 to 20 lines
+        .buffer_size = s_display_config.hor_res * CONFIG_DISPLAY_SERVICE_BUFFER_LINES,
         .double_buffer = true,
         .hres = s_display_config.hor_res,
         .vres = s_display_config.ver_res,
         .monochrome = false,
         .color_format = LV_COLOR_FORMAT_RGB565,
+        // Board base orientation; the port combines it with the LVGL rotation
+        // into panel swap_xy/mirror calls
         .rotation = {
-            .mirror_x = 1,  // Enable X mirroring at LVGL level
+            .mirror_x = 1,  // Matches the panel mirror set in step 5
             .mirror_y = 0,
             .swap_xy = 0,
         },
         .flags = {
             .swap_bytes = 1,
-            .buff_dma = 0,  // Don't use DMA buffers (saves SRAM)
-            .buff_spiram = 1,  // Use SPIRAM for buffers
+            .buff_dma = DRAW_BUFF_DMA,
+            .buff_spiram = DRAW_BUFF_SPIRAM,
+#if CONFIG_DISPLAY_SERVICE_SW_ROTATE
+            .sw_rotate = 1,  // Panel cannot rotate itself: rotate in the flush path
+#endif
         },
     };
 
@@ -469,7 +1148,22 @@ static esp_err_t config_lcd_display(void)
         ret = ESP_FAIL;
         goto cleanup;
     }
-    ESP_LOGI(TAG, "✓ LVGL display created (%dx%d)", s_display_config.hor_res, s_display_config.ver_res);
+    ESP_LOGI(TAG, "✓ LVGL display created (%dx%d, %d-line %s buffers, %d MHz)",
+             s_display_config.hor_res, s_display_config.ver_res,
+             CONFIG_DISPLAY_SERVICE_BUFFER_LINES, DRAW_BUFF_DMA ? "SRAM DMA" : "PSRAM",
+             CONFIG_DISPLAY_SERVICE_SPI_CLOCK_MHZ);
+    
+    // Before any UI exists: fonts bind to their atlases on first use
+    if (display_assets_init() != ESP_OK) {
+        ESP_LOGW(TAG, "UI assets unavailable, drawing from the built-in fonts");
+    }
+    
+    if (display_lock(pdMS_TO_TICKS(1000))) {
+        lv_display_add_event_cb(lvgl_disp, first_frame_cb, LV_EVENT_RENDER_READY, NULL);
+        frame_stats_install();
+        display_ui_queue_init(lvgl_disp);
+        lvgl_port_unlock();
+    }
     
     // 10. Initialize touch controller
     ret = config_touch_controller();
@@ -483,15 +1177,23 @@ static esp_err_t config_lcd_display(void)
             .handle = touch_handle,
         };
         
-        if (lvgl_port_add_touch(&touch_cfg) == NULL) {
+        lv_indev_t *touch_indev = lvgl_port_add_touch(&touch_cfg);
+        if (touch_indev == NULL) {
             ESP_LOGW(TAG, "Failed to add touch to LVGL");
         } else {
+            if (display_lock(pdMS_TO_TICKS(1000))) {
+                lv_indev_add_event_cb(touch_indev, touch_activity_cb, LV_EVENT_PRESSED, NULL);
+#if CONFIG_DISPLAY_SERVICE_TOUCH_IRQ
+                touch_irq_install(touch_indev);
+#endif
+                lvgl_port_unlock();
+            }
             ESP_LOGI(TAG, "✓ Touch input registered with LVGL");
         }
     }
     
     // Set display as default
-    if (lvgl_port_lock(pdMS_TO_TICKS(1000))) {
+    if (display_lock(pdMS_TO_TICKS(1000))) {
         lv_disp_set_default(lvgl_disp);
         lvgl_port_unlock();
     }
@@ -522,13 +1224,29 @@ static void back_button_clicked(void)
 }
 
 
+/* Key presses keep the backlight up */
+static void input_activity_handler(const system_event_t *event, void *user_data)
+{
+    (void)event;
+    (void)user_data;
+    display_backlight_notify_activity();
+}
+
+/* Back is only for sub-screens; the main menu never needs waking for it */
+static bool sub_screen_open(const system_event_t *event, void *user_data)
+{
+    (void)event;
+    (void)user_data;
+    return __atomic_load_n(&nav_stack_top, __ATOMIC_RELAXED) >= 0;
+}
+
 /* Event handler for back button */
 static void display_back_event_handler(const system_event_t *event, void *user_data)
 {
     if (event->event_type == menu_back_event) {
         ESP_LOGI(TAG, "Back button clicked - returning to previous screen");
         
-        if (!lvgl_port_lock(0)) {
+        if (!display_lock(0)) {
             ESP_LOGE(TAG, "Failed to lock LVGL mutex");
             return;
         }
@@ -540,6 +1258,28 @@ static void display_back_event_handler(const system_event_t *event, void *user_d
     }
 }
 
+// A hibernated app gives up its widgets; it builds them again on resume
+static void app_hibernated_handler(const system_event_t *event, void *user_data)
+{
+    const common_app_hibernate_t *report = SYSTEM_EVENT_PAYLOAD(event, COMMON_EVENT_APP_HIBERNATED);
+    if (report == NULL) {
+        return;
+    }
+    
+    if (!display_lock(0)) {
+        ESP_LOGE(TAG, "Failed to lock LVGL mutex");
+        return;
+    }
+    
+    int released = release_app_screens(report->name);
+    
+    lvgl_port_unlock();
+    
+    if (released > 0) {
+        ESP_LOGI(TAG, "Deleted %d screens of hibernated app '%s'", released, report->name);
+    }
+}
+
 esp_err_t display_service_init(void)
 {
     if (initialized) {
@@ -560,6 +1300,17 @@ esp_err_t display_service_init(void)
     
     ESP_LOGI(TAG, "✓ Registered with system service (ID: %d)", display_service_id);
     
+    // Restore the user's brightness before the backlight comes up
+    if (system_setting_register(display_service_id, "disp.bright", SYSTEM_SETTING_U8,
+                                current_brightness, &brightness_setting) == ESP_OK) {
+        current_brightness = system_setting_u8(brightness_setting);
+        if (current_brightness > 100) {
+            current_brightness = 100;
+        }
+    }
+    system_setting_register(display_service_id, "disp.orient", SYSTEM_SETTING_U8,
+                            DISPLAY_ORIENTATION_0, &orientation_setting);
+    
     // Register event types
     const char *event_names[] = {
         "display.registered",
@@ -569,18 +1320,23 @@ esp_err_t display_service_init(void)
         "display.screen_on",
         "display.screen_off",
         "display.orientation_changed",
-        "display.error"
+        "display.error",
+        "display.frame_stats"
     };
     
-    for (int i = 0; i < 8; i++) {
-        ret = system_event_register_type(event_names[i], &display_events[i]);
+    for (int i = 0; i < DISPLAY_EVENT_COUNT; i++) {
+        // Brightness and frame stats are state: a newer value supersedes a pending one
+        system_event_topic_mode_t mode = (i == DISPLAY_EVENT_BRIGHTNESS_CHANGED ||
+                                          i == DISPLAY_EVENT_FRAME_STATS) ?
+                                         SYSTEM_EVENT_TOPIC_LATEST : SYSTEM_EVENT_TOPIC_QUEUED;
+        ret = system_event_register_topic(event_names[i], mode, &display_events[i]);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to register event type '%s'", event_names[i]);
             return ret;
         }
     }
     
-    ESP_LOGI(TAG, "✓ Registered %d event types", 8);
+    ESP_LOGI(TAG, "✓ Registered %d event types", DISPLAY_EVENT_COUNT);
     
     // Register menu event types
     system_event_register_type("menu.audio_clicked", &menu_audio_event);
@@ -592,17 +1348,38 @@ esp_err_t display_service_init(void)
     ESP_LOGI(TAG, "✓ Registered menu event types");
     
     // Subscribe to menu events
-    ret = system_event_subscribe(display_service_id, menu_back_event, display_back_event_handler, NULL);
+    const system_event_filter_t back_filter = {
+        .predicate = sub_screen_open,
+    };
+    ret = system_event_subscribe_filtered(display_service_id, menu_back_event,
+                                          display_back_event_handler, NULL, &back_filter);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "✓ Subscribed to menu.back_clicked event");
     }
     
+    system_event_subscribe(display_service_id, COMMON_EVENT_APP_HIBERNATED, app_hibernated_handler, NULL);
+    
+    // Both rebuild screens, so they run in the LVGL task between frames
+    system_event_set_affinity(display_service_id, menu_back_event, SYSTEM_EVENT_AFFINITY_UI);
+    system_event_set_affinity(display_service_id, COMMON_EVENT_APP_HIBERNATED, SYSTEM_EVENT_AFFINITY_UI);
+    
+    // Any key counts as activity for the backlight idle timer, whenever
+    // the input service gets to register its keys
+    system_event_subscribe_pattern(display_service_id, "input.key_*_pressed", input_activity_handler, NULL);
+    
     // Note: network_service handles its own UI, so we don't subscribe to network clicks here
     
+    ret = system_power_lock_create(SYSTEM_POWER_LOCK_NO_SLEEP, "display", &screen_power_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No power lock, screen may flicker in light sleep");
+    }
+    system_power_lock_acquire(screen_power_lock);
+    
     // Initialize LCD hardware
     ret = config_lcd_display();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to configure LCD display");
+        system_power_lock_release(screen_power_lock);
         system_service_unregister(display_service_id);
         return ret;
     }
@@ -614,6 +1391,24 @@ esp_err_t display_service_init(void)
         // Continue anyway - display is functional
     }
     
+#if CONFIG_DISPLAY_SERVICE_LATENCY_TRACE
+    // Sees the menu events as they leave the bus, so it subscribes as this service
+    const system_event_type_t traced_events[] = {
+        menu_audio_event, menu_network_event, menu_bluetooth_event,
+        menu_display_event, menu_apps_event,
+    };
+    if (display_lock(pdMS_TO_TICKS(1000))) {
+        ret = display_latency_init(display_service_id, lvgl_disp, traced_events,
+                                   sizeof(traced_events) / sizeof(traced_events[0]), menu_back_event);
+        lvgl_port_unlock();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Latency tracer unavailable: %s", esp_err_to_name(ret));
+        } else if (CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_TAPS > 0) {
+            display_latency_run_script(CONFIG_DISPLAY_SERVICE_LATENCY_SCRIPT_TAPS);
+        }
+    }
+#endif
+    
     // Set service state
     system_service_set_state(display_service_id, SYSTEM_SERVICE_STATE_REGISTERED);
     
@@ -628,6 +1423,12 @@ esp_err_t display_service_init(void)
     ESP_LOGI(TAG, "✓ Display service initialized successfully");
     ESP_LOGI(TAG, "  → Posted DISPLAY_EVENT_REGISTERED");
     
+    // Needs the UI up, so after the rest of init
+    display_orientation_t stored_orientation = (display_orientation_t)system_setting_u8(orientation_setting);
+    if (stored_orientation != DISPLAY_ORIENTATION_0) {
+        display_set_orientation(stored_orientation);
+    }
+    
     return ESP_OK;
 }
 
@@ -639,17 +1440,23 @@ esp_err_t display_service_deinit(void)
     
     ESP_LOGI(TAG, "Deinitializing display service...");
     
+    // No more touch wakeups for an indev that is about to go
+    if (touch_handle && s_touch.indev) {
+        esp_lcd_touch_register_interrupt_callback(touch_handle, NULL);
+        s_touch.indev = NULL;
+    }
+    
     // Clean up LVGL
+    display_ui_queue_deinit();
     if (lvgl_disp) {
         lvgl_port_remove_disp(lvgl_disp);
         lvgl_disp = NULL;
     }
     lvgl_port_deinit();
+    display_assets_deinit();
     
     // Turn off backlight
-    if (s_display_config.pin_bl >= 0) {
-        gpio_set_level(s_display_config.pin_bl, 0);
-    }
+    display_backlight_deinit();
     
     // Clean up LCD panel
     if (panel_handle) {
@@ -658,6 +1465,13 @@ esp_err_t display_service_deinit(void)
         panel_handle = NULL;
     }
     
+    // Stop TE sync before the LVGL task could wait on it again
+    if (s_te_sem) {
+        gpio_isr_handler_remove(s_display_config.pin_te);
+        vSemaphoreDelete(s_te_sem);
+        s_te_sem = NULL;
+    }
+    
     // Clean up panel I/O
     if (io_handle) {
         esp_lcd_panel_io_del(io_handle);
@@ -729,13 +1543,10 @@ esp_err_t display_set_brightness(uint8_t brightness)
     }
     
     current_brightness = brightness;
+    system_setting_set_u8(brightness_setting, brightness);
     
-    // Control backlight PWM or simple on/off
-    // For simple GPIO control, map brightness to on/off
-    if (s_display_config.pin_bl >= 0) {
-        gpio_set_level(s_display_config.pin_bl, brightness > 0 ? 1 : 0);
-        // TODO: Use LEDC PWM for proper brightness control
-    }
+    // Fades to the new level; a user change also restarts the idle timer
+    display_backlight_set_brightness(brightness);
     
     display_brightness_event_t event_data = {
         .brightness = brightness
@@ -772,13 +1583,21 @@ esp_err_t display_screen_on(void)
     
     ESP_LOGI(TAG, "Turning screen ON");
     
+    // Resume LVGL and redraw everything before the panel shows it
+    if (!screen_on_state) {
+        system_power_lock_acquire(screen_power_lock);
+        lvgl_port_resume();
+        if (display_lock(pdMS_TO_TICKS(1000))) {
+            lv_obj_invalidate(lv_screen_active());
+            lvgl_port_unlock();
+        }
+    }
+    
     // Turn on LCD panel
     esp_lcd_panel_disp_on_off(panel_handle, true);
     
-    // Turn on backlight
-    if (s_display_config.pin_bl >= 0) {
-        gpio_set_level(s_display_config.pin_bl, 1);
-    }
+    // Fade the backlight back in and restart the idle timer
+    display_backlight_screen_on();
     
     screen_on_state = true;
     
@@ -801,13 +1620,18 @@ esp_err_t display_screen_off(void)
     ESP_LOGI(TAG, "Turning screen OFF");
     
     // Turn off backlight
-    if (s_display_config.pin_bl >= 0) {
-        gpio_set_level(s_display_config.pin_bl, 0);
-    }
+    display_backlight_screen_off();
     
     // Turn off LCD panel
     esp_lcd_panel_disp_on_off(panel_handle, false);
     
+    // Nothing is visible: stop the LVGL tick and timers until screen on.
+    // UI queue commands wait meanwhile and are applied on resume.
+    if (screen_on_state) {
+        lvgl_port_stop();
+        system_power_lock_release(screen_power_lock);
+    }
+    
     screen_on_state = false;
     
     system_event_post(display_service_id,
@@ -822,52 +1646,35 @@ esp_err_t display_screen_off(void)
 
 esp_err_t display_set_orientation(display_orientation_t orientation)
 {
-    if (!initialized || !panel_handle) {
+    if (!initialized || !panel_handle || !lvgl_disp) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    esp_err_t ret;
-    current_orientation = orientation;
-    
-    // Configure panel orientation
-    switch (orientation) {
-        case DISPLAY_ORIENTATION_0:
-            ret = esp_lcd_panel_swap_xy(panel_handle, false);
-            if (ret == ESP_OK) {
-                ret = esp_lcd_panel_mirror(panel_handle, true, true);
-            }
-            break;
-            
-        case DISPLAY_ORIENTATION_90:
-            ret = esp_lcd_panel_swap_xy(panel_handle, true);
-            if (ret == ESP_OK) {
-                ret = esp_lcd_panel_mirror(panel_handle, false, true);
-            }
-            break;
-            
-        case DISPLAY_ORIENTATION_180:
-            ret = esp_lcd_panel_swap_xy(panel_handle, false);
-            if (ret == ESP_OK) {
-                ret = esp_lcd_panel_mirror(panel_handle, true, true);
-            }
-            break;
-            
-        case DISPLAY_ORIENTATION_270:
-            ret = esp_lcd_panel_swap_xy(panel_handle, true);
-            if (ret == ESP_OK) {
-                ret = esp_lcd_panel_mirror(panel_handle, true, false);
-            }
-            break;
-            
-        default:
-            return ESP_ERR_INVALID_ARG;
+    static const lv_display_rotation_t rotations[] = {
+        [DISPLAY_ORIENTATION_0] = LV_DISPLAY_ROTATION_0,
+        [DISPLAY_ORIENTATION_90] = LV_DISPLAY_ROTATION_90,
+        [DISPLAY_ORIENTATION_180] = LV_DISPLAY_ROTATION_180,
+        [DISPLAY_ORIENTATION_270] = LV_DISPLAY_ROTATION_270,
+    };
+    if ((unsigned)orientation >= sizeof(rotations) / sizeof(rotations[0])) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set orientation: %s", esp_err_to_name(ret));
-        return ret;
+    if (!display_lock(pdMS_TO_TICKS(1000))) {
+        ESP_LOGE(TAG, "Failed to lock LVGL mutex");
+        return ESP_ERR_TIMEOUT;
     }
     
+    // LVGL swaps the resolution for 90/270 and invalidates the screen; the
+    // port turns the rotation into panel swap_xy/mirror (MADCTL) calls, on
+    // top of the board's base orientation, unless software rotation is on
+    lv_display_set_rotation(lvgl_disp, rotations[orientation]);
+    current_orientation = orientation;
+    
+    lvgl_port_unlock();
+    
+    system_setting_set_u8(orientation_setting, (uint8_t)orientation);
+    
     display_orientation_event_t event_data = {
         .orientation = orientation
     };
@@ -885,6 +1692,30 @@ esp_err_t display_set_orientation(display_orientation_t orientation)
     return ESP_OK;
 }
 
+esp_err_t display_get_fps(uint32_t *fps)
+{
+    if (!initialized || fps == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&s_perf_lock);
+    *fps = s_perf.last.fps;
+    portEXIT_CRITICAL(&s_perf_lock);
+    return ESP_OK;
+}
+
+esp_err_t display_get_frame_stats(display_frame_stats_t *stats)
+{
+    if (!initialized || stats == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&s_perf_lock);
+    *stats = s_perf.last;
+    portEXIT_CRITICAL(&s_perf_lock);
+    return ESP_OK;
+}
+
 system_service_id_t display_service_get_id(void)
 {
     return display_service_id;
@@ -898,13 +1729,13 @@ esp_err_t display_service_load_screen(lv_obj_t *content)
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (!lvgl_port_lock(0)) {
+    if (!display_lock(0)) {
         ESP_LOGE(TAG, "Failed to lock LVGL mutex");
         return ESP_FAIL;
     }
     
     // Use navigation stack for screen management
-    esp_err_t ret = nav_push(content);
+    esp_err_t ret = nav_push(content, NULL);
     
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "Screen loaded via nav_push");
@@ -916,6 +1747,43 @@ esp_err_t display_service_load_screen(lv_obj_t *content)
     return ret;
 }
 
+/* Load screen content that is cached instead of destroyed when popped */
+esp_err_t display_service_load_screen_cached(lv_obj_t *content, const char *key)
+{
+    if (!main_screen || !content || !key) {
+        ESP_LOGE(TAG, "Invalid parameters for load_screen_cached");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!display_lock(0)) {
+        ESP_LOGE(TAG, "Failed to lock LVGL mutex");
+        return ESP_FAIL;
+    }
+    
+    esp_err_t ret = nav_push(content, key);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to push screen '%s'", key);
+    }
+    
+    lvgl_port_unlock();
+    return ret;
+}
+
+lv_obj_t* display_service_take_cached_screen(const char *key)
+{
+    if (key == NULL || !display_lock(0)) {
+        return NULL;
+    }
+    
+    lv_obj_t *content = screen_cache_take(key);
+    if (content != NULL) {
+        ESP_LOGI(TAG, "Reusing cached screen '%s'", key);
+    }
+    
+    lvgl_port_unlock();
+    return content;
+}
+
 lv_obj_t* display_service_get_main_screen(void)
 {
     return main_screen;
@@ -0,0 +1,290 @@
+/**
+ * @file display_ui_queue.c
+ * @brief Lock-free UI command queue into the LVGL task
+ * 
+ * Bounded MPSC ring with per-slot sequence numbers, the same scheme as the
+ * system service's ISR event ring: a producer claims a slot with a
+ * compare-and-swap on the write position, fills it and publishes it by
+ * advancing the slot sequence. The LVGL task is the only consumer and
+ * drains the ring from the display's LV_EVENT_REFR_START, before layout
+ * and rendering.
+ * 
+ * The same refresh also runs the event handlers subscribed with the UI
+ * affinity, as the LVGL task is attached to the event bus as its UI task.
+ */
+
+#include "display_ui_queue.h"
+#include "display_service.h"
+#include "system_service/event_bus.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "display_ui_queue";
+
+/* ============================================================================
+ * Ring Structure
+ * ============================================================================ */
+
+#define UI_QUEUE_SIZE               CONFIG_DISPLAY_SERVICE_UI_QUEUE_SIZE
+#define UI_QUEUE_MASK               (UI_QUEUE_SIZE - 1)
+
+_Static_assert((UI_QUEUE_SIZE & UI_QUEUE_MASK) == 0,
+               "DISPLAY_SERVICE_UI_QUEUE_SIZE must be a power of two");
+
+// Event handlers run per refresh, the rest wait for the next one
+#define UI_HANDLERS_PER_FRAME       8
+
+typedef enum {
+    UI_CMD_SET_TEXT = 0,
+    UI_CMD_SET_VALUE,
+    UI_CMD_SET_HIDDEN,
+    UI_CMD_LOAD_SCREEN,
+    UI_CMD_CALL,
+} ui_cmd_type_t;
+
+typedef struct {
+    ui_cmd_type_t type;
+    lv_obj_t *target;
+    union {
+        char text[DISPLAY_UI_TEXT_MAX];
+        int32_t value;
+        bool hidden;
+        const char *cache_key;
+        struct {
+            display_ui_fn_t fn;
+            void *arg;
+        } call;
+    } data;
+} ui_cmd_t;
+
+typedef struct {
+    volatile uint32_t sequence;     // Publication state of this slot
+    ui_cmd_t cmd;
+} ui_slot_t;
+
+typedef struct {
+    ui_slot_t slots[UI_QUEUE_SIZE];
+    volatile uint32_t write_pos;    // Next position producers claim
+    uint32_t read_pos;              // Next position the LVGL task reads
+    volatile uint32_t drops;
+    bool initialized;
+} ui_queue_t;
+
+static ui_queue_t s_queue = {0};
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+/* Claim a slot; returns NULL and counts a drop if the ring is full */
+static ui_slot_t* claim_slot(uint32_t *out_pos)
+{
+    uint32_t pos = __atomic_load_n(&s_queue.write_pos, __ATOMIC_RELAXED);
+    
+    while (true) {
+        ui_slot_t *slot = &s_queue.slots[pos & UI_QUEUE_MASK];
+        uint32_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+    
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_queue.write_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *out_pos = pos;
+                return slot;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            __atomic_add_fetch(&s_queue.drops, 1, __ATOMIC_RELAXED);
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&s_queue.write_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static esp_err_t post(const ui_cmd_t *cmd)
+{
+    if (!s_queue.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    uint32_t pos;
+    ui_slot_t *slot = claim_slot(&pos);
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    slot->cmd = *cmd;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+static void apply(const ui_cmd_t *cmd)
+{
+    if (cmd->type == UI_CMD_CALL) {
+        cmd->data.call.fn(cmd->data.call.arg);
+        return;
+    }
+    
+    // The widget may have been deleted since the command was posted
+    if (!lv_obj_is_valid(cmd->target)) {
+        ESP_LOGD(TAG, "Dropping command %d for a deleted object", cmd->type);
+        return;
+    }
+    
+    switch (cmd->type) {
+        case UI_CMD_SET_TEXT:
+            lv_label_set_text(cmd->target, cmd->data.text);
+            break;
+    
+        case UI_CMD_SET_VALUE:
+            if (lv_obj_check_type(cmd->target, &lv_bar_class)) {
+                lv_bar_set_value(cmd->target, cmd->data.value, LV_ANIM_OFF);
+            } else if (lv_obj_check_type(cmd->target, &lv_slider_class)) {
+                lv_slider_set_value(cmd->target, cmd->data.value, LV_ANIM_OFF);
+            } else if (lv_obj_check_type(cmd->target, &lv_arc_class)) {
+                lv_arc_set_value(cmd->target, cmd->data.value);
+            } else {
+                ESP_LOGW(TAG, "Object does not take a value");
+            }
+            break;
+    
+        case UI_CMD_SET_HIDDEN:
+            if (cmd->data.hidden) {
+                lv_obj_add_flag(cmd->target, LV_OBJ_FLAG_HIDDEN);
+            } else {
+                lv_obj_clear_flag(cmd->target, LV_OBJ_FLAG_HIDDEN);
+            }
+            break;
+    
+        case UI_CMD_LOAD_SCREEN:
+            if (cmd->data.cache_key != NULL) {
+                display_service_load_screen_cached(cmd->target, cmd->data.cache_key);
+            } else {
+                display_service_load_screen(cmd->target);
+            }
+            break;
+    
+        default:
+            break;
+    }
+}
+
+/* Drain everything published so far; runs in the LVGL task */
+static void drain_cb(lv_event_t *e)
+{
+    (void)e;
+    
+    while (true) {
+        uint32_t pos = s_queue.read_pos;
+        ui_slot_t *slot = &s_queue.slots[pos & UI_QUEUE_MASK];
+    
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1) {
+            break;
+        }
+    
+        ui_cmd_t cmd = slot->cmd;
+    
+        // Free the slot before applying, so a command may post another
+        s_queue.read_pos = pos + 1;
+        __atomic_store_n(&slot->sequence, pos + UI_QUEUE_SIZE, __ATOMIC_RELEASE);
+    
+        apply(&cmd);
+    }
+    
+    system_event_ui_run(UI_HANDLERS_PER_FRAME);
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t display_ui_queue_init(lv_display_t *disp)
+{
+    if (disp == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_queue.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(&s_queue, 0, sizeof(s_queue));
+    for (uint32_t i = 0; i < UI_QUEUE_SIZE; i++) {
+        s_queue.slots[i].sequence = i;
+    }
+    
+    lv_display_add_event_cb(disp, drain_cb, LV_EVENT_REFR_START, NULL);
+    s_queue.initialized = true;
+    
+    if (system_event_ui_attach() != ESP_OK) {
+        ESP_LOGW(TAG, "UI handlers will run on the dispatch workers");
+    }
+    
+    ESP_LOGI(TAG, "UI command queue ready: %d slots", UI_QUEUE_SIZE);
+    return ESP_OK;
+}
+
+void display_ui_queue_deinit(void)
+{
+    // Commands still queued are discarded with the display, UI handlers
+    // go back to the workers
+    s_queue.initialized = false;
+    system_event_ui_detach();
+}
+
+esp_err_t display_ui_set_text(lv_obj_t *label, const char *text)
+{
+    if (label == NULL || text == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ui_cmd_t cmd = { .type = UI_CMD_SET_TEXT, .target = label };
+    strncpy(cmd.data.text, text, DISPLAY_UI_TEXT_MAX - 1);
+    cmd.data.text[DISPLAY_UI_TEXT_MAX - 1] = '\0';
+    return post(&cmd);
+}
+
+esp_err_t display_ui_set_value(lv_obj_t *obj, int32_t value)
+{
+    if (obj == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ui_cmd_t cmd = { .type = UI_CMD_SET_VALUE, .target = obj, .data.value = value };
+    return post(&cmd);
+}
+
+esp_err_t display_ui_set_hidden(lv_obj_t *obj, bool hidden)
+{
+    if (obj == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ui_cmd_t cmd = { .type = UI_CMD_SET_HIDDEN, .target = obj, .data.hidden = hidden };
+    return post(&cmd);
+}
+
+esp_err_t display_ui_load_screen(lv_obj_t *content, const char *cache_key)
+{
+    if (content == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ui_cmd_t cmd = { .type = UI_CMD_LOAD_SCREEN, .target = content, .data.cache_key = cache_key };
+    return post(&cmd);
+}
+
+esp_err_t display_ui_call(display_ui_fn_t fn, void *arg)
+{
+    if (fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ui_cmd_t cmd = { .type = UI_CMD_CALL, .data.call = { .fn = fn, .arg = arg } };
+    return post(&cmd);
+}
+
+uint32_t display_ui_get_drops(void)
+{
+    return __atomic_load_n(&s_queue.drops, __ATOMIC_RELAXED);
+}
@@ -7,6 +7,7 @@
  */
 
 #include "ui_mainmenu.h"
+#include "ui_styles.h"
 #include <string.h>
 
 // Default configuration (no static object pointers!)
@@ -80,7 +81,7 @@ lv_obj_t* ui_mainmenu_create(lv_obj_t *parent, uint16_t topbar_height,
             lv_obj_t *icon = lv_label_create(item);
             lv_label_set_text(icon, items[i].icon);
             lv_obj_set_style_text_color(icon, cfg.text_color, 0);
-            lv_obj_set_style_text_font(icon, &lv_font_montserrat_14, 0);
+            lv_obj_set_style_text_font(icon, UI_FONT_MEDIUM, 0);
             lv_obj_align(icon, LV_ALIGN_LEFT_MID, 12, 0);
         }
 
@@ -88,14 +89,14 @@ lv_obj_t* ui_mainmenu_create(lv_obj_t *parent, uint16_t topbar_height,
         lv_obj_t *label = lv_label_create(item);
         lv_label_set_text(label, items[i].label);
         lv_obj_set_style_text_color(label, cfg.text_color, 0);
-        lv_obj_set_style_text_font(label, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_text_font(label, UI_FONT_MEDIUM, 0);
         lv_obj_align(label, LV_ALIGN_LEFT_MID, 45, 0);
 
         // Add chevron (right arrow)
         lv_obj_t *chevron = lv_label_create(item);
         lv_label_set_text(chevron, LV_SYMBOL_RIGHT);
         lv_obj_set_style_text_color(chevron, lv_color_hex(0x808080), 0);
-        lv_obj_set_style_text_font(chevron, &lv_font_montserrat_12, 0);
+        lv_obj_set_style_text_font(chevron, UI_FONT_SMALL, 0);
         lv_obj_align(chevron, LV_ALIGN_RIGHT_MID, -8, 0);
 
         // Add click event
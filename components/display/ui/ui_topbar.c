@@ -4,6 +4,7 @@
  */
 
 #include "ui_topbar.h"
+#include "ui_styles.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -53,7 +54,7 @@ lv_obj_t* ui_topbar_create(lv_obj_t *parent, const ui_topbar_config_t *config) {
     clock_label = lv_label_create(topbar_container);
     lv_label_set_text(clock_label, "00:00");
     lv_obj_set_style_text_color(clock_label, current_config.text_color, 0);
-    lv_obj_set_style_text_font(clock_label, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_font(clock_label, UI_FONT_SMALL, 0);
     lv_obj_set_style_text_opa(clock_label, LV_OPA_COVER, 0); // Disable anti-aliasing
     lv_obj_align(clock_label, LV_ALIGN_LEFT_MID, 8, 0);
 
@@ -73,21 +74,21 @@ lv_obj_t* ui_topbar_create(lv_obj_t *parent, const ui_topbar_config_t *config) {
     wifi_icon = lv_label_create(icons_container);
     lv_label_set_text(wifi_icon, LV_SYMBOL_WIFI);
     lv_obj_set_style_text_color(wifi_icon, lv_color_hex(0x808080), 0); // Gray (disconnected)
-    lv_obj_set_style_text_font(wifi_icon, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_font(wifi_icon, UI_FONT_SMALL, 0);
     lv_obj_set_style_text_opa(wifi_icon, LV_OPA_COVER, 0); // Disable anti-aliasing
 
     // Bluetooth icon
     bluetooth_icon = lv_label_create(icons_container);
     lv_label_set_text(bluetooth_icon, LV_SYMBOL_BLUETOOTH);
     lv_obj_set_style_text_color(bluetooth_icon, lv_color_hex(0x808080), 0); // Gray (disconnected)
-    lv_obj_set_style_text_font(bluetooth_icon, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_font(bluetooth_icon, UI_FONT_SMALL, 0);
     lv_obj_set_style_text_opa(bluetooth_icon, LV_OPA_COVER, 0); // Disable anti-aliasing
 
     // Battery icon
     battery_icon = lv_label_create(icons_container);
     lv_label_set_text(battery_icon, LV_SYMBOL_BATTERY_FULL);
     lv_obj_set_style_text_color(battery_icon, current_config.text_color, 0);
-    lv_obj_set_style_text_font(battery_icon, &lv_font_montserrat_12, 0);
+    lv_obj_set_style_text_font(battery_icon, UI_FONT_SMALL, 0);
     lv_obj_set_style_text_opa(battery_icon, LV_OPA_COVER, 0); // Disable anti-aliasing
 
     // Create separator line
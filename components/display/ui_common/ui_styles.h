@@ -7,6 +7,7 @@
 #define UI_STYLES_H
 
 #include "lvgl.h"
+#include "display_assets.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,10 +36,10 @@ extern "C" {
 #define UI_RADIUS_MEDIUM            8
 #define UI_RADIUS_LARGE             12
 
-// Font sizes
-#define UI_FONT_SMALL               &lv_font_montserrat_12
-#define UI_FONT_MEDIUM              &lv_font_montserrat_14
-#define UI_FONT_LARGE               &lv_font_montserrat_16
+// Font sizes, served from the asset atlases and glyph cache
+#define UI_FONT_SMALL               display_assets_font(&lv_font_montserrat_12, "montserrat_12")
+#define UI_FONT_MEDIUM              display_assets_font(&lv_font_montserrat_14, "montserrat_14")
+#define UI_FONT_LARGE               display_assets_font(&lv_font_montserrat_16, "montserrat_16")
 
 // Common dimensions
 #define UI_BUTTON_HEIGHT            40
@@ -3,18 +3,53 @@
 
 #include "esp_err.h"
 #include "system_service/system_types.h"
+#include "system_service/event_schema.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef enum {
-    INPUT_EVENT_KEY_LEFT_PRESSED = 0,
-    INPUT_EVENT_KEY_RIGHT_PRESSED,
-    INPUT_EVENT_KEY_UP_PRESSED,
-    INPUT_EVENT_KEY_DOWN_PRESSED,
-    INPUT_EVENT_KEY_SELECT_PRESSED,
-} input_event_id_t;
+    INPUT_KEY_LEFT = 0,
+    INPUT_KEY_RIGHT,
+    INPUT_KEY_UP,
+    INPUT_KEY_DOWN,
+    INPUT_KEY_SELECT,
+    INPUT_KEY_COUNT,
+} input_key_t;
+
+typedef enum {
+    INPUT_KEY_ACTION_PRESS = 0,     // First edge, posted from the GPIO interrupt
+    INPUT_KEY_ACTION_LONG_PRESS,    // Held for CONFIG_INPUT_LONG_PRESS_MS
+    INPUT_KEY_ACTION_REPEAT,        // Every CONFIG_INPUT_REPEAT_MS after a long press
+    INPUT_KEY_ACTION_RELEASE,
+} input_key_action_t;
+
+/*
+ * Payload of every key event. Press, long press and repeat are posted on
+ * the key's input.key_*_pressed topic, releases of any key on
+ * input.key_released.
+ */
+typedef struct {
+    uint8_t key;                    // input_key_t
+    uint8_t action;                 // input_key_action_t
+    uint16_t repeat;                // Repeats so far, 0 before the first
+    uint32_t held_ms;               // Since the press; 0 for the press itself
+} input_key_event_t;
+
+// The pressed topics are in input_key_t order
+#define INPUT_EVENT_SCHEMA(X) \
+    X(INPUT_EVENT_KEY_LEFT_PRESSED,     "input.key_left_pressed",   input_key_event_t, 1, QUEUED) \
+    X(INPUT_EVENT_KEY_RIGHT_PRESSED,    "input.key_right_pressed",  input_key_event_t, 1, QUEUED) \
+    X(INPUT_EVENT_KEY_UP_PRESSED,       "input.key_up_pressed",     input_key_event_t, 1, QUEUED) \
+    X(INPUT_EVENT_KEY_DOWN_PRESSED,     "input.key_down_pressed",   input_key_event_t, 1, QUEUED) \
+    X(INPUT_EVENT_KEY_SELECT_PRESSED,   "input.key_select_pressed", input_key_event_t, 1, QUEUED) \
+    X(INPUT_EVENT_KEY_RELEASED,         "input.key_released",       input_key_event_t, 1, QUEUED)
+
+SYSTEM_EVENT_SCHEMA_DECLARE(INPUT_EVENT_SCHEMA, INPUT_EVENT, SYSTEM_EVENT_RANGE_INPUT);
+
+_Static_assert(INPUT_EVENT_KEY_SELECT_PRESSED - INPUT_EVENT_KEY_LEFT_PRESSED == INPUT_KEY_SELECT,
+               "pressed topics must follow input_key_t");
 
 esp_err_t input_service_init(void);
 
@@ -0,0 +1,36 @@
+#ifndef INPUT_KEYS_H
+#define INPUT_KEYS_H
+
+#include "esp_err.h"
+#include "input_service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * GPIO key driver behind the input service. Each configured key has an
+ * edge interrupt and one one-shot esp_timer that runs its debounce,
+ * long press and repeat phases in turn; nothing runs while no key is
+ * down.
+ */
+
+/**
+ * @brief Set up the configured keys, interrupts still off
+ *
+ * @param sender Service the key events are posted as
+ * @return ESP_OK, also when no key GPIO is configured
+ */
+esp_err_t input_keys_init(system_service_id_t sender);
+
+esp_err_t input_keys_enable(void);
+
+esp_err_t input_keys_disable(void);
+
+void input_keys_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INPUT_KEYS_H
@@ -0,0 +1,313 @@
+#include "input_keys.h"
+#include "system_service/event_bus.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "input_keys";
+
+#define DEBOUNCE_US         ((int64_t)CONFIG_INPUT_DEBOUNCE_MS * 1000)
+#define LONG_PRESS_US       ((int64_t)CONFIG_INPUT_LONG_PRESS_MS * 1000)
+#define REPEAT_US           ((int64_t)CONFIG_INPUT_REPEAT_MS * 1000)
+
+#if CONFIG_INPUT_KEY_ACTIVE_LOW
+#define KEY_ACTIVE_LEVEL    0
+#else
+#define KEY_ACTIVE_LEVEL    1
+#endif
+
+_Static_assert(CONFIG_INPUT_LONG_PRESS_MS > CONFIG_INPUT_DEBOUNCE_MS,
+               "Long press must outlast the debounce time");
+
+/* What the key's timer is counting down to */
+typedef enum {
+    KEY_PHASE_IDLE = 0,
+    KEY_PHASE_DEBOUNCE,             // Edges ignored until the contacts settle
+    KEY_PHASE_HOLD,                 // Waiting for the long press
+    KEY_PHASE_REPEAT,
+} key_phase_t;
+
+typedef struct {
+    int gpio;                       // -1 if not fitted
+    esp_timer_handle_t timer;
+    portMUX_TYPE lock;              // GPIO ISR against the timer task
+    key_phase_t phase;
+    bool pressed;
+    uint16_t repeat;
+    int64_t press_us;
+    int64_t due_us;                 // Current phase ends; stale timer runs are dropped
+} key_state_t;
+
+typedef struct {
+    key_state_t keys[INPUT_KEY_COUNT];
+    system_service_id_t sender;
+} input_keys_t;
+
+static input_keys_t s_keys = {
+    .keys = {
+        [INPUT_KEY_LEFT] = { .gpio = CONFIG_INPUT_KEY_LEFT_GPIO },
+        [INPUT_KEY_RIGHT] = { .gpio = CONFIG_INPUT_KEY_RIGHT_GPIO },
+        [INPUT_KEY_UP] = { .gpio = CONFIG_INPUT_KEY_UP_GPIO },
+        [INPUT_KEY_DOWN] = { .gpio = CONFIG_INPUT_KEY_DOWN_GPIO },
+        [INPUT_KEY_SELECT] = { .gpio = CONFIG_INPUT_KEY_SELECT_GPIO },
+    },
+};
+
+/* ============================================================================
+ * Key State Machine
+ * ============================================================================ */
+
+/* Enter a timed phase; lock held */
+static void IRAM_ATTR key_schedule(key_state_t *key, key_phase_t phase, int64_t after_us, int64_t now_us)
+{
+    key->phase = phase;
+    key->due_us = now_us + after_us;
+    esp_timer_stop(key->timer);
+    esp_timer_start_once(key->timer, after_us);
+}
+
+static void IRAM_ATTR key_event_fill(const key_state_t *key, input_key_action_t action,
+                                     int64_t now_us, input_key_event_t *event)
+{
+    event->key = (uint8_t)(key - s_keys.keys);
+    event->action = action;
+    event->repeat = key->repeat;
+    event->held_ms = (action == INPUT_KEY_ACTION_PRESS) ? 0 :
+                     (uint32_t)((now_us - key->press_us) / 1000);
+}
+
+static system_event_type_t IRAM_ATTR key_event_topic(const input_key_event_t *event)
+{
+    return (event->action == INPUT_KEY_ACTION_RELEASE) ?
+           INPUT_EVENT_KEY_RELEASED : (system_event_type_t)(INPUT_EVENT_KEY_LEFT_PRESSED + event->key);
+}
+
+/*
+ * Leading-edge debounce: the first edge is reported right away and the
+ * key then ignores its pin until the debounce timer has run, so the
+ * latency is that of the interrupt, not of the debounce time.
+ */
+static void IRAM_ATTR key_isr_handler(void *arg)
+{
+    key_state_t *key = (key_state_t *)arg;
+    int64_t now_us = esp_timer_get_time();
+    bool report = false;
+    input_key_event_t event;
+
+    portENTER_CRITICAL_ISR(&key->lock);
+    if (key->phase != KEY_PHASE_DEBOUNCE) {
+        bool pressed = gpio_get_level(key->gpio) == KEY_ACTIVE_LEVEL;
+        if (pressed != key->pressed) {
+            key->pressed = pressed;
+            if (pressed) {
+                key->press_us = now_us;
+                key->repeat = 0;
+            }
+            key_event_fill(key, pressed ? INPUT_KEY_ACTION_PRESS : INPUT_KEY_ACTION_RELEASE,
+                           now_us, &event);
+            report = true;
+        }
+        key_schedule(key, KEY_PHASE_DEBOUNCE, DEBOUNCE_US, now_us);
+    }
+    portEXIT_CRITICAL_ISR(&key->lock);
+
+    if (report) {
+        BaseType_t woken = pdFALSE;
+        system_event_post_from_isr(s_keys.sender, key_event_topic(&event), &event, sizeof(event),
+                                   SYSTEM_EVENT_PRIORITY_HIGH, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+/* Runs in the esp_timer task at the end of each phase */
+static void key_timer_cb(void *arg)
+{
+    key_state_t *key = (key_state_t *)arg;
+    int64_t now_us = esp_timer_get_time();
+    bool report = false;
+    input_key_event_t event;
+
+    portENTER_CRITICAL(&key->lock);
+    if (now_us < key->due_us) {
+        // The ISR moved the deadline after this run was dispatched
+        portEXIT_CRITICAL(&key->lock);
+        return;
+    }
+
+    switch (key->phase) {
+    case KEY_PHASE_DEBOUNCE: {
+        // An edge lost while ignoring the pin shows up as a level change
+        bool pressed = gpio_get_level(key->gpio) == KEY_ACTIVE_LEVEL;
+        if (pressed != key->pressed) {
+            key->pressed = pressed;
+            if (pressed) {
+                key->press_us = now_us;
+                key->repeat = 0;
+            }
+            key_event_fill(key, pressed ? INPUT_KEY_ACTION_PRESS : INPUT_KEY_ACTION_RELEASE,
+                           now_us, &event);
+            report = true;
+            key_schedule(key, KEY_PHASE_DEBOUNCE, DEBOUNCE_US, now_us);
+        } else if (pressed) {
+            int64_t hold_us = key->press_us + LONG_PRESS_US - now_us;
+            key_schedule(key, KEY_PHASE_HOLD, hold_us > 0 ? hold_us : 0, now_us);
+        } else {
+            key->phase = KEY_PHASE_IDLE;
+        }
+        break;
+    }
+
+    case KEY_PHASE_HOLD:
+        key_event_fill(key, INPUT_KEY_ACTION_LONG_PRESS, now_us, &event);
+        report = true;
+        if (REPEAT_US > 0) {
+            key_schedule(key, KEY_PHASE_REPEAT, REPEAT_US, now_us);
+        } else {
+            key->phase = KEY_PHASE_IDLE;
+        }
+        break;
+
+    case KEY_PHASE_REPEAT:
+        key->repeat++;
+        key_event_fill(key, INPUT_KEY_ACTION_REPEAT, now_us, &event);
+        report = true;
+        key_schedule(key, KEY_PHASE_REPEAT, REPEAT_US, now_us);
+        break;
+
+    case KEY_PHASE_IDLE:
+        break;
+    }
+    portEXIT_CRITICAL(&key->lock);
+
+    if (report) {
+        system_event_post(s_keys.sender, key_event_topic(&event), &event, sizeof(event),
+                          SYSTEM_EVENT_PRIORITY_HIGH);
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t input_keys_init(system_service_id_t sender)
+{
+    s_keys.sender = sender;
+
+    uint64_t pin_mask = 0;
+    for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+        if (s_keys.keys[i].gpio >= 0) {
+            pin_mask |= 1ULL << s_keys.keys[i].gpio;
+        }
+    }
+    if (pin_mask == 0) {
+        ESP_LOGW(TAG, "No key GPIOs configured");
+        return ESP_OK;
+    }
+
+    const gpio_config_t key_gpio_config = {
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = pin_mask,
+        .pull_up_en = KEY_ACTIVE_LEVEL == 0 ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = KEY_ACTIVE_LEVEL == 0 ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    esp_err_t ret = gpio_config(&key_gpio_config);
+    if (ret == ESP_OK) {
+        // Another driver may have installed the ISR service already
+        ret = gpio_install_isr_service(0);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ret = ESP_OK;
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Key GPIO setup failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    int count = 0;
+    for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+        key_state_t *key = &s_keys.keys[i];
+        if (key->gpio < 0) {
+            continue;
+        }
+
+        portMUX_INITIALIZE(&key->lock);
+        key->phase = KEY_PHASE_IDLE;
+        key->pressed = false;
+        gpio_intr_disable(key->gpio);
+
+        const esp_timer_create_args_t timer_args = {
+            .callback = key_timer_cb,
+            .arg = key,
+            .name = "input_key",
+        };
+        ret = esp_timer_create(&timer_args, &key->timer);
+        if (ret == ESP_OK) {
+            ret = gpio_isr_handler_add(key->gpio, key_isr_handler, key);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Key %d on GPIO %d failed: %s", i, key->gpio, esp_err_to_name(ret));
+            input_keys_deinit();
+            return ret;
+        }
+        count++;
+    }
+
+    ESP_LOGI(TAG, "✓ %d keys, %d ms debounce, long press %d ms, repeat %d ms",
+             count, CONFIG_INPUT_DEBOUNCE_MS, CONFIG_INPUT_LONG_PRESS_MS, CONFIG_INPUT_REPEAT_MS);
+    return ESP_OK;
+}
+
+esp_err_t input_keys_enable(void)
+{
+    for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+        key_state_t *key = &s_keys.keys[i];
+        if (key->timer == NULL) {
+            continue;
+        }
+
+        // A key already down at start is reported like any other press
+        portENTER_CRITICAL(&key->lock);
+        key->pressed = false;
+        key_schedule(key, KEY_PHASE_DEBOUNCE, DEBOUNCE_US, esp_timer_get_time());
+        portEXIT_CRITICAL(&key->lock);
+        gpio_intr_enable(key->gpio);
+    }
+    return ESP_OK;
+}
+
+esp_err_t input_keys_disable(void)
+{
+    for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+        key_state_t *key = &s_keys.keys[i];
+        if (key->timer == NULL) {
+            continue;
+        }
+
+        gpio_intr_disable(key->gpio);
+        portENTER_CRITICAL(&key->lock);
+        esp_timer_stop(key->timer);
+        key->phase = KEY_PHASE_IDLE;
+        portEXIT_CRITICAL(&key->lock);
+    }
+    return ESP_OK;
+}
+
+void input_keys_deinit(void)
+{
+    input_keys_disable();
+
+    for (int i = 0; i < INPUT_KEY_COUNT; i++) {
+        key_state_t *key = &s_keys.keys[i];
+        if (key->timer == NULL) {
+            continue;
+        }
+        gpio_isr_handler_remove(key->gpio);
+        esp_timer_delete(key->timer);
+        key->timer = NULL;
+    }
+}
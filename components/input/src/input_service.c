@@ -1,4 +1,5 @@
 #include "input_service.h"
+#include "input_keys.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
@@ -7,8 +8,9 @@
 
 static const char *TAG = "input_service";
 
+SYSTEM_EVENT_SCHEMA_DEFINE(INPUT_EVENT_SCHEMA, INPUT_EVENT);
+
 static system_service_id_t input_service_id = 0;
-static system_event_type_t input_events[5];
 static bool initialized = false;
 
 esp_err_t input_service_init(void)
@@ -31,23 +33,20 @@ esp_err_t input_service_init(void)
 
     ESP_LOGI(TAG, "✓ Registered with system service (ID: %d)", input_service_id);
 
-    const char *event_names[] = {
-        "input.key_left_pressed",
-        "input.key_right_pressed",
-        "input.key_up_pressed",
-        "input.key_down_pressed",
-        "input.key_select_pressed"
-    };
-
-    for (int i = 0; i < 5; i++) {
-        ret = system_event_register_type(event_names[i], &input_events[i]);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to register event type '%s'", event_names[i]);
-            return ret;
-        }
+    ret = SYSTEM_EVENT_SCHEMA_REGISTER(INPUT_EVENT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register event types: %s", esp_err_to_name(ret));
+        return ret;
     }
 
-    ESP_LOGI(TAG, "✓ Registered %d event types", 5);
+    ESP_LOGI(TAG, "✓ Registered %d event types", INPUT_EVENT_COUNT);
+
+    ret = input_keys_init(input_service_id);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize keys");
+        system_service_unregister(input_service_id);
+        return ret;
+    }
 
     // Set service state
     system_service_set_state(input_service_id, SYSTEM_SERVICE_STATE_REGISTERED);
@@ -68,6 +67,7 @@ esp_err_t input_service_deinit(void)
 
     ESP_LOGI(TAG, "Deinitializing input service...");
 
+    input_keys_deinit();
     system_service_unregister(input_service_id);
     initialized = false;
 
@@ -84,6 +84,7 @@ esp_err_t input_service_start(void)
 
     ESP_LOGI(TAG, "Starting input service...");
 
+    input_keys_enable();
     system_service_set_state(input_service_id, SYSTEM_SERVICE_STATE_RUNNING);
 
     ESP_LOGI(TAG, "✓ Input service started");
@@ -99,6 +100,7 @@ esp_err_t input_service_stop(void)
 
     ESP_LOGI(TAG, "Stopping input service...");
 
+    input_keys_disable();
     system_service_set_state(input_service_id, SYSTEM_SERVICE_STATE_STOPPING);
 
     ESP_LOGI(TAG, "✓ Input service stopped");
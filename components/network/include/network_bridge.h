@@ -0,0 +1,104 @@
+/**
+ * @file network_bridge.h
+ * @brief Event bus bridge between units over ESP-NOW
+ *
+ * Forwards shared event types to the other units in radio range and
+ * posts theirs on the local bus, without an access point or broker.
+ * Events are only sent while some peer has advertised subscribers for
+ * their type, and the events posted within CONFIG_NETWORK_BRIDGE_BATCH_MS
+ * of each other travel in one frame.
+ *
+ * Every CONFIG_NETWORK_BRIDGE_ADVERT_MS a unit broadcasts an advert with
+ * the name hashes of the shared types it has subscribers for. A peer not
+ * heard from for three advert intervals is forgotten. Types are matched
+ * by name hash, so units need not register them in the same order.
+ *
+ * Events are posted locally with the bridge as sender and never sent on
+ * again, so frames don't loop between units. A frame heard twice is
+ * delivered once: each record carries a sequence the sending bridge
+ * counts in send order, and every peer has a window of the last 32 it
+ * delivered. A new boot_id in a peer's header means it restarted, and
+ * its window starts over.
+ *
+ * Wire format, little endian: a network_bridge_header_t followed by
+ * `count` records. An EVENTS record is a network_bridge_record_t and
+ * `length` payload bytes, an ADVERT record a uint32_t name hash.
+ */
+
+#ifndef NETWORK_BRIDGE_H
+#define NETWORK_BRIDGE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NETWORK_BRIDGE_MAGIC        0x424B  // "KB"
+#define NETWORK_BRIDGE_VERSION      2
+#define NETWORK_BRIDGE_MAX_TOPICS   32      // Shared types, one bit each in a peer's interest
+
+typedef enum {
+    NETWORK_BRIDGE_FRAME_EVENTS = 1,        // network_bridge_record_t + payload per event
+    NETWORK_BRIDGE_FRAME_ADVERT,            // Name hash per type with subscribers
+} network_bridge_frame_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t type;                   // network_bridge_frame_type_t
+    uint8_t count;                  // Records that follow
+    uint8_t reserved;
+    uint32_t boot_id;               // Random, new each time the sender's bridge starts
+} network_bridge_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t name_hash;             // system_event_name_hash() of the type name
+    uint32_t sequence;              // Sender's bridge counts one per record sent
+    uint8_t priority;               // system_event_priority_t
+    uint8_t length;                 // Payload bytes that follow
+} network_bridge_record_t;
+
+typedef struct {
+    uint32_t frames_sent;
+    uint32_t frames_received;
+    uint32_t events_sent;
+    uint32_t events_received;
+    uint32_t duplicates;            // Received again and dropped
+    uint32_t dropped;               // Too large, or no room to queue or post
+    uint32_t send_errors;
+    uint8_t peers;                  // Units heard from recently
+} network_bridge_stats_t;
+
+/**
+ * @brief Start ESP-NOW and share the types in CONFIG_NETWORK_BRIDGE_TOPICS
+ *
+ * Called by network_service_start() when CONFIG_NETWORK_BRIDGE is set.
+ * Units only hear each other on the same channel, which is the access
+ * point's while connected.
+ */
+esp_err_t network_bridge_start(void);
+
+esp_err_t network_bridge_stop(void);
+
+/**
+ * @brief Bridge an event type in both directions
+ *
+ * Registers the type if needed. Payloads are limited to what fits one
+ * frame next to the headers; larger events are not sent.
+ *
+ * @param event_name Type name
+ * @return ESP_OK on success, also if already shared, ESP_ERR_INVALID_STATE
+ *         if the bridge is not running, ESP_ERR_NO_MEM with
+ *         NETWORK_BRIDGE_MAX_TOPICS types shared
+ */
+esp_err_t network_bridge_share(const char *event_name);
+
+esp_err_t network_bridge_get_stats(network_bridge_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETWORK_BRIDGE_H
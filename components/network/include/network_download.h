@@ -0,0 +1,81 @@
+/**
+ * @file network_download.h
+ * @brief Streaming HTTP(S) download of apps and firmware straight into flash
+ *
+ * The payload is received into one of two sector-aligned buffers while the
+ * other is hashed and written to flash, so the radio and the flash work in
+ * parallel and nothing larger than two chunks is ever held in RAM. A
+ * dropped connection is resumed with an HTTP Range request from the last
+ * byte received.
+ *
+ * Progress is published as "network.download_progress" (latest value only)
+ * and the outcome as "network.download_done", both carrying a
+ * network_download_status_t.
+ */
+
+#ifndef NETWORK_DOWNLOAD_H
+#define NETWORK_DOWNLOAD_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NETWORK_DOWNLOAD_URL_MAX_LEN 256
+
+typedef enum {
+    NETWORK_DOWNLOAD_IDLE = 0,
+    NETWORK_DOWNLOAD_RUNNING,
+    NETWORK_DOWNLOAD_RESUMING,      // Connection lost, reconnecting
+    NETWORK_DOWNLOAD_DONE,
+    NETWORK_DOWNLOAD_FAILED,
+} network_download_state_t;
+
+typedef struct {
+    const char *url;                // http:// or https://, copied
+    const char *partition_label;    // Target partition, NULL for the next OTA slot
+    size_t offset;                  // Within the partition, sector aligned; 0 for OTA
+    const char *cert_pem;           // NULL to use the certificate bundle; must outlive the download
+    const uint8_t *sha256;          // Expected SHA-256, NULL to skip the check
+    uint32_t crc32;                 // Expected CRC-32 (e.g. app_header_t.crc32), 0 to skip
+    bool set_boot_partition;        // OTA only: boot the new image on next reset
+} network_download_config_t;
+
+typedef struct {
+    network_download_state_t state;
+    esp_err_t result;               // Why a download failed
+    uint32_t received;              // Bytes received so far
+    uint32_t written;               // Bytes in flash so far
+    uint32_t total;                 // From Content-Length
+    uint32_t bytes_per_s;           // Average since the start
+    uint32_t retries;               // Resumed connections
+    uint32_t crc32;                 // Of the whole payload, once done
+    uint8_t sha256[32];             // Of the whole payload, once done
+} network_download_status_t;
+
+// Register the download topics; called by network_service_init()
+esp_err_t network_download_init(void);
+
+/**
+ * @brief Start downloading in the background
+ *
+ * @param config Source, target and expected digests
+ * @return ESP_OK if started, ESP_ERR_INVALID_STATE if a download is running,
+ *         ESP_ERR_NOT_FOUND if the target partition does not exist
+ */
+esp_err_t network_download_start(const network_download_config_t *config);
+
+// Stop the running download; it finishes as FAILED with ESP_ERR_INVALID_STATE
+esp_err_t network_download_abort(void);
+
+esp_err_t network_download_get_status(network_download_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETWORK_DOWNLOAD_H
@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include "system_service/system_types.h"
+#include "system_service/event_schema.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,18 +13,6 @@ extern "C" {
 #define NETWORK_SSID_MAX_LEN 33
 #define NETWORK_PASSWORD_MAX_LEN 64
 
-typedef enum {
-    NETWORK_EVENT_REGISTERED = 0,
-    NETWORK_EVENT_STARTED,
-    NETWORK_EVENT_STOPPED,
-    NETWORK_EVENT_CONNECTED,
-    NETWORK_EVENT_DISCONNECTED,
-    NETWORK_EVENT_IP_ASSIGNED,
-    NETWORK_EVENT_IP_LOST,
-    NETWORK_EVENT_SCAN_DONE,
-    NETWORK_EVENT_ERROR,
-} network_event_id_t;
-
 typedef enum {
     NETWORK_AUTH_OPEN = 0,
     NETWORK_AUTH_WEP,
@@ -39,6 +28,7 @@ typedef struct {
     uint8_t channel;
     network_auth_mode_t auth_mode;
     bool connected;
+    uint8_t bars;                   // Signal 0-3 from the smoothed RSSI, with hysteresis
 } network_wifi_info_t;
 
 typedef struct {
@@ -50,13 +40,50 @@ typedef struct {
 typedef struct {
     network_wifi_info_t wifi;
     network_ip_info_t ip_info;
+    uint32_t time_to_ip_ms;         // Connect request to IP for this link
+    bool fast_reconnect;            // Joined through the cached BSSID/channel
 } network_connection_event_t;
 
+// Radio power profiles, most to least power hungry
+typedef enum {
+    NETWORK_POWER_PERFORMANCE = 0,  // No modem sleep: lowest latency
+    NETWORK_POWER_BALANCED,         // Modem sleep, wakes for every DTIM beacon
+    NETWORK_POWER_MAX_MODEM,        // Modem sleep, wakes every listen interval
+    NETWORK_POWER_PROFILE_COUNT,
+} network_power_profile_t;
+
+typedef struct {
+    network_power_profile_t profile;
+    uint32_t switches;
+    uint64_t time_ms[NETWORK_POWER_PROFILE_COUNT];  // Including the current stretch
+} network_power_stats_t;
+
+// Strongest networks first, one entry per SSID. Each payload is the whole
+// list, so a subscriber that missed a coalesced update is still in sync.
 typedef struct {
     network_wifi_info_t networks[NETWORK_MAX_SCAN_RESULTS];
     uint16_t count;
+    bool complete;                  // false while channels are still being scanned
 } network_scan_result_t;
 
+// Network events. Partial scans and the power profile are state, so only the
+// newest matters to a slow subscriber; scans are posted as loans.
+#define NETWORK_EVENT_SCHEMA(X) \
+    X(NETWORK_EVENT_REGISTERED,         "network.registered",        system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_STARTED,            "network.started",           system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_STOPPED,            "network.stopped",           system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_CONNECTED,          "network.connected",         network_connection_event_t, 1, QUEUED) \
+    X(NETWORK_EVENT_DISCONNECTED,       "network.disconnected",      system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_IP_ASSIGNED,        "network.ip_assigned",       network_ip_info_t,          1, QUEUED) \
+    X(NETWORK_EVENT_IP_LOST,            "network.ip_lost",           system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_SCAN_DONE,          "network.scan_done",         network_scan_result_t,      1, QUEUED) \
+    X(NETWORK_EVENT_ERROR,              "network.error",             system_event_no_payload_t,  1, QUEUED) \
+    X(NETWORK_EVENT_SCAN_UPDATE,        "network.scan_update",       network_scan_result_t,      1, LATEST) \
+    X(NETWORK_EVENT_POWER_PROFILE,      "network.power_profile",     network_power_profile_t,    1, LATEST) \
+    X(NETWORK_EVENT_SET_POWER_PROFILE,  "network.set_power_profile", network_power_profile_t,    1, QUEUED)
+
+SYSTEM_EVENT_SCHEMA_DECLARE(NETWORK_EVENT_SCHEMA, NETWORK_EVENT, SYSTEM_EVENT_RANGE_NETWORK);
+
 // Service lifecycle
 esp_err_t network_service_init(void);
 esp_err_t network_service_deinit(void);
@@ -64,9 +91,65 @@ esp_err_t network_service_start(void);
 esp_err_t network_service_stop(void);
 
 // WiFi management
+
+/**
+ * @brief Start a streaming scan, one channel at a time
+ *
+ * Every channel's networks are merged into the results and published as
+ * NETWORK_EVENT_SCAN_UPDATE, the final list as NETWORK_EVENT_SCAN_DONE.
+ * Both carry a network_scan_result_t. Does not block.
+ *
+ * Within CONFIG_NETWORK_SERVICE_SCAN_CACHE_TTL_S of the last complete scan
+ * the cached results are published as NETWORK_EVENT_SCAN_DONE right away
+ * and the radio is not used.
+ *
+ * @return ESP_OK if started or already running
+ */
+esp_err_t network_scan_start(void);
+
+// Copy the results so far; result->complete tells whether the scan finished
+esp_err_t network_scan_get_results(network_scan_result_t *result);
+
+// Scan and wait for the final results (up to 15 s); never from the LVGL task
 esp_err_t network_scan_wifi(network_scan_result_t *result);
+
+/**
+ * @brief Join a network
+ *
+ * Goes straight to the cached BSSID and channel if this network got an IP
+ * before, and falls back to a full scan if that fails. password may be
+ * NULL for an open network or one with a cached PMK.
+ */
 esp_err_t network_connect_wifi(const char *ssid, const char *password);
+
+// Rejoin the most recently used network; ESP_ERR_NOT_FOUND if there is none
+esp_err_t network_connect_last(void);
+
+/**
+ * @brief Turn rejoining the last network at start and on link loss on or off
+ *
+ * Persisted as the "net.autojoin" setting; without
+ * CONFIG_NETWORK_SERVICE_AUTO_RECONNECT the service never rejoins.
+ */
+esp_err_t network_set_auto_reconnect(bool enable);
+
+bool network_get_auto_reconnect(void);
+
 esp_err_t network_disconnect_wifi(void);
+
+/**
+ * @brief Switch the radio power profile
+ *
+ * Takes effect immediately and is announced as NETWORK_EVENT_POWER_PROFILE.
+ * Posting NETWORK_EVENT_SET_POWER_PROFILE does the same from anywhere; the
+ * power service uses it to follow battery and screen state. The listen
+ * interval of NETWORK_POWER_MAX_MODEM is negotiated when joining, from
+ * CONFIG_NETWORK_SERVICE_LISTEN_INTERVAL.
+ */
+esp_err_t network_wifi_set_power_profile(network_power_profile_t profile);
+network_power_profile_t network_wifi_get_power_profile(void);
+esp_err_t network_wifi_get_power_stats(network_power_stats_t *stats);
+
 esp_err_t network_get_status(network_connection_event_t *status);
 bool network_is_connected(void);
 
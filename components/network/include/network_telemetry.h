@@ -0,0 +1,162 @@
+/**
+ * @file network_telemetry.h
+ * @brief Binary telemetry frames over UDP
+ *
+ * Every CONFIG_NETWORK_TELEMETRY_INTERVAL_MS a low-priority task packs the
+ * system metrics, event queue, memory pool and heap counters into one UDP
+ * datagram for a collector. The frame is built in static storage: sending
+ * allocates nothing and formats no text.
+ *
+ * Wire format, little endian: a network_telemetry_header_t followed by
+ * sections, each a network_telemetry_section_t and `count` records of the
+ * section's record type. Unknown sections can be skipped by `length`.
+ */
+
+#ifndef NETWORK_TELEMETRY_H
+#define NETWORK_TELEMETRY_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NETWORK_TELEMETRY_MAGIC     0x314C544B  // "KTL1"
+#define NETWORK_TELEMETRY_VERSION   1
+
+typedef enum {
+    NETWORK_TELEMETRY_SECTION_GLOBAL = 1,   // One network_telemetry_global_t
+    NETWORK_TELEMETRY_SECTION_QUEUE,        // One network_telemetry_queue_t
+    NETWORK_TELEMETRY_SECTION_HEAP,         // One network_telemetry_heap_t
+    NETWORK_TELEMETRY_SECTION_POOLS,        // network_telemetry_pool_t per size class
+    NETWORK_TELEMETRY_SECTION_SERVICES,     // network_telemetry_service_t per service
+    NETWORK_TELEMETRY_SECTION_NAMES,        // network_telemetry_name_t per service, every few frames
+} network_telemetry_section_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;                // Whole frame, header included
+    uint32_t sequence;              // Gaps are lost frames
+    uint32_t uptime_ms;
+    uint8_t device[6];              // Station MAC
+    uint8_t section_count;
+    uint8_t reserved;
+} network_telemetry_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;                   // network_telemetry_section_type_t
+    uint8_t count;                  // Records that follow
+    uint16_t length;                // Bytes of records that follow
+} network_telemetry_section_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t total_services;
+    uint8_t running_services;
+    uint8_t error_services;
+    uint8_t reserved;
+    uint32_t events_processed;
+    uint32_t avg_event_latency_us;
+    uint32_t max_event_latency_us;
+    uint32_t queue_depth;
+    uint32_t queue_overflows;
+    uint32_t service_restarts;
+    uint32_t watchdog_timeouts;
+} network_telemetry_global_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t depth[3];              // High, normal, low
+    uint16_t reserved;
+    uint32_t overflows[3];
+    uint32_t low_priority_drops;
+    uint32_t total_queued;
+    uint32_t total_processed;
+} network_telemetry_queue_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t internal_free;
+    uint32_t internal_largest;
+    uint32_t internal_min_free;
+    uint32_t psram_free;
+    uint32_t psram_largest;
+    uint32_t psram_min_free;
+} network_telemetry_heap_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t pool_size;
+    uint16_t blocks_used;
+    uint16_t high_water_mark;
+    uint16_t reserved;
+    uint32_t allocations;
+    uint32_t failures;
+} network_telemetry_pool_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t service_id;
+    uint8_t state;                  // system_service_state_t
+    uint16_t handler_timeouts;
+    uint32_t events_posted;
+    uint32_t events_received;
+    uint32_t avg_handler_us;
+    uint32_t max_handler_us;
+    uint32_t quota_violations;
+    uint32_t memory_bytes;
+} network_telemetry_service_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t service_id;
+    char name[15];                  // Truncated, NUL padded
+} network_telemetry_name_t;
+
+typedef struct {
+    uint32_t frames_sent;
+    uint32_t send_errors;
+    uint32_t last_frame_bytes;
+} network_telemetry_stats_t;
+
+/**
+ * @brief Start sending frames to CONFIG_NETWORK_TELEMETRY_HOST
+ *
+ * Called by network_service_start() when CONFIG_NETWORK_TELEMETRY is set.
+ * Frames are only sent while WiFi is connected.
+ */
+esp_err_t network_telemetry_start(void);
+
+esp_err_t network_telemetry_stop(void);
+
+esp_err_t network_telemetry_get_stats(network_telemetry_stats_t *stats);
+
+/**
+ * @brief Send a system trace dump to a TCP listener
+ * 
+ * Connects to host:port, streams system_trace_dump() and closes the
+ * connection; `tools/trace2json.py --listen PORT` receives it. Independent
+ * of CONFIG_NETWORK_TELEMETRY.
+ * 
+ * @param host Collector address or host name
+ * @param port Collector TCP port
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_SYSTEM_SERVICE_TRACE, ESP_ERR_INVALID_STATE if WiFi is
+ *         down, ESP_FAIL if the host can't be reached
+ */
+esp_err_t network_telemetry_upload_trace(const char *host, uint16_t port);
+
+/**
+ * @brief Send the flight recorder's log to a TCP listener
+ * 
+ * Like network_telemetry_upload_trace(), with flight_recorder_read();
+ * `tools/trace2json.py --listen PORT` takes either dump.
+ * 
+ * @param minutes Last minutes of uptime to send, 0 for the whole log
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER, ESP_ERR_INVALID_STATE if
+ *         WiFi is down, ESP_FAIL if the host can't be reached
+ */
+esp_err_t network_telemetry_upload_flight(const char *host, uint16_t port, uint32_t minutes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETWORK_TELEMETRY_H
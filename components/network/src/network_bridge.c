@@ -0,0 +1,741 @@
+#include "network_bridge.h"
+#include "system_service/service_manager.h"
+#include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_now.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "network_bridge";
+
+#if CONFIG_NETWORK_BRIDGE
+
+/* Outgoing events are packed into s_br.tx by the handlers on the dispatch
+ * workers; the bridge task sends the frame once it is full or has waited
+ * CONFIG_NETWORK_BRIDGE_BATCH_MS. Received frames are copied out of the
+ * WiFi task into s_br.rx and decoded on the bridge task. */
+#define BRIDGE_FRAME_MAX        ESP_NOW_MAX_DATA_LEN
+#define BRIDGE_RECORD_MAX       (BRIDGE_FRAME_MAX - sizeof(network_bridge_header_t) - \
+                                 sizeof(network_bridge_record_t))
+#define BRIDGE_RX_DEPTH         8
+#define BRIDGE_TASK_STACK       3072
+#define BRIDGE_PEER_TTL_US      (3LL * CONFIG_NETWORK_BRIDGE_ADVERT_MS * 1000)
+#define BRIDGE_DEDUP_WINDOW     32          // Bits of bridge_peer_t.seen
+#define BRIDGE_PRIORITY_MAX     SYSTEM_EVENT_PRIORITY_HIGH  // For events from peers
+
+typedef struct {
+    system_event_type_t event_type;
+    uint32_t name_hash;
+    volatile bool ready;            // Subscribed, readable by the bridge task
+} bridge_topic_t;
+
+typedef struct {
+    uint8_t mac[6];
+    bool active;
+    bool synced;                    // highest_seq holds a received sequence
+    uint32_t boot_id;               // From the peer's last header
+    int64_t last_seen_us;
+    uint32_t interest;              // Bit per topic the peer has subscribers for
+    uint32_t highest_seq;
+    uint32_t seen;                  // Bit n: highest_seq - n was delivered
+} bridge_peer_t;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t len;
+    uint8_t data[BRIDGE_FRAME_MAX];
+} bridge_rx_t;
+
+typedef struct {
+    volatile bool running;
+    system_service_id_t service_id;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped;
+    QueueHandle_t rx;
+    
+    bridge_topic_t topics[NETWORK_BRIDGE_MAX_TOPICS];
+    uint8_t topic_count;
+    portMUX_TYPE topic_lock;
+    
+    // Only touched by the bridge task, except remote_interest
+    bridge_peer_t peers[CONFIG_NETWORK_BRIDGE_MAX_PEERS];
+    volatile uint32_t remote_interest;  // Interest of every live peer
+    
+    uint32_t boot_id;
+    
+    portMUX_TYPE tx_lock;
+    uint32_t tx_sequence;           // Last record sequence, in batch order
+    uint8_t tx[BRIDGE_FRAME_MAX];
+    size_t tx_len;
+    uint8_t tx_count;
+    int64_t tx_first_us;
+    
+    network_bridge_stats_t stats;
+} bridge_t;
+
+static bridge_t s_br = {
+    .service_id = SYSTEM_SERVICE_ID_INVALID,
+    .topic_lock = portMUX_INITIALIZER_UNLOCKED,
+    .tx_lock = portMUX_INITIALIZER_UNLOCKED,
+    .tx_len = sizeof(network_bridge_header_t),
+};
+
+static const uint8_t s_broadcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+// Static storage, the bridge task decodes one frame at a time
+static bridge_rx_t s_rx_frame;
+
+SYSTEM_TASK_DEFINE(s_bridge_task, BRIDGE_TASK_STACK);
+SYSTEM_SEMAPHORE_DEFINE(s_bridge_stopped);
+SYSTEM_QUEUE_DEFINE(s_bridge_rx, BRIDGE_RX_DEPTH, sizeof(bridge_rx_t));
+
+#define STAT_ADD(field, n)      __atomic_add_fetch(&s_br.stats.field, (n), __ATOMIC_RELAXED)
+
+static void write_header(uint8_t *frame, network_bridge_frame_type_t type, uint8_t count)
+{
+    network_bridge_header_t header = {
+        .magic = NETWORK_BRIDGE_MAGIC,
+        .version = NETWORK_BRIDGE_VERSION,
+        .type = type,
+        .count = count,
+        .boot_id = s_br.boot_id,
+    };
+    memcpy(frame, &header, sizeof(header));
+}
+
+static void send_frame(const uint8_t *frame, size_t len, uint8_t events)
+{
+    if (esp_now_send(s_broadcast, frame, len) != ESP_OK) {
+        STAT_ADD(send_errors, 1);
+        return;
+    }
+    STAT_ADD(frames_sent, 1);
+    STAT_ADD(events_sent, events);
+}
+
+/* Move the pending batch to out; called with tx_lock held, 0 if empty */
+static size_t batch_take_locked(uint8_t *out, uint8_t *out_count)
+{
+    if (s_br.tx_count == 0) {
+        return 0;
+    }
+    
+    write_header(s_br.tx, NETWORK_BRIDGE_FRAME_EVENTS, s_br.tx_count);
+    size_t len = s_br.tx_len;
+    memcpy(out, s_br.tx, len);
+    *out_count = s_br.tx_count;
+    
+    s_br.tx_len = sizeof(network_bridge_header_t);
+    s_br.tx_count = 0;
+    return len;
+}
+
+/* Send the batch if it has waited long enough; bridge task */
+static void batch_flush_due(int64_t now_us)
+{
+    static uint8_t frame[BRIDGE_FRAME_MAX];
+    uint8_t count = 0;
+    size_t len = 0;
+    
+    portENTER_CRITICAL(&s_br.tx_lock);
+    if (s_br.tx_count > 0 &&
+        now_us - s_br.tx_first_us >= CONFIG_NETWORK_BRIDGE_BATCH_MS * 1000LL) {
+        len = batch_take_locked(frame, &count);
+    }
+    portEXIT_CRITICAL(&s_br.tx_lock);
+    
+    if (len > 0) {
+        send_frame(frame, len, count);
+    }
+}
+
+/* Time until the batch is due, or the fallback if nothing is pending */
+static int64_t batch_due_in_us(int64_t now_us, int64_t fallback_us)
+{
+    int64_t due_us = fallback_us;
+    
+    portENTER_CRITICAL(&s_br.tx_lock);
+    if (s_br.tx_count > 0) {
+        int64_t left = s_br.tx_first_us + CONFIG_NETWORK_BRIDGE_BATCH_MS * 1000LL - now_us;
+        if (left < due_us) {
+            due_us = left;
+        }
+    }
+    portEXIT_CRITICAL(&s_br.tx_lock);
+    
+    return due_us;
+}
+
+/* Runs on the event task: only events some peer listens for, and never our own posts */
+static bool remote_wants(const system_event_t *event, void *user_data)
+{
+    uint32_t bit = 1u << (uintptr_t)user_data;
+    return event->sender_id != s_br.service_id &&
+           (__atomic_load_n(&s_br.remote_interest, __ATOMIC_RELAXED) & bit) != 0;
+}
+
+static void forward_handler(const system_event_t *event, void *user_data)
+{
+    if (!s_br.running) {
+        return;
+    }
+    
+    const bridge_topic_t *topic = &s_br.topics[(uintptr_t)user_data];
+    size_t size = (event->data != NULL) ? event->data_size : 0;
+    if (size > BRIDGE_RECORD_MAX) {
+        STAT_ADD(dropped, 1);
+        return;
+    }
+    
+    network_bridge_record_t record = {
+        .name_hash = topic->name_hash,
+        .priority = (uint8_t)event->priority,
+        .length = (uint8_t)size,
+    };
+    
+    // A full batch goes out from here to make room, sent outside the lock
+    uint8_t full[BRIDGE_FRAME_MAX];
+    uint8_t full_count = 0;
+    size_t full_len = 0;
+    bool first = false;
+    
+    portENTER_CRITICAL(&s_br.tx_lock);
+    if (s_br.tx_len + sizeof(record) + size > BRIDGE_FRAME_MAX || s_br.tx_count == UINT8_MAX) {
+        full_len = batch_take_locked(full, &full_count);
+    }
+    if (s_br.tx_count == 0) {
+        s_br.tx_first_us = esp_timer_get_time();
+        first = true;
+    }
+    // Numbered here so sequences follow the order records go out in
+    record.sequence = ++s_br.tx_sequence;
+    memcpy(s_br.tx + s_br.tx_len, &record, sizeof(record));
+    if (size > 0) {
+        memcpy(s_br.tx + s_br.tx_len + sizeof(record), event->data, size);
+    }
+    s_br.tx_len += sizeof(record) + size;
+    s_br.tx_count++;
+    portEXIT_CRITICAL(&s_br.tx_lock);
+    
+    if (full_len > 0) {
+        send_frame(full, full_len, full_count);
+    }
+    if (first) {
+        // Starts the batch timer
+        xTaskNotifyGive(s_br.task);
+    }
+}
+
+/* Runs in the WiFi task: copy the frame out and let the bridge task decode it */
+static void espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    if (!s_br.running || len < (int)sizeof(network_bridge_header_t) || len > BRIDGE_FRAME_MAX) {
+        return;
+    }
+    
+    uint16_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    if (magic != NETWORK_BRIDGE_MAGIC) {
+        return;
+    }
+    
+    bridge_rx_t rx;
+    memcpy(rx.mac, info->src_addr, sizeof(rx.mac));
+    rx.len = (uint8_t)len;
+    memcpy(rx.data, data, len);
+    
+    if (xQueueSend(s_br.rx, &rx, 0) != pdTRUE) {
+        STAT_ADD(dropped, 1);
+        return;
+    }
+    xTaskNotifyGive(s_br.task);
+}
+
+static int topic_find(uint32_t name_hash)
+{
+    uint8_t count = __atomic_load_n(&s_br.topic_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        if (s_br.topics[i].ready && s_br.topics[i].name_hash == name_hash) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* A peer's entry, claiming a free one for a new peer; NULL if the table is full */
+static bridge_peer_t *peer_get(const uint8_t *mac)
+{
+    bridge_peer_t *free_peer = NULL;
+    
+    for (int i = 0; i < CONFIG_NETWORK_BRIDGE_MAX_PEERS; i++) {
+        bridge_peer_t *peer = &s_br.peers[i];
+        if (peer->active && memcmp(peer->mac, mac, sizeof(peer->mac)) == 0) {
+            return peer;
+        }
+        if (free_peer == NULL && !peer->active) {
+            free_peer = peer;
+        }
+    }
+    
+    if (free_peer != NULL) {
+        memset(free_peer, 0, sizeof(*free_peer));
+        memcpy(free_peer->mac, mac, sizeof(free_peer->mac));
+        free_peer->active = true;
+        ESP_LOGI(TAG, "Peer " MACSTR " joined", MAC2STR(mac));
+    }
+    return free_peer;
+}
+
+static void update_remote_interest(void)
+{
+    uint32_t interest = 0;
+    uint8_t peers = 0;
+    
+    for (int i = 0; i < CONFIG_NETWORK_BRIDGE_MAX_PEERS; i++) {
+        if (s_br.peers[i].active) {
+            interest |= s_br.peers[i].interest;
+            peers++;
+        }
+    }
+    
+    __atomic_store_n(&s_br.remote_interest, interest, __ATOMIC_RELAXED);
+    s_br.stats.peers = peers;
+}
+
+static void expire_peers(int64_t now_us)
+{
+    bool changed = false;
+    
+    for (int i = 0; i < CONFIG_NETWORK_BRIDGE_MAX_PEERS; i++) {
+        bridge_peer_t *peer = &s_br.peers[i];
+        if (peer->active && now_us - peer->last_seen_us > BRIDGE_PEER_TTL_US) {
+            ESP_LOGI(TAG, "Peer " MACSTR " gone", MAC2STR(peer->mac));
+            peer->active = false;
+            changed = true;
+        }
+    }
+    
+    if (changed) {
+        update_remote_interest();
+    }
+}
+
+/**
+ * @brief Check a sequence number against the peer's window
+ *
+ * Numbers ahead of the window slide it; numbers within it are delivered
+ * once. A peer sends in sequence order, so one further behind can only
+ * be an old frame heard late, and is dropped as a duplicate.
+ *
+ * @return true to deliver the event
+ */
+static bool peer_accept(bridge_peer_t *peer, uint32_t sequence)
+{
+    if (!peer->synced) {
+        peer->synced = true;
+        peer->highest_seq = sequence;
+        peer->seen = 1;
+        return true;
+    }
+    
+    int32_t ahead = (int32_t)(sequence - peer->highest_seq);
+    if (ahead > 0) {
+        peer->seen = (ahead >= BRIDGE_DEDUP_WINDOW) ? 0 : peer->seen << ahead;
+        peer->seen |= 1;
+        peer->highest_seq = sequence;
+        return true;
+    }
+    
+    uint32_t behind = (uint32_t)(-ahead);
+    if (behind >= BRIDGE_DEDUP_WINDOW) {
+        return false;
+    }
+    
+    uint32_t bit = 1u << behind;
+    if (peer->seen & bit) {
+        return false;
+    }
+    peer->seen |= bit;
+    return true;
+}
+
+static void receive_advert(bridge_peer_t *peer, const uint8_t *pos, const uint8_t *end, uint8_t count)
+{
+    uint32_t interest = 0;
+    
+    for (uint8_t i = 0; i < count && pos + sizeof(uint32_t) <= end; i++, pos += sizeof(uint32_t)) {
+        uint32_t name_hash;
+        memcpy(&name_hash, pos, sizeof(name_hash));
+        int topic = topic_find(name_hash);
+        if (topic >= 0) {
+            interest |= 1u << topic;
+        }
+    }
+    
+    if (interest != peer->interest) {
+        peer->interest = interest;
+        update_remote_interest();
+    }
+}
+
+static void receive_events(bridge_peer_t *peer, const uint8_t *pos, const uint8_t *end, uint8_t count)
+{
+    for (uint8_t i = 0; i < count && pos + sizeof(network_bridge_record_t) <= end; i++) {
+        network_bridge_record_t record;
+        memcpy(&record, pos, sizeof(record));
+        const uint8_t *payload = pos + sizeof(record);
+        pos = payload + record.length;
+        if (pos > end) {
+            break;
+        }
+    
+        // Types we don't share are still taken into the window, they may come again
+        if (!peer_accept(peer, record.sequence)) {
+            STAT_ADD(duplicates, 1);
+            continue;
+        }
+    
+        int topic = topic_find(record.name_hash);
+        if (topic < 0) {
+            continue;
+        }
+    
+        // Any unit in radio range can send frames, so none gets onto the
+        // critical lane, where handlers run ahead of everything local
+        system_event_priority_t priority = (record.priority < BRIDGE_PRIORITY_MAX) ?
+                                           (system_event_priority_t)record.priority :
+                                           BRIDGE_PRIORITY_MAX;
+    
+        // Never waits: a full queue here would only back up the radio
+        esp_err_t ret = system_event_try_post(s_br.service_id, s_br.topics[topic].event_type,
+                                              record.length > 0 ? payload : NULL, record.length,
+                                              priority);
+        if (ret == ESP_OK) {
+            STAT_ADD(events_received, 1);
+        } else {
+            STAT_ADD(dropped, 1);
+        }
+    }
+}
+
+static void receive_frame(const bridge_rx_t *rx)
+{
+    network_bridge_header_t header;
+    memcpy(&header, rx->data, sizeof(header));
+    if (header.version != NETWORK_BRIDGE_VERSION) {
+        return;
+    }
+    
+    bridge_peer_t *peer = peer_get(rx->mac);
+    if (peer == NULL) {
+        STAT_ADD(dropped, 1);
+        return;
+    }
+    peer->last_seen_us = esp_timer_get_time();
+    STAT_ADD(frames_received, 1);
+    
+    // The peer restarted and numbers its records from scratch
+    if (header.boot_id != peer->boot_id) {
+        peer->boot_id = header.boot_id;
+        peer->synced = false;
+    }
+    
+    const uint8_t *pos = rx->data + sizeof(header);
+    const uint8_t *end = rx->data + rx->len;
+    
+    if (header.type == NETWORK_BRIDGE_FRAME_ADVERT) {
+        receive_advert(peer, pos, end, header.count);
+    } else if (header.type == NETWORK_BRIDGE_FRAME_EVENTS) {
+        receive_events(peer, pos, end, header.count);
+    }
+}
+
+/* Tell the peers which shared types have subscribers here, besides the bridge */
+static void send_advert(void)
+{
+    static uint8_t frame[BRIDGE_FRAME_MAX];
+    uint8_t *pos = frame + sizeof(network_bridge_header_t);
+    uint8_t count = 0;
+    
+    uint8_t topics = __atomic_load_n(&s_br.topic_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < topics; i++) {
+        uint16_t subscribers = 0;
+        if (!s_br.topics[i].ready ||
+            system_event_get_subscriber_count(s_br.topics[i].event_type, &subscribers) != ESP_OK ||
+            subscribers <= 1) {
+            continue;
+        }
+        memcpy(pos, &s_br.topics[i].name_hash, sizeof(uint32_t));
+        pos += sizeof(uint32_t);
+        count++;
+    }
+    
+    // Sent even when empty, so peers see interest go away
+    write_header(frame, NETWORK_BRIDGE_FRAME_ADVERT, count);
+    send_frame(frame, pos - frame, 0);
+}
+
+static void bridge_task(void *arg)
+{
+    int64_t next_advert_us = 0;
+    
+    while (s_br.running) {
+        int64_t now_us = esp_timer_get_time();
+        int64_t wait_us = batch_due_in_us(now_us, next_advert_us - now_us);
+        TickType_t ticks = (wait_us > 0) ? pdMS_TO_TICKS((wait_us + 999) / 1000) : 0;
+        if (wait_us > 0 && ticks == 0) {
+            ticks = 1;
+        }
+    
+        // Woken by received frames, the first event of a batch and stop
+        if (ticks > 0) {
+            ulTaskNotifyTake(pdTRUE, ticks);
+        }
+        if (!s_br.running) {
+            break;
+        }
+    
+        while (xQueueReceive(s_br.rx, &s_rx_frame, 0) == pdTRUE) {
+            receive_frame(&s_rx_frame);
+        }
+    
+        now_us = esp_timer_get_time();
+        batch_flush_due(now_us);
+    
+        if (now_us >= next_advert_us) {
+            expire_peers(now_us);
+            send_advert();
+            next_advert_us = now_us + CONFIG_NETWORK_BRIDGE_ADVERT_MS * 1000LL;
+        }
+    }
+    
+    xSemaphoreGive(s_br.stopped);
+    vTaskDelete(NULL);
+}
+
+/* Share each name of the comma separated Kconfig list */
+static void share_configured_topics(void)
+{
+    const char *list = CONFIG_NETWORK_BRIDGE_TOPICS;
+    
+    while (*list != '\0') {
+        const char *comma = strchr(list, ',');
+        size_t len = (comma != NULL) ? (size_t)(comma - list) : strlen(list);
+    
+        char name[SYSTEM_SERVICE_MAX_NAME_LEN];
+        if (len > 0 && len < sizeof(name)) {
+            memcpy(name, list, len);
+            name[len] = '\0';
+            if (network_bridge_share(name) != ESP_OK) {
+                ESP_LOGW(TAG, "Could not share '%s'", name);
+            }
+        }
+    
+        list += len;
+        if (*list == ',') {
+            list++;
+        }
+    }
+}
+
+esp_err_t network_bridge_start(void)
+{
+    if (s_br.running) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = system_service_register("network_bridge", NULL, &s_br.service_id);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register bridge service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = esp_now_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize ESP-NOW: %s", esp_err_to_name(ret));
+        system_service_unregister(s_br.service_id);
+        return ret;
+    }
+    
+    // Channel 0 follows the station's current channel
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, s_broadcast, sizeof(peer.peer_addr));
+    ret = esp_now_add_peer(&peer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add broadcast peer: %s", esp_err_to_name(ret));
+        esp_now_deinit();
+        system_service_unregister(s_br.service_id);
+        return ret;
+    }
+    
+    memset(s_br.peers, 0, sizeof(s_br.peers));
+    memset(&s_br.stats, 0, sizeof(s_br.stats));
+    s_br.remote_interest = 0;
+    s_br.topic_count = 0;
+    s_br.tx_len = sizeof(network_bridge_header_t);
+    s_br.tx_count = 0;
+    s_br.tx_sequence = 0;
+    s_br.boot_id = esp_random();
+    
+    s_br.rx = SYSTEM_QUEUE_CREATE(s_bridge_rx, BRIDGE_RX_DEPTH, sizeof(bridge_rx_t));
+    s_br.stopped = SYSTEM_BINARY_CREATE(s_bridge_stopped);
+    s_br.running = true;
+    
+    // Next to the WiFi task, which hands over the received frames
+    BaseType_t created = SYSTEM_TASK_CREATE_PINNED(s_bridge_task, bridge_task, "net_bridge",
+                                                   BRIDGE_TASK_STACK, NULL, 2, &s_br.task, 0);
+    if (created != pdPASS) {
+        s_br.running = false;
+        vSemaphoreDelete(s_br.stopped);
+        vQueueDelete(s_br.rx);
+        esp_now_deinit();
+        system_service_unregister(s_br.service_id);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_now_register_recv_cb(espnow_recv_cb);
+    system_service_set_state(s_br.service_id, SYSTEM_SERVICE_STATE_RUNNING);
+    
+    share_configured_topics();
+    
+    ESP_LOGI(TAG, "Bridge started, %d types shared", s_br.topic_count);
+    return ESP_OK;
+}
+
+esp_err_t network_bridge_stop(void)
+{
+    if (!s_br.running) {
+        return ESP_OK;
+    }
+    
+    esp_now_unregister_recv_cb();
+    
+    s_br.running = false;
+    xTaskNotifyGive(s_br.task);
+    xSemaphoreTake(s_br.stopped, portMAX_DELAY);
+    vSemaphoreDelete(s_br.stopped);
+    vQueueDelete(s_br.rx);
+    s_br.task = NULL;
+    
+    esp_now_deinit();
+    
+    // Drops the forwarding subscriptions with the service
+    system_service_unregister(s_br.service_id);
+    s_br.service_id = SYSTEM_SERVICE_ID_INVALID;
+    
+    ESP_LOGI(TAG, "Bridge stopped after %lu frames", (unsigned long)s_br.stats.frames_sent);
+    return ESP_OK;
+}
+
+esp_err_t network_bridge_share(const char *event_name)
+{
+    if (event_name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_br.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    system_event_type_t event_type;
+    esp_err_t ret = system_event_register_type(event_name, &event_type);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Claim a slot; it stays invisible to the bridge task until subscribed
+    int index = -1;
+    portENTER_CRITICAL(&s_br.topic_lock);
+    bool shared = false;
+    for (int i = 0; i < s_br.topic_count; i++) {
+        if (s_br.topics[i].event_type == event_type) {
+            shared = true;
+            break;
+        }
+    }
+    if (!shared && s_br.topic_count < NETWORK_BRIDGE_MAX_TOPICS) {
+        index = s_br.topic_count;
+        s_br.topics[index].event_type = event_type;
+        s_br.topics[index].name_hash = system_event_name_hash(event_name);
+        s_br.topics[index].ready = false;
+        __atomic_store_n(&s_br.topic_count, index + 1, __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&s_br.topic_lock);
+    
+    if (shared) {
+        return ESP_OK;
+    }
+    if (index < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    const system_event_filter_t filter = {
+        .predicate = remote_wants,
+    };
+    ret = system_event_subscribe_filtered(s_br.service_id, event_type, forward_handler,
+                                          (void *)(uintptr_t)index, &filter);
+    if (ret != ESP_OK) {
+        // The slot stays claimed but never matches
+        s_br.topics[index].event_type = SYSTEM_EVENT_TYPE_INVALID;
+        return ret;
+    }
+    
+    // Frames go out from the radio's core
+    system_event_set_affinity(s_br.service_id, event_type, SYSTEM_EVENT_AFFINITY_CORE0);
+    s_br.topics[index].ready = true;
+    
+    ESP_LOGI(TAG, "Sharing '%s'", event_name);
+    return ESP_OK;
+}
+
+esp_err_t network_bridge_get_stats(network_bridge_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *stats = s_br.stats;
+    return ESP_OK;
+}
+
+#else // !CONFIG_NETWORK_BRIDGE
+
+esp_err_t network_bridge_start(void)
+{
+    ESP_LOGD(TAG, "Bridge disabled");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t network_bridge_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t network_bridge_share(const char *event_name)
+{
+    (void)event_name;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t network_bridge_get_stats(network_bridge_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    return ESP_OK;
+}
+
+#endif // CONFIG_NETWORK_BRIDGE
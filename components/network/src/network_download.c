@@ -0,0 +1,557 @@
+#include "network_download.h"
+#include "network_service.h"
+#include "system_service/event_bus.h"
+#include "system_service/memory_utils.h"
+#include "system_service/static_alloc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "spi_flash_mmap.h"
+#include "esp_rom_crc.h"
+#include "mbedtls/sha256.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "network_download";
+
+/* Two chunk buffers: the download task fills one while the writer task
+ * hashes and flashes the other. Buffer indices travel between the tasks
+ * through the free and full queues, so neither ever waits on the other
+ * unless it has genuinely run ahead. */
+#define DL_CHUNK_SIZE           (CONFIG_NETWORK_DOWNLOAD_CHUNK_SECTORS * SPI_FLASH_SEC_SIZE)
+#define DL_BUFFERS              2
+#define DL_END_OF_STREAM        0xFF
+#define DL_TIMEOUT_MS           10000
+#define DL_MAX_REDIRECTS        3
+#define DL_PROGRESS_INTERVAL_US 250000
+
+typedef struct {
+    uint8_t index;                  // DL_END_OF_STREAM once everything is queued
+    uint32_t len;
+} dl_chunk_t;
+
+typedef struct {
+    char url[NETWORK_DOWNLOAD_URL_MAX_LEN];
+    const char *cert_pem;
+    uint8_t expected_sha256[32];
+    bool check_sha256;
+    uint32_t expected_crc32;
+    bool set_boot_partition;
+    
+    const esp_partition_t *partition;
+    size_t offset;
+    bool ota;
+    esp_ota_handle_t ota_handle;
+    size_t erased_end;              // Partition target: erased up to here
+    
+    uint8_t *buffers[DL_BUFFERS];
+    QueueHandle_t free_q;
+    QueueHandle_t full_q;
+    SemaphoreHandle_t writer_done;
+    
+    mbedtls_sha256_context sha;     // Writer task only
+    esp_err_t write_err;            // First flash error, stops further writes
+    
+    int64_t start_us;
+    int64_t progress_us;
+    volatile bool abort;
+    bool running;
+    network_download_status_t status;
+    portMUX_TYPE lock;              // Guards status
+} download_t;
+
+static download_t s_dl = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static system_event_type_t s_progress_event = SYSTEM_EVENT_TYPE_INVALID;
+static system_event_type_t s_done_event = SYSTEM_EVENT_TYPE_INVALID;
+
+static TaskHandle_t s_download_task = NULL;
+static TaskHandle_t s_writer_task = NULL;
+SYSTEM_TASK_DEFINE(s_download_task_storage, 8192);
+SYSTEM_TASK_DEFINE(s_writer_task_storage, 3072);
+SYSTEM_QUEUE_DEFINE(s_free_q_storage, DL_BUFFERS, sizeof(uint8_t));
+SYSTEM_QUEUE_DEFINE(s_full_q_storage, DL_BUFFERS + 1, sizeof(dl_chunk_t));
+SYSTEM_SEMAPHORE_DEFINE(s_writer_done_storage);
+
+static void publish_status(system_event_type_t type)
+{
+    network_download_status_t status;
+    
+    portENTER_CRITICAL(&s_dl.lock);
+    status = s_dl.status;
+    portEXIT_CRITICAL(&s_dl.lock);
+    
+    if (type != SYSTEM_EVENT_TYPE_INVALID) {
+        system_event_post(network_service_get_id(), type, &status, sizeof(status),
+                          SYSTEM_EVENT_PRIORITY_NORMAL);
+    }
+}
+
+static void set_state(network_download_state_t state)
+{
+    portENTER_CRITICAL(&s_dl.lock);
+    s_dl.status.state = state;
+    portEXIT_CRITICAL(&s_dl.lock);
+}
+
+/* Append one chunk to the target. Call from the writer task only. */
+static esp_err_t write_chunk(const uint8_t *data, size_t len, size_t pos)
+{
+    if (s_dl.ota) {
+        // Sequential-write mode erases each sector just before it is written
+        return esp_ota_write(s_dl.ota_handle, data, len);
+    }
+    
+    // Erase a whole chunk ahead at a time; offset and chunk are sector aligned
+    size_t end = s_dl.offset + pos + len;
+    if (end > s_dl.erased_end) {
+        size_t erase_len = DL_CHUNK_SIZE;
+        if (s_dl.erased_end + erase_len > s_dl.partition->size) {
+            erase_len = s_dl.partition->size - s_dl.erased_end;
+        }
+        esp_err_t ret = esp_partition_erase_range(s_dl.partition, s_dl.erased_end, erase_len);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        s_dl.erased_end += erase_len;
+    }
+    
+    return esp_partition_write(s_dl.partition, s_dl.offset + pos, data, len);
+}
+
+/* Hash and flash full buffers as they arrive */
+static void writer_task(void *arg)
+{
+    size_t pos = 0;
+    uint32_t crc = 0;
+    dl_chunk_t chunk;
+    
+    while (xQueueReceive(s_dl.full_q, &chunk, portMAX_DELAY) == pdTRUE) {
+        if (chunk.index == DL_END_OF_STREAM) {
+            break;
+        }
+    
+        const uint8_t *data = s_dl.buffers[chunk.index];
+        if (s_dl.write_err == ESP_OK) {
+            mbedtls_sha256_update(&s_dl.sha, data, chunk.len);
+            crc = esp_rom_crc32_le(crc, data, chunk.len);
+            s_dl.write_err = write_chunk(data, chunk.len, pos);
+            if (s_dl.write_err != ESP_OK) {
+                ESP_LOGE(TAG, "Flash write at %u failed: %s", (unsigned)pos,
+                         esp_err_to_name(s_dl.write_err));
+                s_dl.abort = true;
+            }
+            pos += chunk.len;
+    
+            portENTER_CRITICAL(&s_dl.lock);
+            s_dl.status.written = pos;
+            s_dl.status.crc32 = crc;
+            portEXIT_CRITICAL(&s_dl.lock);
+        }
+    
+        xQueueSend(s_dl.free_q, &chunk.index, portMAX_DELAY);
+    }
+    
+    xSemaphoreGive(s_dl.writer_done);
+    s_writer_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/* (Re)issue the request from byte `from`, following redirects. On success
+ * the client is ready to read the body. */
+static esp_err_t open_at(esp_http_client_handle_t client, uint32_t from, int64_t *out_length)
+{
+    char range[32];
+    if (from > 0) {
+        snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)from);
+        esp_http_client_set_header(client, "Range", range);
+    } else {
+        esp_http_client_delete_header(client, "Range");
+    }
+    
+    for (int redirects = 0; ; redirects++) {
+        esp_err_t ret = esp_http_client_open(client, 0);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    
+        int64_t length = esp_http_client_fetch_headers(client);
+        int status = esp_http_client_get_status_code(client);
+    
+        if ((status == 301 || status == 302 || status == 307 || status == 308) &&
+            redirects < DL_MAX_REDIRECTS) {
+            esp_http_client_set_redirection(client);
+            esp_http_client_close(client);
+            continue;
+        }
+    
+        // A server that ignores Range would send the payload from the start
+        bool ok = (from == 0) ? status == 200 : status == 206;
+        if (!ok || length < 0) {
+            ESP_LOGE(TAG, "HTTP %d (length %lld) for bytes %lu-", status, length, (unsigned long)from);
+            esp_http_client_close(client);
+            return (from > 0 && status == 200) ? ESP_ERR_NOT_SUPPORTED : ESP_FAIL;
+        }
+    
+        *out_length = length;
+        return ESP_OK;
+    }
+}
+
+/* Reconnect after a dropped connection, backing off between attempts */
+static esp_err_t resume(esp_http_client_handle_t client, uint32_t from)
+{
+    esp_http_client_close(client);
+    set_state(NETWORK_DOWNLOAD_RESUMING);
+    publish_status(s_progress_event);
+    
+    uint32_t delay_ms = 1000;
+    for (int attempt = 0; attempt < CONFIG_NETWORK_DOWNLOAD_RETRIES && !s_dl.abort; attempt++) {
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        delay_ms = (delay_ms < 16000) ? delay_ms * 2 : delay_ms;
+        if (!network_is_connected()) {
+            continue;
+        }
+    
+        portENTER_CRITICAL(&s_dl.lock);
+        s_dl.status.retries++;
+        portEXIT_CRITICAL(&s_dl.lock);
+    
+        int64_t length;
+        esp_err_t ret = open_at(client, from, &length);
+        if (ret == ESP_ERR_NOT_SUPPORTED) {
+            return ret;
+        }
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "Resumed at %lu bytes", (unsigned long)from);
+            set_state(NETWORK_DOWNLOAD_RUNNING);
+            return ESP_OK;
+        }
+        esp_http_client_close(client);
+    }
+    
+    return s_dl.abort ? ESP_ERR_INVALID_STATE : ESP_ERR_TIMEOUT;
+}
+
+static void update_progress(uint32_t received)
+{
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_dl.lock);
+    s_dl.status.received = received;
+    int64_t elapsed_us = now_us - s_dl.start_us;
+    if (elapsed_us > 0) {
+        s_dl.status.bytes_per_s = (uint32_t)((int64_t)received * 1000000 / elapsed_us);
+    }
+    portEXIT_CRITICAL(&s_dl.lock);
+    
+    if (now_us - s_dl.progress_us >= DL_PROGRESS_INTERVAL_US) {
+        s_dl.progress_us = now_us;
+        publish_status(s_progress_event);
+    }
+}
+
+/* Receive the body into free buffers and hand them to the writer */
+static esp_err_t receive(esp_http_client_handle_t client, uint32_t total)
+{
+    uint32_t received = 0;
+    
+    while (received < total) {
+        uint8_t index;
+        xQueueReceive(s_dl.free_q, &index, portMAX_DELAY);
+    
+        uint8_t *buf = s_dl.buffers[index];
+        uint32_t fill = 0;
+        uint32_t want = (total - received < DL_CHUNK_SIZE) ? total - received : DL_CHUNK_SIZE;
+    
+        while (fill < want) {
+            if (s_dl.abort) {
+                return (s_dl.write_err != ESP_OK) ? s_dl.write_err : ESP_ERR_INVALID_STATE;
+            }
+    
+            int n = esp_http_client_read(client, (char *)buf + fill, want - fill);
+            if (n > 0) {
+                fill += n;
+                update_progress(received + fill);
+                continue;
+            }
+    
+            // Connection dropped or closed early: pick up where it stopped
+            ESP_LOGW(TAG, "Connection lost at %lu of %lu bytes",
+                     (unsigned long)(received + fill), (unsigned long)total);
+            esp_err_t ret = resume(client, received + fill);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+    
+        dl_chunk_t chunk = { .index = index, .len = fill };
+        xQueueSend(s_dl.full_q, &chunk, portMAX_DELAY);
+        received += fill;
+    }
+    
+    return ESP_OK;
+}
+
+static esp_err_t verify_and_finish(void)
+{
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&s_dl.sha, digest);
+    
+    portENTER_CRITICAL(&s_dl.lock);
+    memcpy(s_dl.status.sha256, digest, sizeof(digest));
+    uint32_t crc = s_dl.status.crc32;
+    portEXIT_CRITICAL(&s_dl.lock);
+    
+    if (s_dl.check_sha256 && memcmp(digest, s_dl.expected_sha256, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "SHA-256 mismatch");
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (s_dl.expected_crc32 != 0 && crc != s_dl.expected_crc32) {
+        ESP_LOGE(TAG, "CRC-32 mismatch: got %08lx, expected %08lx",
+                 (unsigned long)crc, (unsigned long)s_dl.expected_crc32);
+        return ESP_ERR_INVALID_CRC;
+    }
+    
+    if (s_dl.ota) {
+        // Validates the image header and segments
+        esp_err_t ret = esp_ota_end(s_dl.ota_handle);
+        s_dl.ota_handle = 0;
+        if (ret == ESP_OK && s_dl.set_boot_partition) {
+            ret = esp_ota_set_boot_partition(s_dl.partition);
+        }
+        return ret;
+    }
+    
+    return ESP_OK;
+}
+
+static void download_task(void *arg)
+{
+    esp_err_t ret;
+    int64_t length = 0;
+    
+    esp_http_client_config_t http_config = {
+        .url = s_dl.url,
+        .cert_pem = s_dl.cert_pem,
+        .crt_bundle_attach = s_dl.cert_pem ? NULL : esp_crt_bundle_attach,
+        .timeout_ms = DL_TIMEOUT_MS,
+        .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&http_config);
+    
+    if (client == NULL) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        ret = open_at(client, 0, &length);
+    }
+    
+    size_t capacity = s_dl.partition->size - s_dl.offset;
+    if (ret == ESP_OK && (length == 0 || (uint64_t)length > capacity)) {
+        ESP_LOGE(TAG, "Payload of %lld bytes does not fit %u bytes in '%s'",
+                 length, (unsigned)capacity, s_dl.partition->label);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret == ESP_OK && s_dl.ota) {
+        ret = esp_ota_begin(s_dl.partition, OTA_WITH_SEQUENTIAL_WRITES, &s_dl.ota_handle);
+    }
+    
+    if (ret == ESP_OK) {
+        portENTER_CRITICAL(&s_dl.lock);
+        s_dl.status.total = (uint32_t)length;
+        portEXIT_CRITICAL(&s_dl.lock);
+        ESP_LOGI(TAG, "Downloading %lld bytes into '%s'", length, s_dl.partition->label);
+    
+        ret = receive(client, (uint32_t)length);
+    }
+    
+    // Let the writer drain whatever it still holds
+    dl_chunk_t end = { .index = DL_END_OF_STREAM };
+    xQueueSend(s_dl.full_q, &end, portMAX_DELAY);
+    xSemaphoreTake(s_dl.writer_done, portMAX_DELAY);
+    
+    if (ret == ESP_OK) {
+        ret = s_dl.write_err;
+    }
+    if (ret == ESP_OK) {
+        ret = verify_and_finish();
+    }
+    if (s_dl.ota_handle != 0) {
+        esp_ota_abort(s_dl.ota_handle);
+        s_dl.ota_handle = 0;
+    }
+    
+    if (client != NULL) {
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+    }
+    mbedtls_sha256_free(&s_dl.sha);
+    for (int i = 0; i < DL_BUFFERS; i++) {
+        free(s_dl.buffers[i]);
+        s_dl.buffers[i] = NULL;
+    }
+    vQueueDelete(s_dl.free_q);
+    vQueueDelete(s_dl.full_q);
+    vSemaphoreDelete(s_dl.writer_done);
+    
+    int64_t elapsed_ms = (esp_timer_get_time() - s_dl.start_us) / 1000;
+    portENTER_CRITICAL(&s_dl.lock);
+    s_dl.status.state = (ret == ESP_OK) ? NETWORK_DOWNLOAD_DONE : NETWORK_DOWNLOAD_FAILED;
+    s_dl.status.result = ret;
+    portEXIT_CRITICAL(&s_dl.lock);
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "✓ Downloaded %lld bytes in %lld ms (%lu B/s, %lu resumes)",
+                 length, elapsed_ms, (unsigned long)s_dl.status.bytes_per_s,
+                 (unsigned long)s_dl.status.retries);
+    } else {
+        ESP_LOGE(TAG, "Download failed: %s", esp_err_to_name(ret));
+    }
+    publish_status(s_done_event);
+    
+    s_dl.running = false;
+    s_download_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t network_download_init(void)
+{
+    esp_err_t ret = system_event_register_topic("network.download_progress",
+                                                SYSTEM_EVENT_TOPIC_LATEST, &s_progress_event);
+    if (ret == ESP_OK) {
+        ret = system_event_register_topic("network.download_done",
+                                          SYSTEM_EVENT_TOPIC_QUEUED, &s_done_event);
+    }
+    return ret;
+}
+
+esp_err_t network_download_start(const network_download_config_t *config)
+{
+    if (config == NULL || config->url == NULL ||
+        strlen(config->url) >= NETWORK_DOWNLOAD_URL_MAX_LEN ||
+        config->offset % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_dl.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    const esp_partition_t *partition;
+    bool ota = config->partition_label == NULL;
+    if (ota) {
+        partition = esp_ota_get_next_update_partition(NULL);
+    } else {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY,
+                                             config->partition_label);
+    }
+    if (partition == NULL || config->offset >= partition->size || (ota && config->offset != 0)) {
+        ESP_LOGE(TAG, "No target partition '%s'", ota ? "<next OTA>" : config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint8_t *buffers[DL_BUFFERS] = {0};
+    for (int i = 0; i < DL_BUFFERS; i++) {
+        // Internal RAM lets the flash driver write without a bounce buffer
+        buffers[i] = memory_alloc_sram_only(DL_CHUNK_SIZE);
+        if (buffers[i] == NULL) {
+            buffers[i] = memory_alloc_psram_only(DL_CHUNK_SIZE);
+        }
+        if (buffers[i] == NULL) {
+            free(buffers[0]);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    memset(&s_dl.status, 0, sizeof(s_dl.status));
+    strncpy(s_dl.url, config->url, sizeof(s_dl.url) - 1);
+    s_dl.url[sizeof(s_dl.url) - 1] = '\0';
+    s_dl.cert_pem = config->cert_pem;
+    s_dl.check_sha256 = config->sha256 != NULL;
+    if (s_dl.check_sha256) {
+        memcpy(s_dl.expected_sha256, config->sha256, sizeof(s_dl.expected_sha256));
+    }
+    s_dl.expected_crc32 = config->crc32;
+    s_dl.set_boot_partition = config->set_boot_partition;
+    s_dl.partition = partition;
+    s_dl.offset = config->offset;
+    s_dl.erased_end = config->offset;
+    s_dl.ota = ota;
+    s_dl.ota_handle = 0;
+    s_dl.write_err = ESP_OK;
+    s_dl.abort = false;
+    s_dl.start_us = esp_timer_get_time();
+    s_dl.progress_us = 0;
+    memcpy(s_dl.buffers, buffers, sizeof(buffers));
+    mbedtls_sha256_init(&s_dl.sha);
+    mbedtls_sha256_starts(&s_dl.sha, 0);
+    
+    s_dl.free_q = SYSTEM_QUEUE_CREATE(s_free_q_storage, DL_BUFFERS, sizeof(uint8_t));
+    s_dl.full_q = SYSTEM_QUEUE_CREATE(s_full_q_storage, DL_BUFFERS + 1, sizeof(dl_chunk_t));
+    s_dl.writer_done = SYSTEM_BINARY_CREATE(s_writer_done_storage);
+    for (uint8_t i = 0; i < DL_BUFFERS; i++) {
+        xQueueSend(s_dl.free_q, &i, 0);
+    }
+    
+    s_dl.status.state = NETWORK_DOWNLOAD_RUNNING;
+    s_dl.running = true;
+    
+    // The writer runs above the receiver so a full buffer is flushed at once
+    BaseType_t created = SYSTEM_TASK_CREATE(s_writer_task_storage, writer_task, "net_dl_write",
+                                            3072, NULL, 4, &s_writer_task);
+    if (created == pdPASS) {
+        created = SYSTEM_TASK_CREATE(s_download_task_storage, download_task, "net_dl",
+                                     8192, NULL, 3, &s_download_task);
+        if (created != pdPASS) {
+            dl_chunk_t end = { .index = DL_END_OF_STREAM };
+            xQueueSend(s_dl.full_q, &end, portMAX_DELAY);
+            xSemaphoreTake(s_dl.writer_done, portMAX_DELAY);
+        }
+    }
+    if (created != pdPASS) {
+        mbedtls_sha256_free(&s_dl.sha);
+        for (int i = 0; i < DL_BUFFERS; i++) {
+            free(s_dl.buffers[i]);
+            s_dl.buffers[i] = NULL;
+        }
+        vQueueDelete(s_dl.free_q);
+        vQueueDelete(s_dl.full_q);
+        vSemaphoreDelete(s_dl.writer_done);
+        s_dl.running = false;
+        s_dl.status.state = NETWORK_DOWNLOAD_IDLE;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Download started: %s", s_dl.url);
+    return ESP_OK;
+}
+
+esp_err_t network_download_abort(void)
+{
+    if (!s_dl.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    s_dl.abort = true;
+    return ESP_OK;
+}
+
+esp_err_t network_download_get_status(network_download_status_t *status)
+{
+    if (status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_dl.lock);
+    *status = s_dl.status;
+    portEXIT_CRITICAL(&s_dl.lock);
+    
+    return ESP_OK;
+}
@@ -1,20 +1,36 @@
 #include "network_service.h"
+#include "network_download.h"
+#include "network_telemetry.h"
+#include "network_bridge.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/boot_trace.h"
+#include "system_service/power_lock.h"
+#include "system_service/system_settings.h"
+#include "display_ui_queue.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include "mbedtls/pkcs5.h"
+#include "mbedtls/sha256.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 #include "lvgl.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "network_service";
 
+SYSTEM_EVENT_SCHEMA_DEFINE(NETWORK_EVENT_SCHEMA, NETWORK_EVENT);
+
 static system_service_id_t network_service_id = 0;
-static system_event_type_t network_events[9];
+// User switch over CONFIG_NETWORK_SERVICE_AUTO_RECONNECT, persisted
+static system_setting_id_t autojoin_setting = SYSTEM_SETTING_ID_INVALID;
 static bool initialized = false;
 static bool wifi_initialized = false;
 static bool is_connected = false;
@@ -25,18 +41,124 @@ static esp_event_handler_instance_t instance_any_id;
 static esp_event_handler_instance_t instance_got_ip;
 static esp_event_handler_instance_t instance_scan_done;
 
-/* Scan results storage */
-static wifi_ap_record_t *scan_records = NULL;
-static uint16_t scan_count = 0;
-static bool scan_in_progress = false;
+/* Streaming scan: channels are scanned one at a time and each SCAN_DONE
+ * merges that channel's records into a per-BSSID cache, from which the
+ * top-K table is rebuilt and published straight away. All storage is
+ * static; subscribers get the results in loaned event buffers.
+ *
+ * The cache outlives the scan: within CONFIG_NETWORK_SERVICE_SCAN_CACHE_TTL_S
+ * of a complete scan, network_scan_start() answers from it without using
+ * the radio. RSSI is smoothed across scans so rows don't jump around. */
+#define SCAN_RECORDS_PER_CHANNEL 16
+#define SCAN_TIMEOUT_MS          15000
+#define SCAN_DONE_BIT            BIT0
+#define SCAN_CACHE_SIZE          32
+#define SCAN_CACHE_MAX_MISSES    2          // Complete scans without a sighting
+#define SCAN_RSSI_SHIFT          4          // Smoothed RSSI in 1/16 dBm
+#define SCAN_RSSI_WEIGHT         2          // New sample weighs 1/4
 
-/* Comparison function for qsort - sort by RSSI descending */
-static int compare_rssi(const void *a, const void *b)
-{
-    const network_wifi_info_t *net_a = (const network_wifi_info_t *)a;
-    const network_wifi_info_t *net_b = (const network_wifi_info_t *)b;
-    return net_b->rssi - net_a->rssi;  // Descending order (stronger signal first)
-}
+typedef struct {
+    uint8_t bssid[6];
+    char ssid[NETWORK_SSID_MAX_LEN];
+    uint8_t channel;
+    uint8_t misses;
+    network_auth_mode_t auth_mode;
+    int16_t rssi_q4;                // 0 marks a free slot
+    int64_t seen_us;
+} scan_bss_t;
+
+typedef struct {
+    wifi_ap_record_t records[SCAN_RECORDS_PER_CHANNEL];  // Current channel, raw
+    scan_bss_t bss[SCAN_CACHE_SIZE];
+    network_scan_result_t top;      // Strongest network per SSID, RSSI descending
+    uint8_t channel;                // Channel being scanned, 0 when idle
+    uint8_t last_channel;
+    int64_t started_us;
+    int64_t completed_us;           // Last complete scan, 0 if none
+    SemaphoreHandle_t lock;         // Guards everything above but records
+    EventGroupHandle_t events;
+} wifi_scan_t;
+
+static wifi_scan_t s_scan = {0};
+
+/* Fast reconnect. The networks that last got an IP are kept in NVS with
+ * their BSSID, channel and PMK, so joining one again goes straight to that
+ * AP on that channel and skips both the all-channel scan and the PBKDF2
+ * passphrase hash. A failed fast attempt falls back to a full scan. */
+#define FAST_CACHE_NAMESPACE    "net_fast"
+#define FAST_CACHE_KEY          "aps"
+#define FAST_CACHE_SIZE         4
+#define FAST_CACHE_VERSION      1
+#define FAST_HAS_PMK            0x01
+#define FAST_OPEN               0x02        // No passphrase needed
+#define PMK_LEN                 32
+
+typedef struct {
+    char ssid[NETWORK_SSID_MAX_LEN];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t flags;
+    uint8_t secret_check[8];        // SHA-256(ssid | passphrase) prefix
+    uint8_t pmk[PMK_LEN];
+} fast_entry_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    fast_entry_t entries[FAST_CACHE_SIZE];  // Most recently used first
+} fast_cache_t;
+
+typedef enum {
+    CONNECT_IDLE = 0,
+    CONNECT_FAST,                   // Cached BSSID and channel
+    CONNECT_FULL,                   // All-channel scan
+} connect_attempt_t;
+
+typedef struct {
+    fast_cache_t cache;
+    connect_attempt_t attempt;
+    bool pending;                   // Connect once the old link is down
+    bool user_disconnect;
+    char ssid[NETWORK_SSID_MAX_LEN];
+    char passphrase[NETWORK_PASSWORD_MAX_LEN];  // Wiped once the link is up
+    uint8_t bssid[6];
+    uint8_t channel;
+    int64_t start_us;               // Connect request, for time-to-IP
+} wifi_connect_t;
+
+static wifi_connect_t s_conn = {0};
+
+/* Radio power profile and the time spent in each */
+typedef struct {
+    network_power_profile_t profile;
+    uint32_t switches;
+    int64_t since_us;               // Current profile entered
+    uint64_t time_us[NETWORK_POWER_PROFILE_COUNT];
+    portMUX_TYPE lock;
+} wifi_power_t;
+
+static wifi_power_t s_power = {
+    .profile = NETWORK_POWER_BALANCED,      // Matches the driver's default
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static const char *const power_profile_names[NETWORK_POWER_PROFILE_COUNT] = {
+    "performance", "balanced", "max-modem",
+};
+
+/*
+ * Connecting runs the PMK derivation and the handshake at full speed,
+ * and the performance profile keeps the radio listening, which light
+ * sleep would undo. Flags are swapped atomically, so any task may sync.
+ */
+typedef struct {
+    system_power_lock_t connect;    // CPU_MAX while an attempt runs
+    system_power_lock_t awake;      // NO_SLEEP in the performance profile
+    bool connect_held;
+    bool awake_held;
+} wifi_power_locks_t;
+
+static wifi_power_locks_t s_pm = {0};
 
 /* Convert ESP WiFi auth mode to our auth mode */
 static network_auth_mode_t convert_auth_mode(wifi_auth_mode_t esp_auth)
@@ -59,54 +181,432 @@ static network_auth_mode_t convert_auth_mode(wifi_auth_mode_t esp_auth)
     }
 }
 
-/* WiFi scan done handler */
+static const char *auth_mode_name(network_auth_mode_t auth_mode)
+{
+    switch (auth_mode) {
+        case NETWORK_AUTH_WEP: return "WEP";
+        case NETWORK_AUTH_WPA_PSK: return "WPA";
+        case NETWORK_AUTH_WPA2_PSK: return "WPA2";
+        case NETWORK_AUTH_WPA_WPA2_PSK: return "WPA/WPA2";
+        case NETWORK_AUTH_WPA3_PSK: return "WPA3";
+        default: return "OPEN";
+    }
+}
+
+/* Signal bars with a few dB of dead band, so a network sitting on a
+ * threshold doesn't flicker between two icons */
+static uint8_t rssi_bars(int rssi, uint8_t prev)
+{
+    static const int8_t thresholds[] = { -80, -67, -50 };
+    uint8_t bars = 0;
+    while (bars < 3 && rssi > thresholds[bars]) {
+        bars++;
+    }
+    if (bars == prev + 1 && rssi <= thresholds[prev] + 3) {
+        return prev;
+    }
+    if (bars + 1 == prev && rssi > thresholds[bars] - 3) {
+        return prev;
+    }
+    return bars;
+}
+
+static const network_wifi_info_t *scan_top_find(const network_scan_result_t *top, const char *ssid)
+{
+    for (int i = 0; i < top->count; i++) {
+        if (strncmp(top->networks[i].ssid, ssid, NETWORK_SSID_MAX_LEN) == 0) {
+            return &top->networks[i];
+        }
+    }
+    return NULL;
+}
+
+/* Fold one sighting into the per-BSSID cache. A full cache gives up the
+ * entry seen longest ago. Call with s_scan.lock held. */
+static void scan_cache_update(const wifi_ap_record_t *ap, int64_t now_us)
+{
+    scan_bss_t *slot = NULL;
+    scan_bss_t *oldest = &s_scan.bss[0];
+    
+    // Hidden networks can't be picked from the list
+    if (ap->ssid[0] == '\0') {
+        return;
+    }
+    
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        scan_bss_t *bss = &s_scan.bss[i];
+        if (bss->rssi_q4 != 0 && memcmp(bss->bssid, ap->bssid, sizeof(bss->bssid)) == 0) {
+            slot = bss;
+            break;
+        }
+        if (bss->rssi_q4 == 0 || (oldest->rssi_q4 != 0 && bss->seen_us < oldest->seen_us)) {
+            oldest = bss;
+        }
+    }
+    
+    int16_t sample = (int16_t)(ap->rssi * (1 << SCAN_RSSI_SHIFT));
+    if (slot == NULL) {
+        slot = oldest;
+        memset(slot, 0, sizeof(*slot));
+        memcpy(slot->bssid, ap->bssid, sizeof(slot->bssid));
+        slot->rssi_q4 = sample;
+    } else {
+        slot->rssi_q4 += (sample - slot->rssi_q4) / (1 << SCAN_RSSI_WEIGHT);
+    }
+    if (slot->rssi_q4 == 0) {
+        slot->rssi_q4 = -1;
+    }
+    
+    strncpy(slot->ssid, (const char *)ap->ssid, NETWORK_SSID_MAX_LEN - 1);
+    slot->ssid[NETWORK_SSID_MAX_LEN - 1] = '\0';
+    slot->channel = ap->primary;
+    slot->auth_mode = convert_auth_mode(ap->authmode);
+    slot->misses = 0;
+    slot->seen_us = now_us;
+}
+
+/* End of a complete scan: forget BSSIDs that keep going unseen */
+static void scan_cache_expire(void)
+{
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        scan_bss_t *bss = &s_scan.bss[i];
+        if (bss->rssi_q4 != 0 && bss->seen_us < s_scan.started_us &&
+            ++bss->misses >= SCAN_CACHE_MAX_MISSES) {
+            memset(bss, 0, sizeof(*bss));
+        }
+    }
+}
+
+/* Merge one cached BSSID into the top-K: one row per SSID, strongest
+ * first, the weakest row falls off a full table. */
+static void scan_top_insert(network_scan_result_t *top, const scan_bss_t *bss)
+{
+    int rssi = bss->rssi_q4 / (1 << SCAN_RSSI_SHIFT);
+    
+    // Same SSID on another BSSID or channel: keep the stronger one
+    for (int i = 0; i < top->count; i++) {
+        if (strncmp(top->networks[i].ssid, bss->ssid, NETWORK_SSID_MAX_LEN) == 0) {
+            if (rssi <= top->networks[i].rssi) {
+                return;
+            }
+            memmove(&top->networks[i], &top->networks[i + 1],
+                    (top->count - i - 1) * sizeof(network_wifi_info_t));
+            top->count--;
+            break;
+        }
+    }
+    
+    int pos = top->count;
+    while (pos > 0 && top->networks[pos - 1].rssi < rssi) {
+        pos--;
+    }
+    if (pos >= NETWORK_MAX_SCAN_RESULTS) {
+        return;
+    }
+    
+    int kept = (top->count < NETWORK_MAX_SCAN_RESULTS) ? top->count : NETWORK_MAX_SCAN_RESULTS - 1;
+    memmove(&top->networks[pos + 1], &top->networks[pos],
+            (kept - pos) * sizeof(network_wifi_info_t));
+    top->count = kept + 1;
+    
+    network_wifi_info_t *net = &top->networks[pos];
+    memset(net, 0, sizeof(*net));
+    strncpy(net->ssid, bss->ssid, NETWORK_SSID_MAX_LEN - 1);
+    net->rssi = rssi;
+    net->channel = bss->channel;
+    net->auth_mode = bss->auth_mode;
+    net->connected = is_connected && strcmp(net->ssid, current_status.wifi.ssid) == 0;
+}
+
+/* Rebuild the top-K from the cache; bars keep their dead band against the
+ * previous table. Call with s_scan.lock held. */
+static void scan_top_rebuild(bool complete)
+{
+    static network_scan_result_t top;
+    
+    memset(&top, 0, sizeof(top));
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++) {
+        if (s_scan.bss[i].rssi_q4 != 0) {
+            scan_top_insert(&top, &s_scan.bss[i]);
+        }
+    }
+    
+    for (int i = 0; i < top.count; i++) {
+        const network_wifi_info_t *prev = scan_top_find(&s_scan.top, top.networks[i].ssid);
+        top.networks[i].bars = rssi_bars(top.networks[i].rssi, prev ? prev->bars : UINT8_MAX);
+    }
+    top.complete = complete;
+    
+    memcpy(&s_scan.top, &top, sizeof(top));
+}
+
+/* Send the current table to subscribers in a loaned buffer */
+static void scan_publish(system_event_type_t event_id)
+{
+    network_scan_result_t *payload = NULL;
+    if (system_event_loan(sizeof(*payload), (void **)&payload) != ESP_OK) {
+        // Partial updates catch up on the next channel
+        if (event_id == NETWORK_EVENT_SCAN_DONE) {
+            ESP_LOGW(TAG, "No event buffer for scan results");
+        }
+        return;
+    }
+    
+    xSemaphoreTake(s_scan.lock, portMAX_DELAY);
+    memcpy(payload, &s_scan.top, sizeof(*payload));
+    xSemaphoreGive(s_scan.lock);
+    
+    system_event_post_loaned(network_service_id,
+                             event_id,
+                             payload, sizeof(*payload),
+                             SYSTEM_EVENT_PRIORITY_NORMAL);
+}
+
+/* Start the asynchronous scan of one channel */
+static esp_err_t scan_channel(uint8_t channel)
+{
+    wifi_scan_config_t scan_config = {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = channel,
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time.active.min = 100,
+        .scan_time.active.max = 300,
+    };
+    
+    return esp_wifi_scan_start(&scan_config, false);
+}
+
+/* One channel finished: merge it and move on to the next */
 static void wifi_scan_done_handler(void* arg, esp_event_base_t event_base,
                                    int32_t event_id, void* event_data)
 {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
-        scan_in_progress = false;
-        ESP_LOGI(TAG, "WiFi scan completed");
-        
-        // Allocate scan result on heap to avoid stack overflow in sys_evt task
-        network_scan_result_t *scan_result = malloc(sizeof(network_scan_result_t));
-        if (scan_result == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate memory for scan results");
-            return;
+    if (event_base != WIFI_EVENT || event_id != WIFI_EVENT_SCAN_DONE || s_scan.channel == 0) {
+        return;
+    }
+    
+    // Copies into our own storage and frees the driver's list
+    uint16_t count = SCAN_RECORDS_PER_CHANNEL;
+    if (esp_wifi_scan_get_ap_records(&count, s_scan.records) != ESP_OK) {
+        count = 0;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    
+    xSemaphoreTake(s_scan.lock, portMAX_DELAY);
+    for (uint16_t i = 0; i < count; i++) {
+        scan_cache_update(&s_scan.records[i], now_us);
+    }
+    
+    uint8_t next = s_scan.channel + 1;
+    bool more = s_scan.channel != 0 && next <= s_scan.last_channel;
+    if (more && scan_channel(next) == ESP_OK) {
+        s_scan.channel = next;
+    } else {
+        more = false;
+        s_scan.channel = 0;
+        s_scan.completed_us = now_us;
+        scan_cache_expire();
+    }
+    scan_top_rebuild(!more);
+    xSemaphoreGive(s_scan.lock);
+    
+    if (more) {
+        if (count > 0) {
+            scan_publish(NETWORK_EVENT_SCAN_UPDATE);
         }
-        
-        // Get and display scan results
-        if (network_scan_wifi(scan_result) == ESP_OK) {
-            ESP_LOGI(TAG, "Found %d WiFi networks:", scan_result->count);
-            for (int i = 0; i < scan_result->count; i++) {
-                const char *auth_str = "OPEN";
-                switch (scan_result->networks[i].auth_mode) {
-                    case NETWORK_AUTH_WEP: auth_str = "WEP"; break;
-                    case NETWORK_AUTH_WPA_PSK: auth_str = "WPA"; break;
-                    case NETWORK_AUTH_WPA2_PSK: auth_str = "WPA2"; break;
-                    case NETWORK_AUTH_WPA_WPA2_PSK: auth_str = "WPA/WPA2"; break;
-                    case NETWORK_AUTH_WPA3_PSK: auth_str = "WPA3"; break;
-                    default: break;
-                }
-                
-                ESP_LOGI(TAG, "  [%d] %s (RSSI: %d dBm, Ch: %d, %s)%s",
-                         i + 1,
-                         scan_result->networks[i].ssid,
-                         scan_result->networks[i].rssi,
-                         scan_result->networks[i].channel,
-                         auth_str,
-                         scan_result->networks[i].connected ? " [CONNECTED]" : "");
-            }
+        return;
+    }
+    
+    xEventGroupSetBits(s_scan.events, SCAN_DONE_BIT);
+    scan_publish(NETWORK_EVENT_SCAN_DONE);
+    system_service_heartbeat(network_service_id);
+    
+    ESP_LOGI(TAG, "✓ WiFi scan complete: %d networks found", s_scan.top.count);
+    for (int i = 0; i < s_scan.top.count; i++) {
+        const network_wifi_info_t *net = &s_scan.top.networks[i];
+        ESP_LOGI(TAG, "  [%d] %s (RSSI: %d dBm, Ch: %d, %s)%s",
+                 i + 1, net->ssid, net->rssi, net->channel,
+                 auth_mode_name(net->auth_mode),
+                 net->connected ? " [CONNECTED]" : "");
+    }
+}
+
+static int fast_cache_find(const char *ssid)
+{
+    for (int i = 0; i < s_conn.cache.count; i++) {
+        if (strncmp(s_conn.cache.entries[i].ssid, ssid, NETWORK_SSID_MAX_LEN) == 0) {
+            return i;
         }
-        
-        // Free heap allocation
-        free(scan_result);
-        
-        // Post scan done event (without data to avoid size limit)
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_SCAN_DONE],
-                         NULL, 0,
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
     }
+    return -1;
+}
+
+static void fast_cache_load(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(FAST_CACHE_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    
+    size_t size = sizeof(s_conn.cache);
+    esp_err_t ret = nvs_get_blob(nvs, FAST_CACHE_KEY, &s_conn.cache, &size);
+    nvs_close(nvs);
+    
+    if (ret != ESP_OK || size != sizeof(s_conn.cache) ||
+        s_conn.cache.version != FAST_CACHE_VERSION || s_conn.cache.count > FAST_CACHE_SIZE) {
+        memset(&s_conn.cache, 0, sizeof(s_conn.cache));
+        return;
+    }
+    
+    ESP_LOGI(TAG, "✓ %d cached networks for fast reconnect", s_conn.cache.count);
+}
+
+static void fast_cache_save(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(FAST_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(nvs, FAST_CACHE_KEY, &s_conn.cache, sizeof(s_conn.cache));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save fast reconnect cache: %s", esp_err_to_name(ret));
+    }
+}
+
+/* Tells whether a cached PMK still belongs to the caller's passphrase */
+static void secret_check(const char *ssid, const char *passphrase, uint8_t out[8])
+{
+    uint8_t buf[NETWORK_SSID_MAX_LEN + NETWORK_PASSWORD_MAX_LEN];
+    size_t ssid_len = strnlen(ssid, NETWORK_SSID_MAX_LEN);
+    size_t pass_len = strnlen(passphrase, NETWORK_PASSWORD_MAX_LEN);
+    uint8_t digest[32];
+    
+    memcpy(buf, ssid, ssid_len);
+    memcpy(buf + ssid_len, passphrase, pass_len);
+    mbedtls_sha256(buf, ssid_len + pass_len, digest, 0);
+    memcpy(out, digest, 8);
+    memset(buf, 0, sizeof(buf));
+}
+
+/* Record the AP that just gave us an IP, most recent first. The PMK is
+ * derived once per passphrase; WPA3 (SAE) has no reusable PSK. */
+static void fast_cache_remember(void)
+{
+    fast_entry_t entry = {0};
+    int idx = fast_cache_find(s_conn.ssid);
+    if (idx >= 0) {
+        entry = s_conn.cache.entries[idx];
+    }
+    
+    strncpy(entry.ssid, s_conn.ssid, NETWORK_SSID_MAX_LEN - 1);
+    memcpy(entry.bssid, s_conn.bssid, sizeof(entry.bssid));
+    entry.channel = s_conn.channel;
+    
+    if (s_conn.passphrase[0] == '\0') {
+        // Joined with a cached PMK, or an open network: nothing new to learn
+        if (!(entry.flags & FAST_HAS_PMK)) {
+            entry.flags = FAST_OPEN;
+        }
+    } else if (current_status.wifi.auth_mode == NETWORK_AUTH_WPA3_PSK) {
+        entry.flags = 0;
+    } else {
+        uint8_t check[8];
+        secret_check(s_conn.ssid, s_conn.passphrase, check);
+        if (!(entry.flags & FAST_HAS_PMK) || memcmp(check, entry.secret_check, sizeof(check)) != 0) {
+            int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                                                    (const unsigned char *)s_conn.passphrase,
+                                                    strlen(s_conn.passphrase),
+                                                    (const unsigned char *)s_conn.ssid,
+                                                    strlen(s_conn.ssid),
+                                                    4096, PMK_LEN, entry.pmk);
+            entry.flags = (ret == 0) ? FAST_HAS_PMK : 0;
+            memcpy(entry.secret_check, check, sizeof(check));
+        }
+    }
+    memset(s_conn.passphrase, 0, sizeof(s_conn.passphrase));
+    
+    fast_cache_t old = s_conn.cache;
+    int shift = (idx >= 0) ? idx : (s_conn.cache.count < FAST_CACHE_SIZE ? s_conn.cache.count : FAST_CACHE_SIZE - 1);
+    memmove(&s_conn.cache.entries[1], &s_conn.cache.entries[0], shift * sizeof(fast_entry_t));
+    s_conn.cache.entries[0] = entry;
+    if (idx < 0 && s_conn.cache.count < FAST_CACHE_SIZE) {
+        s_conn.cache.count++;
+    }
+    s_conn.cache.version = FAST_CACHE_VERSION;
+    
+    // Reconnecting to the same AP changes nothing: spare the flash
+    if (memcmp(&old, &s_conn.cache, sizeof(old)) != 0) {
+        fast_cache_save();
+    }
+}
+
+/* Configure the STA for s_conn.ssid and start joining. CONNECT_FAST uses
+ * the cached BSSID and channel when there are any. */
+static esp_err_t start_connect(connect_attempt_t attempt)
+{
+    wifi_config_t wifi_config = {0};
+    int idx = fast_cache_find(s_conn.ssid);
+    const fast_entry_t *entry = (idx >= 0) ? &s_conn.cache.entries[idx] : NULL;
+    
+    strncpy((char*)wifi_config.sta.ssid, s_conn.ssid, sizeof(wifi_config.sta.ssid) - 1);
+    
+    bool use_pmk = entry != NULL && (entry->flags & FAST_HAS_PMK);
+    if (use_pmk && s_conn.passphrase[0] != '\0') {
+        uint8_t check[8];
+        secret_check(s_conn.ssid, s_conn.passphrase, check);
+        use_pmk = memcmp(check, entry->secret_check, sizeof(check)) == 0;
+    }
+    if (use_pmk) {
+        // 64 hex digits are taken as the PSK itself
+        char *psk = (char*)wifi_config.sta.password;
+        for (int i = 0; i < PMK_LEN; i++) {
+            snprintf(psk + i * 2, 3, "%02x", entry->pmk[i]);
+        }
+    } else {
+        strncpy((char*)wifi_config.sta.password, s_conn.passphrase, sizeof(wifi_config.sta.password) - 1);
+    }
+    
+    if (attempt == CONNECT_FAST && entry != NULL && entry->channel != 0) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, entry->bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = entry->channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        attempt = CONNECT_FULL;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    wifi_config.sta.listen_interval = CONFIG_NETWORK_SERVICE_LISTEN_INTERVAL;
+    wifi_config.sta.pmf_cfg.capable = true;
+    wifi_config.sta.pmf_cfg.required = false;
+    
+    esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    memset(&wifi_config, 0, sizeof(wifi_config));
+    if (ret == ESP_OK) {
+        ret = esp_wifi_connect();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to connect to WiFi: %s", esp_err_to_name(ret));
+        s_conn.attempt = CONNECT_IDLE;
+        memset(s_conn.passphrase, 0, sizeof(s_conn.passphrase));
+        SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_ERROR, SYSTEM_EVENT_PRIORITY_NORMAL);
+        power_locks_sync();
+        return ret;
+    }
+    
+    s_conn.attempt = attempt;
+    power_locks_sync();
+    ESP_LOGI(TAG, "Joining %s (%s)", s_conn.ssid,
+             attempt == CONNECT_FAST ? "cached BSSID/channel" : "full scan");
+    return ESP_OK;
 }
 
 /* WiFi event handler */
@@ -116,23 +616,45 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI(TAG, "WiFi station started");
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "WiFi disconnected");
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+        bool link_lost = is_connected && !s_conn.user_disconnect;
+        
+        ESP_LOGI(TAG, "WiFi disconnected (reason %d)", event->reason);
         
         is_connected = false;
         current_status.wifi.connected = false;
         memset(&current_status.ip_info, 0, sizeof(current_status.ip_info));
         
         // Post disconnected event
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_DISCONNECTED],
-                         NULL, 0,
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
+        SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_DISCONNECTED, SYSTEM_EVENT_PRIORITY_NORMAL);
         
         // Post IP lost event
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_IP_LOST],
-                         NULL, 0,
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
+        SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_IP_LOST, SYSTEM_EVENT_PRIORITY_NORMAL);
+        
+        s_conn.user_disconnect = false;
+        if (s_conn.pending) {
+            // Switching networks: the old link is down now
+            s_conn.pending = false;
+            start_connect(CONNECT_FAST);
+        } else if (s_conn.attempt == CONNECT_FAST) {
+            ESP_LOGI(TAG, "Cached AP unavailable, falling back to a full scan");
+            start_connect(CONNECT_FULL);
+        } else if (s_conn.attempt == CONNECT_FULL) {
+            ESP_LOGW(TAG, "Failed to join %s", s_conn.ssid);
+            s_conn.attempt = CONNECT_IDLE;
+            power_locks_sync();
+            memset(s_conn.passphrase, 0, sizeof(s_conn.passphrase));
+            SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_ERROR, SYSTEM_EVENT_PRIORITY_NORMAL);
+        }
+#if CONFIG_NETWORK_SERVICE_AUTO_RECONNECT
+        else if (link_lost && network_get_auto_reconnect() &&
+                 fast_cache_find(s_conn.ssid) >= 0) {
+            s_conn.start_us = esp_timer_get_time();
+            start_connect(CONNECT_FAST);
+        }
+#else
+        (void)link_lost;
+#endif
         
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
         wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*) event_data;
@@ -143,6 +665,8 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         current_status.wifi.ssid[NETWORK_SSID_MAX_LEN - 1] = '\0';
         current_status.wifi.channel = event->channel;
         current_status.wifi.connected = true;
+        memcpy(s_conn.bssid, event->bssid, sizeof(s_conn.bssid));
+        s_conn.channel = event->channel;
         
         // Get RSSI
         wifi_ap_record_t ap_info;
@@ -154,11 +678,8 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         is_connected = true;
         
         // Post connected event
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_CONNECTED],
-                         &current_status,
-                         sizeof(current_status),
-                         SYSTEM_EVENT_PRIORITY_HIGH);
+        SYSTEM_EVENT_POST_TYPED(network_service_id, NETWORK_EVENT_CONNECTED,
+                                &current_status, SYSTEM_EVENT_PRIORITY_HIGH);
     }
 }
 
@@ -173,17 +694,67 @@ static void ip_event_handler(void* arg, esp_event_base_t event_base,
         current_status.ip_info.netmask = event->ip_info.netmask.addr;
         current_status.ip_info.gateway = event->ip_info.gw.addr;
         
-        ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        current_status.fast_reconnect = (s_conn.attempt == CONNECT_FAST);
+        current_status.time_to_ip_ms = s_conn.start_us ?
+            (uint32_t)((esp_timer_get_time() - s_conn.start_us) / 1000) : 0;
+        s_conn.start_us = 0;
+        
+        ESP_LOGI(TAG, "Got IP: " IPSTR " in %lu ms (%s)", IP2STR(&event->ip_info.ip),
+                 (unsigned long)current_status.time_to_ip_ms,
+                 current_status.fast_reconnect ? "fast reconnect" : "full scan");
         
         // Post IP assigned event
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_IP_ASSIGNED],
-                         &current_status.ip_info,
-                         sizeof(current_status.ip_info),
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
+        SYSTEM_EVENT_POST_TYPED(network_service_id, NETWORK_EVENT_IP_ASSIGNED,
+                                &current_status.ip_info, SYSTEM_EVENT_PRIORITY_NORMAL);
         
         system_service_heartbeat(network_service_id);
+        
+        // After the event: deriving a new PMK takes a while
+        if (s_conn.attempt != CONNECT_IDLE) {
+            s_conn.attempt = CONNECT_IDLE;
+            fast_cache_remember();
+            power_locks_sync();
+        }
+    }
+}
+
+static wifi_ps_type_t power_profile_ps(network_power_profile_t profile)
+{
+    switch (profile) {
+        case NETWORK_POWER_PERFORMANCE: return WIFI_PS_NONE;
+        case NETWORK_POWER_MAX_MODEM: return WIFI_PS_MAX_MODEM;
+        default: return WIFI_PS_MIN_MODEM;
+    }
+}
+
+/* Profile change requests from other services */
+static void power_lock_set(system_power_lock_t lock, bool *held, bool want)
+{
+    if (__atomic_exchange_n(held, want, __ATOMIC_ACQ_REL) == want) {
+        return;
+    }
+    if (want) {
+        system_power_lock_acquire(lock);
+    } else {
+        system_power_lock_release(lock);
+    }
+}
+
+/* Match the power locks to the connect attempt and profile */
+static void power_locks_sync(void)
+{
+    power_lock_set(s_pm.connect, &s_pm.connect_held, s_conn.attempt != CONNECT_IDLE);
+    power_lock_set(s_pm.awake, &s_pm.awake_held, s_power.profile == NETWORK_POWER_PERFORMANCE);
+}
+
+static void power_profile_event_handler(const system_event_t *event, void *user_data)
+{
+    const network_power_profile_t *profile = SYSTEM_EVENT_PAYLOAD(event, NETWORK_EVENT_SET_POWER_PROFILE);
+    if (profile == NULL) {
+        return;
     }
+    
+    network_wifi_set_power_profile(*profile);
 }
 
 /* Initialize WiFi subsystem */
@@ -195,6 +766,8 @@ static esp_err_t init_wifi(void)
     
     ESP_LOGI(TAG, "Initializing WiFi subsystem...");
     
+    boot_trace_id_t phase = boot_trace_begin("wifi_stack");
+    
     // Initialize TCP/IP stack
     ESP_ERROR_CHECK(esp_netif_init());
     
@@ -230,6 +803,15 @@ static esp_err_t init_wifi(void)
     
     // Start WiFi
     ESP_ERROR_CHECK(esp_wifi_start());
+    esp_wifi_set_ps(power_profile_ps(s_power.profile));
+    s_power.since_us = esp_timer_get_time();
+    
+    if (s_pm.connect == NULL) {
+        system_power_lock_create(SYSTEM_POWER_LOCK_CPU_MAX, "wifi_connect", &s_pm.connect);
+        system_power_lock_create(SYSTEM_POWER_LOCK_NO_SLEEP, "wifi_awake", &s_pm.awake);
+    }
+    power_locks_sync();
+    boot_trace_end(phase);
     
     wifi_initialized = true;
     ESP_LOGI(TAG, "✓ WiFi subsystem initialized");
@@ -241,6 +823,19 @@ static esp_err_t init_wifi(void)
 static lv_obj_t *s_network_ui = NULL;
 static system_event_type_t s_menu_network_event = SYSTEM_EVENT_TYPE_INVALID;
 static bool s_network_ui_pending = false;  // Flag to trigger UI creation
+static lv_timer_t *s_ui_loader_timer = NULL;  // Owned by the LVGL task
+
+/* Runs in the LVGL task via the display UI queue; arg is a retained
+ * scan event payload */
+static void network_ui_show_scan(void *arg)
+{
+    const network_scan_result_t *result = arg;
+    if (s_network_ui) {
+        extern void network_ui_update_wifi_list(lv_obj_t *ui, const network_scan_result_t *result);
+        network_ui_update_wifi_list(s_network_ui, result);
+    }
+    system_event_data_release(result);
+}
 
 static void network_menu_event_handler(const system_event_t *event, void *user_data)
 {
@@ -250,16 +845,27 @@ static void network_menu_event_handler(const system_event_t *event, void *user_d
         // Just set a flag - don't create UI here
         s_network_ui_pending = true;
         
-    } else if (event->event_type == network_events[NETWORK_EVENT_SCAN_DONE]) {
-        ESP_LOGI(TAG, "WiFi scan done - updating UI");
+    } else if (event->event_type == NETWORK_EVENT_SCAN_UPDATE ||
+               event->event_type == NETWORK_EVENT_SCAN_DONE) {
+        if (event->data == NULL || event->data_size < sizeof(network_scan_result_t) ||
+            system_event_data_retain(event) != ESP_OK) {
+            return;
+        }
         
-        if (s_network_ui) {
-            extern void network_ui_update_wifi_list(lv_obj_t *ui);
-            network_ui_update_wifi_list(s_network_ui);
+        // Update the list in the LVGL task, handing over the payload itself
+        if (display_ui_call(network_ui_show_scan, event->data) != ESP_OK) {
+            system_event_data_release(event->data);
         }
     }
 }
 
+/* The UI may be deleted by the display service's screen cache */
+static void network_ui_deleted_cb(lv_event_t *e)
+{
+    (void)e;
+    s_network_ui = NULL;
+}
+
 /* Timer callback to create and load network UI in LVGL context */
 static void network_ui_loader_timer_cb(lv_timer_t *timer)
 {
@@ -267,25 +873,51 @@ static void network_ui_loader_timer_cb(lv_timer_t *timer)
         return;
     }
     
-    ESP_LOGI(TAG, "Creating network UI in LVGL context");
+    ESP_LOGI(TAG, "Loading network UI in LVGL context");
     
-    extern esp_err_t display_service_load_screen(lv_obj_t *content);
+    extern esp_err_t display_service_load_screen_cached(lv_obj_t *content, const char *key);
+    extern lv_obj_t* display_service_take_cached_screen(const char *key);
     extern lv_obj_t* display_service_get_main_screen(void);
     extern lv_obj_t* network_ui_create(lv_obj_t *parent);
     
     lv_obj_t *main_screen = display_service_get_main_screen();
     if (main_screen) {
-        // Note: Don't destroy previous UI here - nav_pop() handles cleanup when user goes back
-        // Just create new UI and let the navigation stack manage lifecycle
-        s_network_ui = network_ui_create(main_screen);
+        // Reuse the UI from the last visit if the screen cache still has it;
+        // the navigation stack and cache manage its lifecycle from here
+        s_network_ui = display_service_take_cached_screen("network");
+        if (s_network_ui == NULL) {
+            s_network_ui = network_ui_create(main_screen);
+            if (s_network_ui) {
+                lv_obj_add_event_cb(s_network_ui, network_ui_deleted_cb, LV_EVENT_DELETE, NULL);
+            }
+        }
         if (s_network_ui) {
-            display_service_load_screen(s_network_ui);
+            display_service_load_screen_cached(s_network_ui, "network");
         }
     }
     
     s_network_ui_pending = false;
 }
 
+/* Run in the LVGL task through display_ui_call(), so they hold its lock */
+static void network_ui_loader_add(void *arg)
+{
+    (void)arg;
+    if (s_ui_loader_timer == NULL) {
+        s_ui_loader_timer = lv_timer_create(network_ui_loader_timer_cb, 50, NULL);  // Check every 50ms
+    }
+}
+
+static void network_ui_loader_remove(void *arg)
+{
+    (void)arg;
+    if (s_ui_loader_timer != NULL) {
+        lv_timer_del(s_ui_loader_timer);
+        s_ui_loader_timer = NULL;
+    }
+    s_network_ui_pending = false;
+}
+
 esp_err_t network_service_init(void)
 {
     if (initialized) {
@@ -297,6 +929,14 @@ esp_err_t network_service_init(void)
     
     ESP_LOGI(TAG, "Initializing network service...");
     
+    s_scan.lock = xSemaphoreCreateMutex();
+    s_scan.events = xEventGroupCreate();
+    if (s_scan.lock == NULL || s_scan.events == NULL) {
+        ESP_LOGE(TAG, "Failed to create scan state");
+        ret = ESP_ERR_NO_MEM;
+        goto fail_scan;
+    }
+    
     // Initialize NVS (required for WiFi)
     ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -305,37 +945,36 @@ esp_err_t network_service_init(void)
     }
     ESP_ERROR_CHECK(ret);
     
+    fast_cache_load();
+    
     // Register with system service
     ret = system_service_register("network_service", NULL, &network_service_id);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register with system service: %s", esp_err_to_name(ret));
-        return ret;
+        goto fail_scan;
     }
     
     ESP_LOGI(TAG, "✓ Registered with system service (ID: %d)", network_service_id);
     
-    // Register event types
-    const char *event_names[] = {
-        "network.registered",
-        "network.started",
-        "network.stopped",
-        "network.connected",
-        "network.disconnected",
-        "network.ip_assigned",
-        "network.ip_lost",
-        "network.scan_done",
-        "network.error"
-    };
+#if CONFIG_NETWORK_SERVICE_AUTO_RECONNECT
+    system_setting_register(network_service_id, "net.autojoin", SYSTEM_SETTING_BOOL,
+                            true, &autojoin_setting);
+#endif
     
-    for (int i = 0; i < 9; i++) {
-        ret = system_event_register_type(event_names[i], &network_events[i]);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to register event type '%s'", event_names[i]);
-            return ret;
-        }
+    // Register event types
+    ret = SYSTEM_EVENT_SCHEMA_REGISTER(NETWORK_EVENT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register event types: %s", esp_err_to_name(ret));
+        goto fail_registered;
     }
     
-    ESP_LOGI(TAG, "✓ Registered %d event types", 9);
+    ESP_LOGI(TAG, "✓ Registered %d event types", NETWORK_EVENT_COUNT);
+    
+    ret = network_download_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register download events: %s", esp_err_to_name(ret));
+        goto fail_registered;
+    }
     
     // Subscribe to menu events (get event type registered by display service)
     system_event_register_type("menu.network_clicked", &s_menu_network_event);
@@ -344,17 +983,29 @@ esp_err_t network_service_init(void)
         ESP_LOGI(TAG, "✓ Subscribed to menu.network_clicked event");
     }
     
-    // Subscribe to own scan_done event to update UI
-    ret = system_event_subscribe(network_service_id, network_events[NETWORK_EVENT_SCAN_DONE], network_menu_event_handler, NULL);
+    ret = system_event_subscribe(network_service_id, NETWORK_EVENT_SET_POWER_PROFILE,
+                                 power_profile_event_handler, NULL);
+    if (ret == ESP_OK) {
+        // Calls into the WiFi driver, whose task is on core 0
+        system_event_set_affinity(network_service_id, NETWORK_EVENT_SET_POWER_PROFILE,
+                                  SYSTEM_EVENT_AFFINITY_CORE0);
+        ESP_LOGI(TAG, "✓ Subscribed to network.set_power_profile requests");
+    }
+    
+    // Subscribe to own scan results to update UI
+    ret = system_event_subscribe(network_service_id, NETWORK_EVENT_SCAN_UPDATE, network_menu_event_handler, NULL);
+    if (ret == ESP_OK) {
+        ret = system_event_subscribe(network_service_id, NETWORK_EVENT_SCAN_DONE, network_menu_event_handler, NULL);
+    }
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "✓ Subscribed to network.scan_done event");
+        ESP_LOGI(TAG, "✓ Subscribed to network scan events");
     }
     
     // Initialize WiFi
     ret = init_wifi();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize WiFi");
-        return ret;
+        goto fail_registered;
     }
     
     // Set service state
@@ -363,15 +1014,26 @@ esp_err_t network_service_init(void)
     initialized = true;
     
     // Post registration event
-    system_event_post(network_service_id,
-                     network_events[NETWORK_EVENT_REGISTERED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_REGISTERED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Network service initialized successfully");
     ESP_LOGI(TAG, "  → Posted NETWORK_EVENT_REGISTERED");
     
     return ESP_OK;
+    
+    // Leave nothing behind, so a later init (an activation retry) starts clean
+fail_registered:
+    // Also drops the subscriptions
+    system_service_unregister(network_service_id);
+fail_scan:
+    if (s_scan.lock != NULL) {
+        vSemaphoreDelete(s_scan.lock);
+    }
+    if (s_scan.events != NULL) {
+        vEventGroupDelete(s_scan.events);
+    }
+    memset(&s_scan, 0, sizeof(s_scan));
+    return ret;
 }
 
 esp_err_t network_service_deinit(void)
@@ -382,6 +1044,9 @@ esp_err_t network_service_deinit(void)
     
     ESP_LOGI(TAG, "Deinitializing network service...");
     
+    // No-op when stop already removed it
+    display_ui_call(network_ui_loader_remove, NULL);
+    
     // Disconnect if connected
     if (is_connected) {
         network_disconnect_wifi();
@@ -389,23 +1054,26 @@ esp_err_t network_service_deinit(void)
     
     // Stop WiFi
     if (wifi_initialized) {
+        if (s_scan.channel != 0) {
+            s_scan.channel = 0;
+            esp_wifi_scan_stop();
+        }
         esp_wifi_stop();
         esp_wifi_deinit();
         
         // Unregister event handlers
         esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instance_got_ip);
         esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, instance_any_id);
+        esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE, instance_scan_done);
         
         esp_netif_destroy_default_wifi(sta_netif);
         
         wifi_initialized = false;
     }
     
-    // Free scan records if allocated
-    if (scan_records) {
-        free(scan_records);
-        scan_records = NULL;
-    }
+    vSemaphoreDelete(s_scan.lock);
+    vEventGroupDelete(s_scan.events);
+    memset(&s_scan, 0, sizeof(s_scan));
     
     system_service_unregister(network_service_id);
     initialized = false;
@@ -423,22 +1091,39 @@ esp_err_t network_service_start(void)
     
     ESP_LOGI(TAG, "Starting network service...");
     
-    // Create periodic timer to check for pending UI operations
-    // This runs in LVGL task context
-    extern lv_timer_t* lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void *user_data);
-    lv_timer_create(network_ui_loader_timer_cb, 50, NULL);  // Check every 50ms
+    // Periodic timer to check for pending UI operations, in the LVGL task;
+    // start may run again after the service was idled down, so only one is kept
+    if (display_ui_call(network_ui_loader_add, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "UI loader timer not queued");
+    }
     
     system_service_set_state(network_service_id, SYSTEM_SERVICE_STATE_RUNNING);
     
     // Post started event
-    system_event_post(network_service_id,
-                     network_events[NETWORK_EVENT_STARTED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_STARTED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Network service started");
     ESP_LOGI(TAG, "  → Posted NETWORK_EVENT_STARTED");
     
+#if CONFIG_NETWORK_TELEMETRY
+    if (network_telemetry_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry not started");
+    }
+#endif
+    
+#if CONFIG_NETWORK_BRIDGE
+    if (network_bridge_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Event bridge not started");
+    }
+#endif
+    
+#if CONFIG_NETWORK_SERVICE_AUTO_RECONNECT
+    // Rejoin the last network without scanning
+    if (network_get_auto_reconnect() && network_connect_last() == ESP_ERR_NOT_FOUND) {
+        ESP_LOGI(TAG, "No cached network to rejoin");
+    }
+#endif
+    
     // Disabled: Automatically scan for WiFi networks on startup
     // Uncomment below to enable auto-scan on boot
     /*
@@ -452,11 +1137,9 @@ esp_err_t network_service_start(void)
         // Don't set scan_time - let WiFi use default timing for BT coexistence
     };
     
-    scan_in_progress = true;
     esp_err_t scan_ret = esp_wifi_scan_start(&scan_config, false);  // false = async
     if (scan_ret != ESP_OK) {
         ESP_LOGW(TAG, "Failed to start WiFi scan: %s", esp_err_to_name(scan_ret));
-        scan_in_progress = false;
     }
     */
     
@@ -471,6 +1154,14 @@ esp_err_t network_service_stop(void)
     
     ESP_LOGI(TAG, "Stopping network service...");
     
+    network_telemetry_stop();
+    network_bridge_stop();
+    
+    // Nothing left to load the UI for until the next start
+    if (display_ui_call(network_ui_loader_remove, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "UI loader timer removal not queued");
+    }
+    
     // Disconnect if connected
     if (is_connected) {
         network_disconnect_wifi();
@@ -479,134 +1170,101 @@ esp_err_t network_service_stop(void)
     system_service_set_state(network_service_id, SYSTEM_SERVICE_STATE_STOPPING);
     
     // Post stopped event
-    system_event_post(network_service_id,
-                     network_events[NETWORK_EVENT_STOPPED],
-                     NULL, 0,
-                     SYSTEM_EVENT_PRIORITY_NORMAL);
+    SYSTEM_EVENT_POST_EMPTY(network_service_id, NETWORK_EVENT_STOPPED, SYSTEM_EVENT_PRIORITY_NORMAL);
     
     ESP_LOGI(TAG, "✓ Network service stopped");
     
     return ESP_OK;
 }
 
-esp_err_t network_scan_wifi(network_scan_result_t *result)
+esp_err_t network_scan_start(void)
 {
-    if (!initialized || !wifi_initialized || result == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (!initialized || !wifi_initialized) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "Scanning for WiFi networks...");
-    
-    memset(result, 0, sizeof(network_scan_result_t));
-    
-    // If scan already in progress, wait for it
-    if (scan_in_progress) {
-        ESP_LOGI(TAG, "Scan already in progress, waiting...");
-        // Wait up to 15 seconds for scan to complete
-        for (int i = 0; i < 150 && scan_in_progress; i++) {
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        if (scan_in_progress) {
-            ESP_LOGW(TAG, "Scan timeout");
-            return ESP_ERR_TIMEOUT;
-        }
-    } else {
-        // Start new scan (blocking)
-        wifi_scan_config_t scan_config = {
-            .ssid = NULL,
-            .bssid = NULL,
-            .channel = 0,
-            .show_hidden = false,
-            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-            .scan_time.active.min = 100,
-            .scan_time.active.max = 300,
-        };
-        
-        scan_in_progress = true;
-        esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
-        scan_in_progress = false;
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to start WiFi scan: %s", esp_err_to_name(ret));
-            return ret;
-        }
+    // Scan the channels the regulatory domain allows
+    uint8_t first = 1;
+    uint8_t last = 13;
+    wifi_country_t country;
+    if (esp_wifi_get_country(&country) == ESP_OK && country.nchan > 0) {
+        first = country.schan;
+        last = country.schan + country.nchan - 1;
     }
     
-    // Get scan results
-    uint16_t ap_count = 0;
-    esp_wifi_scan_get_ap_num(&ap_count);
-    
-    if (ap_count == 0) {
-        ESP_LOGW(TAG, "No WiFi networks found");
+    xSemaphoreTake(s_scan.lock, portMAX_DELAY);
+    if (s_scan.channel != 0) {
+        xSemaphoreGive(s_scan.lock);
         return ESP_OK;
     }
     
-    // Allocate memory for scan records
-    if (scan_records) {
-        free(scan_records);
+    // Fresh enough: answer from the cache and leave the radio alone
+    int64_t now_us = esp_timer_get_time();
+    if (s_scan.completed_us != 0 &&
+        now_us - s_scan.completed_us < (int64_t)CONFIG_NETWORK_SERVICE_SCAN_CACHE_TTL_S * 1000000) {
+        scan_top_rebuild(true);
+        xSemaphoreGive(s_scan.lock);
+        
+        ESP_LOGI(TAG, "WiFi scan served from cache (%lld s old)",
+                 (now_us - s_scan.completed_us) / 1000000);
+        xEventGroupSetBits(s_scan.events, SCAN_DONE_BIT);
+        scan_publish(NETWORK_EVENT_SCAN_DONE);
+        return ESP_OK;
     }
-    scan_records = malloc(sizeof(wifi_ap_record_t) * ap_count);
-    if (scan_records == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for scan results");
-        return ESP_ERR_NO_MEM;
+    
+    // The previous results stay up while the new ones stream in
+    s_scan.top.complete = false;
+    xEventGroupClearBits(s_scan.events, SCAN_DONE_BIT);
+    s_scan.last_channel = last;
+    s_scan.started_us = now_us;
+    
+    esp_err_t ret = scan_channel(first);
+    if (ret == ESP_OK) {
+        s_scan.channel = first;
     }
+    xSemaphoreGive(s_scan.lock);
     
-    // Get AP records
-    scan_count = ap_count;
-    esp_err_t ret = esp_wifi_scan_get_ap_records(&scan_count, scan_records);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get scan records: %s", esp_err_to_name(ret));
-        free(scan_records);
-        scan_records = NULL;
+        ESP_LOGE(TAG, "Failed to start WiFi scan: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Convert to our format
-    result->count = (scan_count > NETWORK_MAX_SCAN_RESULTS) ? NETWORK_MAX_SCAN_RESULTS : scan_count;
-    
-    for (int i = 0; i < result->count; i++) {
-        strncpy(result->networks[i].ssid, (char*)scan_records[i].ssid, NETWORK_SSID_MAX_LEN - 1);
-        result->networks[i].ssid[NETWORK_SSID_MAX_LEN - 1] = '\0';
-        result->networks[i].rssi = scan_records[i].rssi;
-        result->networks[i].channel = scan_records[i].primary;
-        result->networks[i].auth_mode = convert_auth_mode(scan_records[i].authmode);
-        result->networks[i].connected = false;
-        
-        // Mark current network as connected
-        if (is_connected && strcmp(result->networks[i].ssid, current_status.wifi.ssid) == 0) {
-            result->networks[i].connected = true;
-        }
+    ESP_LOGI(TAG, "Scanning for WiFi networks (channels %d-%d)...", first, last);
+    return ESP_OK;
+}
+
+esp_err_t network_scan_get_results(network_scan_result_t *result)
+{
+    if (!initialized || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Sort networks by signal strength (RSSI descending)
-    qsort(result->networks, result->count, sizeof(network_wifi_info_t), compare_rssi);
+    xSemaphoreTake(s_scan.lock, portMAX_DELAY);
+    memcpy(result, &s_scan.top, sizeof(*result));
+    xSemaphoreGive(s_scan.lock);
     
-    // Note: NETWORK_EVENT_SCAN_DONE is posted by wifi_scan_done_handler
-    // We don't post scan results here to avoid event bus size limit (512 bytes)
+    return ESP_OK;
+}
+
+esp_err_t network_scan_wifi(network_scan_result_t *result)
+{
+    if (!initialized || !wifi_initialized || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    system_service_heartbeat(network_service_id);
+    esp_err_t ret = network_scan_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
-    ESP_LOGI(TAG, "✓ WiFi scan complete: %d networks found", result->count);
-    for (int i = 0; i < result->count; i++) {
-        const char *auth_str = "OPEN";
-        switch (result->networks[i].auth_mode) {
-            case NETWORK_AUTH_WEP: auth_str = "WEP"; break;
-            case NETWORK_AUTH_WPA_PSK: auth_str = "WPA"; break;
-            case NETWORK_AUTH_WPA2_PSK: auth_str = "WPA2"; break;
-            case NETWORK_AUTH_WPA_WPA2_PSK: auth_str = "WPA/WPA2"; break;
-            case NETWORK_AUTH_WPA3_PSK: auth_str = "WPA3"; break;
-            default: break;
-        }
-        
-        ESP_LOGI(TAG, "  [%d] %s (RSSI: %d dBm, Ch: %d, %s)%s",
-                 i + 1,
-                 result->networks[i].ssid,
-                 result->networks[i].rssi,
-                 result->networks[i].channel,
-                 auth_str,
-                 result->networks[i].connected ? " [CONNECTED]" : "");
+    EventBits_t bits = xEventGroupWaitBits(s_scan.events, SCAN_DONE_BIT, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(SCAN_TIMEOUT_MS));
+    if (!(bits & SCAN_DONE_BIT)) {
+        ESP_LOGW(TAG, "Scan timeout");
+        return ESP_ERR_TIMEOUT;
     }
     
-    return ESP_OK;
+    return network_scan_get_results(result);
 }
 
 esp_err_t network_connect_wifi(const char *ssid, const char *password)
@@ -617,43 +1275,64 @@ esp_err_t network_connect_wifi(const char *ssid, const char *password)
     
     ESP_LOGI(TAG, "Connecting to WiFi: %s", ssid);
     
-    // Disconnect from current network if connected
+    memset(&s_conn.ssid, 0, sizeof(s_conn.ssid));
+    memset(&s_conn.passphrase, 0, sizeof(s_conn.passphrase));
+    strncpy(s_conn.ssid, ssid, sizeof(s_conn.ssid) - 1);
+    if (password != NULL) {
+        strncpy(s_conn.passphrase, password, sizeof(s_conn.passphrase) - 1);
+    }
+    s_conn.start_us = esp_timer_get_time();
+    
+    // Disconnect from current network first; the connect follows from the
+    // disconnected event instead of a fixed delay
     if (is_connected) {
         ESP_LOGI(TAG, "Disconnecting from current network first...");
+        s_conn.pending = true;
+        s_conn.user_disconnect = true;
         esp_wifi_disconnect();
-        vTaskDelay(pdMS_TO_TICKS(100));
+        return ESP_OK;
     }
     
-    // Configure WiFi connection
-    wifi_config_t wifi_config = {0};
-    
-    strncpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    if (password != NULL) {
-        strncpy((char*)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
+    esp_err_t ret = start_connect(CONNECT_FAST);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "WiFi connection initiated...");
     }
-    
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    wifi_config.sta.pmf_cfg.capable = true;
-    wifi_config.sta.pmf_cfg.required = false;
-    
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    
-    // Connect to AP
-    esp_err_t ret = esp_wifi_connect();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to connect to WiFi: %s", esp_err_to_name(ret));
-        
-        // Post error event
-        system_event_post(network_service_id,
-                         network_events[NETWORK_EVENT_ERROR],
-                         NULL, 0,
-                         SYSTEM_EVENT_PRIORITY_NORMAL);
-        return ret;
+    return ret;
+}
+
+esp_err_t network_connect_last(void)
+{
+    if (!initialized || !wifi_initialized) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "WiFi connection initiated...");
+    const fast_entry_t *entry = &s_conn.cache.entries[0];
+    if (s_conn.cache.count == 0 || !(entry->flags & (FAST_HAS_PMK | FAST_OPEN))) {
+        return ESP_ERR_NOT_FOUND;
+    }
     
-    return ESP_OK;
+    // The cached PMK stands in for the passphrase
+    return network_connect_wifi(entry->ssid, NULL);
+}
+
+esp_err_t network_set_auto_reconnect(bool enable)
+{
+#if CONFIG_NETWORK_SERVICE_AUTO_RECONNECT
+    return system_setting_set_bool(autojoin_setting, enable);
+#else
+    (void)enable;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+bool network_get_auto_reconnect(void)
+{
+#if CONFIG_NETWORK_SERVICE_AUTO_RECONNECT
+    // On if the settings store was unavailable at init
+    return autojoin_setting == SYSTEM_SETTING_ID_INVALID || system_setting_bool(autojoin_setting);
+#else
+    return false;
+#endif
 }
 
 esp_err_t network_disconnect_wifi(void)
@@ -669,6 +1348,11 @@ esp_err_t network_disconnect_wifi(void)
     
     ESP_LOGI(TAG, "Disconnecting from WiFi: %s", current_status.wifi.ssid);
     
+    s_conn.user_disconnect = true;
+    s_conn.pending = false;
+    s_conn.attempt = CONNECT_IDLE;
+    power_locks_sync();
+    
     esp_err_t ret = esp_wifi_disconnect();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to disconnect: %s", esp_err_to_name(ret));
@@ -695,6 +1379,74 @@ bool network_is_connected(void)
     return is_connected;
 }
 
+esp_err_t network_wifi_set_power_profile(network_power_profile_t profile)
+{
+    if (profile >= NETWORK_POWER_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!initialized || !wifi_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (profile == s_power.profile) {
+        return ESP_OK;
+    }
+    
+    // Refused with WIFI_PS_NONE while Bluetooth shares the radio
+    esp_err_t ret = esp_wifi_set_ps(power_profile_ps(profile));
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Power profile %s refused: %s", power_profile_names[profile], esp_err_to_name(ret));
+        return ret;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    network_power_profile_t previous;
+    
+    portENTER_CRITICAL(&s_power.lock);
+    previous = s_power.profile;
+    s_power.time_us[previous] += now_us - s_power.since_us;
+    s_power.since_us = now_us;
+    s_power.profile = profile;
+    s_power.switches++;
+    portEXIT_CRITICAL(&s_power.lock);
+    
+    power_locks_sync();
+    
+    ESP_LOGI(TAG, "WiFi power profile: %s -> %s",
+             power_profile_names[previous], power_profile_names[profile]);
+    
+    SYSTEM_EVENT_POST_TYPED(network_service_id, NETWORK_EVENT_POWER_PROFILE,
+                            &profile, SYSTEM_EVENT_PRIORITY_NORMAL);
+    return ESP_OK;
+}
+
+network_power_profile_t network_wifi_get_power_profile(void)
+{
+    return s_power.profile;
+}
+
+esp_err_t network_wifi_get_power_stats(network_power_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_power.lock);
+    stats->profile = s_power.profile;
+    stats->switches = s_power.switches;
+    for (int i = 0; i < NETWORK_POWER_PROFILE_COUNT; i++) {
+        uint64_t us = s_power.time_us[i];
+        if (i == s_power.profile && s_power.since_us != 0) {
+            us += now_us - s_power.since_us;
+        }
+        stats->time_ms[i] = us / 1000;
+    }
+    portEXIT_CRITICAL(&s_power.lock);
+    
+    return ESP_OK;
+}
+
 system_service_id_t network_service_get_id(void)
 {
     return network_service_id;
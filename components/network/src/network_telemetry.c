@@ -0,0 +1,491 @@
+#include "network_telemetry.h"
+#include "network_service.h"
+#include "system_service/system_metrics.h"
+#include "system_service/service_manager.h"
+#include "system_service/static_alloc.h"
+#include "system_service/system_trace.h"
+#include "system_service/flight_recorder.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_heap_caps.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static const char *TAG = "network_telemetry";
+
+#if CONFIG_NETWORK_TELEMETRY
+
+/* One datagram per interval, built in place in s_frame. The frame stays
+ * under the Ethernet MTU so it is never fragmented; services that don't
+ * fit are left out of that frame. */
+#define TELEMETRY_FRAME_MAX     1400
+#define TELEMETRY_NAMES_EVERY   30          // Frames between service name tables
+#define TELEMETRY_TASK_STACK    3072
+
+typedef struct {
+    uint8_t *pos;
+    uint8_t *end;
+    uint8_t sections;
+} frame_writer_t;
+
+typedef struct {
+    bool running;
+    int sock;
+    struct sockaddr_in dest;
+    bool resolved;
+    uint32_t sequence;
+    uint8_t mac[6];
+    network_telemetry_stats_t stats;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped;
+} telemetry_t;
+
+static telemetry_t s_tm = { .sock = -1 };
+
+// Static storage, so a send costs no allocation
+static uint8_t s_frame[TELEMETRY_FRAME_MAX];
+static system_service_info_t s_services[SYSTEM_SERVICE_MAX_SERVICES];
+static memory_pool_stats_t s_pools[SYSTEM_METRICS_MAX_POOLS];
+
+SYSTEM_TASK_DEFINE(s_telemetry_task, TELEMETRY_TASK_STACK);
+SYSTEM_SEMAPHORE_DEFINE(s_telemetry_stopped);
+
+/* Open a section of `count` records of `size` bytes; NULL if it won't fit */
+static void *section_begin(frame_writer_t *w, uint8_t type, uint8_t count, size_t size)
+{
+    size_t length = (size_t)count * size;
+    if (count == 0 || w->pos + sizeof(network_telemetry_section_t) + length > w->end) {
+        return NULL;
+    }
+    
+    network_telemetry_section_t section = {
+        .type = type,
+        .count = count,
+        .length = (uint16_t)length,
+    };
+    memcpy(w->pos, &section, sizeof(section));
+    void *records = w->pos + sizeof(section);
+    memset(records, 0, length);
+    w->pos += sizeof(section) + length;
+    w->sections++;
+    return records;
+}
+
+/* How many records of `size` bytes still fit after a section header */
+static uint8_t section_room(const frame_writer_t *w, size_t size)
+{
+    size_t room = w->end - w->pos;
+    if (room <= sizeof(network_telemetry_section_t)) {
+        return 0;
+    }
+    room = (room - sizeof(network_telemetry_section_t)) / size;
+    return room > UINT8_MAX ? UINT8_MAX : (uint8_t)room;
+}
+
+static void pack_global(frame_writer_t *w)
+{
+    global_metrics_t metrics;
+    if (system_metrics_get_global(&metrics) != ESP_OK) {
+        return;
+    }
+    
+    network_telemetry_global_t *g = section_begin(w, NETWORK_TELEMETRY_SECTION_GLOBAL, 1, sizeof(*g));
+    if (g == NULL) {
+        return;
+    }
+    g->total_services = metrics.total_services;
+    g->running_services = metrics.running_services;
+    g->error_services = metrics.error_services;
+    g->events_processed = (uint32_t)metrics.total_events_processed;
+    g->avg_event_latency_us = metrics.avg_event_latency_us;
+    g->max_event_latency_us = metrics.max_event_latency_us;
+    g->queue_depth = metrics.event_queue_depth;
+    g->queue_overflows = metrics.event_queue_overflows;
+    g->service_restarts = metrics.service_restarts;
+    g->watchdog_timeouts = metrics.watchdog_timeouts;
+}
+
+static void pack_queue(frame_writer_t *w)
+{
+    event_queue_stats_t stats;
+    if (system_metrics_get_queue(&stats) != ESP_OK) {
+        return;
+    }
+    
+    network_telemetry_queue_t *q = section_begin(w, NETWORK_TELEMETRY_SECTION_QUEUE, 1, sizeof(*q));
+    if (q == NULL) {
+        return;
+    }
+    q->depth[0] = stats.high_priority_depth;
+    q->depth[1] = stats.normal_priority_depth;
+    q->depth[2] = stats.low_priority_depth;
+    q->overflows[0] = stats.high_priority_overflows;
+    q->overflows[1] = stats.normal_priority_overflows;
+    q->overflows[2] = stats.low_priority_overflows;
+    q->low_priority_drops = stats.low_priority_drops;
+    q->total_queued = (uint32_t)stats.total_events_queued;
+    q->total_processed = (uint32_t)stats.total_events_processed;
+}
+
+static void pack_heap(frame_writer_t *w)
+{
+    network_telemetry_heap_t *h = section_begin(w, NETWORK_TELEMETRY_SECTION_HEAP, 1, sizeof(*h));
+    if (h == NULL) {
+        return;
+    }
+    h->internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    h->internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    h->internal_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    h->psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    h->psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    h->psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+}
+
+static void pack_pools(frame_writer_t *w)
+{
+    size_t count = 0;
+    if (system_metrics_get_pools(s_pools, SYSTEM_METRICS_MAX_POOLS, &count) != ESP_OK) {
+        return;
+    }
+    
+    network_telemetry_pool_t *p = section_begin(w, NETWORK_TELEMETRY_SECTION_POOLS, count, sizeof(*p));
+    for (size_t i = 0; p != NULL && i < count; i++) {
+        p[i].pool_size = s_pools[i].pool_size;
+        p[i].blocks_used = s_pools[i].blocks_used;
+        p[i].high_water_mark = s_pools[i].high_water_mark;
+        p[i].allocations = s_pools[i].total_allocations;
+        p[i].failures = s_pools[i].allocation_failures;
+    }
+}
+
+static void pack_services(frame_writer_t *w, bool with_names)
+{
+    uint32_t count = 0;
+    if (system_service_list_all(s_services, SYSTEM_SERVICE_MAX_SERVICES, &count) != ESP_OK) {
+        return;
+    }
+    
+    uint8_t fit = section_room(w, sizeof(network_telemetry_service_t));
+    uint8_t n = (count < fit) ? count : fit;
+    network_telemetry_service_t *s = section_begin(w, NETWORK_TELEMETRY_SECTION_SERVICES, n, sizeof(*s));
+    for (uint8_t i = 0; s != NULL && i < n; i++) {
+        service_metrics_t metrics;
+        s[i].service_id = s_services[i].service_id;
+        s[i].state = s_services[i].state;
+        if (system_metrics_get_service(s_services[i].service_id, &metrics) == ESP_OK) {
+            s[i].handler_timeouts = metrics.handler_timeouts > UINT16_MAX ? UINT16_MAX : metrics.handler_timeouts;
+            s[i].events_posted = (uint32_t)metrics.total_events_posted;
+            s[i].events_received = (uint32_t)metrics.total_events_received;
+            s[i].avg_handler_us = metrics.avg_handler_time_us;
+            s[i].max_handler_us = metrics.max_handler_time_us;
+            s[i].quota_violations = metrics.quota_violations;
+            s[i].memory_bytes = (uint32_t)metrics.total_memory_allocated;
+        }
+    }
+    
+    if (!with_names) {
+        return;
+    }
+    
+    fit = section_room(w, sizeof(network_telemetry_name_t));
+    n = (count < fit) ? count : fit;
+    network_telemetry_name_t *names = section_begin(w, NETWORK_TELEMETRY_SECTION_NAMES, n, sizeof(*names));
+    for (uint8_t i = 0; names != NULL && i < n; i++) {
+        names[i].service_id = s_services[i].service_id;
+        strncpy(names[i].name, s_services[i].name, sizeof(names[i].name));
+    }
+}
+
+static size_t build_frame(void)
+{
+    frame_writer_t w = {
+        .pos = s_frame + sizeof(network_telemetry_header_t),
+        .end = s_frame + sizeof(s_frame),
+    };
+    
+    pack_global(&w);
+    pack_queue(&w);
+    pack_heap(&w);
+    pack_pools(&w);
+    pack_services(&w, s_tm.sequence % TELEMETRY_NAMES_EVERY == 0);
+    
+    network_telemetry_header_t header = {
+        .magic = NETWORK_TELEMETRY_MAGIC,
+        .version = NETWORK_TELEMETRY_VERSION,
+        .length = (uint16_t)(w.pos - s_frame),
+        .sequence = s_tm.sequence++,
+        .uptime_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .section_count = w.sections,
+    };
+    memcpy(header.device, s_tm.mac, sizeof(header.device));
+    memcpy(s_frame, &header, sizeof(header));
+    
+    return header.length;
+}
+
+/* Look the collector up once; retried each interval until it succeeds */
+static bool resolve_collector(void)
+{
+    if (s_tm.resolved) {
+        return true;
+    }
+    
+    s_tm.dest.sin_family = AF_INET;
+    s_tm.dest.sin_port = htons(CONFIG_NETWORK_TELEMETRY_PORT);
+    if (inet_pton(AF_INET, CONFIG_NETWORK_TELEMETRY_HOST, &s_tm.dest.sin_addr) != 1) {
+        const struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+        struct addrinfo *res = NULL;
+        if (getaddrinfo(CONFIG_NETWORK_TELEMETRY_HOST, NULL, &hints, &res) != 0 || res == NULL) {
+            return false;
+        }
+        s_tm.dest.sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+        freeaddrinfo(res);
+    }
+    
+    s_tm.resolved = true;
+    ESP_LOGI(TAG, "Sending telemetry to %s:%d every %d ms", CONFIG_NETWORK_TELEMETRY_HOST,
+             CONFIG_NETWORK_TELEMETRY_PORT, CONFIG_NETWORK_TELEMETRY_INTERVAL_MS);
+    return true;
+}
+
+static void telemetry_task(void *arg)
+{
+    while (s_tm.running) {
+        // Sleeps the interval unless network_telemetry_stop() wakes it
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_NETWORK_TELEMETRY_INTERVAL_MS));
+        if (!s_tm.running || !network_is_connected() || !resolve_collector()) {
+            continue;
+        }
+    
+        size_t len = build_frame();
+        int sent = sendto(s_tm.sock, s_frame, len, 0, (struct sockaddr *)&s_tm.dest, sizeof(s_tm.dest));
+        if (sent == (int)len) {
+            s_tm.stats.frames_sent++;
+            s_tm.stats.last_frame_bytes = len;
+        } else {
+            s_tm.stats.send_errors++;
+        }
+    }
+    
+    xSemaphoreGive(s_tm.stopped);
+    vTaskDelete(NULL);
+}
+
+esp_err_t network_telemetry_start(void)
+{
+    if (s_tm.running) {
+        return ESP_OK;
+    }
+    if (CONFIG_NETWORK_TELEMETRY_HOST[0] == '\0') {
+        ESP_LOGW(TAG, "No telemetry collector configured");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    s_tm.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s_tm.sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+    
+    // A full send buffer drops this frame rather than stalling the task
+    int flags = fcntl(s_tm.sock, F_GETFL, 0);
+    fcntl(s_tm.sock, F_SETFL, flags | O_NONBLOCK);
+    
+    esp_read_mac(s_tm.mac, ESP_MAC_WIFI_STA);
+    s_tm.resolved = false;
+    s_tm.stopped = SYSTEM_BINARY_CREATE(s_telemetry_stopped);
+    s_tm.running = true;
+    
+    BaseType_t created = SYSTEM_TASK_CREATE(s_telemetry_task, telemetry_task, "net_telemetry",
+                                            TELEMETRY_TASK_STACK, NULL, 1, &s_tm.task);
+    if (created != pdPASS) {
+        s_tm.running = false;
+        vSemaphoreDelete(s_tm.stopped);
+        close(s_tm.sock);
+        s_tm.sock = -1;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t network_telemetry_stop(void)
+{
+    if (!s_tm.running) {
+        return ESP_OK;
+    }
+    
+    s_tm.running = false;
+    xTaskNotifyGive(s_tm.task);
+    xSemaphoreTake(s_tm.stopped, portMAX_DELAY);
+    vSemaphoreDelete(s_tm.stopped);
+    s_tm.task = NULL;
+    
+    close(s_tm.sock);
+    s_tm.sock = -1;
+    
+    ESP_LOGI(TAG, "Telemetry stopped after %lu frames", (unsigned long)s_tm.stats.frames_sent);
+    return ESP_OK;
+}
+
+esp_err_t network_telemetry_get_stats(network_telemetry_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *stats = s_tm.stats;
+    return ESP_OK;
+}
+
+#else // !CONFIG_NETWORK_TELEMETRY
+
+esp_err_t network_telemetry_start(void)
+{
+    ESP_LOGD(TAG, "Telemetry disabled");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t network_telemetry_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t network_telemetry_get_stats(network_telemetry_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    return ESP_OK;
+}
+
+#endif // CONFIG_NETWORK_TELEMETRY
+
+#if CONFIG_SYSTEM_SERVICE_TRACE || CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+
+static esp_err_t collector_send(const void *data, size_t len, void *user_data)
+{
+    int sock = *(int *)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+    while (len > 0) {
+        int sent = send(sock, bytes, len, 0);
+        if (sent < 0) {
+            ESP_LOGW(TAG, "Collector send failed: errno %d", errno);
+            return ESP_FAIL;
+        }
+        bytes += sent;
+        len -= sent;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Open a TCP connection to a dump collector
+ */
+static esp_err_t collector_connect(const char *host, uint16_t port, int *out_sock)
+{
+    if (host == NULL || port == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!network_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    char port_str[6];
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    const struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0 || res == NULL) {
+        ESP_LOGW(TAG, "Can't resolve collector %s", host);
+        return ESP_FAIL;
+    }
+    
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    if (connect(sock, res->ai_addr, res->ai_addrlen) != 0) {
+        ESP_LOGW(TAG, "Can't connect to collector %s:%u: errno %d", host, port, errno);
+        close(sock);
+        ret = ESP_FAIL;
+    }
+    freeaddrinfo(res);
+    
+    *out_sock = sock;
+    return ret;
+}
+
+#endif
+
+#if CONFIG_SYSTEM_SERVICE_TRACE
+
+esp_err_t network_telemetry_upload_trace(const char *host, uint16_t port)
+{
+    int sock;
+    esp_err_t ret = collector_connect(host, port, &sock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = system_trace_dump(collector_send, &sock);
+    close(sock);
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Trace sent to %s:%u", host, port);
+    }
+    return ret;
+}
+
+#else // !CONFIG_SYSTEM_SERVICE_TRACE
+
+esp_err_t network_telemetry_upload_trace(const char *host, uint16_t port)
+{
+    (void)host;
+    (void)port;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_TRACE
+
+#if CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+
+esp_err_t network_telemetry_upload_flight(const char *host, uint16_t port, uint32_t minutes)
+{
+    int sock;
+    esp_err_t ret = collector_connect(host, port, &sock);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = flight_recorder_read(minutes, collector_send, &sock);
+    close(sock);
+    
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Flight log sent to %s:%u", host, port);
+    }
+    return ret;
+}
+
+#else // !CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+
+esp_err_t network_telemetry_upload_flight(const char *host, uint16_t port, uint32_t minutes)
+{
+    (void)host;
+    (void)port;
+    (void)minutes;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
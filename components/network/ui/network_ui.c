@@ -11,6 +11,16 @@
 
 static const char *TAG = "network_ui";
 
+// One list row per SSID, kept across updates so only changed rows are touched
+typedef struct {
+    lv_obj_t *item;                 // NULL for a free slot
+    lv_obj_t *label;
+    lv_obj_t *lock_icon;
+    char ssid[NETWORK_SSID_MAX_LEN];
+    uint8_t bars;
+    bool seen;                      // Present in the update being applied
+} network_ui_row_t;
+
 typedef struct {
     lv_obj_t *container;
     lv_obj_t *wifi_toggle;
@@ -18,6 +28,7 @@ typedef struct {
     lv_obj_t *status_label;
     bool wifi_enabled;
     char connecting_ssid[33];
+    network_ui_row_t rows[NETWORK_MAX_SCAN_RESULTS];
 } network_ui_ctx_t;
 
 static network_ui_ctx_t *s_ui_ctx = NULL;
@@ -25,9 +36,9 @@ static network_ui_ctx_t *s_ui_ctx = NULL;
 static void back_button_cb(void) {
     ESP_LOGI(TAG, "Back button clicked");
     
-    // Get event type and post event
-    system_event_type_t menu_back_event;
-    if (system_event_register_type("menu.back_clicked", &menu_back_event) == ESP_OK) {
+    // Resolved once without the bus lock; stays INVALID until someone registers it
+    system_event_type_t menu_back_event = SYSTEM_EVENT_TYPE_CACHED("menu.back_clicked");
+    if (menu_back_event != SYSTEM_EVENT_TYPE_INVALID) {
         system_event_post(0, menu_back_event, NULL, 0, SYSTEM_EVENT_PRIORITY_NORMAL);
     }
 }
@@ -38,11 +49,20 @@ static void wifi_toggle_cb(bool state) {
     ESP_LOGI(TAG, "WiFi toggled: %s", state ? "ON" : "OFF");
     
     if (state) {
-        network_scan_result_t result;
-        network_scan_wifi(&result);
-        lv_label_set_text(s_ui_ctx->status_label, "Scanning...");
+        // Show what's cached right away; results stream in through
+        // network_ui_update_wifi_list(), straight from the cache if fresh
+        network_scan_result_t cached = {0};
+        if (network_scan_get_results(&cached) == ESP_OK && cached.count > 0) {
+            network_ui_update_wifi_list(s_ui_ctx->container, &cached);
+        }
+        if (network_scan_start() != ESP_OK) {
+            lv_label_set_text(s_ui_ctx->status_label, "Scan failed");
+        } else if (cached.count == 0) {
+            lv_label_set_text(s_ui_ctx->status_label, "Scanning...");
+        }
     } else {
         lv_obj_clean(s_ui_ctx->wifi_list);
+        memset(s_ui_ctx->rows, 0, sizeof(s_ui_ctx->rows));
         lv_label_set_text(s_ui_ctx->status_label, "WiFi Off");
     }
 }
@@ -64,19 +84,66 @@ static void wifi_password_callback(const char *password, bool cancelled) {
 
 static void wifi_item_click_cb(lv_event_t *e) {
     if (!s_ui_ctx) return;
-    lv_obj_t *item = lv_event_get_target(e);
-    lv_obj_t *label = lv_obj_get_child(item, 0);
-    const char *ssid = lv_label_get_text(label);
-    
-    // Extract SSID (remove signal icon)
-    const char *ssid_start = strchr(ssid, ' ');
-    if (ssid_start) {
-        ssid_start++;
-        strncpy(s_ui_ctx->connecting_ssid, ssid_start, sizeof(s_ui_ctx->connecting_ssid) - 1);
-        ESP_LOGI(TAG, "Selected WiFi: %s", s_ui_ctx->connecting_ssid);
-        
-        ui_keyboard_show(s_ui_ctx->container, "Enter WiFi Password", "", wifi_password_callback);
+    const network_ui_row_t *row = lv_event_get_user_data(e);
+    
+    strncpy(s_ui_ctx->connecting_ssid, row->ssid, sizeof(s_ui_ctx->connecting_ssid) - 1);
+    ESP_LOGI(TAG, "Selected WiFi: %s", s_ui_ctx->connecting_ssid);
+    
+    ui_keyboard_show(s_ui_ctx->container, "Enter WiFi Password", "", wifi_password_callback);
+}
+
+static const char *signal_icon(uint8_t bars) {
+    return bars >= 3 ? LV_SYMBOL_WIFI : LV_SYMBOL_WARNING;
+}
+
+static network_ui_row_t *row_find(const char *ssid) {
+    for (int i = 0; i < NETWORK_MAX_SCAN_RESULTS; i++) {
+        network_ui_row_t *row = &s_ui_ctx->rows[i];
+        if (row->item && strncmp(row->ssid, ssid, NETWORK_SSID_MAX_LEN) == 0) {
+            return row;
+        }
+    }
+    return NULL;
+}
+
+static network_ui_row_t *row_create(const network_wifi_info_t *net) {
+    network_ui_row_t *row = NULL;
+    for (int i = 0; i < NETWORK_MAX_SCAN_RESULTS && !row; i++) {
+        if (!s_ui_ctx->rows[i].item) row = &s_ui_ctx->rows[i];
     }
+    if (!row) return NULL;
+    
+    memset(row, 0, sizeof(*row));
+    strncpy(row->ssid, net->ssid, sizeof(row->ssid) - 1);
+    row->bars = net->bars;
+    
+    lv_obj_t *item = lv_obj_create(s_ui_ctx->wifi_list);
+    lv_obj_set_size(item, LV_PCT(100), UI_LIST_ITEM_HEIGHT);
+    lv_obj_set_style_bg_color(item, UI_COLOR_BG_PRIMARY, 0);
+    lv_obj_set_style_bg_color(item, UI_COLOR_BG_SELECTED, LV_STATE_PRESSED);
+    lv_obj_set_style_border_width(item, 0, 0);
+    lv_obj_set_style_radius(item, UI_RADIUS_SMALL, 0);
+    lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+    row->item = item;
+    
+    row->label = lv_label_create(item);
+    lv_label_set_text_fmt(row->label, "%s %s", signal_icon(net->bars), net->ssid);
+    lv_obj_set_style_text_font(row->label, UI_FONT_MEDIUM, 0);
+    lv_obj_set_style_text_color(row->label, UI_COLOR_TEXT_PRIMARY, 0);
+    lv_obj_align(row->label, LV_ALIGN_LEFT_MID, UI_PADDING_MEDIUM, 0);
+    
+    // Lock icon for secured networks
+    if (net->auth_mode != NETWORK_AUTH_OPEN) {
+        row->lock_icon = lv_label_create(item);
+        lv_label_set_text(row->lock_icon, LV_SYMBOL_SETTINGS);
+        lv_obj_set_style_text_font(row->lock_icon, UI_FONT_SMALL, 0);
+        lv_obj_set_style_text_color(row->lock_icon, UI_COLOR_TEXT_SECONDARY, 0);
+        lv_obj_align(row->lock_icon, LV_ALIGN_RIGHT_MID, -UI_PADDING_MEDIUM, 0);
+    }
+    
+    lv_obj_add_event_cb(item, wifi_item_click_cb, LV_EVENT_CLICKED, row);
+    return row;
 }
 
 lv_obj_t* network_ui_create(lv_obj_t *parent) {
@@ -142,51 +209,59 @@ void network_ui_destroy(lv_obj_t *ui) {
     ESP_LOGI(TAG, "Network UI destroyed");
 }
 
-void network_ui_update_wifi_list(lv_obj_t *ui) {
-    if (!s_ui_ctx || !s_ui_ctx->wifi_enabled) return;
+void network_ui_update_wifi_list(lv_obj_t *ui, const network_scan_result_t *result) {
+    if (!s_ui_ctx || !s_ui_ctx->wifi_enabled || !result) return;
     
-    lv_obj_clean(s_ui_ctx->wifi_list);
+    if (result->complete) {
+        lv_label_set_text_fmt(s_ui_ctx->status_label, "Found %d networks", result->count);
+    } else {
+        lv_label_set_text_fmt(s_ui_ctx->status_label, "Scanning... %d found", result->count);
+    }
     
-    network_scan_result_t scan_result;
-    if (network_scan_wifi(&scan_result) != ESP_OK) {
-        lv_label_set_text(s_ui_ctx->status_label, "Scan failed");
-        return;
+    // Diff against the rows on screen: add, update and move only what changed
+    int added = 0, changed = 0, removed = 0;
+    for (int i = 0; i < NETWORK_MAX_SCAN_RESULTS; i++) {
+        s_ui_ctx->rows[i].seen = false;
     }
     
-    lv_label_set_text_fmt(s_ui_ctx->status_label, "Found %d networks", scan_result.count);
-    
-    for (int i = 0; i < scan_result.count && i < 20; i++) {
-        lv_obj_t *item = lv_obj_create(s_ui_ctx->wifi_list);
-        lv_obj_set_size(item, LV_PCT(100), UI_LIST_ITEM_HEIGHT);
-        lv_obj_set_style_bg_color(item, UI_COLOR_BG_PRIMARY, 0);
-        lv_obj_set_style_bg_color(item, UI_COLOR_BG_SELECTED, LV_STATE_PRESSED);
-        lv_obj_set_style_border_width(item, 0, 0);
-        lv_obj_set_style_radius(item, UI_RADIUS_SMALL, 0);
-        lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
-        lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
-        
-        // Signal strength icon
-        const char *signal_icon = scan_result.networks[i].rssi > -50 ? LV_SYMBOL_WIFI : 
-                                  scan_result.networks[i].rssi > -70 ? LV_SYMBOL_WARNING : 
-                                  LV_SYMBOL_WARNING;
+    for (int i = 0; i < result->count && i < NETWORK_MAX_SCAN_RESULTS; i++) {
+        const network_wifi_info_t *net = &result->networks[i];
+        network_ui_row_t *row = row_find(net->ssid);
         
-        lv_obj_t *label = lv_label_create(item);
-        lv_label_set_text_fmt(label, "%s %s", signal_icon, scan_result.networks[i].ssid);
-        lv_obj_set_style_text_font(label, UI_FONT_MEDIUM, 0);
-        lv_obj_set_style_text_color(label, UI_COLOR_TEXT_PRIMARY, 0);
-        lv_obj_align(label, LV_ALIGN_LEFT_MID, UI_PADDING_MEDIUM, 0);
-        
-        // Lock icon for secured networks
-        if (scan_result.networks[i].auth_mode != NETWORK_AUTH_OPEN) {
-            lv_obj_t *lock_icon = lv_label_create(item);
-            lv_label_set_text(lock_icon, LV_SYMBOL_SETTINGS);
-            lv_obj_set_style_text_font(lock_icon, UI_FONT_SMALL, 0);
-            lv_obj_set_style_text_color(lock_icon, UI_COLOR_TEXT_SECONDARY, 0);
-            lv_obj_align(lock_icon, LV_ALIGN_RIGHT_MID, -UI_PADDING_MEDIUM, 0);
+        if (!row) {
+            row = row_create(net);
+            if (!row) continue;
+            added++;
+        } else if (row->bars != net->bars || (row->lock_icon != NULL) != (net->auth_mode != NETWORK_AUTH_OPEN)) {
+            if ((row->lock_icon != NULL) != (net->auth_mode != NETWORK_AUTH_OPEN)) {
+                // Security changed under the same SSID: rebuild the row in place
+                lv_obj_del(row->item);
+                row->item = NULL;
+                row = row_create(net);
+                if (!row) continue;
+            } else {
+                row->bars = net->bars;
+                lv_label_set_text_fmt(row->label, "%s %s", signal_icon(net->bars), net->ssid);
+            }
+            changed++;
         }
+        row->seen = true;
         
-        lv_obj_add_event_cb(item, wifi_item_click_cb, LV_EVENT_CLICKED, NULL);
+        // Rows stay in RSSI order
+        if (lv_obj_get_index(row->item) != i) {
+            lv_obj_move_to_index(row->item, i);
+        }
+    }
+    
+    for (int i = 0; i < NETWORK_MAX_SCAN_RESULTS; i++) {
+        network_ui_row_t *row = &s_ui_ctx->rows[i];
+        if (row->item && !row->seen) {
+            lv_obj_del(row->item);
+            memset(row, 0, sizeof(*row));
+            removed++;
+        }
     }
     
-    ESP_LOGI(TAG, "WiFi list updated with %d networks", scan_result.count);
+    ESP_LOGD(TAG, "WiFi list updated: %d networks, +%d ~%d -%d",
+             result->count, added, changed, removed);
 }
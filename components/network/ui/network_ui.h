@@ -7,6 +7,7 @@
 #define NETWORK_UI_H
 
 #include "lvgl.h"
+#include "network_service.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,8 +29,9 @@ void network_ui_destroy(lv_obj_t *ui);
 /**
  * @brief Update WiFi list with scan results
  * @param ui UI object
+ * @param result Partial or final scan results
  */
-void network_ui_update_wifi_list(lv_obj_t *ui);
+void network_ui_update_wifi_list(lv_obj_t *ui, const network_scan_result_t *result);
 
 #ifdef __cplusplus
 }
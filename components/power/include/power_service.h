@@ -14,11 +14,16 @@ typedef enum {
     POWER_EVENT_ERROR,
     POWER_EVENT_BATTERY_LEVEL,
     POWER_EVENT_BATTERY_STATUS,
+    POWER_EVENT_BATTERY_LOW,
 } power_event_id_t;
 
+// Posted on power.battery_level whenever level or charging changes, and at
+// CRITICAL priority on power.battery_low when the battery drops to the power
+// save level while discharging
 typedef struct {
     uint8_t level;
     bool is_charging;
+    uint16_t voltage_mv;        // Filtered battery voltage
 } power_battery_event_t;
 
 esp_err_t power_service_init(void);
@@ -1,14 +1,22 @@
 #include "esp_log.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_attr.h"
+#include "esp_adc/adc_continuous.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #include "power_service.h"
+#include "display_backlight.h"
+#include "network_service.h"
 #include "system_service/system_service.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "system_service/power_lock.h"
+#include <stdlib.h>
 
 static const char *TAG = "power_service";
 
@@ -31,54 +39,121 @@ static const char *TAG = "power_service";
 
 // Monitoring configuration
 #define BATTERY_CHECK_INTERVAL_MS   5000  // Check every 5 seconds
-#define ADC_SAMPLE_COUNT            10    // Average 10 samples for accuracy
 #define CHARGING_THRESHOLD_MV       50    // Voltage increase threshold for charging detection
+#define POWER_SAVE_LEVEL            20    // Shorter backlight timeouts and max modem sleep at or below this level
 
 // Service state
 static system_service_id_t power_service_id = 0;
-static system_event_type_t power_events[6];
+static system_event_type_t power_events[7];
 static bool initialized = false;
 static bool running = false;
 
+// One DMA frame per reading: 256 conversions in 12.8 ms, averaged
+#define ADC_BURST_SAMPLES       256
+#define ADC_BURST_FREQ_HZ       20000
+#define ADC_BURST_BYTES         (ADC_BURST_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+#define ADC_BURST_TIMEOUT_MS    100
+
+// Battery filter: scalar Kalman on the voltage, EMA on its trend
+#define FILTER_PROCESS_VAR      4.0f   // mV^2 of real change per reading
+#define FILTER_MEASURE_VAR      64.0f  // mV^2 of noise left after averaging a burst
+#define FILTER_TREND_ALPHA      0.25f
+#define LEVEL_HYSTERESIS        2      // Percent
+
 // ADC handles
-static adc_oneshot_unit_handle_t adc_handle = NULL;
+static adc_continuous_handle_t adc_handle = NULL;
 static adc_cali_handle_t adc_cali_handle = NULL;
+static uint8_t adc_burst[ADC_BURST_BYTES];
 
 // Battery monitoring task
 static TaskHandle_t battery_monitor_task_handle = NULL;
+SYSTEM_TASK_DEFINE(s_battery_monitor_task, 4096);
 
 // Battery state
-static uint8_t last_battery_level = 0;
+typedef struct {
+    bool primed;                // First reading seen
+    float voltage_mv;           // Filtered estimate
+    float variance;             // Of the estimate, mV^2
+    float trend_mv;             // Smoothed change per reading
+    uint8_t level;              // Reported percentage, with hysteresis
+    bool charging;
+} battery_filter_t;
+
+static battery_filter_t battery = {0};
+static power_battery_event_t last_battery_event = {0};
+static bool battery_event_sent = false;
 static bool last_charging_state = false;
-static int last_voltage_mv = 0;
+
+// Radio power policy inputs
+static bool screen_off = false;
+static bool battery_low = false;
+static system_event_type_t screen_on_event = SYSTEM_EVENT_TYPE_INVALID;
+static system_event_type_t screen_off_event = SYSTEM_EVENT_TYPE_INVALID;
+static network_power_profile_t wifi_profile = NETWORK_POWER_PROFILE_COUNT;  // None requested yet
+
+// Power management
+#define RESIDENCY_LOG_INTERVAL_US   ((int64_t)CONFIG_POWER_RESIDENCY_LOG_INTERVAL_S * 1000000)
+static int64_t last_residency_log_us = 0;
+
+/* Wake the monitor task when a burst has landed; ISR context */
+static bool IRAM_ATTR adc_conv_done_cb(adc_continuous_handle_t handle,
+                                       const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    if (battery_monitor_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(battery_monitor_task_handle, &woken);
+    }
+    return woken == pdTRUE;
+}
 
 /* Initialize ADC for battery monitoring */
 static esp_err_t init_battery_adc(void)
 {
     esp_err_t ret;
     
-    // Configure ADC oneshot mode
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = BATTERY_ADC_UNIT,
-        .ulp_mode = ADC_ULP_MODE_DISABLE,
+    // Continuous mode: the DMA fills a whole burst with no CPU involvement
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_BURST_BYTES * 2,
+        .conv_frame_size = ADC_BURST_BYTES,
     };
     
-    ret = adc_oneshot_new_unit(&init_config, &adc_handle);
+    ret = adc_continuous_new_handle(&handle_config, &adc_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize ADC unit: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Configure ADC channel
-    adc_oneshot_chan_cfg_t config = {
-        .bitwidth = BATTERY_ADC_WIDTH,
+    adc_digi_pattern_config_t pattern = {
         .atten = BATTERY_ADC_ATTEN,
+        .channel = BATTERY_ADC_CHANNEL,
+        .unit = BATTERY_ADC_UNIT,
+        .bit_width = BATTERY_ADC_WIDTH,
+    };
+    
+    adc_continuous_config_t config = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = ADC_BURST_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
     };
     
-    ret = adc_oneshot_config_channel(adc_handle, BATTERY_ADC_CHANNEL, &config);
+    ret = adc_continuous_config(adc_handle, &config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to config ADC channel: %s", esp_err_to_name(ret));
-        adc_oneshot_del_unit(adc_handle);
+        adc_continuous_deinit(adc_handle);
+        adc_handle = NULL;
+        return ret;
+    }
+    
+    adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = adc_conv_done_cb,
+    };
+    ret = adc_continuous_register_event_callbacks(adc_handle, &callbacks, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register ADC callbacks: %s", esp_err_to_name(ret));
+        adc_continuous_deinit(adc_handle);
+        adc_handle = NULL;
         return ret;
     }
     
@@ -96,56 +171,67 @@ static esp_err_t init_battery_adc(void)
         adc_cali_handle = NULL;
     }
     
-    ESP_LOGI(TAG, "✓ Battery ADC initialized (GPIO 9, Channel 8)");
+    ESP_LOGI(TAG, "✓ Battery ADC initialized (GPIO 9, Channel 8, %d-sample DMA bursts)",
+             ADC_BURST_SAMPLES);
     return ESP_OK;
 }
 
-/* Read battery voltage in millivolts */
+/*
+ * Read battery voltage in millivolts from one DMA burst. The converter
+ * runs only for the burst, so it holds no clock lock in between, and the
+ * task sleeps until the burst is complete.
+ */
 static int read_battery_voltage_mv(void)
 {
     if (!adc_handle) {
         return 0;
     }
     
-    int total_voltage = 0;
-    int valid_samples = 0;
+    adc_continuous_flush_pool(adc_handle);
+    ulTaskNotifyTake(pdTRUE, 0);
+    if (adc_continuous_start(adc_handle) != ESP_OK) {
+        return 0;
+    }
     
-    // Take multiple samples and average
-    for (int i = 0; i < ADC_SAMPLE_COUNT; i++) {
-        int adc_raw = 0;
-        esp_err_t ret = adc_oneshot_read(adc_handle, BATTERY_ADC_CHANNEL, &adc_raw);
-        
-        if (ret == ESP_OK) {
-            int voltage_mv = 0;
-            
-            if (adc_cali_handle) {
-                // Use calibrated value
-                adc_cali_raw_to_voltage(adc_cali_handle, adc_raw, &voltage_mv);
-            } else {
-                // Estimate voltage from raw value (12-bit ADC, 3.3V reference)
-                voltage_mv = (adc_raw * 3300) / 4095;
-            }
-            
-            total_voltage += voltage_mv;
+    uint32_t length = 0;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ADC_BURST_TIMEOUT_MS)) > 0) {
+        adc_continuous_read(adc_handle, adc_burst, sizeof(adc_burst), &length, 0);
+    }
+    adc_continuous_stop(adc_handle);
+    
+    // Oversample: the mean of the burst, kept to 1/16 LSB
+    uint32_t total_raw = 0;
+    uint32_t valid_samples = 0;
+    
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        const adc_digi_output_data_t *result = (const adc_digi_output_data_t *)&adc_burst[i];
+        if (result->type2.unit == BATTERY_ADC_UNIT && result->type2.channel == BATTERY_ADC_CHANNEL) {
+            total_raw += result->type2.data;
             valid_samples++;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(10));  // Small delay between samples
     }
     
     if (valid_samples == 0) {
         return 0;
     }
     
-    // Average voltage
-    int avg_voltage_mv = total_voltage / valid_samples;
+    uint32_t mean_raw_x16 = (total_raw * 16 + valid_samples / 2) / valid_samples;
+    int voltage_mv = 0;
+    
+    if (adc_cali_handle) {
+        // Calibrate the rounded mean; the curve is smooth at this scale
+        adc_cali_raw_to_voltage(adc_cali_handle, (int)((mean_raw_x16 + 8) / 16), &voltage_mv);
+    } else {
+        // Estimate voltage from raw value (12-bit ADC, 3.3V reference)
+        voltage_mv = (int)((mean_raw_x16 * 3300) / (4095 * 16));
+    }
     
     // Floating GPIO detection disabled - causing false positives
     // The voltage readings around 2.0V are actually valid battery voltages
     // (battery voltage after ADC attenuation, not floating GPIO)
     
     // Apply voltage divider ratio to get actual battery voltage
-    int battery_voltage_mv = (int)(avg_voltage_mv * VOLTAGE_DIVIDER_RATIO);
+    int battery_voltage_mv = (int)(voltage_mv * VOLTAGE_DIVIDER_RATIO);
     
     return battery_voltage_mv;
 }
@@ -163,109 +249,168 @@ static uint8_t voltage_to_percentage(int voltage_mv)
     // Linear interpolation between min and max
     int range = BATTERY_VOLTAGE_MAX - BATTERY_VOLTAGE_MIN;
     int value = voltage_mv - BATTERY_VOLTAGE_MIN;
-    uint8_t raw_percentage = (value * 100) / range;
+    return (uint8_t)((value * 100) / range);
+}
+
+/* Decide charging from the filtered voltage and its trend */
+static bool detect_charging(const battery_filter_t *filter)
+{
+    int voltage_mv = (int)filter->voltage_mv;
+    float trend_mv = filter->trend_mv;
     
-    // Apply hysteresis to reduce fluctuations
-    // Only update if percentage changes by more than 2%
-    static uint8_t last_reported_percentage = 0;
-    static bool first_reading = true;
+    // If voltage is very low (<2.5V = 1.25V at ADC), battery is likely disconnected
+    if (voltage_mv < 2500) {
+        return false;
+    }
     
-    if (first_reading) {
-        last_reported_percentage = raw_percentage;
-        first_reading = false;
-        return raw_percentage;
+    // Adaptive threshold based on battery level
+    // At high battery levels (>80%), charging is slower, so use lower threshold
+    float threshold_mv;
+    if (voltage_mv >= 4000) {  // >95% battery
+        threshold_mv = 2.0f;   // Very sensitive for trickle charge
+    } else if (voltage_mv >= 3900) {  // >80% battery
+        threshold_mv = 5.0f;   // Moderately sensitive
+    } else {
+        threshold_mv = 10.0f;  // Normal threshold for fast charging
     }
     
-    // Only update if change is significant (>2%)
-    if (abs(raw_percentage - last_reported_percentage) >= 2) {
-        last_reported_percentage = raw_percentage;
+    // Charging if the smoothed voltage is rising above threshold
+    bool is_charging = (trend_mv > threshold_mv);
+    
+    // A battery does not hold above 4.0V on its own: stable or rising there
+    // means a charger is connected, including when maintaining full charge
+    if (voltage_mv >= 4000 && trend_mv >= -2.0f) {
+        is_charging = true;
+    }
+    if (voltage_mv >= 4150 && trend_mv >= -5.0f && trend_mv <= 5.0f) {
+        is_charging = true;
     }
     
-    return last_reported_percentage;
+    ESP_LOGD(TAG, "Charging detection: voltage=%dmV, trend=%.1fmV, threshold=%.0fmV, charging=%d",
+             voltage_mv, trend_mv, threshold_mv, is_charging);
+    return is_charging;
 }
 
-/* Detect if battery is charging based on voltage trend */
-static bool detect_charging(int current_voltage_mv)
+/* Fold one burst reading into the filter and update level and charging */
+static void battery_filter_update(battery_filter_t *filter, int measured_mv)
 {
-    static int voltage_history[5] = {0};  // Increased to 5 samples for better trend
-    static int history_index = 0;
-    static int sample_count = 0;
-    
-    // Store voltage in history
-    voltage_history[history_index] = current_voltage_mv;
-    history_index = (history_index + 1) % 5;
-    sample_count++;
-    
-    // Need at least 4 samples to detect trend reliably
-    if (sample_count < 4) {
-        return false;
+    if (!filter->primed) {
+        filter->primed = true;
+        filter->voltage_mv = (float)measured_mv;
+        filter->variance = FILTER_MEASURE_VAR;
+        filter->trend_mv = 0.0f;
+        filter->level = voltage_to_percentage(measured_mv);
+        filter->charging = detect_charging(filter);
+        return;
     }
     
-    // Calculate average voltage change over last 4 samples
-    int total_change = 0;
-    int valid_changes = 0;
+    // Predict: the voltage drifts by an unknown amount per reading
+    float prior_var = filter->variance + FILTER_PROCESS_VAR;
     
-    for (int i = 0; i < 4; i++) {
-        int curr_idx = (history_index + i) % 5;
-        int next_idx = (history_index + i + 1) % 5;
-        
-        if (voltage_history[curr_idx] > 0 && voltage_history[next_idx] > 0) {
-            int change = voltage_history[next_idx] - voltage_history[curr_idx];
-            total_change += change;
-            valid_changes++;
-        }
-    }
-    
-    if (valid_changes == 0) {
-        return false;
-    }
+    // Correct with the new reading
+    float gain = prior_var / (prior_var + FILTER_MEASURE_VAR);
+    float previous_mv = filter->voltage_mv;
+    filter->voltage_mv += gain * ((float)measured_mv - filter->voltage_mv);
+    filter->variance = (1.0f - gain) * prior_var;
     
-    // Average voltage change per sample
-    int avg_change_mv = total_change / valid_changes;
+    filter->trend_mv += FILTER_TREND_ALPHA * ((filter->voltage_mv - previous_mv) - filter->trend_mv);
     
-    // Adaptive threshold based on battery level
-    // At high battery levels (>80%), charging is slower, so use lower threshold
-    int threshold_mv;
-    if (current_voltage_mv >= 4000) {  // >95% battery
-        threshold_mv = 2;   // Very sensitive for trickle charge (lowered from 5)
-    } else if (current_voltage_mv >= 3900) {  // >80% battery  
-        threshold_mv = 5;   // Moderately sensitive (lowered from 10)
+    // Only move the reported level on a significant change
+    uint8_t level = voltage_to_percentage((int)filter->voltage_mv);
+    if (abs((int)level - (int)filter->level) >= LEVEL_HYSTERESIS) {
+        filter->level = level;
+    }
+    filter->charging = detect_charging(filter);
+}
+
+/* Pick the WiFi power profile for the current battery and screen state and
+ * ask the network service for it when that changes */
+static void update_wifi_profile(void)
+{
+    network_power_profile_t profile;
+    if (last_charging_state && !screen_off) {
+        profile = NETWORK_POWER_PERFORMANCE;
+    } else if (screen_off || battery_low) {
+        profile = NETWORK_POWER_MAX_MODEM;
     } else {
-        threshold_mv = 10;  // Normal threshold for fast charging (lowered from 20)
+        profile = NETWORK_POWER_BALANCED;
     }
     
-    // Charging if average voltage is increasing above threshold
-    bool is_charging = (avg_change_mv > threshold_mv);
+    if (profile == wifi_profile) {
+        return;
+    }
     
-    // Debug logging
-    ESP_LOGI(TAG, "Charging detection: voltage=%dmV, avg_change=%dmV, threshold=%dmV, charging=%d",
-             current_voltage_mv, avg_change_mv, threshold_mv, is_charging);
+    if (SYSTEM_EVENT_POST_TYPED(power_service_id, NETWORK_EVENT_SET_POWER_PROFILE,
+                                &profile, SYSTEM_EVENT_PRIORITY_NORMAL) == ESP_OK) {
+        wifi_profile = profile;
+    }
+}
+
+#if CONFIG_PM_ENABLE
+/* Scale between the default and minimum frequency as power locks come and go */
+static esp_err_t configure_pm(void)
+{
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_POWER_PM_MIN_FREQ_MHZ,
+#if CONFIG_POWER_PM_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#endif
+    };
     
-    // Check if battery is actually connected
-    // If voltage is very low (<2.5V = 1.25V at ADC), battery is likely disconnected
-    if (current_voltage_mv < 2500) {
-        // No battery or battery critically low - not charging
-        ESP_LOGI(TAG, "Battery voltage too low - assuming disconnected");
-        return false;
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        return ret;
     }
     
-    // Special case: If voltage is stable at high level (>4.0V) and not decreasing,
-    // assume charging since battery shouldn't be stable at high voltage on battery power alone
-    if (current_voltage_mv >= 4000 && avg_change_mv >= -2) {
-        // Voltage stable or slightly increasing at high level - likely charging/maintaining
-        ESP_LOGI(TAG, "Battery at high voltage and stable - assuming charging");
-        is_charging = true;
+    ESP_LOGI(TAG, "✓ Power management: %d-%d MHz, light sleep %s",
+             pm_config.min_freq_mhz, pm_config.max_freq_mhz,
+             pm_config.light_sleep_enable ? "on" : "off");
+    return ESP_OK;
+}
+#endif
+
+/* Time in each power mode since boot, and the locks that were held */
+static void log_residency(void)
+{
+    system_power_residency_t residency;
+    if (system_power_get_residency(&residency) != ESP_OK) {
+        return;
     }
     
-    // Also check if voltage is stable at very high level (>4.15V), 
-    // likely at full charge and maintaining
-    if (current_voltage_mv >= 4150 && avg_change_mv >= -5 && avg_change_mv <= 5) {
-        // Voltage stable at very high level - likely on charger maintaining full charge
-        ESP_LOGI(TAG, "Battery at full charge - assuming charging/maintaining");
-        is_charging = true;
+    uint64_t total_us = 0;
+    for (int i = 0; i < SYSTEM_POWER_MODE_COUNT; i++) {
+        total_us += residency.time_us[i];
+    }
+    if (total_us == 0) {
+        return;
     }
     
-    return is_charging;
+    ESP_LOGI(TAG, "Residency: cpu_max %.1f%%, apb_max %.1f%%, awake %.1f%%, sleep %.1f%% "
+             "(%lu transitions, now %s)",
+             residency.time_us[SYSTEM_POWER_MODE_CPU_MAX] * 100.0f / total_us,
+             residency.time_us[SYSTEM_POWER_MODE_APB_MAX] * 100.0f / total_us,
+             residency.time_us[SYSTEM_POWER_MODE_AWAKE] * 100.0f / total_us,
+             residency.time_us[SYSTEM_POWER_MODE_SLEEP] * 100.0f / total_us,
+             (unsigned long)residency.transitions, system_power_mode_name(residency.mode));
+    
+    system_power_lock_info_t locks[CONFIG_SYSTEM_SERVICE_MAX_POWER_LOCKS];
+    size_t count = 0;
+    system_power_get_locks(locks, CONFIG_SYSTEM_SERVICE_MAX_POWER_LOCKS, &count);
+    for (size_t i = 0; i < count; i++) {
+        if (locks[i].acquisitions == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-16s %5.1f%% held, %lu acquisitions%s", locks[i].name,
+                 locks[i].held_us * 100.0f / total_us, (unsigned long)locks[i].acquisitions,
+                 locks[i].holders > 0 ? ", held now" : "");
+    }
+}
+
+static void screen_event_handler(const system_event_t *event, void *user_data)
+{
+    screen_off = (event->event_type == screen_off_event);
+    update_wifi_profile();
 }
 
 /* Battery monitoring task */
@@ -278,49 +423,54 @@ static void battery_monitor_task(void *arg)
         int voltage_mv = read_battery_voltage_mv();
         
         if (voltage_mv > 0) {
-            // Calculate battery percentage
-            uint8_t battery_level = voltage_to_percentage(voltage_mv);
+            battery_filter_update(&battery, voltage_mv);
             
-            // Detect charging status
-            bool is_charging = detect_charging(voltage_mv);
+            ESP_LOGD(TAG, "Battery: %d%% (%dmV, filtered %.0fmV) %s",
+                     battery.level, voltage_mv, battery.voltage_mv,
+                     battery.charging ? "[CHARGING]" : "[NOT CHARGING]");
             
-            // Log battery status
-            ESP_LOGI(TAG, "Battery: %d%% (%.2fV) %s", 
-                     battery_level, 
-                     voltage_mv / 1000.0f,
-                     is_charging ? "[CHARGING]" : "[NOT CHARGING]");
+            power_battery_event_t event_data = {
+                .level = battery.level,
+                .is_charging = battery.charging,
+                .voltage_mv = (uint16_t)battery.voltage_mv,
+            };
             
-            // Post battery level event if changed
-            if (battery_level != last_battery_level) {
-                power_battery_event_t event_data = {
-                    .level = battery_level,
-                    .is_charging = is_charging
-                };
-                
-                system_event_post(power_service_id, power_events[4], 
-                                &event_data, sizeof(event_data), 
-                                SYSTEM_EVENT_PRIORITY_NORMAL);
-                
-                last_battery_level = battery_level;
+            // One event carries the whole state, posted only when it changes
+            if (!battery_event_sent || event_data.level != last_battery_event.level ||
+                event_data.is_charging != last_battery_event.is_charging) {
+                system_event_post(power_service_id, power_events[POWER_EVENT_BATTERY_LEVEL],
+                                  &event_data, sizeof(event_data),
+                                  SYSTEM_EVENT_PRIORITY_NORMAL);
+                last_battery_event = event_data;
+                battery_event_sent = true;
+                ESP_LOGI(TAG, "Battery: %d%% (%.2fV) %s", battery.level, battery.voltage_mv / 1000.0f,
+                         battery.charging ? "[CHARGING]" : "[NOT CHARGING]");
             }
             
-            // Post charging status event if changed
-            if (is_charging != last_charging_state) {
-                power_battery_event_t event_data = {
-                    .level = battery_level,
-                    .is_charging = is_charging
-                };
+            // Charger plug and unplug keep their own edge event
+            if (battery.charging != last_charging_state) {
+                system_event_post(power_service_id, power_events[POWER_EVENT_BATTERY_STATUS],
+                                  &event_data, sizeof(event_data),
+                                  SYSTEM_EVENT_PRIORITY_NORMAL);
                 
-                system_event_post(power_service_id, power_events[5], 
-                                &event_data, sizeof(event_data), 
-                                SYSTEM_EVENT_PRIORITY_NORMAL);
-                
-                last_charging_state = is_charging;
-                ESP_LOGI(TAG, "Charging status changed: %s", 
-                         is_charging ? "CHARGING" : "NOT CHARGING");
+                last_charging_state = battery.charging;
+                ESP_LOGI(TAG, "Charging status changed: %s",
+                         battery.charging ? "CHARGING" : "NOT CHARGING");
             }
             
-            last_voltage_mv = voltage_mv;
+            // Backlight is the largest load: time it out sooner on a low battery
+            bool was_low = battery_low;
+            battery_low = !battery.charging && battery.level <= POWER_SAVE_LEVEL;
+            display_backlight_set_power_save(battery_low);
+            
+            // Goes ahead of any backlog, apps get to save state in time
+            if (battery_low && !was_low) {
+                system_event_post(power_service_id, power_events[POWER_EVENT_BATTERY_LOW],
+                                  &event_data, sizeof(event_data),
+                                  SYSTEM_EVENT_PRIORITY_CRITICAL);
+                ESP_LOGW(TAG, "Battery low: %d%%", battery.level);
+            }
+            update_wifi_profile();
             
             // Send heartbeat
             system_service_heartbeat(power_service_id);
@@ -328,6 +478,12 @@ static void battery_monitor_task(void *arg)
             ESP_LOGW(TAG, "Failed to read battery voltage");
         }
         
+        int64_t now_us = esp_timer_get_time();
+        if (RESIDENCY_LOG_INTERVAL_US > 0 && now_us - last_residency_log_us >= RESIDENCY_LOG_INTERVAL_US) {
+            last_residency_log_us = now_us;
+            log_residency();
+        }
+        
         // Wait for next check interval
         vTaskDelay(pdMS_TO_TICKS(BATTERY_CHECK_INTERVAL_MS));
     }
@@ -360,11 +516,23 @@ esp_err_t power_service_init(void)
         "power.stopped",
         "power.error",
         "power.battery_level",
-        "power.battery_status"
+        "power.battery_status",
+        "power.battery_low"
+    };
+    
+    // Battery readings are state: subscribers only need the newest one
+    const system_event_topic_mode_t event_modes[] = {
+        SYSTEM_EVENT_TOPIC_QUEUED,
+        SYSTEM_EVENT_TOPIC_QUEUED,
+        SYSTEM_EVENT_TOPIC_QUEUED,
+        SYSTEM_EVENT_TOPIC_QUEUED,
+        SYSTEM_EVENT_TOPIC_LATEST,
+        SYSTEM_EVENT_TOPIC_LATEST,
+        SYSTEM_EVENT_TOPIC_QUEUED
     };
     
-    for (int i = 0; i < 6; i++) {
-        ret = system_event_register_type(event_names[i], &power_events[i]);
+    for (int i = 0; i < 7; i++) {
+        ret = system_event_register_topic(event_names[i], event_modes[i], &power_events[i]);
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Failed to register event type '%s' - continuing anyway", event_names[i]);
             // Continue anyway - events are nice to have but not critical for battery monitoring
@@ -372,6 +540,22 @@ esp_err_t power_service_init(void)
     }
     ESP_LOGI(TAG, "✓ Event registration complete");
     
+    // Screen state drives the WiFi power profile (types owned by the display service)
+    system_event_register_type("display.screen_on", &screen_on_event);
+    system_event_register_type("display.screen_off", &screen_off_event);
+    if (system_event_subscribe(power_service_id, screen_on_event, screen_event_handler, NULL) != ESP_OK ||
+        system_event_subscribe(power_service_id, screen_off_event, screen_event_handler, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to subscribe to screen events");
+    }
+    
+#if CONFIG_PM_ENABLE
+    // Without it the CPU just stays at the default frequency
+    ret = configure_pm();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to configure power management: %s", esp_err_to_name(ret));
+    }
+#endif
+    
     // Initialize battery ADC
     ret = init_battery_adc();
     if (ret != ESP_OK) {
@@ -410,7 +594,8 @@ esp_err_t power_service_start(void)
     running = true;
     
     // Create battery monitoring task
-    BaseType_t task_created = xTaskCreate(
+    BaseType_t task_created = SYSTEM_TASK_CREATE(
+        s_battery_monitor_task,
         battery_monitor_task,
         "battery_monitor",
         4096,
@@ -483,7 +668,7 @@ esp_err_t power_service_deinit(void)
     }
     
     if (adc_handle) {
-        adc_oneshot_del_unit(adc_handle);
+        adc_continuous_deinit(adc_handle);
         adc_handle = NULL;
     }
     
@@ -0,0 +1,249 @@
+/**
+ * @file esp_timer_host.c
+ * @brief Host shim of esp_timer for the linux target
+ *
+ * Armed timers sit in one list under a mutex. The "esp_timer" task sleeps
+ * on its notification until the nearest deadline, and start/stop wake it
+ * to re-plan. A periodic timer that fell behind skips the missed periods
+ * instead of firing back to back, as skip_unhandled_events does on the
+ * device.
+ */
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TIMER_TASK_STACK_SIZE   4096
+#define TIMER_TASK_PRIORITY     (configMAX_PRIORITIES - 3)
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t deadline_us;            // 0 while not armed
+    uint64_t period_us;             // 0 for one-shot
+    struct esp_timer *next;
+};
+
+static struct esp_timer *s_timers = NULL;
+static struct esp_timer *volatile s_running = NULL;
+static SemaphoreHandle_t s_lock = NULL;
+static TaskHandle_t s_task = NULL;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+static int64_t s_epoch_us = 0;
+
+static int64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+__attribute__((constructor))
+static void timer_epoch_init(void)
+{
+    s_epoch_us = monotonic_us();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return monotonic_us() - s_epoch_us;
+}
+
+static void timer_task(void *arg)
+{
+    (void)arg;
+    
+    for (;;) {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+    
+        int64_t now = esp_timer_get_time();
+        int64_t nearest = INT64_MAX;
+        struct esp_timer *due = NULL;
+    
+        for (struct esp_timer *t = s_timers; t != NULL; t = t->next) {
+            if (t->deadline_us == 0) {
+                continue;
+            }
+            if (due == NULL && t->deadline_us <= now) {
+                due = t;
+            } else if (t->deadline_us < nearest) {
+                nearest = t->deadline_us;
+            }
+        }
+    
+        if (due != NULL) {
+            esp_timer_cb_t callback = due->callback;
+            void *cb_arg = due->arg;
+    
+            if (due->period_us > 0) {
+                due->deadline_us += (int64_t)due->period_us;
+                if (due->deadline_us <= now) {
+                    due->deadline_us = now + (int64_t)due->period_us;
+                }
+            } else {
+                due->deadline_us = 0;
+            }
+    
+            s_running = due;
+            xSemaphoreGive(s_lock);
+            callback(cb_arg);
+            s_running = NULL;
+            continue;
+        }
+    
+        xSemaphoreGive(s_lock);
+    
+        TickType_t wait = portMAX_DELAY;
+        if (nearest != INT64_MAX) {
+            int64_t wait_ms = (nearest - now + 999) / 1000;
+            wait = pdMS_TO_TICKS(wait_ms);
+            if (wait == 0) {
+                wait = 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+static void timer_service_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock != NULL) {
+        xTaskCreate(timer_task, "esp_timer", TIMER_TASK_STACK_SIZE, NULL,
+                    TIMER_TASK_PRIORITY, &s_task);
+    }
+}
+
+static void timer_wake(void)
+{
+    if (s_task != NULL && xTaskGetCurrentTaskHandle() != s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
+                           esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    pthread_once(&s_once, timer_service_init);
+    if (s_lock == NULL || s_task == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    struct esp_timer *timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    timer->next = s_timers;
+    s_timers = timer;
+    xSemaphoreGive(s_lock);
+    
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (timer->deadline_us != 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period_us = period_us;
+    timer->deadline_us = esp_timer_get_time() + (int64_t)timeout_us;
+    if (timer->deadline_us == 0) {
+        timer->deadline_us = 1;
+    }
+    xSemaphoreGive(s_lock);
+    
+    timer_wake();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    if (period_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return timer_arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool armed = timer->deadline_us != 0;
+    timer->deadline_us = 0;
+    xSemaphoreGive(s_lock);
+    
+    if (!armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer_wake();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (timer->deadline_us != 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct esp_timer **link = &s_timers; *link != NULL; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    xSemaphoreGive(s_lock);
+    
+    // Its callback may still be running on the timer task
+    while (s_running == timer && xTaskGetCurrentTaskHandle() != s_task) {
+        vTaskDelay(1);
+    }
+    
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    if (timer == NULL || s_lock == NULL) {
+        return false;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool active = timer->deadline_us != 0;
+    xSemaphoreGive(s_lock);
+    return active;
+}
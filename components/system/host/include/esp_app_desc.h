@@ -0,0 +1,55 @@
+/**
+ * @file esp_app_desc.h
+ * @brief Host shim of the application description
+ * 
+ * There is no image header on the host; the description carries the
+ * project version the build passes in, or "host".
+ */
+
+#ifndef HOST_ESP_APP_DESC_H
+#define HOST_ESP_APP_DESC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t magic_word;
+    uint32_t secure_version;
+    uint32_t reserv1[2];
+    char version[32];
+    char project_name[32];
+    char time[16];
+    char date[16];
+    char idf_ver[32];
+    uint8_t app_elf_sha256[32];
+    uint32_t reserv2[20];
+} esp_app_desc_t;
+
+static inline const esp_app_desc_t *esp_app_get_description(void)
+{
+    static const esp_app_desc_t desc = {
+#ifdef PROJECT_VER
+        .version = PROJECT_VER,
+#else
+        .version = "host",
+#endif
+#ifdef PROJECT_NAME
+        .project_name = PROJECT_NAME,
+#endif
+#ifdef IDF_VER
+        .idf_ver = IDF_VER,
+#endif
+        .time = __TIME__,
+        .date = __DATE__,
+    };
+    return &desc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_APP_DESC_H
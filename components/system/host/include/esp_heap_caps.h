@@ -0,0 +1,119 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host shim of the heap_caps API for the linux target
+ * 
+ * Every capability maps to the process heap. Free and total sizes are
+ * fixed nominal values, an S3 with 8 MB PSRAM, so code that picks PSRAM
+ * or sizes itself off free memory takes its on-device path. Nothing here
+ * is a real measurement; use the host's own tools for that.
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MALLOC_CAP_EXEC             (1 << 0)
+#define MALLOC_CAP_32BIT            (1 << 1)
+#define MALLOC_CAP_8BIT             (1 << 2)
+#define MALLOC_CAP_DMA              (1 << 3)
+#define MALLOC_CAP_SPIRAM           (1 << 10)
+#define MALLOC_CAP_INTERNAL         (1 << 11)
+#define MALLOC_CAP_DEFAULT          (1 << 12)
+
+#define HOST_HEAP_INTERNAL_BYTES    (320 * 1024)
+#define HOST_HEAP_SPIRAM_BYTES      (8 * 1024 * 1024)
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return realloc(ptr, size);
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *ptr = NULL;
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+static inline size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? HOST_HEAP_SPIRAM_BYTES : HOST_HEAP_INTERNAL_BYTES;
+}
+
+static inline size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return heap_caps_get_total_size(caps);
+}
+
+static inline size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return heap_caps_get_total_size(caps);
+}
+
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_total_size(caps);
+}
+
+static inline void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    size_t total = heap_caps_get_total_size(caps);
+    *info = (multi_heap_info_t){
+        .total_free_bytes = total,
+        .largest_free_block = total,
+        .minimum_free_bytes = total,
+        .free_blocks = 1,
+        .total_blocks = 1,
+    };
+}
+
+static inline bool heap_caps_check_integrity_all(bool print_errors)
+{
+    (void)print_errors;
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,37 @@
+/**
+ * @file esp_memory_utils.h
+ * @brief Host shim of the address classification helpers
+ * 
+ * The host has one flat heap, all of it reported as internal RAM.
+ */
+
+#ifndef HOST_ESP_MEMORY_UTILS_H
+#define HOST_ESP_MEMORY_UTILS_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline bool esp_ptr_external_ram(const void *p)
+{
+    (void)p;
+    return false;
+}
+
+static inline bool esp_ptr_internal(const void *p)
+{
+    return p != NULL;
+}
+
+static inline bool esp_ptr_byte_accessible(const void *p)
+{
+    return p != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_MEMORY_UTILS_H
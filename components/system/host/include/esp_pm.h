@@ -0,0 +1,28 @@
+/**
+ * @file esp_pm.h
+ * @brief Host shim of the esp_pm types
+ * 
+ * The host has no power management: CONFIG_PM_ENABLE is never set, so
+ * only the types are needed.
+ */
+
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock *esp_pm_lock_handle_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_PM_H
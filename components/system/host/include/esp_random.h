@@ -0,0 +1,37 @@
+/**
+ * @file esp_random.h
+ * @brief Host shim of the hardware RNG
+ * 
+ * Backed by random(), seeded by the C library. Good enough for IDs and
+ * jitter in host runs, not for anything that has to be secret.
+ */
+
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint32_t esp_random(void)
+{
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+static inline void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *out = (uint8_t *)buf;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)random();
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_RANDOM_H
@@ -0,0 +1,59 @@
+/**
+ * @file esp_timer.h
+ * @brief Host shim of the esp_timer API for the linux target
+ * 
+ * Time is CLOCK_MONOTONIC since the first call. Callbacks run on one
+ * FreeRTOS task, "esp_timer", as with ESP_TIMER_TASK dispatch on the
+ * device, so they may use any FreeRTOS API. Deadlines are rounded up to
+ * the FreeRTOS tick, which is coarser than the device's.
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+    ESP_TIMER_MAX,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
+                           esp_timer_handle_t *out_handle);
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+
+bool esp_timer_is_active(esp_timer_handle_t timer);
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_TIMER_H
@@ -20,12 +20,14 @@ typedef enum {
     APP_STATE_RUNNING,
     APP_STATE_PAUSED,
     APP_STATE_ERROR,
+    APP_STATE_HIBERNATED,       // Paused with its state saved and its memory freed
 } app_state_t;
 
 typedef enum {
     APP_SOURCE_INTERNAL = 0,    // Built-in / compiled in
     APP_SOURCE_STORAGE,         // Loaded from storage (SPIFFS/FAT)
     APP_SOURCE_REMOTE,          // Downloaded from URL
+    APP_SOURCE_FLASH,           // Executed in place from a flash partition
 } app_source_t;
 
 typedef struct {
@@ -33,16 +35,85 @@ typedef struct {
     char name[APP_MAX_NAME_LEN];
     char version[APP_MAX_VERSION_LEN];
     char author[APP_MAX_AUTHOR_LEN];
-    uint32_t size;
+    uint32_t size;              // Image bytes after this header
     uint32_t entry_point;       // Offset to entry function
-    uint32_t crc32;
+    uint32_t crc32;             // CRC-32 (LE) of the size bytes after this header
 } app_header_t;
 
+/*
+ * Flash app image, as flash_app_load() expects it:
+ *
+ *   app_header_t | app_image_layout_t | .text | .rodata | .data | relocations
+ *
+ * Offsets are from the start of the image (the header). .text is mapped
+ * into the instruction cache and .rodata into the data cache, both in
+ * place; only .data is copied, with .bss after it, into one PSRAM block
+ * that the app reaches as ctx->app_info->app_data. Neither mapped section
+ * is patched, so the code must be position independent: absolute
+ * addresses live in .data, and every such word is listed in the
+ * relocation table, which adds the load address of its target section.
+ */
+#define APP_IMAGE_NO_EXIT           0xFFFFFFFF
+
+// Relocation entry: target section in the top 4 bits, word offset into .data below
+#define APP_RELOC_TARGET_SHIFT      28
+#define APP_RELOC_OFFSET_MASK       0x0FFFFFFF
+#define APP_RELOC(target, offset)   (((uint32_t)(target) << APP_RELOC_TARGET_SHIFT) | \
+                                     ((uint32_t)(offset) & APP_RELOC_OFFSET_MASK))
+
+typedef enum {
+    APP_RELOC_TEXT = 0,
+    APP_RELOC_RODATA,
+    APP_RELOC_DATA,             // .data and .bss, one block
+} app_reloc_target_t;
+
+typedef struct {
+    uint32_t text_offset;       // 4-byte aligned
+    uint32_t text_size;
+    uint32_t rodata_offset;     // 4-byte aligned
+    uint32_t rodata_size;
+    uint32_t data_offset;       // Initial contents of .data
+    uint32_t data_size;
+    uint32_t bss_size;
+    uint32_t reloc_offset;      // reloc_count uint32_t entries
+    uint32_t reloc_count;
+    uint32_t exit_point;        // Offset to exit function in .text, APP_IMAGE_NO_EXIT if none
+} app_image_layout_t;
+
 typedef struct app_context app_context_t;
 
+/*
+ * Stack an app's entry runs on. Apps run on pre-created workers, one pool
+ * per class, sized by CONFIG_SYSTEM_SERVICE_APP_*_STACK; an app whose
+ * class is busy borrows a worker of a larger class.
+ */
+typedef enum {
+    APP_STACK_MEDIUM = 0,       // Default
+    APP_STACK_SMALL,
+    APP_STACK_LARGE,            // In PSRAM with CONFIG_SYSTEM_SERVICE_APP_LARGE_STACK_PSRAM
+    APP_STACK_CLASS_COUNT,
+} app_stack_class_t;
+
 typedef esp_err_t (*app_entry_fn_t)(app_context_t *ctx);
 typedef esp_err_t (*app_exit_fn_t)(app_context_t *ctx);
 
+/*
+ * Hibernation. An app with a hibernate callback is hibernated instead of
+ * just suspended when it is paused:
+ *   - its events are parked; latest-value topics keep the newest event
+ *   - hibernate writes what the app needs to come back, at most max bytes,
+ *     to state and sets *out_len; it deletes the LVGL objects it made
+ *   - the framework frees the app's arena, and app.hibernated makes the
+ *     display delete the screens loaded under the app's name ("name", or
+ *     keys starting with "name/")
+ * On resume, restore gets the state back, rebuilds its screens and arena
+ * data, and the parked events are delivered before any new one. Arena
+ * pointers do not survive hibernation. A failing hibernate leaves the app
+ * running.
+ */
+typedef esp_err_t (*app_hibernate_fn_t)(app_context_t *ctx, void *state, size_t max, size_t *out_len);
+typedef esp_err_t (*app_restore_fn_t)(app_context_t *ctx, const void *state, size_t len);
+
 typedef struct {
     char name[APP_MAX_NAME_LEN];
     char version[APP_MAX_VERSION_LEN];
@@ -52,6 +123,15 @@ typedef struct {
     app_exit_fn_t exit;
     
     void *user_data;
+    app_stack_class_t stack_class;
+    
+    app_hibernate_fn_t hibernate;   // Optional, see above
+    app_restore_fn_t restore;       // Required with hibernate
+    
+    // Share of one core the app may use, task and handlers together; 0 takes
+    // CONFIG_SYSTEM_SERVICE_APP_CPU_BUDGET_PERCENT. Over budget, the app runs
+    // at CONFIG_SYSTEM_SERVICE_APP_CPU_THROTTLE_PRIORITY with its event rate cut.
+    uint8_t cpu_budget_percent;
 } app_manifest_t;
 
 typedef struct {
@@ -59,8 +139,21 @@ typedef struct {
     app_state_t state;
     app_source_t source;
     
-    void *app_data;
+    void *app_data;             // .data and .bss of a flash app
     size_t app_size;
+    void *image;                // Loader state of a flash app, NULL otherwise
+    
+    // Flash apps: loads and restarts that reused a cached relocated .data
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t load_time_us;      // Of the last load or restart
+    
+    // CPU in the last accounting period, with CONFIG_SYSTEM_SERVICE_APP_CPU_ACCOUNTING
+    uint32_t cpu_task_us;       // Entry task
+    uint32_t cpu_handler_us;    // Event handlers, on the dispatch workers
+    uint8_t cpu_percent;        // Both, of one core
+    bool cpu_throttled;         // Over budget and throttled
+    uint32_t cpu_throttle_count;    // Times it went over budget
     
     system_service_id_t service_id;
     uint32_t load_time;
@@ -68,6 +161,18 @@ typedef struct {
     bool is_dynamic;            // true if loaded from storage/remote
 } app_info_t;
 
+/*
+ * Audio playback for apps, installed by the audio service with
+ * app_manager_set_audio_ops(). Codecs are audio_codec_t values. The stream
+ * belongs to the app and is closed when the app stops.
+ */
+typedef struct {
+    esp_err_t (*open)(app_context_t *ctx, uint32_t sample_rate, uint8_t channels, uint8_t codec);
+    esp_err_t (*write)(app_context_t *ctx, const void *data, size_t len,
+                       size_t *written, uint32_t timeout_ms);
+    esp_err_t (*close)(app_context_t *ctx, bool drain);
+} app_audio_ops_t;
+
 struct app_context {
     app_info_t *app_info;
     system_service_id_t service_id;
@@ -86,11 +191,23 @@ struct app_context {
                                 system_event_handler_t handler, void *user_data);
     esp_err_t (*unsubscribe_event)(system_service_id_t id, system_event_type_t type);
     esp_err_t (*register_event_type)(const char *name, system_event_type_t *out_type);
+    
+    // Arena memory (PSRAM), charged to the app's memory quota and released
+    // all at once by app_manager_stop_app()
+    void* (*arena_alloc)(app_context_t *ctx, size_t size);
+    void* (*arena_calloc)(app_context_t *ctx, size_t count, size_t size);
+    size_t (*arena_used)(app_context_t *ctx);
+    
+    // Audio streaming, NULL when no audio service is installed
+    const app_audio_ops_t *audio;
 };
 
 // App manager initialization
 esp_err_t app_manager_init(void);
 
+// Install the audio API handed to apps from their next start on
+void app_manager_set_audio_ops(const app_audio_ops_t *ops);
+
 // Register a statically-linked app
 esp_err_t app_manager_register_app(const app_manifest_t *manifest, app_info_t **out_info);
 
@@ -106,13 +223,14 @@ esp_err_t app_manager_list_apps(app_info_t *apps, size_t max_count, size_t *out_
 esp_err_t app_manager_get_running_apps(app_info_t *apps, size_t max_count, size_t *out_count);
 
 /**
- * @brief Load and register a dynamic app from flash partition using ELF loader
+ * @brief Load a flash app and register it with the app manager
  * 
- * This function loads a Position-Independent Code (PIC) app from a flash partition,
- * parses the ELF binary, applies relocations, and registers it with the app manager.
+ * Loads the image with flash_app_load() and registers its manifest. The
+ * app stays mapped for the life of the system; start and stop it like a
+ * built-in app.
  * 
  * @param partition_label Flash partition label (e.g., "app_store")
- * @param offset Offset within partition where app ELF binary starts
+ * @param offset Offset within partition where the app image starts
  * @param out_info Output pointer to app info (optional, can be NULL)
  * @return ESP_OK on success, error code otherwise
  */
@@ -121,16 +239,31 @@ esp_err_t app_manager_load_dynamic_from_partition(const char *partition_label, s
 /**
  * @brief Load app from flash partition using memory mapping
  * 
- * This function loads an app directly from flash and maps the code section
- * into instruction cache for execution. This avoids PSRAM execution limitations.
+ * Maps .text into the instruction cache and .rodata into the data cache
+ * straight from the partition, so starting an app costs a few MMU page
+ * table entries, not a copy, whatever the size of its code. Only .data
+ * and .bss take PSRAM. See app_image_layout_t for the image format.
  * 
  * @param partition_label Flash partition label (e.g., "app_store")
- * @param offset Offset within partition where app binary starts
- * @param info Output app info structure
- * @return ESP_OK on success, error code otherwise
+ * @param offset Offset within partition where the app image starts
+ * @param info Output app info structure; manifest, app_data and image are filled in
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND without the partition,
+ *         ESP_ERR_INVALID_VERSION on a bad magic, ESP_ERR_INVALID_SIZE or
+ *         ESP_ERR_INVALID_CRC on a damaged image, ESP_ERR_NO_MEM when out
+ *         of PSRAM, MMU pages or loader slots
  */
 esp_err_t flash_app_load(const char *partition_label, size_t offset, app_info_t *info);
 
+/**
+ * @brief Unmap an app loaded with flash_app_load() and free its data
+ * 
+ * Only for apps that were never registered; registered ones stay loaded.
+ * 
+ * @param info App info filled in by flash_app_load()
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if info holds no flash image
+ */
+esp_err_t flash_app_unload(app_info_t *info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,6 +45,10 @@ extern "C" {
     ptr; \
 })
 
+// Arena allocation - no free, everything goes when the app stops
+#define APP_ARENA_ALLOC(ctx, size) ((ctx)->arena_alloc((ctx), (size)))
+#define APP_ARENA_CALLOC(ctx, n, size) ((ctx)->arena_calloc((ctx), (n), (size)))
+
 // Get app info
 #define APP_NAME(ctx) ((ctx)->app_info->manifest.name)
 #define APP_VERSION(ctx) ((ctx)->app_info->manifest.version)
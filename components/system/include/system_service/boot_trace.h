@@ -0,0 +1,78 @@
+#ifndef SYSTEM_SERVICE_BOOT_TRACE_H
+#define SYSTEM_SERVICE_BOOT_TRACE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Boot phase tracer
+ * 
+ * Records µs timestamps of named boot phases from app_main on, across the
+ * system component and the services. boot_trace_finish() prints a
+ * waterfall and keeps the last CONFIG_SYSTEM_SERVICE_BOOT_TRACE_HISTORY
+ * profiles in NVS so regressions between firmware builds show up.
+ * 
+ * Usable before system_service_init() and from any task. Compiles to
+ * no-ops without CONFIG_SYSTEM_SERVICE_BOOT_TRACE.
+ */
+
+#define BOOT_TRACE_NAME_LEN         20
+#define BOOT_TRACE_ID_INVALID       0xFF
+
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+#define BOOT_TRACE_MAX_PHASES       CONFIG_SYSTEM_SERVICE_BOOT_TRACE_MAX_PHASES
+#else
+#define BOOT_TRACE_MAX_PHASES       1
+#endif
+
+typedef uint8_t boot_trace_id_t;
+
+typedef struct {
+    char name[BOOT_TRACE_NAME_LEN]; // Phase name (truncated)
+    uint32_t start_us;              // Since boot (esp_timer clock)
+    uint32_t duration_us;           // 0 for milestones and unfinished phases
+    uint8_t core;                   // Core the phase began on
+    bool milestone;                 // Recorded with boot_trace_mark()
+} boot_trace_phase_t;
+
+typedef struct {
+    uint32_t boot_count;            // Increments with every stored profile
+    char app_version[32];           // esp_app_desc_t version of the build
+    uint8_t elf_sha256[8];          // Leading bytes of the build's ELF hash
+    uint32_t total_us;              // Boot start until boot_trace_finish()
+    uint8_t phase_count;
+    boot_trace_phase_t phases[BOOT_TRACE_MAX_PHASES];
+} boot_profile_t;
+
+// Open a phase; returns BOOT_TRACE_ID_INVALID once the table is full or
+// after boot_trace_finish(). Passing that to boot_trace_end() is harmless.
+boot_trace_id_t boot_trace_begin(const char *phase);
+
+void boot_trace_end(boot_trace_id_t id);
+
+// Instant milestone, e.g. the first frame on screen
+void boot_trace_mark(const char *phase);
+
+/*
+ * End the boot profile: further phases are ignored, the waterfall is
+ * logged and the profile is stored in NVS (which must be initialized).
+ */
+esp_err_t boot_trace_finish(void);
+
+// age 0 is the most recent stored profile. ESP_ERR_NOT_FOUND if none.
+esp_err_t boot_trace_get_profile(uint32_t age, boot_profile_t *out_profile);
+
+// Log one line per stored profile, newest first, with its change in total
+// boot time against the previous boot
+void boot_trace_print_history(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_BOOT_TRACE_H
@@ -2,43 +2,144 @@
 #define COMMON_EVENTS_H
 
 #include "system_service/system_types.h"
+#include "system_service/event_schema.h"
+#include "system_service/system_settings.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * @brief Common pre-registered event types
+ * @brief Heap fragmentation warning
  * 
- * These events are registered at system startup and available by ID.
- * Flash apps can use these without needing to register them (which requires strings).
+ * Posted by the heap sampler when the largest free internal block is below
+ * CONFIG_SYSTEM_SERVICE_HEAP_MIN_INTERNAL_BLOCK or trending to reach it
+ * within the configured horizon. Payload is common_heap_warning_t.
  */
+#define COMMON_EVENT_NAME_HEAP_WARNING  "system.heap_warning"
 
-// System events (0-99)
-#define COMMON_EVENT_SYSTEM_STARTUP     0
-#define COMMON_EVENT_SYSTEM_SHUTDOWN    1
-#define COMMON_EVENT_SYSTEM_ERROR       2
+typedef struct {
+    uint32_t largest_free_block;    /**< Largest free internal block now */
+    uint32_t free_bytes;            /**< Free internal bytes now */
+    uint32_t threshold;             /**< Configured minimum largest block */
+    int32_t largest_block_slope;    /**< Trend in bytes per minute */
+    uint32_t seconds_to_threshold;  /**< Projected time left, 0 if crossed */
+} common_heap_warning_t;
 
-// Network events (100-199)
-#define COMMON_EVENT_NETWORK_CONNECTED      100
-#define COMMON_EVENT_NETWORK_DISCONNECTED   101
-#define COMMON_EVENT_NETWORK_GOT_IP         102
-#define COMMON_EVENT_NETWORK_LOST_IP        103
+/**
+ * @brief Slow handler quarantine
+ * 
+ * Posted by the dispatcher when a subscription is moved to the deferred
+ * worker for repeatedly running over CONFIG_SYSTEM_SERVICE_HANDLER_WARN_THRESHOLD_MS,
+ * and when it is moved back. Payload is common_handler_quarantine_t.
+ */
+#define COMMON_EVENT_NAME_HANDLER_DEMOTED   "system.handler_demoted"
+#define COMMON_EVENT_NAME_HANDLER_PROMOTED  "system.handler_promoted"
+
+typedef struct {
+    system_service_id_t service_id;     /**< Subscriber */
+    system_event_type_t event_type;     /**< Subscribed event type */
+    uint32_t last_run_us;               /**< Run that triggered the move */
+    uint32_t budget_us;                 /**< Per-run budget */
+} common_handler_quarantine_t;
+
+/**
+ * @brief App hibernation
+ * 
+ * Posted by the app manager, as the app, when a paused app has been
+ * hibernated and when it has been resumed. Services holding objects for
+ * the app free them on app.hibernated; the display service deletes the
+ * screens loaded under the app's name. Payload is common_app_hibernate_t.
+ */
+#define COMMON_EVENT_NAME_APP_HIBERNATED    "app.hibernated"
+#define COMMON_EVENT_NAME_APP_RESUMED       "app.resumed"
+
+typedef struct {
+    char name[SYSTEM_SERVICE_MAX_NAME_LEN]; /**< App (and service) name */
+    system_service_id_t service_id;         /**< App service */
+    uint32_t state_bytes;                   /**< Size of the saved state blob */
+    uint32_t arena_bytes;                   /**< Arena freed on hibernation */
+    uint32_t events_replayed;               /**< Parked events delivered on resume */
+    uint32_t events_dropped;                /**< Missed events coalesced or dropped */
+} common_app_hibernate_t;
+
+/**
+ * @brief Setting changed
+ * 
+ * Posted by the settings store, as the setting's owner, at most once per
+ * setting every SYSTEM_SETTINGS_COALESCE_MS with the latest value. The
+ * change is in the RAM cache already, not necessarily in flash. Payload
+ * is common_setting_changed_t.
+ */
+#define COMMON_EVENT_NAME_SETTING_CHANGED   "system.setting_changed"
+
+typedef struct {
+    system_setting_id_t id;
+    uint8_t type;                           /**< system_setting_type_t */
+    system_service_id_t owner;
+    uint32_t value;                         /**< Scalars: the value; else its length */
+    char key[SYSTEM_SETTING_KEY_LEN];
+} common_setting_changed_t;
 
-// App events (200-299)
-#define COMMON_EVENT_APP_STARTED        200
-#define COMMON_EVENT_APP_STOPPED        201
-#define COMMON_EVENT_APP_ERROR          202
+/**
+ * @brief Safe mode entered
+ * 
+ * Posted at CRITICAL priority by the watchdog when a critical service
+ * times out, before its recovery runs. Payload is common_safe_mode_t.
+ */
+#define COMMON_EVENT_NAME_SAFE_MODE         "system.safe_mode"
+
+typedef struct {
+    char reason[48];
+} common_safe_mode_t;
+
+/**
+ * @brief Service missed its watchdog heartbeat
+ * 
+ * Posted at CRITICAL priority by the watchdog once per timeout, when it
+ * first notices it. Payload is common_watchdog_timeout_t.
+ */
+#define COMMON_EVENT_NAME_WATCHDOG_TIMEOUT  "system.watchdog_timeout"
+
+typedef struct {
+    system_service_id_t service_id;
+    uint32_t elapsed_ms;                    /**< Since the last heartbeat */
+    uint32_t timeout_ms;
+    bool critical;                          /**< Service was registered as critical */
+} common_watchdog_timeout_t;
+
+/**
+ * @brief Common event types, at static IDs
+ * 
+ * Registered by system_service_init(), so every service and flash app can
+ * use the IDs directly without registering (which requires strings).
+ * Network state events belong to network_service.h's schema.
+ */
+#define COMMON_EVENT_SCHEMA(X) \
+    X(COMMON_EVENT_SYSTEM_STARTUP,      "system.startup",           system_event_no_payload_t,   1, QUEUED) \
+    X(COMMON_EVENT_SYSTEM_SHUTDOWN,     "system.shutdown",          system_event_no_payload_t,   1, QUEUED) \
+    X(COMMON_EVENT_SYSTEM_ERROR,        "system.error",             system_event_bytes_t,        1, QUEUED) \
+    X(COMMON_EVENT_APP_STARTED,         "app.started",              system_event_no_payload_t,   1, QUEUED) \
+    X(COMMON_EVENT_APP_STOPPED,         "app.stopped",              system_event_no_payload_t,   1, QUEUED) \
+    X(COMMON_EVENT_APP_ERROR,           "app.error",                system_event_bytes_t,        1, QUEUED) \
+    X(COMMON_EVENT_USER_INPUT,          "user.input",               system_event_bytes_t,        1, QUEUED) \
+    X(COMMON_EVENT_USER_BUTTON,         "user.button",              system_event_bytes_t,        1, QUEUED) \
+    X(COMMON_EVENT_HEAP_WARNING,        COMMON_EVENT_NAME_HEAP_WARNING,     common_heap_warning_t,       1, QUEUED) \
+    X(COMMON_EVENT_HANDLER_DEMOTED,     COMMON_EVENT_NAME_HANDLER_DEMOTED,  common_handler_quarantine_t, 1, QUEUED) \
+    X(COMMON_EVENT_HANDLER_PROMOTED,    COMMON_EVENT_NAME_HANDLER_PROMOTED, common_handler_quarantine_t, 1, QUEUED) \
+    X(COMMON_EVENT_APP_HIBERNATED,      COMMON_EVENT_NAME_APP_HIBERNATED,   common_app_hibernate_t,      1, QUEUED) \
+    X(COMMON_EVENT_APP_RESUMED,         COMMON_EVENT_NAME_APP_RESUMED,      common_app_hibernate_t,      1, QUEUED) \
+    X(COMMON_EVENT_SETTING_CHANGED,     COMMON_EVENT_NAME_SETTING_CHANGED,  common_setting_changed_t,    1, QUEUED) \
+    X(COMMON_EVENT_SAFE_MODE,           COMMON_EVENT_NAME_SAFE_MODE,        common_safe_mode_t,          1, QUEUED) \
+    X(COMMON_EVENT_WATCHDOG_TIMEOUT,    COMMON_EVENT_NAME_WATCHDOG_TIMEOUT, common_watchdog_timeout_t,   1, QUEUED)
 
-// User events (300+)
-#define COMMON_EVENT_USER_INPUT         300
-#define COMMON_EVENT_USER_BUTTON        301
+SYSTEM_EVENT_SCHEMA_DECLARE(COMMON_EVENT_SCHEMA, COMMON_EVENT, SYSTEM_EVENT_RANGE_COMMON);
 
 /**
  * @brief Initialize common event types
  * 
- * Registers all common events at system startup.
- * Must be called during system initialization.
+ * Registers COMMON_EVENT_SCHEMA. system_service_init() already does;
+ * calling it again is a no-op.
  */
 esp_err_t common_events_init(void);
 
@@ -46,7 +147,7 @@ esp_err_t common_events_init(void);
  * @brief Get event type name
  * 
  * @param event_id Common event ID
- * @return Event name string, or NULL if unknown
+ * @return Event name string, or NULL if not a common event
  */
 const char* common_event_get_name(system_event_type_t event_id);
 
@@ -2,34 +2,293 @@
 #define EVENT_BUS_H
 
 #include "system_types.h"
+#include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Event name hashing (FNV-1a over the name zero-padded to
+ * SYSTEM_SERVICE_MAX_NAME_LEN bytes). SYSTEM_EVENT_NAME_HASH() only takes
+ * string literals and folds to a constant at compile time.
+ */
+#define SYSTEM_EVENT_HASH_BYTE_(s, i) \
+    ((uint32_t)((i) < sizeof(s) - 1 ? (uint8_t)(s)[(i) < sizeof(s) - 1 ? (i) : 0] : 0))
+
+#define SYSTEM_EVENT_HASH_STEP_(h, s, i) \
+    (((h) ^ SYSTEM_EVENT_HASH_BYTE_(s, i)) * 16777619u)
+
+#define SYSTEM_EVENT_HASH_8_(h, s, i) \
+    SYSTEM_EVENT_HASH_STEP_(SYSTEM_EVENT_HASH_STEP_(SYSTEM_EVENT_HASH_STEP_( \
+    SYSTEM_EVENT_HASH_STEP_(SYSTEM_EVENT_HASH_STEP_(SYSTEM_EVENT_HASH_STEP_( \
+    SYSTEM_EVENT_HASH_STEP_(SYSTEM_EVENT_HASH_STEP_(h, s, (i) + 0), s, (i) + 1), \
+    s, (i) + 2), s, (i) + 3), s, (i) + 4), s, (i) + 5), s, (i) + 6), s, (i) + 7)
+
+#define SYSTEM_EVENT_NAME_HASH(s) \
+    SYSTEM_EVENT_HASH_8_(SYSTEM_EVENT_HASH_8_(SYSTEM_EVENT_HASH_8_( \
+    SYSTEM_EVENT_HASH_8_(2166136261u, s, 0), s, 8), s, 16), s, 24)
+
+_Static_assert(SYSTEM_SERVICE_MAX_NAME_LEN == 32,
+               "SYSTEM_EVENT_NAME_HASH() unrolls over 32 bytes");
+
+/*
+ * Resolve an event type ID once per call site and cache it. Lock-free on
+ * every call; until the type is registered it yields
+ * SYSTEM_EVENT_TYPE_INVALID and retries next time.
+ */
+#define SYSTEM_EVENT_TYPE_CACHED(name) __extension__ ({                         \
+    static system_event_type_t s_cached_type_ = SYSTEM_EVENT_TYPE_INVALID;     \
+    if (s_cached_type_ == SYSTEM_EVENT_TYPE_INVALID) {                         \
+        system_event_lookup_hashed(SYSTEM_EVENT_NAME_HASH(name), (name),       \
+                                   &s_cached_type_);                           \
+    }                                                                          \
+    s_cached_type_;                                                            \
+})
+
 esp_err_t system_event_register_type(const char *event_name,
                                       system_event_type_t *out_event_type);
 
+/*
+ * Register an event type with an explicit topic mode. With
+ * SYSTEM_EVENT_TOPIC_LATEST a post replaces the still-pending one from the
+ * same sender instead of queueing behind it. system_event_register_type()
+ * registers a QUEUED topic and never downgrades an existing LATEST one.
+ */
+esp_err_t system_event_register_topic(const char *event_name,
+                                       system_event_topic_mode_t mode,
+                                       system_event_type_t *out_event_type);
+
+/*
+ * Look up an already registered type without taking the system lock.
+ * Returns ESP_ERR_EVENT_TYPE_NOT_FOUND if the name is not registered.
+ */
+esp_err_t system_event_lookup(const char *event_name,
+                              system_event_type_t *out_event_type);
+
+esp_err_t system_event_lookup_hashed(uint32_t name_hash,
+                                     const char *event_name,
+                                     system_event_type_t *out_event_type);
+
+uint32_t system_event_name_hash(const char *event_name);
+
 esp_err_t system_event_subscribe(system_service_id_t service_id,
                                   system_event_type_t event_type,
                                   system_event_handler_t handler,
                                   void *user_data);
 
+/*
+ * Subscribe with a filter that the event task checks before it hands the
+ * event to a worker: a rejected event costs no worker hop, no payload
+ * reference and no handler monitoring. The filter is copied. A payload
+ * shorter than match_offset + match_size does not match. As with
+ * system_event_subscribe(), subscribing again to the same type is a
+ * no-op; unsubscribe first to change the filter.
+ */
+esp_err_t system_event_subscribe_filtered(system_service_id_t service_id,
+                                          system_event_type_t event_type,
+                                          system_event_handler_t handler,
+                                          void *user_data,
+                                          const system_event_filter_t *filter);
+
 esp_err_t system_event_unsubscribe(system_service_id_t service_id,
                                     system_event_type_t event_type);
 
+/*
+ * Subscribe to every type whose name matches a pattern with one '*',
+ * which stands for any run of characters: "network.*", "menu.*_clicked".
+ * Types registered later are matched as they come. The pattern takes one
+ * of CONFIG_SYSTEM_SERVICE_MAX_WILDCARDS slots rather than a subscription
+ * per type, and is expanded into the types when subscribing and
+ * registering, so dispatch costs the same as for a plain subscription.
+ * A type the service also subscribed to directly reaches both handlers.
+ */
+esp_err_t system_event_subscribe_pattern(system_service_id_t service_id,
+                                         const char *pattern,
+                                         system_event_handler_t handler,
+                                         void *user_data);
+
+esp_err_t system_event_unsubscribe_pattern(system_service_id_t service_id,
+                                           const char *pattern);
+
+/**
+ * @brief Drop every subscription of a service
+ * 
+ * One pass under the system lock over the service's own subscriptions,
+ * however many it holds.
+ * 
+ * @param service_id Subscribing service
+ * @param out_count Subscriptions dropped, may be NULL
+ * @return ESP_OK on success, even with nothing to drop
+ */
+esp_err_t system_event_unsubscribe_all(system_service_id_t service_id, uint32_t *out_count);
+
 esp_err_t system_event_post(system_service_id_t sender_id,
                             system_event_type_t event_type,
                             const void *data,
                             size_t data_size,
                             system_event_priority_t priority);
 
+/*
+ * Like system_event_post() but never waits: if the sender is out of
+ * credits or the target queue is full it returns ESP_ERR_EVENT_QUEUE_FULL
+ * straight away, and the sender's drain callback (if any) fires once its
+ * backlog has gone down.
+ */
+esp_err_t system_event_try_post(system_service_id_t sender_id,
+                                system_event_type_t event_type,
+                                const void *data,
+                                size_t data_size,
+                                system_event_priority_t priority);
+
+/*
+ * Backpressure. Each queued event holds one of the sender's
+ * CONFIG_SYSTEM_SERVICE_PRODUCER_CREDITS credits until it is dispatched;
+ * posts past that fail with ESP_ERR_EVENT_QUEUE_FULL. After a refused
+ * post the drain callback runs once the sender's backlog is at or below
+ * low_watermark, normally on the event task. Keep it short; it may post.
+ */
+typedef void (*system_event_drain_cb_t)(system_service_id_t sender_id,
+                                        uint32_t remaining_credits,
+                                        void *user_data);
+
+esp_err_t system_event_get_credits(system_service_id_t sender_id,
+                                   uint32_t *out_remaining);
+
+esp_err_t system_event_set_drain_callback(system_service_id_t sender_id,
+                                          uint32_t low_watermark,
+                                          system_event_drain_cb_t callback,
+                                          void *user_data);
+
 esp_err_t system_event_post_async(system_service_id_t sender_id,
                                    system_event_type_t event_type,
                                    const void *data,
                                    size_t data_size,
                                    system_event_priority_t priority);
 
+/*
+ * Post several events from one sender. Quota, locking and queue
+ * bookkeeping are paid once per batch. Entries are validated up front and
+ * queued in order; *out_posted (optional) reports how many made it if the
+ * queues fill up part way.
+ */
+esp_err_t system_event_post_batch(system_service_id_t sender_id,
+                                  const system_event_batch_entry_t *entries,
+                                  size_t count,
+                                  size_t *out_posted);
+
+/*
+ * Post from interrupt context. The payload (at most
+ * CONFIG_SYSTEM_SERVICE_ISR_MAX_DATA_SIZE bytes) is copied into a block
+ * reserved up front, so no mutex or heap allocation happens in the ISR.
+ * Quotas are not applied. Call portYIELD_FROM_ISR() if
+ * higher_priority_task_woken is set.
+ */
+esp_err_t system_event_post_from_isr(system_service_id_t sender_id,
+                                     system_event_type_t event_type,
+                                     const void *data,
+                                     size_t data_size,
+                                     system_event_priority_t priority,
+                                     BaseType_t *higher_priority_task_woken);
+
+/*
+ * Zero-copy posting: borrow a payload buffer from the event pools, fill it
+ * in place and hand it to system_event_post_loaned(). The bus owns the
+ * buffer from then on, even when posting fails.
+ */
+esp_err_t system_event_loan(size_t size, void **out_buffer);
+
+esp_err_t system_event_post_loaned(system_service_id_t sender_id,
+                                   system_event_type_t event_type,
+                                   void *buffer,
+                                   size_t data_size,
+                                   system_event_priority_t priority);
+
+/* Return a loaned buffer that will not be posted */
+void system_event_loan_cancel(void *buffer);
+
+/*
+ * Keep an event payload alive past the handler. Every successful retain
+ * must be balanced by system_event_data_release(event->data).
+ */
+esp_err_t system_event_data_retain(const system_event_t *event);
+
+void system_event_data_release(const void *data);
+
+/*
+ * Latency histograms (CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING).
+ * Pass SYSTEM_EVENT_TYPE_INVALID to read the aggregate over all types.
+ * Return ESP_ERR_NOT_SUPPORTED when tracking is compiled out.
+ */
+esp_err_t system_event_get_latency(system_event_type_t event_type,
+                                   system_event_latency_stage_t stage,
+                                   system_event_latency_t *out_latency);
+
+esp_err_t system_event_reset_latency(void);
+
+/*
+ * Delivery deadlines. Every handler of an event type with a deadline is
+ * expected back within deadline_us of the post; later returns count as
+ * misses in system_event_get_deadline_stats() and the deadline_misses
+ * metric. CRITICAL posts of a type without its own deadline get
+ * CONFIG_SYSTEM_SERVICE_CRITICAL_DEADLINE_MS. 0 removes the deadline.
+ * 
+ * With CONFIG_SYSTEM_SERVICE_CRITICAL_LANE, CRITICAL events have their
+ * own queue and a dispatcher above every worker that runs their handlers
+ * itself, so they never wait behind a running NORMAL or LOW handler. Such
+ * a handler may run while the same subscriber is in another handler on
+ * its worker, and must be safe for that.
+ */
+esp_err_t system_event_set_deadline(system_event_type_t event_type, uint32_t deadline_us);
+
+esp_err_t system_event_get_deadline_stats(system_event_deadline_stats_t *out_stats);
+
+/*
+ * Handler placement. A subscription runs on its subscriber's worker, on
+ * whichever core that is pinned to, unless it is given an affinity: a
+ * CORE affinity picks one of the workers of that core, UI queues the
+ * handler for the attached UI task. Ordering is kept per subscriber and
+ * affinity, not between a subscriber's subscriptions of different
+ * affinity. A demoted handler still moves to the deferred worker.
+ *
+ * The display service attaches the LVGL task and calls
+ * system_event_ui_run() from it with the port lock held. While nothing
+ * is attached, UI handlers run on a worker of CONFIG_SYSTEM_SERVICE_UI_CORE,
+ * so they still take the port lock; it is recursive, and free to take in
+ * the LVGL task. CRITICAL events run on the critical task regardless.
+ */
+esp_err_t system_event_set_affinity(system_service_id_t service_id,
+                                    system_event_type_t event_type,
+                                    system_event_affinity_t affinity);
+
+esp_err_t system_event_ui_attach(void);
+
+void system_event_ui_detach(void);
+
+/* Run up to max_jobs queued UI handlers; returns how many ran */
+uint32_t system_event_ui_run(uint32_t max_jobs);
+
+/* Direct subscriptions plus matching wildcard subscriptions */
+esp_err_t system_event_get_subscriber_count(system_event_type_t event_type, uint16_t *out_count);
+
+/*
+ * Handler profiles (CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING), one per
+ * (subscriber, event type) pair. get_top_handlers fills out_profiles with
+ * the most expensive pairs by total time, most expensive first; dump logs
+ * the top_n (at most 16) of them.
+ */
+esp_err_t system_event_get_handler_profile(system_service_id_t service_id,
+                                           system_event_type_t event_type,
+                                           system_handler_profile_t *out_profile);
+
+esp_err_t system_event_get_top_handlers(system_handler_profile_t *out_profiles,
+                                        size_t max_profiles,
+                                        size_t *out_count);
+
+esp_err_t system_event_reset_handler_profiles(void);
+
+esp_err_t system_event_dump_handler_profiles(size_t top_n);
+
 esp_err_t system_event_get_type_name(system_event_type_t event_type,
                                       char *out_name,
                                       size_t max_len);
@@ -0,0 +1,215 @@
+/**
+ * @file event_schema.h
+ * @brief Declarative event schemas with static IDs and typed payloads
+ * 
+ * A component lists its events once, as an X-macro, in its public header:
+ * 
+ * @code
+ * #define AUDIO_EVENT_SCHEMA(X) \
+ *     X(AUDIO_EVENT_STARTED,        "audio.started",        system_event_no_payload_t, 1, QUEUED) \
+ *     X(AUDIO_EVENT_VOLUME_CHANGED, "audio.volume_changed", audio_volume_event_t,      1, LATEST)
+ * 
+ * SYSTEM_EVENT_SCHEMA_DECLARE(AUDIO_EVENT_SCHEMA, AUDIO_EVENT, SYSTEM_EVENT_RANGE_AUDIO);
+ * @endcode
+ * 
+ * Columns: ID constant, event name, payload type, payload version and
+ * topic mode (QUEUED or LATEST). The declaration gives each event a
+ * system_event_type_t fixed at build time, from the component's range
+ * below, plus `<ID>_payload_t`, `<ID>_VERSION` and `AUDIO_EVENT_COUNT`.
+ * One source file defines the table with SYSTEM_EVENT_SCHEMA_DEFINE() and
+ * registers it with system_event_register_schema(): a copy into fixed
+ * slots with name hashes computed by the compiler, no allocation and no
+ * lookup.
+ * 
+ * SYSTEM_EVENT_POST_TYPED() only compiles with a pointer to the event's
+ * payload type, and SYSTEM_EVENT_PAYLOAD() returns the typed payload or
+ * NULL when the event carries less than the receiver's struct.
+ * 
+ * Payload versions replace versioned_event_header_t: fields are only
+ * ever appended, the version is bumped when they are, and the registered
+ * version and size are available from system_event_get_schema(). Events
+ * without a payload use system_event_no_payload_t; variable length ones
+ * use system_event_bytes_t and are posted with system_event_post().
+ */
+
+#ifndef SYSTEM_SERVICE_EVENT_SCHEMA_H
+#define SYSTEM_SERVICE_EVENT_SCHEMA_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include "system_service/event_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Static ID Ranges
+ * ============================================================================ */
+
+/* One range per component with a schema; IDs from SYSTEM_EVENT_STATIC_TYPES
+ * up are handed out by system_event_register_type() at runtime */
+#define SYSTEM_EVENT_RANGE_COMMON       0, 24
+#define SYSTEM_EVENT_RANGE_NETWORK      24, 16
+#define SYSTEM_EVENT_RANGE_AUDIO        40, 8
+#define SYSTEM_EVENT_RANGE_BLUETOOTH    48, 16
+#define SYSTEM_EVENT_RANGE_INPUT        64, 8
+#define SYSTEM_EVENT_STATIC_TYPES       72
+
+_Static_assert(SYSTEM_EVENT_STATIC_TYPES < SYSTEM_SERVICE_MAX_EVENT_TYPES,
+               "CONFIG_SYSTEM_SERVICE_MAX_EVENT_TYPES leaves no room for runtime event types");
+
+/* ============================================================================
+ * Payload Markers
+ * ============================================================================ */
+
+/** Payload type of events that carry no data */
+typedef struct {
+    uint8_t unused_;
+} system_event_no_payload_t;
+
+/** Payload type of events whose data has no fixed layout */
+typedef struct {
+    uint8_t unused_;
+} system_event_bytes_t;
+
+#define SYSTEM_EVENT_SCHEMA_SIZE_(type) \
+    (__builtin_types_compatible_p(type, system_event_no_payload_t) || \
+     __builtin_types_compatible_p(type, system_event_bytes_t) ? 0 : sizeof(type))
+
+/* ============================================================================
+ * Schema Table
+ * ============================================================================ */
+
+typedef struct {
+    system_event_type_t event_type;
+    uint16_t payload_size;                  /**< 0: none or variable */
+    uint16_t version;
+    system_event_topic_mode_t mode;
+    uint32_t name_hash;                     /**< SYSTEM_EVENT_NAME_HASH(name) */
+    const char *name;
+} system_event_schema_t;
+
+#define SYSTEM_EVENT_SCHEMA_MODE_QUEUED     SYSTEM_EVENT_TOPIC_QUEUED
+#define SYSTEM_EVENT_SCHEMA_MODE_LATEST     SYSTEM_EVENT_TOPIC_LATEST
+
+#define SYSTEM_EVENT_SCHEMA_RANGE_BASE_(base, size)     (base)
+#define SYSTEM_EVENT_SCHEMA_RANGE_SIZE_(base, size)     (size)
+#define SYSTEM_EVENT_SCHEMA_BASE_(...)      SYSTEM_EVENT_SCHEMA_RANGE_BASE_(__VA_ARGS__)
+#define SYSTEM_EVENT_SCHEMA_SPAN_(...)      SYSTEM_EVENT_SCHEMA_RANGE_SIZE_(__VA_ARGS__)
+
+#define SYSTEM_EVENT_SCHEMA_ID_(id_, name_, type_, version_, mode_)      id_,
+
+#define SYSTEM_EVENT_SCHEMA_TYPES_(id_, name_, type_, version_, mode_) \
+    typedef type_ id_##_payload_t; \
+    enum { id_##_VERSION = (version_) }; \
+    _Static_assert(SYSTEM_EVENT_SCHEMA_SIZE_(type_) <= SYSTEM_MAX_DATA_SIZE, \
+                   "payload of " #id_ " is over CONFIG_SYSTEM_SERVICE_MAX_DATA_SIZE"); \
+    _Static_assert(sizeof(name_) <= SYSTEM_SERVICE_MAX_NAME_LEN, "name of " #id_ " is too long");
+
+#define SYSTEM_EVENT_SCHEMA_ENTRY_(id_, name_, type_, version_, mode_) { \
+        .event_type = (id_), \
+        .payload_size = SYSTEM_EVENT_SCHEMA_SIZE_(type_), \
+        .version = (version_), \
+        .mode = SYSTEM_EVENT_SCHEMA_MODE_##mode_, \
+        .name_hash = SYSTEM_EVENT_NAME_HASH(name_), \
+        .name = (name_), \
+    },
+
+/**
+ * @brief Assign IDs and payload types for a schema, in its header
+ * 
+ * @param schema X-macro listing the events
+ * @param prefix Prefix of the generated `<prefix>_COUNT`
+ * @param ... One of the SYSTEM_EVENT_RANGE_ values
+ */
+#define SYSTEM_EVENT_SCHEMA_DECLARE(schema, prefix, ...) \
+    enum { \
+        prefix##_SCHEMA_FIRST_ = SYSTEM_EVENT_SCHEMA_BASE_(__VA_ARGS__) - 1, \
+        schema(SYSTEM_EVENT_SCHEMA_ID_) \
+        prefix##_SCHEMA_END_ \
+    }; \
+    enum { prefix##_COUNT = prefix##_SCHEMA_END_ - SYSTEM_EVENT_SCHEMA_BASE_(__VA_ARGS__) }; \
+    _Static_assert(prefix##_COUNT <= SYSTEM_EVENT_SCHEMA_SPAN_(__VA_ARGS__), \
+                   #prefix " events overflow their ID range"); \
+    schema(SYSTEM_EVENT_SCHEMA_TYPES_) \
+    extern const system_event_schema_t prefix##_SCHEMA_TABLE[prefix##_COUNT]
+
+/**
+ * @brief Define the schema's table, in one source file
+ */
+#define SYSTEM_EVENT_SCHEMA_DEFINE(schema, prefix) \
+    const system_event_schema_t prefix##_SCHEMA_TABLE[prefix##_COUNT] = { \
+        schema(SYSTEM_EVENT_SCHEMA_ENTRY_) \
+    }
+
+#define SYSTEM_EVENT_SCHEMA_REGISTER(prefix) \
+    system_event_register_schema(prefix##_SCHEMA_TABLE, prefix##_COUNT)
+
+/* ============================================================================
+ * Typed Posting and Access
+ * ============================================================================ */
+
+/**
+ * @brief Post a schema event; fails to compile on a wrong payload type
+ */
+#define SYSTEM_EVENT_POST_TYPED(sender_id, id, payload, priority) __extension__ ({ \
+        _Static_assert(__builtin_types_compatible_p(__typeof__(*(payload)), id##_payload_t), \
+                       "payload is not " #id "_payload_t"); \
+        _Static_assert(SYSTEM_EVENT_SCHEMA_SIZE_(id##_payload_t) != 0, \
+                       #id " has no fixed payload"); \
+        system_event_post((sender_id), (id), (payload), sizeof(id##_payload_t), (priority)); \
+    })
+
+/**
+ * @brief Post a schema event that carries no payload
+ */
+#define SYSTEM_EVENT_POST_EMPTY(sender_id, id, priority) __extension__ ({ \
+        _Static_assert(__builtin_types_compatible_p(id##_payload_t, system_event_no_payload_t), \
+                       #id " has a payload"); \
+        system_event_post((sender_id), (id), NULL, 0, (priority)); \
+    })
+
+/**
+ * @brief Typed payload of a received schema event, or NULL
+ * 
+ * NULL if the event isn't `id` or is shorter than `<id>_payload_t`, as
+ * from a producer built against an older version.
+ */
+#define SYSTEM_EVENT_PAYLOAD(event, id) \
+    ((const id##_payload_t *)((event)->event_type == (id) && (event)->data != NULL && \
+                              (event)->data_size >= sizeof(id##_payload_t) ? \
+                              (event)->data : NULL))
+
+/* ============================================================================
+ * Registration
+ * ============================================================================ */
+
+/**
+ * @brief Install a schema's event types at their static IDs
+ * 
+ * Registering the same schema again is a no-op, so both main and the
+ * producing service may do it.
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an ID outside the
+ *         static ranges, ESP_ERR_INVALID_STATE if a name is already
+ *         registered at another ID or an ID under another name
+ */
+esp_err_t system_event_register_schema(const system_event_schema_t *schema, size_t count);
+
+/**
+ * @brief Registered payload size and version of an event type
+ * 
+ * Types registered by name at runtime report size 0, version 0.
+ */
+esp_err_t system_event_get_schema(system_event_type_t event_type,
+                                  uint16_t *out_payload_size,
+                                  uint16_t *out_version);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_EVENT_SCHEMA_H
@@ -0,0 +1,191 @@
+/**
+ * @file flight_recorder.h
+ * @brief Persistent trace and metrics log on the storage partition
+ *
+ * A low-priority task drains the trace rings (system_trace.h) and samples
+ * the metrics registry into a sector image in RAM. Full sectors are
+ * written to a circular log spanning the whole partition, oldest sector
+ * erased first, so wear is spread evenly over it and the hot path pays
+ * nothing beyond its ring write. The sector being filled lives in
+ * no-init RAM and is written out on the next boot if the device reset
+ * before it was full, so a crash loses nothing that reached the ring.
+ *
+ * The last N minutes, across reboots, are retrieved with
+ * flight_recorder_read(): over the console with
+ * flight_recorder_dump_console(), over WiFi with
+ * network_telemetry_upload_flight() and over BLE with the bulk transfer
+ * service. tools/trace2json.py turns the dump into a Perfetto trace with
+ * one process per boot.
+ *
+ * Compiles to ESP_ERR_NOT_SUPPORTED stubs without
+ * CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER.
+ */
+
+#ifndef SYSTEM_SERVICE_FLIGHT_RECORDER_H
+#define SYSTEM_SERVICE_FLIGHT_RECORDER_H
+
+#include "esp_err.h"
+#include "system_service/system_trace.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLIGHT_SECTOR_MAGIC         0x3152464B  // "KFR1"
+#define FLIGHT_DUMP_MAGIC           0x3144464B  // "KFD1"
+#define FLIGHT_DUMP_VERSION         1
+#define FLIGHT_RECORDER_SECTOR_SIZE 4096
+#define FLIGHT_MARK_MAX_LEN         48
+
+/* ============================================================================
+ * On-Flash Layout
+ * ============================================================================ */
+
+/**
+ * @brief Header at the start of every sector
+ *
+ * Written after the sector's data, so a sector whose header checks out
+ * holds `used` valid bytes of entries after it. Sequence numbers increase
+ * by one per sector written and never repeat within a partition.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;                     // FLIGHT_SECTOR_MAGIC
+    uint32_t seq;
+    uint32_t boot;                      // Boot number the sector was filled in
+    uint32_t first_ms;                  // Uptime of the first and last entries
+    uint32_t last_ms;
+    uint16_t used;                      // Entry bytes after the header
+    uint16_t entries;
+    uint32_t data_crc;                  // CRC32 of the `used` bytes
+    uint32_t header_crc;                // CRC32 of the fields above
+} flight_sector_header_t;
+
+typedef enum {
+    FLIGHT_ENTRY_BOOT = 1,              // flight_boot_t
+    FLIGHT_ENTRY_TRACE,                 // flight_trace_t, then system_trace_record_t[]
+    FLIGHT_ENTRY_NAMES,                 // system_trace_name_t[]
+    FLIGHT_ENTRY_METRICS,               // flight_metrics_t, then flight_metric_t[]
+    FLIGHT_ENTRY_MARK,                  // Text, not NUL terminated
+} flight_entry_type_t;
+
+/**
+ * @brief Entry header; the payload follows, padded to 4 bytes
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;                       // flight_entry_type_t
+    uint8_t core;                       // FLIGHT_ENTRY_TRACE: ring the records are from
+    uint16_t length;                    // Payload bytes, without padding
+    uint32_t ms;                        // Uptime when the entry was added
+} flight_entry_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t reset_reason;              // esp_reset_reason_t of this boot
+    uint32_t boot;
+} flight_boot_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t lost;                      // Records overwritten or over budget before these
+} flight_trace_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t free_internal;
+    uint32_t largest_internal;
+    uint16_t count;
+    uint16_t reserved;
+} flight_metrics_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t id;                        // system_metric_id_t, named by SYSTEM_TRACE_NAME_METRIC
+    uint8_t type;                       // system_metric_type_t
+    uint8_t reserved;
+    int32_t value;
+    uint32_t sum;                       // Histograms only
+    uint32_t max;
+} flight_metric_t;
+
+/**
+ * @brief Start of a dump; each sector follows as its header and `used` bytes
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;                     // FLIGHT_DUMP_MAGIC
+    uint16_t version;
+    uint16_t sector_size;
+    uint32_t sectors;                   // Sectors in the dump, oldest first
+    uint32_t boot;                      // Current boot number
+    uint32_t minutes;                   // Window asked for, 0 for everything
+    uint32_t cpu_freq_hz;               // Nominal, SYNC records give the real rate
+} flight_dump_header_t;
+
+typedef struct {
+    uint32_t sectors;                   // Sectors in the partition
+    uint32_t sectors_valid;             // Holding a readable sector
+    uint32_t sectors_written;           // This boot
+    uint32_t boot;
+    uint32_t records_logged;            // Trace records stored this boot
+    uint32_t records_lost;              // Overwritten or over budget this boot
+    uint32_t write_errors;
+} flight_recorder_stats_t;
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+/**
+ * @brief Open the partition, recover the last boot's sector and start logging
+ *
+ * Called by system_service_start(), after system_trace_init().
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND without the partition
+ */
+esp_err_t flight_recorder_start(void);
+
+/**
+ * @brief Write out what is buffered and stop the task
+ */
+void flight_recorder_stop(void);
+
+/**
+ * @brief Add a text marker, e.g. the reason for entering safe mode
+ *
+ * Safe from any task; the text is truncated to FLIGHT_MARK_MAX_LEN.
+ */
+esp_err_t flight_recorder_mark(const char *text);
+
+/**
+ * @brief Drain the rings and write the current sector to flash now
+ *
+ * The sector is written even if it is part full, which costs an erase
+ * cycle; for shutdown paths, not for routine use.
+ */
+esp_err_t flight_recorder_flush(void);
+
+/**
+ * @brief Stream the log out, oldest sector first
+ *
+ * Sectors are read under the recorder's lock one at a time, so logging
+ * continues while a slow transport sends. The sector being filled comes
+ * last, as it is at the time of the call.
+ *
+ * @param minutes Sectors of the last `minutes` of uptime, summed over
+ *                boots; 0 for the whole log
+ * @param write Sink, called with the dump header and then each sector
+ * @param user_data Passed to write
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not started, or the
+ *         sink's error
+ */
+esp_err_t flight_recorder_read(uint32_t minutes, system_trace_write_fn_t write, void *user_data);
+
+/**
+ * @brief flight_recorder_read() to the console, between KFLIGHT markers
+ */
+esp_err_t flight_recorder_dump_console(uint32_t minutes);
+
+esp_err_t flight_recorder_get_stats(flight_recorder_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_FLIGHT_RECORDER_H
@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include "esp_heap_caps.h"
+#include "system_service/system_types.h"
 #include <stddef.h>
 #include <stdbool.h>
 
@@ -83,6 +84,19 @@ void* memory_alloc_psram_only(size_t size);
  */
 void* memory_alloc_sram_only(size_t size);
 
+/**
+ * @brief Allocate like memory_alloc_prefer_psram() and charge it to owner
+ * 
+ * The bytes count against the owner's memory quota; returns NULL when the
+ * quota would be exceeded. Free with memory_free_tagged().
+ */
+void* memory_alloc_prefer_psram_tagged(system_service_id_t owner, size_t size);
+
+/**
+ * @brief Free memory from memory_alloc_prefer_psram_tagged() and uncharge it
+ */
+void memory_free_tagged(void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,87 @@
+#ifndef SYSTEM_SERVICE_POWER_LOCK_H
+#define SYSTEM_SERVICE_POWER_LOCK_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Refcounted power locks over esp_pm
+ *
+ * Anything that needs the clocks up holds a lock for as long as it is
+ * active; in between, the power manager configured by the power service
+ * lowers the CPU frequency and enters automatic light sleep. Each lock is
+ * named for the residency report and counts its own holders, so it can be
+ * acquired again by whoever already holds it. The event dispatcher holds
+ * a CPU_MAX lock while handlers run.
+ *
+ * Acquire and release are safe from any task and cost a few µs. Without
+ * CONFIG_PM_ENABLE the locks are only counted, and the residency shows
+ * the modes the system would have been allowed to enter.
+ */
+
+#define SYSTEM_POWER_LOCK_NAME_LEN  16
+
+typedef enum {
+    SYSTEM_POWER_LOCK_CPU_MAX = 0,  // CPU at its maximum frequency
+    SYSTEM_POWER_LOCK_APB_MAX,      // APB at 80 MHz, for peripherals clocked from it
+    SYSTEM_POWER_LOCK_NO_SLEEP,     // No automatic light sleep, any frequency
+    SYSTEM_POWER_LOCK_TYPE_COUNT,
+} system_power_lock_type_t;
+
+// Most demanding lock held decides the mode
+typedef enum {
+    SYSTEM_POWER_MODE_CPU_MAX = 0,
+    SYSTEM_POWER_MODE_APB_MAX,
+    SYSTEM_POWER_MODE_AWAKE,        // Minimum frequency, no light sleep
+    SYSTEM_POWER_MODE_SLEEP,        // No locks: light sleep whenever idle
+    SYSTEM_POWER_MODE_COUNT,
+} system_power_mode_t;
+
+typedef struct system_power_lock *system_power_lock_t;
+
+typedef struct {
+    uint64_t time_us[SYSTEM_POWER_MODE_COUNT];  // Since boot
+    system_power_mode_t mode;       // Current mode
+    uint32_t transitions;
+} system_power_residency_t;
+
+typedef struct {
+    char name[SYSTEM_POWER_LOCK_NAME_LEN];
+    system_power_lock_type_t type;
+    uint32_t holders;               // Current acquire count
+    uint32_t acquisitions;          // Acquires that took holders 0 -> 1
+    uint64_t held_us;               // Total time with at least one holder
+} system_power_lock_info_t;
+
+/**
+ * @brief Create a lock; locks live for the life of the system
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM once CONFIG_SYSTEM_SERVICE_MAX_POWER_LOCKS
+ *         locks exist
+ */
+esp_err_t system_power_lock_create(system_power_lock_type_t type, const char *name,
+                                   system_power_lock_t *out_lock);
+
+esp_err_t system_power_lock_acquire(system_power_lock_t lock);
+
+// ESP_ERR_INVALID_STATE on a lock that is not held
+esp_err_t system_power_lock_release(system_power_lock_t lock);
+
+esp_err_t system_power_get_residency(system_power_residency_t *out_residency);
+
+/* One entry per lock, in creation order */
+esp_err_t system_power_get_locks(system_power_lock_info_t *out_info, size_t max_count,
+                                 size_t *out_count);
+
+const char *system_power_mode_name(system_power_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_POWER_LOCK_H
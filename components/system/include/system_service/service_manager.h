@@ -21,6 +21,20 @@ esp_err_t system_service_get_state(system_service_id_t service_id,
 
 esp_err_t system_service_heartbeat(system_service_id_t service_id);
 
+/**
+ * Liveness probe, run from the shared heartbeat timer (esp_timer task).
+ * Must not block; return false to withhold the heartbeat.
+ */
+typedef bool (*system_service_heartbeat_probe_t)(void *user_data);
+
+// Heartbeat the service every CONFIG_SYSTEM_SERVICE_HEARTBEAT_PROBE_INTERVAL_MS
+// while it is RUNNING and probe (NULL = none) passes - no task of its own needed.
+esp_err_t system_service_enable_auto_heartbeat(system_service_id_t service_id,
+                                               system_service_heartbeat_probe_t probe,
+                                               void *user_data);
+
+esp_err_t system_service_disable_auto_heartbeat(system_service_id_t service_id);
+
 esp_err_t system_service_get_info(system_service_id_t service_id,
                                    system_service_info_t *out_info);
 
@@ -28,6 +42,39 @@ esp_err_t system_service_list_all(system_service_info_t *out_services,
                                    uint32_t max_count,
                                    uint32_t *out_count);
 
+#define SYSTEM_SERVICE_MAX_ACTIVATABLE  8
+
+/**
+ * Service brought up on first use instead of at boot. It is initialised
+ * and started when another service subscribes to one of its topics, when
+ * ui_event is posted, or on system_service_activate(), and deinitialised
+ * again once unused for idle_timeout_ms. ui_event is handed to the
+ * service's own handler for it after activation, so the click that woke
+ * it still opens its UI.
+ */
+typedef struct {
+    const char *name;               // Name the service registers itself under
+    esp_err_t (*init)(void);        // Must leave nothing behind when it fails
+    esp_err_t (*start)(void);       // Can be NULL
+    esp_err_t (*stop)(void);        // Can be NULL
+    esp_err_t (*deinit)(void);      // NULL keeps it up once active
+    const char *topics;             // Pattern of its event types, "bluetooth.*" (NULL = none)
+    const char *ui_event;           // Event that opens its UI (NULL = none)
+    uint32_t idle_timeout_ms;       // 0 = never deinit
+    bool (*busy)(void);             // Vetoes the idle deinit while true (can be NULL)
+} system_service_activatable_t;
+
+// desc must stay valid; with CONFIG_SYSTEM_SERVICE_LAZY_ACTIVATION off the
+// service is brought up right away and stays up.
+esp_err_t system_service_register_activatable(const system_service_activatable_t *desc);
+
+// Bring a service up if needed and wait up to timeout_ms for it, e.g. before
+// sending it a request. 0 only queues the activation. Services that are not
+// activatable are just looked up. ESP_ERR_TIMEOUT if not up in time.
+esp_err_t system_service_activate(const char *service_name,
+                                  uint32_t timeout_ms,
+                                  system_service_id_t *out_service_id);
+
 #ifdef __cplusplus
 }
 #endif
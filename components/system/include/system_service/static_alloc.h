@@ -0,0 +1,118 @@
+/**
+ * @file static_alloc.h
+ * @brief Storage-agnostic creation of FreeRTOS kernel objects
+ * 
+ * With CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION the system service and the
+ * driver services create their mutexes, queues and tasks from storage
+ * reserved at link time instead of the internal heap, so boot allocates
+ * nothing for them and the heap is left whole for WiFi/BLE buffers.
+ * Without it the same macros map to the dynamic FreeRTOS calls.
+ * 
+ * Each object is declared once at file scope and created by name:
+ * 
+ *     SYSTEM_MUTEX_DEFINE(s_lock);
+ *     SYSTEM_TASK_DEFINE(s_worker, 4096);
+ * 
+ *     ctx.mutex = SYSTEM_MUTEX_CREATE(s_lock);
+ *     ret = SYSTEM_TASK_CREATE(s_worker, worker_task, "worker", 4096, NULL, 5, &ctx.task);
+ * 
+ * A static object can exist once: create it again only after the previous
+ * instance has been deleted and, for tasks, has finished running.
+ */
+
+#ifndef SYSTEM_SERVICE_STATIC_ALLOC_H
+#define SYSTEM_SERVICE_STATIC_ALLOC_H
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+
+/* ============================================================================
+ * Static Storage
+ * ============================================================================ */
+
+/** Reserve storage for a mutex */
+#define SYSTEM_MUTEX_DEFINE(name)           static StaticSemaphore_t name
+
+/** Reserve storage for a binary or counting semaphore */
+#define SYSTEM_SEMAPHORE_DEFINE(name)       static StaticSemaphore_t name
+
+/** Reserve storage for a queue of length items of item_size bytes */
+#define SYSTEM_QUEUE_DEFINE(name, length, item_size) \
+    static StaticQueue_t name; \
+    static uint8_t name##_items[(length) * (item_size)]
+
+/** Reserve a TCB and a stack of stack_size bytes in internal RAM */
+#define SYSTEM_TASK_DEFINE(name, stack_size) \
+    static StaticTask_t name; \
+    static StackType_t name##_stack[(stack_size) / sizeof(StackType_t)]
+
+#define SYSTEM_MUTEX_CREATE(name)           xSemaphoreCreateMutexStatic(&(name))
+#define SYSTEM_BINARY_CREATE(name)          xSemaphoreCreateBinaryStatic(&(name))
+#define SYSTEM_COUNTING_CREATE(name, max, initial) \
+    xSemaphoreCreateCountingStatic((max), (initial), &(name))
+#define SYSTEM_QUEUE_CREATE(name, length, item_size) \
+    xQueueCreateStatic((length), (item_size), name##_items, &(name))
+
+/** Create a task; evaluates to pdPASS on success like xTaskCreate() */
+#define SYSTEM_TASK_CREATE(name, fn, task_name, stack_size, arg, prio, handle) \
+    system_task_create_static((fn), (task_name), sizeof(name##_stack), (arg), (prio), \
+                              (handle), name##_stack, &(name), tskNO_AFFINITY)
+
+/** Create a task pinned to core; evaluates to pdPASS on success */
+#define SYSTEM_TASK_CREATE_PINNED(name, fn, task_name, stack_size, arg, prio, handle, core) \
+    system_task_create_static((fn), (task_name), sizeof(name##_stack), (arg), (prio), \
+                              (handle), name##_stack, &(name), (core))
+
+static inline BaseType_t system_task_create_static(TaskFunction_t fn, const char *task_name,
+                                                   uint32_t stack_size, void *arg,
+                                                   UBaseType_t prio, TaskHandle_t *handle,
+                                                   StackType_t *stack, StaticTask_t *tcb,
+                                                   BaseType_t core)
+{
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(fn, task_name, stack_size, arg, prio,
+                                                      stack, tcb, core);
+    if (handle != NULL) {
+        *handle = task;
+    }
+    return (task != NULL) ? pdPASS : errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+}
+
+#else
+
+/* ============================================================================
+ * Dynamic Fallback
+ * ============================================================================ */
+
+#define SYSTEM_MUTEX_DEFINE(name)
+#define SYSTEM_SEMAPHORE_DEFINE(name)
+#define SYSTEM_QUEUE_DEFINE(name, length, item_size)
+#define SYSTEM_TASK_DEFINE(name, stack_size)
+
+#define SYSTEM_MUTEX_CREATE(name)           xSemaphoreCreateMutex()
+#define SYSTEM_BINARY_CREATE(name)          xSemaphoreCreateBinary()
+#define SYSTEM_COUNTING_CREATE(name, max, initial) \
+    xSemaphoreCreateCounting((max), (initial))
+#define SYSTEM_QUEUE_CREATE(name, length, item_size) \
+    xQueueCreate((length), (item_size))
+
+#define SYSTEM_TASK_CREATE(name, fn, task_name, stack_size, arg, prio, handle) \
+    xTaskCreate((fn), (task_name), (stack_size), (arg), (prio), (handle))
+#define SYSTEM_TASK_CREATE_PINNED(name, fn, task_name, stack_size, arg, prio, handle, core) \
+    xTaskCreatePinnedToCore((fn), (task_name), (stack_size), (arg), (prio), (handle), (core))
+
+#endif // CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_STATIC_ALLOC_H
@@ -0,0 +1,97 @@
+/**
+ * @file system_log.h
+ * @brief Deferred, rate-limited logging for hot paths
+ * 
+ * SYSTEM_LOGI() and friends take the service that logs, a tag, a format
+ * and up to SYSTEM_LOG_MAX_ARGS integer or pointer arguments. The caller
+ * only stores the format pointer and the raw arguments in a queue; a
+ * low-priority task formats them and writes to the console, so the
+ * caller never formats or waits on the UART.
+ * 
+ * Because formatting happens later:
+ *  - `%s` arguments must outlive the call (literals, static names)
+ *  - floating point and 64-bit conversions are not supported
+ * 
+ * Each service has a token bucket of CONFIG_SYSTEM_SERVICE_LOG_RATE_PER_SEC
+ * messages with bursts of CONFIG_SYSTEM_SERVICE_LOG_BURST. Messages over the
+ * budget are counted and reported as "N messages suppressed". Errors are
+ * never rate limited.
+ * 
+ * Without CONFIG_SYSTEM_SERVICE_LOG_DEFERRED the macros are plain ESP_LOGx calls.
+ */
+
+#ifndef SYSTEM_SERVICE_SYSTEM_LOG_H
+#define SYSTEM_SERVICE_SYSTEM_LOG_H
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "system_service/system_types.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYSTEM_LOG_MAX_ARGS     6
+
+#if CONFIG_SYSTEM_SERVICE_LOG_DEFERRED
+
+/**
+ * @brief Queue one message; use the SYSTEM_LOGx macros instead
+ * 
+ * Safe from any task, not from ISRs. Before the logger task runs, and if
+ * the queue is full, the message is formatted in place or dropped and
+ * counted respectively.
+ */
+void system_log_deferred(system_service_id_t service_id, esp_log_level_t level,
+                         const char *tag, const char *format,
+                         uint8_t arg_count, const uintptr_t *args);
+
+/* Argument count and per-argument cast, for up to SYSTEM_LOG_MAX_ARGS */
+#define SYSTEM_LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define SYSTEM_LOG_NARG(...)    SYSTEM_LOG_NARG_(_0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define SYSTEM_LOG_CAT_(a, b)   a##b
+#define SYSTEM_LOG_CAT(a, b)    SYSTEM_LOG_CAT_(a, b)
+#define SYSTEM_LOG_CAST_0()
+#define SYSTEM_LOG_CAST_1(a)        (uintptr_t)(a)
+#define SYSTEM_LOG_CAST_2(a, ...)   (uintptr_t)(a), SYSTEM_LOG_CAST_1(__VA_ARGS__)
+#define SYSTEM_LOG_CAST_3(a, ...)   (uintptr_t)(a), SYSTEM_LOG_CAST_2(__VA_ARGS__)
+#define SYSTEM_LOG_CAST_4(a, ...)   (uintptr_t)(a), SYSTEM_LOG_CAST_3(__VA_ARGS__)
+#define SYSTEM_LOG_CAST_5(a, ...)   (uintptr_t)(a), SYSTEM_LOG_CAST_4(__VA_ARGS__)
+#define SYSTEM_LOG_CAST_6(a, ...)   (uintptr_t)(a), SYSTEM_LOG_CAST_5(__VA_ARGS__)
+
+#define SYSTEM_LOG_LEVEL(level, service_id, tag, format, ...) do { \
+        if (LOG_LOCAL_LEVEL >= (level)) { \
+            const uintptr_t system_log_args_[SYSTEM_LOG_MAX_ARGS] = { \
+                SYSTEM_LOG_CAT(SYSTEM_LOG_CAST_, SYSTEM_LOG_NARG(__VA_ARGS__))(__VA_ARGS__) \
+            }; \
+            system_log_deferred((service_id), (level), (tag), (format), \
+                                SYSTEM_LOG_NARG(__VA_ARGS__), system_log_args_); \
+        } \
+    } while (0)
+
+#else
+
+#define SYSTEM_LOG_LEVEL(level, service_id, tag, format, ...) do { \
+        (void)(service_id); \
+        ESP_LOG_LEVEL_LOCAL((level), (tag), format, ##__VA_ARGS__); \
+    } while (0)
+
+#endif // CONFIG_SYSTEM_SERVICE_LOG_DEFERRED
+
+#define SYSTEM_LOGE(service_id, tag, format, ...) \
+    SYSTEM_LOG_LEVEL(ESP_LOG_ERROR, service_id, tag, format, ##__VA_ARGS__)
+#define SYSTEM_LOGW(service_id, tag, format, ...) \
+    SYSTEM_LOG_LEVEL(ESP_LOG_WARN, service_id, tag, format, ##__VA_ARGS__)
+#define SYSTEM_LOGI(service_id, tag, format, ...) \
+    SYSTEM_LOG_LEVEL(ESP_LOG_INFO, service_id, tag, format, ##__VA_ARGS__)
+#define SYSTEM_LOGD(service_id, tag, format, ...) \
+    SYSTEM_LOG_LEVEL(ESP_LOG_DEBUG, service_id, tag, format, ##__VA_ARGS__)
+#define SYSTEM_LOGV(service_id, tag, format, ...) \
+    SYSTEM_LOG_LEVEL(ESP_LOG_VERBOSE, service_id, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_SYSTEM_LOG_H
@@ -0,0 +1,127 @@
+#ifndef SYSTEM_SERVICE_SYSTEM_METRICS_H
+#define SYSTEM_SERVICE_SYSTEM_METRICS_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Metrics registry and snapshots
+ * 
+ * The registry holds named counters, gauges and histograms. Updating one
+ * is a single atomic operation (a few for histograms) and takes no lock,
+ * so the event bus and dispatcher update theirs on every event. The
+ * built-in metrics below are always registered; services register their
+ * own with system_metric_register().
+ * 
+ * The snapshot functions fill the structures of system_types.h from the
+ * registry and the counters the watchdog, handler monitor and memory
+ * pools keep. Nothing is allocated or formatted, and the system lock is
+ * not taken, so the UI, telemetry and benchmarks can poll them often.
+ * 
+ * Counters and histogram sums are 32 bits and wrap; consumers take the
+ * difference between two snapshots.
+ */
+
+#define SYSTEM_METRICS_MAX_POOLS    9   // memory_pool size classes
+
+#define SYSTEM_METRIC_NAME_LEN              24
+#define SYSTEM_METRIC_HISTOGRAM_BUCKETS     16  // Bucket i counts values below 2^i, the last the rest
+#define SYSTEM_METRIC_ID_INVALID            0xFFFF
+
+typedef uint16_t system_metric_id_t;
+
+typedef enum {
+    SYSTEM_METRIC_COUNTER = 0,          /**< Only goes up (and wraps) */
+    SYSTEM_METRIC_GAUGE,                /**< Signed value that is set or adjusted */
+    SYSTEM_METRIC_HISTOGRAM,            /**< Distribution of observed values */
+} system_metric_type_t;
+
+/**
+ * @brief Built-in metrics, registered by system_service_init()
+ */
+enum {
+    SYSTEM_METRIC_EVENTS_POSTED = 0,    /**< Counter: events accepted by the bus */
+    SYSTEM_METRIC_EVENTS_PROCESSED,     /**< Counter: events taken by the event task */
+    SYSTEM_METRIC_SERVICES,             /**< Gauge: registered services */
+    SYSTEM_METRIC_SERVICES_RUNNING,     /**< Gauge: services in RUNNING */
+    SYSTEM_METRIC_SERVICES_ERROR,       /**< Gauge: services in ERROR */
+    SYSTEM_METRIC_SUBSCRIPTIONS,        /**< Gauge: active subscriptions */
+    SYSTEM_METRIC_HANDLER_US,           /**< Histogram: handler run time (us) */
+    SYSTEM_METRIC_DEADLINE_MISSES,      /**< Counter: handlers back after their event's deadline */
+    SYSTEM_METRIC_EVENTS_FILTERED,      /**< Counter: deliveries a subscription filter skipped */
+    SYSTEM_METRIC_BUILTIN_COUNT
+};
+
+typedef struct {
+    char name[SYSTEM_METRIC_NAME_LEN];
+    system_metric_type_t type;
+    system_service_id_t owner;          /**< Registering service, INVALID for built-ins */
+    int32_t value;                      /**< Counter or gauge value; histogram: observations */
+    uint32_t sum;                       /**< Histogram: sum of observed values */
+    uint32_t max;                       /**< Histogram: largest observed value */
+    uint32_t buckets[SYSTEM_METRIC_HISTOGRAM_BUCKETS];
+} system_metric_snapshot_t;
+
+/**
+ * @brief Register a metric
+ * 
+ * Registering a name that already exists with the same type returns the
+ * existing metric, so a restarted service gets its counters back.
+ * 
+ * @param owner Service the metric belongs to; its metrics are dropped
+ *              when it unregisters
+ * @param name Metric name, under SYSTEM_METRIC_NAME_LEN bytes
+ * @param type Counter, gauge or histogram
+ * @param out_id Metric to pass to the update functions
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the registry is full,
+ *         ESP_ERR_INVALID_STATE if the name exists with another type,
+ *         ESP_ERR_NOT_SUPPORTED without CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+ */
+esp_err_t system_metric_register(system_service_id_t owner, const char *name,
+                                 system_metric_type_t type, system_metric_id_t *out_id);
+
+esp_err_t system_metric_unregister(system_metric_id_t id);
+
+/**
+ * @brief Look a metric up by name
+ */
+esp_err_t system_metric_find(const char *name, system_metric_id_t *out_id);
+
+/* Lock-free updates, safe from any task or ISR; unknown IDs are ignored */
+void system_metric_add(system_metric_id_t id, uint32_t delta);
+void system_metric_set(system_metric_id_t id, int32_t value);
+void system_metric_gauge_add(system_metric_id_t id, int32_t delta);
+void system_metric_observe(system_metric_id_t id, uint32_t value);
+
+esp_err_t system_metric_get(system_metric_id_t id, system_metric_snapshot_t *out_snapshot);
+
+/**
+ * @brief Snapshot every registered metric, built-ins first
+ */
+esp_err_t system_metrics_snapshot(system_metric_snapshot_t *out_snapshots,
+                                  size_t max_count,
+                                  size_t *out_count);
+
+esp_err_t system_metrics_get_global(global_metrics_t *out_metrics);
+
+esp_err_t system_metrics_get_service(system_service_id_t service_id,
+                                     service_metrics_t *out_metrics);
+
+esp_err_t system_metrics_get_queue(event_queue_stats_t *out_stats);
+
+/* One entry per pool size class, smallest blocks first */
+esp_err_t system_metrics_get_pools(memory_pool_stats_t *out_stats,
+                                   size_t max_count,
+                                   size_t *out_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_SYSTEM_METRICS_H
@@ -0,0 +1,186 @@
+#ifndef SYSTEM_SERVICE_SYSTEM_SETTINGS_H
+#define SYSTEM_SERVICE_SYSTEM_SETTINGS_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "system_service/system_types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Persistent settings with a write-back RAM cache
+ * 
+ * A service registers each setting once with its key, type and default;
+ * registration loads the stored value from NVS, so the cache is filled
+ * as the services come up and NVS is never read again. Scalar reads are
+ * a single load from the cache (the inline getters below) and may be
+ * done from any task or ISR.
+ * 
+ * A change only updates the cache and marks the setting dirty. A
+ * background task commits all dirty settings in one NVS transaction once
+ * no setting has changed for CONFIG_SYSTEM_SERVICE_SETTINGS_WRITE_DELAY_MS,
+ * or at the latest CONFIG_SYSTEM_SERVICE_SETTINGS_MAX_DELAY_MS after the
+ * first change, and on restart. Dragging a slider is thus one flash
+ * write, not one per step.
+ * 
+ * Each change is announced as COMMON_EVENT_SETTING_CHANGED, sent by the
+ * setting's owner. Changes within SYSTEM_SETTINGS_COALESCE_MS are
+ * coalesced into one event per setting carrying the latest value.
+ * 
+ * Keys are NVS keys: at most 15 characters, unique across all services.
+ */
+
+#define SYSTEM_SETTING_KEY_LEN          16      // Including the NUL, as NVS
+#define SYSTEM_SETTING_ID_INVALID       0xFFFF
+#define SYSTEM_SETTINGS_MAX             CONFIG_SYSTEM_SERVICE_MAX_SETTINGS
+#define SYSTEM_SETTINGS_COALESCE_MS     100
+
+typedef uint16_t system_setting_id_t;
+
+typedef enum {
+    SYSTEM_SETTING_BOOL = 0,
+    SYSTEM_SETTING_U8,
+    SYSTEM_SETTING_U32,
+    SYSTEM_SETTING_I32,
+    SYSTEM_SETTING_STR,                 /**< NUL-terminated, up to its registered size */
+    SYSTEM_SETTING_BLOB,                /**< Up to its registered size */
+} system_setting_type_t;
+
+typedef struct {
+    uint32_t settings;                  /**< Registered */
+    uint32_t changes;                   /**< Values changed since boot */
+    uint32_t commits;                   /**< NVS commits since boot */
+    uint32_t written;                   /**< Settings written by those commits */
+    uint32_t write_errors;
+    uint32_t bytes_used;                /**< Of CONFIG_SYSTEM_SERVICE_SETTINGS_BYTES */
+    bool dirty;                         /**< Changes not yet in flash */
+} system_settings_stats_t;
+
+/* Cache of the scalar settings, one word each; use the getters */
+extern uint32_t g_system_setting_words[SYSTEM_SETTINGS_MAX];
+
+/**
+ * @brief Register a scalar setting and load its stored value
+ * 
+ * Registering an existing key with the same type returns the existing
+ * setting, so a restarted service gets its values back.
+ * 
+ * @param owner Service the setting belongs to; it sends the change events
+ * @param key NVS key, under SYSTEM_SETTING_KEY_LEN bytes
+ * @param type BOOL, U8, U32 or I32
+ * @param default_value Value until one is stored, as a word
+ * @param out_id Setting to pass to the getters and setters
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the table is full,
+ *         ESP_ERR_INVALID_STATE if the key exists with another type
+ */
+esp_err_t system_setting_register(system_service_id_t owner, const char *key,
+                                  system_setting_type_t type, uint32_t default_value,
+                                  system_setting_id_t *out_id);
+
+/**
+ * @brief Register a string or blob setting and load its stored value
+ * 
+ * Its bytes come from a fixed area of CONFIG_SYSTEM_SERVICE_SETTINGS_BYTES.
+ * 
+ * @param size Largest value in bytes, with the NUL for strings
+ * @param default_value Initial value; a string, or `size` bytes, or NULL
+ *                      for empty
+ */
+esp_err_t system_setting_register_bytes(system_service_id_t owner, const char *key,
+                                        system_setting_type_t type, size_t size,
+                                        const void *default_value,
+                                        system_setting_id_t *out_id);
+
+/**
+ * @brief Change a scalar setting; use the typed setters
+ * 
+ * A value equal to the cached one is not a change: nothing is written
+ * and no event is sent.
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown setting
+ *         or one of another type
+ */
+esp_err_t system_setting_set_word(system_setting_id_t id, system_setting_type_t type, uint32_t value);
+
+static inline uint32_t system_setting_word(system_setting_id_t id)
+{
+    return id < SYSTEM_SETTINGS_MAX ? __atomic_load_n(&g_system_setting_words[id], __ATOMIC_RELAXED) : 0;
+}
+
+static inline bool system_setting_bool(system_setting_id_t id)
+{
+    return system_setting_word(id) != 0;
+}
+
+static inline uint8_t system_setting_u8(system_setting_id_t id)
+{
+    return (uint8_t)system_setting_word(id);
+}
+
+static inline uint32_t system_setting_u32(system_setting_id_t id)
+{
+    return system_setting_word(id);
+}
+
+static inline int32_t system_setting_i32(system_setting_id_t id)
+{
+    return (int32_t)system_setting_word(id);
+}
+
+static inline esp_err_t system_setting_set_bool(system_setting_id_t id, bool value)
+{
+    return system_setting_set_word(id, SYSTEM_SETTING_BOOL, value ? 1 : 0);
+}
+
+static inline esp_err_t system_setting_set_u8(system_setting_id_t id, uint8_t value)
+{
+    return system_setting_set_word(id, SYSTEM_SETTING_U8, value);
+}
+
+static inline esp_err_t system_setting_set_u32(system_setting_id_t id, uint32_t value)
+{
+    return system_setting_set_word(id, SYSTEM_SETTING_U32, value);
+}
+
+static inline esp_err_t system_setting_set_i32(system_setting_id_t id, int32_t value)
+{
+    return system_setting_set_word(id, SYSTEM_SETTING_I32, (uint32_t)value);
+}
+
+/**
+ * @brief Change a string or blob setting
+ * 
+ * @param len Bytes of `data`; strings ignore it and use strlen()
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if over the registered
+ *         size, ESP_ERR_INVALID_ARG for an unknown or scalar setting
+ */
+esp_err_t system_setting_set_bytes(system_setting_id_t id, const void *data, size_t len);
+
+/**
+ * @brief Copy a string or blob setting out of the cache
+ * 
+ * Strings are always NUL terminated, truncated if `size` is too small.
+ * 
+ * @param out_len Bytes copied, without the NUL; may be NULL
+ */
+esp_err_t system_setting_get_bytes(system_setting_id_t id, void *out, size_t size, size_t *out_len);
+
+esp_err_t system_setting_find(const char *key, system_setting_id_t *out_id);
+
+/**
+ * @brief Commit dirty settings now, without waiting for the quiet period
+ */
+esp_err_t system_settings_flush(void);
+
+esp_err_t system_settings_get_stats(system_settings_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_SYSTEM_SETTINGS_H
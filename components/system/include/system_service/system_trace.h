@@ -0,0 +1,190 @@
+/**
+ * @file system_trace.h
+ * @brief Binary scheduling trace
+ *
+ * With CONFIG_SYSTEM_SERVICE_TRACE every core keeps a ring of 16-byte
+ * records: event post and dequeue, handler begin and end, memory pool
+ * heap fallbacks, waits on the system lock and watchdog actions. A
+ * writer claims a slot with one atomic add and takes no lock, so the
+ * rings can be left on in the field; old records are overwritten.
+ * Without the option SYSTEM_TRACE() expands to nothing and no code or
+ * storage is left.
+ *
+ * Timestamps are the CPU cycle counter of the core that wrote the
+ * record. Each core also writes a SYNC record carrying esp_timer time
+ * about every CONFIG_SYSTEM_SERVICE_TRACE_SYNC_MS, which lets the
+ * decoder map cycles to time across frequency changes, counter wraps
+ * and cores.
+ *
+ * Dump format, little endian: a system_trace_header_t, `record_count`
+ * system_trace_record_t oldest first per core, then `name_count`
+ * system_trace_name_t for event types, services and tasks.
+ * tools/trace2json.py turns a dump into Chrome/Perfetto trace JSON.
+ */
+
+#ifndef SYSTEM_SERVICE_SYSTEM_TRACE_H
+#define SYSTEM_SERVICE_SYSTEM_TRACE_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYSTEM_TRACE_MAGIC      0x3152544B  // "KTR1"
+#define SYSTEM_TRACE_VERSION    1
+
+/**
+ * @brief Record types and what their arguments hold
+ */
+typedef enum {
+    SYSTEM_TRACE_NONE = 0,              /**< Slot being written, skip */
+    SYSTEM_TRACE_SYNC,                  /**< arg1: esp_timer time (us, low 32 bits) */
+    SYSTEM_TRACE_EVENT_POST,            /**< arg0: event type, arg1: sender | priority << 16 */
+    SYSTEM_TRACE_EVENT_DEQUEUE,         /**< arg0: event type, arg1: sender */
+    SYSTEM_TRACE_HANDLER_BEGIN,         /**< arg0: event type, arg1: subscriber */
+    SYSTEM_TRACE_HANDLER_END,           /**< arg0: event type, arg1: subscriber */
+    SYSTEM_TRACE_POOL_FALLBACK,         /**< arg1: requested bytes */
+    SYSTEM_TRACE_LOCK_WAIT_BEGIN,       /**< system_lock() found the lock taken */
+    SYSTEM_TRACE_LOCK_WAIT_END,         /**< arg1: 1 if acquired, 0 on timeout */
+    SYSTEM_TRACE_WATCHDOG,              /**< arg0: service, arg1: system_trace_watchdog_action_t */
+    SYSTEM_TRACE_TYPE_COUNT
+} system_trace_type_t;
+
+typedef enum {
+    SYSTEM_TRACE_WATCHDOG_TIMEOUT = 0,  /**< Heartbeat missed */
+    SYSTEM_TRACE_WATCHDOG_RECOVERED,    /**< Heartbeats resumed */
+    SYSTEM_TRACE_WATCHDOG_RESTART,      /**< Restart initiated */
+    SYSTEM_TRACE_WATCHDOG_RESTART_FAILED,
+    SYSTEM_TRACE_WATCHDOG_SAFE_MODE,    /**< Critical service timed out */
+} system_trace_watchdog_action_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t cycles;                    // Cycle counter of `core`
+    uint8_t type;                       // system_trace_type_t
+    uint8_t core;
+    uint16_t arg0;
+    uint32_t arg1;
+    uint32_t task;                      // TaskHandle_t of the writer
+} system_trace_record_t;
+
+typedef enum {
+    SYSTEM_TRACE_NAME_EVENT_TYPE = 1,
+    SYSTEM_TRACE_NAME_SERVICE,
+    SYSTEM_TRACE_NAME_TASK,
+    SYSTEM_TRACE_NAME_METRIC,           /**< Flight recorder only: metric ID */
+} system_trace_name_kind_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t kind;                       // system_trace_name_kind_t
+    uint8_t reserved[3];
+    uint32_t id;                        // Event type, service ID or TaskHandle_t
+    char name[24];                      // Truncated, NUL padded
+} system_trace_name_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t cores;
+    uint8_t record_size;                // sizeof(system_trace_record_t)
+    uint32_t record_count;
+    uint32_t name_count;
+    uint32_t cpu_freq_hz;               // Nominal, SYNC records give the real rate
+    uint32_t dropped;                   // Records overwritten before this dump
+} system_trace_header_t;
+
+/**
+ * @brief Sink for a dump; return anything but ESP_OK to abort it
+ */
+typedef esp_err_t (*system_trace_write_fn_t)(const void *data, size_t len, void *user_data);
+
+#if CONFIG_SYSTEM_SERVICE_TRACE
+
+/**
+ * @brief Allocate the rings and start recording
+ *
+ * Called by system_service_init().
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the rings don't fit
+ */
+esp_err_t system_trace_init(void);
+
+/**
+ * @brief Append a record to the calling core's ring
+ *
+ * Safe from any task. Not for ISRs: the record's task would be wrong.
+ */
+void system_trace_record(system_trace_type_t type, uint16_t arg0, uint32_t arg1);
+
+/**
+ * @brief Pause or resume recording
+ */
+void system_trace_enable(bool enable);
+
+/**
+ * @brief Write the rings out
+ *
+ * Recording pauses for the dump and resumes afterwards, so a dump is a
+ * consistent snapshot. The rings are left as they were.
+ *
+ * @param write Sink, called with header, records and names in order
+ * @param user_data Passed to write
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before init, or the
+ *         sink's error
+ */
+esp_err_t system_trace_dump(system_trace_write_fn_t write, void *user_data);
+
+/**
+ * @brief Read a core's records incrementally, oldest first
+ *
+ * For a consumer that keeps up with the rings, such as the flight
+ * recorder. `cursor` starts at 0 and is advanced past what was read;
+ * records overwritten before they were read are counted in `out_lost`.
+ * The rings are not paused.
+ *
+ * @return Number of records copied
+ */
+size_t system_trace_read(uint8_t core, uint32_t *cursor,
+                         system_trace_record_t *records, size_t max_records,
+                         uint32_t *out_lost);
+
+/**
+ * @brief Advance a read cursor so at most `keep` records are left unread
+ *
+ * @return Number of records skipped
+ */
+uint32_t system_trace_skip(uint8_t core, uint32_t *cursor, uint32_t keep);
+
+/**
+ * @brief Names of the event types, services and tasks, as in a dump
+ *
+ * @return Number of entries filled
+ */
+size_t system_trace_get_names(system_trace_name_t *names, size_t max_names);
+
+/**
+ * @brief Dump to the console as base64 lines
+ *
+ * Lines go between "KTRACE-BEGIN" and "KTRACE-END" markers, so the dump
+ * survives a serial monitor log with other output around it.
+ */
+esp_err_t system_trace_dump_console(void);
+
+#define SYSTEM_TRACE(type, arg0, arg1) \
+    system_trace_record((type), (uint16_t)(arg0), (uint32_t)(arg1))
+
+#else
+
+#define SYSTEM_TRACE(type, arg0, arg1)  do { } while (0)
+
+#endif // CONFIG_SYSTEM_SERVICE_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_SERVICE_SYSTEM_TRACE_H
@@ -36,12 +36,21 @@ extern "C" {
 /** Maximum number of subscribers (from Kconfig) */
 #define SYSTEM_SERVICE_MAX_SUBSCRIBERS  CONFIG_SYSTEM_SERVICE_MAX_SUBSCRIBERS
 
+/** Maximum number of wildcard subscriptions (from Kconfig) */
+#define SYSTEM_SERVICE_MAX_WILDCARDS    CONFIG_SYSTEM_SERVICE_MAX_WILDCARDS
+
 /** Maximum event data size (from Kconfig) */
 #define SYSTEM_MAX_DATA_SIZE            CONFIG_SYSTEM_SERVICE_MAX_DATA_SIZE
 
 /** Event queue size (from Kconfig) */
 #define SYSTEM_EVENT_QUEUE_SIZE         CONFIG_SYSTEM_SERVICE_EVENT_QUEUE_SIZE
 
+/** Maximum events per batch post and per dispatcher wakeup (from Kconfig) */
+#define SYSTEM_EVENT_BATCH_MAX          CONFIG_SYSTEM_SERVICE_EVENT_BATCH_SIZE
+
+/** Latest-value topic slots (from Kconfig) */
+#define SYSTEM_SERVICE_MAX_LATEST_SLOTS CONFIG_SYSTEM_SERVICE_MAX_LATEST_SLOTS
+
 /** Maximum service dependencies */
 #define SYSTEM_SERVICE_MAX_DEPENDENCIES 8
 
@@ -109,6 +118,22 @@ typedef enum {
     SYSTEM_EVENT_PRIORITY_CRITICAL,     /**< Critical priority, processed immediately */
 } system_event_priority_t;
 
+/* ============================================================================
+ * Event Topic Mode
+ * ============================================================================ */
+
+/**
+ * @brief How posts of an event type are queued
+ * 
+ * - QUEUED: Every post is delivered (history, e.g. button presses)
+ * - LATEST: A post replaces the still-pending one from the same sender,
+ *           so handlers only see the newest value (state, e.g. battery level)
+ */
+typedef enum {
+    SYSTEM_EVENT_TOPIC_QUEUED = 0,      /**< Deliver every post in order */
+    SYSTEM_EVENT_TOPIC_LATEST,          /**< Coalesce pending posts per sender */
+} system_event_topic_mode_t;
+
 /* ============================================================================
  * Event Structure
  * ============================================================================ */
@@ -117,21 +142,36 @@ typedef enum {
  * @brief System event structure
  * 
  * Events are the primary communication mechanism between services and apps.
- * Data is always copied when posting events to ensure thread safety.
+ * Data is copied when posting with system_event_post(); loaned buffers
+ * posted with system_event_post_loaned() are delivered without a copy.
  * 
  * @note The data pointer is managed by the event bus and will be freed
- *       after all handlers have processed the event.
+ *       after all handlers have processed the event, unless a handler
+ *       retained it with system_event_data_retain().
  */
 typedef struct {
     system_event_type_t event_type;     /**< Event type identifier */
     system_event_priority_t priority;   /**< Event priority level */
-    void *data;                         /**< Event data payload (copied) */
+    void *data;                         /**< Event data payload (reference counted) */
     size_t data_size;                   /**< Size of data payload in bytes */
     uint32_t timestamp;                 /**< Event creation timestamp (ms) */
+    uint32_t post_time_us;              /**< Post time in µs (wraps, for latency deltas) */
     system_service_id_t sender_id;      /**< Service that posted the event */
     uint32_t sequence_number;           /**< Event sequence number for ordering */
 } system_event_t;
 
+/**
+ * @brief One entry of a batch post
+ * 
+ * @see system_event_post_batch()
+ */
+typedef struct {
+    system_event_type_t event_type;     /**< Event type identifier */
+    system_event_priority_t priority;   /**< Event priority level */
+    const void *data;                   /**< Payload to copy (can be NULL) */
+    size_t data_size;                   /**< Size of data payload in bytes */
+} system_event_batch_entry_t;
+
 /**
  * @brief Event handler callback function
  * 
@@ -144,6 +184,43 @@ typedef struct {
  */
 typedef void (*system_event_handler_t)(const system_event_t *event, void *user_data);
 
+/**
+ * @brief Subscription filter predicate
+ * 
+ * Runs on the event task before the handler is queued, so it must be
+ * short and must not block or post.
+ * 
+ * @return true to deliver the event to the handler
+ */
+typedef bool (*system_event_predicate_t)(const system_event_t *event, void *user_data);
+
+/** Bit of a sender in system_event_filter_t.sender_mask */
+#define SYSTEM_EVENT_SENDER_BIT(service_id)  (1ULL << (service_id))
+
+/**
+ * @brief Subscription filter, see system_event_subscribe_filtered()
+ * 
+ * Every part that is set must accept the event. A zeroed filter accepts
+ * everything.
+ */
+typedef struct {
+    uint64_t sender_mask;               /**< SYSTEM_EVENT_SENDER_BIT()s accepted, 0 for any sender */
+    system_event_predicate_t predicate; /**< Called with the subscription's user data, or NULL */
+    uint16_t match_offset;              /**< Payload byte offset of the matched field */
+    uint8_t match_size;                 /**< 1, 2 or 4 bytes; 0 for no field match */
+    uint32_t match_value;               /**< Field value to accept, native byte order */
+} system_event_filter_t;
+
+/**
+ * @brief Where a subscription's handler runs, see system_event_set_affinity()
+ */
+typedef enum {
+    SYSTEM_EVENT_AFFINITY_ANY = 0,      /**< The subscriber's worker, on either core */
+    SYSTEM_EVENT_AFFINITY_CORE0,        /**< A worker pinned to core 0, next to WiFi and BT */
+    SYSTEM_EVENT_AFFINITY_CORE1,        /**< A worker pinned to core 1 */
+    SYSTEM_EVENT_AFFINITY_UI,           /**< The UI task, see system_event_ui_attach() */
+} system_event_affinity_t;
+
 /* ============================================================================
  * Service Information Structure
  * ============================================================================ */
@@ -205,10 +282,11 @@ typedef struct {
  * exhausting system resources.
  */
 typedef struct {
-    uint32_t max_events_per_sec;    /**< Maximum events posted per second */
+    uint32_t max_events_per_sec;    /**< Sustained event rate (token refill per second) */
     uint32_t max_subscriptions;     /**< Maximum event subscriptions */
     uint32_t max_event_data_size;   /**< Maximum event data size in bytes */
     uint32_t max_memory_bytes;      /**< Maximum memory allocation in bytes */
+    uint32_t event_burst;           /**< Events allowed back to back, 0 = max_events_per_sec */
 } service_quota_t;
 
 /**
@@ -217,7 +295,7 @@ typedef struct {
  * Tracks current resource usage against quotas.
  */
 typedef struct {
-    uint32_t events_this_sec;       /**< Events posted in current second */
+    uint32_t events_this_sec;       /**< Event tokens in use (burst minus available) */
     uint32_t total_events_posted;   /**< Total events posted */
     uint32_t active_subscriptions;  /**< Current active subscriptions */
     uint32_t current_memory_bytes;  /**< Current memory usage */
@@ -294,6 +372,8 @@ typedef struct {
  * @brief Versioned event data header
  * 
  * Prefix event data with version information for backward compatibility.
+ * Events declared in an event_schema.h schema don't need it: their version
+ * and size are in the schema.
  * 
  * Usage:
  * @code
@@ -316,6 +396,66 @@ typedef struct {
 #define VERSIONED_EVENT_INIT(ver, type) \
     { .version = (ver), .size = sizeof(type) }
 
+/* ============================================================================
+ * Event Latency
+ * ============================================================================ */
+
+/**
+ * @brief Stages of event delivery measured by latency tracking
+ */
+typedef enum {
+    SYSTEM_EVENT_LATENCY_QUEUE = 0,     /**< Post until the event task dequeues it */
+    SYSTEM_EVENT_LATENCY_DISPATCH,      /**< Dequeue until a handler starts */
+    SYSTEM_EVENT_LATENCY_HANDLER,       /**< Handler execution time */
+    SYSTEM_EVENT_LATENCY_END_TO_END,    /**< Post until a handler returns */
+    SYSTEM_EVENT_LATENCY_STAGE_COUNT    /**< Number of stages */
+} system_event_latency_stage_t;
+
+/**
+ * @brief Latency summary for one event type and stage
+ * 
+ * Percentiles come from log2 histograms, so they are accurate to within a
+ * factor of two; max_us and avg_us are exact.
+ */
+typedef struct {
+    uint32_t count;             /**< Samples recorded */
+    uint32_t avg_us;            /**< Mean latency (μs) */
+    uint32_t p50_us;            /**< Median latency (μs) */
+    uint32_t p99_us;            /**< 99th percentile latency (μs) */
+    uint32_t max_us;            /**< Maximum latency (μs) */
+} system_event_latency_t;
+
+/**
+ * @brief Execution profile of one subscriber's handler for one event type
+ * 
+ * Percentiles come from half-octave histograms (within 25%); the other
+ * fields are exact.
+ */
+typedef struct {
+    system_service_id_t service_id;     /**< Subscriber */
+    system_event_type_t event_type;     /**< Event type handled */
+    uint32_t count;                     /**< Handler runs recorded */
+    uint64_t total_us;                  /**< Total execution time (μs) */
+    uint32_t avg_us;                    /**< Mean execution time (μs) */
+    uint32_t p50_us;                    /**< Median execution time (μs) */
+    uint32_t p99_us;                    /**< 99th percentile execution time (μs) */
+    uint32_t max_us;                    /**< Maximum execution time (μs) */
+} system_handler_profile_t;
+
+/**
+ * @brief Delivery deadline accounting, see system_event_set_deadline()
+ * 
+ * A handler run is measured from the post to the handler's return.
+ */
+typedef struct {
+    uint32_t critical_runs;             /**< Handlers run on the critical lane */
+    uint32_t critical_max_us;           /**< Slowest of those, post to return (μs) */
+    uint32_t checked;                   /**< Handler runs that had a deadline */
+    uint32_t missed;                    /**< Of those, returned after it */
+    uint32_t worst_overrun_us;          /**< Largest time past a deadline (μs) */
+    system_event_type_t worst_type;     /**< Event type of that overrun */
+} system_event_deadline_stats_t;
+
 /* ============================================================================
  * Memory Pool Statistics
  * ============================================================================ */
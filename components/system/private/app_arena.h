@@ -0,0 +1,97 @@
+/**
+ * @file app_arena.h
+ * @brief Per-app bump allocator released in one step
+ * 
+ * Each app gets an arena of PSRAM chunks it allocates from bump-style.
+ * Nothing is freed individually; the whole arena goes back to the heap
+ * when the app stops. Every chunk is charged to the app's memory quota.
+ */
+
+#ifndef APP_ARENA_H
+#define APP_ARENA_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Arena Structure
+ * ============================================================================ */
+
+typedef struct app_arena_chunk app_arena_chunk_t;
+
+typedef struct {
+    system_service_id_t service_id; /**< Owner, charged for every chunk */
+    app_arena_chunk_t *chunks;      /**< Chunk list, newest (active) first */
+    size_t reserved_bytes;          /**< Chunk bytes charged to the quota */
+    size_t used_bytes;              /**< Bytes handed out */
+    SemaphoreHandle_t mutex;        /**< Serializes the app's tasks */
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+    StaticSemaphore_t mutex_storage;
+#endif
+} app_arena_t;
+
+/* ============================================================================
+ * Arena Operations
+ * ============================================================================ */
+
+/**
+ * @brief Initialize an empty arena
+ * 
+ * No memory is reserved until the first allocation.
+ * 
+ * @param arena Arena to initialize
+ * @param service_id Owning service, used for quota accounting
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the mutex cannot be created
+ */
+esp_err_t app_arena_init(app_arena_t *arena, system_service_id_t service_id);
+
+/**
+ * @brief Allocate from an arena
+ * 
+ * Returns 8-byte aligned memory that stays valid until
+ * app_arena_release(). A request that does not fit the active chunk
+ * opens a new one of CONFIG_SYSTEM_SERVICE_APP_ARENA_CHUNK_SIZE bytes,
+ * or of the request's size if larger.
+ * 
+ * @param arena Arena
+ * @param size Bytes requested
+ * @return Pointer, or NULL if out of memory or over the memory quota
+ */
+void* app_arena_alloc(app_arena_t *arena, size_t size);
+
+/**
+ * @brief Free every chunk of an arena at once
+ * 
+ * All pointers handed out become invalid. The arena stays usable.
+ * 
+ * @param arena Arena
+ */
+void app_arena_release(app_arena_t *arena);
+
+/**
+ * @brief Release an arena and delete its mutex
+ * 
+ * @param arena Arena
+ */
+void app_arena_deinit(app_arena_t *arena);
+
+/**
+ * @brief Bytes handed out since the last release
+ * 
+ * @param arena Arena
+ * @return Bytes in use
+ */
+size_t app_arena_used(const app_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_ARENA_H
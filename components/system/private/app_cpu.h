@@ -0,0 +1,55 @@
+/**
+ * @file app_cpu.h
+ * @brief Per-app CPU accounting and budgets
+ * 
+ * Every CONFIG_SYSTEM_SERVICE_APP_CPU_PERIOD_MS a sampler charges each app
+ * the FreeRTOS run time of the worker its entry runs on, plus the time
+ * the handler monitor measured for its event handlers. The result for the
+ * last period lands in app_info_t.
+ * 
+ * An app over its budget for a period is throttled: its worker drops to
+ * CONFIG_SYSTEM_SERVICE_APP_CPU_THROTTLE_PRIORITY, below the LVGL and
+ * event tasks, and its event quota to the throttle rate. Both are put
+ * back after a period within budget.
+ */
+
+#ifndef APP_CPU_H
+#define APP_CPU_H
+
+#include "app_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the sampler
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_SYSTEM_SERVICE_APP_CPU_ACCOUNTING
+ */
+esp_err_t app_cpu_init(void);
+
+/**
+ * @brief Reset an app's accounting before its entry starts
+ * 
+ * Called with the registry lock held.
+ * 
+ * @param entry App about to start
+ */
+void app_cpu_start(app_registry_entry_t *entry);
+
+/**
+ * @brief Lift an app's throttle once it stopped
+ * 
+ * Called with the registry lock held.
+ * 
+ * @param entry Stopped app
+ */
+void app_cpu_stop(app_registry_entry_t *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_CPU_H
@@ -0,0 +1,51 @@
+/**
+ * @file app_executor.h
+ * @brief Pool of pre-created worker tasks that run app entries
+ * 
+ * Workers are created once, pinned across both cores, from stacks and
+ * TCBs reserved at link time, one pool per app_stack_class_t. Starting an
+ * app hands its entry to an idle worker with a task notification; when
+ * the entry returns the worker goes back to the pool. Nothing is created
+ * or allocated per launch.
+ */
+
+#ifndef APP_EXECUTOR_H
+#define APP_EXECUTOR_H
+
+#include "app_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the workers
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if a worker could not be created
+ */
+esp_err_t app_executor_init(void);
+
+/**
+ * @brief Run an app's entry on an idle worker
+ * 
+ * Sets entry->task_handle to the worker. Call with the registry locked.
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no worker of the app's
+ *         class or larger is idle
+ */
+esp_err_t app_executor_start(app_registry_entry_t *entry);
+
+/**
+ * @brief Wait for an app's entry to return, then free its worker
+ * 
+ * Waits up to CONFIG_SYSTEM_SERVICE_APP_STOP_TIMEOUT_MS after the app's
+ * exit function ran; an entry still running then is killed and its
+ * worker re-created on the same storage. Call with the registry locked.
+ */
+void app_executor_stop(app_registry_entry_t *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_EXECUTOR_H
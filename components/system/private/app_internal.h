@@ -2,6 +2,7 @@
 #define APP_INTERNAL_H
 
 #include "system_service/app_manager.h"
+#include "app_arena.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
@@ -12,11 +13,26 @@ extern "C" {
 
 #define APP_REGISTRY_MAX_ENTRIES    APP_MAX_APPS
 
+// CPU sampler baselines, see app_cpu.h
+typedef struct {
+    TaskHandle_t task;              // Worker the counter baseline is from
+    uint32_t task_counter;          // Its run-time counter then
+    uint64_t handler_us;            // Handler monitor total then
+    int64_t sampled_us;             // When the baselines were taken
+    bool throttled;
+    bool quota_saved;
+    service_quota_t saved_quota;    // Quota to put back when unthrottled
+} app_cpu_account_t;
+
 typedef struct {
     app_info_t info;
     bool registered;
     TaskHandle_t task_handle;
     app_context_t context;
+    app_arena_t arena;
+    void *hibernate_state;      // Saved by the hibernate callback, PSRAM
+    size_t hibernate_state_len;
+    app_cpu_account_t cpu;
 } app_registry_entry_t;
 
 typedef struct {
@@ -31,6 +47,9 @@ esp_err_t app_registry_lock(void);
 esp_err_t app_registry_unlock(void);
 app_registry_entry_t* app_find_by_name(const char *name);
 
+// Reset a flash app's .data and .bss before it starts again
+esp_err_t flash_app_restart(app_info_t *info);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,7 +3,9 @@
  * @brief Application lifecycle management utilities
  * 
  * Provides utilities for safe app lifecycle management including
- * automatic event unsubscription.
+ * automatic event unsubscription. Subscriptions are read from the event
+ * bus subscriber index, which chains them per service, so nothing is
+ * tracked here.
  */
 
 #ifndef APP_LIFECYCLE_H
@@ -17,37 +19,14 @@ extern "C" {
 #endif
 
 /* ============================================================================
- * Subscription Tracking
+ * Subscriptions
  * ============================================================================ */
 
-/**
- * @brief Track app subscription
- * 
- * Records that an app has subscribed to an event type.
- * 
- * @param service_id App's service ID
- * @param event_type Event type subscribed to
- * @return ESP_OK on success, error code otherwise
- */
-esp_err_t app_lifecycle_track_subscription(system_service_id_t service_id,
-                                            system_event_type_t event_type);
-
-/**
- * @brief Untrack app subscription
- * 
- * Removes subscription tracking.
- * 
- * @param service_id App's service ID
- * @param event_type Event type unsubscribed from
- * @return ESP_OK on success, error code otherwise
- */
-esp_err_t app_lifecycle_untrack_subscription(system_service_id_t service_id,
-                                              system_event_type_t event_type);
-
 /**
  * @brief Unsubscribe all app events
  * 
- * Automatically unsubscribes all events when app stops.
+ * Automatically unsubscribes all events when app stops, in one pass
+ * under the system lock whatever the number of subscriptions.
  * 
  * @param service_id App's service ID
  * @return ESP_OK on success, error code otherwise
@@ -0,0 +1,69 @@
+/**
+ * @file boot_orchestrator.h
+ * @brief Parallel, dependency-ordered service bring-up
+ * 
+ * Takes a table of services with their init/start functions and runs them
+ * on one worker per core. Dependencies are registered with the dependency
+ * graph, and every service starts as soon as the graph reports its
+ * dependencies ready, so services that wait on hardware overlap instead of queueing
+ * behind each other.
+ */
+
+#ifndef BOOT_ORCHESTRATOR_H
+#define BOOT_ORCHESTRATOR_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Boot Table
+ * ============================================================================ */
+
+/** Most services one boot_orchestrator_run() call can bring up */
+#define BOOT_MAX_SERVICES           SYSTEM_SERVICE_MAX_SERVICES
+
+/**
+ * @brief One service to bring up
+ */
+typedef struct {
+    const char *name;                                       /**< Name in the dependency graph */
+    esp_err_t (*init)(void);                                /**< Init function */
+    esp_err_t (*start)(void);                               /**< Start function (can be NULL) */
+    const char *depends_on[SYSTEM_SERVICE_MAX_DEPENDENCIES]; /**< Services that must be up first */
+    uint8_t dependency_count;                               /**< Entries used in depends_on */
+} boot_service_t;
+
+/* ============================================================================
+ * Bring-up
+ * ============================================================================ */
+
+/**
+ * @brief Initialize and start a table of services concurrently
+ * 
+ * The calling task is one of the workers; helpers on the other cores run
+ * at the caller's priority and exit when the table is done. A service is
+ * marked initialized in the dependency graph once its init and start both
+ * succeeded. Dependents of a failed service are skipped.
+ * 
+ * @param services Boot table
+ * @param count Entries in services, at most BOOT_MAX_SERVICES
+ * @param timeout_ms How long a service may wait for dependencies that are
+ *                   not in the table before it is skipped
+ * @return ESP_OK if every service came up,
+ *         ESP_ERR_SERVICE_DEPENDENCY_FAILED if some failed or were skipped,
+ *         ESP_ERR_SERVICE_CIRCULAR_DEPENDENCY if the table has a cycle,
+ *         error code otherwise
+ */
+esp_err_t boot_orchestrator_run(const boot_service_t *services,
+                                size_t count,
+                                uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_ORCHESTRATOR_H
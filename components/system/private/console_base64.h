@@ -0,0 +1,52 @@
+/**
+ * @file console_base64.h
+ * @brief Binary dumps over the console as base64 lines
+ * 
+ * A dump goes out between "<marker>-BEGIN" and "<marker>-END" lines, 48
+ * bytes (64 characters) per line, so it survives a serial monitor log
+ * with other output around it. Used by the trace and flight recorder
+ * dumps; tools/trace2json.py reads both.
+ */
+
+#ifndef CONSOLE_BASE64_H
+#define CONSOLE_BASE64_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONSOLE_BASE64_CHUNK    48
+
+typedef struct {
+    const char *marker;
+    uint8_t pending[CONSOLE_BASE64_CHUNK];
+    size_t length;
+} console_base64_t;
+
+/**
+ * @brief Print the BEGIN line
+ */
+void console_base64_begin(console_base64_t *sink, const char *marker);
+
+/**
+ * @brief Dump sink: buffer `data` and print every complete line
+ * 
+ * @param user_data The console_base64_t
+ * @return ESP_OK
+ */
+esp_err_t console_base64_write(const void *data, size_t len, void *user_data);
+
+/**
+ * @brief Print the last partial line and the END line
+ */
+void console_base64_end(console_base64_t *sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONSOLE_BASE64_H
@@ -0,0 +1,103 @@
+/**
+ * @file event_credit.h
+ * @brief Per-producer credits for the event queues
+ * 
+ * Every queued event holds one credit of its sender until the event task
+ * has dispatched it. A producer that has CONFIG_SYSTEM_SERVICE_PRODUCER_CREDITS
+ * events in flight is refused further posts, so one chatty service can no
+ * longer fill the shared queues for everybody else. A refused producer is
+ * marked throttled and its drain callback runs once its backlog falls to
+ * the low watermark.
+ */
+
+#ifndef EVENT_CREDIT_H
+#define EVENT_CREDIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include "system_service/event_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Credits per producer, 0 disables credit accounting */
+#define EVENT_CREDIT_LIMIT          CONFIG_SYSTEM_SERVICE_PRODUCER_CREDITS
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+/**
+ * @brief Clear all credit counters and drain callbacks
+ */
+void event_credit_init(void);
+
+/* ============================================================================
+ * Credit Operations
+ * ============================================================================ */
+
+/**
+ * @brief Take credits before queueing events (lock-free)
+ * 
+ * All or nothing. On failure the producer is marked throttled.
+ * 
+ * @param sender_id Producing service
+ * @param count Number of events about to be queued
+ * @return true if the credits were taken
+ */
+bool event_credit_acquire(system_service_id_t sender_id, uint32_t count);
+
+/**
+ * @brief Return credits of events that left the queues
+ * 
+ * Runs the producer's drain callback, in the caller's context, if the
+ * producer was throttled and its backlog is now at or below its low
+ * watermark.
+ * 
+ * @param sender_id Producing service
+ * @param count Number of events dispatched, dropped or never queued
+ */
+void event_credit_release(system_service_id_t sender_id, uint32_t count);
+
+/**
+ * @brief Mark a producer throttled without taking credits
+ * 
+ * Used when the queue itself was full, so the producer still hears from
+ * its drain callback once things calm down.
+ * 
+ * @param sender_id Producing service
+ */
+void event_credit_throttle(system_service_id_t sender_id);
+
+/**
+ * @brief Credits a producer has left
+ * 
+ * @param sender_id Producing service
+ * @return Remaining credits, UINT32_MAX if accounting is disabled
+ */
+uint32_t event_credit_available(system_service_id_t sender_id);
+
+/**
+ * @brief Install or clear a producer's drain callback
+ * 
+ * @param sender_id Producing service
+ * @param low_watermark Backlog at which the callback fires
+ * @param callback Callback, NULL to clear
+ * @param user_data Passed to callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the watermark is not
+ *         below the credit limit, ESP_ERR_NOT_SUPPORTED if credits are
+ *         disabled
+ */
+esp_err_t event_credit_set_drain_callback(system_service_id_t sender_id,
+                                          uint32_t low_watermark,
+                                          system_event_drain_cb_t callback,
+                                          void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_CREDIT_H
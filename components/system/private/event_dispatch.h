@@ -0,0 +1,139 @@
+/**
+ * @file event_dispatch.h
+ * @brief Multi-worker event handler executor
+ * 
+ * Runs subscriber handlers on a pool of worker tasks pinned across both
+ * cores. Every subscriber is bound to one worker, so a subscriber sees its
+ * events in order while different subscribers run in parallel.
+ * 
+ * Subscriptions that keep overrunning the handler budget are moved to a
+ * lower-priority deferred worker until they behave again.
+ * 
+ * A subscriber can be held, as a hibernated app is: its jobs are parked
+ * instead of run, and replayed in order when it is released.
+ * 
+ * Every handler run is checked against its event's deadline, see
+ * system_event_set_deadline().
+ * 
+ * A subscription's affinity can move it to a worker of one core, or to
+ * the UI task, see system_event_set_affinity().
+ */
+
+#ifndef EVENT_DISPATCH_H
+#define EVENT_DISPATCH_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+/**
+ * @brief Create worker queues and start worker tasks
+ * 
+ * Workers use the event task stack size and priority from Kconfig.
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if a task or queue could not be created
+ */
+esp_err_t event_dispatch_start(void);
+
+/**
+ * @brief Stop all workers and release queued payload references
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not started
+ */
+esp_err_t event_dispatch_stop(void);
+
+/* ============================================================================
+ * Job Submission
+ * ============================================================================ */
+
+/**
+ * @brief Queue one handler invocation on the subscriber's worker
+ * 
+ * Takes its own reference on event->data, so the caller keeps and must
+ * still release its reference.
+ * 
+ * @param event Event to deliver (copied)
+ * @param service_id Subscribing service, selects the worker
+ * @param handler Handler to call
+ * @param user_data User data registered with the subscription
+ * @param affinity Subscription affinity, selects the worker's core or the UI task
+ * @param dequeue_us When the event left the priority queue (latency tracking)
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the worker queue stayed full
+ *         (or was full, for a demoted subscription)
+ */
+esp_err_t event_dispatch_submit(const system_event_t *event,
+                                system_service_id_t service_id,
+                                system_event_handler_t handler,
+                                void *user_data,
+                                system_event_affinity_t affinity,
+                                uint32_t dequeue_us);
+
+/**
+ * @brief Run one handler invocation on the calling task
+ * 
+ * Used by the critical lane: the handler runs before this returns, ahead
+ * of anything queued on the workers, and may run concurrently with the
+ * subscriber's other handlers on its worker. A held subscriber's job is
+ * parked as with event_dispatch_submit(). The caller's reference on
+ * event->data must stay valid until this returns.
+ * 
+ * @return ESP_OK on success (run or parked), ESP_ERR_INVALID_STATE if not started
+ */
+esp_err_t event_dispatch_run(const system_event_t *event,
+                             system_service_id_t service_id,
+                             system_event_handler_t handler,
+                             void *user_data,
+                             uint32_t dequeue_us);
+
+/**
+ * @brief Number of running worker tasks
+ */
+uint32_t event_dispatch_worker_count(void);
+
+/* ============================================================================
+ * Held Subscribers
+ * ============================================================================ */
+
+/**
+ * @brief Park a subscriber's jobs instead of running them
+ * 
+ * Jobs already queued still run. Later jobs go to the shared backlog of
+ * CONFIG_SYSTEM_SERVICE_HIBERNATE_BACKLOG entries: a SYSTEM_EVENT_TOPIC_LATEST
+ * event replaces the one parked from the same sender, a queued one is
+ * appended, and when the backlog is full the subscriber's oldest parked
+ * job is dropped.
+ * 
+ * @param service_id Subscribing service
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid ID
+ */
+esp_err_t event_dispatch_hold(system_service_id_t service_id);
+
+/**
+ * @brief Stop parking a subscriber's jobs
+ * 
+ * With deliver set, parked jobs are queued on the subscriber's worker in
+ * the order they arrived, ahead of any job submitted meanwhile. Otherwise
+ * they are dropped.
+ * 
+ * @param service_id Subscribing service
+ * @param deliver Replay parked jobs rather than drop them
+ * @param out_replayed Jobs queued, may be NULL
+ * @param out_dropped Jobs dropped or coalesced while held, may be NULL
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the service was not held
+ */
+esp_err_t event_dispatch_release(system_service_id_t service_id, bool deliver,
+                                 uint32_t *out_replayed, uint32_t *out_dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_DISPATCH_H
@@ -0,0 +1,65 @@
+/**
+ * @file event_latency.h
+ * @brief Per-event-type latency histograms
+ * 
+ * Records how long events spend in each stage of delivery, in microseconds,
+ * into log2-bucketed histograms so p50/p99 can be read without keeping
+ * individual samples.
+ */
+
+#ifndef EVENT_LATENCY_H
+#define EVENT_LATENCY_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+/**
+ * @brief Allocate histogram storage (prefers PSRAM)
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if storage could not be allocated,
+ *         ESP_ERR_NOT_SUPPORTED if latency tracking is disabled in Kconfig
+ */
+esp_err_t event_latency_init(void);
+
+/**
+ * @brief Free histogram storage
+ */
+void event_latency_deinit(void);
+
+/* ============================================================================
+ * Recording
+ * ============================================================================ */
+
+/**
+ * @brief Current time in the units used by system_event_t.post_time_us
+ */
+uint32_t event_latency_now_us(void);
+
+/**
+ * @brief Record one sample for a stage
+ * 
+ * Safe to call from any task. No-op when tracking is disabled.
+ * 
+ * @param event_type Event type the sample belongs to
+ * @param stage Delivery stage
+ * @param from_us Stage start (event_latency_now_us() clock)
+ * @param to_us Stage end (event_latency_now_us() clock)
+ */
+void event_latency_record(system_event_type_t event_type,
+                          system_event_latency_stage_t stage,
+                          uint32_t from_us,
+                          uint32_t to_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_LATENCY_H
@@ -3,6 +3,8 @@
  * @brief Event handler execution monitoring
  * 
  * Monitors event handler execution time and logs warnings for slow handlers.
+ * With CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING it also keeps a histogram
+ * per (subscriber, event type) pair, read with system_event_get_top_handlers().
  */
 
 #ifndef HANDLER_MONITOR_H
@@ -16,6 +18,23 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+/**
+ * @brief Allocate profile storage (prefers PSRAM) and start the dump timer
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if storage could not be allocated,
+ *         ESP_ERR_NOT_SUPPORTED if profiling is disabled in Kconfig
+ */
+esp_err_t handler_monitor_init(void);
+
+/**
+ * @brief Stop the dump timer and free profile storage
+ */
+void handler_monitor_deinit(void);
+
 /* ============================================================================
  * Handler Monitoring
  * ============================================================================ */
@@ -36,6 +55,21 @@ esp_err_t handler_monitor_execute(system_event_handler_t handler,
                                    void *user_data,
                                    system_service_id_t service_id);
 
+/**
+ * @brief Account one handler run timed by the caller
+ * 
+ * Same statistics, slow-handler warning and timeout check as
+ * handler_monitor_execute(), for handlers that do not take an event.
+ * 
+ * @param service_id Service ID the handler ran for
+ * @param event_type Event or request type it handled
+ * @param elapsed_us Handler execution time in microseconds
+ * @return ESP_OK, or ESP_ERR_EVENT_HANDLER_TIMEOUT if it overran
+ */
+esp_err_t handler_monitor_record(system_service_id_t service_id,
+                                 system_event_type_t event_type,
+                                 uint32_t elapsed_us);
+
 /**
  * @brief Get handler execution statistics
  * 
@@ -50,6 +84,22 @@ esp_err_t handler_monitor_get_stats(system_service_id_t service_id,
                                      uint32_t *max_time_us,
                                      uint32_t *timeout_count);
 
+/**
+ * @brief Number of handler runs recorded for a service
+ * 
+ * @param service_id Service identifier
+ * @return Events the service has handled, 0 for an invalid ID
+ */
+uint32_t handler_monitor_get_executions(system_service_id_t service_id);
+
+/**
+ * @brief Total time a service's handlers have run
+ * 
+ * @param service_id Service identifier
+ * @return Microseconds since boot, 0 for an invalid ID or without monitoring
+ */
+uint64_t handler_monitor_get_total_time(system_service_id_t service_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,12 +3,18 @@
  * @brief Heap fragmentation monitoring
  * 
  * Monitors heap health and fragmentation levels.
+ * 
+ * With CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER a background sampler keeps a
+ * ring buffer of internal SRAM and PSRAM readings, fits trend slopes over
+ * it and posts COMMON_EVENT_NAME_HEAP_WARNING before the largest internal
+ * block gets too small for WiFi buffers.
  */
 
 #ifndef HEAP_MONITOR_H
 #define HEAP_MONITOR_H
 
 #include "esp_err.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -29,6 +35,30 @@ typedef struct {
     bool fragmentation_warning;     /**< Fragmentation above threshold */
 } heap_stats_t;
 
+/** One background reading of both heaps */
+typedef struct {
+    uint32_t timestamp_ms;          /**< Time since boot */
+    uint32_t internal_free;         /**< Free internal SRAM */
+    uint32_t internal_largest;      /**< Largest free internal block */
+    uint32_t internal_min_free;     /**< Internal low-water mark */
+    uint32_t psram_free;            /**< Free PSRAM */
+    uint32_t psram_largest;         /**< Largest free PSRAM block */
+    uint32_t psram_min_free;        /**< PSRAM low-water mark */
+} heap_sample_t;
+
+/** Least-squares trends over the sample history, in bytes per minute */
+typedef struct {
+    uint32_t sample_count;          /**< Samples the fit used */
+    int32_t internal_free_slope;    /**< Free internal SRAM trend */
+    int32_t internal_largest_slope; /**< Largest internal block trend */
+    int32_t psram_free_slope;       /**< Free PSRAM trend */
+    int32_t psram_largest_slope;    /**< Largest PSRAM block trend */
+    uint32_t seconds_to_threshold;  /**< Projected time until the largest
+                                         internal block crosses the threshold,
+                                         UINT32_MAX if not shrinking,
+                                         0 if already below */
+} heap_trend_t;
+
 /* ============================================================================
  * Monitoring Functions
  * ============================================================================ */
@@ -66,6 +96,48 @@ void heap_monitor_log_stats(const char *tag);
  */
 uint32_t heap_monitor_get_fragmentation(void);
 
+/* ============================================================================
+ * Background Sampler
+ * ============================================================================ */
+
+/**
+ * @brief Start the background heap sampler
+ * 
+ * Registers as the "heap_monitor" service so it can post events, then
+ * samples every CONFIG_SYSTEM_SERVICE_HEAP_SAMPLE_INTERVAL_MS from an
+ * esp_timer.
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the sampler is
+ *         disabled, error code otherwise
+ */
+esp_err_t heap_monitor_start(void);
+
+/**
+ * @brief Stop the background sampler and drop its history
+ */
+void heap_monitor_stop(void);
+
+/**
+ * @brief Copy the sample history, oldest first
+ * 
+ * @param samples Output array
+ * @param max_samples Capacity of samples
+ * @param out_count Output number of samples copied
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running,
+ *         error code otherwise
+ */
+esp_err_t heap_monitor_get_samples(heap_sample_t *samples, size_t max_samples,
+                                   size_t *out_count);
+
+/**
+ * @brief Get trend slopes fitted over the sample history
+ * 
+ * @param trend Output trend
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if fewer than two
+ *         samples exist, error code otherwise
+ */
+esp_err_t heap_monitor_get_trend(heap_trend_t *trend);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+/**
+ * @file isr_event_ring.h
+ * @brief Lock-free multi-producer ring for events posted from interrupts
+ * 
+ * Interrupt handlers on either core push events into a bounded ring whose
+ * slots own pre-reserved pool blocks. The event task is the single
+ * consumer and moves entries into the priority queues, so no mutex or
+ * heap allocation ever happens in ISR context.
+ */
+
+#ifndef ISR_EVENT_RING_H
+#define ISR_EVENT_RING_H
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "system_service/system_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Largest payload an ISR may post (reserved per ring slot) */
+#define ISR_EVENT_MAX_DATA_SIZE     CONFIG_SYSTEM_SERVICE_ISR_MAX_DATA_SIZE
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+/**
+ * @brief Create the ring and reserve a payload block for every slot
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if blocks could not be reserved
+ */
+esp_err_t isr_event_ring_init(void);
+
+/**
+ * @brief Release reserved blocks and any undrained payloads
+ */
+void isr_event_ring_deinit(void);
+
+/* ============================================================================
+ * Ring Operations
+ * ============================================================================ */
+
+/**
+ * @brief Push an event (ISR-safe, lock-free)
+ * 
+ * @param event Event header; its data pointer is ignored
+ * @param data Payload to copy into the slot's reserved block (can be NULL)
+ * @param data_size Payload size, at most ISR_EVENT_MAX_DATA_SIZE
+ * @return ESP_OK on success, ESP_ERR_EVENT_QUEUE_FULL if the ring is full,
+ *         ESP_ERR_EVENT_DATA_TOO_LARGE if data_size is too big
+ */
+esp_err_t isr_event_ring_push(const system_event_t *event,
+                              const void *data,
+                              size_t data_size);
+
+/**
+ * @brief Pop the oldest event (single consumer, task context only)
+ * 
+ * The slot's block is handed over as event->data and the slot is re-armed
+ * with a fresh block from the memory pool.
+ * 
+ * @param event Output event, caller owns event->data
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if empty,
+ *         ESP_ERR_NO_MEM if the entry was dropped because the slot could not be re-armed
+ */
+esp_err_t isr_event_ring_pop(system_event_t *event);
+
+/**
+ * @brief Number of ISR posts rejected since init
+ */
+uint32_t isr_event_ring_get_drops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ISR_EVENT_RING_H
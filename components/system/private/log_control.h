@@ -61,6 +61,25 @@ esp_err_t log_control_reset_all(void);
  */
 void log_control_log_status(const char *tag);
 
+/* ============================================================================
+ * Deferred Logging
+ * ============================================================================ */
+
+/**
+ * @brief Start the deferred logger task
+ * 
+ * Called by system_service_init(). Until then SYSTEM_LOGx() messages are
+ * formatted in place. Does nothing without CONFIG_SYSTEM_LOG_DEFERRED.
+ * 
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task can't be created
+ */
+esp_err_t log_control_deferred_init(void);
+
+/**
+ * @brief Write out queued messages and stop the logger task
+ */
+void log_control_deferred_deinit(void);
+
 #ifdef __cplusplus
 }
 #endif
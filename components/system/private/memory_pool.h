@@ -29,9 +29,17 @@ typedef enum {
     MEMORY_POOL_SIZE_128,       /**< 128-byte blocks */
     MEMORY_POOL_SIZE_256,       /**< 256-byte blocks */
     MEMORY_POOL_SIZE_512,       /**< 512-byte blocks */
+    MEMORY_POOL_SIZE_1K,        /**< 1 KB blocks (PSRAM) */
+    MEMORY_POOL_SIZE_2K,        /**< 2 KB blocks (PSRAM) */
+    MEMORY_POOL_SIZE_4K,        /**< 4 KB blocks (PSRAM) */
+    MEMORY_POOL_SIZE_8K,        /**< 8 KB blocks (PSRAM) */
+    MEMORY_POOL_SIZE_16K,       /**< 16 KB blocks (PSRAM) */
     MEMORY_POOL_SIZE_COUNT      /**< Number of pool sizes */
 } memory_pool_size_t;
 
+/** First class of the large-object tier, backed by PSRAM */
+#define MEMORY_POOL_FIRST_LARGE     MEMORY_POOL_SIZE_1K
+
 /* ============================================================================
  * Initialization & Cleanup
  * ============================================================================ */
@@ -68,18 +76,47 @@ esp_err_t memory_pool_deinit(void);
  * @return Pointer to allocated memory, or NULL on failure
  * 
  * @note Caller must call memory_pool_free() to return memory to pool
+ * @note The block starts with a reference count of 1
  */
 void* memory_pool_alloc(size_t size);
 
+/**
+ * @brief Allocate memory from pool and charge it to a service
+ * 
+ * Same as memory_pool_alloc(), but the block counts against the owner's
+ * memory quota until its last reference is freed. Pool blocks are charged
+ * their full size class.
+ * 
+ * @param owner Service charged, SYSTEM_SERVICE_ID_INVALID for no charge
+ * @param size Size in bytes to allocate
+ * @return Pointer to allocated memory, or NULL on failure or if the
+ *         owner's memory quota would be exceeded
+ */
+void* memory_pool_alloc_tagged(system_service_id_t owner, size_t size);
+
+/**
+ * @brief Take an additional reference on a block
+ * 
+ * Each retain must be balanced by one memory_pool_free(). Used to share
+ * event payloads without copying them.
+ * 
+ * @param ptr Pointer returned by memory_pool_alloc()
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if ptr is not a pool/heap block,
+ *         ESP_ERR_INVALID_STATE if the block was already released
+ */
+esp_err_t memory_pool_retain(void *ptr);
+
 /**
  * @brief Free memory back to pool
  * 
- * Returns memory to the appropriate pool, or frees to heap if not from pool.
+ * Drops one reference. When the last reference is dropped the memory is
+ * returned to the appropriate pool, or freed to heap if not from pool.
  * 
  * @param ptr Pointer to memory to free (can be NULL)
  * 
  * @note Safe to call with NULL pointer
- * @note Safe to call with heap-allocated memory
+ * @note ptr must come from memory_pool_alloc(); other pointers are
+ *       rejected and not freed
  */
 void memory_pool_free(void *ptr);
 
@@ -120,6 +157,18 @@ void memory_pool_reset_stats(void);
  */
 void memory_pool_log_stats(const char *tag);
 
+/**
+ * @brief Suggest block counts per pool from observed traffic
+ * 
+ * Based on each pool's high water mark and heap fallbacks since the last
+ * memory_pool_reset_stats(). Intended for tuning the
+ * CONFIG_SYSTEM_SERVICE_POOL_SIZE_* options.
+ * 
+ * @param counts Output block count per pool
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not initialized
+ */
+esp_err_t memory_pool_suggest_sizes(uint32_t counts[MEMORY_POOL_SIZE_COUNT]);
+
 /**
  * @brief Check pool health
  * 
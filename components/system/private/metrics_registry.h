@@ -0,0 +1,53 @@
+/**
+ * @file metrics_registry.h
+ * @brief Internal hooks of the metrics registry
+ * 
+ * The public half is in system_service/system_metrics.h. These are the
+ * calls the service manager, event bus and dispatcher make to keep the
+ * built-in and per-service metrics current.
+ */
+
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "system_service/system_types.h"
+#include "system_service/system_metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Clear the registry and register the built-in metrics
+ */
+void metrics_registry_init(void);
+
+/**
+ * @brief Reset a service's counters and drop the metrics it registered
+ * 
+ * Called when the service ID is handed out and when it is released.
+ */
+void metrics_registry_reset_service(system_service_id_t service_id);
+
+/**
+ * @brief Keep the service state gauges current on a state change
+ * 
+ * SYSTEM_SERVICE_STATE_UNREGISTERED as `from` or `to` means the service
+ * is being registered or unregistered.
+ */
+void metrics_registry_service_state(system_service_state_t from, system_service_state_t to);
+
+/* Per-service event counters */
+void metrics_registry_service_posted(system_service_id_t service_id, uint32_t count);
+void metrics_registry_service_received(system_service_id_t service_id);
+
+uint32_t metrics_registry_get_posted(system_service_id_t service_id);
+uint32_t metrics_registry_get_received(system_service_id_t service_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_REGISTRY_H
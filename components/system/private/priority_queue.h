@@ -10,6 +10,7 @@
 #define PRIORITY_QUEUE_H
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
 #include "system_service/system_types.h"
 
 #ifdef __cplusplus
@@ -44,6 +45,24 @@ esp_err_t priority_queue_create(priority_queue_handle_t *handle);
  */
 esp_err_t priority_queue_destroy(priority_queue_handle_t handle);
 
+/**
+ * @brief Called for an event dropped to make room for a newer one
+ * 
+ * Runs outside the queue's lock and takes over event->data.
+ */
+typedef void (*priority_queue_drop_cb_t)(system_event_t *event);
+
+/**
+ * @brief Set the callback for dropped events
+ * 
+ * Without one, a dropped event's payload is just freed.
+ * 
+ * @param handle Queue handle
+ * @param callback Callback, NULL for none
+ */
+void priority_queue_set_drop_callback(priority_queue_handle_t handle,
+                                      priority_queue_drop_cb_t callback);
+
 /* ============================================================================
  * Queue Operations
  * ============================================================================ */
@@ -60,21 +79,113 @@ esp_err_t priority_queue_post(priority_queue_handle_t handle,
                                const system_event_t *event,
                                uint32_t timeout_ms);
 
+/**
+ * @brief Post several events in order
+ * 
+ * Sequence numbers and queue statistics are updated once for the batch.
+ * Stops at the first event that cannot be queued.
+ * 
+ * @param handle Queue handle
+ * @param events Events to post (copied)
+ * @param count Number of events
+ * @param timeout_ms Timeout per event in milliseconds
+ * @param out_posted Output number of events queued (can be NULL)
+ * @return ESP_OK if all were queued, ESP_ERR_TIMEOUT if a queue stayed full,
+ *         error code otherwise
+ */
+esp_err_t priority_queue_post_batch(priority_queue_handle_t handle,
+                                     const system_event_t *events,
+                                     size_t count,
+                                     uint32_t timeout_ms,
+                                     size_t *out_posted);
+
 /**
  * @brief Receive event from priority queue
  * 
  * Receives highest priority event available.
  * Priority order: CRITICAL > HIGH > NORMAL > LOW
  * 
+ * Blocks on a counting semaphore given by priority_queue_post(), so the
+ * caller wakes as soon as an event lands and consumes no CPU while idle.
+ * 
  * @param handle Queue handle
  * @param event Output event structure
- * @param timeout_ms Timeout in milliseconds
- * @return ESP_OK on success, ESP_ERR_TIMEOUT if no events, error code otherwise
+ * @param timeout_ms Timeout in milliseconds (portMAX_DELAY waits forever)
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if no events,
+ *         ESP_ERR_NOT_FOUND if woken by priority_queue_wake_from_isr(),
+ *         error code otherwise
  */
 esp_err_t priority_queue_receive(priority_queue_handle_t handle,
                                   system_event_t *event,
                                   uint32_t timeout_ms);
 
+/**
+ * @brief Receive up to max_events events in priority order
+ * 
+ * Blocks like priority_queue_receive() for the first event, then takes
+ * whatever else is already queued without waiting.
+ * 
+ * @param handle Queue handle
+ * @param events Output array with room for max_events events
+ * @param max_events Capacity of events
+ * @param out_count Output number of events received
+ * @param timeout_ms Timeout for the first event (portMAX_DELAY waits forever)
+ * @return Same as priority_queue_receive()
+ */
+esp_err_t priority_queue_receive_batch(priority_queue_handle_t handle,
+                                        system_event_t *events,
+                                        size_t max_events,
+                                        size_t *out_count,
+                                        uint32_t timeout_ms);
+
+/**
+ * @brief Wake a blocked receiver from interrupt context
+ * 
+ * Makes priority_queue_receive() return ESP_ERR_NOT_FOUND when it finds
+ * no event, so the receiver can move ISR-posted events into the queues.
+ * 
+ * @param handle Queue handle
+ * @param higher_priority_task_woken Set to pdTRUE if a yield is required
+ */
+void priority_queue_wake_from_isr(priority_queue_handle_t handle,
+                                  BaseType_t *higher_priority_task_woken);
+
+/**
+ * @brief Wake a blocked receiver from task context, to stop its task
+ * 
+ * Same as priority_queue_wake_from_isr(): a receive that finds no event
+ * returns ESP_ERR_NOT_FOUND.
+ * 
+ * @param handle Queue handle
+ */
+void priority_queue_wake(priority_queue_handle_t handle);
+
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+/**
+ * @brief Receive the oldest CRITICAL event
+ * 
+ * With the critical lane, CRITICAL events are counted by a semaphore of
+ * their own and never returned by priority_queue_receive(), so their
+ * dispatcher wakes for them alone.
+ * 
+ * @param handle Queue handle
+ * @param event Output event structure
+ * @param timeout_ms Timeout in milliseconds (portMAX_DELAY waits forever)
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if no event,
+ *         ESP_ERR_NOT_FOUND if woken by priority_queue_wake_critical()
+ */
+esp_err_t priority_queue_receive_critical(priority_queue_handle_t handle,
+                                          system_event_t *event,
+                                          uint32_t timeout_ms);
+
+/**
+ * @brief Wake a blocked priority_queue_receive_critical(), to stop its task
+ * 
+ * @param handle Queue handle
+ */
+void priority_queue_wake_critical(priority_queue_handle_t handle);
+#endif
+
 /* ============================================================================
  * Statistics
  * ============================================================================ */
@@ -3,6 +3,21 @@
  * @brief Request/response event pattern
  * 
  * Provides synchronous request/response communication over async event bus.
+ * 
+ * Every request event starts with a request_header_t carrying the request
+ * ID, so the responder can answer the right caller. Pending requests live
+ * in a fixed table indexed by the low bits of the ID; a synchronous
+ * caller waits on its task notification, so a round trip allocates no
+ * kernel objects and no heap.
+ * 
+ * A service may also register a direct request handler for a request
+ * type. request_send_sync() then calls it on the caller's stack instead
+ * of going through the event queue and the dispatch workers.
+ * 
+ * Asynchronous requests are futures: the caller polls, waits on or
+ * attaches a continuation to the handle. Their deadlines share one hashed
+ * timer wheel serviced by a single task, so an outstanding request costs a
+ * table slot and nothing else.
  */
 
 #ifndef REQUEST_RESPONSE_H
@@ -25,12 +40,48 @@ typedef uint32_t request_id_t;
 /** Invalid request ID */
 #define REQUEST_ID_INVALID 0
 
-/** Request/response callback */
-typedef void (*response_callback_t)(request_id_t request_id, 
+/** Marks a request event payload */
+#define REQUEST_HEADER_MAGIC 0x52455121  // "REQ!"
+
+/** Correlation header in front of every request payload */
+typedef struct {
+    uint32_t magic;                     /**< REQUEST_HEADER_MAGIC */
+    request_id_t request_id;            /**< Pass to request_send_response() */
+    system_service_id_t requester;      /**< Service that sent the request */
+    system_service_id_t target;         /**< Service expected to answer */
+    uint32_t reserved;                  /**< Keeps the payload 8-byte aligned */
+} request_header_t;
+
+/** Handle of an outstanding asynchronous request */
+typedef request_id_t request_future_t;
+
+/**
+ * @brief Response continuation
+ * 
+ * status is ESP_OK with the response, ESP_ERR_TIMEOUT when the deadline
+ * passed (response_data NULL), or ESP_ERR_NO_MEM if the response could
+ * not be stored. response_data is only valid during the call.
+ */
+typedef void (*response_callback_t)(request_id_t request_id,
+                                     esp_err_t status,
                                      const void *response_data,
                                      size_t response_size,
                                      void *user_data);
 
+/**
+ * @brief Direct request handler, runs in the requester's context
+ * 
+ * header->request_id is REQUEST_ID_INVALID: the response is written to
+ * response_data (at most *response_size bytes, update *response_size),
+ * not sent with request_send_response().
+ */
+typedef esp_err_t (*request_handler_t)(const request_header_t *header,
+                                       const void *request_data,
+                                       size_t request_size,
+                                       void *response_data,
+                                       size_t *response_size,
+                                       void *user_data);
+
 /* ============================================================================
  * Request/Response API
  * ============================================================================ */
@@ -38,8 +89,15 @@ typedef void (*response_callback_t)(request_id_t request_id,
 /**
  * @brief Send request and wait for response
  * 
- * Sends request event and blocks until response received or timeout.
+ * Sends request event and blocks until response received or timeout. The
+ * calling task's notification value is used to wake it; stray
+ * notifications are tolerated.
+ * 
+ * If target_service registered a direct handler for request_type, it is
+ * called right here instead, timed by the handler monitor, and its result
+ * is returned.
  * 
+ * @param requester Service sending the request (event sender)
  * @param target_service Service to send request to
  * @param request_type Request event type
  * @param request_data Request data
@@ -47,9 +105,12 @@ typedef void (*response_callback_t)(request_id_t request_id,
  * @param response_data Output response data buffer
  * @param response_size Input: buffer size, Output: actual response size
  * @param timeout_ms Timeout in milliseconds
- * @return ESP_OK on success, ESP_ERR_TIMEOUT if no response, error code otherwise
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if no response,
+ *         ESP_ERR_NO_MEM if all request slots are in use,
+ *         ESP_ERR_INVALID_STATE if cancelled, error code otherwise
  */
-esp_err_t request_send_sync(system_service_id_t target_service,
+esp_err_t request_send_sync(system_service_id_t requester,
+                             system_service_id_t target_service,
                              system_event_type_t request_type,
                              const void *request_data,
                              size_t request_size,
@@ -60,23 +121,115 @@ esp_err_t request_send_sync(system_service_id_t target_service,
 /**
  * @brief Send request with async callback
  * 
+ * The callback runs in the responder's context, or in the request timeout
+ * task with ESP_ERR_TIMEOUT. Exactly one of the two happens.
+ * 
+ * @param requester Service sending the request (event sender)
  * @param target_service Service to send request to
  * @param request_type Request event type
  * @param request_data Request data
  * @param request_size Request data size
+ * @param timeout_ms Deadline in milliseconds, rounded up to the timer
+ *                   wheel resolution
  * @param callback Response callback
  * @param user_data User data for callback
- * @param out_request_id Output request ID
- * @return ESP_OK on success, error code otherwise
+ * @param out_request_id Output request ID (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all request slots are in use,
+ *         error code otherwise
  */
-esp_err_t request_send_async(system_service_id_t target_service,
+esp_err_t request_send_async(system_service_id_t requester,
+                              system_service_id_t target_service,
                               system_event_type_t request_type,
                               const void *request_data,
                               size_t request_size,
+                              uint32_t timeout_ms,
                               response_callback_t callback,
                               void *user_data,
                               request_id_t *out_request_id);
 
+/**
+ * @brief Send request and return a future for its response
+ * 
+ * The response is copied into a memory pool block when it arrives. The
+ * future must be consumed by request_future_poll() or
+ * request_future_wait() returning a final result, handed to
+ * request_future_then(), or dropped with request_future_release().
+ * 
+ * @param requester Service sending the request (event sender)
+ * @param target_service Service to send request to
+ * @param request_type Request event type
+ * @param request_data Request data
+ * @param request_size Request data size
+ * @param timeout_ms Deadline in milliseconds, rounded up to the timer
+ *                   wheel resolution
+ * @param out_future Output future handle
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all request slots are in use,
+ *         error code otherwise
+ */
+esp_err_t request_send_future(system_service_id_t requester,
+                               system_service_id_t target_service,
+                               system_event_type_t request_type,
+                               const void *request_data,
+                               size_t request_size,
+                               uint32_t timeout_ms,
+                               request_future_t *out_future);
+
+/**
+ * @brief Check a future without blocking
+ * 
+ * On any result other than ESP_ERR_NOT_FINISHED the future is consumed.
+ * 
+ * @param future Future handle
+ * @param response_data Output response buffer (can be NULL to discard)
+ * @param response_size Input: buffer size, Output: bytes copied
+ * @return ESP_OK with the response, ESP_ERR_NOT_FINISHED if still pending,
+ *         ESP_ERR_TIMEOUT if the deadline passed, ESP_ERR_NOT_FOUND if the
+ *         handle is stale
+ */
+esp_err_t request_future_poll(request_future_t future,
+                               void *response_data,
+                               size_t *response_size);
+
+/**
+ * @brief Block until a future completes or timeout_ms elapses
+ * 
+ * Uses the calling task's notification. Giving up leaves the future
+ * pending.
+ * 
+ * @param future Future handle
+ * @param response_data Output response buffer (can be NULL to discard)
+ * @param response_size Input: buffer size, Output: bytes copied
+ * @param timeout_ms How long to wait here, independent of the deadline
+ * @return Same as request_future_poll()
+ */
+esp_err_t request_future_wait(request_future_t future,
+                               void *response_data,
+                               size_t *response_size,
+                               uint32_t timeout_ms);
+
+/**
+ * @brief Attach a continuation to a future
+ * 
+ * Runs immediately on the calling task if the future already completed,
+ * otherwise like a request_send_async() callback. Consumes the future.
+ * 
+ * @param future Future handle
+ * @param callback Continuation
+ * @param user_data User data for callback
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the handle is stale
+ */
+esp_err_t request_future_then(request_future_t future,
+                               response_callback_t callback,
+                               void *user_data);
+
+/**
+ * @brief Drop a future and any response it holds
+ * 
+ * @param future Future handle
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the handle is stale
+ */
+esp_err_t request_future_release(request_future_t future);
+
 /**
  * @brief Send response to request
  * 
@@ -91,6 +244,51 @@ esp_err_t request_send_response(request_id_t request_id,
                                  const void *response_data,
                                  size_t response_size);
 
+/**
+ * @brief Register a direct handler for synchronous requests
+ * 
+ * One handler per request type. The handler must be safe to run on any
+ * requester's task and stack; requests sent with request_send_async()
+ * or request_send_future() still arrive as events.
+ * 
+ * @param service_id Service serving the requests
+ * @param request_type Request event type
+ * @param handler Handler to call
+ * @param user_data Passed to handler
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if another service
+ *         already registered this type, error code otherwise
+ */
+esp_err_t request_register_handler(system_service_id_t service_id,
+                                   system_event_type_t request_type,
+                                   request_handler_t handler,
+                                   void *user_data);
+
+/**
+ * @brief Remove a direct handler
+ * 
+ * A call already running on another task may still complete.
+ * 
+ * @param service_id Service that registered it
+ * @param request_type Request event type
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if not registered by service_id
+ */
+esp_err_t request_unregister_handler(system_service_id_t service_id,
+                                     system_event_type_t request_type);
+
+/**
+ * @brief Split a request event into header and payload
+ * 
+ * @param event Request event as received by the handler
+ * @param out_header Output correlation header
+ * @param out_payload Output request data (can be NULL)
+ * @param out_size Output request data size (can be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if event is not a request
+ */
+esp_err_t request_parse(const system_event_t *event,
+                        const request_header_t **out_header,
+                        const void **out_payload,
+                        size_t *out_size);
+
 /**
  * @brief Cancel pending request
  * 
@@ -16,6 +16,24 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Memory Accounting Types
+ * ============================================================================ */
+
+/** Where charged memory lives */
+typedef enum {
+    QUOTA_MEMORY_INTERNAL = 0,      /**< Internal SRAM */
+    QUOTA_MEMORY_PSRAM,             /**< External PSRAM */
+} quota_memory_region_t;
+
+/** Per-service memory charge */
+typedef struct {
+    uint32_t internal_bytes;        /**< Currently charged internal SRAM */
+    uint32_t psram_bytes;           /**< Currently charged PSRAM */
+    uint32_t peak_internal_bytes;   /**< Highest internal charge seen */
+    uint32_t rejected;              /**< Allocations refused by the quota */
+} quota_memory_usage_t;
+
 /* ============================================================================
  * Initialization
  * ============================================================================ */
@@ -70,25 +88,104 @@ esp_err_t quota_get_usage(system_service_id_t service_id, service_quota_usage_t
  * ============================================================================ */
 
 /**
- * @brief Check if service can post event
+ * @brief Take one token for posting an event
+ * 
+ * Refills the service's token bucket and the event type's budget (if one
+ * is set) by the time elapsed, then consumes from both. Lock-free; a
+ * single compare-and-swap per bucket.
+ * 
+ * @param service_id Service identifier
+ * @param event_type Event type being posted
+ * @return ESP_OK if allowed, ESP_ERR_QUOTA_EVENTS_EXCEEDED if a bucket is empty
+ */
+esp_err_t quota_take_event(system_service_id_t service_id, system_event_type_t event_type);
+
+/**
+ * @brief Take count tokens from the service's bucket, all or nothing
+ * 
+ * @param service_id Service identifier
+ * @param count Number of events
+ * @return ESP_OK if allowed, ESP_ERR_QUOTA_EVENTS_EXCEEDED otherwise
+ */
+esp_err_t quota_take_events(system_service_id_t service_id, uint32_t count);
+
+/**
+ * @brief Take count tokens from an event type's budget, if it has one
+ * 
+ * @param service_id Service identifier
+ * @param event_type Event type
+ * @param count Number of events of that type
+ * @return ESP_OK if allowed or no budget is set, ESP_ERR_QUOTA_EVENTS_EXCEEDED otherwise
+ */
+esp_err_t quota_take_type_events(system_service_id_t service_id,
+                                 system_event_type_t event_type,
+                                 uint32_t count);
+
+/**
+ * @brief Give back the tokens of a quota_take_event() whose post failed
  * 
- * Checks event rate quota.
+ * @param service_id Service identifier
+ * @param event_type Event type
+ */
+void quota_return_event(system_service_id_t service_id, system_event_type_t event_type);
+
+/**
+ * @brief Give back tokens taken with quota_take_events()
+ * 
+ * @param service_id Service identifier
+ * @param count Number of tokens
+ */
+void quota_return_events(system_service_id_t service_id, uint32_t count);
+
+/**
+ * @brief Give back tokens taken with quota_take_type_events()
  * 
  * @param service_id Service identifier
- * @return ESP_OK if allowed, ESP_ERR_QUOTA_EVENTS_EXCEEDED if quota exceeded
+ * @param event_type Event type
+ * @param count Number of tokens
  */
-esp_err_t quota_check_event_post(system_service_id_t service_id);
+void quota_return_type_events(system_service_id_t service_id,
+                              system_event_type_t event_type,
+                              uint32_t count);
 
 /**
  * @brief Record event post
  * 
- * Updates event counter for quota tracking.
+ * Updates the posted-event counter. Lock-free.
  * 
  * @param service_id Service identifier
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t quota_record_event_post(system_service_id_t service_id);
 
+/**
+ * @brief Record a batch of event posts
+ * 
+ * @param service_id Service identifier
+ * @param count Number of events posted
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t quota_record_event_batch(system_service_id_t service_id, uint32_t count);
+
+/**
+ * @brief Limit one event type of a service on top of its overall rate
+ * 
+ * Budgets come from a fixed table of
+ * CONFIG_SYSTEM_SERVICE_MAX_EVENT_TYPE_QUOTAS entries.
+ * 
+ * @param service_id Service identifier
+ * @param event_type Event type
+ * @param rate Tokens per second, 0 removes the budget
+ * @param burst Bucket depth, 0 for rate
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the table is full,
+ *         ESP_ERR_NOT_FOUND when removing a budget that is not set,
+ *         error code otherwise
+ */
+esp_err_t quota_set_event_type_budget(system_service_id_t service_id,
+                                      system_event_type_t event_type,
+                                      uint32_t rate,
+                                      uint32_t burst);
+
 /**
  * @brief Check if service can subscribe
  * 
@@ -110,9 +207,20 @@ esp_err_t quota_check_subscription(system_service_id_t service_id);
  */
 esp_err_t quota_record_subscription(system_service_id_t service_id, bool add);
 
+/**
+ * @brief Record dropped subscriptions
+ * 
+ * @param service_id Service identifier
+ * @param count Subscriptions removed at once
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t quota_release_subscriptions(system_service_id_t service_id, uint32_t count);
+
 /**
  * @brief Check event data size
  * 
+ * Lock-free.
+ * 
  * @param service_id Service identifier
  * @param data_size Size of event data
  * @return ESP_OK if allowed, ESP_ERR_QUOTA_DATA_SIZE_EXCEEDED if quota exceeded
@@ -120,31 +228,50 @@ esp_err_t quota_record_subscription(system_service_id_t service_id, bool add);
 esp_err_t quota_check_data_size(system_service_id_t service_id, size_t data_size);
 
 /**
- * @brief Record memory allocation
+ * @brief Charge a memory allocation against the service's quota
+ * 
+ * Lock-free and safe from any task. Nothing is recorded when the
+ * allocation would exceed max_memory_bytes (both regions together); the
+ * caller must then not keep the memory. Services without an explicit
+ * quota are charged against the defaults.
  * 
  * @param service_id Service identifier
  * @param size Size allocated
- * @return ESP_OK on success, error code otherwise
+ * @param region Memory the allocation came from
+ * @return ESP_OK if charged, ESP_ERR_QUOTA_MEMORY_EXCEEDED if over quota,
+ *         error code otherwise
  */
-esp_err_t quota_record_memory_alloc(system_service_id_t service_id, size_t size);
+esp_err_t quota_record_memory_alloc(system_service_id_t service_id, size_t size,
+                                    quota_memory_region_t region);
 
 /**
  * @brief Record memory free
  * 
  * @param service_id Service identifier
- * @param size Size freed
+ * @param size Size freed, as charged
+ * @param region Region it was charged to
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t quota_record_memory_free(system_service_id_t service_id, size_t size);
+esp_err_t quota_record_memory_free(system_service_id_t service_id, size_t size,
+                                   quota_memory_region_t region);
+
+/**
+ * @brief Get a service's memory charge by region
+ * 
+ * @param service_id Service identifier
+ * @param usage Output memory usage
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if service_id invalid
+ */
+esp_err_t quota_get_memory_usage(system_service_id_t service_id, quota_memory_usage_t *usage);
 
 /* ============================================================================
  * Utilities
  * ============================================================================ */
 
 /**
- * @brief Reset quota counters
+ * @brief Refill every event token bucket
  * 
- * Called periodically (e.g., every second) to reset rate-limited counters.
+ * Buckets refill continuously on their own; this only forces them full.
  * 
  * @return ESP_OK on success, error code otherwise
  */
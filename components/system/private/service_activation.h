@@ -0,0 +1,36 @@
+/**
+ * @file service_activation.h
+ * @brief On-demand service activation, internal hooks
+ *
+ * The event bus and the request layer report demand here; none of the
+ * hooks block or take the system lock, and they return at once while no
+ * activatable service is registered.
+ */
+
+#ifndef SERVICE_ACTIVATION_H
+#define SERVICE_ACTIVATION_H
+
+#include "esp_err.h"
+#include "system_service/system_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t service_activation_init(void);
+
+/** A subscription to event_type was added, call without the system lock */
+void service_activation_on_subscribe(system_service_id_t subscriber,
+                                     system_event_type_t event_type);
+
+/** A pattern subscription was added, call without the system lock */
+void service_activation_on_pattern(system_service_id_t subscriber, const char *pattern);
+
+/** A request was sent to target, which keeps an active service from going idle */
+void service_activation_on_request(system_service_id_t target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVICE_ACTIVATION_H
@@ -4,6 +4,10 @@
  * 
  * Manages dependencies between services to ensure correct initialization order.
  * Detects circular dependencies and provides topological sort.
+ * 
+ * Instead of polling dependencies_check_ready(), a service can register a
+ * ready callback; dependencies_mark_initialized() calls it as soon as the
+ * last of the service's dependencies comes up.
  */
 
 #ifndef SERVICE_DEPENDENCIES_H
@@ -16,6 +20,23 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/**
+ * @brief Called when every dependency of a service is initialized
+ * 
+ * Runs on the task that marked the last dependency initialized, or on the
+ * registering task if the service was already ready. No lock is held, so
+ * it may call back into this API, but it should only hand off work (give
+ * a semaphore, post an event) rather than initialize the service inline.
+ * 
+ * @param service_name Service that became ready
+ * @param user_data User data given at registration
+ */
+typedef void (*dependency_ready_cb_t)(const char *service_name, void *user_data);
+
 /* ============================================================================
  * Initialization
  * ============================================================================ */
@@ -87,6 +108,34 @@ esp_err_t dependencies_check_ready(const char *service_name);
  */
 esp_err_t dependencies_mark_initialized(const char *service_name);
 
+/**
+ * @brief Mark service as no longer initialized
+ * 
+ * Used when a service is stopped for a restart. Its dependents become
+ * not ready again; their callbacks run once it is marked initialized
+ * again.
+ * 
+ * @param service_name Service name
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t dependencies_mark_uninitialized(const char *service_name);
+
+/**
+ * @brief Register a ready callback for a service
+ * 
+ * One callback per service; a new one replaces the old, NULL removes it.
+ * The callback runs every time the service goes from not ready to ready,
+ * and once right away if it is ready already.
+ * 
+ * @param service_name Service to watch
+ * @param callback Ready callback (can be NULL)
+ * @param user_data Passed to callback
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the graph is full
+ */
+esp_err_t dependencies_set_ready_callback(const char *service_name,
+                                          dependency_ready_cb_t callback,
+                                          void *user_data);
+
 /* ============================================================================
  * Utilities
  * ============================================================================ */
@@ -81,7 +81,8 @@ esp_err_t watchdog_unregister_service(system_service_id_t service_id);
 /**
  * @brief Update service heartbeat timestamp
  * 
- * Called by service_manager when service sends heartbeat.
+ * Called by service_manager when service sends heartbeat. A single
+ * atomic store; never blocks or takes the watchdog mutex.
  * 
  * @param service_id Service identifier
  * @param timestamp Current timestamp (ms)
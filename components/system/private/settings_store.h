@@ -0,0 +1,32 @@
+/**
+ * @file settings_store.h
+ * @brief Lifecycle of the settings store (system_settings.h)
+ */
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Open the settings namespace and start the write-back task
+ * 
+ * Called by system_service_init(), after common_events_init(). Without
+ * NVS the settings still work, from their defaults and in RAM only.
+ */
+esp_err_t settings_store_init(void);
+
+/**
+ * @brief Commit what is dirty and stop the write-back task
+ */
+void settings_store_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SETTINGS_STORE_H
@@ -0,0 +1,50 @@
+/**
+ * @file system_bench.h
+ * @brief Micro-benchmarks of the system service hot paths
+ * 
+ * Measures, on the running system:
+ * - event post to handler latency, per priority
+ * - event throughput with one and with several subscribers
+ * - memory_pool_alloc()/memory_pool_free() cost, on one core and
+ *   contended from both
+ * - request_send_sync() round trip, through the event queue and with a
+ *   direct handler
+ * - handler_monitor_execute() cost over a direct call
+ * 
+ * Every result is one line on stdout, so release builds can be compared
+ * by grepping the console:
+ * 
+ *     BENCH,<group>,<metric>,<value>,<unit>
+ * 
+ * The run registers its own services and event types, and unregisters
+ * the services when done. Other traffic on the bus shows up in the
+ * numbers, so run it before apps are started.
+ */
+
+#ifndef SYSTEM_BENCH_H
+#define SYSTEM_BENCH_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run all benchmarks and print the results
+ * 
+ * Blocks the caller for the whole run, a few seconds with the default
+ * CONFIG_SYSTEM_SERVICE_BENCHMARK_ITERATIONS. Must not be called from
+ * an event handler.
+ * 
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without
+ *         CONFIG_SYSTEM_SERVICE_BENCHMARK, error code if a benchmark
+ *         could not be set up
+ */
+esp_err_t system_bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_BENCH_H
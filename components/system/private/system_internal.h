@@ -13,20 +13,66 @@ extern "C" {
 #define SYSTEM_MAGIC_NUMBER           0x53595354
 #define SYSTEM_SERVICE_MUTEX_TIMEOUT_MS 1000
 
+/** End-of-chain marker for the per-type and per-service subscriber index */
+#define SUBSCRIPTION_INDEX_NONE       0xFFFF
+
+/** Open-addressing name index, at least twice the type capacity */
+#if SYSTEM_SERVICE_MAX_EVENT_TYPES <= 32
+#define EVENT_TYPE_HASH_SIZE          64
+#elif SYSTEM_SERVICE_MAX_EVENT_TYPES <= 64
+#define EVENT_TYPE_HASH_SIZE          128
+#elif SYSTEM_SERVICE_MAX_EVENT_TYPES <= 128
+#define EVENT_TYPE_HASH_SIZE          256
+#else
+#define EVENT_TYPE_HASH_SIZE          512
+#endif
+
 typedef struct {
     system_event_type_t event_type;
     char event_name[SYSTEM_SERVICE_MAX_NAME_LEN];
     bool registered;
+    uint32_t name_hash;             // system_event_name_hash(event_name)
+    uint16_t first_subscription;    // Head of this type's subscriber chain
+    uint16_t last_subscription;     // Its tail, where new subscribers go
+    uint16_t subscriber_count;      // Active subscribers on the chain
+    system_event_topic_mode_t mode; // Queued or latest-value topic
+    uint16_t payload_size;          // From the schema, 0 if none or runtime type
+    uint16_t version;               // From the schema, 0 for runtime types
+    uint32_t deadline_us;           // Post to handler return, 0 for none
+    uint32_t wildcard_mask;         // Wildcard subscriptions matching this type
 } event_type_entry_t;
 
+/** Latest pending value of a coalescing topic for one sender */
+typedef struct {
+    system_event_t event;           // Pending event, owns event.data
+    bool in_use;                    // Bound to event.event_type/sender_id while pending
+    bool pending;                   // A queue marker is waiting for this slot
+    uint32_t generation;            // Tags the pending value, see coalesce_cancel()
+} latest_slot_t;
+
 typedef struct {
     system_service_id_t service_id;
     system_event_type_t event_type;
     system_event_handler_t handler;
     void *user_data;
+    system_event_filter_t filter;   // Zeroed when subscribed without one
+    system_event_affinity_t affinity;
     bool active;
+    uint16_t next_in_type;          // Next subscription slot for the same type
+    uint16_t prev_in_type;
+    uint16_t next_in_service;       // Next subscription slot of the same service
+    uint16_t prev_in_service;
 } event_subscription_t;
 
+/** Subscription to a name pattern, expanded into the matching types' wildcard_mask */
+typedef struct {
+    char pattern[SYSTEM_SERVICE_MAX_NAME_LEN];
+    system_service_id_t service_id;
+    system_event_handler_t handler;
+    void *user_data;
+    bool active;
+} topic_wildcard_t;
+
 typedef struct {
     char name[SYSTEM_SERVICE_MAX_NAME_LEN];
     system_service_id_t service_id;
@@ -34,7 +80,8 @@ typedef struct {
     uint32_t last_heartbeat;
     void *service_context;
     bool registered;
-    uint32_t event_count;
+    uint16_t first_subscription;    // Head of this service's subscription chain
+    uint16_t subscription_count;
 } service_entry_t;
 
 typedef struct {
@@ -47,16 +94,20 @@ typedef struct {
     
     event_type_entry_t event_types[SYSTEM_SERVICE_MAX_EVENT_TYPES];
     uint16_t event_type_count;
+    uint16_t type_hash_index[EVENT_TYPE_HASH_SIZE];  // Type ID + 1, 0 = empty
     
     event_subscription_t subscriptions[SYSTEM_SERVICE_MAX_SUBSCRIBERS];
     uint16_t subscription_count;
+    uint32_t subscription_seq;      // Odd while subscriber chains are changing
+    
+    topic_wildcard_t wildcards[SYSTEM_SERVICE_MAX_WILDCARDS];
+    
+    latest_slot_t latest[SYSTEM_SERVICE_MAX_LATEST_SLOTS];
     
     priority_queue_handle_t event_queue;  // Changed from QueueHandle_t
     SemaphoreHandle_t mutex;
     TaskHandle_t event_task;
-    
-    uint32_t total_events_posted;
-    uint32_t total_events_processed;
+    TaskHandle_t critical_task;     // CONFIG_SYSTEM_SERVICE_CRITICAL_LANE dispatcher
     
     bool running;
 } system_context_t;
@@ -69,6 +120,52 @@ esp_err_t system_lock(void);
 
 esp_err_t system_unlock(void);
 
+/**
+ * Subscriber index, maintained by the event bus: every subscription is on
+ * its type's chain, in subscription order, and on its service's chain.
+ * Both are doubly linked, so a subscription comes off in O(1).
+ * Callers must hold the system lock.
+ */
+void system_subscription_index_reset(system_context_t *ctx);
+
+void system_subscription_link(system_context_t *ctx, uint16_t slot);
+
+void system_subscription_unlink(system_context_t *ctx, uint16_t slot);
+
+/**
+ * Free every subscription of a service in one pass over its chain, as a
+ * single index update. Returns how many there were.
+ */
+uint16_t system_subscription_drop_service(system_context_t *ctx, system_service_id_t service_id);
+
+/**
+ * Sequence-locked read of the subscriber index, no lock required.
+ * Copy what is needed between begin and retry, and start over while
+ * retry returns true. Writers hold the system lock, so a reader that
+ * keeps failing can take it to let the writer finish.
+ */
+uint32_t system_subscription_read_begin(system_context_t *ctx);
+
+bool system_subscription_read_retry(system_context_t *ctx, uint32_t seq);
+
+/**
+ * Swap a dequeued latest-value marker for the pending value it stands for.
+ * Safe without the system lock. Returns false if nothing is pending.
+ */
+bool system_event_take_latest(system_context_t *ctx, system_event_t *event);
+
+/**
+ * Release an event the priority queue dropped on overflow. A latest-value
+ * marker gives up its pending value, so the next post queues a new one.
+ */
+void system_event_on_drop(system_event_t *event);
+
+/**
+ * Move events posted from ISRs into the priority queues.
+ * Called by the event task only.
+ */
+void system_event_drain_isr(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,66 @@
+/**
+ * @file topic_trie.h
+ * @brief Prefix trie over the registered event type names
+ * 
+ * Resolves wildcard patterns such as "network.*" or "input.key_*_pressed"
+ * to the types they match. Edge labels point into the interned names of
+ * the event type table, so the trie stores no strings of its own and
+ * needs at most two nodes per type.
+ * 
+ * Only used when subscribing and registering, under the system lock;
+ * dispatch never walks it.
+ */
+
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "system_service/system_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Wildcard character: matches any run of characters, at most once per pattern */
+#define TOPIC_WILDCARD              '*'
+
+typedef void (*topic_trie_visit_fn_t)(system_event_type_t event_type, void *arg);
+
+/**
+ * @brief Drop every name, called with the event type table reset
+ */
+void topic_trie_reset(void);
+
+/**
+ * @brief Add a registered type
+ * 
+ * @param event_type Type ID
+ * @param name Its interned name, which must outlive the trie
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the node pool is exhausted
+ */
+esp_err_t topic_trie_insert(system_event_type_t event_type, const char *name);
+
+/**
+ * @brief Call visit for every type whose name matches the pattern
+ * 
+ * The part before the wildcard selects a subtree; the part after it is
+ * checked against the end of each name in it.
+ */
+void topic_trie_match(const char *pattern, topic_trie_visit_fn_t visit, void *arg);
+
+/**
+ * @brief Check one name against a pattern, without the trie
+ */
+bool topic_pattern_match(const char *pattern, const char *name);
+
+/**
+ * @brief Whether a string is a usable pattern: one wildcard, fits a type name
+ */
+bool topic_pattern_valid(const char *pattern);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOPIC_TRIE_H
@@ -0,0 +1,169 @@
+/**
+ * @file app_arena.c
+ * @brief Per-app bump allocator implementation
+ */
+
+#include "app_arena.h"
+#include "resource_quota.h"
+#include "system_service/memory_utils.h"
+#include "system_service/error_codes.h"
+#include "system_service/static_alloc.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "app_arena";
+
+/* ============================================================================
+ * Chunk Structure
+ * ============================================================================ */
+
+#define ARENA_ALIGN         8
+#define ARENA_ALIGN_UP(n)   (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct app_arena_chunk {
+    app_arena_chunk_t *next;        /**< Older chunk */
+    size_t capacity;                /**< Usable bytes in data */
+    size_t offset;                  /**< Bump pointer into data */
+    size_t charged;                 /**< Bytes charged to the quota */
+    uint8_t data[] __attribute__((aligned(ARENA_ALIGN)));
+};
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+/**
+ * @brief Open a new chunk with room for at least size bytes (lock held)
+ */
+static app_arena_chunk_t* arena_add_chunk(app_arena_t *arena, size_t size)
+{
+    size_t capacity = size > CONFIG_SYSTEM_SERVICE_APP_ARENA_CHUNK_SIZE ?
+                      size : CONFIG_SYSTEM_SERVICE_APP_ARENA_CHUNK_SIZE;
+    size_t total = sizeof(app_arena_chunk_t) + capacity;
+    
+    // Charge first so an app over its quota never touches the heap
+    esp_err_t ret = quota_record_memory_alloc(arena->service_id, total, QUOTA_MEMORY_PSRAM);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Service %d arena chunk of %zu bytes refused: %s",
+                 arena->service_id, total, system_service_err_to_name(ret));
+        return NULL;
+    }
+    
+    app_arena_chunk_t *chunk = APP_MALLOC(total);
+    if (chunk == NULL) {
+        quota_record_memory_free(arena->service_id, total, QUOTA_MEMORY_PSRAM);
+        ESP_LOGE(TAG, "Service %d arena out of memory (%zu bytes)", arena->service_id, total);
+        return NULL;
+    }
+    
+    chunk->capacity = capacity;
+    chunk->offset = 0;
+    chunk->charged = total;
+    
+    // An oversized request gets its own chunk behind the active one
+    if (size > CONFIG_SYSTEM_SERVICE_APP_ARENA_CHUNK_SIZE && arena->chunks != NULL) {
+        chunk->next = arena->chunks->next;
+        arena->chunks->next = chunk;
+    } else {
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    arena->reserved_bytes += total;
+    
+    return chunk;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t app_arena_init(app_arena_t *arena, system_service_id_t service_id)
+{
+    if (arena == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(arena, 0, sizeof(app_arena_t));
+    arena->service_id = service_id;
+    
+    arena->mutex = SYSTEM_MUTEX_CREATE(arena->mutex_storage);
+    if (arena->mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    return ESP_OK;
+}
+
+void* app_arena_alloc(app_arena_t *arena, size_t size)
+{
+    if (arena == NULL || arena->mutex == NULL || size == 0) {
+        return NULL;
+    }
+    
+    size = ARENA_ALIGN_UP(size);
+    
+    if (xSemaphoreTake(arena->mutex, portMAX_DELAY) != pdTRUE) {
+        return NULL;
+    }
+    
+    app_arena_chunk_t *chunk = arena->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->offset < size) {
+        chunk = arena_add_chunk(arena, size);
+    }
+    
+    void *ptr = NULL;
+    if (chunk != NULL) {
+        ptr = chunk->data + chunk->offset;
+        chunk->offset += size;
+        arena->used_bytes += size;
+    }
+    
+    xSemaphoreGive(arena->mutex);
+    
+    return ptr;
+}
+
+void app_arena_release(app_arena_t *arena)
+{
+    if (arena == NULL || arena->mutex == NULL) {
+        return;
+    }
+    
+    xSemaphoreTake(arena->mutex, portMAX_DELAY);
+    
+    app_arena_chunk_t *chunk = arena->chunks;
+    size_t released = arena->reserved_bytes;
+    
+    arena->chunks = NULL;
+    arena->reserved_bytes = 0;
+    arena->used_bytes = 0;
+    
+    xSemaphoreGive(arena->mutex);
+    
+    while (chunk != NULL) {
+        app_arena_chunk_t *next = chunk->next;
+        quota_record_memory_free(arena->service_id, chunk->charged, QUOTA_MEMORY_PSRAM);
+        free(chunk);
+        chunk = next;
+    }
+    
+    if (released > 0) {
+        ESP_LOGI(TAG, "Service %d arena released (%zu bytes)", arena->service_id, released);
+    }
+}
+
+void app_arena_deinit(app_arena_t *arena)
+{
+    if (arena == NULL || arena->mutex == NULL) {
+        return;
+    }
+    
+    app_arena_release(arena);
+    vSemaphoreDelete(arena->mutex);
+    arena->mutex = NULL;
+}
+
+size_t app_arena_used(const app_arena_t *arena)
+{
+    return (arena != NULL) ? arena->used_bytes : 0;
+}
@@ -8,6 +8,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "system_service/error_codes.h"
+#include "system_service/static_alloc.h"
 
 static const char *TAG = "app_context_refcount";
 
@@ -24,6 +25,7 @@ typedef struct {
 
 static context_refcount_t g_contexts[SYSTEM_SERVICE_MAX_SERVICES] = {0};
 static SemaphoreHandle_t g_context_mutex = NULL;
+SYSTEM_MUTEX_DEFINE(s_context_mutex);
 
 /* ============================================================================
  * Internal Helpers
@@ -32,7 +34,7 @@ static SemaphoreHandle_t g_context_mutex = NULL;
 static void ensure_mutex(void)
 {
     if (g_context_mutex == NULL) {
-        g_context_mutex = xSemaphoreCreateMutex();
+        g_context_mutex = SYSTEM_MUTEX_CREATE(s_context_mutex);
     }
 }
 
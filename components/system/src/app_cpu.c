@@ -0,0 +1,217 @@
+/**
+ * @file app_cpu.c
+ * @brief Per-app CPU accounting and budgets implementation
+ *
+ * The sampler runs on the esp_timer task, so it never waits for the
+ * registry: a period in which the registry is busy is folded into the
+ * next one. Run-time counters are in microseconds (esp_timer clock) and
+ * compared as deltas, which survives their wrap. A worker that changed
+ * hands since the last sample starts a fresh baseline.
+ */
+
+#include "app_cpu.h"
+#include "handler_monitor.h"
+#include "resource_quota.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#if CONFIG_SYSTEM_SERVICE_APP_CPU_ACCOUNTING
+
+static const char *TAG = "app_cpu";
+
+#define PERIOD_US               ((int64_t)CONFIG_SYSTEM_SERVICE_APP_CPU_PERIOD_MS * 1000)
+#define NORMAL_PRIORITY         CONFIG_SYSTEM_SERVICE_APP_WORKER_PRIORITY
+#define THROTTLE_PRIORITY       CONFIG_SYSTEM_SERVICE_APP_CPU_THROTTLE_PRIORITY
+#define THROTTLE_EVENTS_PER_SEC CONFIG_SYSTEM_SERVICE_APP_CPU_THROTTLE_EVENTS_PER_SEC
+
+static esp_timer_handle_t s_timer = NULL;
+
+static uint32_t budget_of(const app_registry_entry_t *entry)
+{
+    uint32_t budget = entry->info.manifest.cpu_budget_percent;
+    if (budget == 0) {
+        budget = CONFIG_SYSTEM_SERVICE_APP_CPU_BUDGET_PERCENT;
+    }
+    return budget;
+}
+
+static void throttle(app_registry_entry_t *entry, uint32_t percent)
+{
+    app_cpu_account_t *cpu = &entry->cpu;
+    
+    service_quota_t quota;
+    if (quota_get(entry->info.service_id, &quota) == ESP_OK) {
+        cpu->saved_quota = quota;
+        cpu->quota_saved = true;
+        if (quota.max_events_per_sec > THROTTLE_EVENTS_PER_SEC) {
+            quota.max_events_per_sec = THROTTLE_EVENTS_PER_SEC;
+        }
+        quota.event_burst = 0;
+        quota_set(entry->info.service_id, &quota);
+    }
+    
+    if (entry->task_handle != NULL) {
+        vTaskPrioritySet(entry->task_handle, THROTTLE_PRIORITY);
+    }
+    
+    cpu->throttled = true;
+    entry->info.cpu_throttled = true;
+    entry->info.cpu_throttle_count++;
+    
+    ESP_LOGW(TAG, "App '%s' used %lu%% CPU, budget %lu%%: throttled",
+             entry->info.manifest.name, percent, budget_of(entry));
+}
+
+static void unthrottle(app_registry_entry_t *entry)
+{
+    app_cpu_account_t *cpu = &entry->cpu;
+    
+    if (cpu->quota_saved) {
+        quota_set(entry->info.service_id, &cpu->saved_quota);
+        cpu->quota_saved = false;
+    }
+    
+    if (entry->task_handle != NULL) {
+        vTaskPrioritySet(entry->task_handle, NORMAL_PRIORITY);
+    }
+    
+    cpu->throttled = false;
+    entry->info.cpu_throttled = false;
+}
+
+static void sample_entry(app_registry_entry_t *entry, int64_t now_us)
+{
+    app_cpu_account_t *cpu = &entry->cpu;
+    int64_t period_us = now_us - cpu->sampled_us;
+    if (period_us <= 0) {
+        return;
+    }
+    
+    uint32_t task_us = 0;
+    TaskHandle_t task = entry->task_handle;
+    if (task != NULL) {
+        uint32_t counter = (uint32_t)ulTaskGetRunTimeCounter(task);
+        if (task == cpu->task) {
+            task_us = counter - cpu->task_counter;
+        }
+        cpu->task_counter = counter;
+    }
+    cpu->task = task;
+    
+    uint64_t handler_total = handler_monitor_get_total_time(entry->info.service_id);
+    uint32_t handler_us = (uint32_t)(handler_total - cpu->handler_us);
+    cpu->handler_us = handler_total;
+    cpu->sampled_us = now_us;
+    
+    uint64_t percent = ((uint64_t)task_us + handler_us) * 100 / (uint64_t)period_us;
+    if (percent > 100) {
+        percent = 100;     // Handlers on other cores overlap the task
+    }
+    
+    entry->info.cpu_task_us = task_us;
+    entry->info.cpu_handler_us = handler_us;
+    entry->info.cpu_percent = (uint8_t)percent;
+    
+    uint32_t budget = budget_of(entry);
+    bool limited = budget > 0 && budget < 100;
+    
+    if (!cpu->throttled && limited && percent > budget) {
+        throttle(entry, (uint32_t)percent);
+    } else if (cpu->throttled && (!limited || percent <= budget)) {
+        unthrottle(entry);
+        ESP_LOGI(TAG, "App '%s' back within budget", entry->info.manifest.name);
+    }
+}
+
+static void sample_cb(void *arg)
+{
+    app_registry_t *registry = app_get_registry();
+    
+    // Never hold up the timer task
+    if (xSemaphoreTake(registry->mutex, 0) != pdTRUE) {
+        return;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < APP_REGISTRY_MAX_ENTRIES; i++) {
+        app_registry_entry_t *entry = &registry->entries[i];
+        if (!entry->registered) {
+            continue;
+        }
+        app_state_t state = entry->info.state;
+        if (state == APP_STATE_RUNNING || state == APP_STATE_PAUSED || state == APP_STATE_HIBERNATED) {
+            sample_entry(entry, now_us);
+        }
+    }
+    
+    xSemaphoreGive(registry->mutex);
+}
+
+esp_err_t app_cpu_init(void)
+{
+    if (s_timer != NULL) {
+        return ESP_OK;
+    }
+    
+    const esp_timer_create_args_t args = {
+        .callback = sample_cb,
+        .name = "app_cpu",
+    };
+    esp_err_t ret = esp_timer_create(&args, &s_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(s_timer, PERIOD_US);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start CPU sampler: %s", esp_err_to_name(ret));
+        if (s_timer != NULL) {
+            esp_timer_delete(s_timer);
+            s_timer = NULL;
+        }
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "App CPU accounting every %d ms, default budget %d%%",
+             CONFIG_SYSTEM_SERVICE_APP_CPU_PERIOD_MS, CONFIG_SYSTEM_SERVICE_APP_CPU_BUDGET_PERCENT);
+    return ESP_OK;
+}
+
+void app_cpu_start(app_registry_entry_t *entry)
+{
+    app_cpu_stop(entry);
+    
+    app_cpu_account_t *cpu = &entry->cpu;
+    cpu->task = NULL;
+    cpu->task_counter = 0;
+    cpu->handler_us = handler_monitor_get_total_time(entry->info.service_id);
+    cpu->sampled_us = esp_timer_get_time();
+    
+    entry->info.cpu_task_us = 0;
+    entry->info.cpu_handler_us = 0;
+    entry->info.cpu_percent = 0;
+}
+
+void app_cpu_stop(app_registry_entry_t *entry)
+{
+    if (entry->cpu.throttled) {
+        unthrottle(entry);
+    }
+}
+
+#else
+
+esp_err_t app_cpu_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_cpu_start(app_registry_entry_t *entry)
+{
+    (void)entry;
+}
+
+void app_cpu_stop(app_registry_entry_t *entry)
+{
+    (void)entry;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_APP_CPU_ACCOUNTING
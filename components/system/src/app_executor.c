@@ -0,0 +1,325 @@
+/**
+ * @file app_executor.c
+ * @brief App worker pool implementation
+ *
+ * Each worker blocks on its task notification until it is handed an
+ * entry. A stop waits on the worker's done semaphore, which the worker
+ * gives only when someone is waiting, so no stale give can end a later
+ * wait early. An entry that ignores its exit function is killed; since
+ * it is suspended and off the CPU first, vTaskDelete() releases the TCB
+ * at once and the worker can be re-created on the same storage.
+ *
+ * Large stacks go to PSRAM when allowed. A task on a PSRAM stack must not
+ * write flash, which is why only the large class is placed there.
+ */
+
+#include "app_executor.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "app_executor";
+
+/* ============================================================================
+ * Worker Pool
+ * ============================================================================ */
+
+#define SMALL_WORKERS               CONFIG_SYSTEM_SERVICE_APP_WORKERS_SMALL
+#define MEDIUM_WORKERS              CONFIG_SYSTEM_SERVICE_APP_WORKERS_MEDIUM
+#define LARGE_WORKERS               CONFIG_SYSTEM_SERVICE_APP_WORKERS_LARGE
+#define TOTAL_WORKERS               (SMALL_WORKERS + MEDIUM_WORKERS + LARGE_WORKERS)
+
+#define SMALL_STACK_WORDS           (CONFIG_SYSTEM_SERVICE_APP_SMALL_STACK / sizeof(StackType_t))
+#define MEDIUM_STACK_WORDS          (CONFIG_SYSTEM_SERVICE_APP_MEDIUM_STACK / sizeof(StackType_t))
+#define LARGE_STACK_WORDS           (CONFIG_SYSTEM_SERVICE_APP_LARGE_STACK / sizeof(StackType_t))
+
+#if CONFIG_SYSTEM_SERVICE_APP_LARGE_STACK_PSRAM
+#define LARGE_STACK_ATTR            EXT_RAM_BSS_ATTR
+#define LARGE_STACK_PSRAM           1
+#else
+#define LARGE_STACK_ATTR
+#define LARGE_STACK_PSRAM           0
+#endif
+
+_Static_assert(TOTAL_WORKERS > 0, "At least one app worker is needed");
+
+typedef struct {
+    TaskHandle_t task;
+    StaticTask_t tcb;
+    StackType_t *stack;
+    uint32_t stack_size;            // Bytes
+    app_stack_class_t stack_class;
+    BaseType_t core;
+    char name[configMAX_TASK_NAME_LEN];
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_storage;
+    app_registry_entry_t *job;      // Running entry, NULL when idle
+    bool stopping;                  // A stop waits on done
+} app_worker_t;
+
+#if SMALL_WORKERS > 0
+static StackType_t s_small_stacks[SMALL_WORKERS][SMALL_STACK_WORDS];
+#endif
+#if MEDIUM_WORKERS > 0
+static StackType_t s_medium_stacks[MEDIUM_WORKERS][MEDIUM_STACK_WORDS];
+#endif
+#if LARGE_WORKERS > 0
+LARGE_STACK_ATTR static StackType_t s_large_stacks[LARGE_WORKERS][LARGE_STACK_WORDS];
+#endif
+
+static app_worker_t s_workers[TOTAL_WORKERS];
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_started = false;
+
+static const char *const class_names[APP_STACK_CLASS_COUNT] = {
+    [APP_STACK_MEDIUM] = "medium",
+    [APP_STACK_SMALL] = "small",
+    [APP_STACK_LARGE] = "large",
+};
+
+// Fallback order: a busy class borrows from the next larger one
+static const app_stack_class_t class_order[APP_STACK_CLASS_COUNT] = {
+    APP_STACK_SMALL, APP_STACK_MEDIUM, APP_STACK_LARGE,
+};
+
+/* ============================================================================
+ * Worker Task
+ * ============================================================================ */
+
+static void app_worker_task(void *arg)
+{
+    app_worker_t *worker = (app_worker_t *)arg;
+    
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        app_registry_entry_t *entry = worker->job;
+        if (entry == NULL) {
+            continue;
+        }
+    
+        ESP_LOGI(TAG, "Starting app '%s' on %s", entry->info.manifest.name, worker->name);
+    
+        esp_err_t ret = entry->info.manifest.entry(&entry->context);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "App '%s' entry failed: %s",
+                     entry->info.manifest.name, esp_err_to_name(ret));
+            entry->info.state = APP_STATE_ERROR;
+        }
+    
+        ESP_LOGI(TAG, "App '%s' task finished", entry->info.manifest.name);
+    
+        bool notify;
+        portENTER_CRITICAL(&s_pool_lock);
+        entry->task_handle = NULL;
+        worker->job = NULL;
+        notify = worker->stopping;
+        worker->stopping = false;
+        portEXIT_CRITICAL(&s_pool_lock);
+    
+        if (notify) {
+            xSemaphoreGive(worker->done);
+        }
+    }
+}
+
+static esp_err_t worker_spawn(app_worker_t *worker)
+{
+    worker->task = xTaskCreateStaticPinnedToCore(app_worker_task,
+                                                 worker->name,
+                                                 worker->stack_size,
+                                                 worker,
+                                                 CONFIG_SYSTEM_SERVICE_APP_WORKER_PRIORITY,
+                                                 worker->stack,
+                                                 &worker->tcb,
+                                                 worker->core);
+    return (worker->task != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void worker_setup(app_worker_t *worker, int index, app_stack_class_t stack_class,
+                         StackType_t *stack, uint32_t stack_size)
+{
+    memset(worker, 0, sizeof(*worker));
+    worker->stack = stack;
+    worker->stack_size = stack_size;
+    worker->stack_class = stack_class;
+    worker->core = index % portNUM_PROCESSORS;
+    snprintf(worker->name, sizeof(worker->name), "app_%c%d", class_names[stack_class][0], index);
+    worker->done = xSemaphoreCreateBinaryStatic(&worker->done_storage);
+}
+
+/* Take the entry off its worker for good: suspend, wait until it left the CPU, delete */
+static void worker_kill(app_worker_t *worker)
+{
+    vTaskSuspend(worker->task);
+    while (eTaskGetState(worker->task) == eRunning) {
+        vTaskDelay(1);
+    }
+    vTaskDelete(worker->task);
+    
+    portENTER_CRITICAL(&s_pool_lock);
+    if (worker->job != NULL) {
+        worker->job->task_handle = NULL;
+    }
+    worker->job = NULL;
+    worker->stopping = false;
+    portEXIT_CRITICAL(&s_pool_lock);
+    
+    if (worker_spawn(worker) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to re-create %s", worker->name);
+    }
+}
+
+static app_worker_t* worker_of(const app_registry_entry_t *entry)
+{
+    for (int i = 0; i < TOTAL_WORKERS; i++) {
+        if (s_workers[i].job == entry) {
+            return &s_workers[i];
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t app_executor_init(void)
+{
+    if (s_started) {
+        return ESP_OK;
+    }
+    
+    int index = 0;
+#if SMALL_WORKERS > 0
+    for (int i = 0; i < SMALL_WORKERS; i++, index++) {
+        worker_setup(&s_workers[index], index, APP_STACK_SMALL,
+                     s_small_stacks[i], sizeof(s_small_stacks[i]));
+    }
+#endif
+#if MEDIUM_WORKERS > 0
+    for (int i = 0; i < MEDIUM_WORKERS; i++, index++) {
+        worker_setup(&s_workers[index], index, APP_STACK_MEDIUM,
+                     s_medium_stacks[i], sizeof(s_medium_stacks[i]));
+    }
+#endif
+#if LARGE_WORKERS > 0
+    for (int i = 0; i < LARGE_WORKERS; i++, index++) {
+        worker_setup(&s_workers[index], index, APP_STACK_LARGE,
+                     s_large_stacks[i], sizeof(s_large_stacks[i]));
+    }
+#endif
+    
+    for (int i = 0; i < TOTAL_WORKERS; i++) {
+        esp_err_t ret = worker_spawn(&s_workers[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create %s", s_workers[i].name);
+            for (int j = 0; j < i; j++) {
+                vTaskDelete(s_workers[j].task);
+                s_workers[j].task = NULL;
+            }
+            return ret;
+        }
+    }
+    
+    s_started = true;
+    ESP_LOGI(TAG, "✓ %d app workers: %d x %d B, %d x %d B, %d x %d B%s",
+             TOTAL_WORKERS, SMALL_WORKERS, CONFIG_SYSTEM_SERVICE_APP_SMALL_STACK,
+             MEDIUM_WORKERS, CONFIG_SYSTEM_SERVICE_APP_MEDIUM_STACK,
+             LARGE_WORKERS, CONFIG_SYSTEM_SERVICE_APP_LARGE_STACK,
+             LARGE_STACK_PSRAM ? ", large in PSRAM" : "");
+    return ESP_OK;
+}
+
+esp_err_t app_executor_start(app_registry_entry_t *entry)
+{
+    if (!s_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    app_stack_class_t wanted = entry->info.manifest.stack_class;
+    if (wanted >= APP_STACK_CLASS_COUNT) {
+        wanted = APP_STACK_MEDIUM;
+    }
+    
+    // Claim the first idle worker of the class or, failing that, a larger one
+    app_worker_t *worker = NULL;
+    bool eligible = false;
+    portENTER_CRITICAL(&s_pool_lock);
+    for (int c = 0; c < APP_STACK_CLASS_COUNT && worker == NULL; c++) {
+        if (class_order[c] == wanted) {
+            eligible = true;
+        }
+        if (!eligible) {
+            continue;
+        }
+        for (int i = 0; i < TOTAL_WORKERS; i++) {
+            app_worker_t *candidate = &s_workers[i];
+            if (candidate->stack_class == class_order[c] && candidate->job == NULL &&
+                candidate->task != NULL) {
+                worker = candidate;
+                worker->job = entry;
+                entry->task_handle = worker->task;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_pool_lock);
+    
+    if (worker == NULL) {
+        ESP_LOGE(TAG, "No idle worker for app '%s' (%s stack)",
+                 entry->info.manifest.name, class_names[wanted]);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // A throttled app may have left the worker at a lower priority
+    vTaskPrioritySet(worker->task, CONFIG_SYSTEM_SERVICE_APP_WORKER_PRIORITY);
+    xTaskNotifyGive(worker->task);
+    return ESP_OK;
+}
+
+void app_executor_stop(app_registry_entry_t *entry)
+{
+    portENTER_CRITICAL(&s_pool_lock);
+    app_worker_t *worker = worker_of(entry);
+    if (worker != NULL) {
+        worker->stopping = true;
+    }
+    portEXIT_CRITICAL(&s_pool_lock);
+    
+    if (worker == NULL) {
+        return;
+    }
+    
+    // An app stopping itself finishes when its entry returns
+    if (worker->task == xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    
+    // A paused app has to run to see its exit flag. Only then: resuming a
+    // task blocked without timeout would wake it.
+    if (entry->info.state == APP_STATE_PAUSED || entry->info.state == APP_STATE_HIBERNATED) {
+        vTaskResume(worker->task);
+    }
+    
+    if (xSemaphoreTake(worker->done, pdMS_TO_TICKS(CONFIG_SYSTEM_SERVICE_APP_STOP_TIMEOUT_MS)) == pdTRUE) {
+        return;
+    }
+    
+    bool running;
+    portENTER_CRITICAL(&s_pool_lock);
+    running = (worker->job == entry);
+    portEXIT_CRITICAL(&s_pool_lock);
+    
+    if (running) {
+        ESP_LOGW(TAG, "App '%s' did not return within %d ms, killing %s",
+                 entry->info.manifest.name, CONFIG_SYSTEM_SERVICE_APP_STOP_TIMEOUT_MS, worker->name);
+        worker_kill(worker);
+    } else {
+        // Returned just after the timeout; its give is on the way
+        xSemaphoreTake(worker->done, portMAX_DELAY);
+    }
+}
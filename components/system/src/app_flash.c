@@ -0,0 +1,562 @@
+/**
+ * @file app_flash.c
+ * @brief Execute-in-place loading of apps from a flash partition
+ *
+ * The image's .text and .rodata are mapped straight from the partition
+ * through the MMU, into the instruction and the data cache respectively;
+ * a 2 MB app costs 32 page table entries and no copy. Only .data is read
+ * into PSRAM, .bss is zeroed after it, and the relocation table patches
+ * the absolute addresses in .data to the load addresses of the sections.
+ *
+ * Loader state lives in a static table with one slot per app, claimed
+ * under a spinlock so flash_app_load() works before the app manager is up.
+ *
+ * Relocated .data is cached in PSRAM, keyed by the header CRC and the
+ * three load addresses the relocations depend on. A flash app restarts
+ * from its initial .data, which on a hit is one memcpy instead of a flash
+ * read and a relocation pass; reloading an unloaded app hits too when the
+ * MMU and the heap hand out the same addresses again. Entries are pinned
+ * while copied from, so the spinlock is never held across a copy.
+ */
+
+#include "system_service/app_manager.h"
+#include "app_internal.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "app_flash";
+
+/* ============================================================================
+ * Loader State
+ * ============================================================================ */
+
+#define RELOC_BATCH                 64      // Entries read per flash access
+#define VERIFY_CHUNK                4096
+#define CACHE_ENTRIES               CONFIG_SYSTEM_SERVICE_APP_IMAGE_CACHE_ENTRIES
+
+typedef struct {
+    bool in_use;
+    const esp_partition_t *partition;
+    esp_partition_mmap_handle_t text_handle;
+    esp_partition_mmap_handle_t rodata_handle;
+    const void *text;               // Instruction bus address
+    const void *rodata;             // Data bus address
+    void *data;                     // .data then .bss, PSRAM
+    size_t data_size;               // Including .bss
+    size_t offset;                  // Of the image in the partition
+    uint32_t crc32;
+    app_image_layout_t layout;
+    bool started;                   // .data no longer initial
+} flash_image_t;
+
+typedef struct {
+    // Key
+    uint32_t crc32;
+    const void *text;
+    const void *rodata;
+    const void *data;
+    // Relocated .data, without .bss
+    uint8_t *copy;
+    size_t size;
+    uint32_t last_use;
+    uint8_t pins;
+} image_cache_entry_t;
+
+static flash_image_t s_images[APP_MAX_APPS];
+static portMUX_TYPE s_images_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CACHE_ENTRIES > 0
+static image_cache_entry_t s_cache[CACHE_ENTRIES];
+static uint32_t s_cache_clock;
+static portMUX_TYPE s_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static flash_image_t* image_claim(void)
+{
+    flash_image_t *image = NULL;
+    
+    portENTER_CRITICAL(&s_images_lock);
+    for (int i = 0; i < APP_MAX_APPS; i++) {
+        if (!s_images[i].in_use) {
+            image = &s_images[i];
+            memset(image, 0, sizeof(*image));
+            image->in_use = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_images_lock);
+    
+    return image;
+}
+
+static void image_release(flash_image_t *image)
+{
+    if (image->text != NULL) {
+        esp_partition_munmap(image->text_handle);
+    }
+    if (image->rodata != NULL) {
+        esp_partition_munmap(image->rodata_handle);
+    }
+    heap_caps_free(image->data);
+    
+    portENTER_CRITICAL(&s_images_lock);
+    memset(image, 0, sizeof(*image));
+    portEXIT_CRITICAL(&s_images_lock);
+}
+
+/* Section [offset, offset + size) lies inside the image */
+static bool section_valid(uint32_t offset, uint32_t size, uint32_t image_size)
+{
+    return offset <= image_size && size <= image_size - offset;
+}
+
+static esp_err_t layout_check(const app_header_t *header, const app_image_layout_t *layout)
+{
+    uint32_t image_size = sizeof(app_header_t) + header->size;
+    if (header->size < sizeof(app_image_layout_t) || image_size < header->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    if (layout->text_size == 0 ||
+        (layout->text_offset & 3) != 0 || (layout->rodata_offset & 3) != 0 ||
+        !section_valid(layout->text_offset, layout->text_size, image_size) ||
+        !section_valid(layout->rodata_offset, layout->rodata_size, image_size) ||
+        !section_valid(layout->data_offset, layout->data_size, image_size) ||
+        layout->reloc_count > (image_size / sizeof(uint32_t)) ||
+        !section_valid(layout->reloc_offset, layout->reloc_count * sizeof(uint32_t), image_size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    // Entry and exit must land inside .text
+    if (header->entry_point >= layout->text_size ||
+        (layout->exit_point != APP_IMAGE_NO_EXIT && layout->exit_point >= layout->text_size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    if (layout->bss_size > SIZE_MAX - layout->data_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+#if CONFIG_SYSTEM_SERVICE_FLASH_APP_VERIFY
+/* CRC of the image after the header, as app_header_t.crc32 covers it */
+static esp_err_t image_verify(const esp_partition_t *partition, size_t offset, const app_header_t *header)
+{
+    uint8_t *buf = heap_caps_malloc(VERIFY_CHUNK, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    uint32_t crc = 0;
+    esp_err_t ret = ESP_OK;
+    size_t base = offset + sizeof(app_header_t);
+    for (uint32_t pos = 0; pos < header->size && ret == ESP_OK; pos += VERIFY_CHUNK) {
+        uint32_t n = header->size - pos;
+        if (n > VERIFY_CHUNK) {
+            n = VERIFY_CHUNK;
+        }
+        ret = esp_partition_read(partition, base + pos, buf, n);
+        crc = esp_rom_crc32_le(crc, buf, n);
+    }
+    
+    heap_caps_free(buf);
+    if (ret == ESP_OK && crc != header->crc32) {
+        ESP_LOGE(TAG, "CRC mismatch: image 0x%08lx, header 0x%08lx",
+                 (unsigned long)crc, (unsigned long)header->crc32);
+        ret = ESP_ERR_INVALID_CRC;
+    }
+    return ret;
+}
+#endif
+
+/* Map one read-only section in place; empty sections map nothing */
+static esp_err_t section_map(flash_image_t *image, size_t offset, uint32_t size,
+                             esp_partition_mmap_memory_t memory,
+                             const void **out_ptr, esp_partition_mmap_handle_t *out_handle)
+{
+    if (size == 0) {
+        *out_ptr = NULL;
+        return ESP_OK;
+    }
+    return esp_partition_mmap(image->partition, offset, size, memory, out_ptr, out_handle);
+}
+
+/* Add the section load addresses to the .data words the table lists */
+static esp_err_t data_relocate(flash_image_t *image, size_t offset, const app_image_layout_t *layout)
+{
+    const uintptr_t bases[] = {
+        [APP_RELOC_TEXT] = (uintptr_t)image->text,
+        [APP_RELOC_RODATA] = (uintptr_t)image->rodata,
+        [APP_RELOC_DATA] = (uintptr_t)image->data,
+    };
+    uint32_t relocs[RELOC_BATCH];
+    
+    for (uint32_t done = 0; done < layout->reloc_count; ) {
+        uint32_t n = layout->reloc_count - done;
+        if (n > RELOC_BATCH) {
+            n = RELOC_BATCH;
+        }
+        esp_err_t ret = esp_partition_read(image->partition,
+                                           offset + layout->reloc_offset + done * sizeof(uint32_t),
+                                           relocs, n * sizeof(uint32_t));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t target = relocs[i] >> APP_RELOC_TARGET_SHIFT;
+            uint32_t word = relocs[i] & APP_RELOC_OFFSET_MASK;
+            if (target > APP_RELOC_DATA || (word & 3) != 0 ||
+                (size_t)word + sizeof(uint32_t) > layout->data_size) {
+                ESP_LOGE(TAG, "Bad relocation %lu: 0x%08lx",
+                         (unsigned long)(done + i), (unsigned long)relocs[i]);
+                return ESP_ERR_INVALID_SIZE;
+            }
+            uint32_t *slot = (uint32_t *)((uint8_t *)image->data + word);
+            *slot += (uint32_t)bases[target];
+        }
+        done += n;
+    }
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * Relocated Image Cache
+ * ============================================================================ */
+
+#if CACHE_ENTRIES > 0
+static bool cache_key_match(const image_cache_entry_t *entry, const flash_image_t *image)
+{
+    return entry->copy != NULL && entry->crc32 == image->crc32 &&
+           entry->text == image->text && entry->rodata == image->rodata &&
+           entry->data == image->data && entry->size == image->layout.data_size;
+}
+
+/* Copy a cached .data into the image; false on a miss */
+static bool cache_restore(flash_image_t *image)
+{
+    image_cache_entry_t *hit = NULL;
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        if (cache_key_match(&s_cache[i], image)) {
+            hit = &s_cache[i];
+            hit->pins++;
+            hit->last_use = ++s_cache_clock;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    if (hit == NULL) {
+        return false;
+    }
+    
+    memcpy(image->data, hit->copy, hit->size);
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    hit->pins--;
+    portEXIT_CRITICAL(&s_cache_lock);
+    return true;
+}
+
+/* Keep the freshly relocated .data, evicting the least recently used entry */
+static void cache_store(const flash_image_t *image)
+{
+    uint8_t *copy = heap_caps_malloc(image->layout.data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (copy == NULL) {
+        return;
+    }
+    memcpy(copy, image->data, image->layout.data_size);
+    
+    image_cache_entry_t *slot = NULL;
+    uint8_t *evicted = NULL;
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    for (int i = 0; i < CACHE_ENTRIES; i++) {
+        image_cache_entry_t *entry = &s_cache[i];
+        if (cache_key_match(entry, image)) {
+            // Stored by a concurrent load of the same addresses
+            slot = NULL;
+            break;
+        }
+        if (entry->pins > 0) {
+            continue;
+        }
+        if (slot == NULL || entry->copy == NULL ||
+            (slot->copy != NULL && entry->last_use < slot->last_use)) {
+            slot = entry;
+        }
+    }
+    if (slot != NULL) {
+        evicted = slot->copy;
+        slot->crc32 = image->crc32;
+        slot->text = image->text;
+        slot->rodata = image->rodata;
+        slot->data = image->data;
+        slot->copy = copy;
+        slot->size = image->layout.data_size;
+        slot->last_use = ++s_cache_clock;
+        copy = NULL;
+    }
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    heap_caps_free(evicted);
+    heap_caps_free(copy);
+}
+#endif
+
+/* Bring .data and .bss to their initial state, from the cache if possible */
+static esp_err_t data_init(flash_image_t *image, app_info_t *info)
+{
+    int64_t start_us = esp_timer_get_time();
+    const app_image_layout_t *layout = &image->layout;
+    
+    if (image->data_size == 0) {
+        return ESP_OK;
+    }
+    memset((uint8_t *)image->data + layout->data_size, 0, layout->bss_size);
+    
+    // A CRC of 0 means the image was built without one: nothing to key on
+    bool cacheable = CACHE_ENTRIES > 0 && image->crc32 != 0 && layout->data_size > 0;
+    bool hit = false;
+#if CACHE_ENTRIES > 0
+    if (cacheable) {
+        hit = cache_restore(image);
+    }
+#endif
+    
+    if (!hit) {
+        esp_err_t ret = esp_partition_read(image->partition, image->offset + layout->data_offset,
+                                           image->data, layout->data_size);
+        if (ret == ESP_OK) {
+            ret = data_relocate(image, image->offset, layout);
+        }
+        if (ret != ESP_OK) {
+            return ret;
+        }
+#if CACHE_ENTRIES > 0
+        if (cacheable) {
+            cache_store(image);
+        }
+#endif
+    }
+    
+    if (cacheable) {
+        if (hit) {
+            info->cache_hits++;
+        } else {
+            info->cache_misses++;
+        }
+    }
+    info->load_time_us = (uint32_t)(esp_timer_get_time() - start_us);
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t flash_app_load(const char *partition_label, size_t offset, app_info_t *info)
+{
+    if (partition_label == NULL || info == NULL || (offset & 3) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY,
+                                                                partition_label);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    struct {
+        app_header_t header;
+        app_image_layout_t layout;
+    } head;
+    if (offset > partition->size || partition->size - offset < sizeof(head)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = esp_partition_read(partition, offset, &head, sizeof(head));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    if (head.header.magic != APP_MAGIC_NUMBER) {
+        ESP_LOGE(TAG, "No app at %s+0x%x (magic 0x%08lx)", partition_label,
+                 (unsigned)offset, (unsigned long)head.header.magic);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    head.header.name[APP_MAX_NAME_LEN - 1] = '\0';
+    head.header.version[APP_MAX_VERSION_LEN - 1] = '\0';
+    head.header.author[APP_MAX_AUTHOR_LEN - 1] = '\0';
+    
+    ret = layout_check(&head.header, &head.layout);
+    if (ret == ESP_OK && partition->size - offset < sizeof(app_header_t) + head.header.size) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "App '%s' has a bad layout", head.header.name);
+        return ret;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_FLASH_APP_VERIFY
+    ret = image_verify(partition, offset, &head.header);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+#endif
+    
+    flash_image_t *image = image_claim();
+    if (image == NULL) {
+        ESP_LOGE(TAG, "No loader slot for '%s'", head.header.name);
+        return ESP_ERR_NO_MEM;
+    }
+    image->partition = partition;
+    image->offset = offset;
+    image->crc32 = head.header.crc32;
+    image->layout = head.layout;
+    
+    // Code and constants stay in flash: page table entries only
+    ret = section_map(image, offset + head.layout.text_offset, head.layout.text_size,
+                      ESP_PARTITION_MMAP_INST, &image->text, &image->text_handle);
+    if (ret == ESP_OK) {
+        ret = section_map(image, offset + head.layout.rodata_offset, head.layout.rodata_size,
+                          ESP_PARTITION_MMAP_DATA, &image->rodata, &image->rodata_handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map '%s': %s", head.header.name, esp_err_to_name(ret));
+        image_release(image);
+        return ret;
+    }
+    
+    // Writable state is all that is copied
+    image->data_size = head.layout.data_size + head.layout.bss_size;
+    if (image->data_size > 0) {
+        image->data = heap_caps_aligned_alloc(8, image->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (image->data == NULL) {
+            ESP_LOGE(TAG, "No PSRAM for %u bytes of data of '%s'",
+                     (unsigned)image->data_size, head.header.name);
+            image_release(image);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    memset(info, 0, sizeof(*info));
+    ret = data_init(image, info);
+    if (ret != ESP_OK) {
+        image_release(image);
+        return ret;
+    }
+    
+    strlcpy(info->manifest.name, head.header.name, sizeof(info->manifest.name));
+    strlcpy(info->manifest.version, head.header.version, sizeof(info->manifest.version));
+    strlcpy(info->manifest.author, head.header.author, sizeof(info->manifest.author));
+    info->manifest.entry = (app_entry_fn_t)((uintptr_t)image->text + head.header.entry_point);
+    if (head.layout.exit_point != APP_IMAGE_NO_EXIT) {
+        info->manifest.exit = (app_exit_fn_t)((uintptr_t)image->text + head.layout.exit_point);
+    }
+    info->state = APP_STATE_LOADED;
+    info->source = APP_SOURCE_FLASH;
+    info->is_dynamic = true;
+    info->app_data = image->data;
+    info->app_size = image->data_size;
+    info->image = image;
+    
+    ESP_LOGI(TAG, "✓ Mapped '%s' v%s: %lu B code, %lu B rodata in place, %u B data, %lu relocs, "
+             "%lu us%s", head.header.name, head.header.version, (unsigned long)head.layout.text_size,
+             (unsigned long)head.layout.rodata_size, (unsigned)image->data_size,
+             (unsigned long)head.layout.reloc_count, (unsigned long)info->load_time_us,
+             info->cache_hits > 0 ? " (cached)" : "");
+    
+    return ESP_OK;
+}
+
+esp_err_t flash_app_unload(app_info_t *info)
+{
+    if (info == NULL || info->image == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    flash_image_t *image = (flash_image_t *)info->image;
+    if (image < s_images || image >= s_images + APP_MAX_APPS || !image->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    image_release(image);
+    info->image = NULL;
+    info->app_data = NULL;
+    info->app_size = 0;
+    info->manifest.entry = NULL;
+    info->manifest.exit = NULL;
+    info->state = APP_STATE_UNLOADED;
+    return ESP_OK;
+}
+
+esp_err_t flash_app_restart(app_info_t *info)
+{
+    flash_image_t *image = (flash_image_t *)info->image;
+    if (image == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // The first start runs on the .data the load prepared
+    if (!image->started) {
+        image->started = true;
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = data_init(image, info);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to reset data of '%s': %s", info->manifest.name, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t app_manager_load_dynamic_from_partition(const char *partition_label, size_t offset, app_info_t **out_info)
+{
+    app_info_t loaded;
+    esp_err_t ret = flash_app_load(partition_label, offset, &loaded);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // The app sees its data block through its manifest as well
+    loaded.manifest.user_data = loaded.app_data;
+    
+    app_info_t *info = NULL;
+    ret = app_manager_register_app(&loaded.manifest, &info);
+    if (ret != ESP_OK) {
+        flash_app_unload(&loaded);
+        return ret;
+    }
+    
+    // Registration files every app as built in; record where this one lives
+    if (app_registry_lock() == ESP_OK) {
+        info->source = APP_SOURCE_FLASH;
+        info->is_dynamic = true;
+        info->app_data = loaded.app_data;
+        info->app_size = loaded.app_size;
+        info->image = loaded.image;
+        info->cache_hits = loaded.cache_hits;
+        info->cache_misses = loaded.cache_misses;
+        info->load_time_us = loaded.load_time_us;
+        app_registry_unlock();
+    }
+    
+    if (out_info != NULL) {
+        *out_info = info;
+    }
+    return ESP_OK;
+}
@@ -1,13 +1,30 @@
 #include "system_service/app_manager.h"
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "system_service/common_events.h"
 #include "app_internal.h"
+#include "app_executor.h"
+#include "app_cpu.h"
+#include "app_lifecycle.h"
+#include "event_dispatch.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include <stddef.h>
 #include <string.h>
 
 static const char *TAG = "app_manager";
 static app_registry_t g_app_registry = {0};
+static const app_audio_ops_t *s_audio_ops = NULL;
+SYSTEM_MUTEX_DEFINE(s_registry_mutex);
+
+#define HIBERNATE_STATE_MAX     CONFIG_SYSTEM_SERVICE_APP_HIBERNATE_STATE_MAX
+
+// Hibernate callbacks write here first, under the registry lock; only the
+// bytes actually written are kept
+EXT_RAM_BSS_ATTR static uint8_t s_hibernate_scratch[HIBERNATE_STATE_MAX > 0 ? HIBERNATE_STATE_MAX : 1];
 
 app_registry_t* app_get_registry(void)
 {
@@ -53,29 +70,38 @@ app_registry_entry_t* app_find_by_name(const char *name)
     return NULL;
 }
 
-static void app_task_wrapper(void *pvParameters)
+static app_registry_entry_t* entry_from_context(app_context_t *ctx)
 {
-    app_registry_entry_t *entry = (app_registry_entry_t *)pvParameters;
-    
-    if (entry == NULL || entry->info.manifest.entry == NULL) {
-        vTaskDelete(NULL);
-        return;
+    return (app_registry_entry_t *)((uint8_t *)ctx - offsetof(app_registry_entry_t, context));
+}
+
+static void* app_ctx_arena_alloc(app_context_t *ctx, size_t size)
+{
+    if (ctx == NULL) {
+        return NULL;
     }
-    
-    ESP_LOGI(TAG, "Starting app '%s'...", entry->info.manifest.name);
-    
-    esp_err_t ret = entry->info.manifest.entry(&entry->context);
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "App '%s' entry failed: %s", 
-                 entry->info.manifest.name, esp_err_to_name(ret));
-        entry->info.state = APP_STATE_ERROR;
+    return app_arena_alloc(&entry_from_context(ctx)->arena, size);
+}
+
+static void* app_ctx_arena_calloc(app_context_t *ctx, size_t count, size_t size)
+{
+    if (ctx == NULL || (size != 0 && count > SIZE_MAX / size)) {
+        return NULL;
     }
     
-    ESP_LOGI(TAG, "App '%s' task finished", entry->info.manifest.name);
-    
-    entry->task_handle = NULL;
-    vTaskDelete(NULL);
+    void *ptr = app_arena_alloc(&entry_from_context(ctx)->arena, count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+static size_t app_ctx_arena_used(app_context_t *ctx)
+{
+    if (ctx == NULL) {
+        return 0;
+    }
+    return app_arena_used(&entry_from_context(ctx)->arena);
 }
 
 esp_err_t app_manager_init(void)
@@ -89,25 +115,47 @@ esp_err_t app_manager_init(void)
     
     memset(&g_app_registry, 0, sizeof(app_registry_t));
     
-    g_app_registry.mutex = xSemaphoreCreateMutex();
+    g_app_registry.mutex = SYSTEM_MUTEX_CREATE(s_registry_mutex);
     if (g_app_registry.mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create mutex");
         return ESP_ERR_NO_MEM;
     }
     
+    esp_err_t ret = app_executor_init();
+    if (ret != ESP_OK) {
+        vSemaphoreDelete(g_app_registry.mutex);
+        g_app_registry.mutex = NULL;
+        return ret;
+    }
+    
+    ret = app_cpu_init();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Apps run without CPU accounting");
+    }
+    
     g_app_registry.initialized = true;
     
-    ESP_LOGI(TAG, "✓ App manager initialized (static apps only)");
+    ESP_LOGI(TAG, "✓ App manager initialized (static and flash apps)");
     
     return ESP_OK;
 }
 
+void app_manager_set_audio_ops(const app_audio_ops_t *ops)
+{
+    s_audio_ops = ops;
+}
+
 esp_err_t app_manager_register_app(const app_manifest_t *manifest, app_info_t **out_info)
 {
     if (manifest == NULL || manifest->name[0] == '\0') {
         return ESP_ERR_INVALID_ARG;
     }
     
+    if (manifest->hibernate != NULL && manifest->restore == NULL) {
+        ESP_LOGE(TAG, "App '%s' can hibernate but not restore", manifest->name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     esp_err_t ret = app_registry_lock();
     if (ret != ESP_OK) {
         return ret;
@@ -163,6 +211,14 @@ esp_err_t app_manager_register_app(const app_manifest_t *manifest, app_info_t **
     entry->context.unsubscribe_event = system_event_unsubscribe;
     entry->context.register_event_type = system_event_register_type;
     
+    // Arena APIs
+    entry->context.arena_alloc = app_ctx_arena_alloc;
+    entry->context.arena_calloc = app_ctx_arena_calloc;
+    entry->context.arena_used = app_ctx_arena_used;
+    
+    // Audio API, if the audio service is up
+    entry->context.audio = s_audio_ops;
+    
     // Register with system service (apps are visible to system)
     ret = system_service_register(manifest->name, entry, &entry->info.service_id);
     if (ret != ESP_OK) {
@@ -171,6 +227,14 @@ esp_err_t app_manager_register_app(const app_manifest_t *manifest, app_info_t **
         return ret;
     }
     
+    ret = app_arena_init(&entry->arena, entry->info.service_id);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create arena for app '%s'", manifest->name);
+        system_service_unregister(entry->info.service_id);
+        app_registry_unlock();
+        return ret;
+    }
+    
     // Update context with actual service ID
     entry->context.service_id = entry->info.service_id;
     entry->registered = true;
@@ -212,29 +276,40 @@ esp_err_t app_manager_start_app(const char *app_name)
         return ESP_OK;
     }
     
+    if (entry->info.state == APP_STATE_PAUSED || entry->info.state == APP_STATE_HIBERNATED) {
+        ESP_LOGW(TAG, "App '%s' is paused, resume it instead", app_name);
+        app_registry_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    
     if (entry->info.manifest.entry == NULL) {
         ESP_LOGE(TAG, "App '%s' has no entry function", app_name);
         app_registry_unlock();
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Create task for the app
-    BaseType_t task_ret = xTaskCreate(
-        app_task_wrapper,
-        app_name,
-        4096,  // Stack size
-        entry,
-        5,     // Priority
-        &entry->task_handle
-    );
+    // The audio service may have come up after the app was registered
+    entry->context.audio = s_audio_ops;
     
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create task for app '%s'", app_name);
-        app_registry_unlock();
-        return ESP_ERR_NO_MEM;
+    // A flash app starts over from its initial .data
+    if (entry->info.image != NULL) {
+        ret = flash_app_restart(&entry->info);
+        if (ret != ESP_OK) {
+            app_registry_unlock();
+            return ret;
+        }
     }
     
+    // Hand the entry to an idle pooled worker; RUNNING goes first so it
+    // cannot overwrite the ERROR of an entry that fails straight away
     entry->info.state = APP_STATE_RUNNING;
+    app_cpu_start(entry);
+    ret = app_executor_start(entry);
+    if (ret != ESP_OK) {
+        entry->info.state = APP_STATE_LOADED;
+        app_registry_unlock();
+        return ret;
+    }
     
     system_service_set_state(entry->info.service_id, SYSTEM_SERVICE_STATE_RUNNING);
     
@@ -263,7 +338,8 @@ esp_err_t app_manager_stop_app(const char *app_name)
         return ESP_ERR_NOT_FOUND;
     }
     
-    if (entry->info.state != APP_STATE_RUNNING && entry->info.state != APP_STATE_PAUSED) {
+    if (entry->info.state != APP_STATE_RUNNING && entry->info.state != APP_STATE_PAUSED &&
+        entry->info.state != APP_STATE_HIBERNATED) {
         ESP_LOGW(TAG, "App '%s' not running", app_name);
         app_registry_unlock();
         return ESP_OK;
@@ -274,10 +350,27 @@ esp_err_t app_manager_stop_app(const char *app_name)
         entry->info.manifest.exit(&entry->context);
     }
     
-    // Delete task if still running
-    if (entry->task_handle != NULL) {
-        vTaskDelete(entry->task_handle);
-        entry->task_handle = NULL;
+    // Let the entry return, or take it off its worker
+    app_executor_stop(entry);
+    app_cpu_stop(entry);
+    
+    // Nothing handles its events anymore
+    app_lifecycle_unsubscribe_all(entry->info.service_id);
+    
+    // Silence a stream the app left open
+    if (entry->context.audio != NULL) {
+        entry->context.audio->close(&entry->context, false);
+    }
+    
+    // Nothing of the app runs anymore, drop its arena in one go
+    app_arena_release(&entry->arena);
+    
+    // Events it missed while hibernated and the state it would have restored
+    if (entry->info.state == APP_STATE_HIBERNATED) {
+        event_dispatch_release(entry->info.service_id, false, NULL, NULL);
+        heap_caps_free(entry->hibernate_state);
+        entry->hibernate_state = NULL;
+        entry->hibernate_state_len = 0;
     }
     
     entry->info.state = APP_STATE_LOADED;
@@ -291,6 +384,71 @@ esp_err_t app_manager_stop_app(const char *app_name)
     return ESP_OK;
 }
 
+/* Post app.hibernated or app.resumed as the app */
+static void post_hibernation_event(system_event_type_t type, const common_app_hibernate_t *report)
+{
+    esp_err_t ret = system_event_post(report->service_id, type, report, sizeof(*report),
+                                      SYSTEM_EVENT_PRIORITY_NORMAL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to announce app '%s': %s", report->name, esp_err_to_name(ret));
+    }
+}
+
+/*
+ * Park the app's events, save its state and free its arena. Called with the
+ * registry lock held while the app still runs. On failure the app is left
+ * running with its events flowing again.
+ */
+static esp_err_t app_hibernate(app_registry_entry_t *entry, common_app_hibernate_t *report)
+{
+    const char *name = entry->info.manifest.name;
+    system_service_id_t service_id = entry->info.service_id;
+    
+    // Park first, so no handler runs against state being torn down
+    esp_err_t ret = event_dispatch_hold(service_id);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    size_t len = 0;
+    ret = entry->info.manifest.hibernate(&entry->context, s_hibernate_scratch, HIBERNATE_STATE_MAX, &len);
+    if (ret == ESP_OK && len > HIBERNATE_STATE_MAX) {
+        ESP_LOGE(TAG, "App '%s' saved %u bytes, limit is %d", name, (unsigned)len, HIBERNATE_STATE_MAX);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "App '%s' failed to hibernate: %s", name, esp_err_to_name(ret));
+        event_dispatch_release(service_id, true, NULL, NULL);
+        return ret;
+    }
+    
+    void *state = NULL;
+    if (len > 0) {
+        state = heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (state == NULL) {
+            // The app already tore down; bring it straight back
+            ESP_LOGE(TAG, "No memory for %u bytes of app '%s' state", (unsigned)len, name);
+            entry->info.manifest.restore(&entry->context, s_hibernate_scratch, len);
+            event_dispatch_release(service_id, true, NULL, NULL);
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(state, s_hibernate_scratch, len);
+    }
+    
+    entry->hibernate_state = state;
+    entry->hibernate_state_len = len;
+    
+    memset(report, 0, sizeof(*report));
+    strlcpy(report->name, name, sizeof(report->name));
+    report->service_id = service_id;
+    report->state_bytes = len;
+    report->arena_bytes = app_arena_used(&entry->arena);
+    
+    app_arena_release(&entry->arena);
+    
+    return ESP_OK;
+}
+
 esp_err_t app_manager_pause_app(const char *app_name)
 {
     if (app_name == NULL) {
@@ -313,16 +471,32 @@ esp_err_t app_manager_pause_app(const char *app_name)
         return ESP_ERR_INVALID_STATE;
     }
     
+    bool hibernate = (entry->info.manifest.hibernate != NULL);
+    common_app_hibernate_t report;
+    if (hibernate) {
+        ret = app_hibernate(entry, &report);
+        if (ret != ESP_OK) {
+            app_registry_unlock();
+            return ret;
+        }
+    }
+    
     if (entry->task_handle != NULL) {
         vTaskSuspend(entry->task_handle);
     }
     
-    entry->info.state = APP_STATE_PAUSED;
+    entry->info.state = hibernate ? APP_STATE_HIBERNATED : APP_STATE_PAUSED;
     system_service_set_state(entry->info.service_id, SYSTEM_SERVICE_STATE_PAUSED);
     
     app_registry_unlock();
     
-    ESP_LOGI(TAG, "✓ Paused app '%s'", app_name);
+    if (hibernate) {
+        post_hibernation_event(COMMON_EVENT_APP_HIBERNATED, &report);
+        ESP_LOGI(TAG, "✓ Hibernated app '%s' (%lu B state, %lu B arena freed)", app_name,
+                 (unsigned long)report.state_bytes, (unsigned long)report.arena_bytes);
+    } else {
+        ESP_LOGI(TAG, "✓ Paused app '%s'", app_name);
+    }
     
     return ESP_OK;
 }
@@ -344,11 +518,34 @@ esp_err_t app_manager_resume_app(const char *app_name)
         return ESP_ERR_NOT_FOUND;
     }
     
-    if (entry->info.state != APP_STATE_PAUSED) {
+    if (entry->info.state != APP_STATE_PAUSED && entry->info.state != APP_STATE_HIBERNATED) {
         app_registry_unlock();
         return ESP_ERR_INVALID_STATE;
     }
     
+    bool hibernated = (entry->info.state == APP_STATE_HIBERNATED);
+    common_app_hibernate_t report;
+    if (hibernated) {
+        // Rebuild before the app runs or sees an event; a failed restore
+        // keeps the state for another try
+        ret = entry->info.manifest.restore(&entry->context, entry->hibernate_state,
+                                           entry->hibernate_state_len);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "App '%s' failed to restore: %s", app_name, esp_err_to_name(ret));
+            app_registry_unlock();
+            return ret;
+        }
+    
+        memset(&report, 0, sizeof(report));
+        strlcpy(report.name, app_name, sizeof(report.name));
+        report.service_id = entry->info.service_id;
+        report.state_bytes = entry->hibernate_state_len;
+    
+        heap_caps_free(entry->hibernate_state);
+        entry->hibernate_state = NULL;
+        entry->hibernate_state_len = 0;
+    }
+    
     if (entry->task_handle != NULL) {
         vTaskResume(entry->task_handle);
     }
@@ -356,14 +553,24 @@ esp_err_t app_manager_resume_app(const char *app_name)
     entry->info.state = APP_STATE_RUNNING;
     system_service_set_state(entry->info.service_id, SYSTEM_SERVICE_STATE_RUNNING);
     
+    if (hibernated) {
+        event_dispatch_release(entry->info.service_id, true,
+                               &report.events_replayed, &report.events_dropped);
+    }
+    
     app_registry_unlock();
     
-    ESP_LOGI(TAG, "✓ Resumed app '%s'", app_name);
+    if (hibernated) {
+        post_hibernation_event(COMMON_EVENT_APP_RESUMED, &report);
+        ESP_LOGI(TAG, "✓ Restored app '%s' (%lu events replayed, %lu missed)", app_name,
+                 (unsigned long)report.events_replayed, (unsigned long)report.events_dropped);
+    } else {
+        ESP_LOGI(TAG, "✓ Resumed app '%s'", app_name);
+    }
     
     return ESP_OK;
 }
 
-
 esp_err_t app_manager_get_info(const char *app_name, app_info_t *out_info)
 {
     if (app_name == NULL || out_info == NULL) {
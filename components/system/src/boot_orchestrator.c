@@ -0,0 +1,398 @@
+/**
+ * @file boot_orchestrator.c
+ * @brief Parallel, dependency-ordered service bring-up implementation
+ * 
+ * Workers share one run table guarded by a mutex. A worker claims the
+ * first pending service, in topological order, whose dependencies are
+ * ready, runs it without holding the lock, and then wakes the others,
+ * since the service it just finished may have unblocked theirs. Workers
+ * with nothing ready sleep until then, or until a ready callback from the
+ * dependency graph reports that a dependency outside the table came up.
+ */
+
+#include "boot_orchestrator.h"
+#include "service_dependencies.h"
+#include "system_service/error_codes.h"
+#include "system_service/boot_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "boot";
+
+/* ============================================================================
+ * Run State
+ * ============================================================================ */
+
+#define BOOT_WORKER_COUNT           portNUM_PROCESSORS
+
+typedef enum {
+    BOOT_PENDING = 0,
+    BOOT_RUNNING,
+    BOOT_DONE,
+    BOOT_FAILED,
+    BOOT_SKIPPED,
+} boot_state_t;
+
+/** claim_next() results besides a table index */
+#define BOOT_NONE_READY             (-1)
+#define BOOT_ALL_FINISHED           (-2)
+
+/** dep_index entry for a dependency outside the table */
+#define BOOT_EXTERNAL               0xFF
+
+typedef struct {
+    const boot_service_t *services;
+    size_t count;
+    uint8_t order[BOOT_MAX_SERVICES];       /**< Table indices, dependencies first */
+    uint8_t dep_index[BOOT_MAX_SERVICES][SYSTEM_SERVICE_MAX_DEPENDENCIES]; /**< Or BOOT_EXTERNAL */
+    boot_state_t state[BOOT_MAX_SERVICES];
+    size_t finished;                        /**< Services done, failed or skipped */
+    int64_t deadline_us;                    /**< Give up on unmet dependencies */
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t progress;             /**< Given once per worker on progress */
+    SemaphoreHandle_t exited;               /**< Given by each helper as it exits */
+} boot_run_t;
+
+static boot_run_t g_boot;
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static int find_service(const char *name)
+{
+    for (size_t i = 0; i < g_boot.count; i++) {
+        if (strcmp(g_boot.services[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Append a service to the claim order after its dependencies
+ */
+static void order_dfs(int index, bool *placed, size_t *n)
+{
+    if (placed[index]) {
+        return;
+    }
+    placed[index] = true;
+    
+    const boot_service_t *svc = &g_boot.services[index];
+    for (uint8_t d = 0; d < svc->dependency_count; d++) {
+        if (g_boot.dep_index[index][d] != BOOT_EXTERNAL) {
+            order_dfs(g_boot.dep_index[index][d], placed, n);
+        }
+    }
+    
+    g_boot.order[(*n)++] = (uint8_t)index;
+}
+
+/**
+ * @brief Register the table's dependencies and fix the claim order
+ * 
+ * Dependency names are resolved to table indices here, once. The order is a topological sort of the graph, like
+ * dependencies_get_init_order(), with ties broken by table position so
+ * callers can put the services that matter most for time-to-UI first.
+ * dependencies_add() has already rejected cycles.
+ */
+static esp_err_t build_order(void)
+{
+    for (size_t i = 0; i < g_boot.count; i++) {
+        const boot_service_t *svc = &g_boot.services[i];
+        for (uint8_t d = 0; d < svc->dependency_count; d++) {
+            esp_err_t ret = dependencies_add(svc->name, svc->depends_on[d]);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Cannot add dependency %s -> %s: %s",
+                         svc->name, svc->depends_on[d], system_service_err_to_name(ret));
+                return ret;
+            }
+            int dep = find_service(svc->depends_on[d]);
+            g_boot.dep_index[i][d] = (dep >= 0) ? (uint8_t)dep : BOOT_EXTERNAL;
+        }
+    }
+    
+    bool placed[BOOT_MAX_SERVICES] = {0};
+    size_t n = 0;
+    for (size_t i = 0; i < g_boot.count; i++) {
+        order_dfs((int)i, placed, &n);
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief True if a dependency inside the table failed or was skipped
+ */
+static bool dependency_lost(int index)
+{
+    const boot_service_t *svc = &g_boot.services[index];
+    for (uint8_t d = 0; d < svc->dependency_count; d++) {
+        uint8_t dep = g_boot.dep_index[index][d];
+        if (dep != BOOT_EXTERNAL &&
+            (g_boot.state[dep] == BOOT_FAILED || g_boot.state[dep] == BOOT_SKIPPED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief True if a dependency inside the table is still coming up
+ */
+static bool dependency_in_progress(int index)
+{
+    const boot_service_t *svc = &g_boot.services[index];
+    for (uint8_t d = 0; d < svc->dependency_count; d++) {
+        uint8_t dep = g_boot.dep_index[index][d];
+        if (dep != BOOT_EXTERNAL &&
+            (g_boot.state[dep] == BOOT_PENDING || g_boot.state[dep] == BOOT_RUNNING)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void wake_workers(void)
+{
+    for (int i = 0; i < BOOT_WORKER_COUNT; i++) {
+        xSemaphoreGive(g_boot.progress);
+    }
+}
+
+/**
+ * @brief Dependency graph ready callback for every table service
+ * 
+ * Covers dependencies marked initialized outside the orchestrator; those
+ * inside the table already wake the workers when they finish.
+ */
+static void on_service_ready(const char *service_name, void *user_data)
+{
+    (void)service_name;
+    (void)user_data;
+    wake_workers();
+}
+
+static void set_ready_callbacks(bool install)
+{
+    for (size_t i = 0; i < g_boot.count; i++) {
+        dependencies_set_ready_callback(g_boot.services[i].name,
+                                        install ? on_service_ready : NULL, NULL);
+    }
+}
+
+/**
+ * @brief Claim the next ready service (lock held)
+ * 
+ * Skips services whose dependencies can no longer come up, and after the
+ * deadline also those still waiting on dependencies outside the table.
+ */
+static int claim_next_locked(bool *out_skipped)
+{
+    bool expired = esp_timer_get_time() >= g_boot.deadline_us;
+    
+    for (size_t i = 0; i < g_boot.count; i++) {
+        int index = g_boot.order[i];
+        if (g_boot.state[index] != BOOT_PENDING) {
+            continue;
+        }
+    
+        const boot_service_t *svc = &g_boot.services[index];
+        if (dependency_lost(index)) {
+            ESP_LOGW(TAG, "Skipping %s: a dependency failed", svc->name);
+            g_boot.state[index] = BOOT_SKIPPED;
+            g_boot.finished++;
+            *out_skipped = true;
+            continue;
+        }
+    
+        if (dependencies_check_ready(svc->name) == ESP_OK) {
+            g_boot.state[index] = BOOT_RUNNING;
+            return index;
+        }
+    
+        if (expired && !dependency_in_progress(index)) {
+            ESP_LOGW(TAG, "Skipping %s: dependencies not ready in time", svc->name);
+            g_boot.state[index] = BOOT_SKIPPED;
+            g_boot.finished++;
+            *out_skipped = true;
+        }
+    }
+    
+    return (g_boot.finished == g_boot.count) ? BOOT_ALL_FINISHED : BOOT_NONE_READY;
+}
+
+static esp_err_t bring_up(const boot_service_t *svc)
+{
+    int64_t start_us = esp_timer_get_time();
+    boot_trace_id_t phase = boot_trace_begin(svc->name);
+    
+    esp_err_t ret = svc->init();
+    if (ret == ESP_OK && svc->start != NULL) {
+        ret = svc->start();
+    }
+    
+    boot_trace_end(phase);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s up in %lu ms (core %d)", svc->name, elapsed_ms, xPortGetCoreID());
+        dependencies_mark_initialized(svc->name);
+    } else {
+        ESP_LOGE(TAG, "%s failed after %lu ms: %s", svc->name, elapsed_ms,
+                 system_service_err_to_name(ret));
+    }
+    
+    return ret;
+}
+
+static void worker_loop(void)
+{
+    while (true) {
+        bool skipped = false;
+        xSemaphoreTake(g_boot.lock, portMAX_DELAY);
+        int index = claim_next_locked(&skipped);
+        xSemaphoreGive(g_boot.lock);
+    
+        if (skipped) {
+            wake_workers();
+        }
+    
+        if (index == BOOT_ALL_FINISHED) {
+            // Let the others see it too
+            wake_workers();
+            return;
+        }
+    
+        if (index == BOOT_NONE_READY) {
+            // Woken by progress or a ready callback, or at the deadline
+            int64_t remaining_us = g_boot.deadline_us - esp_timer_get_time();
+            TickType_t wait = (remaining_us > 0) ? pdMS_TO_TICKS(remaining_us / 1000) + 1
+                                                 : pdMS_TO_TICKS(100);
+            xSemaphoreTake(g_boot.progress, wait);
+            continue;
+        }
+    
+        esp_err_t ret = bring_up(&g_boot.services[index]);
+    
+        xSemaphoreTake(g_boot.lock, portMAX_DELAY);
+        g_boot.state[index] = (ret == ESP_OK) ? BOOT_DONE : BOOT_FAILED;
+        g_boot.finished++;
+        xSemaphoreGive(g_boot.lock);
+    
+        wake_workers();
+    }
+}
+
+static void helper_task(void *arg)
+{
+    (void)arg;
+    worker_loop();
+    xSemaphoreGive(g_boot.exited);
+    vTaskDelete(NULL);
+}
+
+static void delete_sync(void)
+{
+    if (g_boot.lock != NULL) {
+        vSemaphoreDelete(g_boot.lock);
+    }
+    if (g_boot.progress != NULL) {
+        vSemaphoreDelete(g_boot.progress);
+    }
+    if (g_boot.exited != NULL) {
+        vSemaphoreDelete(g_boot.exited);
+    }
+    g_boot.lock = NULL;
+    g_boot.progress = NULL;
+    g_boot.exited = NULL;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t boot_orchestrator_run(const boot_service_t *services,
+                                size_t count,
+                                uint32_t timeout_ms)
+{
+    if (services == NULL || count == 0 || count > BOOT_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (services[i].name == NULL || services[i].init == NULL ||
+            services[i].dependency_count > SYSTEM_SERVICE_MAX_DEPENDENCIES) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    
+    if (g_boot.lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(&g_boot, 0, sizeof(g_boot));
+    g_boot.services = services;
+    g_boot.count = count;
+    g_boot.deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    
+    esp_err_t ret = build_order();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Boot-time only, so plain dynamic objects: they are gone again below
+    g_boot.lock = xSemaphoreCreateMutex();
+    g_boot.progress = xSemaphoreCreateCounting(BOOT_WORKER_COUNT * BOOT_MAX_SERVICES, 0);
+    g_boot.exited = xSemaphoreCreateCounting(BOOT_WORKER_COUNT, 0);
+    if (g_boot.lock == NULL || g_boot.progress == NULL || g_boot.exited == NULL) {
+        delete_sync();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    set_ready_callbacks(true);
+    
+    int64_t start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Bringing up %zu services on %d cores", count, BOOT_WORKER_COUNT);
+    
+    // One helper per other core; the caller works on its own
+    int helpers = 0;
+    int own_core = xPortGetCoreID();
+    for (int core = 0; core < BOOT_WORKER_COUNT; core++) {
+        if (core == own_core) {
+            continue;
+        }
+        if (xTaskCreatePinnedToCore(helper_task, "boot_worker",
+                                    CONFIG_SYSTEM_SERVICE_BOOT_WORKER_STACK_SIZE, NULL,
+                                    uxTaskPriorityGet(NULL), NULL, core) == pdPASS) {
+            helpers++;
+        } else {
+            ESP_LOGW(TAG, "No boot worker for core %d, continuing with fewer", core);
+        }
+    }
+    
+    worker_loop();
+    
+    for (int i = 0; i < helpers; i++) {
+        xSemaphoreTake(g_boot.exited, portMAX_DELAY);
+    }
+    
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (g_boot.state[i] != BOOT_DONE) {
+            failed++;
+        }
+    }
+    
+    set_ready_callbacks(false);
+    delete_sync();
+    
+    ESP_LOGI(TAG, "Bring-up finished in %lu ms, %zu of %zu services up",
+             (uint32_t)((esp_timer_get_time() - start_us) / 1000), count - failed, count);
+    
+    return (failed == 0) ? ESP_OK : ESP_ERR_SERVICE_DEPENDENCY_FAILED;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file boot_trace.c
+ * @brief Boot phase tracer implementation
+ * 
+ * Phases go into a fixed table in .bss, so tracing works from the first
+ * line of app_main without any init call. Slots are claimed under a
+ * spinlock because services boot in parallel. The profile is written to
+ * NVS as a blob holding only the used phases, in a ring of
+ * CONFIG_SYSTEM_SERVICE_BOOT_TRACE_HISTORY keys.
+ */
+
+#include "system_service/boot_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_app_desc.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "boot_trace";
+
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+
+/* ============================================================================
+ * Trace State
+ * ============================================================================ */
+
+#define BOOT_TRACE_HISTORY          CONFIG_SYSTEM_SERVICE_BOOT_TRACE_HISTORY
+#define BOOT_TRACE_NAMESPACE        "boot_trace"
+#define BOOT_TRACE_COUNT_KEY        "count"
+#define WATERFALL_WIDTH             40
+
+static boot_trace_phase_t g_phases[BOOT_TRACE_MAX_PHASES];
+static uint8_t g_phase_count = 0;
+static bool g_finished = false;
+static portMUX_TYPE g_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static boot_trace_id_t add_phase(const char *phase, bool milestone)
+{
+    if (phase == NULL) {
+        return BOOT_TRACE_ID_INVALID;
+    }
+    
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    boot_trace_id_t id = BOOT_TRACE_ID_INVALID;
+    
+    portENTER_CRITICAL(&g_trace_lock);
+    if (!g_finished && g_phase_count < BOOT_TRACE_MAX_PHASES) {
+        id = g_phase_count++;
+        boot_trace_phase_t *entry = &g_phases[id];
+        strncpy(entry->name, phase, BOOT_TRACE_NAME_LEN - 1);
+        entry->name[BOOT_TRACE_NAME_LEN - 1] = '\0';
+        entry->start_us = now_us;
+        entry->duration_us = 0;
+        entry->core = (uint8_t)xPortGetCoreID();
+        entry->milestone = milestone;
+    }
+    portEXIT_CRITICAL(&g_trace_lock);
+    
+    return id;
+}
+
+static size_t profile_blob_size(uint8_t phase_count)
+{
+    return offsetof(boot_profile_t, phases) + (size_t)phase_count * sizeof(boot_trace_phase_t);
+}
+
+static void print_waterfall(const boot_profile_t *profile)
+{
+    uint32_t span = profile->total_us ? profile->total_us : 1;
+    
+    ESP_LOGI(TAG, "Boot waterfall, %lu ms total (boot #%lu, %s):",
+             profile->total_us / 1000, profile->boot_count, profile->app_version);
+    ESP_LOGI(TAG, "  %-*s %8s %8s  core", BOOT_TRACE_NAME_LEN - 1, "phase", "start", "duration");
+    
+    for (uint8_t i = 0; i < profile->phase_count; i++) {
+        const boot_trace_phase_t *phase = &profile->phases[i];
+    
+        char bar[WATERFALL_WIDTH + 1];
+        memset(bar, ' ', WATERFALL_WIDTH);
+        bar[WATERFALL_WIDTH] = '\0';
+    
+        uint32_t from = (uint32_t)((uint64_t)phase->start_us * WATERFALL_WIDTH / span);
+        uint32_t to = (uint32_t)((uint64_t)(phase->start_us + phase->duration_us) * WATERFALL_WIDTH / span);
+        if (from >= WATERFALL_WIDTH) {
+            from = WATERFALL_WIDTH - 1;
+        }
+        if (to > WATERFALL_WIDTH) {
+            to = WATERFALL_WIDTH;
+        }
+        if (phase->milestone) {
+            bar[from] = '|';
+        } else {
+            for (uint32_t c = from; c < to || c == from; c++) {
+                bar[c] = '#';
+            }
+        }
+    
+        if (phase->milestone) {
+            ESP_LOGI(TAG, "  %-*s %5lu ms %8s   %u  [%s]", BOOT_TRACE_NAME_LEN - 1, phase->name,
+                     phase->start_us / 1000, "-", phase->core, bar);
+        } else {
+            ESP_LOGI(TAG, "  %-*s %5lu ms %5lu ms   %u  [%s]", BOOT_TRACE_NAME_LEN - 1, phase->name,
+                     phase->start_us / 1000, phase->duration_us / 1000, phase->core, bar);
+        }
+    }
+}
+
+static esp_err_t store_profile(boot_profile_t *profile)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(BOOT_TRACE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    uint32_t count = 0;
+    nvs_get_u32(nvs, BOOT_TRACE_COUNT_KEY, &count);
+    profile->boot_count = count + 1;
+    
+    char key[8];
+    snprintf(key, sizeof(key), "p%lu", count % BOOT_TRACE_HISTORY);
+    
+    ret = nvs_set_blob(nvs, key, profile, profile_blob_size(profile->phase_count));
+    if (ret == ESP_OK) {
+        ret = nvs_set_u32(nvs, BOOT_TRACE_COUNT_KEY, count + 1);
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    
+    nvs_close(nvs);
+    return ret;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+boot_trace_id_t boot_trace_begin(const char *phase)
+{
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    return add_phase(phase, false);
+#else
+    (void)phase;
+    return BOOT_TRACE_ID_INVALID;
+#endif
+}
+
+void boot_trace_end(boot_trace_id_t id)
+{
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    
+    portENTER_CRITICAL(&g_trace_lock);
+    if (!g_finished && id < g_phase_count && !g_phases[id].milestone) {
+        g_phases[id].duration_us = now_us - g_phases[id].start_us;
+    }
+    portEXIT_CRITICAL(&g_trace_lock);
+#else
+    (void)id;
+#endif
+}
+
+void boot_trace_mark(const char *phase)
+{
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    add_phase(phase, true);
+#else
+    (void)phase;
+#endif
+}
+
+esp_err_t boot_trace_finish(void)
+{
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    static boot_profile_t profile;
+    
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    
+    portENTER_CRITICAL(&g_trace_lock);
+    if (g_finished) {
+        portEXIT_CRITICAL(&g_trace_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_finished = true;
+    portEXIT_CRITICAL(&g_trace_lock);
+    
+    // The table is frozen now, no lock needed to copy it
+    memset(&profile, 0, sizeof(profile));
+    profile.total_us = now_us;
+    profile.phase_count = g_phase_count;
+    memcpy(profile.phases, g_phases, sizeof(boot_trace_phase_t) * g_phase_count);
+    
+    const esp_app_desc_t *app = esp_app_get_description();
+    strncpy(profile.app_version, app->version, sizeof(profile.app_version) - 1);
+    memcpy(profile.elf_sha256, app->app_elf_sha256, sizeof(profile.elf_sha256));
+    
+    esp_err_t ret = store_profile(&profile);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store boot profile: %s", esp_err_to_name(ret));
+    }
+    
+    print_waterfall(&profile);
+    
+    return ret;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t boot_trace_get_profile(uint32_t age, boot_profile_t *out_profile)
+{
+    if (out_profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(BOOT_TRACE_NAMESPACE, NVS_READONLY, &nvs);
+    if (ret != ESP_OK) {
+        return (ret == ESP_ERR_NVS_NOT_FOUND) ? ESP_ERR_NOT_FOUND : ret;
+    }
+    
+    uint32_t count = 0;
+    nvs_get_u32(nvs, BOOT_TRACE_COUNT_KEY, &count);
+    uint32_t stored = (count < BOOT_TRACE_HISTORY) ? count : BOOT_TRACE_HISTORY;
+    if (age >= stored) {
+        nvs_close(nvs);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    char key[8];
+    snprintf(key, sizeof(key), "p%lu", (count - 1 - age) % BOOT_TRACE_HISTORY);
+    
+    // Profiles from builds with a larger phase table do not fit and are skipped
+    memset(out_profile, 0, sizeof(*out_profile));
+    size_t size = sizeof(*out_profile);
+    ret = nvs_get_blob(nvs, key, out_profile, &size);
+    nvs_close(nvs);
+    
+    if (ret != ESP_OK || size < offsetof(boot_profile_t, phases) ||
+        size != profile_blob_size(out_profile->phase_count)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    return ESP_OK;
+#else
+    (void)age;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void boot_trace_print_history(void)
+{
+#if CONFIG_SYSTEM_SERVICE_BOOT_TRACE
+    // Too large for most task stacks
+    static boot_profile_t profiles[2];
+    
+    ESP_LOGI(TAG, "Stored boot profiles, newest first:");
+    
+    boot_profile_t *current = &profiles[0];
+    boot_profile_t *older = &profiles[1];
+    bool have_current = (boot_trace_get_profile(0, current) == ESP_OK);
+    
+    for (uint32_t age = 0; have_current && age < BOOT_TRACE_HISTORY; age++) {
+        bool have_older = (boot_trace_get_profile(age + 1, older) == ESP_OK);
+    
+        if (have_older) {
+            int32_t delta_ms = ((int32_t)current->total_us - (int32_t)older->total_us) / 1000;
+            ESP_LOGI(TAG, "  #%lu %-24s %5lu ms (%+ld ms)", current->boot_count, current->app_version,
+                     current->total_us / 1000, delta_ms);
+        } else {
+            ESP_LOGI(TAG, "  #%lu %-24s %5lu ms", current->boot_count, current->app_version,
+                     current->total_us / 1000);
+        }
+    
+        boot_profile_t *swap = current;
+        current = older;
+        older = swap;
+        have_current = have_older;
+    }
+#endif
+}
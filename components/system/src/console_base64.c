@@ -0,0 +1,72 @@
+/**
+ * @file console_base64.c
+ * @brief Binary dumps over the console as base64 lines
+ */
+
+#include "console_base64.h"
+#include <stdio.h>
+#include <string.h>
+
+static void console_line(const uint8_t *data, size_t len)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char line[CONSOLE_BASE64_CHUNK / 3 * 4 + 1];
+    size_t out = 0;
+    
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t chunk = (uint32_t)data[i] << 16;
+        if (i + 1 < len) {
+            chunk |= (uint32_t)data[i + 1] << 8;
+        }
+        if (i + 2 < len) {
+            chunk |= data[i + 2];
+        }
+        line[out++] = alphabet[(chunk >> 18) & 0x3F];
+        line[out++] = alphabet[(chunk >> 12) & 0x3F];
+        line[out++] = (i + 1 < len) ? alphabet[(chunk >> 6) & 0x3F] : '=';
+        line[out++] = (i + 2 < len) ? alphabet[chunk & 0x3F] : '=';
+    }
+    line[out] = '\0';
+    printf("%s\n", line);
+}
+
+void console_base64_begin(console_base64_t *sink, const char *marker)
+{
+    sink->marker = marker;
+    sink->length = 0;
+    printf("%s-BEGIN\n", marker);
+}
+
+esp_err_t console_base64_write(const void *data, size_t len, void *user_data)
+{
+    console_base64_t *sink = (console_base64_t *)user_data;
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+    while (len > 0) {
+        size_t take = CONSOLE_BASE64_CHUNK - sink->length;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(sink->pending + sink->length, bytes, take);
+        sink->length += take;
+        bytes += take;
+        len -= take;
+    
+        if (sink->length == CONSOLE_BASE64_CHUNK) {
+            console_line(sink->pending, sink->length);
+            sink->length = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+void console_base64_end(console_base64_t *sink)
+{
+    if (sink->length > 0) {
+        console_line(sink->pending, sink->length);
+        sink->length = 0;
+    }
+    printf("%s-END\n", sink->marker);
+    fflush(stdout);
+}
@@ -6,23 +6,572 @@
  */
 
 #include "system_service/event_bus.h"
+#include "system_service/event_schema.h"
 #include "system_internal.h"
 #include "memory_pool.h"
 #include "priority_queue.h"
+#include "isr_event_ring.h"
 #include "handler_monitor.h"
 #include "resource_quota.h"
-#include "app_lifecycle.h"
+#include "event_credit.h"
+#include "metrics_registry.h"
+#include "topic_trie.h"
+#include "service_activation.h"
 #include "system_service/error_codes.h"
+#include "system_service/system_trace.h"
+#include "system_service/system_log.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "esp_timer.h"
 #include <string.h>
 
 static const char *TAG = "event_bus";
 
+/* Guards the latest-value slots, shared by posters and the event task */
+static portMUX_TYPE g_latest_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t g_latest_generation;   // Tags each parked value, 0 is never used
+
+#define LATEST_ANY      0                  // coalesce_cancel() whatever is parked
+
+/* ============================================================================
+ * Subscriber Index
+ * ============================================================================ */
+
+/*
+ * The event task walks the chains without the system lock. Writers bump
+ * subscription_seq to odd before touching a chain and back to even after,
+ * so a reader that saw the same even value on both sides copied a
+ * consistent chain. Slot indices are always in range, so a torn walk can
+ * only produce a wrong copy that the retry throws away.
+ */
+
+static void subscription_write_begin(system_context_t *ctx)
+{
+    __atomic_store_n(&ctx->subscription_seq, ctx->subscription_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void subscription_write_end(system_context_t *ctx)
+{
+    __atomic_store_n(&ctx->subscription_seq, ctx->subscription_seq + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t system_subscription_read_begin(system_context_t *ctx)
+{
+    return __atomic_load_n(&ctx->subscription_seq, __ATOMIC_ACQUIRE);
+}
+
+bool system_subscription_read_retry(system_context_t *ctx, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (seq & 1) != 0 ||
+           __atomic_load_n(&ctx->subscription_seq, __ATOMIC_RELAXED) != seq;
+}
+
+void system_subscription_index_reset(system_context_t *ctx)
+{
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
+        ctx->event_types[i].first_subscription = SUBSCRIPTION_INDEX_NONE;
+        ctx->event_types[i].last_subscription = SUBSCRIPTION_INDEX_NONE;
+        ctx->event_types[i].subscriber_count = 0;
+        ctx->event_types[i].wildcard_mask = 0;
+    }
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_WILDCARDS; i++) {
+        ctx->wildcards[i].active = false;
+    }
+    topic_trie_reset();
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        ctx->services[i].first_subscription = SUBSCRIPTION_INDEX_NONE;
+        ctx->services[i].subscription_count = 0;
+    }
+    system_metric_set(SYSTEM_METRIC_SUBSCRIPTIONS, 0);
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SUBSCRIBERS; i++) {
+        ctx->subscriptions[i].next_in_type = SUBSCRIPTION_INDEX_NONE;
+        ctx->subscriptions[i].prev_in_type = SUBSCRIPTION_INDEX_NONE;
+        ctx->subscriptions[i].next_in_service = SUBSCRIPTION_INDEX_NONE;
+        ctx->subscriptions[i].prev_in_service = SUBSCRIPTION_INDEX_NONE;
+    }
+}
+
+void system_subscription_link(system_context_t *ctx, uint16_t slot)
+{
+    event_subscription_t *sub = &ctx->subscriptions[slot];
+    event_type_entry_t *type = &ctx->event_types[sub->event_type];
+    service_entry_t *service = &ctx->services[sub->service_id];
+    
+    subscription_write_begin(ctx);
+    
+    // Append so handlers keep running in subscription order
+    sub->next_in_type = SUBSCRIPTION_INDEX_NONE;
+    sub->prev_in_type = type->last_subscription;
+    if (type->last_subscription != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[type->last_subscription].next_in_type = slot;
+    } else {
+        type->first_subscription = slot;
+    }
+    type->last_subscription = slot;
+    type->subscriber_count++;
+    
+    // Order does not matter per service
+    sub->prev_in_service = SUBSCRIPTION_INDEX_NONE;
+    sub->next_in_service = service->first_subscription;
+    if (service->first_subscription != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[service->first_subscription].prev_in_service = slot;
+    }
+    service->first_subscription = slot;
+    service->subscription_count++;
+    system_metric_gauge_add(SYSTEM_METRIC_SUBSCRIPTIONS, 1);
+    
+    subscription_write_end(ctx);
+}
+
+/* Take a subscription off both chains; the caller brackets the write */
+static void subscription_unlink_locked(system_context_t *ctx, uint16_t slot)
+{
+    event_subscription_t *sub = &ctx->subscriptions[slot];
+    event_type_entry_t *type = &ctx->event_types[sub->event_type];
+    service_entry_t *service = &ctx->services[sub->service_id];
+    
+    if (sub->prev_in_type != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[sub->prev_in_type].next_in_type = sub->next_in_type;
+    } else {
+        type->first_subscription = sub->next_in_type;
+    }
+    if (sub->next_in_type != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[sub->next_in_type].prev_in_type = sub->prev_in_type;
+    } else {
+        type->last_subscription = sub->prev_in_type;
+    }
+    type->subscriber_count--;
+    
+    if (sub->prev_in_service != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[sub->prev_in_service].next_in_service = sub->next_in_service;
+    } else {
+        service->first_subscription = sub->next_in_service;
+    }
+    if (sub->next_in_service != SUBSCRIPTION_INDEX_NONE) {
+        ctx->subscriptions[sub->next_in_service].prev_in_service = sub->prev_in_service;
+    }
+    service->subscription_count--;
+    system_metric_gauge_add(SYSTEM_METRIC_SUBSCRIPTIONS, -1);
+    
+    // A reader standing on this slot still finds the rest of the type chain
+    sub->prev_in_type = SUBSCRIPTION_INDEX_NONE;
+    sub->next_in_service = SUBSCRIPTION_INDEX_NONE;
+    sub->prev_in_service = SUBSCRIPTION_INDEX_NONE;
+}
+
+void system_subscription_unlink(system_context_t *ctx, uint16_t slot)
+{
+    subscription_write_begin(ctx);
+    subscription_unlink_locked(ctx, slot);
+    subscription_write_end(ctx);
+}
+
+/*
+ * Wildcard subscriptions are not on the chains. Each matching type has
+ * the wildcard's bit in its wildcard_mask instead, set through the trie
+ * when subscribing and by the registration of a new type, so the event
+ * task only reads the mask. The caller brackets the write.
+ */
+typedef struct {
+    system_context_t *ctx;
+    uint32_t bit;
+} wildcard_expand_t;
+
+static void wildcard_mark_type(system_event_type_t event_type, void *arg)
+{
+    wildcard_expand_t *expand = (wildcard_expand_t *)arg;
+    expand->ctx->event_types[event_type].wildcard_mask |= expand->bit;
+}
+
+static void wildcard_remove_locked(system_context_t *ctx, int index)
+{
+    uint32_t bit = 1u << index;
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
+        ctx->event_types[i].wildcard_mask &= ~bit;
+    }
+    ctx->wildcards[index].active = false;
+    system_metric_gauge_add(SYSTEM_METRIC_SUBSCRIPTIONS, -1);
+}
+
+/* Index a new type, before it is published, and pick up the wildcards matching it */
+static void type_attach_wildcards(system_context_t *ctx, event_type_entry_t *type)
+{
+    topic_trie_insert(type->event_type, type->event_name);
+    
+    uint32_t mask = 0;
+    for (int w = 0; w < SYSTEM_SERVICE_MAX_WILDCARDS; w++) {
+        if (ctx->wildcards[w].active &&
+            topic_pattern_match(ctx->wildcards[w].pattern, type->event_name)) {
+            mask |= 1u << w;
+        }
+    }
+    type->wildcard_mask = mask;
+}
+
+uint16_t system_subscription_drop_service(system_context_t *ctx, system_service_id_t service_id)
+{
+    uint16_t dropped = 0;
+    
+    bool has_wildcards = false;
+    for (int w = 0; w < SYSTEM_SERVICE_MAX_WILDCARDS; w++) {
+        if (ctx->wildcards[w].active && ctx->wildcards[w].service_id == service_id) {
+            has_wildcards = true;
+            break;
+        }
+    }
+    
+    if (ctx->services[service_id].first_subscription == SUBSCRIPTION_INDEX_NONE && !has_wildcards) {
+        return 0;
+    }
+    
+    subscription_write_begin(ctx);
+    
+    uint16_t slot;
+    while ((slot = ctx->services[service_id].first_subscription) != SUBSCRIPTION_INDEX_NONE) {
+        subscription_unlink_locked(ctx, slot);
+        ctx->subscriptions[slot].active = false;
+        ctx->subscription_count--;
+        dropped++;
+    }
+    
+    for (int w = 0; w < SYSTEM_SERVICE_MAX_WILDCARDS; w++) {
+        if (ctx->wildcards[w].active && ctx->wildcards[w].service_id == service_id) {
+            wildcard_remove_locked(ctx, w);
+            dropped++;
+        }
+    }
+    
+    subscription_write_end(ctx);
+    
+    return dropped;
+}
+
+/* ============================================================================
+ * Event Type Name Index
+ * ============================================================================ */
+
+/*
+ * Types are never unregistered, so the index is append-only: writers fill
+ * the entry, then publish its slot with a release store; readers need no
+ * lock and only trust entries they reached through the index.
+ */
+
+uint32_t system_event_name_hash(const char *event_name)
+{
+    // Must match SYSTEM_EVENT_NAME_HASH(): FNV-1a over the zero-padded name
+    uint32_t hash = 2166136261u;
+    bool ended = false;
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_NAME_LEN; i++) {
+        uint8_t c = 0;
+        if (!ended && i < SYSTEM_SERVICE_MAX_NAME_LEN - 1) {
+            c = (uint8_t)event_name[i];
+            ended = (c == 0);
+        }
+        hash = (hash ^ c) * 16777619u;
+    }
+    
+    return hash;
+}
+
+static int type_index_find(system_context_t *ctx, uint32_t hash, const char *event_name)
+{
+    for (uint32_t probe = 0; probe < EVENT_TYPE_HASH_SIZE; probe++) {
+        uint32_t bucket = (hash + probe) & (EVENT_TYPE_HASH_SIZE - 1);
+        uint16_t entry = __atomic_load_n(&ctx->type_hash_index[bucket], __ATOMIC_ACQUIRE);
+        if (entry == 0) {
+            return -1;
+        }
+    
+        event_type_entry_t *type = &ctx->event_types[entry - 1];
+        if (type->name_hash == hash &&
+            strncmp(type->event_name, event_name, SYSTEM_SERVICE_MAX_NAME_LEN - 1) == 0) {
+            return entry - 1;
+        }
+    }
+    
+    return -1;
+}
+
+static void type_index_insert(system_context_t *ctx, uint32_t hash, uint16_t slot)
+{
+    for (uint32_t probe = 0; probe < EVENT_TYPE_HASH_SIZE; probe++) {
+        uint32_t bucket = (hash + probe) & (EVENT_TYPE_HASH_SIZE - 1);
+        if (ctx->type_hash_index[bucket] == 0) {
+            __atomic_store_n(&ctx->type_hash_index[bucket], (uint16_t)(slot + 1), __ATOMIC_RELEASE);
+            return;
+        }
+    }
+}
+
+esp_err_t system_event_lookup_hashed(uint32_t name_hash,
+                                     const char *event_name,
+                                     system_event_type_t *out_event_type)
+{
+    if (event_name == NULL || out_event_type == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    int slot = type_index_find(ctx, name_hash, event_name);
+    if (slot < 0) {
+        return ESP_ERR_EVENT_TYPE_NOT_FOUND;
+    }
+    
+    *out_event_type = ctx->event_types[slot].event_type;
+    return ESP_OK;
+}
+
+esp_err_t system_event_lookup(const char *event_name,
+                              system_event_type_t *out_event_type)
+{
+    if (event_name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return system_event_lookup_hashed(system_event_name_hash(event_name),
+                                      event_name, out_event_type);
+}
+
+/* ============================================================================
+ * Latest-Value Topics
+ * ============================================================================ */
+
+static latest_slot_t* find_latest_slot(system_context_t *ctx,
+                                       system_event_type_t event_type,
+                                       system_service_id_t sender_id,
+                                       bool create)
+{
+    latest_slot_t *free_slot = NULL;
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_LATEST_SLOTS; i++) {
+        latest_slot_t *slot = &ctx->latest[i];
+        if (!slot->in_use) {
+            if (free_slot == NULL) {
+                free_slot = slot;
+            }
+            continue;
+        }
+        if (slot->event.event_type == event_type && slot->event.sender_id == sender_id) {
+            return slot;
+        }
+    }
+    
+    if (!create || free_slot == NULL) {
+        return NULL;
+    }
+    
+    memset(free_slot, 0, sizeof(latest_slot_t));
+    free_slot->event.event_type = event_type;
+    free_slot->event.sender_id = sender_id;
+    free_slot->in_use = true;
+    
+    return free_slot;
+}
+
+/**
+ * @brief Fold an event into its latest-value slot
+ * 
+ * If a value is already pending, it is replaced and *out_stale returns its
+ * payload for the caller to free after unlocking. Otherwise the value is
+ * parked in the slot, *out_marker returns the generation it was parked
+ * with and event is turned into a payload-less marker.
+ * 
+ * @param out_marker Generation of the parked value, 0 if event is no marker
+ * @return true if event (possibly now a marker) still has to be queued
+ */
+static bool coalesce_locked(system_context_t *ctx,
+                            system_event_t *event,
+                            uint32_t *out_marker,
+                            void **out_stale)
+{
+    *out_stale = NULL;
+    *out_marker = 0;
+    
+    if (ctx->event_types[event->event_type].mode != SYSTEM_EVENT_TOPIC_LATEST) {
+        return true;
+    }
+    
+    portENTER_CRITICAL(&g_latest_lock);
+    
+    latest_slot_t *slot = find_latest_slot(ctx, event->event_type, event->sender_id, true);
+    if (slot == NULL) {
+        portEXIT_CRITICAL(&g_latest_lock);
+        ESP_LOGD(TAG, "No latest slot for event %d, queueing normally", event->event_type);
+        return true;
+    }
+    
+    if (++g_latest_generation == LATEST_ANY) {
+        g_latest_generation++;
+    }
+    
+    if (slot->pending) {
+        *out_stale = slot->event.data;
+        slot->event = *event;
+        slot->generation = g_latest_generation;
+        portEXIT_CRITICAL(&g_latest_lock);
+        return false;
+    }
+    
+    slot->event = *event;
+    slot->generation = g_latest_generation;
+    slot->pending = true;
+    
+    portEXIT_CRITICAL(&g_latest_lock);
+    
+    *out_marker = g_latest_generation;
+    event->data = NULL;
+    event->data_size = 0;
+    return true;
+}
+
+/**
+ * @brief Undo coalesce_locked() for a marker that is not queued
+ * 
+ * @param generation Cancel only the value parked with it, or LATEST_ANY
+ * @param out_payload Payload of the parked value, for the caller to free
+ * @return false if the slot holds a different value by now
+ */
+static bool coalesce_cancel(system_context_t *ctx,
+                            system_event_type_t event_type,
+                            system_service_id_t sender_id,
+                            uint32_t generation,
+                            void **out_payload)
+{
+    bool cancelled = true;
+    *out_payload = NULL;
+    
+    portENTER_CRITICAL(&g_latest_lock);
+    
+    latest_slot_t *slot = find_latest_slot(ctx, event_type, sender_id, false);
+    if (slot != NULL && slot->pending) {
+        if (generation != LATEST_ANY && slot->generation != generation) {
+            cancelled = false;
+        } else {
+            *out_payload = slot->event.data;
+            slot->event.data = NULL;
+            slot->pending = false;
+            slot->in_use = false;
+        }
+    }
+    
+    portEXIT_CRITICAL(&g_latest_lock);
+    
+    return cancelled;
+}
+
+/**
+ * @brief Deal with a marker whose post failed
+ * 
+ * While the post waited, another one from the same sender may have
+ * replaced the parked value and been told it was delivered; that value
+ * keeps the slot, and the marker is queued for it once more without
+ * waiting. Only if that fails too is the value given up, the slot must
+ * not stay pending with no marker queued.
+ * 
+ * @param out_payload Payload to free if the marker is not queued
+ * @return ESP_OK if the marker got queued after all
+ */
+static esp_err_t coalesce_unqueued(system_context_t *ctx,
+                                   const system_event_t *marker,
+                                   uint32_t generation,
+                                   void **out_payload)
+{
+    if (coalesce_cancel(ctx, marker->event_type, marker->sender_id, generation, out_payload)) {
+        return ESP_FAIL;
+    }
+    
+    if (priority_queue_post(ctx->event_queue, marker, 0) == ESP_OK) {
+        return ESP_OK;
+    }
+    
+    ESP_LOGW(TAG, "Dropped latest value of event %d from service %d, queue full",
+             marker->event_type, marker->sender_id);
+    coalesce_cancel(ctx, marker->event_type, marker->sender_id, LATEST_ANY, out_payload);
+    return ESP_FAIL;
+}
+
+bool system_event_take_latest(system_context_t *ctx, system_event_t *event)
+{
+    if (event->event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        ctx->event_types[event->event_type].mode != SYSTEM_EVENT_TOPIC_LATEST) {
+        return true;
+    }
+    
+    portENTER_CRITICAL(&g_latest_lock);
+    
+    latest_slot_t *slot = find_latest_slot(ctx, event->event_type, event->sender_id, false);
+    if (slot == NULL) {
+        // Queued normally because no slot was free
+        portEXIT_CRITICAL(&g_latest_lock);
+        return true;
+    }
+    
+    if (!slot->pending) {
+        slot->in_use = false;
+        portEXIT_CRITICAL(&g_latest_lock);
+        return false;
+    }
+    
+    // Marker carries no payload, the slot's value replaces it
+    uint32_t sequence = event->sequence_number;
+    *event = slot->event;
+    event->sequence_number = sequence;
+    
+    // Free for any (type, sender) again, or senders that come and go
+    // would use the slots up for good
+    slot->event.data = NULL;
+    slot->pending = false;
+    slot->in_use = false;
+    
+    portEXIT_CRITICAL(&g_latest_lock);
+    
+    return true;
+}
+
+void system_event_on_drop(system_event_t *event)
+{
+    system_context_t *ctx = system_get_context();
+    
+    if (event->data == NULL && event->event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES &&
+        ctx->event_types[event->event_type].mode == SYSTEM_EVENT_TOPIC_LATEST) {
+        // Left pending, every later post would only replace it in place
+        void *payload;
+        coalesce_cancel(ctx, event->event_type, event->sender_id, LATEST_ANY, &payload);
+        memory_pool_free(payload);
+        return;
+    }
+    
+    if (event->data != NULL) {
+        memory_pool_free(event->data);
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
 esp_err_t system_event_register_type(const char *event_name,
                                       system_event_type_t *out_event_type)
 {
-    if (event_name == NULL || out_event_type == NULL) {
+    return system_event_register_topic(event_name, SYSTEM_EVENT_TOPIC_QUEUED, out_event_type);
+}
+
+esp_err_t system_event_register_topic(const char *event_name,
+                                       system_event_topic_mode_t mode,
+                                       system_event_type_t *out_event_type)
+{
+    if (event_name == NULL || out_event_type == NULL ||
+        mode > SYSTEM_EVENT_TOPIC_LATEST) {
         return ESP_ERR_INVALID_ARG;
     }
     
@@ -38,14 +587,17 @@ esp_err_t system_event_register_type(const char *event_name,
     }
     
     // Check if already registered
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
-        if (ctx->event_types[i].registered &&
-            strcmp(ctx->event_types[i].event_name, event_name) == 0) {
-            *out_event_type = ctx->event_types[i].event_type;
-            system_unlock();
-            ESP_LOGD(TAG, "Event type '%s' already registered", event_name);
-            return ESP_OK;
+    uint32_t hash = system_event_name_hash(event_name);
+    int existing = type_index_find(ctx, hash, event_name);
+    if (existing >= 0) {
+        // A producer declaring a latest-value topic wins over plain lookups
+        if (mode == SYSTEM_EVENT_TOPIC_LATEST) {
+            ctx->event_types[existing].mode = mode;
         }
+        *out_event_type = ctx->event_types[existing].event_type;
+        system_unlock();
+        ESP_LOGD(TAG, "Event type '%s' already registered", event_name);
+        return ESP_OK;
     }
     
     if (ctx->event_type_count >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
@@ -54,9 +606,9 @@ esp_err_t system_event_register_type(const char *event_name,
         return ESP_ERR_EVENT_TYPE_REGISTRY_FULL;
     }
     
-    // Find free slot
+    // Find free slot; IDs below SYSTEM_EVENT_STATIC_TYPES belong to schemas
     int slot = -1;
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
+    for (int i = SYSTEM_EVENT_STATIC_TYPES; i < SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
         if (!ctx->event_types[i].registered) {
             slot = i;
             break;
@@ -71,8 +623,20 @@ esp_err_t system_event_register_type(const char *event_name,
     strncpy(ctx->event_types[slot].event_name, event_name, SYSTEM_SERVICE_MAX_NAME_LEN - 1);
     ctx->event_types[slot].event_name[SYSTEM_SERVICE_MAX_NAME_LEN - 1] = '\0';
     ctx->event_types[slot].event_type = (system_event_type_t)slot;
+    ctx->event_types[slot].first_subscription = SUBSCRIPTION_INDEX_NONE;
+    ctx->event_types[slot].last_subscription = SUBSCRIPTION_INDEX_NONE;
+    ctx->event_types[slot].subscriber_count = 0;
+    ctx->event_types[slot].mode = mode;
+    ctx->event_types[slot].name_hash = hash;
+    ctx->event_types[slot].payload_size = 0;
+    ctx->event_types[slot].version = 0;
+    ctx->event_types[slot].deadline_us = 0;
+    type_attach_wildcards(ctx, &ctx->event_types[slot]);
     ctx->event_types[slot].registered = true;
     
+    // Publish to lock-free readers only once the entry is complete
+    type_index_insert(ctx, hash, (uint16_t)slot);
+    
     *out_event_type = ctx->event_types[slot].event_type;
     ctx->event_type_count++;
     
@@ -87,11 +651,25 @@ esp_err_t system_event_subscribe(system_service_id_t service_id,
                                   system_event_type_t event_type,
                                   system_event_handler_t handler,
                                   void *user_data)
+{
+    return system_event_subscribe_filtered(service_id, event_type, handler, user_data, NULL);
+}
+
+esp_err_t system_event_subscribe_filtered(system_service_id_t service_id,
+                                          system_event_type_t event_type,
+                                          system_event_handler_t handler,
+                                          void *user_data,
+                                          const system_event_filter_t *filter)
 {
     if (handler == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
+    if (filter != NULL && filter->match_size != 0 && filter->match_size != 1 &&
+        filter->match_size != 2 && filter->match_size != 4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     system_context_t *ctx = system_get_context();
     if (!ctx->initialized) {
         return ESP_ERR_SYSTEM_NOT_INITIALIZED;
@@ -124,11 +702,11 @@ esp_err_t system_event_subscribe(system_service_id_t service_id,
         return ESP_ERR_EVENT_TYPE_NOT_FOUND;
     }
     
-    // Check if already subscribed
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_SUBSCRIBERS; i++) {
-        if (ctx->subscriptions[i].active &&
-            ctx->subscriptions[i].service_id == service_id &&
-            ctx->subscriptions[i].event_type == event_type) {
+    // Check if already subscribed (only this type's chain needs scanning)
+    for (uint16_t i = ctx->event_types[event_type].first_subscription;
+         i != SUBSCRIPTION_INDEX_NONE;
+         i = ctx->subscriptions[i].next_in_type) {
+        if (ctx->subscriptions[i].service_id == service_id) {
             ESP_LOGD(TAG, "Service %d already subscribed to event %d", service_id, event_type);
             system_unlock();
             return ESP_OK;
@@ -154,18 +732,25 @@ esp_err_t system_event_subscribe(system_service_id_t service_id,
     ctx->subscriptions[slot].event_type = event_type;
     ctx->subscriptions[slot].handler = handler;
     ctx->subscriptions[slot].user_data = user_data;
+    if (filter != NULL) {
+        ctx->subscriptions[slot].filter = *filter;
+    } else {
+        memset(&ctx->subscriptions[slot].filter, 0, sizeof(ctx->subscriptions[slot].filter));
+    }
+    ctx->subscriptions[slot].affinity = SYSTEM_EVENT_AFFINITY_ANY;
     ctx->subscriptions[slot].active = true;
     ctx->subscription_count++;
+    system_subscription_link(ctx, (uint16_t)slot);
     
     system_unlock();
     
-    // Track subscription for auto-cleanup
-    app_lifecycle_track_subscription(service_id, event_type);
-    
     // Record in quota system
     quota_record_subscription(service_id, true);
     
-    ESP_LOGI(TAG, "Service %d subscribed to event type %d", service_id, event_type);
+    // An activatable service whose topic this is comes up to serve it
+    service_activation_on_subscribe(service_id, event_type);
+    
+    SYSTEM_LOGI(service_id, TAG, "Service %d subscribed to event type %d", service_id, event_type);
     
     return ESP_OK;
 }
@@ -188,14 +773,17 @@ esp_err_t system_event_unsubscribe(system_service_id_t service_id,
     }
     
     bool found = false;
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_SUBSCRIBERS; i++) {
-        if (ctx->subscriptions[i].active &&
-            ctx->subscriptions[i].service_id == service_id &&
-            ctx->subscriptions[i].event_type == event_type) {
-            ctx->subscriptions[i].active = false;
-            ctx->subscription_count--;
-            found = true;
-            break;
+    if (event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        for (uint16_t i = ctx->event_types[event_type].first_subscription;
+             i != SUBSCRIPTION_INDEX_NONE;
+             i = ctx->subscriptions[i].next_in_type) {
+            if (ctx->subscriptions[i].service_id == service_id) {
+                system_subscription_unlink(ctx, i);
+                ctx->subscriptions[i].active = false;
+                ctx->subscription_count--;
+                found = true;
+                break;
+            }
         }
     }
     
@@ -205,62 +793,238 @@ esp_err_t system_event_unsubscribe(system_service_id_t service_id,
         return ESP_ERR_EVENT_SUBSCRIPTION_NOT_FOUND;
     }
     
-    // Untrack subscription
-    app_lifecycle_untrack_subscription(service_id, event_type);
-    
     // Update quota
     quota_record_subscription(service_id, false);
     
-    ESP_LOGI(TAG, "Service %d unsubscribed from event type %d", service_id, event_type);
+    SYSTEM_LOGI(service_id, TAG, "Service %d unsubscribed from event type %d", service_id, event_type);
     
     return ESP_OK;
 }
 
-esp_err_t system_event_post(system_service_id_t sender_id,
-                            system_event_type_t event_type,
-                            const void *data,
-                            size_t data_size,
-                            system_event_priority_t priority)
+esp_err_t system_event_subscribe_pattern(system_service_id_t service_id,
+                                         const char *pattern,
+                                         system_event_handler_t handler,
+                                         void *user_data)
 {
+    if (handler == NULL || !topic_pattern_valid(pattern)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     system_context_t *ctx = system_get_context();
-    if (!ctx->initialized || !ctx->running) {
-        return ESP_ERR_SYSTEM_NOT_STARTED;
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
     }
     
-    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Check event posting quota
-    esp_err_t ret = quota_check_event_post(sender_id);
+    // A wildcard counts as one subscription against the quota
+    esp_err_t ret = quota_check_subscription(service_id);
     if (ret != ESP_OK) {
         return ret;
     }
     
-    // Check data size quota
-    ret = quota_check_data_size(sender_id, data_size);
+    ret = system_lock();
     if (ret != ESP_OK) {
         return ret;
     }
     
-    if (data_size > SYSTEM_MAX_DATA_SIZE) {
-        ESP_LOGE(TAG, "Data size %zu exceeds maximum %d", data_size, SYSTEM_MAX_DATA_SIZE);
-        return ESP_ERR_EVENT_DATA_TOO_LARGE;
+    if (!ctx->services[service_id].registered) {
+        system_unlock();
+        return ESP_ERR_SERVICE_NOT_FOUND;
     }
     
-    ret = system_lock();
+    int slot = -1;
+    for (int w = 0; w < SYSTEM_SERVICE_MAX_WILDCARDS; w++) {
+        topic_wildcard_t *wildcard = &ctx->wildcards[w];
+        if (wildcard->active && wildcard->service_id == service_id &&
+            strcmp(wildcard->pattern, pattern) == 0) {
+            system_unlock();
+            return ESP_OK;
+        }
+        if (slot < 0 && !wildcard->active) {
+            slot = w;
+        }
+    }
+    
+    if (slot < 0) {
+        ESP_LOGE(TAG, "Maximum wildcard subscriptions reached");
+        system_unlock();
+        return ESP_ERR_EVENT_SUBSCRIPTION_FULL;
+    }
+    
+    topic_wildcard_t *wildcard = &ctx->wildcards[slot];
+    strlcpy(wildcard->pattern, pattern, sizeof(wildcard->pattern));
+    wildcard->service_id = service_id;
+    wildcard->handler = handler;
+    wildcard->user_data = user_data;
+    
+    subscription_write_begin(ctx);
+    wildcard->active = true;
+    wildcard_expand_t expand = { .ctx = ctx, .bit = 1u << slot };
+    topic_trie_match(pattern, wildcard_mark_type, &expand);
+    system_metric_gauge_add(SYSTEM_METRIC_SUBSCRIPTIONS, 1);
+    subscription_write_end(ctx);
+    
+    system_unlock();
+    
+    quota_record_subscription(service_id, true);
+    
+    service_activation_on_pattern(service_id, pattern);
+    
+    SYSTEM_LOGI(service_id, TAG, "Service %d subscribed to '%s'", service_id, wildcard->pattern);
+    
+    return ESP_OK;
+}
+
+esp_err_t system_event_unsubscribe_pattern(system_service_id_t service_id,
+                                           const char *pattern)
+{
+    if (pattern == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = system_lock();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    bool found = false;
+    for (int w = 0; w < SYSTEM_SERVICE_MAX_WILDCARDS; w++) {
+        if (ctx->wildcards[w].active && ctx->wildcards[w].service_id == service_id &&
+            strcmp(ctx->wildcards[w].pattern, pattern) == 0) {
+            subscription_write_begin(ctx);
+            wildcard_remove_locked(ctx, w);
+            subscription_write_end(ctx);
+            found = true;
+            break;
+        }
+    }
+    
+    system_unlock();
+    
+    if (!found) {
+        return ESP_ERR_EVENT_SUBSCRIPTION_NOT_FOUND;
+    }
+    
+    quota_record_subscription(service_id, false);
+    
+    return ESP_OK;
+}
+
+esp_err_t system_event_unsubscribe_all(system_service_id_t service_id, uint32_t *out_count)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = system_lock();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    uint16_t dropped = system_subscription_drop_service(ctx, service_id);
+    
+    system_unlock();
+    
+    quota_release_subscriptions(service_id, dropped);
+    
+    if (out_count != NULL) {
+        *out_count = dropped;
+    }
+    
+    if (dropped > 0) {
+        SYSTEM_LOGI(service_id, TAG, "Service %d unsubscribed from %u event types", service_id, dropped);
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Checks that run before any payload is allocated or copied
+ */
+static esp_err_t event_post_prepare(system_context_t *ctx,
+                                    system_service_id_t sender_id,
+                                    system_event_type_t event_type,
+                                    size_t data_size)
+{
+    if (!ctx->initialized || !ctx->running) {
+        return ESP_ERR_SYSTEM_NOT_STARTED;
+    }
+    
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Check data size quota
+    esp_err_t ret = quota_check_data_size(sender_id, data_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    if (data_size > SYSTEM_MAX_DATA_SIZE) {
+        ESP_LOGE(TAG, "Data size %zu exceeds maximum %d", data_size, SYSTEM_MAX_DATA_SIZE);
+        return ESP_ERR_EVENT_DATA_TOO_LARGE;
+    }
+    
+    // Take the rate token last; callers give it back if the post fails
+    return quota_take_event(sender_id, event_type);
+}
+
+/**
+ * @brief Queue an event whose payload is already a pool block
+ *
+ * Takes ownership of payload: it is released here on any failure and by
+ * the dispatcher after delivery otherwise. A queued event holds one of the
+ * sender's credits; with timeout_ms 0 a full queue fails straight away.
+ */
+static esp_err_t event_post_commit(system_context_t *ctx,
+                                   system_service_id_t sender_id,
+                                   system_event_type_t event_type,
+                                   void *payload,
+                                   size_t data_size,
+                                   system_event_priority_t priority,
+                                   uint32_t timeout_ms)
+{
+    if (!event_credit_acquire(sender_id, 1)) {
+        memory_pool_free(payload);
+        return ESP_ERR_EVENT_QUEUE_FULL;
+    }
+    
+    esp_err_t ret = system_lock();
     if (ret != ESP_OK) {
+        event_credit_release(sender_id, 1);
+        memory_pool_free(payload);
         return ret;
     }
     
     if (!ctx->services[sender_id].registered) {
         system_unlock();
+        event_credit_release(sender_id, 1);
+        memory_pool_free(payload);
         return ESP_ERR_SERVICE_NOT_FOUND;
     }
     
     if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
         !ctx->event_types[event_type].registered) {
         system_unlock();
+        event_credit_release(sender_id, 1);
+        memory_pool_free(payload);
         return ESP_ERR_EVENT_TYPE_NOT_FOUND;
     }
     
@@ -268,30 +1032,43 @@ esp_err_t system_event_post(system_service_id_t sender_id,
     event.event_type = event_type;
     event.priority = priority;
     event.sender_id = sender_id;
-    event.timestamp = (uint32_t)(esp_timer_get_time() / 1000);
-    event.data_size = data_size;
+    int64_t now_us = esp_timer_get_time();
+    event.timestamp = (uint32_t)(now_us / 1000);
+    event.post_time_us = (uint32_t)now_us;
+    event.data = payload;
+    event.data_size = (payload != NULL) ? data_size : 0;
     
-    // Use memory pool for event data allocation
-    if (data != NULL && data_size > 0) {
-        event.data = memory_pool_alloc(data_size);
-        if (event.data == NULL) {
-            system_unlock();
-            ESP_LOGE(TAG, "Failed to allocate event data");
-            return ESP_ERR_NO_MEM;
-        }
-        memcpy(event.data, data, data_size);
-    }
+    metrics_registry_service_posted(sender_id, 1);
     
-    ctx->services[sender_id].event_count++;
-    ctx->total_events_posted++;
+    void *stale = NULL;
+    uint32_t marker = 0;
+    bool needs_queue = coalesce_locked(ctx, &event, &marker, &stale);
     
     system_unlock();
     
+    if (!needs_queue) {
+        // Replaced a pending value in place
+        event_credit_release(sender_id, 1);
+        memory_pool_free(stale);
+        quota_record_event_post(sender_id);
+        SYSTEM_TRACE(SYSTEM_TRACE_EVENT_POST, event_type, sender_id | ((uint32_t)priority << 16));
+        return ESP_OK;
+    }
+    
     // Post to priority queue instead of simple queue
-    ret = priority_queue_post(ctx->event_queue, &event, 100);
+    ret = priority_queue_post(ctx->event_queue, &event, timeout_ms);
+    void *unposted = event.data;
+    if (ret != ESP_OK && marker != 0 &&
+        coalesce_unqueued(ctx, &event, marker, &unposted) == ESP_OK) {
+        // Superseded while waiting, the newer value went out for both
+        ret = ESP_OK;
+    }
     if (ret != ESP_OK) {
-        if (event.data != NULL) {
-            memory_pool_free(event.data);
+        memory_pool_free(unposted);
+        event_credit_release(sender_id, 1);
+        event_credit_throttle(sender_id);
+        if (timeout_ms == 0) {
+            return ESP_ERR_EVENT_QUEUE_FULL;
         }
         ESP_LOGE(TAG, "Failed to post event to priority queue: %s", 
                  system_service_err_to_name(ret));
@@ -300,10 +1077,309 @@ esp_err_t system_event_post(system_service_id_t sender_id,
     
     // Record event posting in quota
     quota_record_event_post(sender_id);
+    SYSTEM_TRACE(SYSTEM_TRACE_EVENT_POST, event_type, sender_id | ((uint32_t)priority << 16));
     
     return ESP_OK;
 }
 
+/**
+ * @brief Copy a payload into a pool block and queue it
+ */
+static esp_err_t event_post_copy(system_service_id_t sender_id,
+                                 system_event_type_t event_type,
+                                 const void *data,
+                                 size_t data_size,
+                                 system_event_priority_t priority,
+                                 uint32_t timeout_ms)
+{
+    system_context_t *ctx = system_get_context();
+    
+    esp_err_t ret = event_post_prepare(ctx, sender_id, event_type, data_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Use memory pool for event data allocation
+    void *payload = NULL;
+    if (data != NULL && data_size > 0) {
+        payload = memory_pool_alloc(data_size);
+        if (payload == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate event data");
+            quota_return_event(sender_id, event_type);
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(payload, data, data_size);
+    }
+    
+    ret = event_post_commit(ctx, sender_id, event_type, payload, data_size, priority, timeout_ms);
+    if (ret != ESP_OK) {
+        quota_return_event(sender_id, event_type);
+    }
+    return ret;
+}
+
+esp_err_t system_event_post(system_service_id_t sender_id,
+                            system_event_type_t event_type,
+                            const void *data,
+                            size_t data_size,
+                            system_event_priority_t priority)
+{
+    return event_post_copy(sender_id, event_type, data, data_size, priority, 100);
+}
+
+esp_err_t system_event_try_post(system_service_id_t sender_id,
+                                system_event_type_t event_type,
+                                const void *data,
+                                size_t data_size,
+                                system_event_priority_t priority)
+{
+    return event_post_copy(sender_id, event_type, data, data_size, priority, 0);
+}
+
+/**
+ * @brief Take tokens for a whole batch, all or nothing
+ *
+ * The service bucket is charged once for count; per-type budgets, if the
+ * sender has any, are charged entry by entry.
+ */
+static esp_err_t batch_take_quota(system_service_id_t sender_id,
+                                  const system_event_batch_entry_t *entries,
+                                  size_t count)
+{
+    size_t taken = 0;
+    esp_err_t ret = ESP_OK;
+    
+    for (; taken < count; taken++) {
+        ret = quota_take_type_events(sender_id, entries[taken].event_type, 1);
+        if (ret != ESP_OK) {
+            break;
+        }
+    }
+    
+    if (ret == ESP_OK) {
+        ret = quota_take_events(sender_id, (uint32_t)count);
+        if (ret == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    
+    for (size_t i = 0; i < taken; i++) {
+        quota_return_type_events(sender_id, entries[i].event_type, 1);
+    }
+    return ret;
+}
+
+/**
+ * @brief Give back what batch_take_quota() took
+ */
+static void batch_return_quota(system_service_id_t sender_id,
+                               const system_event_batch_entry_t *entries,
+                               size_t count)
+{
+    quota_return_events(sender_id, (uint32_t)count);
+    for (size_t i = 0; i < count; i++) {
+        quota_return_type_events(sender_id, entries[i].event_type, 1);
+    }
+}
+
+static void release_payloads(system_event_t *events, size_t from, size_t to)
+{
+    for (size_t i = from; i < to; i++) {
+        memory_pool_free(events[i].data);
+    }
+}
+
+esp_err_t system_event_post_batch(system_service_id_t sender_id,
+                                  const system_event_batch_entry_t *entries,
+                                  size_t count,
+                                  size_t *out_posted)
+{
+    if (out_posted != NULL) {
+        *out_posted = 0;
+    }
+    
+    if (entries == NULL || count == 0 || count > SYSTEM_EVENT_BATCH_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized || !ctx->running) {
+        return ESP_ERR_SYSTEM_NOT_STARTED;
+    }
+    
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Quota checks once for the whole batch
+    size_t largest = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].data_size > largest) {
+            largest = entries[i].data_size;
+        }
+    }
+    
+    esp_err_t ret = quota_check_data_size(sender_id, largest);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    if (largest > SYSTEM_MAX_DATA_SIZE) {
+        ESP_LOGE(TAG, "Data size %zu exceeds maximum %d", largest, SYSTEM_MAX_DATA_SIZE);
+        return ESP_ERR_EVENT_DATA_TOO_LARGE;
+    }
+    
+    ret = batch_take_quota(sender_id, entries, count);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    if (!event_credit_acquire(sender_id, (uint32_t)count)) {
+        batch_return_quota(sender_id, entries, count);
+        return ESP_ERR_EVENT_QUEUE_FULL;
+    }
+    
+    system_event_t events[SYSTEM_EVENT_BATCH_MAX];
+    memset(events, 0, sizeof(system_event_t) * count);
+    
+    // Copy payloads outside the system lock
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].data != NULL && entries[i].data_size > 0) {
+            events[i].data = memory_pool_alloc(entries[i].data_size);
+            if (events[i].data == NULL) {
+                ESP_LOGE(TAG, "Failed to allocate event data");
+                release_payloads(events, 0, count);
+                batch_return_quota(sender_id, entries, count);
+                event_credit_release(sender_id, (uint32_t)count);
+                return ESP_ERR_NO_MEM;
+            }
+            memcpy(events[i].data, entries[i].data, entries[i].data_size);
+            events[i].data_size = entries[i].data_size;
+        }
+    }
+    
+    ret = system_lock();
+    if (ret != ESP_OK) {
+        release_payloads(events, 0, count);
+        batch_return_quota(sender_id, entries, count);
+        event_credit_release(sender_id, (uint32_t)count);
+        return ret;
+    }
+    
+    if (!ctx->services[sender_id].registered) {
+        system_unlock();
+        release_payloads(events, 0, count);
+        batch_return_quota(sender_id, entries, count);
+        event_credit_release(sender_id, (uint32_t)count);
+        return ESP_ERR_SERVICE_NOT_FOUND;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    uint32_t timestamp = (uint32_t)(now_us / 1000);
+    for (size_t i = 0; i < count; i++) {
+        system_event_type_t event_type = entries[i].event_type;
+        if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+            !ctx->event_types[event_type].registered) {
+            system_unlock();
+            release_payloads(events, 0, count);
+            batch_return_quota(sender_id, entries, count);
+            event_credit_release(sender_id, (uint32_t)count);
+            return ESP_ERR_EVENT_TYPE_NOT_FOUND;
+        }
+    
+        events[i].event_type = event_type;
+        events[i].priority = entries[i].priority;
+        events[i].sender_id = sender_id;
+        events[i].timestamp = timestamp;
+        events[i].post_time_us = (uint32_t)now_us;
+    }
+    
+    metrics_registry_service_posted(sender_id, (uint32_t)count);
+    
+    // Fold latest-value topics in place; only the rest is queued
+    void *stale[SYSTEM_EVENT_BATCH_MAX];
+    uint32_t markers[SYSTEM_EVENT_BATCH_MAX];  // Generations, see coalesce_locked()
+    size_t absorbed = 0;
+    size_t queued = 0;
+    for (size_t i = 0; i < count; i++) {
+        system_event_t event = events[i];
+        uint32_t marker = 0;
+        void *old = NULL;
+        if (coalesce_locked(ctx, &event, &marker, &old)) {
+            markers[queued] = marker;
+            events[queued++] = event;
+        } else {
+            stale[absorbed++] = old;
+        }
+    }
+    
+    system_unlock();
+    
+    for (size_t i = 0; i < absorbed; i++) {
+        memory_pool_free(stale[i]);
+    }
+    
+    size_t posted = 0;
+    ret = ESP_OK;
+    if (queued > 0) {
+        ret = priority_queue_post_batch(ctx->event_queue, events, queued, 100, &posted);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Batch stopped after %zu of %zu events: %s",
+                     posted, queued, system_service_err_to_name(ret));
+        }
+    }
+    
+    // Markers of values replaced while the batch waited still go out;
+    // the rest are moved behind the posted ones, with what to free
+    void *unposted[SYSTEM_EVENT_BATCH_MAX];
+    size_t failed = queued;
+    for (size_t i = queued; i-- > posted;) {
+        void *payload = events[i].data;
+        if (markers[i] != 0 &&
+            coalesce_unqueued(ctx, &events[i], markers[i], &payload) == ESP_OK) {
+            continue;
+        }
+        failed--;
+        events[failed] = events[i];
+        unposted[failed] = payload;
+    }
+    posted = failed;
+    if (posted == queued) {
+        ret = ESP_OK;
+    }
+    
+    // Posts folded into a pending value count as delivered
+    size_t delivered = posted + absorbed;
+    
+#if CONFIG_SYSTEM_SERVICE_TRACE
+    for (size_t i = 0; i < posted; i++) {
+        SYSTEM_TRACE(SYSTEM_TRACE_EVENT_POST, events[i].event_type,
+                     sender_id | ((uint32_t)events[i].priority << 16));
+    }
+#endif
+    
+    if (delivered > 0) {
+        quota_record_event_batch(sender_id, (uint32_t)delivered);
+    }
+    
+    if (out_posted != NULL) {
+        *out_posted = delivered;
+    }
+    
+    // Release payloads, tokens and credits of anything that was not queued
+    quota_return_events(sender_id, (uint32_t)(count - delivered));
+    event_credit_release(sender_id, (uint32_t)(count - posted));
+    if (posted < queued) {
+        event_credit_throttle(sender_id);
+    }
+    for (size_t i = posted; i < queued; i++) {
+        quota_return_type_events(sender_id, events[i].event_type, 1);
+        memory_pool_free(unposted[i]);
+    }
+    
+    return ret;
+}
+
 esp_err_t system_event_post_async(system_service_id_t sender_id,
                                    system_event_type_t event_type,
                                    const void *data,
@@ -313,6 +1389,310 @@ esp_err_t system_event_post_async(system_service_id_t sender_id,
     return system_event_post(sender_id, event_type, data, data_size, priority);
 }
 
+/* ============================================================================
+ * Interrupt Posting
+ * ============================================================================ */
+
+esp_err_t IRAM_ATTR system_event_post_from_isr(system_service_id_t sender_id,
+                                               system_event_type_t event_type,
+                                               const void *data,
+                                               size_t data_size,
+                                               system_event_priority_t priority,
+                                               BaseType_t *higher_priority_task_woken)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized || !ctx->running) {
+        return ESP_ERR_SYSTEM_NOT_STARTED;
+    }
+    
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES ||
+        event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_event_t event = {0};
+    event.event_type = event_type;
+    event.priority = priority;
+    event.sender_id = sender_id;
+    int64_t now_us = esp_timer_get_time();
+    event.timestamp = (uint32_t)(now_us / 1000);
+    event.post_time_us = (uint32_t)now_us;
+    
+    esp_err_t ret = isr_event_ring_push(&event, data, data_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    priority_queue_wake_from_isr(ctx->event_queue, higher_priority_task_woken);
+    
+    return ESP_OK;
+}
+
+void system_event_drain_isr(void)
+{
+    system_context_t *ctx = system_get_context();
+    system_event_t event;
+    esp_err_t ret;
+    
+    while ((ret = isr_event_ring_pop(&event)) != ESP_ERR_NOT_FOUND) {
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Dropped ISR event %d: %s",
+                     event.event_type, system_service_err_to_name(ret));
+            continue;
+        }
+    
+        // Registration is checked here, not in the ISR. Never block: the
+        // caller is the only consumer of the priority queues.
+        ret = event_post_commit(ctx, event.sender_id, event.event_type,
+                                event.data, event.data_size, event.priority, 0);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Dropped ISR event %d: %s",
+                     event.event_type, system_service_err_to_name(ret));
+        }
+    }
+}
+
+/* ============================================================================
+ * Zero-Copy Payloads
+ * ============================================================================ */
+
+esp_err_t system_event_loan(size_t size, void **out_buffer)
+{
+    if (out_buffer == NULL || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *out_buffer = NULL;
+    
+    if (size > SYSTEM_MAX_DATA_SIZE) {
+        return ESP_ERR_EVENT_DATA_TOO_LARGE;
+    }
+    
+    void *buffer = memory_pool_alloc(size);
+    if (buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    *out_buffer = buffer;
+    return ESP_OK;
+}
+
+esp_err_t system_event_post_loaned(system_service_id_t sender_id,
+                                   system_event_type_t event_type,
+                                   void *buffer,
+                                   size_t data_size,
+                                   system_event_priority_t priority)
+{
+    system_context_t *ctx = system_get_context();
+    
+    esp_err_t ret = event_post_prepare(ctx, sender_id, event_type, data_size);
+    if (ret != ESP_OK) {
+        memory_pool_free(buffer);
+        return ret;
+    }
+    
+    ret = event_post_commit(ctx, sender_id, event_type, buffer, data_size, priority, 100);
+    if (ret != ESP_OK) {
+        quota_return_event(sender_id, event_type);
+    }
+    return ret;
+}
+
+void system_event_loan_cancel(void *buffer)
+{
+    memory_pool_free(buffer);
+}
+
+esp_err_t system_event_data_retain(const system_event_t *event)
+{
+    if (event == NULL || event->data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    return memory_pool_retain(event->data);
+}
+
+void system_event_data_release(const void *data)
+{
+    memory_pool_free((void *)data);
+}
+
+esp_err_t system_event_register_schema(const system_event_schema_t *schema, size_t count)
+{
+    if (schema == NULL && count > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        ESP_LOGE(TAG, "System service not initialized");
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    esp_err_t ret = system_lock();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    size_t added = 0;
+    for (size_t i = 0; i < count && ret == ESP_OK; i++) {
+        const system_event_schema_t *entry = &schema[i];
+        if (entry->name == NULL || entry->event_type >= SYSTEM_EVENT_STATIC_TYPES ||
+            entry->mode > SYSTEM_EVENT_TOPIC_LATEST) {
+            ret = ESP_ERR_INVALID_ARG;
+            break;
+        }
+    
+        event_type_entry_t *type = &ctx->event_types[entry->event_type];
+        if (type->registered) {
+            if (type->name_hash != entry->name_hash ||
+                strncmp(type->event_name, entry->name, SYSTEM_SERVICE_MAX_NAME_LEN - 1) != 0) {
+                ESP_LOGE(TAG, "Event type %d is '%s', schema says '%s'",
+                         entry->event_type, type->event_name, entry->name);
+                ret = ESP_ERR_INVALID_STATE;
+            }
+            continue;
+        }
+    
+        int existing = type_index_find(ctx, entry->name_hash, entry->name);
+        if (existing >= 0) {
+            ESP_LOGE(TAG, "Event type '%s' already registered with ID %d, schema says %d",
+                     entry->name, existing, entry->event_type);
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+    
+        strncpy(type->event_name, entry->name, SYSTEM_SERVICE_MAX_NAME_LEN - 1);
+        type->event_name[SYSTEM_SERVICE_MAX_NAME_LEN - 1] = '\0';
+        type->event_type = entry->event_type;
+        type->first_subscription = SUBSCRIPTION_INDEX_NONE;
+        type->last_subscription = SUBSCRIPTION_INDEX_NONE;
+        type->subscriber_count = 0;
+        type->mode = entry->mode;
+        type->name_hash = entry->name_hash;
+        type->payload_size = entry->payload_size;
+        type->version = entry->version;
+        type->deadline_us = 0;
+        type_attach_wildcards(ctx, type);
+        type->registered = true;
+    
+        type_index_insert(ctx, entry->name_hash, entry->event_type);
+        ctx->event_type_count++;
+        added++;
+    }
+    
+    system_unlock();
+    
+    if (added > 0) {
+        ESP_LOGI(TAG, "Registered %u schema event types", (unsigned)added);
+    }
+    
+    return ret;
+}
+
+esp_err_t system_event_get_schema(system_event_type_t event_type,
+                                  uint16_t *out_payload_size,
+                                  uint16_t *out_version)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        !ctx->event_types[event_type].registered) {
+        return ESP_ERR_EVENT_TYPE_NOT_FOUND;
+    }
+    
+    if (out_payload_size != NULL) {
+        *out_payload_size = ctx->event_types[event_type].payload_size;
+    }
+    if (out_version != NULL) {
+        *out_version = ctx->event_types[event_type].version;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t system_event_set_deadline(system_event_type_t event_type, uint32_t deadline_us)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        !ctx->event_types[event_type].registered) {
+        return ESP_ERR_EVENT_TYPE_NOT_FOUND;
+    }
+    
+    // Read by the dispatch workers without the lock
+    __atomic_store_n(&ctx->event_types[event_type].deadline_us, deadline_us, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t system_event_set_affinity(system_service_id_t service_id,
+                                    system_event_type_t event_type,
+                                    system_event_affinity_t affinity)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES || affinity > SYSTEM_EVENT_AFFINITY_UI) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    esp_err_t ret = system_lock();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    bool found = false;
+    if (event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        for (uint16_t i = ctx->event_types[event_type].first_subscription;
+             i != SUBSCRIPTION_INDEX_NONE;
+             i = ctx->subscriptions[i].next_in_type) {
+            if (ctx->subscriptions[i].service_id == service_id) {
+                // Copied out by the event task with the rest of the subscription
+                subscription_write_begin(ctx);
+                ctx->subscriptions[i].affinity = affinity;
+                subscription_write_end(ctx);
+                found = true;
+                break;
+            }
+        }
+    }
+    
+    system_unlock();
+    
+    return found ? ESP_OK : ESP_ERR_EVENT_SUBSCRIPTION_NOT_FOUND;
+}
+
+esp_err_t system_event_get_subscriber_count(system_event_type_t event_type, uint16_t *out_count)
+{
+    if (out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        !ctx->event_types[event_type].registered) {
+        return ESP_ERR_EVENT_TYPE_NOT_FOUND;
+    }
+    
+    // Without the lock: the count may change as soon as it is returned anyway
+    const event_type_entry_t *type = &ctx->event_types[event_type];
+    *out_count = __atomic_load_n(&type->subscriber_count, __ATOMIC_RELAXED) +
+                 __builtin_popcount(__atomic_load_n(&type->wildcard_mask, __ATOMIC_RELAXED));
+    return ESP_OK;
+}
+
 esp_err_t system_event_get_type_name(system_event_type_t event_type,
                                       char *out_name,
                                       size_t max_len)
@@ -344,3 +1724,31 @@ esp_err_t system_event_get_type_name(system_event_type_t event_type,
     
     return ESP_OK;
 }
+
+/* ============================================================================
+ * Backpressure
+ * ============================================================================ */
+
+esp_err_t system_event_get_credits(system_service_id_t sender_id,
+                                   uint32_t *out_remaining)
+{
+    if (out_remaining == NULL || sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *out_remaining = event_credit_available(sender_id);
+    return ESP_OK;
+}
+
+esp_err_t system_event_set_drain_callback(system_service_id_t sender_id,
+                                          uint32_t low_watermark,
+                                          system_event_drain_cb_t callback,
+                                          void *user_data)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_SYSTEM_NOT_INITIALIZED;
+    }
+    
+    return event_credit_set_drain_callback(sender_id, low_watermark, callback, user_data);
+}
@@ -0,0 +1,158 @@
+/**
+ * @file event_credit.c
+ * @brief Per-producer credits for the event queues
+ * 
+ * The in-flight count of each producer is a single word updated with
+ * compare-and-swap, so posting tasks and the event task never contend on
+ * a lock. Only the drain callback fields are guarded by a spinlock, and
+ * the callback itself is called after it is released.
+ */
+
+#include "event_credit.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "event_credit";
+
+/* ============================================================================
+ * Credit Table
+ * ============================================================================ */
+
+typedef struct {
+    volatile uint32_t in_flight;        /**< Events queued and not yet dispatched */
+    volatile bool throttled;            /**< A post was refused since the last drain */
+    uint32_t low_watermark;             /**< Backlog at which the callback fires */
+    system_event_drain_cb_t callback;   /**< Drain callback (can be NULL) */
+    void *user_data;                    /**< Passed to callback */
+} producer_credit_t;
+
+static producer_credit_t g_credits[SYSTEM_SERVICE_MAX_SERVICES];
+static portMUX_TYPE g_credit_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+void event_credit_init(void)
+{
+    portENTER_CRITICAL(&g_credit_lock);
+    memset(g_credits, 0, sizeof(g_credits));
+    for (size_t i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        g_credits[i].low_watermark = EVENT_CREDIT_LIMIT / 2;
+    }
+    portEXIT_CRITICAL(&g_credit_lock);
+    
+    ESP_LOGI(TAG, "Producer credits: %d per service", EVENT_CREDIT_LIMIT);
+}
+
+/* ============================================================================
+ * Credit Operations
+ * ============================================================================ */
+
+bool event_credit_acquire(system_service_id_t sender_id, uint32_t count)
+{
+    if (EVENT_CREDIT_LIMIT == 0 || count == 0) {
+        return true;
+    }
+    
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return false;
+    }
+    
+    producer_credit_t *credit = &g_credits[sender_id];
+    uint32_t in_flight = __atomic_load_n(&credit->in_flight, __ATOMIC_RELAXED);
+    do {
+        if (count > EVENT_CREDIT_LIMIT - in_flight) {
+            __atomic_store_n(&credit->throttled, true, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&credit->in_flight, &in_flight, in_flight + count,
+                                          true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    
+    return true;
+}
+
+void event_credit_release(system_service_id_t sender_id, uint32_t count)
+{
+    if (EVENT_CREDIT_LIMIT == 0 || count == 0 || sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return;
+    }
+    
+    producer_credit_t *credit = &g_credits[sender_id];
+    uint32_t in_flight = __atomic_load_n(&credit->in_flight, __ATOMIC_RELAXED);
+    uint32_t next;
+    do {
+        // Saturate: events queued before a reset carry no credit
+        next = (in_flight > count) ? in_flight - count : 0;
+    } while (!__atomic_compare_exchange_n(&credit->in_flight, &in_flight, next,
+                                          true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    
+    if (!__atomic_load_n(&credit->throttled, __ATOMIC_RELAXED)) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&g_credit_lock);
+    system_event_drain_cb_t callback = NULL;
+    void *user_data = NULL;
+    if (credit->throttled && next <= credit->low_watermark) {
+        credit->throttled = false;
+        callback = credit->callback;
+        user_data = credit->user_data;
+    }
+    portEXIT_CRITICAL(&g_credit_lock);
+    
+    if (callback != NULL) {
+        callback(sender_id, EVENT_CREDIT_LIMIT - next, user_data);
+    }
+}
+
+void event_credit_throttle(system_service_id_t sender_id)
+{
+    if (EVENT_CREDIT_LIMIT == 0 || sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return;
+    }
+    
+    __atomic_store_n(&g_credits[sender_id].throttled, true, __ATOMIC_RELAXED);
+}
+
+uint32_t event_credit_available(system_service_id_t sender_id)
+{
+    if (EVENT_CREDIT_LIMIT == 0) {
+        return UINT32_MAX;
+    }
+    
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return 0;
+    }
+    
+    uint32_t in_flight = __atomic_load_n(&g_credits[sender_id].in_flight, __ATOMIC_RELAXED);
+    return (in_flight < EVENT_CREDIT_LIMIT) ? EVENT_CREDIT_LIMIT - in_flight : 0;
+}
+
+esp_err_t event_credit_set_drain_callback(system_service_id_t sender_id,
+                                          uint32_t low_watermark,
+                                          system_event_drain_cb_t callback,
+                                          void *user_data)
+{
+    if (sender_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (EVENT_CREDIT_LIMIT == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    if (callback != NULL && low_watermark >= EVENT_CREDIT_LIMIT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&g_credit_lock);
+    g_credits[sender_id].callback = callback;
+    g_credits[sender_id].user_data = user_data;
+    g_credits[sender_id].low_watermark = (callback != NULL) ? low_watermark
+                                                            : EVENT_CREDIT_LIMIT / 2;
+    portEXIT_CRITICAL(&g_credit_lock);
+    
+    return ESP_OK;
+}
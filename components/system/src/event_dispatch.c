@@ -0,0 +1,1006 @@
+/**
+ * @file event_dispatch.c
+ * @brief Multi-worker event handler executor implementation
+ * 
+ * The event task resolves subscribers and submits one job per handler.
+ * Jobs are routed by subscriber ID, which keeps per-subscriber ordering
+ * without any locking between workers.
+ * 
+ * A subscription whose handler keeps running over the warning threshold
+ * is demoted to a deferred worker at lower priority, so it stops holding
+ * up the subscribers that share its worker. It is promoted back after a
+ * run of handlers within budget. Ordering between jobs queued before and
+ * after a switch is not guaranteed.
+ * 
+ * Jobs for a held subscriber are parked in a shared backlog and queued on
+ * its worker when it is released. The release drains the backlog while
+ * the subscriber is still held, so jobs arriving meanwhile are parked
+ * behind and nothing overtakes the replay.
+ * 
+ * A subscription with a core affinity is routed to the worker of that
+ * core in the subscriber's row, and one with the UI affinity to a queue
+ * the UI task drains between frames. That queue is created once and kept
+ * across restarts, since the UI task may be draining it at any time.
+ */
+
+#include "event_dispatch.h"
+#include "memory_pool.h"
+#include "handler_monitor.h"
+#include "event_latency.h"
+#include "metrics_registry.h"
+#include "system_internal.h"
+#include "system_service/error_codes.h"
+#include "system_service/common_events.h"
+#include "system_service/event_bus.h"
+#include "system_service/service_manager.h"
+#include "system_service/static_alloc.h"
+#include "system_service/power_lock.h"
+#include "system_service/system_trace.h"
+#include "system_service/system_log.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+
+static const char *TAG = "event_dispatch";
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+#define DISPATCH_CORE_COUNT         portNUM_PROCESSORS
+#define DISPATCH_WORKER_COUNT       (CONFIG_SYSTEM_SERVICE_DISPATCH_WORKERS_PER_CORE * DISPATCH_CORE_COUNT)
+#define DISPATCH_SUBMIT_TIMEOUT_MS  100
+#define CRITICAL_DEADLINE_US        (CONFIG_SYSTEM_SERVICE_CRITICAL_DEADLINE_MS * 1000)
+
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+/** Deferred worker for demoted subscriptions, after the regular workers */
+#define DISPATCH_DEFERRED_WORKER    DISPATCH_WORKER_COUNT
+#define DISPATCH_TOTAL_WORKERS      (DISPATCH_WORKER_COUNT + 1)
+#define QUARANTINE_SLOTS            CONFIG_SYSTEM_SERVICE_QUARANTINE_SLOTS
+#define QUARANTINE_BUDGET_US        (CONFIG_SYSTEM_SERVICE_HANDLER_WARN_THRESHOLD_MS * 1000)
+#else
+#define DISPATCH_TOTAL_WORKERS      DISPATCH_WORKER_COUNT
+#endif
+
+/* ============================================================================
+ * Worker State
+ * ============================================================================ */
+
+typedef struct {
+    system_event_t event;           /**< Event copy, data holds a job reference */
+    system_event_handler_t handler; /**< Handler to call (NULL stops the worker) */
+    void *user_data;                /**< Subscription user data */
+    system_service_id_t service_id; /**< Subscribing service */
+    system_event_affinity_t affinity; /**< Where the subscription wants to run */
+    uint32_t dequeue_us;            /**< When the event task dequeued the event */
+} dispatch_job_t;
+
+typedef struct {
+    QueueHandle_t jobs;             /**< Pending jobs for this worker */
+    TaskHandle_t task;              /**< Worker task */
+} dispatch_worker_t;
+
+static dispatch_worker_t g_workers[DISPATCH_TOTAL_WORKERS];
+static bool g_dispatch_running = false;
+
+/** Jobs with the UI affinity, drained by system_event_ui_run() while attached */
+static QueueHandle_t g_ui_jobs = NULL;
+static volatile bool g_ui_attached = false;
+
+#if CONFIG_SYSTEM_SERVICE_DISPATCH_POWER_LOCK
+/** Held by every worker while a handler runs; created once, kept across restarts */
+static system_power_lock_t g_dispatch_power_lock = NULL;
+#endif
+
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+/** Subscription that went over budget, tracked until it behaves again */
+typedef struct {
+    system_service_id_t service_id; /**< SYSTEM_SERVICE_ID_INVALID if free */
+    system_event_type_t event_type; /**< Subscribed event type */
+    uint8_t strikes;                /**< Over-budget runs, minus runs within budget */
+    uint8_t good_runs;              /**< Consecutive runs within budget while demoted */
+    bool demoted;                   /**< Routed to the deferred worker */
+} quarantine_entry_t;
+
+static quarantine_entry_t g_quarantine[QUARANTINE_SLOTS];
+static volatile uint32_t g_demoted_count = 0;
+static portMUX_TYPE g_quarantine_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Sender of demoted/promoted events */
+static system_service_id_t g_quarantine_service = SYSTEM_SERVICE_ID_INVALID;
+#endif
+
+#define PARK_SLOTS                  CONFIG_SYSTEM_SERVICE_HIBERNATE_BACKLOG
+
+/** Job of a held subscriber, waiting for the release */
+typedef struct {
+    dispatch_job_t job;             /**< Job, holding its payload reference */
+    uint32_t seq;                   /**< Arrival order, 0 if the slot is free */
+} parked_job_t;
+
+static parked_job_t g_parked[PARK_SLOTS];
+static bool g_held[SYSTEM_SERVICE_MAX_SERVICES];
+static uint32_t g_held_dropped[SYSTEM_SERVICE_MAX_SERVICES];
+static uint32_t g_park_seq = 0;
+static portMUX_TYPE g_park_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/** Deadline and critical lane accounting, see system_event_get_deadline_stats() */
+static system_event_deadline_stats_t g_deadline_stats;
+static portMUX_TYPE g_deadline_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+/** Reserved kernel object storage, one per worker */
+typedef struct {
+    StaticQueue_t queue;
+    StaticTask_t tcb;
+    uint8_t items[CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE * sizeof(dispatch_job_t)];
+    StackType_t stack[CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE / sizeof(StackType_t)];
+} dispatch_worker_storage_t;
+
+static dispatch_worker_storage_t g_worker_storage[DISPATCH_TOTAL_WORKERS];
+
+static StaticQueue_t g_ui_queue;
+static uint8_t g_ui_queue_items[CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE * sizeof(dispatch_job_t)];
+#endif
+
+/* ============================================================================
+ * Internal Helper Functions
+ * ============================================================================ */
+
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+
+/**
+ * @brief Find a subscription's entry, or claim a free one if create is set
+ * 
+ * Called with g_quarantine_lock held.
+ */
+static quarantine_entry_t* find_entry_locked(system_service_id_t service_id,
+                                             system_event_type_t event_type,
+                                             bool create)
+{
+    quarantine_entry_t *free_entry = NULL;
+    
+    for (int i = 0; i < QUARANTINE_SLOTS; i++) {
+        quarantine_entry_t *entry = &g_quarantine[i];
+        if (entry->service_id == service_id && entry->event_type == event_type) {
+            return entry;
+        }
+        if (free_entry == NULL && entry->service_id == SYSTEM_SERVICE_ID_INVALID) {
+            free_entry = entry;
+        }
+    }
+    
+    if (!create || free_entry == NULL) {
+        return NULL;
+    }
+    
+    memset(free_entry, 0, sizeof(*free_entry));
+    free_entry->service_id = service_id;
+    free_entry->event_type = event_type;
+    return free_entry;
+}
+
+static bool is_demoted(system_service_id_t service_id, system_event_type_t event_type)
+{
+    // Nothing to look up in the common case
+    if (__atomic_load_n(&g_demoted_count, __ATOMIC_RELAXED) == 0) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&g_quarantine_lock);
+    quarantine_entry_t *entry = find_entry_locked(service_id, event_type, false);
+    bool demoted = (entry != NULL && entry->demoted);
+    portEXIT_CRITICAL(&g_quarantine_lock);
+    
+    return demoted;
+}
+
+static void post_transition(const dispatch_job_t *job, uint32_t elapsed_us, bool demoted)
+{
+    if (demoted) {
+        ESP_LOGW(TAG, "Demoting service %d handler for event %d (%lu us over %d ms budget)",
+                 job->service_id, job->event.event_type, elapsed_us,
+                 CONFIG_SYSTEM_SERVICE_HANDLER_WARN_THRESHOLD_MS);
+    } else {
+        ESP_LOGI(TAG, "Promoting service %d handler for event %d back to its worker",
+                 job->service_id, job->event.event_type);
+    }
+    
+    if (g_quarantine_service == SYSTEM_SERVICE_ID_INVALID) {
+        return;
+    }
+    
+    common_handler_quarantine_t info = {
+        .service_id = job->service_id,
+        .event_type = job->event.event_type,
+        .last_run_us = elapsed_us,
+        .budget_us = QUARANTINE_BUDGET_US,
+    };
+    if (demoted) {
+        SYSTEM_EVENT_POST_TYPED(g_quarantine_service, COMMON_EVENT_HANDLER_DEMOTED,
+                                &info, SYSTEM_EVENT_PRIORITY_NORMAL);
+    } else {
+        SYSTEM_EVENT_POST_TYPED(g_quarantine_service, COMMON_EVENT_HANDLER_PROMOTED,
+                                &info, SYSTEM_EVENT_PRIORITY_NORMAL);
+    }
+}
+
+/**
+ * @brief Update a subscription's record after one handler run
+ * 
+ * Over-budget runs add a strike and runs within budget take one away, so
+ * occasional spikes are forgiven. CONFIG_SYSTEM_SERVICE_QUARANTINE_STRIKES
+ * strikes demote the subscription; CONFIG_SYSTEM_SERVICE_QUARANTINE_RECOVERY_RUNS
+ * consecutive runs within budget promote it again.
+ */
+static void quarantine_account(const dispatch_job_t *job, uint32_t elapsed_us)
+{
+    bool over = elapsed_us > QUARANTINE_BUDGET_US;
+    int transition = 0;
+    
+    portENTER_CRITICAL(&g_quarantine_lock);
+    quarantine_entry_t *entry = find_entry_locked(job->service_id, job->event.event_type, over);
+    if (entry != NULL) {
+        if (over) {
+            entry->good_runs = 0;
+            if (!entry->demoted && ++entry->strikes >= CONFIG_SYSTEM_SERVICE_QUARANTINE_STRIKES) {
+                entry->demoted = true;
+                g_demoted_count++;
+                transition = 1;
+            }
+        } else if (entry->demoted) {
+            if (++entry->good_runs >= CONFIG_SYSTEM_SERVICE_QUARANTINE_RECOVERY_RUNS) {
+                entry->service_id = SYSTEM_SERVICE_ID_INVALID;
+                g_demoted_count--;
+                transition = -1;
+            }
+        } else if (--entry->strikes == 0) {
+            entry->service_id = SYSTEM_SERVICE_ID_INVALID;
+        }
+    }
+    portEXIT_CRITICAL(&g_quarantine_lock);
+    
+    if (transition != 0) {
+        post_transition(job, elapsed_us, transition > 0);
+    }
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+
+static void release_job_payload(dispatch_job_t *job)
+{
+    if (job->event.data != NULL) {
+        memory_pool_free(job->event.data);
+    }
+}
+
+static bool is_latest_topic(system_event_type_t event_type)
+{
+    system_context_t *ctx = system_get_context();
+    return event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES &&
+           ctx->event_types[event_type].mode == SYSTEM_EVENT_TOPIC_LATEST;
+}
+
+static uint32_t park_next_seq_locked(void)
+{
+    if (++g_park_seq == 0) {
+        g_park_seq = 1;
+    }
+    return g_park_seq;
+}
+
+/**
+ * @brief Park a job of a held subscriber
+ * 
+ * Called with g_park_lock held. The job that has to go, whether replaced
+ * by a newer latest value, evicted as the oldest or refused for lack of
+ * room, is copied to out_dropped so its payload can be released outside
+ * the lock.
+ * 
+ * @return true if a job was dropped
+ */
+static bool park_job_locked(const dispatch_job_t *job, bool latest, dispatch_job_t *out_dropped)
+{
+    system_service_id_t service_id = job->service_id;
+    int free_slot = -1;
+    int oldest = -1;
+    
+    for (int i = 0; i < PARK_SLOTS; i++) {
+        parked_job_t *slot = &g_parked[i];
+        if (slot->seq == 0) {
+            if (free_slot < 0) {
+                free_slot = i;
+            }
+            continue;
+        }
+        if (slot->job.service_id != service_id) {
+            continue;
+        }
+        if (latest && slot->job.event.event_type == job->event.event_type &&
+            slot->job.event.sender_id == job->event.sender_id) {
+            // Only the newest value matters; it takes its place in arrival order
+            *out_dropped = slot->job;
+            slot->job = *job;
+            slot->seq = park_next_seq_locked();
+            g_held_dropped[service_id]++;
+            return true;
+        }
+        if (oldest < 0 || slot->seq < g_parked[oldest].seq) {
+            oldest = i;
+        }
+    }
+    
+    bool dropped = false;
+    if (free_slot < 0) {
+        g_held_dropped[service_id]++;
+        if (oldest < 0) {
+            // Backlog full with other subscribers' jobs
+            *out_dropped = *job;
+            return true;
+        }
+        *out_dropped = g_parked[oldest].job;
+        free_slot = oldest;
+        dropped = true;
+    }
+    
+    g_parked[free_slot].job = *job;
+    g_parked[free_slot].seq = park_next_seq_locked();
+    return dropped;
+}
+
+/* Called with g_park_lock held */
+static int oldest_parked_locked(system_service_id_t service_id)
+{
+    int oldest = -1;
+    for (int i = 0; i < PARK_SLOTS; i++) {
+        if (g_parked[i].seq != 0 && g_parked[i].job.service_id == service_id &&
+            (oldest < 0 || g_parked[i].seq < g_parked[oldest].seq)) {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+/* Drop every parked job; holds stay in place */
+static void release_parked_jobs(void)
+{
+    for (int i = 0; i < PARK_SLOTS; i++) {
+        dispatch_job_t job;
+        bool found = false;
+    
+        portENTER_CRITICAL(&g_park_lock);
+        if (g_parked[i].seq != 0) {
+            job = g_parked[i].job;
+            g_parked[i].seq = 0;
+            g_held_dropped[job.service_id]++;
+            found = true;
+        }
+        portEXIT_CRITICAL(&g_park_lock);
+    
+        if (found) {
+            release_job_payload(&job);
+        }
+    }
+}
+
+/* Deadline of the event type, or the Kconfig default for CRITICAL events; 0 for none */
+static uint32_t event_deadline_us(const system_event_t *event)
+{
+    uint32_t deadline_us = 0;
+    
+    if (event->event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        system_context_t *ctx = system_get_context();
+        deadline_us = __atomic_load_n(&ctx->event_types[event->event_type].deadline_us,
+                                      __ATOMIC_RELAXED);
+    }
+    
+    if (deadline_us == 0 && event->priority == SYSTEM_EVENT_PRIORITY_CRITICAL) {
+        deadline_us = CRITICAL_DEADLINE_US;
+    }
+    
+    return deadline_us;
+}
+
+/**
+ * @brief Check a finished handler against its event's deadline
+ * 
+ * The deadline runs from the post to the end of the handler, so it covers
+ * the time spent queued as well as the handler itself.
+ */
+static void deadline_account(const dispatch_job_t *job, uint32_t end_us)
+{
+    uint32_t deadline_us = event_deadline_us(&job->event);
+    if (deadline_us == 0) {
+        return;
+    }
+    
+    uint32_t elapsed_us = end_us - job->event.post_time_us;
+    bool missed = elapsed_us > deadline_us;
+    
+    portENTER_CRITICAL(&g_deadline_lock);
+    g_deadline_stats.checked++;
+    if (missed) {
+        g_deadline_stats.missed++;
+        if (elapsed_us - deadline_us > g_deadline_stats.worst_overrun_us) {
+            g_deadline_stats.worst_overrun_us = elapsed_us - deadline_us;
+            g_deadline_stats.worst_type = job->event.event_type;
+        }
+    }
+    portEXIT_CRITICAL(&g_deadline_lock);
+    
+    if (missed) {
+        system_metric_add(SYSTEM_METRIC_DEADLINE_MISSES, 1);
+        // Rate limited per subscriber, a late handler tends to stay late
+        SYSTEM_LOGW(job->service_id, TAG, "Event %d to service %d missed its %lu us deadline by %lu us",
+                    job->event.event_type, job->service_id, deadline_us, elapsed_us - deadline_us);
+    }
+}
+
+/* Returns when the handler finished */
+static uint32_t run_job(dispatch_job_t *job)
+{
+#if CONFIG_SYSTEM_SERVICE_DISPATCH_POWER_LOCK
+    system_power_lock_acquire(g_dispatch_power_lock);
+#endif
+    uint32_t start_us = event_latency_now_us();
+    SYSTEM_TRACE(SYSTEM_TRACE_HANDLER_BEGIN, job->event.event_type, job->service_id);
+    
+#if CONFIG_SYSTEM_SERVICE_ENABLE_HANDLER_MONITORING
+    esp_err_t ret = handler_monitor_execute(job->handler,
+                                            &job->event,
+                                            job->user_data,
+                                            job->service_id);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Handler for service %d returned error: %s",
+                 job->service_id, system_service_err_to_name(ret));
+    }
+#else
+    job->handler(&job->event, job->user_data);
+#endif
+    
+    uint32_t end_us = event_latency_now_us();
+    system_event_type_t type = job->event.event_type;
+    SYSTEM_TRACE(SYSTEM_TRACE_HANDLER_END, type, job->service_id);
+    metrics_registry_service_received(job->service_id);
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    system_metric_observe(SYSTEM_METRIC_HANDLER_US, end_us - start_us);
+#endif
+    event_latency_record(type, SYSTEM_EVENT_LATENCY_DISPATCH, job->dequeue_us, start_us);
+    event_latency_record(type, SYSTEM_EVENT_LATENCY_HANDLER, start_us, end_us);
+    event_latency_record(type, SYSTEM_EVENT_LATENCY_END_TO_END, job->event.post_time_us, end_us);
+    
+#if CONFIG_SYSTEM_SERVICE_DISPATCH_POWER_LOCK
+    system_power_lock_release(g_dispatch_power_lock);
+#endif
+    
+    deadline_account(job, end_us);
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+    quarantine_account(job, end_us - start_us);
+#endif
+    
+    return end_us;
+}
+
+static void worker_task(void *arg)
+{
+    dispatch_worker_t *worker = (dispatch_worker_t *)arg;
+    dispatch_job_t job;
+    
+    while (true) {
+        if (xQueueReceive(worker->jobs, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+    
+        if (job.handler == NULL) {
+            break;
+        }
+    
+        (void)run_job(&job);
+    
+        // Drop the job reference taken at submit time
+        if (job.event.data != NULL) {
+            memory_pool_free(job.event.data);
+        }
+    }
+    
+    worker->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static void release_pending_jobs(QueueHandle_t jobs)
+{
+    dispatch_job_t job;
+    while (xQueueReceive(jobs, &job, 0) == pdTRUE) {
+        if (job.event.data != NULL) {
+            memory_pool_free(job.event.data);
+        }
+    }
+}
+
+static void shutdown_workers(void)
+{
+    // Queue a stop job behind any pending work on each worker
+    dispatch_job_t stop_job = {0};
+    for (int i = 0; i < DISPATCH_TOTAL_WORKERS; i++) {
+        if (g_workers[i].task != NULL) {
+            xQueueSend(g_workers[i].jobs, &stop_job, portMAX_DELAY);
+        }
+    }
+    
+    // Wait for workers to finish their current handler and exit
+    for (int i = 0; i < DISPATCH_TOTAL_WORKERS; i++) {
+        while (g_workers[i].task != NULL) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    
+    for (int i = 0; i < DISPATCH_TOTAL_WORKERS; i++) {
+        if (g_workers[i].jobs != NULL) {
+            release_pending_jobs(g_workers[i].jobs);
+            vQueueDelete(g_workers[i].jobs);
+            g_workers[i].jobs = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Park a job if its subscriber is held
+ * 
+ * The job must hold its own payload reference, which the backlog takes
+ * over. Returns false, keeping the job, if the subscriber is not held.
+ */
+static bool park_if_held(dispatch_job_t *job)
+{
+    system_service_id_t service_id = job->service_id;
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return false;
+    }
+    
+    bool latest = is_latest_topic(job->event.event_type);
+    bool parked = false;
+    bool dropped = false;
+    dispatch_job_t dropped_job;
+    
+    portENTER_CRITICAL(&g_park_lock);
+    if (g_held[service_id]) {
+        parked = true;
+        dropped = park_job_locked(job, latest, &dropped_job);
+    }
+    portEXIT_CRITICAL(&g_park_lock);
+    
+    if (dropped) {
+        release_job_payload(&dropped_job);
+    }
+    
+    return parked;
+}
+
+/* Queue a job's affinity asks for, from the subscriber's row of workers */
+static QueueHandle_t job_queue(const dispatch_job_t *job)
+{
+    int core;
+    switch (job->affinity) {
+        case SYSTEM_EVENT_AFFINITY_CORE0:
+            core = 0;
+            break;
+    
+        case SYSTEM_EVENT_AFFINITY_CORE1:
+            core = 1;
+            break;
+    
+        case SYSTEM_EVENT_AFFINITY_UI:
+            if (__atomic_load_n(&g_ui_attached, __ATOMIC_ACQUIRE)) {
+                return g_ui_jobs;
+            }
+            core = CONFIG_SYSTEM_SERVICE_UI_CORE;
+            break;
+    
+        default:
+            return g_workers[job->service_id % DISPATCH_WORKER_COUNT].jobs;
+    }
+    
+    // Worker i is pinned to core i % DISPATCH_CORE_COUNT
+    int row = job->service_id % CONFIG_SYSTEM_SERVICE_DISPATCH_WORKERS_PER_CORE;
+    return g_workers[row * DISPATCH_CORE_COUNT + core % DISPATCH_CORE_COUNT].jobs;
+}
+
+/* Queue a job on its subscriber's worker; drops its payload reference on failure */
+static esp_err_t enqueue_job(dispatch_job_t *job)
+{
+    system_service_id_t service_id = job->service_id;
+    QueueHandle_t jobs = job_queue(job);
+    uint32_t timeout_ms = DISPATCH_SUBMIT_TIMEOUT_MS;
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+    // Never wait for a demoted handler, that is the delay being avoided
+    if (is_demoted(service_id, job->event.event_type)) {
+        jobs = g_workers[DISPATCH_DEFERRED_WORKER].jobs;
+        timeout_ms = 0;
+    }
+#endif
+    
+    if (xQueueSend(jobs, job, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        release_job_payload(job);
+        ESP_LOGW(TAG, "Worker for service %d is backed up, dropping event %d",
+                 service_id, job->event.event_type);
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t event_dispatch_start(void)
+{
+    if (g_dispatch_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(g_workers, 0, sizeof(g_workers));
+    
+    if (g_ui_jobs == NULL) {
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+        g_ui_jobs = xQueueCreateStatic(CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE,
+                                       sizeof(dispatch_job_t),
+                                       g_ui_queue_items, &g_ui_queue);
+#else
+        g_ui_jobs = xQueueCreate(CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE,
+                                 sizeof(dispatch_job_t));
+#endif
+        if (g_ui_jobs == NULL) {
+            ESP_LOGE(TAG, "Failed to create UI job queue");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_DISPATCH_POWER_LOCK
+    if (g_dispatch_power_lock == NULL) {
+        esp_err_t lock_ret = system_power_lock_create(SYSTEM_POWER_LOCK_CPU_MAX, "dispatch",
+                                                      &g_dispatch_power_lock);
+        if (lock_ret != ESP_OK) {
+            return lock_ret;
+        }
+    }
+#endif
+    
+    for (int i = 0; i < DISPATCH_TOTAL_WORKERS; i++) {
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+        dispatch_worker_storage_t *storage = &g_worker_storage[i];
+        g_workers[i].jobs = xQueueCreateStatic(CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE,
+                                               sizeof(dispatch_job_t),
+                                               storage->items, &storage->queue);
+#else
+        g_workers[i].jobs = xQueueCreate(CONFIG_SYSTEM_SERVICE_DISPATCH_WORKER_QUEUE_SIZE,
+                                         sizeof(dispatch_job_t));
+#endif
+        if (g_workers[i].jobs == NULL) {
+            ESP_LOGE(TAG, "Failed to create queue for worker %d", i);
+            shutdown_workers();
+            return ESP_ERR_NO_MEM;
+        }
+    
+        char name[configMAX_TASK_NAME_LEN];
+        UBaseType_t priority = CONFIG_SYSTEM_SERVICE_EVENT_TASK_PRIORITY;
+        BaseType_t core = i % DISPATCH_CORE_COUNT;
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+        if (i == DISPATCH_DEFERRED_WORKER) {
+            // Demoted handlers run when nothing more urgent is ready
+            snprintf(name, sizeof(name), "sys_defer");
+            priority = CONFIG_SYSTEM_SERVICE_QUARANTINE_TASK_PRIORITY;
+            core = tskNO_AFFINITY;
+        } else
+#endif
+        {
+            snprintf(name, sizeof(name), "sys_disp%d", i);
+        }
+    
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+        BaseType_t ret = system_task_create_static(worker_task,
+                                                   name,
+                                                   sizeof(storage->stack),
+                                                   &g_workers[i],
+                                                   priority,
+                                                   &g_workers[i].task,
+                                                   storage->stack,
+                                                   &storage->tcb,
+                                                   core);
+#else
+        BaseType_t ret = xTaskCreatePinnedToCore(worker_task,
+                                                 name,
+                                                 CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE,
+                                                 &g_workers[i],
+                                                 priority,
+                                                 &g_workers[i].task,
+                                                 core);
+#endif
+        if (ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            g_workers[i].task = NULL;
+            shutdown_workers();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+    portENTER_CRITICAL(&g_quarantine_lock);
+    for (int i = 0; i < QUARANTINE_SLOTS; i++) {
+        g_quarantine[i].service_id = SYSTEM_SERVICE_ID_INVALID;
+    }
+    g_demoted_count = 0;
+    portEXIT_CRITICAL(&g_quarantine_lock);
+    
+    // Demotions are still applied without it, just not announced
+    if (system_service_register("dispatch", NULL, &g_quarantine_service) == ESP_OK) {
+        system_service_set_state(g_quarantine_service, SYSTEM_SERVICE_STATE_RUNNING);
+    } else {
+        ESP_LOGW(TAG, "Failed to register dispatch service, quarantine events disabled");
+        g_quarantine_service = SYSTEM_SERVICE_ID_INVALID;
+    }
+#endif
+    
+    g_dispatch_running = true;
+    
+    ESP_LOGI(TAG, "Started %d dispatch workers across %d cores",
+             DISPATCH_WORKER_COUNT, DISPATCH_CORE_COUNT);
+    
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_stop(void)
+{
+    if (!g_dispatch_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    g_dispatch_running = false;
+    shutdown_workers();
+    release_pending_jobs(g_ui_jobs);
+    release_parked_jobs();
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_QUARANTINE
+    if (g_quarantine_service != SYSTEM_SERVICE_ID_INVALID) {
+        system_service_unregister(g_quarantine_service);
+        g_quarantine_service = SYSTEM_SERVICE_ID_INVALID;
+    }
+#endif
+    
+    ESP_LOGI(TAG, "Dispatch workers stopped");
+    
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_submit(const system_event_t *event,
+                                system_service_id_t service_id,
+                                system_event_handler_t handler,
+                                void *user_data,
+                                system_event_affinity_t affinity,
+                                uint32_t dequeue_us)
+{
+    if (event == NULL || handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_dispatch_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    dispatch_job_t job = {
+        .event = *event,
+        .handler = handler,
+        .user_data = user_data,
+        .service_id = service_id,
+        .affinity = affinity,
+        .dequeue_us = dequeue_us,
+    };
+    
+    if (job.event.data != NULL && memory_pool_retain(job.event.data) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (park_if_held(&job)) {
+        return ESP_OK;
+    }
+    
+    return enqueue_job(&job);
+}
+
+esp_err_t event_dispatch_run(const system_event_t *event,
+                             system_service_id_t service_id,
+                             system_event_handler_t handler,
+                             void *user_data,
+                             uint32_t dequeue_us)
+{
+    if (event == NULL || handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_dispatch_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    dispatch_job_t job = {
+        .event = *event,
+        .handler = handler,
+        .user_data = user_data,
+        .service_id = service_id,
+        .dequeue_us = dequeue_us,
+    };
+    
+    // A held subscriber gets it on release, like any other job
+    bool held = false;
+    if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        portENTER_CRITICAL(&g_park_lock);
+        held = g_held[service_id];
+        portEXIT_CRITICAL(&g_park_lock);
+    }
+    
+    if (held) {
+        if (job.event.data != NULL && memory_pool_retain(job.event.data) != ESP_OK) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (park_if_held(&job)) {
+            return ESP_OK;
+        }
+        // Released meanwhile, so it runs here after all
+        release_job_payload(&job);
+    }
+    
+    // The caller's reference covers the call
+    uint32_t end_us = run_job(&job);
+    uint32_t run_us = end_us - job.event.post_time_us;
+    
+    portENTER_CRITICAL(&g_deadline_lock);
+    g_deadline_stats.critical_runs++;
+    if (run_us > g_deadline_stats.critical_max_us) {
+        g_deadline_stats.critical_max_us = run_us;
+    }
+    portEXIT_CRITICAL(&g_deadline_lock);
+    
+    return ESP_OK;
+}
+
+uint32_t event_dispatch_worker_count(void)
+{
+    return g_dispatch_running ? DISPATCH_WORKER_COUNT : 0;
+}
+
+esp_err_t event_dispatch_hold(system_service_id_t service_id)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&g_park_lock);
+    if (!g_held[service_id]) {
+        g_held[service_id] = true;
+        g_held_dropped[service_id] = 0;
+    }
+    portEXIT_CRITICAL(&g_park_lock);
+    
+    return ESP_OK;
+}
+
+esp_err_t event_dispatch_release(system_service_id_t service_id, bool deliver,
+                                 uint32_t *out_replayed, uint32_t *out_dropped)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    bool held;
+    portENTER_CRITICAL(&g_park_lock);
+    held = g_held[service_id];
+    portEXIT_CRITICAL(&g_park_lock);
+    
+    if (!held) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    uint32_t replayed = 0;
+    uint32_t dropped = 0;
+    
+    for (;;) {
+        dispatch_job_t job;
+        bool found = false;
+    
+        portENTER_CRITICAL(&g_park_lock);
+        int next = oldest_parked_locked(service_id);
+        if (next >= 0) {
+            job = g_parked[next].job;
+            g_parked[next].seq = 0;
+            found = true;
+        } else {
+            // Backlog empty: from here on jobs go straight to the worker
+            g_held[service_id] = false;
+            dropped += g_held_dropped[service_id];
+            g_held_dropped[service_id] = 0;
+        }
+        portEXIT_CRITICAL(&g_park_lock);
+    
+        if (!found) {
+            break;
+        }
+    
+        if (!deliver || !g_dispatch_running) {
+            release_job_payload(&job);
+            dropped++;
+        } else if (enqueue_job(&job) == ESP_OK) {
+            replayed++;
+        } else {
+            dropped++;
+        }
+    }
+    
+    if (out_replayed != NULL) {
+        *out_replayed = replayed;
+    }
+    if (out_dropped != NULL) {
+        *out_dropped = dropped;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t system_event_ui_attach(void)
+{
+    if (g_ui_jobs == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    __atomic_store_n(&g_ui_attached, true, __ATOMIC_RELEASE);
+    ESP_LOGI(TAG, "UI task attached");
+    return ESP_OK;
+}
+
+void system_event_ui_detach(void)
+{
+    if (!__atomic_exchange_n(&g_ui_attached, false, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    
+    // Anything still queued for the UI task goes to a worker of its core
+    dispatch_job_t job;
+    while (g_ui_jobs != NULL && xQueueReceive(g_ui_jobs, &job, 0) == pdTRUE) {
+        if (!g_dispatch_running) {
+            release_job_payload(&job);
+        } else {
+            (void)enqueue_job(&job);
+        }
+    }
+    
+    ESP_LOGI(TAG, "UI task detached");
+}
+
+uint32_t system_event_ui_run(uint32_t max_jobs)
+{
+    uint32_t ran = 0;
+    dispatch_job_t job;
+    
+    while (ran < max_jobs && g_ui_jobs != NULL && xQueueReceive(g_ui_jobs, &job, 0) == pdTRUE) {
+        (void)run_job(&job);
+        release_job_payload(&job);
+        ran++;
+    }
+    
+    return ran;
+}
+
+esp_err_t system_event_get_deadline_stats(system_event_deadline_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&g_deadline_lock);
+    *out_stats = g_deadline_stats;
+    portEXIT_CRITICAL(&g_deadline_lock);
+    
+    return ESP_OK;
+}
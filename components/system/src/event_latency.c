@@ -0,0 +1,228 @@
+/**
+ * @file event_latency.c
+ * @brief Per-event-type latency histograms implementation
+ * 
+ * Bucket i counts samples in [2^i, 2^(i+1)) microseconds; bucket 0 also
+ * takes 0 µs and the last bucket takes everything longer. Percentiles
+ * report the upper edge of the bucket holding the requested rank, clamped
+ * to the observed maximum.
+ */
+
+#include "event_latency.h"
+#include "system_service/event_bus.h"
+#include "system_service/memory_utils.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "event_latency";
+
+/* ============================================================================
+ * Histogram Storage
+ * ============================================================================ */
+
+#define LATENCY_BUCKETS         20  /**< Last bucket starts at ~0.5 s */
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_histogram_t;
+
+typedef struct {
+    latency_histogram_t stages[SYSTEM_EVENT_LATENCY_STAGE_COUNT];
+} latency_entry_t;
+
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+
+/** One entry per event type plus an aggregate of all types at the end */
+#define LATENCY_AGGREGATE       SYSTEM_SERVICE_MAX_EVENT_TYPES
+
+static latency_entry_t *g_latency = NULL;
+static portMUX_TYPE g_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* ============================================================================
+ * Internal Helper Functions
+ * ============================================================================ */
+
+static int bucket_for(uint32_t us)
+{
+    int bucket = 0;
+    while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void histogram_add(latency_histogram_t *hist, uint32_t us)
+{
+    hist->buckets[bucket_for(us)]++;
+    hist->count++;
+    hist->total_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+static uint32_t histogram_percentile(const latency_histogram_t *hist, uint32_t percent)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    
+    // Rank of the sample at this percentile (1-based, rounded up)
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = (i == LATENCY_BUCKETS - 1) ? hist->max_us : ((1UL << (i + 1)) - 1);
+            return (upper < hist->max_us) ? upper : hist->max_us;
+        }
+    }
+    
+    return hist->max_us;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t event_latency_init(void)
+{
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+    if (g_latency != NULL) {
+        return ESP_OK;
+    }
+    
+    size_t size = sizeof(latency_entry_t) * (SYSTEM_SERVICE_MAX_EVENT_TYPES + 1);
+    latency_entry_t *table = memory_alloc_prefer_psram(size);
+    if (table == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate latency histograms (%zu bytes)", size);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(table, 0, size);
+    
+    g_latency = table;
+    
+    ESP_LOGI(TAG, "Latency tracking enabled (%zu bytes)", size);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void event_latency_deinit(void)
+{
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+    portENTER_CRITICAL(&g_latency_lock);
+    latency_entry_t *table = g_latency;
+    g_latency = NULL;
+    portEXIT_CRITICAL(&g_latency_lock);
+    
+    free(table);
+#endif
+}
+
+uint32_t IRAM_ATTR event_latency_now_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+void event_latency_record(system_event_type_t event_type,
+                          system_event_latency_stage_t stage,
+                          uint32_t from_us,
+                          uint32_t to_us)
+{
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+    if (event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        stage >= SYSTEM_EVENT_LATENCY_STAGE_COUNT) {
+        return;
+    }
+    
+    // Unsigned difference stays correct across the 32-bit wrap (~71 minutes)
+    uint32_t elapsed = to_us - from_us;
+    
+    portENTER_CRITICAL(&g_latency_lock);
+    if (g_latency != NULL) {
+        histogram_add(&g_latency[event_type].stages[stage], elapsed);
+        histogram_add(&g_latency[LATENCY_AGGREGATE].stages[stage], elapsed);
+    }
+    portEXIT_CRITICAL(&g_latency_lock);
+#else
+    (void)event_type;
+    (void)stage;
+    (void)from_us;
+    (void)to_us;
+#endif
+}
+
+esp_err_t system_event_get_latency(system_event_type_t event_type,
+                                   system_event_latency_stage_t stage,
+                                   system_event_latency_t *out_latency)
+{
+    if (out_latency == NULL || stage >= SYSTEM_EVENT_LATENCY_STAGE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+    size_t index;
+    if (event_type == SYSTEM_EVENT_TYPE_INVALID) {
+        index = LATENCY_AGGREGATE;
+    } else if (event_type < SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        index = event_type;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Snapshot so percentiles are computed outside the critical section
+    latency_histogram_t hist;
+    portENTER_CRITICAL(&g_latency_lock);
+    if (g_latency == NULL) {
+        portEXIT_CRITICAL(&g_latency_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    hist = g_latency[index].stages[stage];
+    portEXIT_CRITICAL(&g_latency_lock);
+    
+    out_latency->count = hist.count;
+    out_latency->avg_us = hist.count ? (uint32_t)(hist.total_us / hist.count) : 0;
+    out_latency->p50_us = histogram_percentile(&hist, 50);
+    out_latency->p99_us = histogram_percentile(&hist, 99);
+    out_latency->max_us = hist.max_us;
+    
+    return ESP_OK;
+#else
+    (void)event_type;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t system_event_reset_latency(void)
+{
+#if CONFIG_SYSTEM_SERVICE_ENABLE_LATENCY_TRACKING
+    if (g_latency == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // One entry per critical section keeps interrupt latency low
+    for (size_t i = 0; i <= SYSTEM_SERVICE_MAX_EVENT_TYPES; i++) {
+        portENTER_CRITICAL(&g_latency_lock);
+        if (g_latency != NULL) {
+            memset(&g_latency[i], 0, sizeof(latency_entry_t));
+        }
+        portEXIT_CRITICAL(&g_latency_lock);
+    }
+    
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
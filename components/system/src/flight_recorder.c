@@ -0,0 +1,861 @@
+/**
+ * @file flight_recorder.c
+ * @brief Persistent flight recorder implementation
+ *
+ * The partition is a ring of sectors: sequence number `seq` lives in
+ * sector `seq % sectors`, so the newest sector is the one before the
+ * sector being filled and the oldest the one after it. Every sector is
+ * erased once per lap of the ring, whatever the mix of entries.
+ *
+ * The sector being filled is built in place in s_pending, which is not
+ * cleared at reset. Its header CRCs are brought up to date after every
+ * drain, so after a crash or watchdog reset the next boot finds a valid
+ * image and writes it out as the sector it would have become.
+ *
+ * Trace records are taken from the rings against a byte budget (token
+ * bucket of CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_BYTES_PER_SEC); over it
+ * the oldest unread records are skipped and counted as lost, so flash
+ * wear is bounded however busy the bus gets.
+ */
+
+#include "system_service/flight_recorder.h"
+
+#if CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+
+#include "system_service/system_metrics.h"
+#include "system_service/memory_utils.h"
+#include "system_service/static_alloc.h"
+#include "console_base64.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#define FLIGHT_CPU_FREQ_HZ  1000000
+#define FLIGHT_NOINIT
+#else
+#include "esp_system.h"
+#define FLIGHT_CPU_FREQ_HZ  (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000)
+#define FLIGHT_NOINIT       __NOINIT_ATTR
+#endif
+
+static const char *TAG = "flight";
+
+#define SECTOR_SIZE         FLIGHT_RECORDER_SECTOR_SIZE
+#define SECTOR_DATA         (SECTOR_SIZE - sizeof(flight_sector_header_t))
+#define PENDING_MAGIC       0x444E4550      // "PEND"
+#define FLUSH_MS            CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_FLUSH_MS
+#define METRICS_MS          (CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_METRICS_S * 1000)
+#define BYTES_PER_SEC       CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_BYTES_PER_SEC
+#define BUDGET_BURST        (BYTES_PER_SEC * 4)
+#define NAMES_FIRST_MS      2000            // Let the services register first
+#define NAMES_CHECK_MS      10000
+#define LOCK_TIMEOUT_MS     100
+#define MIN_TRACE_RECORDS   8               // Fewer fit: start the next sector
+
+#define FLIGHT_TASK_STACK   4096
+#define FLIGHT_TASK_PRIORITY 1
+
+#define PAD4(n)             (((n) + 3u) & ~3u)
+
+_Static_assert(sizeof(flight_sector_header_t) == 32, "sector headers are 32 bytes");
+_Static_assert(sizeof(flight_entry_t) == 8, "entry headers are 8 bytes");
+_Static_assert(sizeof(flight_metric_t) == 16, "metric entries are 16 bytes");
+
+typedef struct {
+    uint32_t magic;                 // PENDING_MAGIC while the image is in use
+    uint32_t reserved;
+    union {
+        flight_sector_header_t header;
+        uint8_t bytes[SECTOR_SIZE];
+    } image;
+} pending_sector_t;
+
+static FLIGHT_NOINIT pending_sector_t s_pending;
+
+static struct {
+    const esp_partition_t *partition;
+    uint32_t sectors;
+    uint32_t next_seq;              // Sequence number of s_pending
+    uint32_t oldest_seq;            // Oldest sector that may still be valid
+    uint32_t boot;
+    
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+    volatile bool running;
+    bool started;
+    
+    uint32_t budget;                // Trace bytes that may be stored now
+    int64_t budget_us;
+    uint32_t cursors[portNUM_PROCESSORS];
+    uint32_t lost[portNUM_PROCESSORS];  // Not yet reported in a trace entry
+    uint32_t names_crc;
+    uint32_t names_due_ms;
+    uint32_t metrics_due_ms;
+    
+    flight_recorder_stats_t stats;
+} s_flight;
+
+SYSTEM_MUTEX_DEFINE(s_flight_mutex);
+SYSTEM_TASK_DEFINE(s_flight_task_buf, FLIGHT_TASK_STACK);
+
+static inline uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* ============================================================================
+ * Sectors
+ * ============================================================================ */
+
+static uint32_t header_crc(const flight_sector_header_t *header)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(flight_sector_header_t, header_crc));
+}
+
+static bool header_valid(const flight_sector_header_t *header)
+{
+    return header->magic == FLIGHT_SECTOR_MAGIC &&
+           header->used <= SECTOR_DATA &&
+           header->header_crc == header_crc(header);
+}
+
+static size_t sector_offset(uint32_t seq)
+{
+    return (size_t)(seq % s_flight.sectors) * SECTOR_SIZE;
+}
+
+static esp_err_t read_header(uint32_t seq, flight_sector_header_t *header)
+{
+    esp_err_t ret = esp_partition_read(s_flight.partition, sector_offset(seq), header, sizeof(*header));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return header_valid(header) && header->seq == seq ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @brief Bring the pending header's CRCs up to date
+ */
+static void seal(void)
+{
+    flight_sector_header_t *header = &s_pending.image.header;
+    header->data_crc = esp_rom_crc32_le(0, s_pending.image.bytes + sizeof(*header), header->used);
+    header->header_crc = header_crc(header);
+}
+
+static void begin_sector(void)
+{
+    memset(&s_pending.image.header, 0, sizeof(s_pending.image.header));
+    s_pending.image.header.magic = FLIGHT_SECTOR_MAGIC;
+    s_pending.image.header.seq = s_flight.next_seq;
+    s_pending.image.header.boot = s_flight.boot;
+    seal();
+    s_pending.magic = PENDING_MAGIC;
+}
+
+/**
+ * @brief Write s_pending to its sector; the header goes last
+ */
+static esp_err_t write_pending(void)
+{
+    flight_sector_header_t *header = &s_pending.image.header;
+    size_t offset = sector_offset(header->seq);
+    
+    seal();
+    esp_err_t ret = esp_partition_erase_range(s_flight.partition, offset, SECTOR_SIZE);
+    if (ret == ESP_OK && header->used > 0) {
+        ret = esp_partition_write(s_flight.partition, offset + sizeof(*header),
+                                  s_pending.image.bytes + sizeof(*header), header->used);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(s_flight.partition, offset, header, sizeof(*header));
+    }
+    
+    if (ret != ESP_OK) {
+        s_flight.stats.write_errors++;
+        ESP_LOGW(TAG, "Sector %lu write failed: %s", (unsigned long)header->seq, esp_err_to_name(ret));
+    } else {
+        s_flight.stats.sectors_written++;
+    }
+    
+    // The erased sector held the oldest one
+    s_flight.next_seq = header->seq + 1;
+    if (s_flight.next_seq - s_flight.oldest_seq > s_flight.sectors) {
+        s_flight.oldest_seq = s_flight.next_seq - s_flight.sectors;
+    }
+    return ret;
+}
+
+static esp_err_t commit_sector(void)
+{
+    if (s_pending.image.header.entries == 0) {
+        return ESP_OK;
+    }
+    esp_err_t ret = write_pending();
+    begin_sector();
+    return ret;
+}
+
+/* ============================================================================
+ * Entries
+ * ============================================================================ */
+
+static size_t space_left(void)
+{
+    return SECTOR_DATA - s_pending.image.header.used;
+}
+
+/**
+ * @brief Reserve room for an entry of up to `max_len` payload bytes
+ *
+ * Starts the next sector when this one is too full. Nothing is recorded
+ * until entry_end().
+ *
+ * @return The payload, NULL if `max_len` can't fit a sector
+ */
+static uint8_t *entry_begin(size_t max_len)
+{
+    if (sizeof(flight_entry_t) + PAD4(max_len) > SECTOR_DATA) {
+        return NULL;
+    }
+    if (sizeof(flight_entry_t) + PAD4(max_len) > space_left()) {
+        commit_sector();
+    }
+    return s_pending.image.bytes + sizeof(flight_sector_header_t) + s_pending.image.header.used +
+           sizeof(flight_entry_t);
+}
+
+static void entry_end(flight_entry_type_t type, uint8_t core, size_t len)
+{
+    flight_sector_header_t *header = &s_pending.image.header;
+    uint8_t *at = s_pending.image.bytes + sizeof(*header) + header->used;
+    flight_entry_t entry = {
+        .type = (uint8_t)type,
+        .core = core,
+        .length = (uint16_t)len,
+        .ms = now_ms(),
+    };
+    
+    memcpy(at, &entry, sizeof(entry));
+    memset(at + sizeof(entry) + len, 0, PAD4(len) - len);
+    
+    if (header->entries == 0) {
+        header->first_ms = entry.ms;
+    }
+    header->last_ms = entry.ms;
+    header->used += sizeof(entry) + PAD4(len);
+    header->entries++;
+}
+
+static void add_entry(flight_entry_type_t type, const void *payload, size_t len)
+{
+    uint8_t *at = entry_begin(len);
+    if (at != NULL) {
+        memcpy(at, payload, len);
+        entry_end(type, 0, len);
+    }
+}
+
+/* ============================================================================
+ * Sources
+ * ============================================================================ */
+
+#if CONFIG_SYSTEM_SERVICE_TRACE
+
+static void drain_traces(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    uint64_t refill = (uint64_t)(now_us - s_flight.budget_us) * BYTES_PER_SEC / 1000000;
+    if (refill > 0) {
+        s_flight.budget = (uint32_t)(s_flight.budget + refill > BUDGET_BURST ?
+                                     BUDGET_BURST : s_flight.budget + refill);
+        s_flight.budget_us = now_us;
+    }
+    
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        // An idle core leaves its share to the next
+        size_t share = s_flight.budget / (portNUM_PROCESSORS - core);
+        size_t allowed = share / sizeof(system_trace_record_t);
+        uint32_t skipped = system_trace_skip((uint8_t)core, &s_flight.cursors[core], allowed);
+        s_flight.lost[core] += skipped;
+        s_flight.stats.records_lost += skipped;
+    
+        while (allowed > 0 || s_flight.lost[core] > 0) {
+            const size_t overhead = sizeof(flight_entry_t) + sizeof(flight_trace_t);
+            size_t want = allowed < MIN_TRACE_RECORDS ? allowed : MIN_TRACE_RECORDS;
+            if (space_left() < overhead + want * sizeof(system_trace_record_t)) {
+                commit_sector();
+            }
+            size_t room = (space_left() - overhead) / sizeof(system_trace_record_t);
+            size_t max = allowed < room ? allowed : room;
+    
+            uint8_t *at = entry_begin(sizeof(flight_trace_t) + max * sizeof(system_trace_record_t));
+            uint32_t lost = 0;
+            size_t count = system_trace_read((uint8_t)core, &s_flight.cursors[core],
+                                             (system_trace_record_t *)(at + sizeof(flight_trace_t)),
+                                             max, &lost);
+            s_flight.lost[core] += lost;
+            s_flight.stats.records_lost += lost;
+            if (count == 0 && s_flight.lost[core] == 0) {
+                break;
+            }
+    
+            flight_trace_t trace = { .lost = s_flight.lost[core] };
+            memcpy(at, &trace, sizeof(trace));
+            size_t len = sizeof(trace) + count * sizeof(system_trace_record_t);
+            entry_end(FLIGHT_ENTRY_TRACE, (uint8_t)core, len);
+    
+            s_flight.lost[core] = 0;
+            s_flight.stats.records_logged += count;
+            allowed -= count;
+            share = sizeof(flight_entry_t) + len;
+            s_flight.budget = s_flight.budget > share ? s_flight.budget - share : 0;
+            if (count < max) {
+                break;
+            }
+        }
+    }
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_TRACE
+
+static void sample_metrics(void)
+{
+    flight_metrics_t head = {
+        .free_internal = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        .largest_internal = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+    };
+    size_t room = 0;
+    
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    // Size the entry first, so a sector isn't started for nothing
+    for (system_metric_id_t id = 0; id < CONFIG_SYSTEM_SERVICE_MAX_METRICS; id++) {
+        system_metric_snapshot_t snapshot;
+        room += (system_metric_get(id, &snapshot) == ESP_OK);
+    }
+#endif
+    
+    uint8_t *at = entry_begin(sizeof(head) + room * sizeof(flight_metric_t));
+    if (at == NULL) {
+        return;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    flight_metric_t *metrics = (flight_metric_t *)(at + sizeof(head));
+    
+    for (system_metric_id_t id = 0; id < CONFIG_SYSTEM_SERVICE_MAX_METRICS && head.count < room; id++) {
+        system_metric_snapshot_t snapshot;
+        if (system_metric_get(id, &snapshot) != ESP_OK) {
+            continue;
+        }
+        flight_metric_t metric = {
+            .id = id,
+            .type = (uint8_t)snapshot.type,
+            .value = snapshot.value,
+            .sum = snapshot.sum,
+            .max = snapshot.max,
+        };
+        memcpy(&metrics[head.count++], &metric, sizeof(metric));
+    }
+#endif
+    
+    memcpy(at, &head, sizeof(head));
+    entry_end(FLIGHT_ENTRY_METRICS, 0, sizeof(head) + head.count * sizeof(flight_metric_t));
+}
+
+/**
+ * @brief Collect trace and metric names
+ */
+static size_t collect_names(system_trace_name_t *names, size_t max)
+{
+    size_t count = 0;
+    
+#if CONFIG_SYSTEM_SERVICE_TRACE
+    count = system_trace_get_names(names, max);
+#endif
+    
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    for (system_metric_id_t id = 0; id < CONFIG_SYSTEM_SERVICE_MAX_METRICS && count < max; id++) {
+        system_metric_snapshot_t snapshot;
+        if (system_metric_get(id, &snapshot) != ESP_OK) {
+            continue;
+        }
+        system_trace_name_t *entry = &names[count++];
+        memset(entry, 0, sizeof(*entry));
+        entry->kind = SYSTEM_TRACE_NAME_METRIC;
+        entry->id = id;
+        strncpy(entry->name, snapshot.name, sizeof(entry->name));
+    }
+#endif
+    
+    return count;
+}
+
+/**
+ * @brief Store the names if they changed since they were last stored
+ *
+ * A decoder labels a boot's records with the names stored in that boot,
+ * so `force` stores them even unchanged, for a read that may not reach
+ * back to the sector holding them.
+ */
+static void write_names(bool force)
+{
+    size_t max = SYSTEM_SERVICE_MAX_EVENT_TYPES + SYSTEM_SERVICE_MAX_SERVICES + 64;
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    max += CONFIG_SYSTEM_SERVICE_MAX_METRICS;
+#endif
+    system_trace_name_t *names = memory_alloc_prefer_psram(max * sizeof(system_trace_name_t));
+    if (names == NULL) {
+        return;
+    }
+    
+    size_t count = collect_names(names, max);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)names, count * sizeof(system_trace_name_t));
+    
+    if (count > 0 && (force || crc != s_flight.names_crc)) {
+        const size_t per_entry = (SECTOR_DATA - sizeof(flight_entry_t)) / sizeof(system_trace_name_t);
+        for (size_t i = 0; i < count; i += per_entry) {
+            size_t n = count - i < per_entry ? count - i : per_entry;
+            add_entry(FLIGHT_ENTRY_NAMES, &names[i], n * sizeof(system_trace_name_t));
+        }
+        s_flight.names_crc = crc;
+    }
+    free(names);
+}
+
+/**
+ * @brief One round of the recorder task; called with the lock held
+ */
+static void drain(bool force_names)
+{
+#if CONFIG_SYSTEM_SERVICE_TRACE
+    drain_traces();
+#endif
+    
+    uint32_t now = now_ms();
+    if ((int32_t)(now - s_flight.metrics_due_ms) >= 0) {
+        s_flight.metrics_due_ms = now + METRICS_MS;
+        sample_metrics();
+    }
+    if (force_names || (int32_t)(now - s_flight.names_due_ms) >= 0) {
+        s_flight.names_due_ms = now + NAMES_CHECK_MS;
+        write_names(force_names);
+    }
+    
+    seal();
+}
+
+/* ============================================================================
+ * Task
+ * ============================================================================ */
+
+static bool lock(void)
+{
+    return xSemaphoreTake(s_flight.lock, pdMS_TO_TICKS(LOCK_TIMEOUT_MS)) == pdTRUE;
+}
+
+static void unlock(void)
+{
+    xSemaphoreGive(s_flight.lock);
+}
+
+static void flight_task(void *arg)
+{
+    while (s_flight.running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLUSH_MS));
+        if (lock()) {
+            drain(false);
+            unlock();
+        }
+    }
+    
+    s_flight.task = NULL;
+    vTaskDelete(NULL);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+/**
+ * @brief Drain before a software restart; s_pending is written out by the next boot
+ */
+static void flight_shutdown(void)
+{
+    if (s_flight.started && lock()) {
+        drain(false);
+        unlock();
+    }
+}
+#endif
+
+/* ============================================================================
+ * Start and Stop
+ * ============================================================================ */
+
+/**
+ * @brief Find the newest sector and the highest boot number on flash
+ */
+static void scan(void)
+{
+    uint32_t newest = 0;
+    uint32_t boot = 0;
+    bool found = false;
+    
+    for (uint32_t i = 0; i < s_flight.sectors; i++) {
+        flight_sector_header_t header;
+        if (esp_partition_read(s_flight.partition, (size_t)i * SECTOR_SIZE, &header, sizeof(header)) != ESP_OK ||
+            !header_valid(&header) || header.seq % s_flight.sectors != i) {
+            continue;
+        }
+        s_flight.stats.sectors_valid++;
+        if (!found || (int32_t)(header.seq - newest) > 0) {
+            newest = header.seq;
+        }
+        if (header.boot > boot) {
+            boot = header.boot;
+        }
+        found = true;
+    }
+    
+    s_flight.next_seq = found ? newest + 1 : 1;
+    s_flight.oldest_seq = s_flight.next_seq > s_flight.sectors ? s_flight.next_seq - s_flight.sectors : 1;
+    s_flight.boot = boot + 1;
+}
+
+/**
+ * @brief Write out the sector the last boot was filling when it reset
+ */
+static void recover_pending(void)
+{
+    flight_sector_header_t *header = &s_pending.image.header;
+    
+    // Cold boots leave noise here, which fails the CRCs
+    if (s_pending.magic != PENDING_MAGIC || !header_valid(header) || header->entries == 0 ||
+        header->data_crc != esp_rom_crc32_le(0, s_pending.image.bytes + sizeof(*header), header->used)) {
+        return;
+    }
+    if (header->boot >= s_flight.boot) {
+        s_flight.boot = header->boot + 1;
+    }
+    
+    ESP_LOGI(TAG, "Recovered %u entries of boot %lu", header->entries, (unsigned long)header->boot);
+    header->seq = s_flight.next_seq;
+    write_pending();
+}
+
+esp_err_t flight_recorder_start(void)
+{
+    if (s_flight.started) {
+        return ESP_OK;
+    }
+    
+    s_flight.partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                  CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_PARTITION);
+    if (s_flight.partition == NULL) {
+        ESP_LOGW(TAG, "Partition '%s' not found", CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER_PARTITION);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_flight.sectors = s_flight.partition->size / SECTOR_SIZE;
+    if (s_flight.sectors < 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    if (s_flight.lock == NULL) {
+        s_flight.lock = SYSTEM_MUTEX_CREATE(s_flight_mutex);
+        if (s_flight.lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    memset(&s_flight.stats, 0, sizeof(s_flight.stats));
+    scan();
+    recover_pending();
+    s_flight.stats.sectors = s_flight.sectors;
+    s_flight.stats.boot = s_flight.boot;
+    
+    begin_sector();
+    flight_boot_t boot = { .boot = s_flight.boot };
+#if !CONFIG_IDF_TARGET_LINUX
+    boot.reset_reason = (uint32_t)esp_reset_reason();
+#endif
+    add_entry(FLIGHT_ENTRY_BOOT, &boot, sizeof(boot));
+    seal();
+    
+    uint32_t now = now_ms();
+    s_flight.budget = BYTES_PER_SEC;
+    s_flight.budget_us = esp_timer_get_time();
+    s_flight.metrics_due_ms = now;
+    s_flight.names_due_ms = now + NAMES_FIRST_MS;
+    s_flight.names_crc = 0;
+    memset(s_flight.lost, 0, sizeof(s_flight.lost));
+    memset(s_flight.cursors, 0, sizeof(s_flight.cursors));
+    
+    s_flight.running = true;
+    if (SYSTEM_TASK_CREATE(s_flight_task_buf, flight_task, "flight_rec", FLIGHT_TASK_STACK,
+                           NULL, FLIGHT_TASK_PRIORITY, &s_flight.task) != pdPASS) {
+        s_flight.running = false;
+        vSemaphoreDelete(s_flight.lock);
+        s_flight.lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    s_flight.started = true;
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_register_shutdown_handler(flight_shutdown);
+#endif
+    
+    ESP_LOGI(TAG, "Boot %lu: %lu of %lu sectors valid, %d bytes/s",
+             (unsigned long)s_flight.boot, (unsigned long)s_flight.stats.sectors_valid,
+             (unsigned long)s_flight.sectors, BYTES_PER_SEC);
+    return ESP_OK;
+}
+
+void flight_recorder_stop(void)
+{
+    if (!s_flight.started) {
+        return;
+    }
+    
+    s_flight.running = false;
+    xTaskNotifyGive(s_flight.task);
+    for (int i = 0; i < FLUSH_MS / 10 + 10 && s_flight.task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_unregister_shutdown_handler(flight_shutdown);
+#endif
+    
+    xSemaphoreTake(s_flight.lock, portMAX_DELAY);
+    drain(false);
+    commit_sector();
+    s_flight.started = false;
+    xSemaphoreGive(s_flight.lock);
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t flight_recorder_mark(const char *text)
+{
+    if (text == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_flight.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    size_t len = strnlen(text, FLIGHT_MARK_MAX_LEN);
+    add_entry(FLIGHT_ENTRY_MARK, text, len);
+    seal();
+    
+    unlock();
+    return ESP_OK;
+}
+
+esp_err_t flight_recorder_flush(void)
+{
+    if (!s_flight.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    drain(false);
+    esp_err_t ret = commit_sector();
+    
+    unlock();
+    return ret;
+}
+
+/**
+ * @brief Oldest sequence number of the read window
+ */
+static uint32_t window_start(uint32_t minutes)
+{
+    const flight_sector_header_t *pending = &s_pending.image.header;
+    uint64_t want_ms = (uint64_t)minutes * 60 * 1000;
+    uint64_t spans_ms = 0;              // Boots before the current one
+    uint32_t boot = pending->boot;
+    uint32_t boot_end = pending->last_ms;
+    uint32_t boot_start = pending->entries > 0 ? pending->first_ms : pending->last_ms;
+    uint32_t start = s_flight.next_seq;
+    
+    while (start > s_flight.oldest_seq) {
+        if (minutes > 0 && spans_ms + (boot_end - boot_start) >= want_ms) {
+            break;
+        }
+        flight_sector_header_t header;
+        if (read_header(start - 1, &header) != ESP_OK) {
+            break;
+        }
+        if (header.boot != boot) {
+            spans_ms += boot_end - boot_start;
+            boot = header.boot;
+            boot_end = header.last_ms;
+        }
+        boot_start = header.first_ms;
+        start--;
+    }
+    return start;
+}
+
+esp_err_t flight_recorder_read(uint32_t minutes, system_trace_write_fn_t write, void *user_data)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_flight.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    uint8_t *buf = memory_alloc_prefer_psram(SECTOR_SIZE);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!lock()) {
+        free(buf);
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    drain(true);
+    uint32_t first = window_start(minutes);
+    uint32_t end = s_flight.next_seq;
+    flight_dump_header_t dump = {
+        .magic = FLIGHT_DUMP_MAGIC,
+        .version = FLIGHT_DUMP_VERSION,
+        .sector_size = SECTOR_SIZE,
+        .sectors = end - first + 1,
+        .boot = s_flight.boot,
+        .minutes = minutes,
+        .cpu_freq_hz = FLIGHT_CPU_FREQ_HZ,
+    };
+    unlock();
+    
+    esp_err_t ret = write(&dump, sizeof(dump), user_data);
+    
+    // One sector per lock, so the recorder keeps up while the sink is slow
+    for (uint32_t seq = first; seq != end && ret == ESP_OK; seq++) {
+        flight_sector_header_t *header = (flight_sector_header_t *)buf;
+        if (!lock()) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+        ret = read_header(seq, header);
+        if (ret == ESP_OK && header->used > 0) {
+            ret = esp_partition_read(s_flight.partition, sector_offset(seq) + sizeof(*header),
+                                     buf + sizeof(*header), header->used);
+        }
+        unlock();
+    
+        // Lapped by the writer since the window was taken: send it empty
+        if (ret == ESP_ERR_NOT_FOUND) {
+            memset(header, 0, sizeof(*header));
+            ret = ESP_OK;
+        }
+        if (ret == ESP_OK) {
+            ret = write(buf, sizeof(*header) + header->used, user_data);
+        }
+    }
+    
+    // The sector being filled goes last
+    if (ret == ESP_OK) {
+        if (lock()) {
+            seal();
+            memcpy(buf, s_pending.image.bytes, sizeof(flight_sector_header_t) + s_pending.image.header.used);
+            unlock();
+            ret = write(buf, sizeof(flight_sector_header_t) + ((flight_sector_header_t *)buf)->used, user_data);
+        } else {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+    
+    free(buf);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read aborted: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t flight_recorder_dump_console(uint32_t minutes)
+{
+    console_base64_t sink;
+    
+    console_base64_begin(&sink, "KFLIGHT");
+    esp_err_t ret = flight_recorder_read(minutes, console_base64_write, &sink);
+    console_base64_end(&sink);
+    
+    return ret;
+}
+
+esp_err_t flight_recorder_get_stats(flight_recorder_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_flight.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *out_stats = s_flight.stats;
+    unlock();
+    return ESP_OK;
+}
+
+#else // !CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
+
+esp_err_t flight_recorder_start(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void flight_recorder_stop(void)
+{
+}
+
+esp_err_t flight_recorder_mark(const char *text)
+{
+    (void)text;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t flight_recorder_flush(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t flight_recorder_read(uint32_t minutes, system_trace_write_fn_t write, void *user_data)
+{
+    (void)minutes;
+    (void)write;
+    (void)user_data;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t flight_recorder_dump_console(uint32_t minutes)
+{
+    (void)minutes;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t flight_recorder_get_stats(flight_recorder_stats_t *out_stats)
+{
+    (void)out_stats;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER
@@ -1,12 +1,27 @@
 /**
  * @file handler_monitor.c
  * @brief Event handler execution monitoring implementation
+ * 
+ * Besides the per-service totals, every (subscriber, event type) pair that
+ * runs a handler gets a profile slot with an execution-time histogram.
+ * Slots live in a small open-addressed table claimed on first use; all
+ * updates happen under one spinlock so concurrent dispatch workers never
+ * leave a torn count/total pair behind.
+ * 
+ * Histogram buckets split every power of two in half: bucket 2k holds
+ * [2^k, 1.5 * 2^k) µs and bucket 2k+1 holds [1.5 * 2^k, 2^(k+1)) µs, so
+ * percentiles are within 25% of the true value.
  */
 
 #include "handler_monitor.h"
+#include "system_service/event_bus.h"
+#include "system_service/memory_utils.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 #include "system_service/error_codes.h"
+#include <stdlib.h>
+#include <string.h>
 
 static const char *TAG = "handler_monitor";
 
@@ -22,6 +37,219 @@ typedef struct {
 } handler_stats_t;
 
 static handler_stats_t g_handler_stats[SYSTEM_SERVICE_MAX_SERVICES] = {0};
+static portMUX_TYPE g_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* ============================================================================
+ * Handler Profiles (per service and event type)
+ * ============================================================================ */
+
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+
+#define PROFILE_SLOTS           CONFIG_SYSTEM_SERVICE_HANDLER_PROFILE_SLOTS
+#define PROFILE_BUCKETS         48  /**< Last bucket starts at ~12.6 s */
+
+typedef struct {
+    system_service_id_t service_id;     /**< SYSTEM_SERVICE_ID_INVALID if free */
+    system_event_type_t event_type;
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[PROFILE_BUCKETS];
+} handler_profile_t;
+
+static handler_profile_t *g_profiles = NULL;
+static uint32_t g_profile_overflows = 0;   /**< Samples lost to a full table */
+static esp_timer_handle_t g_dump_timer = NULL;
+
+static int profile_bucket_for(uint32_t us)
+{
+    if (us < 2) {
+        return (int)us;
+    }
+    
+    int msb = 31 - __builtin_clz(us);
+    int bucket = 2 * msb + (int)((us >> (msb - 1)) & 1);
+    return (bucket < PROFILE_BUCKETS) ? bucket : PROFILE_BUCKETS - 1;
+}
+
+static uint32_t profile_bucket_upper(int bucket)
+{
+    if (bucket < 2) {
+        return (uint32_t)bucket;
+    }
+    
+    int msb = bucket / 2;
+    uint32_t half = 1UL << (msb - 1);
+    uint32_t lower = (1UL << msb) + ((bucket & 1) ? half : 0);
+    return lower + half - 1;
+}
+
+static uint32_t profile_percentile(const handler_profile_t *profile, uint32_t percent)
+{
+    if (profile->count == 0) {
+        return 0;
+    }
+    
+    uint32_t rank = (uint32_t)(((uint64_t)profile->count * percent + 99) / 100);
+    uint32_t seen = 0;
+    
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        seen += profile->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = (i == PROFILE_BUCKETS - 1) ? profile->max_us : profile_bucket_upper(i);
+            return (upper < profile->max_us) ? upper : profile->max_us;
+        }
+    }
+    
+    return profile->max_us;
+}
+
+/**
+ * @brief Find the slot of a pair, claiming a free one if create is set
+ * 
+ * Called with g_stats_lock held.
+ */
+static handler_profile_t* find_profile_locked(system_service_id_t service_id,
+                                              system_event_type_t event_type,
+                                              bool create)
+{
+    uint32_t key = ((uint32_t)service_id << 16) ^ (uint32_t)event_type;
+    uint32_t start = (key * 2654435761u) % PROFILE_SLOTS;
+    
+    for (uint32_t probe = 0; probe < PROFILE_SLOTS; probe++) {
+        handler_profile_t *profile = &g_profiles[(start + probe) % PROFILE_SLOTS];
+        if (profile->service_id == service_id && profile->event_type == event_type) {
+            return profile;
+        }
+        if (profile->service_id == SYSTEM_SERVICE_ID_INVALID) {
+            if (!create) {
+                return NULL;
+            }
+            profile->service_id = service_id;
+            profile->event_type = event_type;
+            return profile;
+        }
+    }
+    
+    return NULL;
+}
+
+static void clear_profiles_locked(void)
+{
+    memset(g_profiles, 0, sizeof(handler_profile_t) * PROFILE_SLOTS);
+    for (size_t i = 0; i < PROFILE_SLOTS; i++) {
+        g_profiles[i].service_id = SYSTEM_SERVICE_ID_INVALID;
+    }
+    g_profile_overflows = 0;
+}
+
+static void fill_summary(const handler_profile_t *profile, system_handler_profile_t *out)
+{
+    out->service_id = profile->service_id;
+    out->event_type = profile->event_type;
+    out->count = profile->count;
+    out->total_us = profile->total_us;
+    out->avg_us = profile->count ? (uint32_t)(profile->total_us / profile->count) : 0;
+    out->p50_us = profile_percentile(profile, 50);
+    out->p99_us = profile_percentile(profile, 99);
+    out->max_us = profile->max_us;
+}
+
+static void profile_record(system_service_id_t service_id,
+                           system_event_type_t event_type,
+                           uint32_t elapsed_us)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    if (g_profiles != NULL) {
+        handler_profile_t *profile = find_profile_locked(service_id, event_type, true);
+        if (profile != NULL) {
+            profile->buckets[profile_bucket_for(elapsed_us)]++;
+            profile->count++;
+            profile->total_us += elapsed_us;
+            if (elapsed_us > profile->max_us) {
+                profile->max_us = elapsed_us;
+            }
+        } else {
+            g_profile_overflows++;
+        }
+    }
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
+static void dump_timer_cb(void *arg)
+{
+    (void)arg;
+    system_event_dump_handler_profiles(CONFIG_SYSTEM_SERVICE_HANDLER_PROFILE_TOP_N);
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+esp_err_t handler_monitor_init(void)
+{
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    if (g_profiles != NULL) {
+        return ESP_OK;
+    }
+    
+    size_t size = sizeof(handler_profile_t) * PROFILE_SLOTS;
+    handler_profile_t *table = memory_alloc_prefer_psram(size);
+    if (table == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate handler profiles (%zu bytes)", size);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    portENTER_CRITICAL(&g_stats_lock);
+    g_profiles = table;
+    clear_profiles_locked();
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILE_DUMP_INTERVAL_MS > 0
+    const esp_timer_create_args_t args = {
+        .callback = dump_timer_cb,
+        .name = "handler_prof",
+    };
+    esp_err_t ret = esp_timer_create(&args, &g_dump_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(g_dump_timer,
+                                       (uint64_t)CONFIG_SYSTEM_SERVICE_HANDLER_PROFILE_DUMP_INTERVAL_MS * 1000);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start profile dump timer: %s", esp_err_to_name(ret));
+        if (g_dump_timer != NULL) {
+            esp_timer_delete(g_dump_timer);
+            g_dump_timer = NULL;
+        }
+    }
+#endif
+    
+    ESP_LOGI(TAG, "Handler profiling enabled (%d slots, %zu bytes)", PROFILE_SLOTS, size);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void handler_monitor_deinit(void)
+{
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    if (g_dump_timer != NULL) {
+        esp_timer_stop(g_dump_timer);
+        esp_timer_delete(g_dump_timer);
+        g_dump_timer = NULL;
+    }
+    
+    portENTER_CRITICAL(&g_stats_lock);
+    handler_profile_t *table = g_profiles;
+    g_profiles = NULL;
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+    free(table);
+#endif
+}
 
 /* ============================================================================
  * Public API Implementation
@@ -45,24 +273,44 @@ esp_err_t handler_monitor_execute(system_event_handler_t handler,
     
     // Calculate execution time
     int64_t end_time = esp_timer_get_time();
-    uint32_t elapsed_us = (uint32_t)(end_time - start_time);
     
+    return handler_monitor_record(service_id, event->event_type,
+                                  (uint32_t)(end_time - start_time));
+    
+#else
+    // Monitoring disabled, just execute handler
+    handler(event, user_data);
+    return ESP_OK;
+#endif
+}
+
+esp_err_t handler_monitor_record(system_service_id_t service_id,
+                                 system_event_type_t event_type,
+                                 uint32_t elapsed_us)
+{
+#if CONFIG_SYSTEM_SERVICE_ENABLE_HANDLER_MONITORING
     // Update statistics
     if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        portENTER_CRITICAL(&g_stats_lock);
         handler_stats_t *stats = &g_handler_stats[service_id];
         stats->total_time_us += elapsed_us;
         stats->execution_count++;
-        
+    
         if (elapsed_us > stats->max_time_us) {
             stats->max_time_us = elapsed_us;
         }
+        portEXIT_CRITICAL(&g_stats_lock);
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+        profile_record(service_id, event_type, elapsed_us);
+#endif
     }
     
     // Check for slow handler
     uint32_t warn_threshold_us = CONFIG_SYSTEM_SERVICE_HANDLER_WARN_THRESHOLD_MS * 1000;
     if (elapsed_us > warn_threshold_us) {
-        ESP_LOGW(TAG, "Slow handler detected: service_id=%d, time=%lu us (threshold=%lu us)",
-                 service_id, elapsed_us, warn_threshold_us);
+        ESP_LOGW(TAG, "Slow handler detected: service_id=%d, event=%d, time=%lu us (threshold=%lu us)",
+                 service_id, event_type, elapsed_us, warn_threshold_us);
     }
     
     // Check for timeout (if enabled)
@@ -70,7 +318,9 @@ esp_err_t handler_monitor_execute(system_event_handler_t handler,
     uint32_t timeout_us = CONFIG_SYSTEM_SERVICE_HANDLER_TIMEOUT_MS * 1000;
     if (elapsed_us > timeout_us) {
         if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+            portENTER_CRITICAL(&g_stats_lock);
             g_handler_stats[service_id].timeout_count++;
+            portEXIT_CRITICAL(&g_stats_lock);
         }
         ESP_LOGE(TAG, "Handler timeout: service_id=%d, time=%lu us (timeout=%lu us)",
                  service_id, elapsed_us, timeout_us);
@@ -81,8 +331,9 @@ esp_err_t handler_monitor_execute(system_event_handler_t handler,
     return ESP_OK;
     
 #else
-    // Monitoring disabled, just execute handler
-    handler(event, user_data);
+    (void)service_id;
+    (void)event_type;
+    (void)elapsed_us;
     return ESP_OK;
 #endif
 }
@@ -96,23 +347,191 @@ esp_err_t handler_monitor_get_stats(system_service_id_t service_id,
         return ESP_ERR_INVALID_ARG;
     }
     
-    handler_stats_t *stats = &g_handler_stats[service_id];
+    portENTER_CRITICAL(&g_stats_lock);
+    handler_stats_t stats = g_handler_stats[service_id];
+    portEXIT_CRITICAL(&g_stats_lock);
     
     if (avg_time_us != NULL) {
-        if (stats->execution_count > 0) {
-            *avg_time_us = (uint32_t)(stats->total_time_us / stats->execution_count);
+        if (stats.execution_count > 0) {
+            *avg_time_us = (uint32_t)(stats.total_time_us / stats.execution_count);
         } else {
             *avg_time_us = 0;
         }
     }
     
     if (max_time_us != NULL) {
-        *max_time_us = stats->max_time_us;
+        *max_time_us = stats.max_time_us;
     }
     
     if (timeout_count != NULL) {
-        *timeout_count = stats->timeout_count;
+        *timeout_count = stats.timeout_count;
+    }
+    
+    return ESP_OK;
+}
+
+uint32_t handler_monitor_get_executions(system_service_id_t service_id)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return 0;
+    }
+    
+    portENTER_CRITICAL(&g_stats_lock);
+    uint32_t count = g_handler_stats[service_id].execution_count;
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+    return count;
+}
+
+uint64_t handler_monitor_get_total_time(system_service_id_t service_id)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return 0;
+    }
+    
+    portENTER_CRITICAL(&g_stats_lock);
+    uint64_t total_us = g_handler_stats[service_id].total_time_us;
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+    return total_us;
+}
+
+esp_err_t system_event_get_handler_profile(system_service_id_t service_id,
+                                           system_event_type_t event_type,
+                                           system_handler_profile_t *out_profile)
+{
+    if (out_profile == NULL || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    // Snapshot so percentiles are computed outside the critical section
+    handler_profile_t profile;
+    portENTER_CRITICAL(&g_stats_lock);
+    if (g_profiles == NULL) {
+        portEXIT_CRITICAL(&g_stats_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    handler_profile_t *slot = find_profile_locked(service_id, event_type, false);
+    if (slot == NULL) {
+        portEXIT_CRITICAL(&g_stats_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    profile = *slot;
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+    fill_summary(&profile, out_profile);
+    return ESP_OK;
+#else
+    (void)event_type;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t system_event_get_top_handlers(system_handler_profile_t *out_profiles,
+                                        size_t max_profiles,
+                                        size_t *out_count)
+{
+    if (out_profiles == NULL || max_profiles == 0 || out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
+    *out_count = 0;
+    
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    if (g_profiles == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Insertion into a list kept sorted by total time, one slot per
+    // critical section so dispatch workers are never held up for long
+    size_t count = 0;
+    for (size_t i = 0; i < PROFILE_SLOTS; i++) {
+        handler_profile_t profile;
+        portENTER_CRITICAL(&g_stats_lock);
+        if (g_profiles == NULL) {
+            portEXIT_CRITICAL(&g_stats_lock);
+            return ESP_ERR_INVALID_STATE;
+        }
+        profile = g_profiles[i];
+        portEXIT_CRITICAL(&g_stats_lock);
+    
+        if (profile.service_id == SYSTEM_SERVICE_ID_INVALID || profile.count == 0) {
+            continue;
+        }
+    
+        size_t pos = count;
+        while (pos > 0 && out_profiles[pos - 1].total_us < profile.total_us) {
+            pos--;
+        }
+        if (pos >= max_profiles) {
+            continue;
+        }
+    
+        size_t last = (count < max_profiles) ? count : max_profiles - 1;
+        memmove(&out_profiles[pos + 1], &out_profiles[pos],
+                (last - pos) * sizeof(system_handler_profile_t));
+        fill_summary(&profile, &out_profiles[pos]);
+        if (count < max_profiles) {
+            count++;
+        }
+    }
+    
+    *out_count = count;
     return ESP_OK;
+#else
+    (void)max_profiles;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t system_event_reset_handler_profiles(void)
+{
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    portENTER_CRITICAL(&g_stats_lock);
+    if (g_profiles == NULL) {
+        portEXIT_CRITICAL(&g_stats_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    clear_profiles_locked();
+    portEXIT_CRITICAL(&g_stats_lock);
+    
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t system_event_dump_handler_profiles(size_t top_n)
+{
+#if CONFIG_SYSTEM_SERVICE_HANDLER_PROFILING
+    system_handler_profile_t top[16];
+    if (top_n == 0 || top_n > sizeof(top) / sizeof(top[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t count = 0;
+    esp_err_t ret = system_event_get_top_handlers(top, top_n, &count);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Top %zu handlers by total time (%lu samples unprofiled):",
+             count, g_profile_overflows);
+    for (size_t i = 0; i < count; i++) {
+        char name[32];
+        if (system_event_get_type_name(top[i].event_type, name, sizeof(name)) != ESP_OK) {
+            strcpy(name, "?");
+        }
+        ESP_LOGI(TAG, "  svc %2d %-20s n=%-7lu total=%llu ms p50=%lu us p99=%lu us max=%lu us",
+                 top[i].service_id, name, top[i].count,
+                 (unsigned long long)(top[i].total_us / 1000),
+                 top[i].p50_us, top[i].p99_us, top[i].max_us);
+    }
+    
+    return ESP_OK;
+#else
+    (void)top_n;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
 }
@@ -1,11 +1,21 @@
 /**
  * @file heap_monitor.c
  * @brief Heap fragmentation monitoring implementation
+ * 
+ * The sampler runs in the esp_timer task. Each pass reads both heaps,
+ * stores the sample and refits the trend, so readers only take a short
+ * critical section to copy results out.
  */
 
 #include "heap_monitor.h"
+#include "system_service/common_events.h"
+#include "system_service/event_bus.h"
+#include "system_service/service_manager.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
 
 static const char *TAG = "heap_monitor";
 
@@ -87,3 +97,272 @@ uint32_t heap_monitor_get_fragmentation(void)
     }
     return stats.fragmentation_percent;
 }
+
+/* ============================================================================
+ * Background Sampler
+ * ============================================================================ */
+
+#if CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+
+#define SAMPLE_COUNT        CONFIG_SYSTEM_SERVICE_HEAP_SAMPLE_COUNT
+#define MIN_INTERNAL_BLOCK  CONFIG_SYSTEM_SERVICE_HEAP_MIN_INTERNAL_BLOCK
+
+typedef struct {
+    bool running;
+    esp_timer_handle_t timer;
+    system_service_id_t service_id;     /**< Sender of heap warnings */
+    heap_sample_t samples[SAMPLE_COUNT];
+    uint32_t head;                      /**< Next slot to write */
+    uint32_t count;                     /**< Valid samples */
+    heap_trend_t trend;                 /**< Fit over the current history */
+    bool warned;                        /**< Warning posted, not yet cleared */
+} heap_sampler_t;
+
+static heap_sampler_t g_sampler = {0};
+static portMUX_TYPE g_sampler_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const heap_sample_t* sample_at(uint32_t i)
+{
+    // i = 0 is the oldest sample
+    return &g_sampler.samples[(g_sampler.head + SAMPLE_COUNT - g_sampler.count + i) % SAMPLE_COUNT];
+}
+
+/**
+ * @brief Least-squares slope of one sample field, in bytes per minute
+ */
+static int32_t fit_slope(size_t field_offset)
+{
+    uint32_t n = g_sampler.count;
+    uint32_t t0 = sample_at(0)->timestamp_ms;
+    int64_t sum_t = 0, sum_v = 0;
+    
+    for (uint32_t i = 0; i < n; i++) {
+        const heap_sample_t *sample = sample_at(i);
+        sum_t += sample->timestamp_ms - t0;
+        sum_v += *(const uint32_t *)((const uint8_t *)sample + field_offset);
+    }
+    
+    // Centered sums keep the products within 64 bits
+    int64_t mean_t = sum_t / n, mean_v = sum_v / n;
+    int64_t cov = 0, var = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const heap_sample_t *sample = sample_at(i);
+        int64_t dt = (int64_t)(sample->timestamp_ms - t0) - mean_t;
+        int64_t dv = (int64_t)*(const uint32_t *)((const uint8_t *)sample + field_offset) - mean_v;
+        cov += dt * dv;
+        var += dt * dt;
+    }
+    
+    if (var == 0) {
+        return 0;
+    }
+    return (int32_t)(cov * 60000 / var);
+}
+
+static heap_trend_t compute_trend(void)
+{
+    heap_trend_t trend = {
+        .sample_count = g_sampler.count,
+        .seconds_to_threshold = UINT32_MAX,
+    };
+    
+    if (g_sampler.count >= 2) {
+        trend.internal_free_slope = fit_slope(offsetof(heap_sample_t, internal_free));
+        trend.internal_largest_slope = fit_slope(offsetof(heap_sample_t, internal_largest));
+        trend.psram_free_slope = fit_slope(offsetof(heap_sample_t, psram_free));
+        trend.psram_largest_slope = fit_slope(offsetof(heap_sample_t, psram_largest));
+    }
+    
+    uint32_t largest = sample_at(g_sampler.count - 1)->internal_largest;
+    if (largest < MIN_INTERNAL_BLOCK) {
+        trend.seconds_to_threshold = 0;
+    } else if (trend.internal_largest_slope < 0) {
+        uint64_t margin = largest - MIN_INTERNAL_BLOCK;
+        uint64_t seconds = margin * 60 / (uint64_t)(-(int64_t)trend.internal_largest_slope);
+        trend.seconds_to_threshold = seconds > UINT32_MAX ? UINT32_MAX : (uint32_t)seconds;
+    }
+    
+    return trend;
+}
+
+static void post_warning(const heap_sample_t *sample, const heap_trend_t *trend)
+{
+    common_heap_warning_t warning = {
+        .largest_free_block = sample->internal_largest,
+        .free_bytes = sample->internal_free,
+        .threshold = MIN_INTERNAL_BLOCK,
+        .largest_block_slope = trend->internal_largest_slope,
+        .seconds_to_threshold = trend->seconds_to_threshold,
+    };
+    
+    SYSTEM_EVENT_POST_TYPED(g_sampler.service_id, COMMON_EVENT_HEAP_WARNING,
+                            &warning, SYSTEM_EVENT_PRIORITY_HIGH);
+}
+
+static void sampler_cb(void *arg)
+{
+    heap_sample_t sample = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        .internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+        .internal_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        .psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+        .psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+        .psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM),
+    };
+    
+    portENTER_CRITICAL(&g_sampler_lock);
+    g_sampler.samples[g_sampler.head] = sample;
+    g_sampler.head = (g_sampler.head + 1) % SAMPLE_COUNT;
+    if (g_sampler.count < SAMPLE_COUNT) {
+        g_sampler.count++;
+    }
+    portEXIT_CRITICAL(&g_sampler_lock);
+    
+    // Only this callback writes samples, so the fit can run unlocked
+    heap_trend_t trend = compute_trend();
+    
+    portENTER_CRITICAL(&g_sampler_lock);
+    g_sampler.trend = trend;
+    portEXIT_CRITICAL(&g_sampler_lock);
+    
+    // Needs a few samples before a slope means anything
+    bool at_risk = trend.seconds_to_threshold == 0 ||
+                   (trend.sample_count >= 4 &&
+                    trend.seconds_to_threshold <= CONFIG_SYSTEM_SERVICE_HEAP_WARNING_HORIZON_S);
+    
+    if (at_risk && !g_sampler.warned) {
+        g_sampler.warned = true;
+        ESP_LOGW(TAG, "Largest internal block %lu bytes, trend %ld B/min, %lu s to %d bytes",
+                 sample.internal_largest, trend.internal_largest_slope,
+                 trend.seconds_to_threshold, MIN_INTERNAL_BLOCK);
+        post_warning(&sample, &trend);
+    } else if (!at_risk && g_sampler.warned &&
+               sample.internal_largest >= MIN_INTERNAL_BLOCK + MIN_INTERNAL_BLOCK / 4) {
+        // Re-arm only with some headroom so a hovering value posts once
+        g_sampler.warned = false;
+        ESP_LOGI(TAG, "Internal heap recovered (largest block %lu bytes)", sample.internal_largest);
+    }
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+
+esp_err_t heap_monitor_start(void)
+{
+#if CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+    if (g_sampler.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(&g_sampler, 0, sizeof(g_sampler));
+    
+    esp_err_t ret = system_service_register("heap_monitor", NULL, &g_sampler.service_id);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register heap monitor service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    system_service_set_state(g_sampler.service_id, SYSTEM_SERVICE_STATE_RUNNING);
+    
+    const esp_timer_create_args_t args = {
+        .callback = sampler_cb,
+        .name = "heap_sampler",
+    };
+    ret = esp_timer_create(&args, &g_sampler.timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(g_sampler.timer,
+                                       (uint64_t)CONFIG_SYSTEM_SERVICE_HEAP_SAMPLE_INTERVAL_MS * 1000);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start heap sampler: %s", esp_err_to_name(ret));
+        if (g_sampler.timer != NULL) {
+            esp_timer_delete(g_sampler.timer);
+            g_sampler.timer = NULL;
+        }
+        system_service_unregister(g_sampler.service_id);
+        return ret;
+    }
+    
+    g_sampler.running = true;
+    
+    // First sample now so the history starts at boot
+    sampler_cb(NULL);
+    
+    ESP_LOGI(TAG, "Heap sampler started (%d ms interval, %d samples)",
+             CONFIG_SYSTEM_SERVICE_HEAP_SAMPLE_INTERVAL_MS, SAMPLE_COUNT);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void heap_monitor_stop(void)
+{
+#if CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+    if (!g_sampler.running) {
+        return;
+    }
+    
+    esp_timer_stop(g_sampler.timer);
+    esp_timer_delete(g_sampler.timer);
+    g_sampler.timer = NULL;
+    
+    system_service_unregister(g_sampler.service_id);
+    
+    portENTER_CRITICAL(&g_sampler_lock);
+    g_sampler.running = false;
+    g_sampler.count = 0;
+    g_sampler.head = 0;
+    portEXIT_CRITICAL(&g_sampler_lock);
+#endif
+}
+
+esp_err_t heap_monitor_get_samples(heap_sample_t *samples, size_t max_samples,
+                                   size_t *out_count)
+{
+    if (samples == NULL || out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+    if (!g_sampler.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    portENTER_CRITICAL(&g_sampler_lock);
+    
+    // Keep the newest samples when the caller has less room
+    uint32_t skip = (g_sampler.count > max_samples) ? g_sampler.count - max_samples : 0;
+    size_t count = g_sampler.count - skip;
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = *sample_at(skip + i);
+    }
+    
+    portEXIT_CRITICAL(&g_sampler_lock);
+    
+    *out_count = count;
+    return ESP_OK;
+#else
+    *out_count = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t heap_monitor_get_trend(heap_trend_t *trend)
+{
+    if (trend == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_HEAP_SAMPLER
+    portENTER_CRITICAL(&g_sampler_lock);
+    *trend = g_sampler.trend;
+    portEXIT_CRITICAL(&g_sampler_lock);
+    
+    if (!g_sampler.running || trend->sample_count < 2) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -0,0 +1,182 @@
+/**
+ * @file isr_event_ring.c
+ * @brief Lock-free multi-producer ring for events posted from interrupts
+ * 
+ * Bounded MPSC queue with per-slot sequence numbers. A producer claims a
+ * slot with a compare-and-swap on the write position, fills it, then
+ * publishes it by advancing the slot sequence. The consumer only ever
+ * reads slots whose sequence says they are published.
+ */
+
+#include "isr_event_ring.h"
+#include "memory_pool.h"
+#include "system_service/error_codes.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "isr_ring";
+
+/* ============================================================================
+ * Ring Structure
+ * ============================================================================ */
+
+#define ISR_RING_SIZE               CONFIG_SYSTEM_SERVICE_ISR_RING_SIZE
+#define ISR_RING_MASK               (ISR_RING_SIZE - 1)
+
+_Static_assert((ISR_RING_SIZE & ISR_RING_MASK) == 0,
+               "SYSTEM_SERVICE_ISR_RING_SIZE must be a power of two");
+
+typedef struct {
+    volatile uint32_t sequence;     /**< Publication state of this slot */
+    system_event_t event;           /**< Event header, data points at block */
+    void *block;                    /**< Pre-reserved payload block */
+} isr_ring_slot_t;
+
+typedef struct {
+    isr_ring_slot_t slots[ISR_RING_SIZE];
+    volatile uint32_t write_pos;    /**< Next position producers claim */
+    uint32_t read_pos;              /**< Next position the consumer reads */
+    volatile uint32_t drops;        /**< Rejected pushes */
+    bool initialized;
+} isr_ring_t;
+
+static DRAM_ATTR isr_ring_t g_ring = {0};
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t isr_event_ring_init(void)
+{
+    if (g_ring.initialized) {
+        return ESP_OK;
+    }
+    
+    memset(&g_ring, 0, sizeof(g_ring));
+    
+    for (uint32_t i = 0; i < ISR_RING_SIZE; i++) {
+        g_ring.slots[i].sequence = i;
+        
+        if (ISR_EVENT_MAX_DATA_SIZE > 0) {
+            g_ring.slots[i].block = memory_pool_alloc(ISR_EVENT_MAX_DATA_SIZE);
+            if (g_ring.slots[i].block == NULL) {
+                ESP_LOGE(TAG, "Failed to reserve block for slot %lu", (unsigned long)i);
+                isr_event_ring_deinit();
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+    
+    g_ring.initialized = true;
+    
+    ESP_LOGI(TAG, "ISR event ring ready: %d slots × %d bytes",
+             ISR_RING_SIZE, ISR_EVENT_MAX_DATA_SIZE);
+    
+    return ESP_OK;
+}
+
+void isr_event_ring_deinit(void)
+{
+    g_ring.initialized = false;
+    
+    for (uint32_t i = 0; i < ISR_RING_SIZE; i++) {
+        if (g_ring.slots[i].block != NULL) {
+            memory_pool_free(g_ring.slots[i].block);
+            g_ring.slots[i].block = NULL;
+        }
+    }
+}
+
+esp_err_t IRAM_ATTR isr_event_ring_push(const system_event_t *event,
+                                        const void *data,
+                                        size_t data_size)
+{
+    if (!g_ring.initialized || event == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (data_size > ISR_EVENT_MAX_DATA_SIZE) {
+        __atomic_add_fetch(&g_ring.drops, 1, __ATOMIC_RELAXED);
+        return ESP_ERR_EVENT_DATA_TOO_LARGE;
+    }
+    
+    // Claim a slot
+    isr_ring_slot_t *slot;
+    uint32_t pos = __atomic_load_n(&g_ring.write_pos, __ATOMIC_RELAXED);
+    while (true) {
+        slot = &g_ring.slots[pos & ISR_RING_MASK];
+        uint32_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&g_ring.write_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            // Consumer has not freed this slot yet - ring is full
+            __atomic_add_fetch(&g_ring.drops, 1, __ATOMIC_RELAXED);
+            return ESP_ERR_EVENT_QUEUE_FULL;
+        } else {
+            pos = __atomic_load_n(&g_ring.write_pos, __ATOMIC_RELAXED);
+        }
+    }
+    
+    // Fill the claimed slot
+    slot->event = *event;
+    slot->event.data = NULL;
+    slot->event.data_size = 0;
+    if (data != NULL && data_size > 0) {
+        memcpy(slot->block, data, data_size);
+        slot->event.data = slot->block;
+        slot->event.data_size = data_size;
+    }
+    
+    // Publish
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    
+    return ESP_OK;
+}
+
+esp_err_t isr_event_ring_pop(system_event_t *event)
+{
+    if (!g_ring.initialized || event == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    uint32_t pos = g_ring.read_pos;
+    isr_ring_slot_t *slot = &g_ring.slots[pos & ISR_RING_MASK];
+    
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    *event = slot->event;
+    
+    esp_err_t ret = ESP_OK;
+    if (event->data != NULL) {
+        // Hand the block over and re-arm the slot before releasing it
+        void *fresh = memory_pool_alloc(ISR_EVENT_MAX_DATA_SIZE);
+        if (fresh != NULL) {
+            slot->block = fresh;
+        } else {
+            event->data = NULL;
+            event->data_size = 0;
+            __atomic_add_fetch(&g_ring.drops, 1, __ATOMIC_RELAXED);
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    
+    // Make the slot available to producers one lap later
+    g_ring.read_pos = pos + 1;
+    __atomic_store_n(&slot->sequence, pos + ISR_RING_SIZE, __ATOMIC_RELEASE);
+    
+    return ret;
+}
+
+uint32_t isr_event_ring_get_drops(void)
+{
+    return __atomic_load_n(&g_ring.drops, __ATOMIC_RELAXED);
+}
@@ -1,6 +1,12 @@
 /**
  * @file log_control.c
- * @brief Per-service log level control implementation
+ * @brief Per-service log level control and deferred logging implementation
+ *
+ * Deferred messages are queued as format pointer plus raw arguments and
+ * formatted by one low-priority task. The per-service token buckets and
+ * cached levels sit under a spinlock, since the caller's check is a few
+ * loads and stores; the level table under g_log_mutex stays the source
+ * of truth for the configuration API.
  */
 
 #include "log_control.h"
@@ -8,6 +14,12 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "system_service/service_manager.h"
+#include "system_service/static_alloc.h"
+#include "system_service/system_log.h"
+#include "esp_timer.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "log_control";
@@ -25,6 +37,9 @@ typedef struct {
 
 static service_log_config_t g_log_configs[SYSTEM_SERVICE_MAX_SERVICES] = {0};
 static SemaphoreHandle_t g_log_mutex = NULL;
+SYSTEM_MUTEX_DEFINE(s_log_mutex);
+
+static void deferred_set_level(system_service_id_t service_id, esp_log_level_t level);
 
 /* ============================================================================
  * Internal Helpers
@@ -33,7 +48,7 @@ static SemaphoreHandle_t g_log_mutex = NULL;
 static void ensure_mutex(void)
 {
     if (g_log_mutex == NULL) {
-        g_log_mutex = xSemaphoreCreateMutex();
+        g_log_mutex = SYSTEM_MUTEX_CREATE(s_log_mutex);
     }
 }
 
@@ -71,7 +86,7 @@ static service_log_config_t* get_or_create_config(system_service_id_t service_id
             g_log_configs[i].active = true;
             g_log_configs[i].service_id = service_id;
             g_log_configs[i].level = ESP_LOG_INFO; // Default
-            
+    
             // Try to get service name
             system_service_info_t info;
             if (system_service_get_info(service_id, &info) == ESP_OK) {
@@ -79,7 +94,7 @@ static service_log_config_t* get_or_create_config(system_service_id_t service_id
                         SYSTEM_SERVICE_MAX_NAME_LEN - 1);
                 g_log_configs[i].service_name[SYSTEM_SERVICE_MAX_NAME_LEN - 1] = '\0';
             }
-            
+    
             return &g_log_configs[i];
         }
     }
@@ -123,6 +138,7 @@ esp_err_t log_control_set_level(system_service_id_t service_id, esp_log_level_t
     }
     
     config->level = level;
+    deferred_set_level(service_id, level);
     
     // Set ESP-IDF log level for service tag
     if (config->service_name[0] != '\0') {
@@ -176,6 +192,7 @@ esp_err_t log_control_set_level_by_name(const char *service_name, esp_log_level_
     service_log_config_t *config = find_config_by_name(service_name);
     if (config != NULL) {
         config->level = level;
+        deferred_set_level(config->service_id, level);
     }
     
     // Set ESP-IDF log level
@@ -200,6 +217,7 @@ esp_err_t log_control_reset_all(void)
     for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
         if (g_log_configs[i].active) {
             g_log_configs[i].level = ESP_LOG_INFO;
+            deferred_set_level(g_log_configs[i].service_id, ESP_LOG_INFO);
             if (g_log_configs[i].service_name[0] != '\0') {
                 esp_log_level_set(g_log_configs[i].service_name, ESP_LOG_INFO);
             }
@@ -234,3 +252,300 @@ void log_control_log_status(const char *tag)
     
     xSemaphoreGive(g_log_mutex);
 }
+
+/* ============================================================================
+ * Deferred Logging
+ * ============================================================================ */
+
+#if CONFIG_SYSTEM_SERVICE_LOG_DEFERRED
+
+#define DEFERRED_QUEUE_LEN      CONFIG_SYSTEM_SERVICE_LOG_QUEUE_LEN
+#define DEFERRED_LINE_MAX       CONFIG_SYSTEM_SERVICE_LOG_LINE_MAX
+#define DEFERRED_TASK_STACK     3072
+#define DEFERRED_TASK_PRIORITY  1
+#define DEFERRED_IDLE_MS        1000        // Summaries are flushed this often when idle
+#define BUCKET_SCALE            1000        // Tokens are kept in thousandths
+
+typedef struct {
+    const char *tag;
+    const char *format;
+    uint32_t timestamp;                     // esp_log_timestamp() at the call
+    uint8_t level;
+    uint8_t arg_count;
+    uintptr_t args[SYSTEM_LOG_MAX_ARGS];
+} deferred_entry_t;
+
+typedef struct {
+    uint32_t tokens;                        // In 1/BUCKET_SCALE messages
+    int64_t refill_us;
+    uint32_t suppressed;
+    const char *last_tag;                   // Tag for the suppression summary
+    esp_log_level_t level;
+} log_limit_t;
+
+static log_limit_t s_limits[SYSTEM_SERVICE_MAX_SERVICES];
+static log_limit_t s_system_limit;          // Callers without a valid service ID
+static portMUX_TYPE s_limit_lock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t s_log_queue = NULL;
+static TaskHandle_t s_log_task = NULL;
+static volatile bool s_log_running = false;
+static uint32_t s_dropped = 0;
+
+SYSTEM_QUEUE_DEFINE(s_log_queue_buf, DEFERRED_QUEUE_LEN, sizeof(deferred_entry_t));
+SYSTEM_TASK_DEFINE(s_log_task_buf, DEFERRED_TASK_STACK);
+
+static log_limit_t *limit_for(system_service_id_t service_id)
+{
+    return service_id < SYSTEM_SERVICE_MAX_SERVICES ? &s_limits[service_id] : &s_system_limit;
+}
+
+static void deferred_set_level(system_service_id_t service_id, esp_log_level_t level)
+{
+    portENTER_CRITICAL(&s_limit_lock);
+    limit_for(service_id)->level = level;
+    portEXIT_CRITICAL(&s_limit_lock);
+}
+
+static void limits_reset(void)
+{
+    int64_t now = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&s_limit_lock);
+    for (int i = 0; i <= SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        log_limit_t *limit = (i < SYSTEM_SERVICE_MAX_SERVICES) ? &s_limits[i] : &s_system_limit;
+        *limit = (log_limit_t){
+            .tokens = CONFIG_SYSTEM_SERVICE_LOG_BURST * BUCKET_SCALE,
+            .refill_us = now,
+            .level = CONFIG_LOG_DEFAULT_LEVEL,
+        };
+    }
+    portEXIT_CRITICAL(&s_limit_lock);
+    
+    // Levels set before the logger started
+    ensure_mutex();
+    if (xSemaphoreTake(g_log_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+            if (g_log_configs[i].active) {
+                deferred_set_level(g_log_configs[i].service_id, g_log_configs[i].level);
+            }
+        }
+        xSemaphoreGive(g_log_mutex);
+    }
+}
+
+/* Take a token; the caller holds s_limit_lock */
+static bool limit_take(log_limit_t *limit, int64_t now)
+{
+    uint64_t refill = (uint64_t)(now - limit->refill_us) * CONFIG_SYSTEM_SERVICE_LOG_RATE_PER_SEC / 1000;
+    limit->refill_us = now;
+    
+    uint64_t tokens = limit->tokens + refill;
+    limit->tokens = (tokens > CONFIG_SYSTEM_SERVICE_LOG_BURST * BUCKET_SCALE) ?
+                    CONFIG_SYSTEM_SERVICE_LOG_BURST * BUCKET_SCALE : (uint32_t)tokens;
+    
+    if (limit->tokens < BUCKET_SCALE) {
+        limit->suppressed++;
+        return false;
+    }
+    limit->tokens -= BUCKET_SCALE;
+    return true;
+}
+
+static void emit(const deferred_entry_t *entry)
+{
+    static const char letters[] = "NEWIDV";
+    char line[DEFERRED_LINE_MAX];
+    const uintptr_t *a = entry->args;
+    
+    // Unused trailing arguments are zero and ignored by the format
+    snprintf(line, sizeof(line), entry->format, a[0], a[1], a[2], a[3], a[4], a[5]);
+    
+    esp_log_level_t level = (esp_log_level_t)entry->level;
+    const char *color = (level == ESP_LOG_ERROR) ? LOG_COLOR_E :
+                        (level == ESP_LOG_WARN) ? LOG_COLOR_W :
+                        (level == ESP_LOG_INFO) ? LOG_COLOR_I : "";
+    const char *reset = color[0] != '\0' ? LOG_RESET_COLOR : "";
+    
+    esp_log_write(level, entry->tag, "%s%c (%lu) %s: %s%s\n", color, letters[level],
+                  (unsigned long)entry->timestamp, entry->tag, line, reset);
+}
+
+static bool enqueue(const deferred_entry_t *entry)
+{
+    if (xQueueSend(s_log_queue, entry, 0) != pdTRUE) {
+        __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+static void summary_entry(deferred_entry_t *entry, const char *tag, uint32_t suppressed)
+{
+    *entry = (deferred_entry_t){
+        .tag = tag != NULL ? tag : TAG,
+        .format = "%u messages suppressed",
+        .timestamp = esp_log_timestamp(),
+        .level = ESP_LOG_WARN,
+        .arg_count = 1,
+        .args = { suppressed },
+    };
+}
+
+void system_log_deferred(system_service_id_t service_id, esp_log_level_t level,
+                         const char *tag, const char *format,
+                         uint8_t arg_count, const uintptr_t *args)
+{
+    deferred_entry_t entry = {
+        .tag = tag,
+        .format = format,
+        .timestamp = esp_log_timestamp(),
+        .level = (uint8_t)level,
+        .arg_count = arg_count,
+    };
+    memcpy(entry.args, args, arg_count * sizeof(uintptr_t));
+    
+    if (!s_log_running) {
+        // Before the logger task starts, or after it stops, log in place
+        emit(&entry);
+        return;
+    }
+    
+    log_limit_t *limit = limit_for(service_id);
+    uint32_t suppressed = 0;
+    const char *last_tag = NULL;
+    
+    portENTER_CRITICAL(&s_limit_lock);
+    if (level > limit->level) {
+        portEXIT_CRITICAL(&s_limit_lock);
+        return;
+    }
+    if (level != ESP_LOG_ERROR && !limit_take(limit, esp_timer_get_time())) {
+        limit->last_tag = tag;
+        portEXIT_CRITICAL(&s_limit_lock);
+        return;
+    }
+    
+    // First message through after a suppressed run reports the run
+    suppressed = limit->suppressed;
+    last_tag = limit->last_tag;
+    limit->suppressed = 0;
+    portEXIT_CRITICAL(&s_limit_lock);
+    
+    if (suppressed > 0) {
+        deferred_entry_t summary;
+        summary_entry(&summary, last_tag, suppressed);
+        enqueue(&summary);
+    }
+    enqueue(&entry);
+}
+
+/* Report suppressed runs that no later message has reported yet */
+static void flush_summaries(void)
+{
+    for (int i = 0; i <= SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        log_limit_t *limit = (i < SYSTEM_SERVICE_MAX_SERVICES) ? &s_limits[i] : &s_system_limit;
+    
+        portENTER_CRITICAL(&s_limit_lock);
+        uint32_t suppressed = limit->suppressed;
+        const char *tag = limit->last_tag;
+        limit->suppressed = 0;
+        portEXIT_CRITICAL(&s_limit_lock);
+    
+        if (suppressed > 0) {
+            deferred_entry_t summary;
+            summary_entry(&summary, tag, suppressed);
+            emit(&summary);
+        }
+    }
+    
+    uint32_t dropped = __atomic_exchange_n(&s_dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        ESP_LOGW(TAG, "%lu deferred messages dropped, queue full", (unsigned long)dropped);
+    }
+}
+
+static void log_task(void *arg)
+{
+    deferred_entry_t entry;
+    
+    while (s_log_running) {
+        if (xQueueReceive(s_log_queue, &entry, pdMS_TO_TICKS(DEFERRED_IDLE_MS)) == pdTRUE) {
+            emit(&entry);
+            if (s_dropped == 0) {
+                continue;
+            }
+        }
+        flush_summaries();
+    }
+    
+    // Drain what is left before exiting
+    while (xQueueReceive(s_log_queue, &entry, 0) == pdTRUE) {
+        emit(&entry);
+    }
+    flush_summaries();
+    
+    s_log_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t log_control_deferred_init(void)
+{
+    if (s_log_queue != NULL) {
+        return ESP_OK;
+    }
+    
+    limits_reset();
+    
+    s_log_queue = SYSTEM_QUEUE_CREATE(s_log_queue_buf, DEFERRED_QUEUE_LEN, sizeof(deferred_entry_t));
+    if (s_log_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    s_log_running = true;
+    if (SYSTEM_TASK_CREATE(s_log_task_buf, log_task, "log_deferred", DEFERRED_TASK_STACK,
+                           NULL, DEFERRED_TASK_PRIORITY, &s_log_task) != pdPASS) {
+        s_log_running = false;
+        vQueueDelete(s_log_queue);
+        s_log_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Deferred logging: %d entries, %d msg/s per service, burst %d",
+             DEFERRED_QUEUE_LEN, CONFIG_SYSTEM_SERVICE_LOG_RATE_PER_SEC, CONFIG_SYSTEM_SERVICE_LOG_BURST);
+    return ESP_OK;
+}
+
+void log_control_deferred_deinit(void)
+{
+    if (s_log_queue == NULL) {
+        return;
+    }
+    
+    // The task drains the queue and exits within DEFERRED_IDLE_MS
+    s_log_running = false;
+    for (int i = 0; i < DEFERRED_IDLE_MS / 10 + 10 && s_log_task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    vQueueDelete(s_log_queue);
+    s_log_queue = NULL;
+}
+
+#else // !CONFIG_SYSTEM_SERVICE_LOG_DEFERRED
+
+static void deferred_set_level(system_service_id_t service_id, esp_log_level_t level)
+{
+    (void)service_id;
+    (void)level;
+}
+
+esp_err_t log_control_deferred_init(void)
+{
+    return ESP_OK;
+}
+
+void log_control_deferred_deinit(void)
+{
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_LOG_DEFERRED
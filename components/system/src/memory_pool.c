@@ -4,43 +4,137 @@
  * 
  * Uses pre-allocated memory pools to reduce heap fragmentation and improve
  * allocation performance. Falls back to heap for oversized allocations.
+ * 
+ * Free lists, reference counts and statistics are updated with atomic
+ * compare-and-swap, so allocation and release never block and can run
+ * concurrently on both cores.
+ * 
+ * Pool blocks carry no header: ownership is decided by address range and
+ * the block index is computed from the offset, with per-block bookkeeping
+ * kept in a side table.
+ * 
+ * With CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE a periodic pass adds slabs to
+ * classes that keep falling back to the heap and returns slabs that have
+ * gone idle. Slab 0 is the Kconfig-sized region and is never released.
+ * 
+ * memory_pool_alloc_tagged() charges each block to a service's memory
+ * quota; the owner is kept with the block and uncharged on the last free.
  */
 
 #include "memory_pool.h"
+#include "resource_quota.h"
+#include "system_service/memory_utils.h"
+#include "system_service/system_trace.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "memory_pool";
 
 /* ============================================================================
- * Pool Block Structure
+ * Block Bookkeeping
  * ============================================================================ */
 
-/** Magic number for block validation */
-#define POOL_BLOCK_MAGIC 0xDEADBEEF
+/** Per-block state, stored apart from the data so blocks stay header-free */
+typedef struct {
+    uint32_t next;                  /**< Next free block index + 1, 0 = end */
+    uint32_t refcount;              /**< Outstanding references while allocated */
+    system_service_id_t owner;      /**< Charged service, SYSTEM_SERVICE_ID_INVALID if none */
+    uint16_t reserved;
+} pool_block_meta_t;
 
-/** Block header for tracking */
-typedef struct pool_block {
-    uint32_t magic;                 /**< Magic number for validation */
-    memory_pool_size_t pool_id;     /**< Which pool this belongs to */
-    struct pool_block *next;        /**< Next free block in pool */
-} pool_block_t;
+/** Magic number for heap fallback blocks */
+#define HEAP_BLOCK_MAGIC 0xFEEDFACE
+
+/** Header in front of heap fallback blocks, which have no owning pool */
+typedef struct {
+    uint32_t magic;                 /**< HEAP_BLOCK_MAGIC while allocated */
+    uint32_t refcount;              /**< Outstanding references */
+    uint32_t size;                  /**< Requested size, as charged */
+    system_service_id_t owner;      /**< Charged service, SYSTEM_SERVICE_ID_INVALID if none */
+    uint8_t region;                 /**< quota_memory_region_t charged */
+    uint8_t reserved;
+} heap_block_t;
+
+/*
+ * Free list heads pack a generation tag above the block index + 1. Every
+ * successful push or pop bumps the tag, so a head that was popped and
+ * pushed back between a reader's load and its CAS no longer compares
+ * equal (ABA). 32-bit CAS is native on Xtensa and RISC-V.
+ */
+#define FREE_LIST_INDEX(head)        ((head) & 0xFFFFu)
+#define FREE_LIST_TAG(head)          ((head) >> 16)
+#define FREE_LIST_MAKE(tag, index)   (((uint32_t)(tag) << 16) | ((index) & 0xFFFFu))
+
+/* ============================================================================
+ * Adaptive Sizing
+ * ============================================================================ */
+
+#ifdef CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+#define POOL_GROWTH_SLABS       CONFIG_SYSTEM_SERVICE_POOL_GROWTH_SLABS
+#define POOL_SLAB_BLOCKS        CONFIG_SYSTEM_SERVICE_POOL_SLAB_BLOCKS
+#define POOL_ADAPT_INTERVAL_MS  CONFIG_SYSTEM_SERVICE_POOL_ADAPT_INTERVAL_MS
+#else
+#define POOL_GROWTH_SLABS       0
+#define POOL_SLAB_BLOCKS        0
+#endif
+
+/** Heap fallbacks within one interval that make a class grow */
+#define POOL_GROW_FAILURES      4
+
+/** Quiet intervals before the newest slab of a class is released */
+#define POOL_SHRINK_IDLE_WINDOWS 6
+
+/** Classes at least this large take growth slabs from PSRAM */
+#define POOL_PSRAM_MIN_DATA_SIZE 256
+
+#ifdef CONFIG_SYSTEM_SERVICE_ENABLE_LARGE_POOLS
+#define POOL_SIZE_1K            CONFIG_SYSTEM_SERVICE_POOL_SIZE_1K
+#define POOL_SIZE_2K            CONFIG_SYSTEM_SERVICE_POOL_SIZE_2K
+#define POOL_SIZE_4K            CONFIG_SYSTEM_SERVICE_POOL_SIZE_4K
+#define POOL_SIZE_8K            CONFIG_SYSTEM_SERVICE_POOL_SIZE_8K
+#define POOL_SIZE_16K           CONFIG_SYSTEM_SERVICE_POOL_SIZE_16K
+#else
+#define POOL_SIZE_1K            0
+#define POOL_SIZE_2K            0
+#define POOL_SIZE_4K            0
+#define POOL_SIZE_8K            0
+#define POOL_SIZE_16K           0
+#endif
+
+/** Slab 0 is the boot-time region, the rest are grown on demand */
+#define POOL_MAX_SLABS          (1 + POOL_GROWTH_SLABS)
 
 /* ============================================================================
  * Pool Structure
  * ============================================================================ */
 
+/** One contiguous run of blocks */
+typedef struct {
+    uint8_t *memory;                /**< First block, NULL if not present */
+    uintptr_t end;                  /**< One past the last block */
+    uint32_t first_index;           /**< Block index of the first block */
+    uint32_t block_count;           /**< Blocks in this slab */
+} pool_slab_t;
+
 typedef struct {
-    size_t block_size;              /**< Size of each block (including header) */
-    size_t data_size;               /**< Usable data size (block_size - header) */
-    uint32_t total_blocks;          /**< Total blocks in pool */
-    pool_block_t *free_list;        /**< Free list head */
-    void *pool_memory;              /**< Pointer to pool memory */
-    SemaphoreHandle_t mutex;        /**< Mutex for thread safety */
-    memory_pool_stats_t stats;      /**< Pool statistics */
+    size_t data_size;               /**< Size of each block (power of two) */
+    uint32_t block_shift;           /**< log2(data_size) */
+    uint32_t base_blocks;           /**< Blocks in slab 0 (Kconfig) */
+    uint32_t max_blocks;            /**< Bookkeeping entries, all slabs present */
+    uint32_t free_head;             /**< Tagged free list head */
+    uint32_t slab_count;            /**< Published slabs, read with acquire */
+    pool_slab_t slabs[POOL_MAX_SLABS];
+    pool_block_meta_t *meta;        /**< Bookkeeping, one entry per block */
+    memory_pool_stats_t stats;      /**< Pool statistics, updated atomically */
+    
+    // Adaptive sizing state, owned by the adapt pass
+    uint32_t window_peak;           /**< Peak blocks used this interval */
+    uint32_t last_failures;         /**< allocation_failures at last pass */
+    uint32_t idle_windows;          /**< Consecutive intervals with slack */
 } memory_pool_t;
 
 /* ============================================================================
@@ -53,21 +147,46 @@ static memory_pool_t g_pools[MEMORY_POOL_SIZE_COUNT];
 /** Pool initialized flag */
 static bool g_pools_initialized = false;
 
+#ifdef CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+/** Periodic adapt pass */
+static esp_timer_handle_t g_adapt_timer = NULL;
+#endif
+
 /** Pool size configurations */
 static const struct {
     size_t data_size;
     uint32_t count;
+    uint32_t caps;                  /**< heap_caps for the boot-time slab */
 } pool_configs[MEMORY_POOL_SIZE_COUNT] = {
-    { 64,  CONFIG_SYSTEM_SERVICE_POOL_SIZE_64  },
-    { 128, CONFIG_SYSTEM_SERVICE_POOL_SIZE_128 },
-    { 256, CONFIG_SYSTEM_SERVICE_POOL_SIZE_256 },
-    { 512, CONFIG_SYSTEM_SERVICE_POOL_SIZE_512 },
+    { 64,    CONFIG_SYSTEM_SERVICE_POOL_SIZE_64,  MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { 128,   CONFIG_SYSTEM_SERVICE_POOL_SIZE_128, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { 256,   CONFIG_SYSTEM_SERVICE_POOL_SIZE_256, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { 512,   CONFIG_SYSTEM_SERVICE_POOL_SIZE_512, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { 1024,  POOL_SIZE_1K,  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    { 2048,  POOL_SIZE_2K,  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    { 4096,  POOL_SIZE_4K,  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    { 8192,  POOL_SIZE_8K,  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    { 16384, POOL_SIZE_16K, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
 };
 
 /* ============================================================================
  * Internal Helper Functions
  * ============================================================================ */
 
+/**
+ * @brief Link meta entries [first, first + count) into one free chain
+ * 
+ * @param tail_next Index + 1 the last entry links to
+ */
+static void chain_blocks(memory_pool_t *pool, uint32_t first, uint32_t count, uint32_t tail_next)
+{
+    for (uint32_t i = first; i < first + count; i++) {
+        pool->meta[i].next = (i + 1 < first + count) ? i + 2 : tail_next;
+        pool->meta[i].refcount = 0;
+        pool->meta[i].owner = SYSTEM_SERVICE_ID_INVALID;
+    }
+}
+
 /**
  * @brief Initialize a single pool
  */
@@ -75,56 +194,57 @@ static esp_err_t pool_init_single(memory_pool_size_t pool_id)
 {
     memory_pool_t *pool = &g_pools[pool_id];
     
-    // Calculate block size (data + header)
+    memset(pool, 0, sizeof(memory_pool_t));
     pool->data_size = pool_configs[pool_id].data_size;
-    pool->block_size = pool->data_size + sizeof(pool_block_t);
-    pool->total_blocks = pool_configs[pool_id].count;
+    pool->block_shift = (uint32_t)__builtin_ctz(pool->data_size);
+    pool->base_blocks = pool_configs[pool_id].count;
     
     // Skip if pool size is 0
-    if (pool->total_blocks == 0) {
+    if (pool->base_blocks == 0) {
         ESP_LOGW(TAG, "Pool %d disabled (size=0)", pool_id);
-        pool->pool_memory = NULL;
-        pool->free_list = NULL;
-        pool->mutex = NULL;
         return ESP_OK;
     }
     
+    // Large classes are sized explicitly and never grow
+    uint32_t growth = (pool_id >= MEMORY_POOL_FIRST_LARGE) ? 0 : POOL_GROWTH_SLABS;
+    pool->max_blocks = pool->base_blocks + growth * POOL_SLAB_BLOCKS;
+    if (pool->max_blocks > FREE_LIST_INDEX(~0u)) {
+        ESP_LOGE(TAG, "Pool %d too large (%u blocks)", pool_id, pool->max_blocks);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
     // Allocate pool memory
-    size_t total_size = pool->block_size * pool->total_blocks;
-    pool->pool_memory = heap_caps_malloc(total_size, MALLOC_CAP_8BIT);
-    if (pool->pool_memory == NULL) {
+    size_t total_size = pool->data_size * pool->base_blocks;
+    pool_slab_t *slab = &pool->slabs[0];
+    slab->memory = heap_caps_malloc(total_size, pool_configs[pool_id].caps);
+    if (slab->memory == NULL) {
         ESP_LOGE(TAG, "Failed to allocate pool %d (%zu bytes)", pool_id, total_size);
         return ESP_ERR_NO_MEM;
     }
+    slab->end = (uintptr_t)slab->memory + total_size;
+    slab->first_index = 0;
+    slab->block_count = pool->base_blocks;
     
-    // Create mutex
-    pool->mutex = xSemaphoreCreateMutex();
-    if (pool->mutex == NULL) {
-        free(pool->pool_memory);
-        pool->pool_memory = NULL;
-        ESP_LOGE(TAG, "Failed to create mutex for pool %d", pool_id);
+    // Sized for every growth slab so growing never reallocates it
+    pool->meta = heap_caps_calloc(pool->max_blocks, sizeof(pool_block_meta_t), MALLOC_CAP_8BIT);
+    if (pool->meta == NULL) {
+        free(slab->memory);
+        memset(slab, 0, sizeof(pool_slab_t));
+        ESP_LOGE(TAG, "Failed to allocate bookkeeping for pool %d", pool_id);
         return ESP_ERR_NO_MEM;
     }
     
-    // Initialize free list
-    pool->free_list = NULL;
-    uint8_t *ptr = (uint8_t *)pool->pool_memory;
-    for (uint32_t i = 0; i < pool->total_blocks; i++) {
-        pool_block_t *block = (pool_block_t *)ptr;
-        block->magic = POOL_BLOCK_MAGIC;
-        block->pool_id = pool_id;
-        block->next = pool->free_list;
-        pool->free_list = block;
-        ptr += pool->block_size;
-    }
+    // Initialize free list, lowest block first
+    chain_blocks(pool, 0, pool->base_blocks, 0);
+    pool->free_head = FREE_LIST_MAKE(0, 1);
+    pool->slab_count = 1;
     
     // Initialize statistics
-    memset(&pool->stats, 0, sizeof(memory_pool_stats_t));
-    pool->stats.pool_size = pool->total_blocks;
-    pool->stats.blocks_free = pool->total_blocks;
+    pool->stats.pool_size = pool->base_blocks;
+    pool->stats.blocks_free = pool->base_blocks;
     
     ESP_LOGI(TAG, "Pool %d initialized: %u blocks × %zu bytes = %zu total",
-             pool_id, pool->total_blocks, pool->data_size, total_size);
+             pool_id, pool->base_blocks, pool->data_size, total_size);
     
     return ESP_OK;
 }
@@ -136,17 +256,94 @@ static void pool_deinit_single(memory_pool_size_t pool_id)
 {
     memory_pool_t *pool = &g_pools[pool_id];
     
-    if (pool->pool_memory != NULL) {
-        free(pool->pool_memory);
-        pool->pool_memory = NULL;
+    for (int i = 0; i < POOL_MAX_SLABS; i++) {
+        if (pool->slabs[i].memory != NULL) {
+            free(pool->slabs[i].memory);
+        }
+    }
+    
+    if (pool->meta != NULL) {
+        free(pool->meta);
     }
     
-    if (pool->mutex != NULL) {
-        vSemaphoreDelete(pool->mutex);
-        pool->mutex = NULL;
+    memset(pool, 0, sizeof(memory_pool_t));
+}
+
+/**
+ * @brief Address of the block with a given index
+ */
+static inline void* pool_block_addr(memory_pool_t *pool, uint32_t index)
+{
+    uint32_t slab_id = (index < pool->base_blocks) ? 0 :
+                       1 + (index - pool->base_blocks) / POOL_SLAB_BLOCKS;
+    const pool_slab_t *slab = &pool->slabs[slab_id];
+    
+    return slab->memory + ((index - slab->first_index) << pool->block_shift);
+}
+
+/**
+ * @brief Pop a block index off the free list without locking
+ * 
+ * A stale next read for a block another core just popped is harmless:
+ * the head's tag has moved on and the CAS fails.
+ * 
+ * @return Zero-based block index, or -1 if the pool is exhausted
+ */
+static int32_t free_list_pop(memory_pool_t *pool)
+{
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    
+    while (FREE_LIST_INDEX(head) != 0) {
+        uint32_t index = FREE_LIST_INDEX(head) - 1;
+        uint32_t next = __atomic_load_n(&pool->meta[index].next, __ATOMIC_RELAXED);
+        uint32_t new_head = FREE_LIST_MAKE(FREE_LIST_TAG(head) + 1, next);
+        
+        if (__atomic_compare_exchange_n(&pool->free_head, &head, new_head, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return (int32_t)index;
+        }
     }
     
-    pool->free_list = NULL;
+    return -1;
+}
+
+/**
+ * @brief Push a chain of block indices back onto the free list
+ * 
+ * @param first Index of the first block of the chain
+ * @param last Index of the last block, its next is overwritten
+ */
+static void free_list_push_chain(memory_pool_t *pool, uint32_t first, uint32_t last)
+{
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_RELAXED);
+    uint32_t new_head;
+    
+    do {
+        __atomic_store_n(&pool->meta[last].next, FREE_LIST_INDEX(head), __ATOMIC_RELAXED);
+        new_head = FREE_LIST_MAKE(FREE_LIST_TAG(head) + 1, first + 1);
+    } while (!__atomic_compare_exchange_n(&pool->free_head, &head, new_head, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Push a single block index back onto the free list
+ */
+static inline void free_list_push(memory_pool_t *pool, uint32_t index)
+{
+    free_list_push_chain(pool, index, index);
+}
+
+/**
+ * @brief Raise a high water mark to at least used
+ */
+static void stats_note_peak(uint32_t *peak, uint32_t used)
+{
+    uint32_t current = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    
+    while (used > current &&
+           !__atomic_compare_exchange_n(peak, &current, used, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
 }
 
 /**
@@ -163,48 +360,296 @@ static memory_pool_size_t select_pool_for_size(size_t size)
 }
 
 /**
- * @brief Check if pointer belongs to a pool
+ * @brief Find the pool block a pointer refers to, by address range only
+ * 
+ * Never dereferences ptr, so it is safe for any pointer.
+ * 
+ * @param out_index Output zero-based block index
+ * @return Owning pool, or NULL if ptr is not the start of a pool block
  */
-static bool is_pool_pointer(const void *ptr, memory_pool_size_t *out_pool_id)
+static memory_pool_t* find_pool_block(const void *ptr, uint32_t *out_index)
 {
-    if (ptr == NULL) {
-        return false;
+    uintptr_t addr = (uintptr_t)ptr;
+    
+    for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
+        memory_pool_t *pool = &g_pools[i];
+        uint32_t slab_count = __atomic_load_n(&pool->slab_count, __ATOMIC_ACQUIRE);
+        
+        for (uint32_t s = 0; s < slab_count; s++) {
+            const pool_slab_t *slab = &pool->slabs[s];
+            uintptr_t start = (uintptr_t)slab->memory;
+            
+            if (addr < start || addr >= slab->end) {
+                continue;
+            }
+            
+            uintptr_t offset = addr - start;
+            if ((offset & (pool->data_size - 1)) != 0) {
+                return NULL;  // Points into the middle of a block
+            }
+            
+            *out_index = slab->first_index + (uint32_t)(offset >> pool->block_shift);
+            return pool;
+        }
     }
     
-    // Get block header
-    const pool_block_t *block = (const pool_block_t *)((const uint8_t *)ptr - sizeof(pool_block_t));
+    return NULL;
+}
+
+/**
+ * @brief Allocate a heap fallback block carrying a small header
+ *
+ * The header holds the reference count, so heap blocks can be shared
+ * exactly like pool blocks.
+ */
+static void* heap_alloc_block(size_t size)
+{
+    SYSTEM_TRACE(SYSTEM_TRACE_POOL_FALLBACK, 0, size);
     
-    // Validate magic number
-    if (block->magic != POOL_BLOCK_MAGIC) {
-        return false;
+    // Keep large fallbacks out of internal SRAM where possible
+    heap_block_t *block = (size > pool_configs[MEMORY_POOL_FIRST_LARGE - 1].data_size) ?
+                          memory_alloc_prefer_psram(sizeof(heap_block_t) + size) :
+                          malloc(sizeof(heap_block_t) + size);
+    if (block == NULL) {
+        return NULL;
     }
     
-    // Validate pool ID
-    if (block->pool_id >= MEMORY_POOL_SIZE_COUNT) {
-        return false;
+    block->magic = HEAP_BLOCK_MAGIC;
+    block->refcount = 1;
+    block->size = (uint32_t)size;
+    block->owner = SYSTEM_SERVICE_ID_INVALID;
+    block->region = esp_ptr_external_ram(block) ? QUOTA_MEMORY_PSRAM : QUOTA_MEMORY_INTERNAL;
+    
+    return (void *)(block + 1);
+}
+
+/**
+ * @brief Quota region backing a pool's blocks
+ */
+static inline quota_memory_region_t pool_region(const memory_pool_t *pool)
+{
+    return (pool_configs[pool - g_pools].caps & MALLOC_CAP_SPIRAM) ?
+           QUOTA_MEMORY_PSRAM : QUOTA_MEMORY_INTERNAL;
+}
+
+/**
+ * @brief Reference count of a block handed out by memory_pool_alloc()
+ *
+ * Pointers outside every pool must be heap fallback blocks; their header
+ * is checked as a guard against foreign pointers.
+ *
+ * @return Reference count, or NULL if ptr was not allocated here
+ */
+static uint32_t* get_refcount(void *ptr, memory_pool_t **out_pool, uint32_t *out_index)
+{
+    *out_pool = find_pool_block(ptr, out_index);
+    if (*out_pool != NULL) {
+        return &(*out_pool)->meta[*out_index].refcount;
     }
     
-    // Validate pointer is within pool memory range
-    memory_pool_t *pool = &g_pools[block->pool_id];
-    if (pool->pool_memory == NULL) {
-        return false;
+    heap_block_t *block = (heap_block_t *)ptr - 1;
+    if (block->magic == HEAP_BLOCK_MAGIC) {
+        return &block->refcount;
     }
     
-    const uint8_t *pool_start = (const uint8_t *)pool->pool_memory;
-    const uint8_t *pool_end = pool_start + (pool->block_size * pool->total_blocks);
-    const uint8_t *block_ptr = (const uint8_t *)block;
+    return NULL;
+}
+
+/* ============================================================================
+ * Adaptive Sizing
+ * ============================================================================ */
+
+#ifdef CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+
+/**
+ * @brief Add one growth slab to a pool
+ * 
+ * The slab is published before its blocks reach the free list, so a block
+ * is always findable by address once it can be allocated.
+ */
+static esp_err_t pool_grow(memory_pool_size_t pool_id)
+{
+    memory_pool_t *pool = &g_pools[pool_id];
+    uint32_t slab_id = pool->slab_count;
     
-    if (block_ptr < pool_start || block_ptr >= pool_end) {
+    if (slab_id >= POOL_MAX_SLABS || pool_id >= MEMORY_POOL_FIRST_LARGE) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    size_t size = pool->data_size * POOL_SLAB_BLOCKS;
+    uint8_t *memory = (pool->data_size >= POOL_PSRAM_MIN_DATA_SIZE) ?
+                      memory_alloc_prefer_psram(size) : SYSTEM_MALLOC(size);
+    if (memory == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    pool_slab_t *slab = &pool->slabs[slab_id];
+    slab->first_index = pool->base_blocks + (slab_id - 1) * POOL_SLAB_BLOCKS;
+    slab->block_count = POOL_SLAB_BLOCKS;
+    slab->end = (uintptr_t)memory + size;
+    slab->memory = memory;
+    chain_blocks(pool, slab->first_index, POOL_SLAB_BLOCKS, 0);
+    
+    __atomic_store_n(&pool->slab_count, slab_id + 1, __ATOMIC_RELEASE);
+    
+    __atomic_add_fetch(&pool->stats.pool_size, POOL_SLAB_BLOCKS, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->stats.blocks_free, POOL_SLAB_BLOCKS, __ATOMIC_RELAXED);
+    free_list_push_chain(pool, slab->first_index, slab->first_index + POOL_SLAB_BLOCKS - 1);
+    
+    ESP_LOGI(TAG, "Pool %d grew to %u blocks (+%zu bytes)", pool_id,
+             pool->base_blocks + slab_id * POOL_SLAB_BLOCKS, size);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Release the newest growth slab if all its blocks are free
+ * 
+ * Detaches the whole free list, sorts out the slab's blocks and puts the
+ * rest back. Allocations racing with this briefly see an empty pool and
+ * fall back to the heap; nothing blocks.
+ */
+static bool pool_shrink(memory_pool_size_t pool_id)
+{
+    memory_pool_t *pool = &g_pools[pool_id];
+    uint32_t slab_id = pool->slab_count - 1;
+    
+    if (slab_id == 0) {
         return false;
     }
     
-    if (out_pool_id != NULL) {
-        *out_pool_id = block->pool_id;
+    pool_slab_t *slab = &pool->slabs[slab_id];
+    uint32_t lo = slab->first_index;
+    uint32_t hi = lo + slab->block_count;
+    
+    // Take the whole free list
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&pool->free_head, &head,
+                                        FREE_LIST_MAKE(FREE_LIST_TAG(head) + 1, 0), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+    }
+    
+    // Split it into blocks to keep and blocks of the retiring slab
+    uint32_t keep_first = 0, keep_last = 0, drop_first = 0, drop_last = 0;
+    uint32_t dropped = 0;
+    
+    for (uint32_t link = FREE_LIST_INDEX(head); link != 0; ) {
+        uint32_t index = link - 1;
+        link = pool->meta[index].next;
+        
+        bool drop = (index >= lo && index < hi);
+        uint32_t *first = drop ? &drop_first : &keep_first;
+        uint32_t *last = drop ? &drop_last : &keep_last;
+        
+        if (*first == 0) {
+            *first = index + 1;
+        } else {
+            pool->meta[*last - 1].next = index + 1;
+        }
+        *last = index + 1;
+        dropped += drop ? 1 : 0;
     }
     
+    bool release = (dropped == slab->block_count);
+    
+    if (!release && drop_first != 0) {
+        // Some block is still allocated, keep the slab
+        if (keep_first == 0) {
+            keep_first = drop_first;
+        } else {
+            pool->meta[keep_last - 1].next = drop_first;
+        }
+        keep_last = drop_last;
+    }
+    
+    if (keep_first != 0) {
+        free_list_push_chain(pool, keep_first - 1, keep_last - 1);
+    }
+    
+    if (!release) {
+        return false;
+    }
+    
+    __atomic_store_n(&pool->slab_count, slab_id, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&pool->stats.pool_size, slab->block_count, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&pool->stats.blocks_free, slab->block_count, __ATOMIC_RELAXED);
+    
+    free(slab->memory);
+    memset(slab, 0, sizeof(pool_slab_t));
+    
+    ESP_LOGI(TAG, "Pool %d shrank to %u blocks", pool_id,
+             pool->base_blocks + (slab_id - 1) * POOL_SLAB_BLOCKS);
+    
     return true;
 }
 
+/**
+ * @brief Periodic pass: grow classes that fell back to heap, shrink idle ones
+ */
+static void pool_adapt_cb(void *arg)
+{
+    (void)arg;
+    
+    for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
+        memory_pool_t *pool = &g_pools[i];
+        if (pool->slab_count == 0) {
+            continue;
+        }
+        
+        uint32_t failures = __atomic_load_n(&pool->stats.allocation_failures, __ATOMIC_RELAXED);
+        uint32_t new_failures = failures - pool->last_failures;
+        uint32_t peak = __atomic_exchange_n(&pool->window_peak,
+                                            __atomic_load_n(&pool->stats.blocks_used, __ATOMIC_RELAXED),
+                                            __ATOMIC_RELAXED);
+        uint32_t capacity = __atomic_load_n(&pool->stats.pool_size, __ATOMIC_RELAXED);
+        pool->last_failures = failures;
+        
+        if (new_failures >= POOL_GROW_FAILURES) {
+            pool->idle_windows = 0;
+            if (pool_grow((memory_pool_size_t)i) != ESP_OK) {
+                ESP_LOGD(TAG, "Pool %d cannot grow further", i);
+            }
+            continue;
+        }
+        
+        // Newest slab plus half a slab of headroom went unused
+        bool slack = (pool->slab_count > 1 && new_failures == 0 &&
+                      peak + POOL_SLAB_BLOCKS + POOL_SLAB_BLOCKS / 2 <= capacity);
+        pool->idle_windows = slack ? pool->idle_windows + 1 : 0;
+        
+        if (pool->idle_windows >= POOL_SHRINK_IDLE_WINDOWS &&
+            pool_shrink((memory_pool_size_t)i)) {
+            pool->idle_windows = 0;
+        }
+    }
+}
+
+static esp_err_t pool_adapt_start(void)
+{
+    const esp_timer_create_args_t args = {
+        .callback = pool_adapt_cb,
+        .name = "pool_adapt",
+    };
+    
+    esp_err_t ret = esp_timer_create(&args, &g_adapt_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    return esp_timer_start_periodic(g_adapt_timer, (uint64_t)POOL_ADAPT_INTERVAL_MS * 1000);
+}
+
+static void pool_adapt_stop(void)
+{
+    if (g_adapt_timer != NULL) {
+        esp_timer_stop(g_adapt_timer);
+        esp_timer_delete(g_adapt_timer);
+        g_adapt_timer = NULL;
+    }
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -221,6 +666,11 @@ esp_err_t memory_pool_init(void)
     // Initialize all pools
     for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
         esp_err_t ret = pool_init_single((memory_pool_size_t)i);
+        if (ret != ESP_OK && i >= MEMORY_POOL_FIRST_LARGE) {
+            // Large payloads fall back to the heap, small events are unaffected
+            ESP_LOGW(TAG, "Large pool %d unavailable: %s", i, esp_err_to_name(ret));
+            continue;
+        }
         if (ret != ESP_OK && pool_configs[i].count > 0) {
             // Cleanup already initialized pools
             for (int j = 0; j < i; j++) {
@@ -230,6 +680,13 @@ esp_err_t memory_pool_init(void)
         }
     }
     
+#ifdef CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+    if (pool_adapt_start() != ESP_OK) {
+        // Pools still work at their configured size
+        ESP_LOGW(TAG, "Adaptive pool sizing unavailable");
+    }
+#endif
+    
     g_pools_initialized = true;
     ESP_LOGI(TAG, "Memory pools initialized successfully");
     
@@ -244,6 +701,10 @@ esp_err_t memory_pool_deinit(void)
     
     ESP_LOGI(TAG, "Deinitializing memory pools...");
     
+#ifdef CONFIG_SYSTEM_SERVICE_POOL_ADAPTIVE
+    pool_adapt_stop();
+#endif
+    
     // Deinitialize all pools
     for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
         pool_deinit_single((memory_pool_size_t)i);
@@ -255,7 +716,10 @@ esp_err_t memory_pool_deinit(void)
     return ESP_OK;
 }
 
-void* memory_pool_alloc(size_t size)
+/**
+ * @brief Allocate a block with a reference count of 1 and no owner
+ */
+static void* pool_alloc_block(size_t size)
 {
     if (!g_pools_initialized || size == 0) {
         return NULL;
@@ -266,7 +730,7 @@ void* memory_pool_alloc(size_t size)
     
     // If too large for any pool, use heap
     if (pool_id >= MEMORY_POOL_SIZE_COUNT) {
-        void *ptr = malloc(size);
+        void *ptr = heap_alloc_block(size);
         ESP_LOGD(TAG, "Heap alloc %zu bytes (too large for pool): %p", size, ptr);
         return ptr;
     }
@@ -274,91 +738,160 @@ void* memory_pool_alloc(size_t size)
     memory_pool_t *pool = &g_pools[pool_id];
     
     // If pool is disabled, use heap
-    if (pool->pool_memory == NULL) {
-        void *ptr = malloc(size);
+    if (pool->meta == NULL) {
+        void *ptr = heap_alloc_block(size);
         ESP_LOGD(TAG, "Heap alloc %zu bytes (pool disabled): %p", size, ptr);
         return ptr;
     }
     
     // Try to allocate from pool
-    if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGW(TAG, "Failed to acquire pool mutex");
-        return NULL;
-    }
-    
-    pool_block_t *block = pool->free_list;
+    int32_t index = free_list_pop(pool);
     void *ptr = NULL;
     
-    if (block != NULL) {
-        // Remove from free list
-        pool->free_list = block->next;
+    if (index >= 0) {
+        __atomic_store_n(&pool->meta[index].refcount, 1, __ATOMIC_RELAXED);
         
         // Update statistics
-        pool->stats.blocks_used++;
-        pool->stats.blocks_free--;
-        pool->stats.total_allocations++;
-        if (pool->stats.blocks_used > pool->stats.high_water_mark) {
-            pool->stats.high_water_mark = pool->stats.blocks_used;
-        }
+        uint32_t used = __atomic_add_fetch(&pool->stats.blocks_used, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&pool->stats.blocks_free, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pool->stats.total_allocations, 1, __ATOMIC_RELAXED);
+        stats_note_peak(&pool->stats.high_water_mark, used);
+        stats_note_peak(&pool->window_peak, used);
         
-        // Return pointer to data (after header)
-        ptr = (void *)((uint8_t *)block + sizeof(pool_block_t));
+        ptr = pool_block_addr(pool, (uint32_t)index);
         
-        ESP_LOGD(TAG, "Pool %d alloc %zu bytes: %p (free=%u)", 
-                 pool_id, size, ptr, pool->stats.blocks_free);
+        ESP_LOGD(TAG, "Pool %d alloc %zu bytes: %p (used=%u)", 
+                 pool_id, size, ptr, used);
     } else {
         // Pool exhausted, update statistics
-        pool->stats.allocation_failures++;
+        __atomic_add_fetch(&pool->stats.allocation_failures, 1, __ATOMIC_RELAXED);
         ESP_LOGW(TAG, "Pool %d exhausted, falling back to heap", pool_id);
     }
     
-    xSemaphoreGive(pool->mutex);
-    
     // Fall back to heap if pool exhausted
     if (ptr == NULL) {
-        ptr = malloc(size);
+        ptr = heap_alloc_block(size);
         ESP_LOGD(TAG, "Heap alloc %zu bytes (pool full): %p", size, ptr);
     }
     
     return ptr;
 }
 
+void* memory_pool_alloc(size_t size)
+{
+    return pool_alloc_block(size);
+}
+
+void* memory_pool_alloc_tagged(system_service_id_t owner, size_t size)
+{
+    void *ptr = pool_alloc_block(size);
+    if (ptr == NULL || owner == SYSTEM_SERVICE_ID_INVALID) {
+        return ptr;
+    }
+    
+    memory_pool_t *pool;
+    uint32_t index;
+    get_refcount(ptr, &pool, &index);
+    
+    // A pool block costs its whole size class
+    size_t charged = (pool != NULL) ? pool->data_size : size;
+    quota_memory_region_t region = (pool != NULL) ? pool_region(pool) :
+                                   (quota_memory_region_t)((heap_block_t *)ptr - 1)->region;
+    
+    if (quota_record_memory_alloc(owner, charged, region) != ESP_OK) {
+        memory_pool_free(ptr);
+        return NULL;
+    }
+    
+    if (pool != NULL) {
+        pool->meta[index].owner = owner;
+    } else {
+        ((heap_block_t *)ptr - 1)->owner = owner;
+    }
+    
+    return ptr;
+}
+
+esp_err_t memory_pool_retain(void *ptr)
+{
+    if (ptr == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memory_pool_t *pool;
+    uint32_t index;
+    uint32_t *refcount = get_refcount(ptr, &pool, &index);
+    if (refcount == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint32_t count = __atomic_load_n(refcount, __ATOMIC_RELAXED);
+    do {
+        if (count == 0) {
+            return ESP_ERR_INVALID_STATE;  // Already released
+        }
+    } while (!__atomic_compare_exchange_n(refcount, &count, count + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    return ESP_OK;
+}
+
 void memory_pool_free(void *ptr)
 {
     if (ptr == NULL) {
         return;
     }
     
-    // Check if this is a pool pointer
-    memory_pool_size_t pool_id;
-    if (!is_pool_pointer(ptr, &pool_id)) {
-        // Not from pool, free to heap
-        free(ptr);
-        ESP_LOGD(TAG, "Heap free: %p", ptr);
+    memory_pool_t *pool;
+    uint32_t index;
+    uint32_t *refcount = get_refcount(ptr, &pool, &index);
+    if (refcount == NULL) {
+        ESP_LOGE(TAG, "Free of foreign pointer ignored: %p", ptr);
         return;
     }
     
-    // Return to pool
-    memory_pool_t *pool = &g_pools[pool_id];
-    pool_block_t *block = (pool_block_t *)((uint8_t *)ptr - sizeof(pool_block_t));
+    // Drop one reference, only the last one returns the block
+    uint32_t count = __atomic_load_n(refcount, __ATOMIC_RELAXED);
+    do {
+        if (count == 0) {
+            ESP_LOGW(TAG, "Double free ignored: %p", ptr);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(refcount, &count, count - 1, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
     
-    if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGW(TAG, "Failed to acquire pool mutex for free");
+    if (count > 1) {
         return;
     }
     
-    // Add to free list
-    block->next = pool->free_list;
-    pool->free_list = block;
+    if (pool == NULL) {
+        // Heap fallback block
+        heap_block_t *block = (heap_block_t *)ptr - 1;
+        if (block->owner != SYSTEM_SERVICE_ID_INVALID) {
+            quota_record_memory_free(block->owner, block->size,
+                                     (quota_memory_region_t)block->region);
+        }
+        block->magic = 0;
+        free(block);
+        ESP_LOGD(TAG, "Heap free: %p", ptr);
+        return;
+    }
+    
+    pool_block_meta_t *meta = &pool->meta[index];
+    if (meta->owner != SYSTEM_SERVICE_ID_INVALID) {
+        quota_record_memory_free(meta->owner, pool->data_size, pool_region(pool));
+        meta->owner = SYSTEM_SERVICE_ID_INVALID;
+    }
     
-    // Update statistics
-    pool->stats.blocks_used--;
-    pool->stats.blocks_free++;
-    pool->stats.total_frees++;
+    // Update statistics before the block becomes visible to allocators
+    __atomic_sub_fetch(&pool->stats.blocks_used, 1, __ATOMIC_RELAXED);
+    uint32_t free_count = __atomic_add_fetch(&pool->stats.blocks_free, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->stats.total_frees, 1, __ATOMIC_RELAXED);
     
-    ESP_LOGD(TAG, "Pool %d free: %p (free=%u)", pool_id, ptr, pool->stats.blocks_free);
+    // Add to free list
+    free_list_push(pool, index);
     
-    xSemaphoreGive(pool->mutex);
+    ESP_LOGD(TAG, "Pool %d free: %p (free=%u)", (int)(pool - g_pools), ptr, free_count);
 }
 
 esp_err_t memory_pool_get_stats(memory_pool_size_t pool_size, memory_pool_stats_t *stats)
@@ -373,19 +906,20 @@ esp_err_t memory_pool_get_stats(memory_pool_size_t pool_size, memory_pool_stats_
     
     memory_pool_t *pool = &g_pools[pool_size];
     
-    if (pool->mutex == NULL) {
+    if (pool->meta == NULL) {
         // Pool disabled
         memset(stats, 0, sizeof(memory_pool_stats_t));
         return ESP_OK;
     }
     
-    if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
-    }
-    
-    memcpy(stats, &pool->stats, sizeof(memory_pool_stats_t));
-    
-    xSemaphoreGive(pool->mutex);
+    // Field-by-field snapshot, counters may move between reads
+    stats->pool_size = __atomic_load_n(&pool->stats.pool_size, __ATOMIC_RELAXED);
+    stats->blocks_used = __atomic_load_n(&pool->stats.blocks_used, __ATOMIC_RELAXED);
+    stats->blocks_free = __atomic_load_n(&pool->stats.blocks_free, __ATOMIC_RELAXED);
+    stats->total_allocations = __atomic_load_n(&pool->stats.total_allocations, __ATOMIC_RELAXED);
+    stats->total_frees = __atomic_load_n(&pool->stats.total_frees, __ATOMIC_RELAXED);
+    stats->allocation_failures = __atomic_load_n(&pool->stats.allocation_failures, __ATOMIC_RELAXED);
+    stats->high_water_mark = __atomic_load_n(&pool->stats.high_water_mark, __ATOMIC_RELAXED);
     
     return ESP_OK;
 }
@@ -414,14 +948,13 @@ void memory_pool_reset_stats(void)
     
     for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
         memory_pool_t *pool = &g_pools[i];
-        if (pool->mutex != NULL) {
-            if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                pool->stats.total_allocations = 0;
-                pool->stats.total_frees = 0;
-                pool->stats.allocation_failures = 0;
-                pool->stats.high_water_mark = pool->stats.blocks_used;
-                xSemaphoreGive(pool->mutex);
-            }
+        if (pool->meta != NULL) {
+            __atomic_store_n(&pool->stats.total_allocations, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&pool->stats.total_frees, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&pool->stats.allocation_failures, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&pool->stats.high_water_mark,
+                             __atomic_load_n(&pool->stats.blocks_used, __ATOMIC_RELAXED),
+                             __ATOMIC_RELAXED);
         }
     }
 }
@@ -434,13 +967,13 @@ void memory_pool_log_stats(const char *tag)
     }
     
     ESP_LOGI(tag, "Memory Pool Statistics:");
-    ESP_LOGI(tag, "  Pool | Size | Total | Used | Free | Allocs | Frees | Failures | HWM");
-    ESP_LOGI(tag, "  -----|------|-------|------|------|--------|-------|----------|----");
+    ESP_LOGI(tag, "  Pool |  Size | Total | Used | Free | Allocs | Frees | Failures | HWM");
+    ESP_LOGI(tag, "  -----|-------|-------|------|------|--------|-------|----------|----");
     
     for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
         memory_pool_stats_t stats;
         if (memory_pool_get_stats((memory_pool_size_t)i, &stats) == ESP_OK) {
-            ESP_LOGI(tag, "  %4d | %4zu | %5u | %4u | %4u | %6u | %5u | %8u | %3u",
+            ESP_LOGI(tag, "  %4d | %5zu | %5u | %4u | %4u | %6u | %5u | %8u | %3u",
                      i,
                      pool_configs[i].data_size,
                      stats.pool_size,
@@ -452,6 +985,45 @@ void memory_pool_log_stats(const char *tag)
                      stats.high_water_mark);
         }
     }
+    
+    uint32_t suggested[MEMORY_POOL_SIZE_COUNT];
+    if (memory_pool_suggest_sizes(suggested) == ESP_OK) {
+        for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
+            if (pool_configs[i].count > 0) {
+                ESP_LOGI(tag, "  Suggested size for %zu-byte pool: %u",
+                         pool_configs[i].data_size, suggested[i]);
+            }
+        }
+    }
+}
+
+esp_err_t memory_pool_suggest_sizes(uint32_t counts[MEMORY_POOL_SIZE_COUNT])
+{
+    if (counts == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!g_pools_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    for (int i = 0; i < MEMORY_POOL_SIZE_COUNT; i++) {
+        memory_pool_stats_t stats;
+        memory_pool_get_stats((memory_pool_size_t)i, &stats);
+        
+        // Observed peak plus a quarter of headroom
+        uint32_t count = stats.high_water_mark + (stats.high_water_mark + 3) / 4;
+        
+        // A class that still overflowed needs more than it has now
+        if (stats.allocation_failures > 0 && count <= stats.pool_size) {
+            count = stats.pool_size + stats.pool_size / 2 + 1;
+        }
+        
+        // Never suggest enabling a class that was turned off
+        counts[i] = (pool_configs[i].count == 0) ? 0 : count;
+    }
+    
+    return ESP_OK;
 }
 
 bool memory_pool_check_health(void)
@@ -1,9 +1,21 @@
 #include "system_service/memory_utils.h"
+#include "resource_quota.h"
 #include "esp_log.h"
 #include <string.h>
 
 static const char *TAG = "memory_utils";
 
+#define TAGGED_ALLOC_MAGIC  0x7A66ED00
+
+// Placed in front of tagged allocations; 16 bytes keeps the data aligned
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint16_t owner;
+    uint8_t region;
+    uint8_t reserved[5];
+} tagged_alloc_header_t;
+
 esp_err_t memory_get_info(memory_info_t *info)
 {
     if (info == NULL) {
@@ -115,3 +127,53 @@ void* memory_alloc_sram_only(size_t size)
     
     return ptr;
 }
+
+void* memory_alloc_prefer_psram_tagged(system_service_id_t owner, size_t size)
+{
+    size_t total = sizeof(tagged_alloc_header_t) + size;
+    quota_memory_region_t region = QUOTA_MEMORY_PSRAM;
+    tagged_alloc_header_t *header = NULL;
+    
+    if (memory_psram_available()) {
+        header = heap_caps_malloc(total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    
+    if (header == NULL) {
+        region = QUOTA_MEMORY_INTERNAL;
+        header = heap_caps_malloc(total, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (header == NULL) {
+            return NULL;
+        }
+    }
+    
+    // Charged by where the block landed, so a SRAM fallback counts as SRAM
+    if (quota_record_memory_alloc(owner, size, region) != ESP_OK) {
+        heap_caps_free(header);
+        return NULL;
+    }
+    
+    header->magic = TAGGED_ALLOC_MAGIC;
+    header->size = (uint32_t)size;
+    header->owner = (uint16_t)owner;
+    header->region = (uint8_t)region;
+    
+    return header + 1;
+}
+
+void memory_free_tagged(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    
+    tagged_alloc_header_t *header = (tagged_alloc_header_t *)ptr - 1;
+    if (header->magic != TAGGED_ALLOC_MAGIC) {
+        ESP_LOGE(TAG, "memory_free_tagged: %p was not tagged", ptr);
+        return;
+    }
+    
+    quota_record_memory_free((system_service_id_t)header->owner, header->size,
+                             (quota_memory_region_t)header->region);
+    header->magic = 0;
+    heap_caps_free(header);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file power_lock.c
+ * @brief Refcounted power locks implementation
+ *
+ * Every lock wraps one esp_pm lock, which esp_pm refcounts itself; the
+ * counts kept here under a spinlock only feed the per-lock statistics and
+ * the mode residency. A mode lasts from one change of the most demanding
+ * held lock type to the next.
+ */
+
+#include "system_service/power_lock.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "power_lock";
+
+/* ============================================================================
+ * Lock State
+ * ============================================================================ */
+
+#define MAX_POWER_LOCKS             CONFIG_SYSTEM_SERVICE_MAX_POWER_LOCKS
+
+struct system_power_lock {
+    char name[SYSTEM_POWER_LOCK_NAME_LEN];
+    system_power_lock_type_t type;
+    esp_pm_lock_handle_t pm_lock;   // NULL without CONFIG_PM_ENABLE
+    uint32_t holders;
+    uint32_t acquisitions;
+    int64_t held_since_us;
+    uint64_t held_us;
+};
+
+typedef struct {
+    struct system_power_lock locks[MAX_POWER_LOCKS];
+    uint8_t lock_count;
+    uint32_t type_holders[SYSTEM_POWER_LOCK_TYPE_COUNT];
+    system_power_mode_t mode;
+    int64_t mode_since_us;
+    uint64_t mode_us[SYSTEM_POWER_MODE_COUNT];
+    uint32_t transitions;
+} power_locks_t;
+
+static power_locks_t g_power = {
+    .mode = SYSTEM_POWER_MODE_SLEEP,
+};
+static portMUX_TYPE g_power_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const mode_names[SYSTEM_POWER_MODE_COUNT] = {
+    [SYSTEM_POWER_MODE_CPU_MAX] = "cpu_max",
+    [SYSTEM_POWER_MODE_APB_MAX] = "apb_max",
+    [SYSTEM_POWER_MODE_AWAKE] = "awake",
+    [SYSTEM_POWER_MODE_SLEEP] = "sleep",
+};
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static system_power_mode_t current_mode(void)
+{
+    if (g_power.type_holders[SYSTEM_POWER_LOCK_CPU_MAX] > 0) {
+        return SYSTEM_POWER_MODE_CPU_MAX;
+    }
+    if (g_power.type_holders[SYSTEM_POWER_LOCK_APB_MAX] > 0) {
+        return SYSTEM_POWER_MODE_APB_MAX;
+    }
+    if (g_power.type_holders[SYSTEM_POWER_LOCK_NO_SLEEP] > 0) {
+        return SYSTEM_POWER_MODE_AWAKE;
+    }
+    return SYSTEM_POWER_MODE_SLEEP;
+}
+
+/* Close the running mode interval if the mode changed; lock held */
+static void account_mode(int64_t now_us)
+{
+    system_power_mode_t mode = current_mode();
+    if (mode == g_power.mode) {
+        return;
+    }
+    
+    g_power.mode_us[g_power.mode] += now_us - g_power.mode_since_us;
+    g_power.mode_since_us = now_us;
+    g_power.mode = mode;
+    g_power.transitions++;
+}
+
+static bool valid_lock(system_power_lock_t lock)
+{
+    return lock >= &g_power.locks[0] && lock < &g_power.locks[g_power.lock_count];
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t system_power_lock_create(system_power_lock_type_t type, const char *name,
+                                   system_power_lock_t *out_lock)
+{
+    if (type >= SYSTEM_POWER_LOCK_TYPE_COUNT || name == NULL || out_lock == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_pm_lock_handle_t pm_lock = NULL;
+#if CONFIG_PM_ENABLE
+    static const esp_pm_lock_type_t pm_types[SYSTEM_POWER_LOCK_TYPE_COUNT] = {
+        [SYSTEM_POWER_LOCK_CPU_MAX] = ESP_PM_CPU_FREQ_MAX,
+        [SYSTEM_POWER_LOCK_APB_MAX] = ESP_PM_APB_FREQ_MAX,
+        [SYSTEM_POWER_LOCK_NO_SLEEP] = ESP_PM_NO_LIGHT_SLEEP,
+    };
+    esp_err_t ret = esp_pm_lock_create(pm_types[type], 0, name, &pm_lock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create lock '%s': %s", name, esp_err_to_name(ret));
+        return ret;
+    }
+#endif
+    
+    struct system_power_lock *lock = NULL;
+    portENTER_CRITICAL(&g_power_lock);
+    if (g_power.lock_count < MAX_POWER_LOCKS) {
+        lock = &g_power.locks[g_power.lock_count];
+        strncpy(lock->name, name, SYSTEM_POWER_LOCK_NAME_LEN - 1);
+        lock->name[SYSTEM_POWER_LOCK_NAME_LEN - 1] = '\0';
+        lock->type = type;
+        lock->pm_lock = pm_lock;
+        g_power.lock_count++;
+    }
+    portEXIT_CRITICAL(&g_power_lock);
+    
+    if (lock == NULL) {
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_delete(pm_lock);
+#endif
+        ESP_LOGE(TAG, "No room for lock '%s' (max %d)", name, MAX_POWER_LOCKS);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    *out_lock = lock;
+    return ESP_OK;
+}
+
+esp_err_t system_power_lock_acquire(system_power_lock_t lock)
+{
+    if (!valid_lock(lock)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Clocks first, so the holder never runs below what it asked for
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(lock->pm_lock);
+#endif
+    
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&g_power_lock);
+    if (lock->holders++ == 0) {
+        lock->acquisitions++;
+        lock->held_since_us = now_us;
+        g_power.type_holders[lock->type]++;
+        account_mode(now_us);
+    }
+    portEXIT_CRITICAL(&g_power_lock);
+    
+    return ESP_OK;
+}
+
+esp_err_t system_power_lock_release(system_power_lock_t lock)
+{
+    if (!valid_lock(lock)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    bool held;
+    
+    portENTER_CRITICAL(&g_power_lock);
+    held = lock->holders > 0;
+    if (held && --lock->holders == 0) {
+        lock->held_us += now_us - lock->held_since_us;
+        g_power.type_holders[lock->type]--;
+        account_mode(now_us);
+    }
+    portEXIT_CRITICAL(&g_power_lock);
+    
+    if (!held) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(lock->pm_lock);
+#endif
+    return ESP_OK;
+}
+
+esp_err_t system_power_get_residency(system_power_residency_t *out_residency)
+{
+    if (out_residency == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    
+    portENTER_CRITICAL(&g_power_lock);
+    for (int i = 0; i < SYSTEM_POWER_MODE_COUNT; i++) {
+        out_residency->time_us[i] = g_power.mode_us[i];
+    }
+    out_residency->time_us[g_power.mode] += now_us - g_power.mode_since_us;
+    out_residency->mode = g_power.mode;
+    out_residency->transitions = g_power.transitions;
+    portEXIT_CRITICAL(&g_power_lock);
+    
+    return ESP_OK;
+}
+
+esp_err_t system_power_get_locks(system_power_lock_info_t *out_info, size_t max_count,
+                                 size_t *out_count)
+{
+    if (out_info == NULL || out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int64_t now_us = esp_timer_get_time();
+    size_t count = 0;
+    
+    portENTER_CRITICAL(&g_power_lock);
+    for (; count < g_power.lock_count && count < max_count; count++) {
+        const struct system_power_lock *lock = &g_power.locks[count];
+        system_power_lock_info_t *info = &out_info[count];
+        memcpy(info->name, lock->name, sizeof(info->name));
+        info->type = lock->type;
+        info->holders = lock->holders;
+        info->acquisitions = lock->acquisitions;
+        info->held_us = lock->held_us;
+        if (lock->holders > 0) {
+            info->held_us += now_us - lock->held_since_us;
+        }
+    }
+    portEXIT_CRITICAL(&g_power_lock);
+    
+    *out_count = count;
+    return ESP_OK;
+}
+
+const char *system_power_mode_name(system_power_mode_t mode)
+{
+    return (mode < SYSTEM_POWER_MODE_COUNT) ? mode_names[mode] : "unknown";
+}
@@ -5,7 +5,10 @@
 
 #include "priority_queue.h"
 #include "memory_pool.h"
+#include "event_credit.h"
+#include "system_service/static_alloc.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
@@ -19,9 +22,16 @@ static const char *TAG = "priority_queue";
 
 struct priority_queue {
     QueueHandle_t queues[4];        /**< Queues for each priority level */
+    SemaphoreHandle_t items;        /**< Counts queued events, wakes the receiver */
+    volatile bool kicked;           /**< Receiver woken from ISR without an event */
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    SemaphoreHandle_t critical_items; /**< Counts CRITICAL events, wakes their dispatcher */
+    volatile bool critical_kicked;  /**< Critical dispatcher woken without an event */
+#endif
     SemaphoreHandle_t mutex;        /**< Mutex for statistics */
     event_queue_stats_t stats;      /**< Queue statistics */
     uint32_t sequence_counter;      /**< Event sequence counter */
+    priority_queue_drop_cb_t on_drop; /**< Owner's hook for dropped events */
 };
 
 /* Queue sizes from config */
@@ -29,9 +39,79 @@ static const uint32_t queue_sizes[] = {
     [SYSTEM_EVENT_PRIORITY_LOW] = CONFIG_SYSTEM_SERVICE_LOW_PRIORITY_QUEUE_SIZE,
     [SYSTEM_EVENT_PRIORITY_NORMAL] = CONFIG_SYSTEM_SERVICE_NORMAL_PRIORITY_QUEUE_SIZE,
     [SYSTEM_EVENT_PRIORITY_HIGH] = CONFIG_SYSTEM_SERVICE_HIGH_PRIORITY_QUEUE_SIZE,
-    [SYSTEM_EVENT_PRIORITY_CRITICAL] = CONFIG_SYSTEM_SERVICE_HIGH_PRIORITY_QUEUE_SIZE,
+    [SYSTEM_EVENT_PRIORITY_CRITICAL] = CONFIG_SYSTEM_SERVICE_CRITICAL_PRIORITY_QUEUE_SIZE,
 };
 
+/* Slots counted by the shared semaphore; CRITICAL has its own with the lane */
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+#define PQ_TOTAL_SLOTS (CONFIG_SYSTEM_SERVICE_LOW_PRIORITY_QUEUE_SIZE + \
+                        CONFIG_SYSTEM_SERVICE_NORMAL_PRIORITY_QUEUE_SIZE + \
+                        CONFIG_SYSTEM_SERVICE_HIGH_PRIORITY_QUEUE_SIZE)
+#else
+#define PQ_TOTAL_SLOTS (CONFIG_SYSTEM_SERVICE_LOW_PRIORITY_QUEUE_SIZE + \
+                        CONFIG_SYSTEM_SERVICE_NORMAL_PRIORITY_QUEUE_SIZE + \
+                        CONFIG_SYSTEM_SERVICE_HIGH_PRIORITY_QUEUE_SIZE + \
+                        CONFIG_SYSTEM_SERVICE_CRITICAL_PRIORITY_QUEUE_SIZE)
+#endif
+
+/* ============================================================================
+ * Storage
+ * ============================================================================ */
+
+SYSTEM_MUTEX_DEFINE(s_pq_mutex);
+SYSTEM_SEMAPHORE_DEFINE(s_pq_items);
+SYSTEM_QUEUE_DEFINE(s_pq_low, CONFIG_SYSTEM_SERVICE_LOW_PRIORITY_QUEUE_SIZE, sizeof(system_event_t));
+SYSTEM_QUEUE_DEFINE(s_pq_normal, CONFIG_SYSTEM_SERVICE_NORMAL_PRIORITY_QUEUE_SIZE, sizeof(system_event_t));
+SYSTEM_QUEUE_DEFINE(s_pq_high, CONFIG_SYSTEM_SERVICE_HIGH_PRIORITY_QUEUE_SIZE, sizeof(system_event_t));
+SYSTEM_QUEUE_DEFINE(s_pq_critical, CONFIG_SYSTEM_SERVICE_CRITICAL_PRIORITY_QUEUE_SIZE, sizeof(system_event_t));
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+SYSTEM_SEMAPHORE_DEFINE(s_pq_critical_sem);
+#endif
+
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+/* The system service creates a single queue; statically it has one slot */
+static struct priority_queue g_static_pq;
+static bool g_static_pq_in_use = false;
+#endif
+
+static struct priority_queue* pq_alloc(void)
+{
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+    if (g_static_pq_in_use) {
+        return NULL;
+    }
+    g_static_pq_in_use = true;
+    memset(&g_static_pq, 0, sizeof(g_static_pq));
+    return &g_static_pq;
+#else
+    return calloc(1, sizeof(struct priority_queue));
+#endif
+}
+
+static void pq_free(struct priority_queue *pq)
+{
+#ifdef CONFIG_SYSTEM_SERVICE_STATIC_ALLOCATION
+    (void)pq;
+    g_static_pq_in_use = false;
+#else
+    free(pq);
+#endif
+}
+
+static QueueHandle_t pq_create_level(system_event_priority_t level)
+{
+    switch (level) {
+        case SYSTEM_EVENT_PRIORITY_LOW:
+            return SYSTEM_QUEUE_CREATE(s_pq_low, queue_sizes[level], sizeof(system_event_t));
+        case SYSTEM_EVENT_PRIORITY_NORMAL:
+            return SYSTEM_QUEUE_CREATE(s_pq_normal, queue_sizes[level], sizeof(system_event_t));
+        case SYSTEM_EVENT_PRIORITY_HIGH:
+            return SYSTEM_QUEUE_CREATE(s_pq_high, queue_sizes[level], sizeof(system_event_t));
+        default:
+            return SYSTEM_QUEUE_CREATE(s_pq_critical, queue_sizes[level], sizeof(system_event_t));
+    }
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -43,23 +123,43 @@ esp_err_t priority_queue_create(priority_queue_handle_t *handle)
     }
     
     // Allocate queue structure
-    struct priority_queue *pq = calloc(1, sizeof(struct priority_queue));
+    struct priority_queue *pq = pq_alloc();
     if (pq == NULL) {
         ESP_LOGE(TAG, "Failed to allocate priority queue");
         return ESP_ERR_NO_MEM;
     }
     
     // Create mutex
-    pq->mutex = xSemaphoreCreateMutex();
+    pq->mutex = SYSTEM_MUTEX_CREATE(s_pq_mutex);
     if (pq->mutex == NULL) {
-        free(pq);
+        pq_free(pq);
         return ESP_ERR_NO_MEM;
     }
     
+    // Counting semaphore covering every slot of every level, so the
+    // receiver blocks on one object instead of polling four queues
+    pq->items = SYSTEM_COUNTING_CREATE(s_pq_items, PQ_TOTAL_SLOTS, 0);
+    if (pq->items == NULL) {
+        vSemaphoreDelete(pq->mutex);
+        pq_free(pq);
+        return ESP_ERR_NO_MEM;
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    pq->critical_items = SYSTEM_COUNTING_CREATE(s_pq_critical_sem,
+                                                CONFIG_SYSTEM_SERVICE_CRITICAL_PRIORITY_QUEUE_SIZE, 0);
+    if (pq->critical_items == NULL) {
+        vSemaphoreDelete(pq->items);
+        vSemaphoreDelete(pq->mutex);
+        pq_free(pq);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    
     // Create queues for each priority level
     bool success = true;
     for (int i = 0; i < 4; i++) {
-        pq->queues[i] = xQueueCreate(queue_sizes[i], sizeof(system_event_t));
+        pq->queues[i] = pq_create_level((system_event_priority_t)i);
         if (pq->queues[i] == NULL) {
             ESP_LOGE(TAG, "Failed to create queue for priority %d", i);
             success = false;
@@ -74,8 +174,12 @@ esp_err_t priority_queue_create(priority_queue_handle_t *handle)
                 vQueueDelete(pq->queues[i]);
             }
         }
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+        vSemaphoreDelete(pq->critical_items);
+#endif
+        vSemaphoreDelete(pq->items);
         vSemaphoreDelete(pq->mutex);
-        free(pq);
+        pq_free(pq);
         return ESP_ERR_NO_MEM;
     }
     
@@ -85,7 +189,8 @@ esp_err_t priority_queue_create(priority_queue_handle_t *handle)
     
     *handle = pq;
     
-    ESP_LOGI(TAG, "Priority queue created (HIGH=%lu, NORMAL=%lu, LOW=%lu)",
+    ESP_LOGI(TAG, "Priority queue created (CRITICAL=%lu, HIGH=%lu, NORMAL=%lu, LOW=%lu)",
+             queue_sizes[SYSTEM_EVENT_PRIORITY_CRITICAL],
              queue_sizes[SYSTEM_EVENT_PRIORITY_HIGH],
              queue_sizes[SYSTEM_EVENT_PRIORITY_NORMAL],
              queue_sizes[SYSTEM_EVENT_PRIORITY_LOW]);
@@ -93,6 +198,14 @@ esp_err_t priority_queue_create(priority_queue_handle_t *handle)
     return ESP_OK;
 }
 
+void priority_queue_set_drop_callback(priority_queue_handle_t handle,
+                                      priority_queue_drop_cb_t callback)
+{
+    if (handle != NULL) {
+        ((struct priority_queue *)handle)->on_drop = callback;
+    }
+}
+
 esp_err_t priority_queue_destroy(priority_queue_handle_t handle)
 {
     if (handle == NULL) {
@@ -115,78 +228,196 @@ esp_err_t priority_queue_destroy(priority_queue_handle_t handle)
         }
     }
     
+    if (pq->items != NULL) {
+        vSemaphoreDelete(pq->items);
+    }
+    
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    if (pq->critical_items != NULL) {
+        vSemaphoreDelete(pq->critical_items);
+    }
+#endif
+    
     if (pq->mutex != NULL) {
         vSemaphoreDelete(pq->mutex);
     }
     
-    free(pq);
+    pq_free(pq);
     
     ESP_LOGI(TAG, "Priority queue destroyed");
     return ESP_OK;
 }
 
+/**
+ * @brief Handle a full queue for an event that failed to send
+ * 
+ * LOW priority events make room by dropping the oldest LOW event.
+ * 
+ * @return true if the event was queued after all
+ */
+static bool handle_overflow(struct priority_queue *pq, const system_event_t *event_copy)
+{
+    bool queued = false;
+    bool has_dropped = false;
+    system_event_t dropped;
+    
+    if (xSemaphoreTake(pq->mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return false;
+    }
+    
+    switch (event_copy->priority) {
+        case SYSTEM_EVENT_PRIORITY_HIGH:
+        case SYSTEM_EVENT_PRIORITY_CRITICAL:
+            pq->stats.high_priority_overflows++;
+            break;
+        case SYSTEM_EVENT_PRIORITY_NORMAL:
+            pq->stats.normal_priority_overflows++;
+            break;
+        case SYSTEM_EVENT_PRIORITY_LOW:
+            pq->stats.low_priority_overflows++;
+            // Try to drop oldest low priority event
+            if (xQueueReceive(pq->queues[SYSTEM_EVENT_PRIORITY_LOW], &dropped, 0) == pdTRUE) {
+                // Retire the dropped event's token. If the receiver
+                // already claimed it, it just rescans and waits again.
+                xSemaphoreTake(pq->items, 0);
+                has_dropped = true;
+                pq->stats.low_priority_drops++;
+                // Try posting again
+                if (xQueueSend(pq->queues[SYSTEM_EVENT_PRIORITY_LOW], event_copy, 0) == pdTRUE) {
+                    xSemaphoreGive(pq->items);
+                    ESP_LOGW(TAG, "Dropped low priority event to make room");
+                    queued = true;
+                }
+            }
+            break;
+    }
+    
+    xSemaphoreGive(pq->mutex);
+    
+    // Outside the mutex, the drop and drain callbacks may post again
+    if (has_dropped) {
+        priority_queue_drop_cb_t on_drop = pq->on_drop;
+        if (on_drop != NULL) {
+            on_drop(&dropped);
+        } else if (dropped.data != NULL) {
+            memory_pool_free(dropped.data);
+        }
+        event_credit_release(dropped.sender_id, 1);
+    }
+    
+    return queued;
+}
+
+/* Semaphore that wakes the receiver of a level's events */
+static inline SemaphoreHandle_t level_items(struct priority_queue *pq, system_event_priority_t level)
+{
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    if (level == SYSTEM_EVENT_PRIORITY_CRITICAL) {
+        return pq->critical_items;
+    }
+#endif
+    return pq->items;
+}
+
+/**
+ * @brief Take the highest priority event without waiting
+ */
+static bool take_highest(struct priority_queue *pq, system_event_t *event)
+{
+    // CRITICAL/HIGH first, then NORMAL, then LOW; with the critical lane
+    // CRITICAL events have a receiver of their own
+    static const int priority_order[] = {
+#if !CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+        SYSTEM_EVENT_PRIORITY_CRITICAL,
+#endif
+        SYSTEM_EVENT_PRIORITY_HIGH,
+        SYSTEM_EVENT_PRIORITY_NORMAL,
+        SYSTEM_EVENT_PRIORITY_LOW
+    };
+    
+    for (size_t i = 0; i < sizeof(priority_order) / sizeof(priority_order[0]); i++) {
+        if (xQueueReceive(pq->queues[priority_order[i]], event, 0) == pdTRUE) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * @brief Account for received events and refresh queue depths
+ */
+static void record_received(struct priority_queue *pq, uint32_t count)
+{
+    if (xSemaphoreTake(pq->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        pq->stats.total_events_processed += count;
+    
+        // Update queue depths
+        pq->stats.high_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_HIGH]) +
+                                        uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_CRITICAL]);
+        pq->stats.normal_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_NORMAL]);
+        pq->stats.low_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_LOW]);
+    
+        xSemaphoreGive(pq->mutex);
+    }
+}
+
 esp_err_t priority_queue_post(priority_queue_handle_t handle,
                                const system_event_t *event,
                                uint32_t timeout_ms)
 {
-    if (handle == NULL || event == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    return priority_queue_post_batch(handle, event, 1, timeout_ms, NULL);
+}
+
+esp_err_t priority_queue_post_batch(priority_queue_handle_t handle,
+                                     const system_event_t *events,
+                                     size_t count,
+                                     uint32_t timeout_ms,
+                                     size_t *out_posted)
+{
+    if (out_posted != NULL) {
+        *out_posted = 0;
     }
     
-    if (event->priority >= 4) {
+    if (handle == NULL || events == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct priority_queue *pq = (struct priority_queue *)handle;
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].priority >= 4) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
     
-    // Copy event
-    system_event_t event_copy = *event;
+    struct priority_queue *pq = (struct priority_queue *)handle;
     
-    // Assign sequence number
+    // Reserve a run of sequence numbers for the whole batch
+    uint32_t sequence = 0;
     if (xSemaphoreTake(pq->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        event_copy.sequence_number = pq->sequence_counter++;
-        pq->stats.total_events_queued++;
+        sequence = pq->sequence_counter;
+        pq->sequence_counter += count;
+        pq->stats.total_events_queued += count;
         xSemaphoreGive(pq->mutex);
     }
     
-    // Post to appropriate queue
-    QueueHandle_t queue = pq->queues[event->priority];
-    BaseType_t ret = xQueueSend(queue, &event_copy, pdMS_TO_TICKS(timeout_ms));
-    
-    if (ret != pdTRUE) {
-        // Queue full - handle overflow
-        if (xSemaphoreTake(pq->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            switch (event->priority) {
-                case SYSTEM_EVENT_PRIORITY_HIGH:
-                case SYSTEM_EVENT_PRIORITY_CRITICAL:
-                    pq->stats.high_priority_overflows++;
-                    break;
-                case SYSTEM_EVENT_PRIORITY_NORMAL:
-                    pq->stats.normal_priority_overflows++;
-                    break;
-                case SYSTEM_EVENT_PRIORITY_LOW:
-                    pq->stats.low_priority_overflows++;
-                    // Try to drop oldest low priority event
-                    system_event_t dropped;
-                    if (xQueueReceive(pq->queues[SYSTEM_EVENT_PRIORITY_LOW], &dropped, 0) == pdTRUE) {
-                        if (dropped.data != NULL) {
-                            memory_pool_free(dropped.data);
-                        }
-                        pq->stats.low_priority_drops++;
-                        // Try posting again
-                        if (xQueueSend(queue, &event_copy, 0) == pdTRUE) {
-                            xSemaphoreGive(pq->mutex);
-                            ESP_LOGW(TAG, "Dropped low priority event to make room");
-                            return ESP_OK;
-                        }
-                    }
-                    break;
-            }
-            xSemaphoreGive(pq->mutex);
+    for (size_t i = 0; i < count; i++) {
+        // Copy event
+        system_event_t event_copy = events[i];
+        event_copy.sequence_number = sequence + i;
+    
+        // Post to appropriate queue
+        QueueHandle_t queue = pq->queues[event_copy.priority];
+        if (xQueueSend(queue, &event_copy, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {
+            // Wake the receiver
+            xSemaphoreGive(level_items(pq, event_copy.priority));
+        } else if (!handle_overflow(pq, &event_copy)) {
+            ESP_LOGW(TAG, "Queue full for priority %d", event_copy.priority);
+            return ESP_ERR_TIMEOUT;
+        }
+    
+        if (out_posted != NULL) {
+            (*out_posted)++;
         }
-        
-        ESP_LOGW(TAG, "Queue full for priority %d", event->priority);
-        return ESP_ERR_TIMEOUT;
     }
     
     return ESP_OK;
@@ -196,56 +427,134 @@ esp_err_t priority_queue_receive(priority_queue_handle_t handle,
                                   system_event_t *event,
                                   uint32_t timeout_ms)
 {
-    if (handle == NULL || event == NULL) {
+    size_t received = 0;
+    return priority_queue_receive_batch(handle, event, 1, &received, timeout_ms);
+}
+
+esp_err_t priority_queue_receive_batch(priority_queue_handle_t handle,
+                                        system_event_t *events,
+                                        size_t max_events,
+                                        size_t *out_count,
+                                        uint32_t timeout_ms)
+{
+    if (handle == NULL || events == NULL || out_count == NULL || max_events == 0) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    struct priority_queue *pq = (struct priority_queue *)handle;
+    *out_count = 0;
     
-    // Try to receive from queues in priority order
-    // CRITICAL/HIGH first, then NORMAL, then LOW
-    const int priority_order[] = {
-        SYSTEM_EVENT_PRIORITY_CRITICAL,
-        SYSTEM_EVENT_PRIORITY_HIGH,
-        SYSTEM_EVENT_PRIORITY_NORMAL,
-        SYSTEM_EVENT_PRIORITY_LOW
-    };
+    struct priority_queue *pq = (struct priority_queue *)handle;
     
     TickType_t start_ticks = xTaskGetTickCount();
-    TickType_t timeout_ticks = pdMS_TO_TICKS(timeout_ms);
+    TickType_t timeout_ticks = (timeout_ms == portMAX_DELAY) ?
+                               portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    TickType_t wait_ticks = timeout_ticks;
     
     while (1) {
-        // Try each queue in priority order
-        for (int i = 0; i < 4; i++) {
-            int priority = priority_order[i];
-            if (xQueueReceive(pq->queues[priority], event, 0) == pdTRUE) {
-                // Update statistics
-                if (xSemaphoreTake(pq->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                    pq->stats.total_events_processed++;
-                    
-                    // Update queue depths
-                    pq->stats.high_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_HIGH]) +
-                                                    uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_CRITICAL]);
-                    pq->stats.normal_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_NORMAL]);
-                    pq->stats.low_priority_depth = uxQueueMessagesWaiting(pq->queues[SYSTEM_EVENT_PRIORITY_LOW]);
-                    
-                    xSemaphoreGive(pq->mutex);
-                }
-                
-                return ESP_OK;
+        // Sleep until a post hands out a token - no polling while idle
+        if (xSemaphoreTake(pq->items, wait_ticks) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    
+        if (take_highest(pq, &events[0])) {
+            break;
+        }
+    
+        // Woken from ISR so the caller can drain its side channel
+        if (pq->kicked) {
+            pq->kicked = false;
+            return ESP_ERR_NOT_FOUND;
+        }
+    
+        // Stale token (its LOW event was dropped on overflow) - wait out
+        // whatever remains of the timeout
+        if (timeout_ticks != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start_ticks;
+            if (elapsed >= timeout_ticks) {
+                return ESP_ERR_TIMEOUT;
             }
+            wait_ticks = timeout_ticks - elapsed;
         }
-        
-        // Check timeout
-        TickType_t elapsed = xTaskGetTickCount() - start_ticks;
-        if (elapsed >= timeout_ticks) {
-            return ESP_ERR_TIMEOUT;
+    }
+    
+    // Collect whatever else is already queued, without blocking
+    size_t count = 1;
+    while (count < max_events && xSemaphoreTake(pq->items, 0) == pdTRUE) {
+        if (take_highest(pq, &events[count])) {
+            count++;
         }
-        
-        // Wait a bit before trying again
-        vTaskDelay(1);
     }
+    
+    record_received(pq, count);
+    *out_count = count;
+    
+    return ESP_OK;
+}
+
+void IRAM_ATTR priority_queue_wake_from_isr(priority_queue_handle_t handle,
+                                           BaseType_t *higher_priority_task_woken)
+{
+    if (handle == NULL) {
+        return;
+    }
+    
+    struct priority_queue *pq = (struct priority_queue *)handle;
+    
+    pq->kicked = true;
+    xSemaphoreGiveFromISR(pq->items, higher_priority_task_woken);
+}
+
+void priority_queue_wake(priority_queue_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+    
+    struct priority_queue *pq = (struct priority_queue *)handle;
+    
+    pq->kicked = true;
+    xSemaphoreGive(pq->items);
+}
+
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+esp_err_t priority_queue_receive_critical(priority_queue_handle_t handle,
+                                          system_event_t *event,
+                                          uint32_t timeout_ms)
+{
+    if (handle == NULL || event == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    struct priority_queue *pq = (struct priority_queue *)handle;
+    TickType_t timeout_ticks = (timeout_ms == portMAX_DELAY) ?
+                               portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    
+    // CRITICAL events are never dropped, so every token has its event
+    if (xSemaphoreTake(pq->critical_items, timeout_ticks) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    if (xQueueReceive(pq->queues[SYSTEM_EVENT_PRIORITY_CRITICAL], event, 0) != pdTRUE) {
+        pq->critical_kicked = false;
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    record_received(pq, 1);
+    return ESP_OK;
+}
+
+void priority_queue_wake_critical(priority_queue_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+    
+    struct priority_queue *pq = (struct priority_queue *)handle;
+    
+    pq->critical_kicked = true;
+    xSemaphoreGive(pq->critical_items);
 }
+#endif // CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
 
 esp_err_t priority_queue_get_stats(priority_queue_handle_t handle,
                                     event_queue_stats_t *stats)
@@ -1,13 +1,27 @@
 /**
  * @file request_response.c
  * @brief Request/response event pattern implementation
+ * 
+ * Request IDs carry their slot: the low 16 bits are slot index + 1 and the
+ * high 16 bits a per-slot generation, so lookup is a single index and a
+ * stale ID never matches a reused slot. Slots move
+ * FREE -> PENDING -> RESPONDING -> DONE under a spinlock; the response is
+ * copied outside it while the slot is RESPONDING, which keeps a timing-out
+ * caller from leaving while its buffer is being written.
+ * 
+ * Futures and async requests keep their deadline in one hashed timer
+ * wheel. A single task advances it, and only while something is armed.
  */
 
 #include "request_response.h"
+#include "handler_monitor.h"
+#include "memory_pool.h"
+#include "service_activation.h"
+#include "system_service/static_alloc.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
-#include "freertos/event_groups.h"
+#include "freertos/task.h"
 #include "system_service/event_bus.h"
 #include <string.h>
 
@@ -17,82 +31,557 @@ static const char *TAG = "request_response";
  * Request Tracking
  * ============================================================================ */
 
-#define MAX_PENDING_REQUESTS 16
+#define MAX_PENDING_REQUESTS    CONFIG_SYSTEM_SERVICE_MAX_PENDING_REQUESTS
+
+#define REQUEST_SLOT_BITS       16
+#define REQUEST_SLOT_MASK       ((1u << REQUEST_SLOT_BITS) - 1)
+#define REQUEST_ID_MAKE(gen, slot) \
+    (((uint32_t)(gen) << REQUEST_SLOT_BITS) | ((uint32_t)(slot) + 1))
+#define REQUEST_ID_SLOT(id)     (((id) & REQUEST_SLOT_MASK) - 1)
+
+_Static_assert(MAX_PENDING_REQUESTS < REQUEST_SLOT_MASK, "request slot index must fit 16 bits");
+
+typedef enum {
+    REQUEST_SLOT_FREE = 0,
+    REQUEST_SLOT_PENDING,               /**< Posted, waiting for a response */
+    REQUEST_SLOT_RESPONDING,            /**< Responder is copying the response */
+    REQUEST_SLOT_DONE,                  /**< Completed, status holds the result */
+} request_slot_state_t;
+
+typedef enum {
+    REQUEST_KIND_SYNC = 0,              /**< Caller blocked in request_send_sync() */
+    REQUEST_KIND_FUTURE,                /**< Held by a request_future_t */
+} request_kind_t;
 
 typedef struct {
-    bool active;
-    request_id_t request_id;
+    request_id_t request_id;            /**< Current ID, REQUEST_ID_INVALID if free */
+    uint16_t generation;                /**< Bumped on every release */
+    uint16_t next_free;                 /**< Free list link (slot index + 1) */
+    uint8_t state;                      /**< request_slot_state_t */
+    uint8_t kind;                       /**< request_kind_t */
+    bool armed;                         /**< Linked into the timer wheel */
+    esp_err_t status;                   /**< Result once DONE */
     system_service_id_t requester;
-    SemaphoreHandle_t response_sem;
-    void *response_data;
+    TaskHandle_t waiter;                /**< Task blocked on this request */
+    void *response_data;                /**< Caller buffer (sync) or pool copy (future) */
     size_t response_size;
     size_t response_buffer_size;
-    response_callback_t callback;
+    response_callback_t callback;       /**< Continuation, releases the slot */
     void *user_data;
+    
+    // Timer wheel linkage
+    uint32_t deadline;                  /**< Expiry in wheel ticks */
+    uint16_t wheel_next;                /**< Slot index + 1, 0 = end */
+    uint16_t wheel_prev;                /**< Slot index + 1, 0 = bucket head */
 } pending_request_t;
 
+/** Direct handler, indexed by request type */
+typedef struct {
+    request_handler_t handler;
+    void *user_data;
+    system_service_id_t service_id;
+} direct_handler_t;
+
+/* ============================================================================
+ * Timer Wheel
+ * ============================================================================ */
+
+#define WHEEL_BUCKETS           64
+#define WHEEL_TICK_MS           CONFIG_SYSTEM_SERVICE_REQUEST_TIMER_RESOLUTION_MS
+#define WHEEL_TASK_STACK_SIZE   3072
+#define WHEEL_TASK_PRIORITY     (CONFIG_SYSTEM_SERVICE_EVENT_TASK_PRIORITY - 1)
+
+typedef struct {
+    uint16_t buckets[WHEEL_BUCKETS];    /**< Slot index + 1 of each bucket head */
+    uint32_t armed_count;               /**< Slots linked into the wheel */
+    uint32_t last_tick;                 /**< Last tick processed */
+    TaskHandle_t task;                  /**< Wheel task, created on first use */
+    bool task_starting;
+} request_wheel_t;
+
 /* ============================================================================
  * Global State
  * ============================================================================ */
 
 static pending_request_t g_pending_requests[MAX_PENDING_REQUESTS] = {0};
-static SemaphoreHandle_t g_requests_mutex = NULL;
-static uint32_t g_next_request_id = 1;
+static portMUX_TYPE g_requests_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t g_free_head = 0;        /**< Slot index + 1, 0 = none */
+static bool g_slots_ready = false;
+static direct_handler_t g_direct_handlers[SYSTEM_SERVICE_MAX_EVENT_TYPES] = {0};
+static request_wheel_t g_wheel = {0};
+
+SYSTEM_TASK_DEFINE(s_wheel_task, WHEEL_TASK_STACK_SIZE);
 
 /* ============================================================================
  * Internal Helpers
  * ============================================================================ */
 
-static void ensure_mutex(void)
+static inline uint32_t wheel_now(void)
+{
+    return (uint32_t)(xTaskGetTickCount() / pdMS_TO_TICKS(WHEEL_TICK_MS));
+}
+
+/**
+ * @brief Link every slot into the free list on first use (lock held)
+ */
+static void ensure_slots_locked(void)
 {
-    if (g_requests_mutex == NULL) {
-        g_requests_mutex = xSemaphoreCreateMutex();
+    if (g_slots_ready) {
+        return;
+    }
+    
+    for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
+        g_pending_requests[i].next_free = (i + 1 < MAX_PENDING_REQUESTS) ? i + 2 : 0;
     }
+    g_free_head = 1;
+    g_slots_ready = true;
 }
 
-static request_id_t allocate_request_id(void)
+/**
+ * @brief Take a free slot and give it a fresh ID (lock held)
+ */
+static pending_request_t* allocate_slot_locked(request_kind_t kind)
 {
-    ensure_mutex();
+    ensure_slots_locked();
     
-    if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return REQUEST_ID_INVALID;
+    if (g_free_head == 0) {
+        return NULL;
     }
     
-    request_id_t id = g_next_request_id++;
-    if (g_next_request_id == REQUEST_ID_INVALID) {
-        g_next_request_id = 1;
+    uint32_t index = g_free_head - 1;
+    pending_request_t *req = &g_pending_requests[index];
+    g_free_head = req->next_free;
+    
+    req->request_id = REQUEST_ID_MAKE(req->generation, index);
+    req->state = REQUEST_SLOT_PENDING;
+    req->kind = kind;
+    req->status = ESP_ERR_NOT_FINISHED;
+    req->response_size = 0;
+    return req;
+}
+
+/**
+ * @brief Unlink a slot from its wheel bucket (lock held)
+ */
+static void wheel_remove_locked(pending_request_t *req)
+{
+    if (!req->armed) {
+        return;
     }
     
-    xSemaphoreGive(g_requests_mutex);
-    return id;
+    if (req->wheel_prev != 0) {
+        g_pending_requests[req->wheel_prev - 1].wheel_next = req->wheel_next;
+    } else {
+        g_wheel.buckets[req->deadline % WHEEL_BUCKETS] = req->wheel_next;
+    }
+    if (req->wheel_next != 0) {
+        g_pending_requests[req->wheel_next - 1].wheel_prev = req->wheel_prev;
+    }
+    
+    req->armed = false;
+    req->wheel_next = 0;
+    req->wheel_prev = 0;
+    g_wheel.armed_count--;
 }
 
-static pending_request_t* find_request(request_id_t request_id)
+/**
+ * @brief Arm a slot's deadline (lock held)
+ * 
+ * @return true if the wheel was idle and its task must be woken
+ */
+static bool wheel_insert_locked(pending_request_t *req, uint32_t timeout_ms)
 {
-    for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
-        if (g_pending_requests[i].active && 
-            g_pending_requests[i].request_id == request_id) {
-            return &g_pending_requests[i];
+    uint32_t index = (uint32_t)(req - g_pending_requests);
+    uint32_t ticks = (timeout_ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+    uint32_t now = wheel_now();
+    
+    bool was_idle = (g_wheel.armed_count == 0);
+    if (was_idle) {
+        g_wheel.last_tick = now;
+    }
+    
+    // Never in the bucket being processed now, so at least one tick out
+    req->deadline = now + (ticks > 0 ? ticks : 1);
+    
+    uint16_t *head = &g_wheel.buckets[req->deadline % WHEEL_BUCKETS];
+    req->wheel_prev = 0;
+    req->wheel_next = *head;
+    if (*head != 0) {
+        g_pending_requests[*head - 1].wheel_prev = (uint16_t)(index + 1);
+    }
+    *head = (uint16_t)(index + 1);
+    req->armed = true;
+    g_wheel.armed_count++;
+    
+    return was_idle;
+}
+
+/**
+ * @brief Return a slot to the free list (lock held)
+ * 
+ * A future's stored response is not freed here; callers take it first
+ * and free it once the lock is dropped.
+ */
+static void release_slot_locked(pending_request_t *req)
+{
+    uint32_t index = (uint32_t)(req - g_pending_requests);
+    
+    wheel_remove_locked(req);
+    
+    req->request_id = REQUEST_ID_INVALID;
+    req->generation++;
+    req->state = REQUEST_SLOT_FREE;
+    req->waiter = NULL;
+    req->callback = NULL;
+    req->user_data = NULL;
+    req->response_data = NULL;
+    req->next_free = g_free_head;
+    g_free_head = (uint16_t)(index + 1);
+}
+
+/**
+ * @brief O(1) lookup by ID (lock held)
+ */
+static pending_request_t* find_request_locked(request_id_t request_id)
+{
+    uint32_t index = REQUEST_ID_SLOT(request_id);
+    if (request_id == REQUEST_ID_INVALID || index >= MAX_PENDING_REQUESTS) {
+        return NULL;
+    }
+    
+    pending_request_t *req = &g_pending_requests[index];
+    return (req->request_id == request_id) ? req : NULL;
+}
+
+/**
+ * @brief Look up a future that has no continuation attached (lock held)
+ */
+static pending_request_t* find_future_locked(request_future_t future)
+{
+    pending_request_t *req = find_request_locked(future);
+    if (req == NULL || req->kind != REQUEST_KIND_FUTURE || req->callback != NULL) {
+        return NULL;
+    }
+    return req;
+}
+
+/**
+ * @brief Post the request event with its correlation header in front
+ */
+static esp_err_t post_request(system_service_id_t requester,
+                              system_service_id_t target_service,
+                              system_event_type_t request_type,
+                              request_id_t request_id,
+                              const void *request_data,
+                              size_t request_size)
+{
+    if (request_data == NULL && request_size > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t total = sizeof(request_header_t) + request_size;
+    void *buffer;
+    esp_err_t ret = system_event_loan(total, &buffer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    request_header_t *header = buffer;
+    header->magic = REQUEST_HEADER_MAGIC;
+    header->request_id = request_id;
+    header->requester = requester;
+    header->target = target_service;
+    header->reserved = 0;
+    if (request_size > 0) {
+        memcpy(header + 1, request_data, request_size);
+    }
+    
+    return system_event_post_loaned(requester, request_type, buffer, total,
+                                    SYSTEM_EVENT_PRIORITY_HIGH);
+}
+
+/**
+ * @brief Run a registered direct handler on the caller's stack
+ * 
+ * @return true if a handler ran (result in out_ret)
+ */
+static bool try_direct_invoke(system_service_id_t requester,
+                              system_service_id_t target_service,
+                              system_event_type_t request_type,
+                              const void *request_data,
+                              size_t request_size,
+                              void *response_data,
+                              size_t *response_size,
+                              uint32_t timeout_ms,
+                              esp_err_t *out_ret)
+{
+    if (request_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&g_requests_lock);
+    direct_handler_t entry = g_direct_handlers[request_type];
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    if (entry.handler == NULL || entry.service_id != target_service) {
+        return false;
+    }
+    
+    const request_header_t header = {
+        .magic = REQUEST_HEADER_MAGIC,
+        .request_id = REQUEST_ID_INVALID,
+        .requester = requester,
+        .target = target_service,
+    };
+    
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = entry.handler(&header, request_data, request_size,
+                                  response_data, response_size, entry.user_data);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+    
+    handler_monitor_record(target_service, request_type, elapsed_us);
+    if (elapsed_us / 1000 > timeout_ms) {
+        ESP_LOGW(TAG, "Direct request to service %d took %lu us (timeout %lu ms)",
+                 target_service, elapsed_us, timeout_ms);
+    }
+    
+    *out_ret = ret;
+    return true;
+}
+
+/* ============================================================================
+ * Timer Wheel Task
+ * ============================================================================ */
+
+/**
+ * @brief Expire everything due in one bucket
+ * 
+ * Continuations run without the lock, so the bucket is rescanned after
+ * each one.
+ */
+static void wheel_expire_bucket(uint32_t tick)
+{
+    while (true) {
+        portENTER_CRITICAL(&g_requests_lock);
+    
+        pending_request_t *req = NULL;
+        for (uint16_t link = g_wheel.buckets[tick % WHEEL_BUCKETS]; link != 0;
+             link = g_pending_requests[link - 1].wheel_next) {
+            pending_request_t *candidate = &g_pending_requests[link - 1];
+            // Later laps of the wheel share the bucket
+            if ((int32_t)(candidate->deadline - tick) <= 0 &&
+                candidate->state == REQUEST_SLOT_PENDING) {
+                req = candidate;
+                break;
+            }
+        }
+    
+        if (req == NULL) {
+            portEXIT_CRITICAL(&g_requests_lock);
+            return;
+        }
+    
+        request_id_t request_id = req->request_id;
+        response_callback_t callback = req->callback;
+        void *user_data = req->user_data;
+        TaskHandle_t waiter = req->waiter;
+    
+        if (callback != NULL) {
+            release_slot_locked(req);
+        } else {
+            wheel_remove_locked(req);
+            req->state = REQUEST_SLOT_DONE;
+            req->status = ESP_ERR_TIMEOUT;
+        }
+    
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        ESP_LOGW(TAG, "Request %lu timed out", request_id);
+    
+        if (callback != NULL) {
+            callback(request_id, ESP_ERR_TIMEOUT, NULL, 0, user_data);
+        } else if (waiter != NULL) {
+            xTaskNotifyGive(waiter);
         }
     }
-    return NULL;
 }
 
-static pending_request_t* allocate_request_slot(void)
+static void wheel_task(void *arg)
 {
-    for (int i = 0; i < MAX_PENDING_REQUESTS; i++) {
-        if (!g_pending_requests[i].active) {
-            return &g_pending_requests[i];
+    while (true) {
+        portENTER_CRITICAL(&g_requests_lock);
+        bool idle = (g_wheel.armed_count == 0);
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        // Sleeps without ticking until a deadline is armed
+        if (idle) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+    
+        vTaskDelay(pdMS_TO_TICKS(WHEEL_TICK_MS));
+    
+        // Catch up on every tick missed since the last pass
+        uint32_t now = wheel_now();
+        portENTER_CRITICAL(&g_requests_lock);
+        uint32_t tick = g_wheel.last_tick;
+        g_wheel.last_tick = now;
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        if (now - tick > WHEEL_BUCKETS) {
+            tick = now - WHEEL_BUCKETS;
+        }
+        while (tick != now) {
+            tick++;
+            wheel_expire_bucket(tick);
+        }
+    }
+}
+
+/**
+ * @brief Create the wheel task on first use
+ */
+static esp_err_t wheel_ensure_task(void)
+{
+    portENTER_CRITICAL(&g_requests_lock);
+    bool create = (g_wheel.task == NULL && !g_wheel.task_starting);
+    if (create) {
+        g_wheel.task_starting = true;
+    }
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    if (!create) {
+        return ESP_OK;
+    }
+    
+    TaskHandle_t task = NULL;
+    BaseType_t ret = SYSTEM_TASK_CREATE(s_wheel_task, wheel_task, "req_timeout",
+                                        WHEEL_TASK_STACK_SIZE, NULL,
+                                        WHEEL_TASK_PRIORITY, &task);
+    
+    portENTER_CRITICAL(&g_requests_lock);
+    g_wheel.task = (ret == pdPASS) ? task : NULL;
+    g_wheel.task_starting = false;
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create request timeout task");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Deadlines armed while the task was being created
+    xTaskNotifyGive(task);
+    return ESP_OK;
+}
+
+/**
+ * @brief Claim a future slot, arm its deadline and post the request
+ */
+static esp_err_t send_future(system_service_id_t requester,
+                             system_service_id_t target_service,
+                             system_event_type_t request_type,
+                             const void *request_data,
+                             size_t request_size,
+                             uint32_t timeout_ms,
+                             response_callback_t callback,
+                             void *user_data,
+                             request_id_t *out_request_id)
+{
+    esp_err_t ret = wheel_ensure_task();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    service_activation_on_request(target_service);
+    
+    portENTER_CRITICAL(&g_requests_lock);
+    pending_request_t *req = allocate_slot_locked(REQUEST_KIND_FUTURE);
+    bool wake = false;
+    request_id_t request_id = REQUEST_ID_INVALID;
+    if (req != NULL) {
+        req->requester = requester;
+        req->callback = callback;
+        req->user_data = user_data;
+        request_id = req->request_id;
+        wake = wheel_insert_locked(req, timeout_ms);
+    }
+    TaskHandle_t wheel = g_wheel.task;
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    if (req == NULL) {
+        ESP_LOGE(TAG, "No request slots available");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (wake && wheel != NULL) {
+        xTaskNotifyGive(wheel);
+    }
+    
+    // Publish the ID before a fast responder can complete the request
+    *out_request_id = request_id;
+    
+    ret = post_request(requester, target_service, request_type, request_id,
+                       request_data, request_size);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&g_requests_lock);
+        if (req->request_id == request_id) {
+            release_slot_locked(req);
+        }
+        portEXIT_CRITICAL(&g_requests_lock);
+        *out_request_id = REQUEST_ID_INVALID;
+        return ret;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Take a completed future's result and release its slot (lock held)
+ * 
+ * The stored response then belongs to the caller alone, so it is copied
+ * out by finish_future() once the lock is dropped.
+ */
+static esp_err_t collect_future_locked(pending_request_t *req,
+                                       void **out_stored,
+                                       size_t *out_stored_size)
+{
+    esp_err_t status = req->status;
+    
+    *out_stored = req->response_data;
+    *out_stored_size = req->response_size;
+    release_slot_locked(req);
+    return status;
+}
+
+/**
+ * @brief Copy a collected result to the caller and free it (lock not held)
+ */
+static esp_err_t finish_future(esp_err_t status,
+                               void *stored,
+                               size_t stored_size,
+                               void *response_data,
+                               size_t *response_size)
+{
+    if (status == ESP_OK && response_data != NULL && response_size != NULL) {
+        size_t copy_size = (stored_size < *response_size) ? stored_size : *response_size;
+        if (copy_size > 0) {
+            memcpy(response_data, stored, copy_size);
         }
+        *response_size = copy_size;
+    } else if (response_size != NULL) {
+        *response_size = 0;
     }
-    return NULL;
+    
+    memory_pool_free(stored);
+    return status;
 }
 
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
 
-esp_err_t request_send_sync(system_service_id_t target_service,
+esp_err_t request_send_sync(system_service_id_t requester,
+                             system_service_id_t target_service,
                              system_event_type_t request_type,
                              const void *request_data,
                              size_t request_size,
@@ -104,71 +593,88 @@ esp_err_t request_send_sync(system_service_id_t target_service,
         return ESP_ERR_INVALID_ARG;
     }
     
-    ensure_mutex();
+    // Keeps an on-demand target from going idle
+    service_activation_on_request(target_service);
     
-    // Allocate request ID
-    request_id_t request_id = allocate_request_id();
-    if (request_id == REQUEST_ID_INVALID) {
-        return ESP_ERR_NO_MEM;
+    esp_err_t direct_ret;
+    if (try_direct_invoke(requester, target_service, request_type, request_data, request_size,
+                          response_data, response_size, timeout_ms, &direct_ret)) {
+        return direct_ret;
     }
     
-    // Allocate request slot
-    if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
+    portENTER_CRITICAL(&g_requests_lock);
+    pending_request_t *req = allocate_slot_locked(REQUEST_KIND_SYNC);
+    if (req != NULL) {
+        req->requester = requester;
+        req->waiter = xTaskGetCurrentTaskHandle();
+        req->response_data = response_data;
+        req->response_buffer_size = *response_size;
     }
+    portEXIT_CRITICAL(&g_requests_lock);
     
-    pending_request_t *req = allocate_request_slot();
     if (req == NULL) {
-        xSemaphoreGive(g_requests_mutex);
         ESP_LOGE(TAG, "No request slots available");
         return ESP_ERR_NO_MEM;
     }
     
-    // Initialize request
-    req->active = true;
-    req->request_id = request_id;
-    req->requester = 0; // TODO: Get current service ID
-    req->response_sem = xSemaphoreCreateBinary();
-    req->response_data = response_data;
-    req->response_buffer_size = *response_size;
-    req->response_size = 0;
-    req->callback = NULL;
-    req->user_data = NULL;
-    
-    xSemaphoreGive(g_requests_mutex);
+    request_id_t request_id = req->request_id;
     
-    // Send request event (TODO: Embed request_id in event data)
-    esp_err_t ret = system_event_post(0, request_type, request_data, request_size,
-                                      SYSTEM_EVENT_PRIORITY_HIGH);
+    esp_err_t ret = post_request(requester, target_service, request_type, request_id,
+                                 request_data, request_size);
     if (ret != ESP_OK) {
-        vSemaphoreDelete(req->response_sem);
-        req->active = false;
+        portENTER_CRITICAL(&g_requests_lock);
+        if (req->request_id == request_id) {
+            release_slot_locked(req);
+        }
+        portEXIT_CRITICAL(&g_requests_lock);
         return ret;
     }
     
-    // Wait for response
-    if (xSemaphoreTake(req->response_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
-        vSemaphoreDelete(req->response_sem);
-        req->active = false;
-        ESP_LOGW(TAG, "Request %lu timed out", request_id);
-        return ESP_ERR_TIMEOUT;
-    }
+    // Wait for the responder's notification; anything else just rechecks
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    TickType_t wait = timeout;
     
-    // Copy response size
-    *response_size = req->response_size;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
     
-    // Cleanup
-    vSemaphoreDelete(req->response_sem);
-    req->active = false;
+        TickType_t elapsed = xTaskGetTickCount() - start;
     
-    ESP_LOGD(TAG, "Request %lu completed", request_id);
-    return ESP_OK;
+        portENTER_CRITICAL(&g_requests_lock);
+        if (req->request_id != request_id) {
+            // Cancelled and released by request_cancel()
+            portEXIT_CRITICAL(&g_requests_lock);
+            return ESP_ERR_INVALID_STATE;
+        }
+    
+        request_slot_state_t state = req->state;
+        if (state == REQUEST_SLOT_DONE) {
+            *response_size = req->response_size;
+            release_slot_locked(req);
+            portEXIT_CRITICAL(&g_requests_lock);
+            ESP_LOGD(TAG, "Request %lu completed", request_id);
+            return ESP_OK;
+        }
+    
+        if (state == REQUEST_SLOT_PENDING && elapsed >= timeout) {
+            release_slot_locked(req);
+            portEXIT_CRITICAL(&g_requests_lock);
+            ESP_LOGW(TAG, "Request %lu timed out", request_id);
+            return ESP_ERR_TIMEOUT;
+        }
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        // A response being copied is waited out, it writes our buffer
+        wait = (state == REQUEST_SLOT_RESPONDING) ? portMAX_DELAY : timeout - elapsed;
+    }
 }
 
-esp_err_t request_send_async(system_service_id_t target_service,
+esp_err_t request_send_async(system_service_id_t requester,
+                              system_service_id_t target_service,
                               system_event_type_t request_type,
                               const void *request_data,
                               size_t request_size,
+                              uint32_t timeout_ms,
                               response_callback_t callback,
                               void *user_data,
                               request_id_t *out_request_id)
@@ -177,47 +683,161 @@ esp_err_t request_send_async(system_service_id_t target_service,
         return ESP_ERR_INVALID_ARG;
     }
     
-    ensure_mutex();
+    request_id_t request_id;
+    esp_err_t ret = send_future(requester, target_service, request_type, request_data,
+                                request_size, timeout_ms, callback, user_data, &request_id);
     
-    // Allocate request ID
-    request_id_t request_id = allocate_request_id();
-    if (request_id == REQUEST_ID_INVALID) {
-        return ESP_ERR_NO_MEM;
+    if (ret == ESP_OK && out_request_id != NULL) {
+        *out_request_id = request_id;
     }
     
-    // Allocate request slot
-    if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
+    return ret;
+}
+
+esp_err_t request_send_future(system_service_id_t requester,
+                               system_service_id_t target_service,
+                               system_event_type_t request_type,
+                               const void *request_data,
+                               size_t request_size,
+                               uint32_t timeout_ms,
+                               request_future_t *out_future)
+{
+    if (out_future == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    pending_request_t *req = allocate_request_slot();
+    return send_future(requester, target_service, request_type, request_data,
+                       request_size, timeout_ms, NULL, NULL, out_future);
+}
+
+esp_err_t request_future_poll(request_future_t future,
+                               void *response_data,
+                               size_t *response_size)
+{
+    portENTER_CRITICAL(&g_requests_lock);
+    
+    pending_request_t *req = find_future_locked(future);
     if (req == NULL) {
-        xSemaphoreGive(g_requests_mutex);
-        return ESP_ERR_NO_MEM;
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_NOT_FOUND;
     }
     
-    // Initialize request
-    req->active = true;
-    req->request_id = request_id;
-    req->requester = 0;
-    req->response_sem = NULL;
-    req->callback = callback;
-    req->user_data = user_data;
+    if (req->state != REQUEST_SLOT_DONE) {
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_NOT_FINISHED;
+    }
     
-    xSemaphoreGive(g_requests_mutex);
+    void *stored;
+    size_t stored_size;
+    esp_err_t status = collect_future_locked(req, &stored, &stored_size);
+    portEXIT_CRITICAL(&g_requests_lock);
     
-    // Send request event
-    esp_err_t ret = system_event_post(0, request_type, request_data, request_size,
-                                      SYSTEM_EVENT_PRIORITY_HIGH);
-    if (ret != ESP_OK) {
-        req->active = false;
-        return ret;
+    return finish_future(status, stored, stored_size, response_data, response_size);
+}
+
+esp_err_t request_future_wait(request_future_t future,
+                               void *response_data,
+                               size_t *response_size,
+                               uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    
+    while (true) {
+        portENTER_CRITICAL(&g_requests_lock);
+    
+        pending_request_t *req = find_future_locked(future);
+        if (req == NULL) {
+            portEXIT_CRITICAL(&g_requests_lock);
+            return ESP_ERR_NOT_FOUND;
+        }
+    
+        if (req->state == REQUEST_SLOT_DONE) {
+            void *stored;
+            size_t stored_size;
+            esp_err_t status = collect_future_locked(req, &stored, &stored_size);
+            portEXIT_CRITICAL(&g_requests_lock);
+            return finish_future(status, stored, stored_size, response_data, response_size);
+        }
+    
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            // The future stays pending, only this wait gave up
+            req->waiter = NULL;
+            portEXIT_CRITICAL(&g_requests_lock);
+            return ESP_ERR_NOT_FINISHED;
+        }
+    
+        req->waiter = xTaskGetCurrentTaskHandle();
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+    }
+}
+
+esp_err_t request_future_then(request_future_t future,
+                               response_callback_t callback,
+                               void *user_data)
+{
+    if (callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    if (out_request_id != NULL) {
-        *out_request_id = request_id;
+    portENTER_CRITICAL(&g_requests_lock);
+    
+    pending_request_t *req = find_future_locked(future);
+    if (req == NULL) {
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    if (req->state != REQUEST_SLOT_DONE) {
+        // Completion or expiry calls it and releases the slot
+        req->callback = callback;
+        req->user_data = user_data;
+        req->waiter = NULL;
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_OK;
+    }
+    
+    // Already complete: run it now
+    esp_err_t status = req->status;
+    void *stored = req->response_data;
+    size_t size = req->response_size;
+    release_slot_locked(req);
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    callback(future, status, stored, (status == ESP_OK) ? size : 0, user_data);
+    memory_pool_free(stored);
+    
+    return ESP_OK;
+}
+
+esp_err_t request_future_release(request_future_t future)
+{
+    portENTER_CRITICAL(&g_requests_lock);
+    
+    pending_request_t *req = find_future_locked(future);
+    if (req == NULL) {
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    if (req->state == REQUEST_SLOT_RESPONDING) {
+        // The responder still owns the slot; drop the result when it lands
+        req->kind = REQUEST_KIND_SYNC;
+        req->response_data = NULL;
+        req->response_buffer_size = 0;
+        req->waiter = NULL;
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_OK;
     }
     
+    void *stored = req->response_data;
+    release_slot_locked(req);
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    memory_pool_free(stored);
     return ESP_OK;
 }
 
@@ -225,69 +845,175 @@ esp_err_t request_send_response(request_id_t request_id,
                                  const void *response_data,
                                  size_t response_size)
 {
-    ensure_mutex();
-    
-    if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
-    }
+    portENTER_CRITICAL(&g_requests_lock);
     
-    pending_request_t *req = find_request(request_id);
-    if (req == NULL) {
-        xSemaphoreGive(g_requests_mutex);
+    pending_request_t *req = find_request_locked(request_id);
+    if (req == NULL || req->state != REQUEST_SLOT_PENDING) {
+        portEXIT_CRITICAL(&g_requests_lock);
         ESP_LOGW(TAG, "Request %lu not found", request_id);
         return ESP_ERR_NOT_FOUND;
     }
     
     if (req->callback != NULL) {
-        // Async request - call callback
-        xSemaphoreGive(g_requests_mutex);
-        req->callback(request_id, response_data, response_size, req->user_data);
-        
-        if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-            return ESP_OK;
-        }
-        req->active = false;
-        xSemaphoreGive(g_requests_mutex);
-    } else {
-        // Sync request - copy data and signal semaphore
-        if (req->response_data != NULL && response_data != NULL) {
-            size_t copy_size = (response_size < req->response_buffer_size) ? 
-                               response_size : req->response_buffer_size;
-            memcpy(req->response_data, response_data, copy_size);
-            req->response_size = copy_size;
+        // Continuation - free the slot first, the callback may send again
+        response_callback_t callback = req->callback;
+        void *user_data = req->user_data;
+        release_slot_locked(req);
+        portEXIT_CRITICAL(&g_requests_lock);
+    
+        callback(request_id, ESP_OK, response_data, response_size, user_data);
+        return ESP_OK;
+    }
+    
+    // Copy outside the lock; RESPONDING keeps the slot in place meanwhile
+    req->state = REQUEST_SLOT_RESPONDING;
+    wheel_remove_locked(req);
+    request_kind_t kind = (request_kind_t)req->kind;
+    void *buffer = req->response_data;
+    size_t buffer_size = req->response_buffer_size;
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    size_t copy_size = 0;
+    void *stored = NULL;
+    esp_err_t status = ESP_OK;
+    
+    if (kind == REQUEST_KIND_SYNC) {
+        copy_size = (response_size < buffer_size) ? response_size : buffer_size;
+        if (response_data != NULL && copy_size > 0) {
+            memcpy(buffer, response_data, copy_size);
         }
-        
-        xSemaphoreGive(g_requests_mutex);
-        
-        if (req->response_sem != NULL) {
-            xSemaphoreGive(req->response_sem);
+    } else if (response_data != NULL && response_size > 0) {
+        // The future outlives the responder's buffer, keep a copy
+        stored = memory_pool_alloc(response_size);
+        if (stored != NULL) {
+            memcpy(stored, response_data, response_size);
+            copy_size = response_size;
+        } else {
+            status = ESP_ERR_NO_MEM;
         }
     }
     
+    portENTER_CRITICAL(&g_requests_lock);
+    
+    response_callback_t callback = req->callback;
+    void *user_data = req->user_data;
+    TaskHandle_t waiter = req->waiter;
+    bool dropped = (kind == REQUEST_KIND_FUTURE && req->kind != REQUEST_KIND_FUTURE);
+    
+    if (callback != NULL || dropped) {
+        // A continuation attached, or the future released, while copying
+        release_slot_locked(req);
+    } else {
+        req->response_data = (kind == REQUEST_KIND_FUTURE) ? stored : buffer;
+        req->response_size = copy_size;
+        req->status = status;
+        req->state = REQUEST_SLOT_DONE;
+    }
+    
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    if (callback != NULL) {
+        callback(request_id, status, stored, copy_size, user_data);
+        memory_pool_free(stored);
+    } else if (dropped) {
+        memory_pool_free(stored);
+    } else if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+    
     return ESP_OK;
 }
 
-esp_err_t request_cancel(request_id_t request_id)
+esp_err_t request_register_handler(system_service_id_t service_id,
+                                   system_event_type_t request_type,
+                                   request_handler_t handler,
+                                   void *user_data)
 {
-    ensure_mutex();
+    if (handler == NULL || request_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES ||
+        service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    if (xSemaphoreTake(g_requests_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        return ESP_ERR_TIMEOUT;
+    portENTER_CRITICAL(&g_requests_lock);
+    direct_handler_t *entry = &g_direct_handlers[request_type];
+    if (entry->handler != NULL && entry->service_id != service_id) {
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_INVALID_STATE;
     }
+    entry->handler = handler;
+    entry->user_data = user_data;
+    entry->service_id = service_id;
+    portEXIT_CRITICAL(&g_requests_lock);
     
-    pending_request_t *req = find_request(request_id);
-    if (req == NULL) {
-        xSemaphoreGive(g_requests_mutex);
-        return ESP_ERR_NOT_FOUND;
+    ESP_LOGD(TAG, "Service %d serves request type %d directly", service_id, request_type);
+    return ESP_OK;
+}
+
+esp_err_t request_unregister_handler(system_service_id_t service_id,
+                                     system_event_type_t request_type)
+{
+    if (request_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    if (req->response_sem != NULL) {
-        vSemaphoreDelete(req->response_sem);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    
+    portENTER_CRITICAL(&g_requests_lock);
+    direct_handler_t *entry = &g_direct_handlers[request_type];
+    if (entry->handler != NULL && entry->service_id == service_id) {
+        memset(entry, 0, sizeof(direct_handler_t));
+        ret = ESP_OK;
     }
+    portEXIT_CRITICAL(&g_requests_lock);
     
-    req->active = false;
+    return ret;
+}
+
+esp_err_t request_parse(const system_event_t *event,
+                        const request_header_t **out_header,
+                        const void **out_payload,
+                        size_t *out_size)
+{
+    if (event == NULL || out_header == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    xSemaphoreGive(g_requests_mutex);
+    const request_header_t *header = event->data;
+    if (header == NULL || event->data_size < sizeof(request_header_t) ||
+        header->magic != REQUEST_HEADER_MAGIC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *out_header = header;
+    if (out_payload != NULL) {
+        *out_payload = header + 1;
+    }
+    if (out_size != NULL) {
+        *out_size = event->data_size - sizeof(request_header_t);
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t request_cancel(request_id_t request_id)
+{
+    portENTER_CRITICAL(&g_requests_lock);
+    
+    pending_request_t *req = find_request_locked(request_id);
+    if (req == NULL || req->state != REQUEST_SLOT_PENDING) {
+        portEXIT_CRITICAL(&g_requests_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    TaskHandle_t waiter = req->waiter;
+    release_slot_locked(req);
+    
+    portEXIT_CRITICAL(&g_requests_lock);
+    
+    // Wake a blocked caller so it sees the slot is gone
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
     
     ESP_LOGI(TAG, "Request %lu cancelled", request_id);
     return ESP_OK;
@@ -1,6 +1,17 @@
 /**
  * @file resource_quota.c
  * @brief Resource quota implementation
+ * 
+ * Limits on the posting path - event rate and data size - and memory
+ * charges are kept in per-service accounts updated with atomics, so
+ * posting and allocating never take the quota mutex. The mutex only
+ * serializes configuration and the subscription counters.
+ * 
+ * Event rates are token buckets: max_events_per_sec tokens are added per
+ * second up to event_burst, and each post takes one. A bucket is kept as
+ * the time it is next empty (GCRA's theoretical arrival time), one 32-bit
+ * word: refill, check and consume are a single native compare-and-swap,
+ * where a 64-bit one would go through libatomic's critical section.
  */
 
 #include "resource_quota.h"
@@ -9,6 +20,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "system_service/error_codes.h"
+#include "system_service/static_alloc.h"
 #include <string.h>
 
 static const char *TAG = "quota";
@@ -37,6 +49,62 @@ typedef struct {
 } quota_context_t;
 
 static quota_context_t g_quota_ctx = {0};
+SYSTEM_MUTEX_DEFINE(s_quota_mutex);
+
+/*
+ * Memory charges are indexed by service ID and updated with atomics, so
+ * allocation paths never take the quota mutex. limit mirrors the
+ * service's max_memory_bytes.
+ */
+typedef struct {
+    uint32_t bytes[2];                  /**< Charged bytes per quota_memory_region_t */
+    uint32_t peak_internal;             /**< Highest internal charge */
+    uint32_t limit;                     /**< max_memory_bytes */
+    uint32_t rejected;                  /**< Refused allocations */
+} memory_account_t;
+
+static memory_account_t g_memory_accounts[SYSTEM_SERVICE_MAX_SERVICES];
+
+#define TOKEN_MAX_SPAN_US       INT32_MAX   /**< Longest burst, in refill time */
+#define TOKEN_IDLE_MS           (30 * 60 * 1000)
+
+/**
+ * Rate limit; rate 0 means unlimited. The bucket is full once tat has
+ * passed and empty while tat is span ahead of now; each token moves tat
+ * on by interval. tat is in wrapping microseconds, so after an idle of
+ * more than half their range it would read as the future: last_ms spots
+ * that and the bucket just counts as full.
+ */
+typedef struct {
+    uint32_t tat;                       /**< Time the bucket runs empty, us */
+    uint32_t last_ms;                   /**< Last successful take */
+    uint32_t interval;                  /**< us per token */
+    uint32_t span;                      /**< burst * interval */
+    uint32_t rate;                      /**< Tokens per second */
+    uint32_t burst;                     /**< Bucket depth in tokens */
+} token_bucket_t;
+
+/** Posting limits and counters, indexed by service ID */
+typedef struct {
+    token_bucket_t events;
+    uint32_t max_data_size;             /**< max_event_data_size mirror */
+    uint32_t total_posted;
+    uint32_t rejected;
+    uint32_t type_budgets;              /**< Type budgets owned by this service */
+} event_account_t;
+
+/** Optional budget for one event type of one service */
+typedef struct {
+    bool in_use;                        /**< Published with release ordering */
+    system_service_id_t service_id;
+    system_event_type_t event_type;
+    token_bucket_t bucket;
+} type_budget_t;
+
+#define MAX_TYPE_BUDGETS        CONFIG_SYSTEM_SERVICE_MAX_EVENT_TYPE_QUOTAS
+
+static event_account_t g_event_accounts[SYSTEM_SERVICE_MAX_SERVICES];
+static type_budget_t g_type_budgets[MAX_TYPE_BUDGETS];
 
 /* ============================================================================
  * Internal Helpers
@@ -47,6 +115,11 @@ static inline uint32_t get_time_ms(void)
     return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
+static inline uint32_t get_time_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
 static quota_entry_t* find_entry(system_service_id_t service_id)
 {
     for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
@@ -70,6 +143,134 @@ static quota_entry_t* allocate_entry(system_service_id_t service_id)
     return NULL;
 }
 
+/* ============================================================================
+ * Token Buckets
+ * ============================================================================ */
+
+/**
+ * @brief Set rate and depth and fill the bucket (quota mutex held)
+ */
+static void token_bucket_configure(token_bucket_t *bucket, uint32_t rate, uint32_t burst)
+{
+    if (burst == 0) {
+        burst = rate;
+    }
+    
+    uint32_t interval = 0;
+    if (rate != 0) {
+        interval = (rate < 1000000) ? 1000000 / rate : 1;
+        if (burst > TOKEN_MAX_SPAN_US / interval) {
+            burst = TOKEN_MAX_SPAN_US / interval;
+        }
+    }
+    
+    __atomic_store_n(&bucket->burst, burst, __ATOMIC_RELAXED);
+    __atomic_store_n(&bucket->interval, interval, __ATOMIC_RELAXED);
+    __atomic_store_n(&bucket->span, burst * interval, __ATOMIC_RELAXED);
+    __atomic_store_n(&bucket->last_ms, get_time_ms(), __ATOMIC_RELAXED);
+    __atomic_store_n(&bucket->tat, get_time_us(), __ATOMIC_RELAXED);
+    __atomic_store_n(&bucket->rate, rate, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Refill by elapsed time and take count tokens, all or nothing
+ */
+static bool token_bucket_take(token_bucket_t *bucket, uint32_t count)
+{
+    uint32_t rate = __atomic_load_n(&bucket->rate, __ATOMIC_ACQUIRE);
+    if (rate == 0 || count == 0) {
+        return true;
+    }
+    
+    uint32_t span = __atomic_load_n(&bucket->span, __ATOMIC_RELAXED);
+    uint64_t needed = (uint64_t)count * __atomic_load_n(&bucket->interval, __ATOMIC_RELAXED);
+    if (needed > span) {
+        return false;
+    }
+    
+    uint32_t now = get_time_us();
+    bool idle = get_time_ms() - __atomic_load_n(&bucket->last_ms, __ATOMIC_RELAXED) > TOKEN_IDLE_MS;
+    uint32_t tat = __atomic_load_n(&bucket->tat, __ATOMIC_RELAXED);
+    uint32_t next;
+    
+    do {
+        // tat in the past: full, whatever time has passed since
+        uint32_t from = (idle || (int32_t)(tat - now) < 0) ? now : tat;
+        next = from + (uint32_t)needed;
+        
+        if ((int32_t)(next - now) > (int32_t)span) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&bucket->tat, &tat, next, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    __atomic_store_n(&bucket->last_ms, get_time_ms(), __ATOMIC_RELAXED);
+    return true;
+}
+
+/**
+ * @brief Put back tokens taken for a post that then failed
+ */
+static void token_bucket_refund(token_bucket_t *bucket, uint32_t count)
+{
+    if (__atomic_load_n(&bucket->rate, __ATOMIC_ACQUIRE) == 0 || count == 0) {
+        return;
+    }
+    
+    uint32_t given = count * __atomic_load_n(&bucket->interval, __ATOMIC_RELAXED);
+    uint32_t now = get_time_us();
+    uint32_t tat = __atomic_load_n(&bucket->tat, __ATOMIC_RELAXED);
+    uint32_t next;
+    
+    do {
+        // Never further back than full, which is tat reaching now
+        int32_t ahead = (int32_t)(tat - now);
+        if (ahead <= 0) {
+            return;
+        }
+        next = ((uint32_t)ahead > given) ? tat - given : now;
+    } while (!__atomic_compare_exchange_n(&bucket->tat, &tat, next, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Whole tokens currently available
+ */
+static uint32_t token_bucket_level(token_bucket_t *bucket)
+{
+    uint32_t interval = __atomic_load_n(&bucket->interval, __ATOMIC_RELAXED);
+    uint32_t burst = __atomic_load_n(&bucket->burst, __ATOMIC_RELAXED);
+    int32_t ahead = (int32_t)(__atomic_load_n(&bucket->tat, __ATOMIC_RELAXED) - get_time_us());
+    
+    if (interval == 0 || ahead <= 0 ||
+        get_time_ms() - __atomic_load_n(&bucket->last_ms, __ATOMIC_RELAXED) > TOKEN_IDLE_MS) {
+        return burst;
+    }
+    uint32_t used = ((uint32_t)ahead + interval - 1) / interval;
+    return (used < burst) ? burst - used : 0;
+}
+
+/**
+ * @brief Lock-free lookup of a type budget
+ */
+static type_budget_t* find_type_budget(system_service_id_t service_id,
+                                       system_event_type_t event_type)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES ||
+        __atomic_load_n(&g_event_accounts[service_id].type_budgets, __ATOMIC_ACQUIRE) == 0) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < MAX_TYPE_BUDGETS; i++) {
+        type_budget_t *budget = &g_type_budgets[i];
+        if (__atomic_load_n(&budget->in_use, __ATOMIC_ACQUIRE) &&
+            budget->service_id == service_id && budget->event_type == event_type) {
+            return budget;
+        }
+    }
+    return NULL;
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -83,7 +284,7 @@ esp_err_t quota_init(void)
     ESP_LOGI(TAG, "Initializing quota system...");
     
     // Create mutex
-    g_quota_ctx.mutex = xSemaphoreCreateMutex();
+    g_quota_ctx.mutex = SYSTEM_MUTEX_CREATE(s_quota_mutex);
     if (g_quota_ctx.mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create quota mutex");
         return ESP_ERR_NO_MEM;
@@ -98,6 +299,18 @@ esp_err_t quota_init(void)
     // Initialize entries
     memset(g_quota_ctx.entries, 0, sizeof(g_quota_ctx.entries));
     
+    memset(g_memory_accounts, 0, sizeof(g_memory_accounts));
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        g_memory_accounts[i].limit = g_quota_ctx.default_quota.max_memory_bytes;
+    }
+    
+    // No rate or size limit until quota_set()
+    memset(g_event_accounts, 0, sizeof(g_event_accounts));
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        g_event_accounts[i].max_data_size = UINT32_MAX;
+    }
+    memset(g_type_budgets, 0, sizeof(g_type_budgets));
+    
     g_quota_ctx.initialized = true;
     
     ESP_LOGI(TAG, "Quota system initialized");
@@ -157,6 +370,17 @@ esp_err_t quota_set(system_service_id_t service_id, const service_quota_t *quota
         entry->quota = g_quota_ctx.default_quota;
     }
     
+    if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        __atomic_store_n(&g_memory_accounts[service_id].limit,
+                         entry->quota.max_memory_bytes, __ATOMIC_RELAXED);
+        
+        event_account_t *account = &g_event_accounts[service_id];
+        token_bucket_configure(&account->events, entry->quota.max_events_per_sec,
+                               entry->quota.event_burst);
+        __atomic_store_n(&account->max_data_size, entry->quota.max_event_data_size,
+                         __ATOMIC_RELAXED);
+    }
+    
     xSemaphoreGive(g_quota_ctx.mutex);
     
     ESP_LOGI(TAG, "Quota set for service %d", service_id);
@@ -204,55 +428,178 @@ esp_err_t quota_get_usage(system_service_id_t service_id, service_quota_usage_t
     
     xSemaphoreGive(g_quota_ctx.mutex);
     
+    quota_memory_usage_t memory;
+    if (quota_get_memory_usage(service_id, &memory) == ESP_OK) {
+        usage->current_memory_bytes = memory.internal_bytes + memory.psram_bytes;
+        usage->quota_violations += memory.rejected;
+    }
+    
+    if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        event_account_t *account = &g_event_accounts[service_id];
+        uint32_t burst = __atomic_load_n(&account->events.burst, __ATOMIC_RELAXED);
+        uint32_t level = token_bucket_level(&account->events);
+        usage->events_this_sec = (burst > level) ? burst - level : 0;
+        usage->total_events_posted = __atomic_load_n(&account->total_posted, __ATOMIC_RELAXED);
+        usage->quota_violations += __atomic_load_n(&account->rejected, __ATOMIC_RELAXED);
+    }
+    
     return ESP_OK;
 }
 
-esp_err_t quota_check_event_post(system_service_id_t service_id)
+esp_err_t quota_take_events(system_service_id_t service_id, uint32_t count)
 {
-    if (!g_quota_ctx.initialized) {
+    if (!g_quota_ctx.initialized || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
         return ESP_OK; // Quotas disabled
     }
     
-    if (xSemaphoreTake(g_quota_ctx.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return ESP_OK; // Don't block on quota check
+    event_account_t *account = &g_event_accounts[service_id];
+    if (!token_bucket_take(&account->events, count)) {
+        __atomic_add_fetch(&account->rejected, 1, __ATOMIC_RELAXED);
+        ESP_LOGW(TAG, "Service %d exceeded event rate (%lu/s, burst %lu)",
+                 service_id, account->events.rate, account->events.burst);
+        return ESP_ERR_QUOTA_EVENTS_EXCEEDED;
     }
     
-    quota_entry_t *entry = find_entry(service_id);
-    if (entry == NULL) {
-        xSemaphoreGive(g_quota_ctx.mutex);
-        return ESP_OK; // No quota set
+    return ESP_OK;
+}
+
+esp_err_t quota_take_type_events(system_service_id_t service_id,
+                                 system_event_type_t event_type,
+                                 uint32_t count)
+{
+    if (!g_quota_ctx.initialized) {
+        return ESP_OK;
     }
     
-    // Check event rate quota
-    if (entry->usage.events_this_sec >= entry->quota.max_events_per_sec) {
-        entry->usage.quota_violations++;
-        xSemaphoreGive(g_quota_ctx.mutex);
-        ESP_LOGW(TAG, "Service %d exceeded event quota (%lu/%lu)",
-                 service_id, entry->usage.events_this_sec, entry->quota.max_events_per_sec);
+    type_budget_t *budget = find_type_budget(service_id, event_type);
+    if (budget == NULL) {
+        return ESP_OK;
+    }
+    
+    if (!token_bucket_take(&budget->bucket, count)) {
+        __atomic_add_fetch(&g_event_accounts[service_id].rejected, 1, __ATOMIC_RELAXED);
+        ESP_LOGW(TAG, "Service %d exceeded budget for event type %d (%lu/s)",
+                 service_id, event_type, budget->bucket.rate);
         return ESP_ERR_QUOTA_EVENTS_EXCEEDED;
     }
     
-    xSemaphoreGive(g_quota_ctx.mutex);
     return ESP_OK;
 }
 
-esp_err_t quota_record_event_post(system_service_id_t service_id)
+esp_err_t quota_take_event(system_service_id_t service_id, system_event_type_t event_type)
+{
+    esp_err_t ret = quota_take_type_events(service_id, event_type, 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = quota_take_events(service_id, 1);
+    if (ret != ESP_OK) {
+        quota_return_type_events(service_id, event_type, 1);
+    }
+    return ret;
+}
+
+void quota_return_events(system_service_id_t service_id, uint32_t count)
+{
+    if (!g_quota_ctx.initialized || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return;
+    }
+    
+    token_bucket_refund(&g_event_accounts[service_id].events, count);
+}
+
+void quota_return_type_events(system_service_id_t service_id,
+                              system_event_type_t event_type,
+                              uint32_t count)
 {
     if (!g_quota_ctx.initialized) {
-        return ESP_OK;
+        return;
     }
     
-    if (xSemaphoreTake(g_quota_ctx.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+    type_budget_t *budget = find_type_budget(service_id, event_type);
+    if (budget != NULL) {
+        token_bucket_refund(&budget->bucket, count);
+    }
+}
+
+void quota_return_event(system_service_id_t service_id, system_event_type_t event_type)
+{
+    quota_return_type_events(service_id, event_type, 1);
+    quota_return_events(service_id, 1);
+}
+
+esp_err_t quota_record_event_batch(system_service_id_t service_id, uint32_t count)
+{
+    if (!g_quota_ctx.initialized || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
         return ESP_OK;
     }
     
-    quota_entry_t *entry = find_entry(service_id);
-    if (entry != NULL) {
-        entry->usage.events_this_sec++;
-        entry->usage.total_events_posted++;
+    __atomic_add_fetch(&g_event_accounts[service_id].total_posted, count, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t quota_record_event_post(system_service_id_t service_id)
+{
+    return quota_record_event_batch(service_id, 1);
+}
+
+esp_err_t quota_set_event_type_budget(system_service_id_t service_id,
+                                      system_event_type_t event_type,
+                                      uint32_t rate,
+                                      uint32_t burst)
+{
+    if (!g_quota_ctx.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES || event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (xSemaphoreTake(g_quota_ctx.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    type_budget_t *budget = find_type_budget(service_id, event_type);
+    
+    if (rate == 0) {
+        // Remove; posters that already found it see rate 0 = unlimited
+        esp_err_t ret = ESP_ERR_NOT_FOUND;
+        if (budget != NULL) {
+            __atomic_store_n(&budget->bucket.rate, 0, __ATOMIC_RELEASE);
+            __atomic_store_n(&budget->in_use, false, __ATOMIC_RELEASE);
+            __atomic_sub_fetch(&g_event_accounts[service_id].type_budgets, 1, __ATOMIC_RELEASE);
+            ret = ESP_OK;
+        }
+        xSemaphoreGive(g_quota_ctx.mutex);
+        return ret;
+    }
+    
+    if (budget == NULL) {
+        for (int i = 0; i < MAX_TYPE_BUDGETS; i++) {
+            if (!g_type_budgets[i].in_use) {
+                budget = &g_type_budgets[i];
+                break;
+            }
+        }
+        if (budget == NULL) {
+            xSemaphoreGive(g_quota_ctx.mutex);
+            return ESP_ERR_NO_MEM;
+        }
+        
+        budget->service_id = service_id;
+        budget->event_type = event_type;
+        token_bucket_configure(&budget->bucket, rate, burst);
+        __atomic_store_n(&budget->in_use, true, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&g_event_accounts[service_id].type_budgets, 1, __ATOMIC_RELEASE);
+    } else {
+        token_bucket_configure(&budget->bucket, rate, burst);
     }
     
     xSemaphoreGive(g_quota_ctx.mutex);
+    
+    ESP_LOGI(TAG, "Service %d event type %d limited to %lu/s", service_id, event_type, rate);
     return ESP_OK;
 }
 
@@ -307,9 +654,9 @@ esp_err_t quota_record_subscription(system_service_id_t service_id, bool add)
     return ESP_OK;
 }
 
-esp_err_t quota_check_data_size(system_service_id_t service_id, size_t data_size)
+esp_err_t quota_release_subscriptions(system_service_id_t service_id, uint32_t count)
 {
-    if (!g_quota_ctx.initialized) {
+    if (!g_quota_ctx.initialized || count == 0) {
         return ESP_OK;
     }
     
@@ -318,68 +665,107 @@ esp_err_t quota_check_data_size(system_service_id_t service_id, size_t data_size
     }
     
     quota_entry_t *entry = find_entry(service_id);
-    if (entry == NULL) {
-        xSemaphoreGive(g_quota_ctx.mutex);
+    if (entry != NULL) {
+        entry->usage.active_subscriptions = (entry->usage.active_subscriptions > count) ?
+                                            entry->usage.active_subscriptions - count : 0;
+    }
+    
+    xSemaphoreGive(g_quota_ctx.mutex);
+    return ESP_OK;
+}
+
+esp_err_t quota_check_data_size(system_service_id_t service_id, size_t data_size)
+{
+    if (!g_quota_ctx.initialized || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
         return ESP_OK;
     }
     
-    if (data_size > entry->quota.max_event_data_size) {
-        entry->usage.quota_violations++;
-        xSemaphoreGive(g_quota_ctx.mutex);
+    event_account_t *account = &g_event_accounts[service_id];
+    uint32_t limit = __atomic_load_n(&account->max_data_size, __ATOMIC_RELAXED);
+    if (data_size > limit) {
+        __atomic_add_fetch(&account->rejected, 1, __ATOMIC_RELAXED);
         ESP_LOGW(TAG, "Service %d exceeded data size quota (%zu/%lu)",
-                 service_id, data_size, entry->quota.max_event_data_size);
+                 service_id, data_size, limit);
         return ESP_ERR_QUOTA_DATA_SIZE_EXCEEDED;
     }
     
-    xSemaphoreGive(g_quota_ctx.mutex);
     return ESP_OK;
 }
 
-esp_err_t quota_record_memory_alloc(system_service_id_t service_id, size_t size)
+esp_err_t quota_record_memory_alloc(system_service_id_t service_id, size_t size,
+                                    quota_memory_region_t region)
 {
     if (!g_quota_ctx.initialized) {
         return ESP_OK;
     }
     
-    if (xSemaphoreTake(g_quota_ctx.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return ESP_OK;
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    quota_entry_t *entry = find_entry(service_id);
-    if (entry != NULL) {
-        entry->usage.current_memory_bytes += size;
-        
-        // Check quota
-        if (entry->usage.current_memory_bytes > entry->quota.max_memory_bytes) {
-            ESP_LOGW(TAG, "Service %d exceeded memory quota (%lu/%lu)",
-                     service_id, entry->usage.current_memory_bytes, entry->quota.max_memory_bytes);
+    memory_account_t *account = &g_memory_accounts[service_id];
+    uint32_t limit = __atomic_load_n(&account->limit, __ATOMIC_RELAXED);
+    uint32_t *bytes = &account->bytes[region];
+    uint32_t other = __atomic_load_n(&account->bytes[region ^ 1], __ATOMIC_RELAXED);
+    uint32_t current = __atomic_load_n(bytes, __ATOMIC_RELAXED);
+    
+    do {
+        if ((uint64_t)current + other + size > limit) {
+            __atomic_add_fetch(&account->rejected, 1, __ATOMIC_RELAXED);
+            ESP_LOGW(TAG, "Service %d exceeded memory quota (%lu+%zu/%lu)",
+                     service_id, (unsigned long)(current + other), size, (unsigned long)limit);
+            return ESP_ERR_QUOTA_MEMORY_EXCEEDED;
+        }
+    } while (!__atomic_compare_exchange_n(bytes, &current, current + (uint32_t)size, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    if (region == QUOTA_MEMORY_INTERNAL) {
+        uint32_t used = current + (uint32_t)size;
+        uint32_t peak = __atomic_load_n(&account->peak_internal, __ATOMIC_RELAXED);
+        while (used > peak &&
+               !__atomic_compare_exchange_n(&account->peak_internal, &peak, used, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
         }
     }
     
-    xSemaphoreGive(g_quota_ctx.mutex);
     return ESP_OK;
 }
 
-esp_err_t quota_record_memory_free(system_service_id_t service_id, size_t size)
+esp_err_t quota_record_memory_free(system_service_id_t service_id, size_t size,
+                                   quota_memory_region_t region)
 {
     if (!g_quota_ctx.initialized) {
         return ESP_OK;
     }
     
-    if (xSemaphoreTake(g_quota_ctx.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return ESP_OK;
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    quota_entry_t *entry = find_entry(service_id);
-    if (entry != NULL) {
-        if (entry->usage.current_memory_bytes >= size) {
-            entry->usage.current_memory_bytes -= size;
-        } else {
-            entry->usage.current_memory_bytes = 0;
-        }
+    uint32_t *bytes = &g_memory_accounts[service_id].bytes[region];
+    uint32_t current = __atomic_load_n(bytes, __ATOMIC_RELAXED);
+    uint32_t remaining;
+    
+    do {
+        remaining = (current >= size) ? current - (uint32_t)size : 0;
+    } while (!__atomic_compare_exchange_n(bytes, &current, remaining, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    
+    return ESP_OK;
+}
+
+esp_err_t quota_get_memory_usage(system_service_id_t service_id, quota_memory_usage_t *usage)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES || usage == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    xSemaphoreGive(g_quota_ctx.mutex);
+    memory_account_t *account = &g_memory_accounts[service_id];
+    usage->internal_bytes = __atomic_load_n(&account->bytes[QUOTA_MEMORY_INTERNAL], __ATOMIC_RELAXED);
+    usage->psram_bytes = __atomic_load_n(&account->bytes[QUOTA_MEMORY_PSRAM], __ATOMIC_RELAXED);
+    usage->peak_internal_bytes = __atomic_load_n(&account->peak_internal, __ATOMIC_RELAXED);
+    usage->rejected = __atomic_load_n(&account->rejected, __ATOMIC_RELAXED);
+    
     return ESP_OK;
 }
 
@@ -395,13 +781,20 @@ esp_err_t quota_reset_counters(void)
     
     uint32_t now = get_time_ms();
     
+    // Refill every bucket
     for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        token_bucket_t *bucket = &g_event_accounts[i].events;
+        token_bucket_configure(bucket, bucket->rate, bucket->burst);
         if (g_quota_ctx.entries[i].active) {
-            // Reset per-second counters
-            g_quota_ctx.entries[i].usage.events_this_sec = 0;
             g_quota_ctx.entries[i].last_reset_time = now;
         }
     }
+    for (int i = 0; i < MAX_TYPE_BUDGETS; i++) {
+        if (g_type_budgets[i].in_use) {
+            token_bucket_t *bucket = &g_type_budgets[i].bucket;
+            token_bucket_configure(bucket, bucket->rate, bucket->burst);
+        }
+    }
     
     xSemaphoreGive(g_quota_ctx.mutex);
     
@@ -416,21 +809,38 @@ void quota_log_status(const char *tag)
     }
     
     ESP_LOGI(tag, "Quota Status:");
-    ESP_LOGI(tag, "  Service | Events/s | Subs | Memory | Violations");
-    ESP_LOGI(tag, "  --------|----------|------|--------|------------");
+    ESP_LOGI(tag, "  Service | Events/s | Subs | SRAM KB (peak) | PSRAM KB | Limit KB | Violations");
+    ESP_LOGI(tag, "  --------|----------|------|----------------|----------|----------|-----------");
     
     for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
-        if (g_quota_ctx.entries[i].active) {
-            quota_entry_t *entry = &g_quota_ctx.entries[i];
-            ESP_LOGI(tag, "  %7d | %4lu/%3lu | %2lu/%2lu | %4lu/%4lu | %10lu",
-                     entry->service_id,
-                     entry->usage.events_this_sec,
-                     entry->quota.max_events_per_sec,
-                     entry->usage.active_subscriptions,
-                     entry->quota.max_subscriptions,
-                     entry->usage.current_memory_bytes / 1024,
-                     entry->quota.max_memory_bytes / 1024,
-                     entry->usage.quota_violations);
+        quota_entry_t *entry = g_quota_ctx.entries[i].active ? &g_quota_ctx.entries[i] : NULL;
+        system_service_id_t id = (entry != NULL) ? entry->service_id : (system_service_id_t)i;
+        
+        quota_memory_usage_t memory;
+        if (quota_get_memory_usage(id, &memory) != ESP_OK) {
+            memset(&memory, 0, sizeof(memory));
+        }
+        
+        // Services with no quota entry still show up once they hold memory
+        if (entry == NULL && memory.internal_bytes == 0 && memory.psram_bytes == 0) {
+            continue;
         }
+        
+        // Events column: tokens in use / refill rate
+        token_bucket_t *bucket = &g_event_accounts[id < SYSTEM_SERVICE_MAX_SERVICES ? id : 0].events;
+        uint32_t level = token_bucket_level(bucket);
+        
+        ESP_LOGI(tag, "  %7d | %4lu/%3lu | %2lu/%2lu | %6lu (%5lu) | %8lu | %8lu | %10lu",
+                 id,
+                 (unsigned long)(bucket->burst > level ? bucket->burst - level : 0),
+                 (unsigned long)bucket->rate,
+                 entry ? entry->usage.active_subscriptions : 0,
+                 entry ? entry->quota.max_subscriptions : 0,
+                 (unsigned long)(memory.internal_bytes / 1024),
+                 (unsigned long)(memory.peak_internal_bytes / 1024),
+                 (unsigned long)(memory.psram_bytes / 1024),
+                 (unsigned long)(g_memory_accounts[id < SYSTEM_SERVICE_MAX_SERVICES ? id : 0].limit / 1024),
+                 (entry ? entry->usage.quota_violations : 0) + memory.rejected +
+                 g_event_accounts[id < SYSTEM_SERVICE_MAX_SERVICES ? id : 0].rejected);
     }
 }
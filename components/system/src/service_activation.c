@@ -0,0 +1,724 @@
+/**
+ * @file service_activation.c
+ * @brief On-demand service activation
+ *
+ * Activatable services are brought up by one activation task, one at a
+ * time, so their init functions never race each other and never run on
+ * a dispatch worker or under the system lock. The task also runs the
+ * idle timeouts. It only exists while a service is coming up or an idle
+ * timeout is running; with nothing left to do it exits and its stack
+ * goes back to the heap.
+ *
+ * Demand is noted wherever it arises without blocking: the entry goes
+ * PENDING and the task is woken. Demand while the service is stopping
+ * brings it straight back up afterwards. A service that failed to come up
+ * is retried on demand only once its backoff has passed, 1 s doubling up
+ * to a minute; its init must have undone whatever it got done.
+ *
+ * A service goes idle when it has not been used for its timeout, its
+ * busy callback says so and no other service subscribes to its topics.
+ * Requests to it and demand while it is up count as use.
+ */
+
+#include "system_service/service_manager.h"
+#include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "service_activation.h"
+#include "service_dependencies.h"
+#include "system_internal.h"
+#include "topic_trie.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "activation";
+
+#define ACTIVATION_TASK_PRIORITY    5
+#define ACTIVATION_POLL_MS          10      // Waiters in system_service_activate()
+#define ACTIVATION_RETRY_MS         1000    // First retry after a failure, doubling
+#define ACTIVATION_RETRY_MAX_MS     60000
+
+typedef enum {
+    ACTIVATION_INACTIVE = 0,
+    ACTIVATION_PENDING,
+    ACTIVATION_STARTING,
+    ACTIVATION_ACTIVE,
+    ACTIVATION_STOPPING,
+    ACTIVATION_FAILED,
+} activation_state_t;
+
+typedef struct {
+    const system_service_activatable_t *desc;
+    activation_state_t state;
+    esp_err_t last_error;
+    system_service_id_t service_id;         // Valid while ACTIVE
+    system_event_type_t ui_event;
+    uint32_t last_used_ms;
+    uint32_t retry_at_ms;                   // FAILED: demand before this is refused
+    uint32_t retry_backoff_ms;              // 0 until the first failure
+    bool reactivate;                        // Demand arrived while stopping
+    bool has_replay;
+    system_event_t replay;                  // UI event that woke it, payload retained
+} activation_entry_t;
+
+static struct {
+    activation_entry_t entries[SYSTEM_SERVICE_MAX_ACTIVATABLE];
+    size_t count;                           // Entries are only appended
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+    system_service_id_t service_id;         // Subscriber of the UI events
+} g_activation = {
+    .service_id = SYSTEM_SERVICE_ID_INVALID,
+};
+
+SYSTEM_MUTEX_DEFINE(s_activation_lock);
+
+/* ============================================================================
+ * Internal Helpers
+ * ============================================================================ */
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static size_t entry_count(void)
+{
+    return __atomic_load_n(&g_activation.count, __ATOMIC_ACQUIRE);
+}
+
+static activation_entry_t *find_entry_locked(const char *name)
+{
+    for (size_t i = 0; i < g_activation.count; i++) {
+        if (strcmp(g_activation.entries[i].desc->name, name) == 0) {
+            return &g_activation.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool lookup_service(const char *name, system_service_id_t *out_id)
+{
+    system_context_t *ctx = system_get_context();
+    if (system_lock() != ESP_OK) {
+        return false;
+    }
+    
+    bool found = false;
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        if (ctx->services[i].registered && strcmp(ctx->services[i].name, name) == 0) {
+            *out_id = ctx->services[i].service_id;
+            found = true;
+            break;
+        }
+    }
+    
+    system_unlock();
+    return found;
+}
+
+static void activation_task(void *arg);
+
+static void backoff_locked(activation_entry_t *entry)
+{
+    if (entry->retry_backoff_ms == 0) {
+        entry->retry_backoff_ms = ACTIVATION_RETRY_MS;
+    } else if (entry->retry_backoff_ms < ACTIVATION_RETRY_MAX_MS) {
+        entry->retry_backoff_ms *= 2;
+        if (entry->retry_backoff_ms > ACTIVATION_RETRY_MAX_MS) {
+            entry->retry_backoff_ms = ACTIVATION_RETRY_MAX_MS;
+        }
+    }
+    entry->retry_at_ms = now_ms() + entry->retry_backoff_ms;
+}
+
+/**
+ * @brief Note demand for a service, waking or creating the task
+ */
+static void demand_locked(activation_entry_t *entry)
+{
+    switch (entry->state) {
+        case ACTIVATION_ACTIVE:
+            entry->last_used_ms = now_ms();
+            return;
+        case ACTIVATION_STOPPING:
+            entry->reactivate = true;
+            return;
+        case ACTIVATION_PENDING:
+        case ACTIVATION_STARTING:
+            return;
+        case ACTIVATION_FAILED:
+            // Don't hammer a service that keeps failing, each click retrying
+            if ((int32_t)(now_ms() - entry->retry_at_ms) < 0) {
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    
+    entry->state = ACTIVATION_PENDING;
+    
+    if (g_activation.task != NULL) {
+        xTaskNotifyGive(g_activation.task);
+        return;
+    }
+    
+    // Service init functions run on it, so it gets a boot worker's stack
+    if (xTaskCreate(activation_task, "activation", CONFIG_SYSTEM_SERVICE_ACTIVATION_STACK_SIZE,
+                    NULL, ACTIVATION_TASK_PRIORITY, &g_activation.task) != pdPASS) {
+        ESP_LOGE(TAG, "No activation task, %s stays down", entry->desc->name);
+        g_activation.task = NULL;
+        entry->state = ACTIVATION_FAILED;
+        entry->last_error = ESP_ERR_NO_MEM;
+        backoff_locked(entry);
+    }
+}
+
+static void demand(activation_entry_t *entry)
+{
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    demand_locked(entry);
+    xSemaphoreGive(g_activation.lock);
+}
+
+static void release_replay(system_event_t *event)
+{
+    if (event->data != NULL && event->data_size > 0) {
+        system_event_data_release(event->data);
+    }
+}
+
+/**
+ * @brief Hand the UI event that woke a service to its own handler for it
+ *
+ * Other subscribers had it already, so it is not posted again.
+ */
+static void replay_ui_event(system_service_id_t service_id, system_event_t *event)
+{
+    system_context_t *ctx = system_get_context();
+    system_event_handler_t handler = NULL;
+    void *user_data = NULL;
+    
+    if (system_lock() == ESP_OK) {
+        for (uint16_t i = ctx->event_types[event->event_type].first_subscription;
+             i != SUBSCRIPTION_INDEX_NONE;
+             i = ctx->subscriptions[i].next_in_type) {
+            if (ctx->subscriptions[i].service_id == service_id) {
+                handler = ctx->subscriptions[i].handler;
+                user_data = ctx->subscriptions[i].user_data;
+                break;
+            }
+        }
+        system_unlock();
+    }
+    
+    if (handler != NULL) {
+        handler(event, user_data);
+    }
+    release_replay(event);
+}
+
+/* ============================================================================
+ * Activation Task
+ * ============================================================================ */
+
+static void activate(activation_entry_t *entry)
+{
+    const system_service_activatable_t *desc = entry->desc;
+    int64_t start_us = esp_timer_get_time();
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    
+    esp_err_t ret = desc->init();
+    if (ret == ESP_OK && desc->start != NULL) {
+        ret = desc->start();
+        if (ret != ESP_OK && desc->deinit != NULL) {
+            desc->deinit();
+        }
+    }
+    
+    system_service_id_t service_id = SYSTEM_SERVICE_ID_INVALID;
+    if (ret == ESP_OK && !lookup_service(desc->name, &service_id)) {
+        ESP_LOGW(TAG, "%s came up but did not register under that name", desc->name);
+    }
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    entry->state = (ret == ESP_OK) ? ACTIVATION_ACTIVE : ACTIVATION_FAILED;
+    entry->last_error = ret;
+    entry->service_id = service_id;
+    entry->last_used_ms = now_ms();
+    if (ret == ESP_OK) {
+        entry->retry_backoff_ms = 0;
+    } else {
+        backoff_locked(entry);
+    }
+    system_event_t replay = entry->replay;
+    bool has_replay = entry->has_replay;
+    entry->has_replay = false;
+    xSemaphoreGive(g_activation.lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to activate %s: %s, retry in %lu ms at the earliest",
+                 desc->name, esp_err_to_name(ret), (unsigned long)entry->retry_backoff_ms);
+        if (has_replay) {
+            release_replay(&replay);
+        }
+        return;
+    }
+    
+    dependencies_mark_initialized(desc->name);
+    
+    ESP_LOGI(TAG, "Activated %s in %lld ms (%d bytes internal heap)",
+             desc->name, (esp_timer_get_time() - start_us) / 1000,
+             (int)(free_before - heap_caps_get_free_size(MALLOC_CAP_INTERNAL)));
+    
+    if (has_replay) {
+        replay_ui_event(service_id, &replay);
+    }
+}
+
+static void deactivate(activation_entry_t *entry)
+{
+    const system_service_activatable_t *desc = entry->desc;
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    
+    dependencies_mark_uninitialized(desc->name);
+    
+    if (desc->stop != NULL) {
+        desc->stop();
+    }
+    esp_err_t ret = desc->deinit();
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    entry->service_id = SYSTEM_SERVICE_ID_INVALID;
+    entry->state = ACTIVATION_INACTIVE;
+    if (entry->reactivate) {
+        entry->reactivate = false;
+        demand_locked(entry);
+    }
+    xSemaphoreGive(g_activation.lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Deinit of idle %s failed: %s", desc->name, esp_err_to_name(ret));
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Deactivated idle %s (%d bytes internal heap back)",
+             desc->name, (int)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) - free_before));
+}
+
+typedef struct {
+    system_context_t *ctx;
+    system_service_id_t owner;
+    uint32_t count;
+} foreign_count_t;
+
+static void count_foreign(system_event_type_t event_type, void *arg)
+{
+    foreign_count_t *fc = arg;
+    const event_type_entry_t *type = &fc->ctx->event_types[event_type];
+    
+    for (uint16_t i = type->first_subscription; i != SUBSCRIPTION_INDEX_NONE;
+         i = fc->ctx->subscriptions[i].next_in_type) {
+        system_service_id_t subscriber = fc->ctx->subscriptions[i].service_id;
+        if (subscriber != fc->owner && subscriber != g_activation.service_id) {
+            fc->count++;
+        }
+    }
+    
+    for (uint32_t mask = type->wildcard_mask; mask != 0; mask &= mask - 1) {
+        if (fc->ctx->wildcards[__builtin_ctz(mask)].service_id != fc->owner) {
+            fc->count++;
+        }
+    }
+}
+
+/**
+ * @brief Subscriptions to a service's topics by anyone but itself
+ */
+static uint32_t foreign_subscribers(const activation_entry_t *entry)
+{
+    if (entry->desc->topics == NULL) {
+        return 0;
+    }
+    
+    foreign_count_t fc = {
+        .ctx = system_get_context(),
+        .owner = entry->service_id,
+    };
+    if (system_lock() != ESP_OK) {
+        return 1;
+    }
+    topic_trie_match(entry->desc->topics, count_foreign, &fc);
+    system_unlock();
+    
+    return fc.count;
+}
+
+/**
+ * @brief Deactivate services that went idle
+ * @return Milliseconds until the next idle timeout, 0 if none is running
+ */
+static uint32_t idle_check(void)
+{
+#if CONFIG_SYSTEM_SERVICE_LAZY_ACTIVATION
+    uint32_t wait_ms = 0;
+    size_t count = entry_count();
+    
+    for (size_t i = 0; i < count; i++) {
+        activation_entry_t *entry = &g_activation.entries[i];
+        const system_service_activatable_t *desc = entry->desc;
+        if (desc->idle_timeout_ms == 0 || desc->deinit == NULL) {
+            continue;
+        }
+    
+        xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+        bool active = entry->state == ACTIVATION_ACTIVE;
+        uint32_t idle_ms = now_ms() - entry->last_used_ms;
+        xSemaphoreGive(g_activation.lock);
+        if (!active) {
+            continue;
+        }
+    
+        uint32_t remaining = 0;
+        bool stop = false;
+        if (idle_ms < desc->idle_timeout_ms) {
+            remaining = desc->idle_timeout_ms - idle_ms;
+        } else if ((desc->busy != NULL && desc->busy()) || foreign_subscribers(entry) > 0) {
+            xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+            entry->last_used_ms = now_ms();
+            xSemaphoreGive(g_activation.lock);
+            remaining = desc->idle_timeout_ms;
+        } else {
+            // Unless it was used since the check above
+            xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+            idle_ms = now_ms() - entry->last_used_ms;
+            if (idle_ms < desc->idle_timeout_ms) {
+                remaining = desc->idle_timeout_ms - idle_ms;
+            } else if (entry->state == ACTIVATION_ACTIVE) {
+                entry->state = ACTIVATION_STOPPING;
+                stop = true;
+            }
+            xSemaphoreGive(g_activation.lock);
+        }
+    
+        if (stop) {
+            deactivate(entry);
+        } else if (remaining > 0 && (wait_ms == 0 || remaining < wait_ms)) {
+            wait_ms = remaining;
+        }
+    }
+    
+    return wait_ms;
+#else
+    return 0;
+#endif
+}
+
+static activation_entry_t *claim_pending(void)
+{
+    activation_entry_t *claimed = NULL;
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    for (size_t i = 0; i < g_activation.count; i++) {
+        if (g_activation.entries[i].state == ACTIVATION_PENDING) {
+            claimed = &g_activation.entries[i];
+            claimed->state = ACTIVATION_STARTING;
+            break;
+        }
+    }
+    xSemaphoreGive(g_activation.lock);
+    
+    return claimed;
+}
+
+static void activation_task(void *arg)
+{
+    (void)arg;
+    
+    while (true) {
+        activation_entry_t *entry = claim_pending();
+        if (entry != NULL) {
+            activate(entry);
+            continue;
+        }
+    
+        uint32_t wait_ms = idle_check();
+    
+        xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+        bool pending = false;
+        for (size_t i = 0; i < g_activation.count; i++) {
+            pending |= g_activation.entries[i].state == ACTIVATION_PENDING;
+        }
+        if (wait_ms == 0 && !pending) {
+            // Demand from now on creates a new task
+            g_activation.task = NULL;
+            xSemaphoreGive(g_activation.lock);
+            vTaskDelete(NULL);
+            return;
+        }
+        xSemaphoreGive(g_activation.lock);
+    
+        if (!pending) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+        }
+    }
+}
+
+/* ============================================================================
+ * Triggers
+ * ============================================================================ */
+
+static void ui_event_handler(const system_event_t *event, void *user_data)
+{
+    (void)user_data;
+    size_t count = entry_count();
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        activation_entry_t *entry = &g_activation.entries[i];
+        if (entry->ui_event != event->event_type) {
+            continue;
+        }
+    
+        // Up already, the service had the event itself
+        if (entry->state != ACTIVATION_ACTIVE && !entry->has_replay &&
+            (event->data_size == 0 || system_event_data_retain(event) == ESP_OK)) {
+            entry->replay = *event;
+            entry->has_replay = true;
+        }
+        demand_locked(entry);
+    }
+    xSemaphoreGive(g_activation.lock);
+}
+
+void service_activation_on_subscribe(system_service_id_t subscriber,
+                                     system_event_type_t event_type)
+{
+    size_t count = entry_count();
+    if (count == 0 || subscriber == g_activation.service_id ||
+        event_type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+        return;
+    }
+    
+    // Type names never change once registered, no lock needed to read one
+    const char *name = system_get_context()->event_types[event_type].event_name;
+    
+    for (size_t i = 0; i < count; i++) {
+        activation_entry_t *entry = &g_activation.entries[i];
+        if (entry->desc->topics != NULL && topic_pattern_match(entry->desc->topics, name)) {
+            demand(entry);
+        }
+    }
+}
+
+typedef struct {
+    system_context_t *ctx;
+    const char *topics;
+    bool overlap;
+} pattern_overlap_t;
+
+static void check_overlap(system_event_type_t event_type, void *arg)
+{
+    pattern_overlap_t *po = arg;
+    if (!po->overlap) {
+        po->overlap = topic_pattern_match(po->topics, po->ctx->event_types[event_type].event_name);
+    }
+}
+
+void service_activation_on_pattern(system_service_id_t subscriber, const char *pattern)
+{
+    size_t count = entry_count();
+    if (count == 0 || subscriber == g_activation.service_id) {
+        return;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        activation_entry_t *entry = &g_activation.entries[i];
+        if (entry->desc->topics == NULL) {
+            continue;
+        }
+    
+        // Only registered types count, like for the subscription itself
+        pattern_overlap_t po = {
+            .ctx = system_get_context(),
+            .topics = entry->desc->topics,
+        };
+        if (system_lock() != ESP_OK) {
+            return;
+        }
+        topic_trie_match(pattern, check_overlap, &po);
+        system_unlock();
+    
+        if (po.overlap) {
+            demand(entry);
+        }
+    }
+}
+
+void service_activation_on_request(system_service_id_t target)
+{
+    size_t count = entry_count();
+    
+    // A stale read only misses one touch, the next request makes it
+    for (size_t i = 0; i < count; i++) {
+        activation_entry_t *entry = &g_activation.entries[i];
+        if (entry->state == ACTIVATION_ACTIVE && entry->service_id == target) {
+            __atomic_store_n(&entry->last_used_ms, now_ms(), __ATOMIC_RELAXED);
+            return;
+        }
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+esp_err_t service_activation_init(void)
+{
+    if (g_activation.lock == NULL) {
+        g_activation.lock = SYSTEM_MUTEX_CREATE(s_activation_lock);
+        if (g_activation.lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t system_service_register_activatable(const system_service_activatable_t *desc)
+{
+    if (desc == NULL || desc->name == NULL || desc->init == NULL ||
+        (desc->topics != NULL && !topic_pattern_valid(desc->topics))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (g_activation.lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    
+    if (find_entry_locked(desc->name) != NULL) {
+        xSemaphoreGive(g_activation.lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (g_activation.count >= SYSTEM_SERVICE_MAX_ACTIVATABLE) {
+        xSemaphoreGive(g_activation.lock);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    system_event_type_t ui_event = SYSTEM_EVENT_TYPE_INVALID;
+    if (desc->ui_event != NULL) {
+        esp_err_t ret = ESP_OK;
+        if (g_activation.service_id == SYSTEM_SERVICE_ID_INVALID) {
+            ret = system_service_register("activation", NULL, &g_activation.service_id);
+            if (ret == ESP_OK) {
+                system_service_set_state(g_activation.service_id, SYSTEM_SERVICE_STATE_RUNNING);
+            } else {
+                g_activation.service_id = SYSTEM_SERVICE_ID_INVALID;
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = system_event_register_type(desc->ui_event, &ui_event);
+        }
+        if (ret == ESP_OK) {
+            ret = system_event_subscribe(g_activation.service_id, ui_event, ui_event_handler, NULL);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot watch %s for %s: %s", desc->ui_event, desc->name,
+                     esp_err_to_name(ret));
+            xSemaphoreGive(g_activation.lock);
+            return ret;
+        }
+    }
+    
+    activation_entry_t *entry = &g_activation.entries[g_activation.count];
+    memset(entry, 0, sizeof(*entry));
+    entry->desc = desc;
+    entry->service_id = SYSTEM_SERVICE_ID_INVALID;
+    entry->ui_event = ui_event;
+    __atomic_store_n(&g_activation.count, g_activation.count + 1, __ATOMIC_RELEASE);
+    
+#if !CONFIG_SYSTEM_SERVICE_LAZY_ACTIVATION
+    demand_locked(entry);
+#endif
+    
+    xSemaphoreGive(g_activation.lock);
+    
+    ESP_LOGI(TAG, "%s activates on demand (topics %s, UI %s)", desc->name,
+             desc->topics ? desc->topics : "-", desc->ui_event ? desc->ui_event : "-");
+    
+    return ESP_OK;
+}
+
+esp_err_t system_service_activate(const char *service_name,
+                                  uint32_t timeout_ms,
+                                  system_service_id_t *out_service_id)
+{
+    if (service_name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (g_activation.lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    system_service_id_t service_id = SYSTEM_SERVICE_ID_INVALID;
+    
+    xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+    activation_entry_t *entry = find_entry_locked(service_name);
+    if (entry == NULL) {
+        xSemaphoreGive(g_activation.lock);
+        if (!lookup_service(service_name, &service_id)) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (out_service_id != NULL) {
+            *out_service_id = service_id;
+        }
+        return ESP_OK;
+    }
+    
+    demand_locked(entry);
+    
+    // From another service's init waiting would deadlock, so run it here
+    bool run_here = entry->state == ACTIVATION_PENDING &&
+                    g_activation.task == xTaskGetCurrentTaskHandle();
+    if (run_here) {
+        entry->state = ACTIVATION_STARTING;
+    }
+    xSemaphoreGive(g_activation.lock);
+    
+    if (run_here) {
+        activate(entry);
+    }
+    
+    TickType_t start = xTaskGetTickCount();
+    while (true) {
+        xSemaphoreTake(g_activation.lock, portMAX_DELAY);
+        activation_state_t state = entry->state;
+        esp_err_t last_error = entry->last_error;
+        service_id = entry->service_id;
+        xSemaphoreGive(g_activation.lock);
+    
+        if (state == ACTIVATION_ACTIVE) {
+            if (out_service_id != NULL) {
+                *out_service_id = service_id;
+            }
+            return ESP_OK;
+        }
+        if (state == ACTIVATION_FAILED) {
+            return last_error;
+        }
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms)) {
+            return ESP_ERR_TIMEOUT;
+        }
+    
+        // Activation takes hundreds of ms, polling costs nothing noticeable
+        vTaskDelay(pdMS_TO_TICKS(ACTIVATION_POLL_MS));
+    }
+}
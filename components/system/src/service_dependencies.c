@@ -1,6 +1,12 @@
 /**
  * @file service_dependencies.c
  * @brief Service dependency management implementation
+ * 
+ * Names are resolved to entry indices once, in dependencies_add(). Each
+ * entry keeps the indices of its dependents and a count of dependencies
+ * not yet initialized, so marking a service initialized only touches its
+ * direct dependents, and a dependent whose count drops to zero has its
+ * ready callback called.
  */
 
 #include "service_dependencies.h"
@@ -8,6 +14,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "system_service/error_codes.h"
+#include "system_service/static_alloc.h"
 #include <string.h>
 
 static const char *TAG = "dependencies";
@@ -19,7 +26,13 @@ static const char *TAG = "dependencies";
 typedef struct {
     char service_name[SYSTEM_SERVICE_MAX_NAME_LEN];
     char depends_on[SYSTEM_SERVICE_MAX_DEPENDENCIES][SYSTEM_SERVICE_MAX_NAME_LEN];
+    uint8_t dep_index[SYSTEM_SERVICE_MAX_DEPENDENCIES];   // Entry index of each depends_on
     uint8_t dependency_count;
+    uint8_t dependents[SYSTEM_SERVICE_MAX_SERVICES];      // Entries depending on this one
+    uint8_t dependent_count;
+    uint8_t pending;                                      // Dependencies not yet initialized
+    dependency_ready_cb_t ready_cb;
+    void *ready_user_data;
     bool initialized;
     bool visited;  // For cycle detection
     bool in_stack; // For cycle detection
@@ -37,6 +50,7 @@ typedef struct {
 } dependency_context_t;
 
 static dependency_context_t g_dep_ctx = {0};
+SYSTEM_MUTEX_DEFINE(s_dep_mutex);
 
 /* ============================================================================
  * Internal Helpers
@@ -52,6 +66,11 @@ static dependency_entry_t* find_entry(const char *service_name)
     return NULL;
 }
 
+static inline uint8_t entry_index(const dependency_entry_t *entry)
+{
+    return (uint8_t)(entry - g_dep_ctx.entries);
+}
+
 static dependency_entry_t* create_entry(const char *service_name)
 {
     if (g_dep_ctx.entry_count >= SYSTEM_SERVICE_MAX_SERVICES) {
@@ -62,6 +81,10 @@ static dependency_entry_t* create_entry(const char *service_name)
     strncpy(entry->service_name, service_name, SYSTEM_SERVICE_MAX_NAME_LEN - 1);
     entry->service_name[SYSTEM_SERVICE_MAX_NAME_LEN - 1] = '\0';
     entry->dependency_count = 0;
+    entry->dependent_count = 0;
+    entry->pending = 0;
+    entry->ready_cb = NULL;
+    entry->ready_user_data = NULL;
     entry->initialized = false;
     entry->visited = false;
     entry->in_stack = false;
@@ -87,8 +110,7 @@ static bool has_cycle_dfs(dependency_entry_t *entry)
     
     // Check all dependencies
     for (int i = 0; i < entry->dependency_count; i++) {
-        dependency_entry_t *dep = find_entry(entry->depends_on[i]);
-        if (dep != NULL && has_cycle_dfs(dep)) {
+        if (has_cycle_dfs(&g_dep_ctx.entries[entry->dep_index[i]])) {
             return true;
         }
     }
@@ -110,16 +132,40 @@ static void topo_sort_dfs(dependency_entry_t *entry, const char **order, size_t
     
     // Visit dependencies first
     for (int i = 0; i < entry->dependency_count; i++) {
-        dependency_entry_t *dep = find_entry(entry->depends_on[i]);
-        if (dep != NULL) {
-            topo_sort_dfs(dep, order, index);
-        }
+        topo_sort_dfs(&g_dep_ctx.entries[entry->dep_index[i]], order, index);
     }
     
     // Add this service to order
     order[(*index)++] = entry->service_name;
 }
 
+/** A ready callback due, called once the mutex is released */
+typedef struct {
+    dependency_ready_cb_t cb;
+    void *user_data;
+    const char *service_name;
+} ready_call_t;
+
+/**
+ * @brief Queue the entry's ready callback if it has become ready (mutex held)
+ */
+static void collect_ready(dependency_entry_t *entry, ready_call_t *calls, size_t *count)
+{
+    if (entry->pending == 0 && entry->ready_cb != NULL) {
+        calls[*count].cb = entry->ready_cb;
+        calls[*count].user_data = entry->ready_user_data;
+        calls[*count].service_name = entry->service_name;
+        (*count)++;
+    }
+}
+
+static void run_ready_calls(const ready_call_t *calls, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        calls[i].cb(calls[i].service_name, calls[i].user_data);
+    }
+}
+
 /* ============================================================================
  * Public API Implementation
  * ============================================================================ */
@@ -132,7 +178,7 @@ esp_err_t dependencies_init(void)
     
     ESP_LOGI(TAG, "Initializing dependency system...");
     
-    g_dep_ctx.mutex = xSemaphoreCreateMutex();
+    g_dep_ctx.mutex = SYSTEM_MUTEX_CREATE(s_dep_mutex);
     if (g_dep_ctx.mutex == NULL) {
         return ESP_ERR_NO_MEM;
     }
@@ -197,15 +243,21 @@ esp_err_t dependencies_add(const char *service_name, const char *depends_on)
         return ESP_ERR_NO_MEM;
     }
     
+    // Ensure dependency service exists in graph
+    dependency_entry_t *dep = find_entry(depends_on);
+    if (dep == NULL) {
+        dep = create_entry(depends_on);
+        if (dep == NULL) {
+            xSemaphoreGive(g_dep_ctx.mutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
     strncpy(entry->depends_on[entry->dependency_count], depends_on, SYSTEM_SERVICE_MAX_NAME_LEN - 1);
     entry->depends_on[entry->dependency_count][SYSTEM_SERVICE_MAX_NAME_LEN - 1] = '\0';
+    entry->dep_index[entry->dependency_count] = entry_index(dep);
     entry->dependency_count++;
     
-    // Ensure dependency service exists in graph
-    if (find_entry(depends_on) == NULL) {
-        create_entry(depends_on);
-    }
-    
     // Check for circular dependencies
     // Reset visited flags
     for (int i = 0; i < g_dep_ctx.entry_count; i++) {
@@ -221,6 +273,12 @@ esp_err_t dependencies_add(const char *service_name, const char *depends_on)
         return ESP_ERR_SERVICE_CIRCULAR_DEPENDENCY;
     }
     
+    // Link the reverse edge only once the edge is known to stay
+    dep->dependents[dep->dependent_count++] = entry_index(entry);
+    if (!dep->initialized) {
+        entry->pending++;
+    }
+    
     xSemaphoreGive(g_dep_ctx.mutex);
     
     ESP_LOGI(TAG, "Added dependency: %s depends on %s", service_name, depends_on);
@@ -289,15 +347,10 @@ esp_err_t dependencies_check_ready(const char *service_name)
         return ESP_OK; // No dependencies
     }
     
-    // Check if all dependencies are initialized
-    for (int i = 0; i < entry->dependency_count; i++) {
-        dependency_entry_t *dep = find_entry(entry->depends_on[i]);
-        if (dep == NULL || !dep->initialized) {
-            xSemaphoreGive(g_dep_ctx.mutex);
-            ESP_LOGW(TAG, "Service %s waiting for dependency: %s", 
-                     service_name, entry->depends_on[i]);
-            return ESP_ERR_SERVICE_DEPENDENCY_FAILED;
-        }
+    if (entry->pending > 0) {
+        xSemaphoreGive(g_dep_ctx.mutex);
+        ESP_LOGD(TAG, "Service %s waiting for %u dependencies", service_name, entry->pending);
+        return ESP_ERR_SERVICE_DEPENDENCY_FAILED;
     }
     
     xSemaphoreGive(g_dep_ctx.mutex);
@@ -314,13 +367,87 @@ esp_err_t dependencies_mark_initialized(const char *service_name)
         return ESP_ERR_TIMEOUT;
     }
     
+    ready_call_t calls[SYSTEM_SERVICE_MAX_SERVICES];
+    size_t call_count = 0;
+    
     dependency_entry_t *entry = find_entry(service_name);
-    if (entry != NULL) {
+    if (entry != NULL && !entry->initialized) {
         entry->initialized = true;
+    
+        for (int i = 0; i < entry->dependent_count; i++) {
+            dependency_entry_t *dependent = &g_dep_ctx.entries[entry->dependents[i]];
+            dependent->pending--;
+            collect_ready(dependent, calls, &call_count);
+        }
         ESP_LOGI(TAG, "Service %s marked as initialized", service_name);
     }
     
     xSemaphoreGive(g_dep_ctx.mutex);
+    
+    run_ready_calls(calls, call_count);
+    return ESP_OK;
+}
+
+esp_err_t dependencies_mark_uninitialized(const char *service_name)
+{
+    if (!g_dep_ctx.initialized || service_name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (xSemaphoreTake(g_dep_ctx.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    dependency_entry_t *entry = find_entry(service_name);
+    if (entry != NULL && entry->initialized) {
+        entry->initialized = false;
+    
+        for (int i = 0; i < entry->dependent_count; i++) {
+            g_dep_ctx.entries[entry->dependents[i]].pending++;
+        }
+        ESP_LOGI(TAG, "Service %s marked as not initialized", service_name);
+    }
+    
+    xSemaphoreGive(g_dep_ctx.mutex);
+    return ESP_OK;
+}
+
+esp_err_t dependencies_set_ready_callback(const char *service_name,
+                                          dependency_ready_cb_t callback,
+                                          void *user_data)
+{
+    if (!g_dep_ctx.initialized || service_name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (xSemaphoreTake(g_dep_ctx.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    dependency_entry_t *entry = find_entry(service_name);
+    if (entry == NULL) {
+        if (callback == NULL) {
+            xSemaphoreGive(g_dep_ctx.mutex);
+            return ESP_OK;
+        }
+        entry = create_entry(service_name);
+        if (entry == NULL) {
+            xSemaphoreGive(g_dep_ctx.mutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    entry->ready_cb = callback;
+    entry->ready_user_data = user_data;
+    
+    // Already ready: call it now rather than never
+    ready_call_t call;
+    size_t call_count = 0;
+    collect_ready(entry, &call, &call_count);
+    
+    xSemaphoreGive(g_dep_ctx.mutex);
+    
+    run_ready_calls(&call, call_count);
     return ESP_OK;
 }
 
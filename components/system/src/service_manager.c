@@ -1,12 +1,28 @@
 #include "system_service/service_manager.h"
 #include "system_internal.h"
 #include "service_watchdog.h"
+#include "metrics_registry.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include <string.h>
 
 static const char *TAG = "service_manager";
 
+/* ============================================================================
+ * Shared Heartbeat Timer
+ * ============================================================================ */
+
+typedef struct {
+    bool enabled;
+    system_service_heartbeat_probe_t probe;
+    void *user_data;
+} heartbeat_probe_entry_t;
+
+static heartbeat_probe_entry_t g_heartbeat_probes[SYSTEM_SERVICE_MAX_SERVICES] = {0};
+static portMUX_TYPE g_heartbeat_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t g_heartbeat_timer = NULL;
+static uint32_t g_heartbeat_probe_count = 0;
+
 esp_err_t system_service_register(const char *service_name,
                                    void *service_context,
                                    system_service_id_t *out_service_id)
@@ -61,7 +77,8 @@ esp_err_t system_service_register(const char *service_name,
     ctx->services[slot].service_context = service_context;
     ctx->services[slot].last_heartbeat = (uint32_t)(esp_timer_get_time() / 1000);
     ctx->services[slot].registered = true;
-    ctx->services[slot].event_count = 0;
+    metrics_registry_reset_service((system_service_id_t)slot);
+    metrics_registry_service_state(SYSTEM_SERVICE_STATE_UNREGISTERED, SYSTEM_SERVICE_STATE_REGISTERED);
     
     *out_service_id = ctx->services[slot].service_id;
     ctx->service_count++;
@@ -94,19 +111,18 @@ esp_err_t system_service_unregister(system_service_id_t service_id)
         return ESP_ERR_NOT_FOUND;
     }
     
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_SUBSCRIBERS; i++) {
-        if (ctx->subscriptions[i].active &&
-            ctx->subscriptions[i].service_id == service_id) {
-            ctx->subscriptions[i].active = false;
-            ctx->subscription_count--;
-        }
-    }
+    system_subscription_drop_service(ctx, service_id);
+    metrics_registry_service_state(ctx->services[service_id].state, SYSTEM_SERVICE_STATE_UNREGISTERED);
+    metrics_registry_reset_service(service_id);
     
     memset(&ctx->services[service_id], 0, sizeof(service_entry_t));
+    ctx->services[service_id].first_subscription = SUBSCRIPTION_INDEX_NONE;
     ctx->service_count--;
     
     system_unlock();
     
+    system_service_disable_auto_heartbeat(service_id);
+    
     ESP_LOGI(TAG, "Service ID %d unregistered", service_id);
     
     return ESP_OK;
@@ -134,6 +150,7 @@ esp_err_t system_service_set_state(system_service_id_t service_id,
         return ESP_ERR_NOT_FOUND;
     }
     
+    metrics_registry_service_state(ctx->services[service_id].state, state);
     ctx->services[service_id].state = state;
     
     system_unlock();
@@ -185,6 +202,55 @@ esp_err_t system_service_heartbeat(system_service_id_t service_id)
         return ESP_ERR_INVALID_ARG;
     }
     
+    // Lock-free so heartbeats from hot loops never contend on the system mutex
+    if (!__atomic_load_n(&ctx->services[service_id].registered, __ATOMIC_ACQUIRE)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint32_t timestamp = (uint32_t)(esp_timer_get_time() / 1000);
+    __atomic_store_n(&ctx->services[service_id].last_heartbeat, timestamp, __ATOMIC_RELAXED);
+    
+    // Update watchdog timestamp
+    watchdog_update_heartbeat(service_id, timestamp);
+    
+    return ESP_OK;
+}
+
+static void heartbeat_timer_callback(void *arg)
+{
+    system_context_t *ctx = system_get_context();
+    
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        portENTER_CRITICAL(&g_heartbeat_lock);
+        heartbeat_probe_entry_t entry = g_heartbeat_probes[i];
+        portEXIT_CRITICAL(&g_heartbeat_lock);
+        
+        if (!entry.enabled || ctx->services[i].state != SYSTEM_SERVICE_STATE_RUNNING) {
+            continue;
+        }
+        
+        if (entry.probe != NULL && !entry.probe(entry.user_data)) {
+            ESP_LOGW(TAG, "Service %d failed its liveness probe", i);
+            continue;
+        }
+        
+        system_service_heartbeat((system_service_id_t)i);
+    }
+}
+
+esp_err_t system_service_enable_auto_heartbeat(system_service_id_t service_id,
+                                               system_service_heartbeat_probe_t probe,
+                                               void *user_data)
+{
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     esp_err_t ret = system_lock();
     if (ret != ESP_OK) {
         return ret;
@@ -195,17 +261,73 @@ esp_err_t system_service_heartbeat(system_service_id_t service_id)
         return ESP_ERR_NOT_FOUND;
     }
     
-    uint32_t timestamp = (uint32_t)(esp_timer_get_time() / 1000);
-    ctx->services[service_id].last_heartbeat = timestamp;
+    // One timer for every service, created on first use
+    if (g_heartbeat_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = heartbeat_timer_callback,
+            .name = "svc_heartbeat",
+        };
+        ret = esp_timer_create(&args, &g_heartbeat_timer);
+        if (ret != ESP_OK) {
+            system_unlock();
+            ESP_LOGE(TAG, "Failed to create heartbeat timer: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
     
-    system_unlock();
+    portENTER_CRITICAL(&g_heartbeat_lock);
+    bool was_enabled = g_heartbeat_probes[service_id].enabled;
+    g_heartbeat_probes[service_id].probe = probe;
+    g_heartbeat_probes[service_id].user_data = user_data;
+    g_heartbeat_probes[service_id].enabled = true;
+    portEXIT_CRITICAL(&g_heartbeat_lock);
+    
+    if (!was_enabled && g_heartbeat_probe_count++ == 0) {
+        ret = esp_timer_start_periodic(g_heartbeat_timer,
+                                       (uint64_t)CONFIG_SYSTEM_SERVICE_HEARTBEAT_PROBE_INTERVAL_MS * 1000);
+        if (ret != ESP_OK) {
+            g_heartbeat_probe_count--;
+            portENTER_CRITICAL(&g_heartbeat_lock);
+            g_heartbeat_probes[service_id].enabled = false;
+            portEXIT_CRITICAL(&g_heartbeat_lock);
+            system_unlock();
+            ESP_LOGE(TAG, "Failed to start heartbeat timer: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
     
-    // Update watchdog timestamp
-    watchdog_update_heartbeat(service_id, timestamp);
+    system_unlock();
     
+    ESP_LOGD(TAG, "Service %d heartbeats from the shared timer", service_id);
     return ESP_OK;
 }
 
+esp_err_t system_service_disable_auto_heartbeat(system_service_id_t service_id)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = system_lock();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    portENTER_CRITICAL(&g_heartbeat_lock);
+    bool was_enabled = g_heartbeat_probes[service_id].enabled;
+    memset(&g_heartbeat_probes[service_id], 0, sizeof(heartbeat_probe_entry_t));
+    portEXIT_CRITICAL(&g_heartbeat_lock);
+    
+    // Idle timer costs nothing once stopped
+    if (was_enabled && --g_heartbeat_probe_count == 0) {
+        esp_timer_stop(g_heartbeat_timer);
+    }
+    
+    system_unlock();
+    
+    return was_enabled ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 esp_err_t system_service_get_info(system_service_id_t service_id,
                                    system_service_info_t *out_info)
 {
@@ -1,6 +1,12 @@
 /**
  * @file service_watchdog.c
  * @brief Service watchdog implementation with automatic recovery
+ * 
+ * Entries are indexed by service ID and their next check time is kept in
+ * a min-heap, so the task sleeps until the earliest deadline instead of
+ * scanning on a fixed interval. Heartbeats are plain atomic stores that
+ * never touch the heap or the mutex; a popped deadline whose heartbeat
+ * moved on is simply rescheduled.
  */
 
 #include "service_watchdog.h"
@@ -12,6 +18,12 @@
 #include "freertos/semphr.h"
 #include "system_service/error_codes.h"
 #include "system_service/service_manager.h"
+#include "system_service/static_alloc.h"
+#include "system_service/system_trace.h"
+#include "system_service/flight_recorder.h"
+#include "system_service/common_events.h"
+#include "system_service/event_bus.h"
+#include <stdio.h>
 #include <string.h>
 
 static const char *TAG = "watchdog";
@@ -20,15 +32,22 @@ static const char *TAG = "watchdog";
  * Watchdog Entry Structure
  * ============================================================================ */
 
+#define WATCHDOG_NOT_QUEUED         0xFF
+
 typedef struct {
-    bool active;                        /**< Entry is active */
+    bool active;                        /**< Entry is registered */
+    bool enabled;                       /**< Monitoring enabled */
     system_service_id_t service_id;     /**< Service being monitored */
     service_watchdog_config_t config;   /**< Watchdog configuration */
-    uint32_t last_heartbeat;            /**< Last heartbeat timestamp */
+    uint32_t last_heartbeat;            /**< Last heartbeat timestamp (atomic) */
+    uint32_t deadline;                  /**< Next check time (ms) */
+    uint8_t heap_index;                 /**< Position in deadline heap */
     uint8_t restart_attempts;           /**< Current restart attempts */
     bool timeout_detected;              /**< Timeout currently detected */
 } watchdog_entry_t;
 
+_Static_assert(SYSTEM_SERVICE_MAX_SERVICES < WATCHDOG_NOT_QUEUED, "heap index must fit 8 bits");
+
 /* ============================================================================
  * Global State
  * ============================================================================ */
@@ -39,12 +58,22 @@ typedef struct {
     TaskHandle_t task_handle;           /**< Watchdog task handle */
     SemaphoreHandle_t mutex;            /**< Mutex for thread safety */
     watchdog_entry_t entries[SYSTEM_SERVICE_MAX_SERVICES];
+    uint8_t heap[SYSTEM_SERVICE_MAX_SERVICES];  /**< Service IDs ordered by deadline */
+    uint32_t heap_size;
     watchdog_stats_t stats;             /**< Global statistics */
     bool safe_mode;                     /**< System in safe mode */
 } watchdog_context_t;
 
 static watchdog_context_t g_watchdog_ctx = {0};
 
+/** Sender of the timeout and safe mode events, registered while running */
+static system_service_id_t g_watchdog_service = SYSTEM_SERVICE_ID_INVALID;
+
+#define WATCHDOG_TASK_STACK_SIZE    4096
+
+SYSTEM_MUTEX_DEFINE(s_watchdog_mutex);
+SYSTEM_TASK_DEFINE(s_watchdog_task, WATCHDOG_TASK_STACK_SIZE);
+
 /* ============================================================================
  * Forward Declarations
  * ============================================================================ */
@@ -64,23 +93,108 @@ static inline uint32_t get_time_ms(void)
 
 static watchdog_entry_t* find_entry(system_service_id_t service_id)
 {
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
-        if (g_watchdog_ctx.entries[i].active && 
-            g_watchdog_ctx.entries[i].service_id == service_id) {
-            return &g_watchdog_ctx.entries[i];
-        }
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES || !g_watchdog_ctx.entries[service_id].active) {
+        return NULL;
     }
-    return NULL;
+    return &g_watchdog_ctx.entries[service_id];
 }
 
-static watchdog_entry_t* allocate_entry(void)
+/* ============================================================================
+ * Deadline Heap (mutex held)
+ * ============================================================================ */
+
+static inline bool deadline_before(uint32_t a, uint32_t b)
 {
-    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
-        if (!g_watchdog_ctx.entries[i].active) {
-            return &g_watchdog_ctx.entries[i];
+    return (int32_t)(a - b) < 0;
+}
+
+static inline bool heap_less(uint32_t i, uint32_t j)
+{
+    return deadline_before(g_watchdog_ctx.entries[g_watchdog_ctx.heap[i]].deadline,
+                           g_watchdog_ctx.entries[g_watchdog_ctx.heap[j]].deadline);
+}
+
+static void heap_swap(uint32_t i, uint32_t j)
+{
+    uint8_t *heap = g_watchdog_ctx.heap;
+    uint8_t tmp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = tmp;
+    g_watchdog_ctx.entries[heap[i]].heap_index = (uint8_t)i;
+    g_watchdog_ctx.entries[heap[j]].heap_index = (uint8_t)j;
+}
+
+static void heap_sift_up(uint32_t i)
+{
+    while (i > 0 && heap_less(i, (i - 1) / 2)) {
+        heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void heap_sift_down(uint32_t i)
+{
+    while (true) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = i;
+        
+        if (left < g_watchdog_ctx.heap_size && heap_less(left, smallest)) {
+            smallest = left;
+        }
+        if (right < g_watchdog_ctx.heap_size && heap_less(right, smallest)) {
+            smallest = right;
         }
+        if (smallest == i) {
+            return;
+        }
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+static void heap_push(watchdog_entry_t *entry)
+{
+    uint32_t i = g_watchdog_ctx.heap_size++;
+    g_watchdog_ctx.heap[i] = entry->service_id;
+    entry->heap_index = (uint8_t)i;
+    heap_sift_up(i);
+}
+
+static void heap_remove(watchdog_entry_t *entry)
+{
+    uint32_t i = entry->heap_index;
+    if (i == WATCHDOG_NOT_QUEUED) {
+        return;
+    }
+    
+    uint32_t last = --g_watchdog_ctx.heap_size;
+    if (i != last) {
+        heap_swap(i, last);
+        heap_sift_down(i);
+        heap_sift_up(i);
+    }
+    entry->heap_index = WATCHDOG_NOT_QUEUED;
+}
+
+/**
+ * @brief Queue an entry for its next check at deadline
+ */
+static void schedule_entry(watchdog_entry_t *entry, uint32_t deadline)
+{
+    heap_remove(entry);
+    entry->deadline = deadline;
+    heap_push(entry);
+}
+
+/**
+ * @brief Wake the watchdog task to recompute its sleep
+ */
+static void wake_watchdog_task(void)
+{
+    if (g_watchdog_ctx.running && g_watchdog_ctx.task_handle != NULL) {
+        xTaskNotifyGive(g_watchdog_ctx.task_handle);
     }
-    return NULL;
 }
 
 /* ============================================================================
@@ -132,117 +246,157 @@ static void enter_safe_mode(const char *reason)
     
     g_watchdog_ctx.safe_mode = true;
     g_watchdog_ctx.stats.safe_mode_active = true;
+    SYSTEM_TRACE(SYSTEM_TRACE_WATCHDOG, SYSTEM_SERVICE_ID_INVALID, SYSTEM_TRACE_WATCHDOG_SAFE_MODE);
     g_watchdog_ctx.stats.critical_failures++;
+    flight_recorder_mark(reason);
+    
+    // CRITICAL: handlers hear of it ahead of any backlog
+    if (g_watchdog_service != SYSTEM_SERVICE_ID_INVALID) {
+        common_safe_mode_t info;
+        strlcpy(info.reason, reason, sizeof(info.reason));
+        SYSTEM_EVENT_POST_TYPED(g_watchdog_service, COMMON_EVENT_SAFE_MODE,
+                                &info, SYSTEM_EVENT_PRIORITY_CRITICAL);
+    }
     
     // TODO: Implement safe mode actions:
     // - Stop non-critical services
     // - Disable event processing
     // - Enter minimal operation mode
-    // - Log diagnostic information
+    // - Log diagnostic information (the flight recorder has the lead-up)
 }
 
 /* ============================================================================
  * Watchdog Task
  * ============================================================================ */
 
-static void watchdog_task(void *arg)
+/**
+ * @brief Check one entry whose deadline passed and schedule the next check
+ */
+static void check_entry(watchdog_entry_t *entry, uint32_t now)
 {
-    ESP_LOGI(TAG, "Watchdog task started");
+    const uint32_t recheck_ms = CONFIG_SYSTEM_SERVICE_WATCHDOG_CHECK_INTERVAL_MS;
     
-    const uint32_t check_interval_ms = CONFIG_SYSTEM_SERVICE_WATCHDOG_CHECK_INTERVAL_MS;
+    uint32_t last_heartbeat = __atomic_load_n(&entry->last_heartbeat, __ATOMIC_RELAXED);
     
-    while (g_watchdog_ctx.running) {
-        uint32_t now = get_time_ms();
-        
-        // Lock mutex
-        if (xSemaphoreTake(g_watchdog_ctx.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-            ESP_LOGW(TAG, "Failed to acquire watchdog mutex");
-            vTaskDelay(pdMS_TO_TICKS(check_interval_ms));
-            continue;
+    // Signed: a heartbeat stored after 'now' was read is not a timeout
+    int32_t elapsed = (int32_t)(now - last_heartbeat);
+    
+    if (elapsed <= (int32_t)entry->config.timeout_ms) {
+        // Service is healthy
+        if (entry->timeout_detected) {
+            ESP_LOGI(TAG, "Service %d recovered", entry->service_id);
+            SYSTEM_TRACE(SYSTEM_TRACE_WATCHDOG, entry->service_id, SYSTEM_TRACE_WATCHDOG_RECOVERED);
+            entry->timeout_detected = false;
+            entry->restart_attempts = 0;
         }
-        
-        // Check all monitored services
-        for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
-            watchdog_entry_t *entry = &g_watchdog_ctx.entries[i];
-            
-            if (!entry->active) {
-                continue;
-            }
+        schedule_entry(entry, last_heartbeat + entry->config.timeout_ms + 1);
+        return;
+    }
+    
+    // Still timed out: look again for recovery after the recheck interval
+    schedule_entry(entry, now + recheck_ms);
+    
+    if (entry->timeout_detected) {
+        return;
+    }
+    
+    // First timeout detection
+    entry->timeout_detected = true;
+    g_watchdog_ctx.stats.total_timeouts++;
+    SYSTEM_TRACE(SYSTEM_TRACE_WATCHDOG, entry->service_id, SYSTEM_TRACE_WATCHDOG_TIMEOUT);
+    
+    ESP_LOGW(TAG, "Service %d timeout detected (elapsed=%lu ms, timeout=%lu ms)",
+             entry->service_id, (uint32_t)elapsed, entry->config.timeout_ms);
+    
+    if (g_watchdog_service != SYSTEM_SERVICE_ID_INVALID) {
+        common_watchdog_timeout_t info = {
+            .service_id = entry->service_id,
+            .elapsed_ms = (uint32_t)elapsed,
+            .timeout_ms = entry->config.timeout_ms,
+            .critical = entry->config.is_critical,
+        };
+        SYSTEM_EVENT_POST_TYPED(g_watchdog_service, COMMON_EVENT_WATCHDOG_TIMEOUT,
+                                &info, SYSTEM_EVENT_PRIORITY_CRITICAL);
+    }
+    
+    // Handle timeout based on configuration
+    if (entry->config.is_critical) {
+        // Critical service - enter safe mode
+        char reason[64];
+        snprintf(reason, sizeof(reason), "Critical service %d timeout", entry->service_id);
+        enter_safe_mode(reason);
+    } else if (entry->config.auto_restart) {
+        // Check restart attempts
+        if (entry->config.max_restart_attempts == 0 || 
+            entry->restart_attempts < entry->config.max_restart_attempts) {
             
-            // Calculate time since last heartbeat
-            uint32_t elapsed = now - entry->last_heartbeat;
+            // Attempt restart
+            entry->restart_attempts++;
+            g_watchdog_ctx.stats.total_restarts++;
             
-            // Check for timeout
-            if (elapsed > entry->config.timeout_ms) {
-                if (!entry->timeout_detected) {
-                    // First timeout detection
-                    entry->timeout_detected = true;
-                    g_watchdog_ctx.stats.total_timeouts++;
-                    
-                    ESP_LOGW(TAG, "Service %d timeout detected (elapsed=%lu ms, timeout=%lu ms)",
-                             entry->service_id, elapsed, entry->config.timeout_ms);
-                    
-                    // Handle timeout based on configuration
-                    if (entry->config.is_critical) {
-                        // Critical service - enter safe mode
-                        char reason[64];
-                        snprintf(reason, sizeof(reason), "Critical service %d timeout", entry->service_id);
-                        enter_safe_mode(reason);
-                    } else if (entry->config.auto_restart) {
-                        // Check restart attempts
-                        if (entry->config.max_restart_attempts == 0 || 
-                            entry->restart_attempts < entry->config.max_restart_attempts) {
-                            
-                            // Attempt restart
-                            entry->restart_attempts++;
-                            g_watchdog_ctx.stats.total_restarts++;
-                            
-                            esp_err_t ret = restart_service(entry->service_id);
-                            if (ret != ESP_OK) {
-                                ESP_LOGE(TAG, "Service %d restart failed (attempt %d)",
-                                         entry->service_id, entry->restart_attempts);
-                                g_watchdog_ctx.stats.failed_restarts++;
-                                
-                                // Check if max attempts reached
-                                if (entry->config.max_restart_attempts > 0 &&
-                                    entry->restart_attempts >= entry->config.max_restart_attempts) {
-                                    ESP_LOGE(TAG, "Service %d exceeded max restart attempts",
-                                             entry->service_id);
-                                    // Mark as critical failure
-                                    g_watchdog_ctx.stats.critical_failures++;
-                                }
-                            } else {
-                                ESP_LOGI(TAG, "Service %d restart initiated (attempt %d)",
-                                         entry->service_id, entry->restart_attempts);
-                                // Reset heartbeat timestamp
-                                entry->last_heartbeat = now;
-                                entry->timeout_detected = false;
-                            }
-                        } else {
-                            ESP_LOGE(TAG, "Service %d exceeded max restart attempts (%d)",
-                                     entry->service_id, entry->config.max_restart_attempts);
-                        }
-                    } else {
-                        ESP_LOGW(TAG, "Service %d timeout (auto-restart disabled)", entry->service_id);
-                    }
+            esp_err_t ret = restart_service(entry->service_id);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Service %d restart failed (attempt %d)",
+                         entry->service_id, entry->restart_attempts);
+                g_watchdog_ctx.stats.failed_restarts++;
+                SYSTEM_TRACE(SYSTEM_TRACE_WATCHDOG, entry->service_id, SYSTEM_TRACE_WATCHDOG_RESTART_FAILED);
+                
+                // Check if max attempts reached
+                if (entry->config.max_restart_attempts > 0 &&
+                    entry->restart_attempts >= entry->config.max_restart_attempts) {
+                    ESP_LOGE(TAG, "Service %d exceeded max restart attempts",
+                             entry->service_id);
+                    // Mark as critical failure
+                    g_watchdog_ctx.stats.critical_failures++;
                 }
             } else {
-                // Service is healthy
-                if (entry->timeout_detected) {
-                    ESP_LOGI(TAG, "Service %d recovered", entry->service_id);
-                    entry->timeout_detected = false;
-                    entry->restart_attempts = 0;
-                }
+                ESP_LOGI(TAG, "Service %d restart initiated (attempt %d)",
+                         entry->service_id, entry->restart_attempts);
+                SYSTEM_TRACE(SYSTEM_TRACE_WATCHDOG, entry->service_id, SYSTEM_TRACE_WATCHDOG_RESTART);
+                // Reset heartbeat timestamp
+                __atomic_store_n(&entry->last_heartbeat, now, __ATOMIC_RELAXED);
+                entry->timeout_detected = false;
+                schedule_entry(entry, now + entry->config.timeout_ms + 1);
             }
+        } else {
+            ESP_LOGE(TAG, "Service %d exceeded max restart attempts (%d)",
+                     entry->service_id, entry->config.max_restart_attempts);
         }
+    } else {
+        ESP_LOGW(TAG, "Service %d timeout (auto-restart disabled)", entry->service_id);
+    }
+}
+
+static void watchdog_task(void *arg)
+{
+    ESP_LOGI(TAG, "Watchdog task started");
+    
+    while (g_watchdog_ctx.running) {
+        TickType_t wait = portMAX_DELAY;
         
-        xSemaphoreGive(g_watchdog_ctx.mutex);
+        if (xSemaphoreTake(g_watchdog_ctx.mutex, portMAX_DELAY) == pdTRUE) {
+            uint32_t now = get_time_ms();
+            
+            // Handle every deadline that passed
+            while (g_watchdog_ctx.heap_size > 0) {
+                watchdog_entry_t *entry = &g_watchdog_ctx.entries[g_watchdog_ctx.heap[0]];
+                if (deadline_before(now, entry->deadline)) {
+                    // Sleep until it; +1 since the tick conversion rounds down
+                    wait = pdMS_TO_TICKS(entry->deadline - now) + 1;
+                    break;
+                }
+                check_entry(entry, now);
+            }
+            
+            xSemaphoreGive(g_watchdog_ctx.mutex);
+        }
         
-        // Sleep until next check
-        vTaskDelay(pdMS_TO_TICKS(check_interval_ms));
+        // Registration changes notify us to recompute the deadline
+        ulTaskNotifyTake(pdTRUE, wait);
     }
     
     ESP_LOGI(TAG, "Watchdog task stopped");
+    g_watchdog_ctx.task_handle = NULL;
     vTaskDelete(NULL);
 }
 
@@ -259,7 +413,7 @@ esp_err_t watchdog_init(void)
     ESP_LOGI(TAG, "Initializing watchdog system...");
     
     // Create mutex
-    g_watchdog_ctx.mutex = xSemaphoreCreateMutex();
+    g_watchdog_ctx.mutex = SYSTEM_MUTEX_CREATE(s_watchdog_mutex);
     if (g_watchdog_ctx.mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create watchdog mutex");
         return ESP_ERR_NO_MEM;
@@ -267,6 +421,10 @@ esp_err_t watchdog_init(void)
     
     // Initialize entries
     memset(g_watchdog_ctx.entries, 0, sizeof(g_watchdog_ctx.entries));
+    for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
+        g_watchdog_ctx.entries[i].heap_index = WATCHDOG_NOT_QUEUED;
+    }
+    g_watchdog_ctx.heap_size = 0;
     memset(&g_watchdog_ctx.stats, 0, sizeof(watchdog_stats_t));
     
     g_watchdog_ctx.initialized = true;
@@ -289,13 +447,22 @@ esp_err_t watchdog_start(void)
     
     ESP_LOGI(TAG, "Starting watchdog monitoring...");
     
+    // Timeouts are still handled without it, just not announced
+    if (system_service_register("watchdog", NULL, &g_watchdog_service) == ESP_OK) {
+        system_service_set_state(g_watchdog_service, SYSTEM_SERVICE_STATE_RUNNING);
+    } else {
+        ESP_LOGW(TAG, "Failed to register watchdog service, timeout events disabled");
+        g_watchdog_service = SYSTEM_SERVICE_ID_INVALID;
+    }
+    
     g_watchdog_ctx.running = true;
     
     // Create watchdog task
-    BaseType_t ret = xTaskCreate(
+    BaseType_t ret = SYSTEM_TASK_CREATE(
+        s_watchdog_task,
         watchdog_task,
         "watchdog",
-        4096,
+        WATCHDOG_TASK_STACK_SIZE,
         NULL,
         CONFIG_SYSTEM_SERVICE_WATCHDOG_TASK_PRIORITY,
         &g_watchdog_ctx.task_handle
@@ -304,6 +471,10 @@ esp_err_t watchdog_start(void)
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create watchdog task");
         g_watchdog_ctx.running = false;
+        if (g_watchdog_service != SYSTEM_SERVICE_ID_INVALID) {
+            system_service_unregister(g_watchdog_service);
+            g_watchdog_service = SYSTEM_SERVICE_ID_INVALID;
+        }
         return ESP_ERR_NO_MEM;
     }
     
@@ -320,10 +491,18 @@ esp_err_t watchdog_stop(void)
     ESP_LOGI(TAG, "Stopping watchdog monitoring...");
     
     g_watchdog_ctx.running = false;
+    if (g_watchdog_ctx.task_handle != NULL) {
+        xTaskNotifyGive(g_watchdog_ctx.task_handle);
+    }
     
     // Wait for task to exit
     vTaskDelay(pdMS_TO_TICKS(100));
     
+    if (g_watchdog_service != SYSTEM_SERVICE_ID_INVALID) {
+        system_service_unregister(g_watchdog_service);
+        g_watchdog_service = SYSTEM_SERVICE_ID_INVALID;
+    }
+    
     ESP_LOGI(TAG, "Watchdog monitoring stopped");
     return ESP_OK;
 }
@@ -362,23 +541,24 @@ esp_err_t watchdog_register_service(system_service_id_t service_id,
         return ESP_ERR_TIMEOUT;
     }
     
-    // Check if already registered
-    if (find_entry(service_id) != NULL) {
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
         xSemaphoreGive(g_watchdog_ctx.mutex);
-        return ESP_ERR_INVALID_STATE;
+        return ESP_ERR_INVALID_ARG;
     }
     
-    // Allocate entry
-    watchdog_entry_t *entry = allocate_entry();
-    if (entry == NULL) {
+    // Check if already registered
+    if (find_entry(service_id) != NULL) {
         xSemaphoreGive(g_watchdog_ctx.mutex);
-        return ESP_ERR_NO_MEM;
+        return ESP_ERR_INVALID_STATE;
     }
     
     // Initialize entry
+    watchdog_entry_t *entry = &g_watchdog_ctx.entries[service_id];
+    uint32_t now = get_time_ms();
     entry->active = true;
+    entry->enabled = true;
     entry->service_id = service_id;
-    entry->last_heartbeat = get_time_ms();
+    __atomic_store_n(&entry->last_heartbeat, now, __ATOMIC_RELAXED);
     entry->restart_attempts = 0;
     entry->timeout_detected = false;
     
@@ -392,6 +572,9 @@ esp_err_t watchdog_register_service(system_service_id_t service_id,
         entry->config.is_critical = false;
     }
     
+    schedule_entry(entry, now + entry->config.timeout_ms + 1);
+    wake_watchdog_task();
+    
     xSemaphoreGive(g_watchdog_ctx.mutex);
     
     ESP_LOGI(TAG, "Service %d registered with watchdog (timeout=%lu ms, auto_restart=%d)",
@@ -416,7 +599,9 @@ esp_err_t watchdog_unregister_service(system_service_id_t service_id)
         return ESP_ERR_NOT_FOUND;
     }
     
+    heap_remove(entry);
     entry->active = false;
+    entry->enabled = false;
     
     xSemaphoreGive(g_watchdog_ctx.mutex);
     
@@ -430,17 +615,13 @@ esp_err_t watchdog_update_heartbeat(system_service_id_t service_id, uint32_t tim
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (xSemaphoreTake(g_watchdog_ctx.mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        // Don't block on heartbeat updates
-        return ESP_ERR_TIMEOUT;
-    }
-    
-    watchdog_entry_t *entry = find_entry(service_id);
-    if (entry != NULL) {
-        entry->last_heartbeat = timestamp;
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    xSemaphoreGive(g_watchdog_ctx.mutex);
+    // Lock-free: the task compares against this when the deadline comes up
+    __atomic_store_n(&g_watchdog_ctx.entries[service_id].last_heartbeat, timestamp,
+                     __ATOMIC_RELAXED);
     
     return ESP_OK;
 }
@@ -461,8 +642,13 @@ esp_err_t watchdog_enable_service(system_service_id_t service_id)
         return ESP_ERR_NOT_FOUND;
     }
     
-    entry->active = true;
-    entry->last_heartbeat = get_time_ms();
+    if (!entry->enabled) {
+        uint32_t now = get_time_ms();
+        entry->enabled = true;
+        __atomic_store_n(&entry->last_heartbeat, now, __ATOMIC_RELAXED);
+        schedule_entry(entry, now + entry->config.timeout_ms + 1);
+        wake_watchdog_task();
+    }
     
     xSemaphoreGive(g_watchdog_ctx.mutex);
     
@@ -485,7 +671,9 @@ esp_err_t watchdog_disable_service(system_service_id_t service_id)
         return ESP_ERR_NOT_FOUND;
     }
     
-    entry->active = false;
+    // Stays registered, just leaves the heap
+    heap_remove(entry);
+    entry->enabled = false;
     
     xSemaphoreGive(g_watchdog_ctx.mutex);
     
@@ -554,7 +742,7 @@ void watchdog_log_status(const char *tag)
     // Count monitored services
     uint32_t monitored = 0;
     for (int i = 0; i < SYSTEM_SERVICE_MAX_SERVICES; i++) {
-        if (g_watchdog_ctx.entries[i].active) {
+        if (g_watchdog_ctx.entries[i].active && g_watchdog_ctx.entries[i].enabled) {
             monitored++;
         }
     }
@@ -0,0 +1,584 @@
+/**
+ * @file system_bench.c
+ * @brief Micro-benchmarks of the system service hot paths
+ *
+ * Timings use esp_timer (microseconds). Per-operation costs below a
+ * microsecond are taken over a whole loop and reported in nanoseconds;
+ * round trips are sampled one by one and reported as min/avg/p50/p99/max.
+ *
+ * Handlers signal the benchmark task through a binary semaphore, never
+ * its notification value, which request_send_sync() uses.
+ */
+
+#include "system_bench.h"
+#include "system_service/service_manager.h"
+#include "system_service/event_bus.h"
+#include "system_service/system_metrics.h"
+#include "memory_pool.h"
+#include "request_response.h"
+#include "handler_monitor.h"
+#include "resource_quota.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_app_desc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_SYSTEM_SERVICE_BENCHMARK
+
+static const char *TAG = "bench";
+
+#define ITERATIONS          CONFIG_SYSTEM_SERVICE_BENCHMARK_ITERATIONS
+#define MAX_SUBSCRIBERS     CONFIG_SYSTEM_SERVICE_BENCHMARK_SUBSCRIBERS
+#define WAIT_TICKS          pdMS_TO_TICKS(1000)
+#define REQUEST_TIMEOUT_MS  1000
+#define POOL_BLOCK_SIZE     64
+
+typedef struct {
+    system_service_id_t self;
+    system_service_id_t subs[MAX_SUBSCRIBERS];
+    size_t sub_count;
+    
+    system_event_type_t latency_type;
+    system_event_type_t throughput_type;
+    system_event_type_t request_type;
+    system_event_type_t direct_type;
+    
+    SemaphoreHandle_t done;
+    uint32_t *samples;
+    
+    volatile uint32_t last_latency_us;
+    volatile uint32_t delivered;
+    uint32_t expected;
+} bench_ctx_t;
+
+typedef struct {
+    bench_ctx_t *ctx;
+    SemaphoreHandle_t start;
+    uint32_t elapsed_us;
+    uint32_t failures;
+    volatile bool finished;
+} pool_worker_t;
+
+static bench_ctx_t s_bench;
+static pool_worker_t s_pool_workers[portNUM_PROCESSORS];
+
+static void report(const char *group, const char *metric, uint32_t value, const char *unit)
+{
+    printf("BENCH,%s,%s,%lu,%s\n", group, metric, (unsigned long)value, unit);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Report a sampled series as min/avg/p50/p99/max (sorts it)
+ */
+static void report_samples(const char *group, uint32_t *samples, size_t count, const char *unit)
+{
+    if (count == 0) {
+        report(group, "samples", 0, "count");
+        return;
+    }
+    
+    qsort(samples, count, sizeof(samples[0]), compare_u32);
+    
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    
+    report(group, "samples", count, "count");
+    report(group, "min", samples[0], unit);
+    report(group, "avg", (uint32_t)(sum / count), unit);
+    report(group, "p50", samples[count / 2], unit);
+    report(group, "p99", samples[(count * 99) / 100], unit);
+    report(group, "max", samples[count - 1], unit);
+}
+
+static uint32_t ns_per_op(int64_t elapsed_us, uint32_t ops)
+{
+    return ops > 0 ? (uint32_t)((uint64_t)elapsed_us * 1000 / ops) : 0;
+}
+
+/**
+ * @brief Post, retrying while the queue or a credit limit pushes back
+ */
+static esp_err_t post_blocking(system_event_type_t type, system_event_priority_t priority)
+{
+    for (int attempt = 0; attempt < 10; attempt++) {
+        esp_err_t ret = system_event_post(s_bench.self, type, NULL, 0, priority);
+        if (ret == ESP_OK) {
+            return ESP_OK;
+        }
+        vTaskDelay(1);
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+/* ============================================================================
+ * Handlers
+ * ============================================================================ */
+
+static void latency_handler(const system_event_t *event, void *user_data)
+{
+    bench_ctx_t *ctx = (bench_ctx_t *)user_data;
+    ctx->last_latency_us = (uint32_t)esp_timer_get_time() - event->post_time_us;
+    xSemaphoreGive(ctx->done);
+}
+
+static void throughput_handler(const system_event_t *event, void *user_data)
+{
+    bench_ctx_t *ctx = (bench_ctx_t *)user_data;
+    if (__atomic_add_fetch(&ctx->delivered, 1, __ATOMIC_RELAXED) == ctx->expected) {
+        xSemaphoreGive(ctx->done);
+    }
+}
+
+static void request_handler(const system_event_t *event, void *user_data)
+{
+    const request_header_t *header;
+    const void *payload;
+    size_t size;
+    
+    if (request_parse(event, &header, &payload, &size) == ESP_OK) {
+        request_send_response(header->request_id, payload, size);
+    }
+}
+
+static esp_err_t direct_handler(const request_header_t *header,
+                                const void *request_data,
+                                size_t request_size,
+                                void *response_data,
+                                size_t *response_size,
+                                void *user_data)
+{
+    if (request_size > *response_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(response_data, request_data, request_size);
+    *response_size = request_size;
+    return ESP_OK;
+}
+
+static void noop_handler(const system_event_t *event, void *user_data)
+{
+    __atomic_add_fetch((volatile uint32_t *)user_data, 1, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * Benchmarks
+ * ============================================================================ */
+
+static void bench_latency(bench_ctx_t *ctx)
+{
+    static const struct {
+        system_event_priority_t priority;
+        const char *group;
+    } levels[] = {
+        { SYSTEM_EVENT_PRIORITY_LOW,      "latency_low" },
+        { SYSTEM_EVENT_PRIORITY_NORMAL,   "latency_normal" },
+        { SYSTEM_EVENT_PRIORITY_HIGH,     "latency_high" },
+        { SYSTEM_EVENT_PRIORITY_CRITICAL, "latency_critical" },
+    };
+    
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        size_t count = 0;
+        xSemaphoreTake(ctx->done, 0);
+    
+        for (int i = 0; i < ITERATIONS; i++) {
+            if (post_blocking(ctx->latency_type, levels[l].priority) != ESP_OK) {
+                break;
+            }
+            if (xSemaphoreTake(ctx->done, WAIT_TICKS) != pdTRUE) {
+                ESP_LOGW(TAG, "%s: event %d not delivered", levels[l].group, i);
+                break;
+            }
+            ctx->samples[count++] = ctx->last_latency_us;
+        }
+    
+        report_samples(levels[l].group, ctx->samples, count, "us");
+    }
+}
+
+static void bench_throughput_run(bench_ctx_t *ctx, size_t subscribers, const char *group)
+{
+    for (size_t s = 0; s < subscribers; s++) {
+        system_event_subscribe(ctx->subs[s], ctx->throughput_type, throughput_handler, ctx);
+    }
+    
+    ctx->delivered = 0;
+    ctx->expected = ITERATIONS * subscribers;
+    xSemaphoreTake(ctx->done, 0);
+    
+    uint32_t posted = 0;
+    int64_t start = esp_timer_get_time();
+    for (; posted < ITERATIONS; posted++) {
+        if (post_blocking(ctx->throughput_type, SYSTEM_EVENT_PRIORITY_NORMAL) != ESP_OK) {
+            break;
+        }
+    }
+    
+    bool complete = posted == ITERATIONS &&
+                    xSemaphoreTake(ctx->done, WAIT_TICKS * 5) == pdTRUE;
+    int64_t elapsed = esp_timer_get_time() - start;
+    uint32_t delivered = __atomic_load_n(&ctx->delivered, __ATOMIC_RELAXED);
+    
+    for (size_t s = 0; s < subscribers; s++) {
+        system_event_unsubscribe(ctx->subs[s], ctx->throughput_type);
+    }
+    
+    if (!complete) {
+        ESP_LOGW(TAG, "%s: %lu of %lu deliveries", group, delivered, ctx->expected);
+    }
+    
+    report(group, "subscribers", subscribers, "count");
+    report(group, "events", posted, "count");
+    report(group, "elapsed", (uint32_t)elapsed, "us");
+    if (elapsed > 0) {
+        report(group, "events_per_sec", (uint32_t)((uint64_t)posted * 1000000 / elapsed), "1/s");
+        report(group, "deliveries_per_sec", (uint32_t)((uint64_t)delivered * 1000000 / elapsed), "1/s");
+    }
+}
+
+static void bench_throughput(bench_ctx_t *ctx)
+{
+    bench_throughput_run(ctx, 1, "throughput_1");
+    if (ctx->sub_count > 1) {
+        bench_throughput_run(ctx, ctx->sub_count, "throughput_n");
+    }
+}
+
+static uint32_t pool_loop(uint32_t *out_failures)
+{
+    uint32_t failures = 0;
+    
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        void *block = memory_pool_alloc(POOL_BLOCK_SIZE);
+        if (block == NULL) {
+            failures++;
+            continue;
+        }
+        memory_pool_free(block);
+    }
+    
+    *out_failures = failures;
+    return (uint32_t)(esp_timer_get_time() - start);
+}
+
+static void pool_worker_task(void *arg)
+{
+    pool_worker_t *worker = (pool_worker_t *)arg;
+    
+    xSemaphoreTake(worker->start, portMAX_DELAY);
+    worker->elapsed_us = pool_loop(&worker->failures);
+    worker->finished = true;
+    xSemaphoreGive(worker->ctx->done);
+    
+    vTaskDelete(NULL);
+}
+
+static void bench_pool(bench_ctx_t *ctx)
+{
+    uint32_t failures;
+    uint32_t elapsed = pool_loop(&failures);
+    report("pool_single", "alloc_free", ns_per_op(elapsed, ITERATIONS), "ns");
+    report("pool_single", "failures", failures, "count");
+    
+    // One worker per core, released together
+    pool_worker_t *workers = s_pool_workers;
+    SemaphoreHandle_t start = xSemaphoreCreateCounting(portNUM_PROCESSORS, 0);
+    if (start == NULL) {
+        return;
+    }
+    xSemaphoreTake(ctx->done, 0);
+    
+    int created = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        workers[core] = (pool_worker_t){ .ctx = ctx, .start = start };
+        if (xTaskCreatePinnedToCore(pool_worker_task, "bench_pool", 3072, &workers[core],
+                                    uxTaskPriorityGet(NULL), NULL, core) == pdPASS) {
+            created++;
+        }
+    }
+    for (int i = 0; i < created; i++) {
+        xSemaphoreGive(start);
+    }
+    
+    uint32_t total_elapsed = 0;
+    uint32_t total_failures = 0;
+    int finished = 0;
+    while (finished < created && xSemaphoreTake(ctx->done, WAIT_TICKS * 5) == pdTRUE) {
+        finished++;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (workers[core].finished) {
+            total_elapsed += workers[core].elapsed_us;
+            total_failures += workers[core].failures;
+        }
+    }
+    
+    // A straggler still holds the start semaphore, leave it be
+    if (finished == created) {
+        vSemaphoreDelete(start);
+    } else {
+        ESP_LOGW(TAG, "pool_contended: %d of %d workers finished", finished, created);
+    }
+    
+    report("pool_contended", "tasks", finished, "count");
+    if (finished > 0) {
+        report("pool_contended", "alloc_free",
+               ns_per_op(total_elapsed, (uint32_t)ITERATIONS * finished), "ns");
+    }
+    report("pool_contended", "failures", total_failures, "count");
+}
+
+static void bench_request_run(bench_ctx_t *ctx, system_event_type_t type, const char *group)
+{
+    uint32_t request = 0;
+    uint32_t response;
+    size_t count = 0;
+    uint32_t failures = 0;
+    
+    for (int i = 0; i < ITERATIONS; i++) {
+        size_t response_size = sizeof(response);
+        request = (uint32_t)i;
+    
+        int64_t start = esp_timer_get_time();
+        esp_err_t ret = request_send_sync(ctx->self, ctx->subs[0], type,
+                                          &request, sizeof(request),
+                                          &response, &response_size, REQUEST_TIMEOUT_MS);
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    
+        if (ret != ESP_OK || response_size != sizeof(response) || response != request) {
+            failures++;
+            continue;
+        }
+        ctx->samples[count++] = elapsed;
+    }
+    
+    report(group, "failures", failures, "count");
+    report_samples(group, ctx->samples, count, "us");
+}
+
+static void bench_request(bench_ctx_t *ctx)
+{
+    if (system_event_subscribe(ctx->subs[0], ctx->request_type, request_handler, ctx) == ESP_OK) {
+        bench_request_run(ctx, ctx->request_type, "request_event");
+        system_event_unsubscribe(ctx->subs[0], ctx->request_type);
+    }
+    
+    if (request_register_handler(ctx->subs[0], ctx->direct_type, direct_handler, ctx) == ESP_OK) {
+        bench_request_run(ctx, ctx->direct_type, "request_direct");
+        request_unregister_handler(ctx->subs[0], ctx->direct_type);
+    }
+}
+
+static void bench_handler_monitor(bench_ctx_t *ctx)
+{
+    volatile uint32_t calls = 0;
+    system_event_t event = {
+        .event_type = ctx->latency_type,
+        .priority = SYSTEM_EVENT_PRIORITY_NORMAL,
+        .sender_id = ctx->self,
+    };
+    
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        noop_handler(&event, (void *)&calls);
+    }
+    uint32_t direct_ns = ns_per_op(esp_timer_get_time() - start, ITERATIONS);
+    
+    start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        handler_monitor_execute(noop_handler, &event, (void *)&calls, ctx->self);
+    }
+    uint32_t monitored_ns = ns_per_op(esp_timer_get_time() - start, ITERATIONS);
+    
+    report("handler_monitor", "direct", direct_ns, "ns");
+    report("handler_monitor", "monitored", monitored_ns, "ns");
+    report("handler_monitor", "overhead", monitored_ns > direct_ns ? monitored_ns - direct_ns : 0, "ns");
+}
+
+/* Upper bound of the bucket holding the given fraction of observations */
+static uint32_t histogram_percentile(const system_metric_snapshot_t *metric, uint32_t permille)
+{
+    uint64_t target = ((uint64_t)(uint32_t)metric->value * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int b = 0; b < SYSTEM_METRIC_HISTOGRAM_BUCKETS; b++) {
+        seen += metric->buckets[b];
+        if (seen >= target) {
+            return (b == SYSTEM_METRIC_HISTOGRAM_BUCKETS - 1) ? metric->max : (1u << b);
+        }
+    }
+    return metric->max;
+}
+
+/* The registry as it stands after the run, so runs can be compared on it too */
+static void bench_metrics(void)
+{
+    static system_metric_snapshot_t metrics[48];
+    size_t count = 0;
+    
+    if (system_metrics_snapshot(metrics, sizeof(metrics) / sizeof(metrics[0]), &count) != ESP_OK) {
+        return;
+    }
+    
+    char name[SYSTEM_METRIC_NAME_LEN + 8];
+    for (size_t i = 0; i < count; i++) {
+        const system_metric_snapshot_t *metric = &metrics[i];
+        if (metric->type != SYSTEM_METRIC_HISTOGRAM) {
+            report("metrics", metric->name, (uint32_t)metric->value, "count");
+            continue;
+        }
+        if (metric->value == 0) {
+            continue;
+        }
+        uint32_t observations = (uint32_t)metric->value;
+        snprintf(name, sizeof(name), "%s_count", metric->name);
+        report("metrics", name, observations, "count");
+        snprintf(name, sizeof(name), "%s_avg", metric->name);
+        report("metrics", name, metric->sum / observations, "value");
+        snprintf(name, sizeof(name), "%s_p50", metric->name);
+        report("metrics", name, histogram_percentile(metric, 500), "value");
+        snprintf(name, sizeof(name), "%s_p99", metric->name);
+        report("metrics", name, histogram_percentile(metric, 990), "value");
+        snprintf(name, sizeof(name), "%s_max", metric->name);
+        report("metrics", name, metric->max, "value");
+    }
+}
+
+/* ============================================================================
+ * Setup
+ * ============================================================================ */
+
+static void bench_reset(bench_ctx_t *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->self = SYSTEM_SERVICE_ID_INVALID;
+}
+
+static esp_err_t bench_setup(bench_ctx_t *ctx)
+{
+    bench_reset(ctx);
+    
+    esp_err_t ret = system_service_register("bench", ctx, &ctx->self);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register bench service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // Unlimited event rate, the benchmark is about the bus
+    service_quota_t quota;
+    if (quota_get(ctx->self, &quota) == ESP_OK) {
+        quota.max_events_per_sec = 0;
+        quota_set(ctx->self, &quota);
+    }
+    
+    // Take as many subscriber services as the registry has room for
+    for (size_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "bench_sub%u", (unsigned)i);
+        if (system_service_register(name, ctx, &ctx->subs[i]) != ESP_OK) {
+            break;
+        }
+        ctx->sub_count++;
+    }
+    if (ctx->sub_count == 0) {
+        ESP_LOGE(TAG, "No room for subscriber services");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ret = system_event_register_type("bench.latency", &ctx->latency_type);
+    if (ret == ESP_OK) {
+        ret = system_event_register_type("bench.throughput", &ctx->throughput_type);
+    }
+    if (ret == ESP_OK) {
+        ret = system_event_register_type("bench.request", &ctx->request_type);
+    }
+    if (ret == ESP_OK) {
+        ret = system_event_register_type("bench.request_direct", &ctx->direct_type);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register event types: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ctx->done = xSemaphoreCreateBinary();
+    ctx->samples = heap_caps_malloc(ITERATIONS * sizeof(uint32_t),
+                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ctx->samples == NULL) {
+        ctx->samples = malloc(ITERATIONS * sizeof(uint32_t));
+    }
+    if (ctx->done == NULL || ctx->samples == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    return system_event_subscribe(ctx->subs[0], ctx->latency_type, latency_handler, ctx);
+}
+
+static void bench_teardown(bench_ctx_t *ctx)
+{
+    for (size_t i = 0; i < ctx->sub_count; i++) {
+        system_service_unregister(ctx->subs[i]);
+    }
+    if (ctx->self != SYSTEM_SERVICE_ID_INVALID) {
+        system_service_unregister(ctx->self);
+    }
+    if (ctx->done != NULL) {
+        vSemaphoreDelete(ctx->done);
+    }
+    free(ctx->samples);
+    bench_reset(ctx);
+}
+
+esp_err_t system_bench_run(void)
+{
+    bench_ctx_t *ctx = &s_bench;
+    
+    esp_err_t ret = bench_setup(ctx);
+    if (ret != ESP_OK) {
+        bench_teardown(ctx);
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Running benchmarks: %d iterations, %u subscribers",
+             ITERATIONS, (unsigned)ctx->sub_count);
+    
+    const esp_app_desc_t *app = esp_app_get_description();
+    printf("BENCH,meta,version,%s,\n", app->version);
+    printf("BENCH,meta,idf,%s,\n", app->idf_ver);
+    report("meta", "iterations", ITERATIONS, "count");
+    
+    bench_latency(ctx);
+    bench_throughput(ctx);
+    bench_pool(ctx);
+    bench_request(ctx);
+    bench_handler_monitor(ctx);
+    bench_metrics();
+    
+    printf("BENCH,meta,done,1,\n");
+    
+    bench_teardown(ctx);
+    ESP_LOGI(TAG, "Benchmarks done");
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t system_bench_run(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_BENCHMARK
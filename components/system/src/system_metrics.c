@@ -0,0 +1,530 @@
+/**
+ * @file system_metrics.c
+ * @brief Metrics registry and snapshots implementation
+ *
+ * Metric values are updated with relaxed atomics and read the same way;
+ * a snapshot of a histogram can therefore be one observation apart
+ * between its count and its buckets. The registry lock only guards
+ * registration, never an update.
+ */
+
+#include "system_service/system_metrics.h"
+#include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "system_internal.h"
+#include "metrics_registry.h"
+#include "priority_queue.h"
+#include "memory_pool.h"
+#include "handler_monitor.h"
+#include "resource_quota.h"
+#include "service_watchdog.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+_Static_assert(MEMORY_POOL_SIZE_COUNT <= SYSTEM_METRICS_MAX_POOLS,
+               "SYSTEM_METRICS_MAX_POOLS is smaller than the pool size classes");
+
+#if CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+#define CUSTOM_METRICS          CONFIG_SYSTEM_SERVICE_MAX_METRICS
+#define CUSTOM_HISTOGRAMS       CONFIG_SYSTEM_SERVICE_MAX_HISTOGRAMS
+#else
+#define CUSTOM_METRICS          0
+#define CUSTOM_HISTOGRAMS       0
+#endif
+
+#define METRICS_MAX             (SYSTEM_METRIC_BUILTIN_COUNT + CUSTOM_METRICS)
+#define HISTOGRAMS_MAX          (1 + CUSTOM_HISTOGRAMS)     // SYSTEM_METRIC_HANDLER_US first
+#define HISTOGRAM_NONE          0xFF
+
+typedef struct {
+    uint32_t count;
+    uint32_t sum;
+    uint32_t max;
+    uint32_t buckets[SYSTEM_METRIC_HISTOGRAM_BUCKETS];
+    bool used;
+} metric_histogram_t;
+
+typedef struct {
+    char name[SYSTEM_METRIC_NAME_LEN];
+    bool active;
+    uint8_t type;                   // system_metric_type_t
+    uint8_t histogram;              // Index into s_histograms, HISTOGRAM_NONE otherwise
+    system_service_id_t owner;
+    int32_t value;
+} metric_entry_t;
+
+static metric_entry_t s_metrics[METRICS_MAX];
+static metric_histogram_t s_histograms[HISTOGRAMS_MAX];
+static uint32_t s_service_posted[SYSTEM_SERVICE_MAX_SERVICES];
+static uint32_t s_service_received[SYSTEM_SERVICE_MAX_SERVICES];
+static SemaphoreHandle_t s_registry_mutex = NULL;
+SYSTEM_MUTEX_DEFINE(s_registry_mutex_buf);
+
+static const struct {
+    const char *name;
+    system_metric_type_t type;
+} s_builtins[SYSTEM_METRIC_BUILTIN_COUNT] = {
+    [SYSTEM_METRIC_EVENTS_POSTED]    = { "events_posted",    SYSTEM_METRIC_COUNTER },
+    [SYSTEM_METRIC_EVENTS_PROCESSED] = { "events_processed", SYSTEM_METRIC_COUNTER },
+    [SYSTEM_METRIC_SERVICES]         = { "services",         SYSTEM_METRIC_GAUGE },
+    [SYSTEM_METRIC_SERVICES_RUNNING] = { "services_running", SYSTEM_METRIC_GAUGE },
+    [SYSTEM_METRIC_SERVICES_ERROR]   = { "services_error",   SYSTEM_METRIC_GAUGE },
+    [SYSTEM_METRIC_SUBSCRIPTIONS]    = { "subscriptions",    SYSTEM_METRIC_GAUGE },
+    [SYSTEM_METRIC_HANDLER_US]       = { "handler_us",       SYSTEM_METRIC_HISTOGRAM },
+    [SYSTEM_METRIC_DEADLINE_MISSES]  = { "deadline_misses",  SYSTEM_METRIC_COUNTER },
+    [SYSTEM_METRIC_EVENTS_FILTERED]  = { "events_filtered",  SYSTEM_METRIC_COUNTER },
+};
+
+/* ============================================================================
+ * Registry
+ * ============================================================================ */
+
+void metrics_registry_init(void)
+{
+    if (s_registry_mutex == NULL) {
+        s_registry_mutex = SYSTEM_MUTEX_CREATE(s_registry_mutex_buf);
+    }
+    
+    memset(s_metrics, 0, sizeof(s_metrics));
+    memset(s_histograms, 0, sizeof(s_histograms));
+    memset(s_service_posted, 0, sizeof(s_service_posted));
+    memset(s_service_received, 0, sizeof(s_service_received));
+    
+    for (int i = 0; i < SYSTEM_METRIC_BUILTIN_COUNT; i++) {
+        metric_entry_t *entry = &s_metrics[i];
+        strncpy(entry->name, s_builtins[i].name, sizeof(entry->name) - 1);
+        entry->type = (uint8_t)s_builtins[i].type;
+        entry->owner = SYSTEM_SERVICE_ID_INVALID;
+        entry->histogram = HISTOGRAM_NONE;
+        entry->active = true;
+    }
+    s_metrics[SYSTEM_METRIC_HANDLER_US].histogram = 0;
+    s_histograms[0].used = true;
+}
+
+static int find_locked(const char *name)
+{
+    for (int i = 0; i < METRICS_MAX; i++) {
+        if (s_metrics[i].active && strcmp(s_metrics[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void release_locked(int index)
+{
+    metric_entry_t *entry = &s_metrics[index];
+    if (entry->histogram != HISTOGRAM_NONE) {
+        s_histograms[entry->histogram].used = false;
+    }
+    memset(entry, 0, sizeof(*entry));
+}
+
+esp_err_t system_metric_register(system_service_id_t owner, const char *name,
+                                 system_metric_type_t type, system_metric_id_t *out_id)
+{
+    if (name == NULL || out_id == NULL || type > SYSTEM_METRIC_HISTOGRAM ||
+        name[0] == '\0' || strlen(name) >= SYSTEM_METRIC_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if !CONFIG_SYSTEM_SERVICE_ENABLE_METRICS
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (s_registry_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_registry_mutex, portMAX_DELAY);
+    
+    int index = find_locked(name);
+    if (index >= 0) {
+        xSemaphoreGive(s_registry_mutex);
+        if (s_metrics[index].type != type) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        *out_id = (system_metric_id_t)index;
+        return ESP_OK;
+    }
+    
+    for (int i = SYSTEM_METRIC_BUILTIN_COUNT; i < METRICS_MAX && index < 0; i++) {
+        if (!s_metrics[i].active) {
+            index = i;
+        }
+    }
+    
+    uint8_t histogram = HISTOGRAM_NONE;
+    if (index >= 0 && type == SYSTEM_METRIC_HISTOGRAM) {
+        for (int h = 1; h < HISTOGRAMS_MAX; h++) {
+            if (!s_histograms[h].used) {
+                histogram = (uint8_t)h;
+                break;
+            }
+        }
+    }
+    if (index < 0 || (type == SYSTEM_METRIC_HISTOGRAM && histogram == HISTOGRAM_NONE)) {
+        xSemaphoreGive(s_registry_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (histogram != HISTOGRAM_NONE) {
+        memset(&s_histograms[histogram], 0, sizeof(s_histograms[histogram]));
+        s_histograms[histogram].used = true;
+    }
+    
+    metric_entry_t *entry = &s_metrics[index];
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->type = (uint8_t)type;
+    entry->owner = owner;
+    entry->histogram = histogram;
+    entry->active = true;
+    
+    xSemaphoreGive(s_registry_mutex);
+    
+    *out_id = (system_metric_id_t)index;
+    return ESP_OK;
+#endif
+}
+
+esp_err_t system_metric_unregister(system_metric_id_t id)
+{
+    if (id < SYSTEM_METRIC_BUILTIN_COUNT || id >= METRICS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_registry_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_registry_mutex, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (s_metrics[id].active) {
+        release_locked(id);
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_registry_mutex);
+    
+    return ret;
+}
+
+esp_err_t system_metric_find(const char *name, system_metric_id_t *out_id)
+{
+    if (name == NULL || out_id == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_registry_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_registry_mutex, portMAX_DELAY);
+    int index = find_locked(name);
+    xSemaphoreGive(s_registry_mutex);
+    
+    if (index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *out_id = (system_metric_id_t)index;
+    return ESP_OK;
+}
+
+void metrics_registry_reset_service(system_service_id_t service_id)
+{
+    if (service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return;
+    }
+    
+    __atomic_store_n(&s_service_posted[service_id], 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_service_received[service_id], 0, __ATOMIC_RELAXED);
+    
+    if (s_registry_mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_registry_mutex, portMAX_DELAY);
+    for (int i = SYSTEM_METRIC_BUILTIN_COUNT; i < METRICS_MAX; i++) {
+        if (s_metrics[i].active && s_metrics[i].owner == service_id) {
+            release_locked(i);
+        }
+    }
+    xSemaphoreGive(s_registry_mutex);
+}
+
+/* ============================================================================
+ * Updates
+ * ============================================================================ */
+
+void system_metric_add(system_metric_id_t id, uint32_t delta)
+{
+    if (id < METRICS_MAX) {
+        __atomic_fetch_add((uint32_t *)&s_metrics[id].value, delta, __ATOMIC_RELAXED);
+    }
+}
+
+void system_metric_set(system_metric_id_t id, int32_t value)
+{
+    if (id < METRICS_MAX) {
+        __atomic_store_n(&s_metrics[id].value, value, __ATOMIC_RELAXED);
+    }
+}
+
+void system_metric_gauge_add(system_metric_id_t id, int32_t delta)
+{
+    if (id < METRICS_MAX) {
+        __atomic_fetch_add(&s_metrics[id].value, delta, __ATOMIC_RELAXED);
+    }
+}
+
+void system_metric_observe(system_metric_id_t id, uint32_t value)
+{
+    if (id >= METRICS_MAX || s_metrics[id].histogram == HISTOGRAM_NONE) {
+        return;
+    }
+    metric_histogram_t *histogram = &s_histograms[s_metrics[id].histogram];
+    
+    // Bucket i holds values below 2^i: 0 in bucket 0, 1 in 1, 2..3 in 2
+    int bucket = (value == 0) ? 0 : 32 - __builtin_clz(value);
+    if (bucket >= SYSTEM_METRIC_HISTOGRAM_BUCKETS) {
+        bucket = SYSTEM_METRIC_HISTOGRAM_BUCKETS - 1;
+    }
+    
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sum, value, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->buckets[bucket], 1, __ATOMIC_RELAXED);
+    
+    uint32_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    while (value > max &&
+           !__atomic_compare_exchange_n(&histogram->max, &max, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void metrics_registry_service_state(system_service_state_t from, system_service_state_t to)
+{
+    if (from == to) {
+        return;
+    }
+    
+    if (from == SYSTEM_SERVICE_STATE_UNREGISTERED) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES, 1);
+    } else if (from == SYSTEM_SERVICE_STATE_RUNNING) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES_RUNNING, -1);
+    } else if (from == SYSTEM_SERVICE_STATE_ERROR) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES_ERROR, -1);
+    }
+    
+    if (to == SYSTEM_SERVICE_STATE_UNREGISTERED) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES, -1);
+    } else if (to == SYSTEM_SERVICE_STATE_RUNNING) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES_RUNNING, 1);
+    } else if (to == SYSTEM_SERVICE_STATE_ERROR) {
+        system_metric_gauge_add(SYSTEM_METRIC_SERVICES_ERROR, 1);
+    }
+}
+
+void metrics_registry_service_posted(system_service_id_t service_id, uint32_t count)
+{
+    system_metric_add(SYSTEM_METRIC_EVENTS_POSTED, count);
+    if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        __atomic_fetch_add(&s_service_posted[service_id], count, __ATOMIC_RELAXED);
+    }
+}
+
+void metrics_registry_service_received(system_service_id_t service_id)
+{
+    if (service_id < SYSTEM_SERVICE_MAX_SERVICES) {
+        __atomic_fetch_add(&s_service_received[service_id], 1, __ATOMIC_RELAXED);
+    }
+}
+
+uint32_t metrics_registry_get_posted(system_service_id_t service_id)
+{
+    return service_id < SYSTEM_SERVICE_MAX_SERVICES ?
+           __atomic_load_n(&s_service_posted[service_id], __ATOMIC_RELAXED) : 0;
+}
+
+uint32_t metrics_registry_get_received(system_service_id_t service_id)
+{
+    return service_id < SYSTEM_SERVICE_MAX_SERVICES ?
+           __atomic_load_n(&s_service_received[service_id], __ATOMIC_RELAXED) : 0;
+}
+
+static int32_t metric_value(system_metric_id_t id)
+{
+    return __atomic_load_n(&s_metrics[id].value, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * Snapshots
+ * ============================================================================ */
+
+static void snapshot_entry(int index, system_metric_snapshot_t *out)
+{
+    const metric_entry_t *entry = &s_metrics[index];
+    
+    memset(out, 0, sizeof(*out));
+    memcpy(out->name, entry->name, sizeof(out->name));
+    out->type = (system_metric_type_t)entry->type;
+    out->owner = entry->owner;
+    
+    if (entry->histogram == HISTOGRAM_NONE) {
+        out->value = metric_value((system_metric_id_t)index);
+        return;
+    }
+    
+    const metric_histogram_t *histogram = &s_histograms[entry->histogram];
+    out->value = (int32_t)__atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    out->sum = __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+    out->max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    for (int b = 0; b < SYSTEM_METRIC_HISTOGRAM_BUCKETS; b++) {
+        out->buckets[b] = __atomic_load_n(&histogram->buckets[b], __ATOMIC_RELAXED);
+    }
+}
+
+esp_err_t system_metric_get(system_metric_id_t id, system_metric_snapshot_t *out_snapshot)
+{
+    if (out_snapshot == NULL || id >= METRICS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_metrics[id].active) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    snapshot_entry(id, out_snapshot);
+    return ESP_OK;
+}
+
+esp_err_t system_metrics_snapshot(system_metric_snapshot_t *out_snapshots,
+                                  size_t max_count,
+                                  size_t *out_count)
+{
+    if (out_snapshots == NULL || out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t count = 0;
+    for (int i = 0; i < METRICS_MAX && count < max_count; i++) {
+        if (s_metrics[i].active) {
+            snapshot_entry(i, &out_snapshots[count++]);
+        }
+    }
+    
+    *out_count = count;
+    return ESP_OK;
+}
+
+esp_err_t system_metrics_get_global(global_metrics_t *out_metrics)
+{
+    if (out_metrics == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(out_metrics, 0, sizeof(*out_metrics));
+    out_metrics->total_services = (uint32_t)metric_value(SYSTEM_METRIC_SERVICES);
+    out_metrics->running_services = (uint32_t)metric_value(SYSTEM_METRIC_SERVICES_RUNNING);
+    out_metrics->error_services = (uint32_t)metric_value(SYSTEM_METRIC_SERVICES_ERROR);
+    out_metrics->total_events_processed = (uint32_t)metric_value(SYSTEM_METRIC_EVENTS_PROCESSED);
+    priority_queue_handle_t queue = ctx->event_queue;
+    
+    system_event_latency_t latency;
+    if (system_event_get_latency(SYSTEM_EVENT_TYPE_INVALID, SYSTEM_EVENT_LATENCY_END_TO_END,
+                                 &latency) == ESP_OK) {
+        out_metrics->avg_event_latency_us = latency.avg_us;
+        out_metrics->max_event_latency_us = latency.max_us;
+    }
+    
+    event_queue_stats_t queue_stats;
+    if (queue != NULL && priority_queue_get_stats(queue, &queue_stats) == ESP_OK) {
+        out_metrics->event_queue_depth = queue_stats.high_priority_depth +
+                                         queue_stats.normal_priority_depth +
+                                         queue_stats.low_priority_depth;
+        out_metrics->event_queue_overflows = queue_stats.high_priority_overflows +
+                                             queue_stats.normal_priority_overflows +
+                                             queue_stats.low_priority_overflows;
+    }
+    
+    watchdog_stats_t watchdog;
+    if (watchdog_get_stats(&watchdog) == ESP_OK) {
+        out_metrics->service_restarts = watchdog.total_restarts;
+        out_metrics->watchdog_timeouts = watchdog.total_timeouts;
+    }
+    
+    out_metrics->free_heap_bytes = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    out_metrics->min_free_heap_bytes = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+    out_metrics->uptime_seconds = (uint32_t)(esp_timer_get_time() / 1000000);
+    
+    return ESP_OK;
+}
+
+esp_err_t system_metrics_get_service(system_service_id_t service_id,
+                                     service_metrics_t *out_metrics)
+{
+    if (out_metrics == NULL || service_id >= SYSTEM_SERVICE_MAX_SERVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized || !ctx->services[service_id].registered) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(out_metrics, 0, sizeof(*out_metrics));
+    out_metrics->total_events_posted = metrics_registry_get_posted(service_id);
+    out_metrics->total_events_received = metrics_registry_get_received(service_id);
+    
+    handler_monitor_get_stats(service_id, &out_metrics->avg_handler_time_us,
+                              &out_metrics->max_handler_time_us,
+                              &out_metrics->handler_timeouts);
+    
+    service_quota_usage_t usage;
+    if (quota_get_usage(service_id, &usage) == ESP_OK) {
+        out_metrics->quota_violations = usage.quota_violations;
+    }
+    
+    quota_memory_usage_t memory;
+    if (quota_get_memory_usage(service_id, &memory) == ESP_OK) {
+        out_metrics->total_memory_allocated = memory.internal_bytes + memory.psram_bytes;
+    }
+    
+    out_metrics->last_update_timestamp = (uint32_t)(esp_timer_get_time() / 1000);
+    return ESP_OK;
+}
+
+esp_err_t system_metrics_get_queue(event_queue_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    system_context_t *ctx = system_get_context();
+    if (!ctx->initialized || ctx->event_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    return priority_queue_get_stats(ctx->event_queue, out_stats);
+}
+
+esp_err_t system_metrics_get_pools(memory_pool_stats_t *out_stats,
+                                   size_t max_count,
+                                   size_t *out_count)
+{
+    if (out_stats == NULL || out_count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t count = 0;
+    for (int i = 0; i < MEMORY_POOL_SIZE_COUNT && count < max_count; i++) {
+        if (memory_pool_get_stats((memory_pool_size_t)i, &out_stats[count]) == ESP_OK) {
+            count++;
+        }
+    }
+    
+    *out_count = count;
+    return ESP_OK;
+}
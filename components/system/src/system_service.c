@@ -6,6 +6,11 @@
 #include "system_service/system_service.h"
 #include "system_service/memory_utils.h"
 #include "system_service/error_codes.h"
+#include "system_service/static_alloc.h"
+#include "system_service/boot_trace.h"
+#include "system_service/system_trace.h"
+#include "system_service/flight_recorder.h"
+#include "system_service/common_events.h"
 #include "system_internal.h"
 #include "security.h"
 #include "memory_pool.h"
@@ -13,8 +18,18 @@
 #include "resource_quota.h"
 #include "service_watchdog.h"
 #include "service_dependencies.h"
+#include "service_activation.h"
 #include "handler_monitor.h"
+#include "event_dispatch.h"
+#include "isr_event_ring.h"
+#include "event_credit.h"
+#include "event_latency.h"
+#include "heap_monitor.h"
+#include "log_control.h"
+#include "settings_store.h"
+#include "metrics_registry.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -22,81 +37,337 @@
 static const char *TAG = "system_service";
 static system_context_t g_system_ctx = {0};
 
-/* Event processing task with production features */
+SYSTEM_MUTEX_DEFINE(s_system_mutex);
+SYSTEM_TASK_DEFINE(s_event_task, CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE);
+SYSTEM_SEMAPHORE_DEFINE(s_event_task_exit);
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+SYSTEM_TASK_DEFINE(s_critical_task, CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE);
+SYSTEM_SEMAPHORE_DEFINE(s_critical_task_exit);
+#endif
+
+/* Given by a routing task once it has left its loop, see task_park() */
+static SemaphoreHandle_t s_event_task_exited;
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+static SemaphoreHandle_t s_critical_task_exited;
+#endif
+
+/* Handlers matched for the events being dispatched, copied out under the lock */
+typedef struct {
+    system_service_id_t service_id;
+    system_event_handler_t handler;
+    void *user_data;
+    system_event_filter_t filter;
+    system_event_affinity_t affinity;
+} dispatch_target_t;
+
+/* Slice of the batch's targets belonging to one of its events */
+typedef struct {
+    uint16_t first;
+    uint16_t count;
+} dispatch_range_t;
+
+/*
+ * A subscription slot belongs to exactly one type, and events of a type
+ * already seen in the batch reuse its slice, so a batch never needs more
+ * than SYSTEM_SERVICE_MAX_SUBSCRIBERS targets for them. A wildcard can
+ * match every distinct type of the batch, once each.
+ */
+#define DISPATCH_TARGETS_MAX(events) \
+    (SYSTEM_SERVICE_MAX_SUBSCRIBERS + SYSTEM_SERVICE_MAX_WILDCARDS * (events))
+
+typedef struct {
+    system_event_t *events;
+    dispatch_range_t *ranges;
+    dispatch_target_t *targets;
+    uint16_t capacity;              /**< Entries of targets */
+} dispatch_batch_t;
+
+static dispatch_target_t s_dispatch_targets[DISPATCH_TARGETS_MAX(SYSTEM_EVENT_BATCH_MAX)];
+static system_event_t s_batch_events[SYSTEM_EVENT_BATCH_MAX];
+static dispatch_range_t s_batch_ranges[SYSTEM_EVENT_BATCH_MAX];
+
+static const dispatch_batch_t s_batch = {
+    .events = s_batch_events,
+    .ranges = s_batch_ranges,
+    .targets = s_dispatch_targets,
+    .capacity = DISPATCH_TARGETS_MAX(SYSTEM_EVENT_BATCH_MAX),
+};
+
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+/* The critical task's own batch of one, resolved while the event task runs */
+static dispatch_target_t s_critical_targets[DISPATCH_TARGETS_MAX(1)];
+static system_event_t s_critical_event;
+static dispatch_range_t s_critical_range;
+
+static const dispatch_batch_t s_critical_batch = {
+    .events = &s_critical_event,
+    .ranges = &s_critical_range,
+    .targets = s_critical_targets,
+    .capacity = DISPATCH_TARGETS_MAX(1),
+};
+#endif
+
+/* Optimistic copies attempted before falling back to the system lock */
+#define DISPATCH_READ_RETRIES  4
+
+/* Copy the subscriber slice for every event of the batch */
+static void resolve_batch_targets(system_context_t *ctx, const dispatch_batch_t *batch, size_t count)
+{
+    uint16_t used = 0;
+    
+    for (size_t e = 0; e < count; e++) {
+        system_event_type_t type = batch->events[e].event_type;
+    
+        batch->ranges[e].first = used;
+        batch->ranges[e].count = 0;
+    
+        if (type >= SYSTEM_SERVICE_MAX_EVENT_TYPES) {
+            continue;
+        }
+    
+        // Same type earlier in the batch - share its slice
+        bool shared = false;
+        for (size_t prev = 0; prev < e; prev++) {
+            if (batch->events[prev].event_type == type) {
+                batch->ranges[e] = batch->ranges[prev];
+                shared = true;
+                break;
+            }
+        }
+        if (shared) {
+            continue;
+        }
+    
+        // Walk only this type's subscriber chain instead of every slot
+        for (uint16_t i = ctx->event_types[type].first_subscription;
+             i != SUBSCRIPTION_INDEX_NONE && used < batch->capacity;
+             i = ctx->subscriptions[i].next_in_type) {
+            batch->targets[used].service_id = ctx->subscriptions[i].service_id;
+            batch->targets[used].handler = ctx->subscriptions[i].handler;
+            batch->targets[used].user_data = ctx->subscriptions[i].user_data;
+            batch->targets[used].filter = ctx->subscriptions[i].filter;
+            batch->targets[used].affinity = ctx->subscriptions[i].affinity;
+            used++;
+        }
+    
+        // Then the wildcards, already matched against this type
+        uint32_t wildcards = ctx->event_types[type].wildcard_mask;
+        while (wildcards != 0 && used < batch->capacity) {
+            const topic_wildcard_t *wildcard = &ctx->wildcards[__builtin_ctz(wildcards)];
+            wildcards &= wildcards - 1;
+            batch->targets[used] = (dispatch_target_t) {
+                .service_id = wildcard->service_id,
+                .handler = wildcard->handler,
+                .user_data = wildcard->user_data,
+            };
+            used++;
+        }
+        batch->ranges[e].count = used - batch->ranges[e].first;
+    }
+}
+
+/*
+ * Subscriber chains are read under their sequence lock, so posters and
+ * the event task no longer contend on the system mutex. Only a reader that
+ * keeps racing subscribe/unsubscribe takes the lock, which also lets a
+ * preempted writer run to completion.
+ */
+static void resolve_batch(system_context_t *ctx, const dispatch_batch_t *batch, size_t count)
+{
+    for (size_t e = 0; e < count; e++) {
+        // Latest-value markers pick up their pending value here
+        if (!system_event_take_latest(ctx, &batch->events[e])) {
+            batch->events[e].event_type = SYSTEM_EVENT_TYPE_INVALID;
+        }
+    }
+    
+    for (int attempt = 0; attempt < DISPATCH_READ_RETRIES; attempt++) {
+        uint32_t seq = system_subscription_read_begin(ctx);
+        resolve_batch_targets(ctx, batch, count);
+        if (!system_subscription_read_retry(ctx, seq)) {
+            return;
+        }
+    }
+    
+    if (system_lock() == ESP_OK) {
+        resolve_batch_targets(ctx, batch, count);
+        system_unlock();
+        return;
+    }
+    
+    // Chains unreadable - drop the batch rather than use a torn copy
+    ESP_LOGW(TAG, "Subscriber table busy, dropping %u events", (unsigned)count);
+    for (size_t e = 0; e < count; e++) {
+        batch->ranges[e].count = 0;
+    }
+}
+
+/* Whether a subscription's filter lets the event through, see system_event_subscribe_filtered() */
+static inline bool filter_accepts(const dispatch_target_t *target, const system_event_t *event)
+{
+    const system_event_filter_t *filter = &target->filter;
+    
+    if (filter->sender_mask != 0 &&
+        (event->sender_id >= 64 || (filter->sender_mask & SYSTEM_EVENT_SENDER_BIT(event->sender_id)) == 0)) {
+        return false;
+    }
+    
+    if (filter->match_size != 0) {
+        if (event->data == NULL ||
+            event->data_size < (size_t)filter->match_offset + filter->match_size) {
+            return false;
+        }
+        // Little-endian: the low bytes of value hold a 1 or 2 byte field
+        uint32_t value = 0;
+        memcpy(&value, (const uint8_t *)event->data + filter->match_offset, filter->match_size);
+        if (value != filter->match_value) {
+            return false;
+        }
+    }
+    
+    return filter->predicate == NULL || filter->predicate(event, target->user_data);
+}
+
+/*
+ * Routing tasks run on static TCBs and stacks, which must not be handed to
+ * a new task until the old one is fully deleted. So a task leaving its
+ * loop only reports it and parks; task_join() deletes it from the stopping
+ * side, after which the storage is free again.
+ */
+static void task_park(SemaphoreHandle_t exited)
+{
+    xSemaphoreGive(exited);
+    vTaskSuspend(NULL);
+}
+
+static void task_join(TaskHandle_t *task, SemaphoreHandle_t *exited)
+{
+    xSemaphoreTake(*exited, portMAX_DELAY);
+    vTaskDelete(*task);
+    *task = NULL;
+    vSemaphoreDelete(*exited);
+    *exited = NULL;
+}
+
+/* Event routing task: resolves subscribers and feeds the dispatch workers */
 static void event_task(void *arg)
 {
     system_context_t *ctx = (system_context_t *)arg;
-    system_event_t event;
     
     ESP_LOGI(TAG, "Event processing task started");
     
     while (ctx->running) {
-        // Receive from priority queue (handles priority automatically)
-        esp_err_t ret = priority_queue_receive(ctx->event_queue, &event, portMAX_DELAY);
+        // Pick up anything interrupts posted since the last pass
+        system_event_drain_isr();
+    
+        // Take up to a batch per wakeup (handles priority automatically)
+        size_t count = 0;
+        esp_err_t ret = priority_queue_receive_batch(ctx->event_queue,
+                                                     s_batch_events,
+                                                     SYSTEM_EVENT_BATCH_MAX,
+                                                     &count,
+                                                     portMAX_DELAY);
         if (ret != ESP_OK) {
             continue;
         }
-        
-        // Process event
-        ret = system_lock();
-        if (ret != ESP_OK) {
-            if (event.data != NULL) {
-                memory_pool_free(event.data);
+    
+        uint32_t dequeue_us = event_latency_now_us();
+    
+        resolve_batch(ctx, &s_batch, count);
+        system_metric_add(SYSTEM_METRIC_EVENTS_PROCESSED, (uint32_t)count);
+    
+        for (size_t e = 0; e < count; e++) {
+            const dispatch_range_t *range = &s_batch_ranges[e];
+    
+            if (s_batch_events[e].event_type != SYSTEM_EVENT_TYPE_INVALID) {
+                event_latency_record(s_batch_events[e].event_type, SYSTEM_EVENT_LATENCY_QUEUE,
+                                     s_batch_events[e].post_time_us, dequeue_us);
+                SYSTEM_TRACE(SYSTEM_TRACE_EVENT_DEQUEUE, s_batch_events[e].event_type,
+                             s_batch_events[e].sender_id);
             }
+    
+            // Hand each subscriber's handler to its dispatch worker
+            for (uint16_t i = range->first; i < range->first + range->count; i++) {
+                if (!filter_accepts(&s_dispatch_targets[i], &s_batch_events[e])) {
+                    system_metric_add(SYSTEM_METRIC_EVENTS_FILTERED, 1);
+                    continue;
+                }
+                event_dispatch_submit(&s_batch_events[e],
+                                      s_dispatch_targets[i].service_id,
+                                      s_dispatch_targets[i].handler,
+                                      s_dispatch_targets[i].user_data,
+                                      s_dispatch_targets[i].affinity,
+                                      dequeue_us);
+            }
+    
+            // Drop the bus reference, retained payloads stay alive
+            if (s_batch_events[e].data != NULL) {
+                memory_pool_free(s_batch_events[e].data);
+            }
+    
+            // Dispatched: the sender gets its credit back
+            event_credit_release(s_batch_events[e].sender_id, 1);
+        }
+    }
+    
+    ESP_LOGI(TAG, "Event processing task stopped");
+    task_park(s_event_task_exited);
+}
+
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+/*
+ * Critical lane: waits on the CRITICAL queue alone, above the event task
+ * and the workers, and runs each handler itself. A critical event thus
+ * never waits behind a batch being routed or a worker's backlog.
+ */
+static void critical_task(void *arg)
+{
+    system_context_t *ctx = (system_context_t *)arg;
+    system_event_t *event = &s_critical_event;
+    
+    ESP_LOGI(TAG, "Critical event task started");
+    
+    while (ctx->running) {
+        if (priority_queue_receive_critical(ctx->event_queue, event, portMAX_DELAY) != ESP_OK) {
             continue;
         }
-        
-        // Find and call all subscribers
-        for (int i = 0; i < SYSTEM_SERVICE_MAX_SUBSCRIBERS; i++) {
-            if (ctx->subscriptions[i].active &&
-                ctx->subscriptions[i].event_type == event.event_type) {
-                
-                system_service_id_t subscriber_id = ctx->subscriptions[i].service_id;
-                system_event_handler_t handler = ctx->subscriptions[i].handler;
-                void *user_data = ctx->subscriptions[i].user_data;
-                
-                system_unlock();
-                
-                // Execute handler with monitoring (if enabled)
-#if CONFIG_SYSTEM_SERVICE_ENABLE_HANDLER_MONITORING
-                esp_err_t handler_ret = handler_monitor_execute(
-                    handler,
-                    &event,
-                    user_data,
-                    subscriber_id
-                );
-                
-                if (handler_ret != ESP_OK) {
-                    ESP_LOGW(TAG, "Handler for service %d returned error: %s",
-                             subscriber_id, system_service_err_to_name(handler_ret));
-                }
-#else
-                // Direct handler call without monitoring
-                handler(&event, user_data);
-#endif
-                
-                ret = system_lock();
-                if (ret != ESP_OK) {
-                    break;
-                }
+    
+        uint32_t dequeue_us = event_latency_now_us();
+    
+        resolve_batch(ctx, &s_critical_batch, 1);
+        system_metric_add(SYSTEM_METRIC_EVENTS_PROCESSED, 1);
+    
+        if (event->event_type != SYSTEM_EVENT_TYPE_INVALID) {
+            event_latency_record(event->event_type, SYSTEM_EVENT_LATENCY_QUEUE,
+                                 event->post_time_us, dequeue_us);
+            SYSTEM_TRACE(SYSTEM_TRACE_EVENT_DEQUEUE, event->event_type, event->sender_id);
+        }
+    
+        for (uint16_t i = 0; i < s_critical_range.count; i++) {
+            if (!filter_accepts(&s_critical_targets[i], event)) {
+                system_metric_add(SYSTEM_METRIC_EVENTS_FILTERED, 1);
+                continue;
             }
+            event_dispatch_run(event,
+                               s_critical_targets[i].service_id,
+                               s_critical_targets[i].handler,
+                               s_critical_targets[i].user_data,
+                               dequeue_us);
         }
-        
-        ctx->total_events_processed++;
-        
-        system_unlock();
-        
-        // Free event data using memory pool
-        if (event.data != NULL) {
-            memory_pool_free(event.data);
+    
+        if (event->data != NULL) {
+            memory_pool_free(event->data);
         }
+    
+        event_credit_release(event->sender_id, 1);
     }
     
-    ESP_LOGI(TAG, "Event processing task stopped");
-    vTaskDelete(NULL);
+    ESP_LOGI(TAG, "Critical event task stopped");
+    task_park(s_critical_task_exited);
 }
+#endif
 
-system_context_t* system_get_context(void)
+system_context_t* IRAM_ATTR system_get_context(void)
 {
     return &g_system_ctx;
 }
@@ -115,9 +386,22 @@ esp_err_t system_lock(void)
         return ESP_ERR_INVALID_STATE;
     }
     
+#if CONFIG_SYSTEM_SERVICE_TRACE
+    // Only contended takes go on the timeline
+    if (xSemaphoreTake(g_system_ctx.mutex, 0) == pdTRUE) {
+        return ESP_OK;
+    }
+    SYSTEM_TRACE(SYSTEM_TRACE_LOCK_WAIT_BEGIN, 0, 0);
+    BaseType_t taken = xSemaphoreTake(g_system_ctx.mutex, pdMS_TO_TICKS(SYSTEM_SERVICE_MUTEX_TIMEOUT_MS));
+    SYSTEM_TRACE(SYSTEM_TRACE_LOCK_WAIT_END, 0, taken == pdTRUE);
+    if (taken != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+#else
     if (xSemaphoreTake(g_system_ctx.mutex, pdMS_TO_TICKS(SYSTEM_SERVICE_MUTEX_TIMEOUT_MS)) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
+#endif
     
     return ESP_OK;
 }
@@ -146,13 +430,15 @@ esp_err_t system_service_init(system_secure_key_t *out_secure_key)
     ESP_LOGI(TAG, "Initializing system service...");
     
     memset(&g_system_ctx, 0, sizeof(system_context_t));
+    metrics_registry_init();
+    system_subscription_index_reset(&g_system_ctx);
     
     // Generate secure key
     g_system_ctx.secure_key = security_generate_key();
     *out_secure_key = g_system_ctx.secure_key;
     
     // Create mutex
-    g_system_ctx.mutex = xSemaphoreCreateMutex();
+    g_system_ctx.mutex = SYSTEM_MUTEX_CREATE(s_system_mutex);
     if (g_system_ctx.mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create mutex");
         return ESP_ERR_NO_MEM;
@@ -166,11 +452,31 @@ esp_err_t system_service_init(system_secure_key_t *out_secure_key)
         return ret;
     }
     
+    // Overflow can drop latest-value markers, the bus has to release their slots
+    priority_queue_set_drop_callback(g_system_ctx.event_queue, system_event_on_drop);
+    
     // Initialize production systems
     ESP_LOGI(TAG, "Initializing production systems...");
     
+#if CONFIG_SYSTEM_SERVICE_TRACE
+    // First, so the rest of init is on the timeline
+    ret = system_trace_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to initialize tracing: %s", system_service_err_to_name(ret));
+        // Continue anyway, without a trace
+    }
+#endif
+    
+    ret = log_control_deferred_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start deferred logging: %s", system_service_err_to_name(ret));
+        // Continue anyway, messages are formatted in place
+    }
+    
     // Memory pools
+    boot_trace_id_t pool_phase = boot_trace_begin("memory_pool");
     ret = memory_pool_init();
+    boot_trace_end(pool_phase);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize memory pools: %s", system_service_err_to_name(ret));
         priority_queue_destroy(g_system_ctx.event_queue);
@@ -178,6 +484,30 @@ esp_err_t system_service_init(system_secure_key_t *out_secure_key)
         return ret;
     }
     
+    // Reserved blocks for ISR posting (needs the pools)
+    ret = isr_event_ring_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to initialize ISR event ring: %s", system_service_err_to_name(ret));
+        // Continue anyway, ISR posting will be rejected
+    }
+    
+    // Producer credits
+    event_credit_init();
+    
+    // Per-handler profiles
+    ret = handler_monitor_init();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Failed to initialize handler profiling: %s", system_service_err_to_name(ret));
+        // Continue anyway
+    }
+    
+    // Latency histograms
+    ret = event_latency_init();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Failed to initialize latency tracking: %s", system_service_err_to_name(ret));
+        // Continue anyway
+    }
+    
     // Resource quotas
     ret = quota_init();
     if (ret != ESP_OK) {
@@ -192,6 +522,13 @@ esp_err_t system_service_init(system_secure_key_t *out_secure_key)
         // Continue anyway
     }
     
+    // Before anything registers as activatable
+    ret = service_activation_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to initialize service activation: %s", system_service_err_to_name(ret));
+        // Continue anyway
+    }
+    
     // Watchdog
     ret = watchdog_init();
     if (ret != ESP_OK) {
@@ -203,6 +540,18 @@ esp_err_t system_service_init(system_secure_key_t *out_secure_key)
     g_system_ctx.initialized = true;
     g_system_ctx.running = false;
     
+    // Claim the common static IDs before anything registers names
+    ret = common_events_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register common events: %s", system_service_err_to_name(ret));
+    }
+    
+    // After the common events, as it posts COMMON_EVENT_SETTING_CHANGED
+    ret = settings_store_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to initialize settings: %s", system_service_err_to_name(ret));
+    }
+    
     ESP_LOGI(TAG, "System service initialized successfully");
     
     // Log initial memory state
@@ -229,10 +578,15 @@ esp_err_t system_service_deinit(system_secure_key_t secure_key)
     }
     
     // Deinitialize production systems
+    settings_store_deinit();
     watchdog_deinit();
     dependencies_deinit();
     quota_deinit();
+    isr_event_ring_deinit();
+    event_latency_deinit();
+    handler_monitor_deinit();
     memory_pool_deinit();
+    log_control_deferred_deinit();
     
     if (g_system_ctx.event_queue != NULL) {
         priority_queue_destroy(g_system_ctx.event_queue);
@@ -276,21 +630,88 @@ esp_err_t system_service_start(system_secure_key_t secure_key)
         ESP_LOGW(TAG, "Failed to start watchdog: %s", system_service_err_to_name(ret));
     }
     
-    // Create event processing task (defined in event_bus.c)
-    BaseType_t task_ret = xTaskCreate(event_task,
-                                      "sys_event",
-                                      4096,
-                                      &g_system_ctx,
-                                      5,
-                                      &g_system_ctx.event_task);
+    // Start handler workers before anything can be routed to them
+    ret = event_dispatch_start();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start dispatch workers: %s", system_service_err_to_name(ret));
+        g_system_ctx.running = false;
+        watchdog_stop();
+        return ret;
+    }
+    
+    s_event_task_exited = SYSTEM_BINARY_CREATE(s_event_task_exit);
+    if (s_event_task_exited == NULL) {
+        ESP_LOGE(TAG, "Failed to create event task exit semaphore");
+        g_system_ctx.running = false;
+        event_dispatch_stop();
+        watchdog_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Create event routing task
+    BaseType_t task_ret = SYSTEM_TASK_CREATE(s_event_task,
+                                             event_task,
+                                             "sys_event",
+                                             CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE,
+                                             &g_system_ctx,
+                                             CONFIG_SYSTEM_SERVICE_EVENT_TASK_PRIORITY,
+                                             &g_system_ctx.event_task);
     
     if (task_ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create event task");
+        g_system_ctx.event_task = NULL;
+        vSemaphoreDelete(s_event_task_exited);
+        s_event_task_exited = NULL;
         g_system_ctx.running = false;
+        event_dispatch_stop();
         watchdog_stop();
         return ESP_ERR_NO_MEM;
     }
     
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    // Until it runs critical events wait in their queue, nothing is lost
+    task_ret = pdFAIL;
+    s_critical_task_exited = SYSTEM_BINARY_CREATE(s_critical_task_exit);
+    if (s_critical_task_exited != NULL) {
+        task_ret = SYSTEM_TASK_CREATE(s_critical_task,
+                                      critical_task,
+                                      "sys_critical",
+                                      CONFIG_SYSTEM_SERVICE_EVENT_TASK_STACK_SIZE,
+                                      &g_system_ctx,
+                                      CONFIG_SYSTEM_SERVICE_CRITICAL_TASK_PRIORITY,
+                                      &g_system_ctx.critical_task);
+    }
+    if (task_ret != pdPASS) {
+        // Critical events would never be delivered without it
+        ESP_LOGE(TAG, "Failed to create critical event task");
+        g_system_ctx.critical_task = NULL;
+        if (s_critical_task_exited != NULL) {
+            vSemaphoreDelete(s_critical_task_exited);
+            s_critical_task_exited = NULL;
+        }
+        g_system_ctx.running = false;
+        priority_queue_wake(g_system_ctx.event_queue);
+        task_join(&g_system_ctx.event_task, &s_event_task_exited);
+        event_dispatch_stop();
+        watchdog_stop();
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+    
+    // Background heap sampling posts events, so it starts with the bus
+    ret = heap_monitor_start();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Failed to start heap sampler: %s", system_service_err_to_name(ret));
+        // Continue anyway
+    }
+    
+    // Persistent log of the trace rings and metrics, on the storage partition
+    ret = flight_recorder_start();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Failed to start flight recorder: %s", system_service_err_to_name(ret));
+        // Continue anyway
+    }
+    
     ESP_LOGI(TAG, "System service started");
     
     return ESP_OK;
@@ -311,14 +732,29 @@ esp_err_t system_service_stop(system_secure_key_t secure_key)
     
     g_system_ctx.running = false;
     
+    flight_recorder_stop();
+    heap_monitor_stop();
+    
     // Stop watchdog
     watchdog_stop();
     
+    // Kick it out of its blocking receive, it sees running cleared
     if (g_system_ctx.event_task != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(200));
-        g_system_ctx.event_task = NULL;
+        priority_queue_wake(g_system_ctx.event_queue);
+        task_join(&g_system_ctx.event_task, &s_event_task_exited);
     }
     
+#if CONFIG_SYSTEM_SERVICE_CRITICAL_LANE
+    // It runs handlers itself, so it must be gone before the dispatcher
+    if (g_system_ctx.critical_task != NULL) {
+        priority_queue_wake_critical(g_system_ctx.event_queue);
+        task_join(&g_system_ctx.critical_task, &s_critical_task_exited);
+    }
+#endif
+    
+    // Let workers finish queued handlers, then release what is left
+    event_dispatch_stop();
+    
     ESP_LOGI(TAG, "System service stopped");
     
     return ESP_OK;
@@ -338,24 +774,23 @@ esp_err_t system_service_get_stats(system_secure_key_t secure_key,
         return ESP_ERR_SYSTEM_NOT_INITIALIZED;
     }
     
-    esp_err_t ret = system_lock();
-    if (ret != ESP_OK) {
-        return ret;
-    }
+    // Registry gauges, so this no longer takes the system lock
+    system_metric_snapshot_t metric;
     
     if (out_total_services != NULL) {
-        *out_total_services = g_system_ctx.service_count;
+        system_metric_get(SYSTEM_METRIC_SERVICES, &metric);
+        *out_total_services = (uint32_t)metric.value;
     }
     
     if (out_total_events != NULL) {
-        *out_total_events = g_system_ctx.total_events_processed;
+        system_metric_get(SYSTEM_METRIC_EVENTS_PROCESSED, &metric);
+        *out_total_events = (uint32_t)metric.value;
     }
     
     if (out_total_subscriptions != NULL) {
-        *out_total_subscriptions = g_system_ctx.subscription_count;
+        system_metric_get(SYSTEM_METRIC_SUBSCRIPTIONS, &metric);
+        *out_total_subscriptions = (uint32_t)metric.value;
     }
     
-    system_unlock();
-    
     return ESP_OK;
 }
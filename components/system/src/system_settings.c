@@ -0,0 +1,683 @@
+/**
+ * @file system_settings.c
+ * @brief Settings cache with coalesced events and batched NVS write-back
+ *
+ * Values live in fixed tables: scalars in g_system_setting_words[], so a
+ * read is one load, strings and blobs in a byte area handed out at
+ * registration. A setter updates the cache and sets the setting's dirty
+ * and announce bits under a spinlock, then wakes the settings task,
+ * which posts the change events after SYSTEM_SETTINGS_COALESCE_MS and
+ * writes the dirty settings in one NVS commit once they have been quiet
+ * for the write delay. NVS is only touched by the task, by flush and by
+ * registration, all under s_settings.mutex.
+ */
+
+#include "system_service/system_settings.h"
+#include "system_service/common_events.h"
+#include "system_service/event_bus.h"
+#include "system_service/static_alloc.h"
+#include "settings_store.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <string.h>
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_system.h"
+#endif
+
+static const char *TAG = "settings";
+
+#define SETTINGS_NAMESPACE      "settings"
+#define SETTINGS_TASK_STACK     3072
+#define SETTINGS_TASK_PRIORITY  1
+#define SETTINGS_IDLE_MS        1000
+#define SETTINGS_BYTES          CONFIG_SYSTEM_SERVICE_SETTINGS_BYTES
+#define SETTINGS_MASK_WORDS     ((SYSTEM_SETTINGS_MAX + 31) / 32)
+
+typedef struct {
+    char key[SYSTEM_SETTING_KEY_LEN];
+    bool active;
+    uint8_t type;                       // system_setting_type_t
+    system_service_id_t owner;
+    uint16_t offset;                    // STR and BLOB: value in s_bytes
+    uint16_t size;
+    uint16_t length;                    // Current value, without a string's NUL
+} setting_entry_t;
+
+uint32_t g_system_setting_words[SYSTEM_SETTINGS_MAX];
+
+static setting_entry_t s_entries[SYSTEM_SETTINGS_MAX];
+static uint8_t s_bytes[SETTINGS_BYTES];
+static uint8_t s_scratch[SETTINGS_BYTES];
+
+static struct {
+    SemaphoreHandle_t mutex;
+    TaskHandle_t task;
+    volatile bool running;
+    bool nvs_open;
+    nvs_handle_t nvs;
+    uint16_t bytes_used;
+    uint32_t dirty[SETTINGS_MASK_WORDS];
+    uint32_t announce[SETTINGS_MASK_WORDS];
+    int64_t first_change_us;            // Oldest unwritten change, 0 if none
+    int64_t last_change_us;
+    system_settings_stats_t stats;
+} s_settings;
+
+static portMUX_TYPE s_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+
+SYSTEM_MUTEX_DEFINE(s_settings_mutex);
+SYSTEM_TASK_DEFINE(s_settings_task_buf, SETTINGS_TASK_STACK);
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static inline bool is_scalar(system_setting_type_t type)
+{
+    return type <= SYSTEM_SETTING_I32;
+}
+
+static inline void mask_set(uint32_t *mask, system_setting_id_t id)
+{
+    mask[id / 32] |= 1u << (id % 32);
+}
+
+static const setting_entry_t *get_entry(system_setting_id_t id)
+{
+    if (id >= SYSTEM_SETTINGS_MAX || !s_entries[id].active) {
+        return NULL;
+    }
+    return &s_entries[id];
+}
+
+static int find_key(const char *key)
+{
+    for (int i = 0; i < SYSTEM_SETTINGS_MAX; i++) {
+        if (s_entries[i].active && strncmp(s_entries[i].key, key, SYSTEM_SETTING_KEY_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* NVS may be initialised after the system service; opened on first use */
+static bool nvs_ready(void)
+{
+    if (!s_settings.nvs_open &&
+        nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &s_settings.nvs) == ESP_OK) {
+        s_settings.nvs_open = true;
+    }
+    return s_settings.nvs_open;
+}
+
+/* Called with the cache lock held */
+static void mark_changed(system_setting_id_t id)
+{
+    int64_t now = esp_timer_get_time();
+    
+    mask_set(s_settings.dirty, id);
+    mask_set(s_settings.announce, id);
+    s_settings.last_change_us = now;
+    if (s_settings.first_change_us == 0) {
+        s_settings.first_change_us = now;
+    }
+    s_settings.stats.changes++;
+}
+
+static void wake_task(void)
+{
+    if (s_settings.task != NULL) {
+        xTaskNotifyGive(s_settings.task);
+    }
+}
+
+/* Load a registered setting's stored value over its default; mutex held */
+static void load_value(system_setting_id_t id)
+{
+    setting_entry_t *entry = &s_entries[id];
+    
+    if (!nvs_ready()) {
+        return;
+    }
+    
+    if (is_scalar(entry->type)) {
+        uint32_t word;
+        esp_err_t ret = (entry->type == SYSTEM_SETTING_I32) ?
+                        nvs_get_i32(s_settings.nvs, entry->key, (int32_t *)&word) :
+                        nvs_get_u32(s_settings.nvs, entry->key, &word);
+        if (ret == ESP_OK) {
+            __atomic_store_n(&g_system_setting_words[id], word, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+    
+    size_t length = entry->size;
+    esp_err_t ret = (entry->type == SYSTEM_SETTING_STR) ?
+                    nvs_get_str(s_settings.nvs, entry->key, (char *)s_scratch, &length) :
+                    nvs_get_blob(s_settings.nvs, entry->key, s_scratch, &length);
+    if (ret != ESP_OK) {
+        // Missing, or stored by a build with a larger size: keep the default
+        return;
+    }
+    if (entry->type == SYSTEM_SETTING_STR && length > 0) {
+        length--;
+    }
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    memcpy(&s_bytes[entry->offset], s_scratch, length);
+    if (entry->type == SYSTEM_SETTING_STR) {
+        s_bytes[entry->offset + length] = '\0';
+    }
+    entry->length = (uint16_t)length;
+    portEXIT_CRITICAL(&s_cache_lock);
+}
+
+/* ============================================================================
+ * Write-Back
+ * ============================================================================ */
+
+/* Write every dirty setting and commit once; mutex held */
+static esp_err_t write_back(void)
+{
+    uint32_t taken[SETTINGS_MASK_WORDS];
+    uint32_t pending[SETTINGS_MASK_WORDS];
+    bool any = false;
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    memcpy(taken, s_settings.dirty, sizeof(taken));
+    memset(s_settings.dirty, 0, sizeof(s_settings.dirty));
+    s_settings.first_change_us = 0;
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    for (int i = 0; i < SETTINGS_MASK_WORDS; i++) {
+        any |= taken[i] != 0;
+    }
+    if (!any) {
+        return ESP_OK;
+    }
+    
+    esp_err_t ret = nvs_ready() ? ESP_OK : ESP_ERR_NVS_NOT_INITIALIZED;
+    uint32_t written = 0;
+    memcpy(pending, taken, sizeof(pending));
+    
+    for (int id = 0; ret == ESP_OK && id < SYSTEM_SETTINGS_MAX; id++) {
+        if (!(pending[id / 32] & (1u << (id % 32)))) {
+            continue;
+        }
+    
+        const setting_entry_t *entry = &s_entries[id];
+        esp_err_t err;
+        if (is_scalar(entry->type)) {
+            uint32_t word = __atomic_load_n(&g_system_setting_words[id], __ATOMIC_RELAXED);
+            err = (entry->type == SYSTEM_SETTING_I32) ?
+                  nvs_set_i32(s_settings.nvs, entry->key, (int32_t)word) :
+                  nvs_set_u32(s_settings.nvs, entry->key, word);
+        } else {
+            portENTER_CRITICAL(&s_cache_lock);
+            size_t length = entry->length;
+            memcpy(s_scratch, &s_bytes[entry->offset], length + (entry->type == SYSTEM_SETTING_STR));
+            portEXIT_CRITICAL(&s_cache_lock);
+    
+            err = (entry->type == SYSTEM_SETTING_STR) ?
+                  nvs_set_str(s_settings.nvs, entry->key, (const char *)s_scratch) :
+                  nvs_set_blob(s_settings.nvs, entry->key, s_scratch, length);
+        }
+    
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to write %s: %s", entry->key, esp_err_to_name(err));
+            ret = err;
+            break;
+        }
+        pending[id / 32] &= ~(1u << (id % 32));
+        written++;
+    }
+    
+    if (written > 0) {
+        esp_err_t err = nvs_commit(s_settings.nvs);
+        if (err == ESP_OK) {
+            s_settings.stats.commits++;
+            s_settings.stats.written += written;
+        } else {
+            // Nothing of this batch is known to be in flash
+            ESP_LOGW(TAG, "Commit failed: %s", esp_err_to_name(err));
+            memcpy(pending, taken, sizeof(pending));
+            ret = err;
+        }
+    }
+    
+    if (ret != ESP_OK) {
+        // Retry after another quiet period rather than spinning on a failing flash
+        int64_t now = esp_timer_get_time();
+        s_settings.stats.write_errors++;
+        portENTER_CRITICAL(&s_cache_lock);
+        for (int i = 0; i < SETTINGS_MASK_WORDS; i++) {
+            s_settings.dirty[i] |= pending[i];
+        }
+        s_settings.last_change_us = now;
+        if (s_settings.first_change_us == 0) {
+            s_settings.first_change_us = now;
+        }
+        portEXIT_CRITICAL(&s_cache_lock);
+    }
+    return ret;
+}
+
+/* Post one event per setting changed since the last announcement */
+static void announce(void)
+{
+    uint32_t pending[SETTINGS_MASK_WORDS];
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    memcpy(pending, s_settings.announce, sizeof(pending));
+    memset(s_settings.announce, 0, sizeof(s_settings.announce));
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    for (int id = 0; id < SYSTEM_SETTINGS_MAX; id++) {
+        if (!(pending[id / 32] & (1u << (id % 32)))) {
+            continue;
+        }
+    
+        const setting_entry_t *entry = &s_entries[id];
+        common_setting_changed_t changed = {
+            .id = (system_setting_id_t)id,
+            .type = entry->type,
+            .owner = entry->owner,
+            .value = is_scalar(entry->type) ? system_setting_word((system_setting_id_t)id) : entry->length,
+        };
+        strncpy(changed.key, entry->key, sizeof(changed.key) - 1);
+    
+        SYSTEM_EVENT_POST_TYPED(entry->owner, COMMON_EVENT_SETTING_CHANGED, &changed,
+                                SYSTEM_EVENT_PRIORITY_NORMAL);
+    }
+}
+
+/* Ticks until the dirty settings are due for writing, portMAX_DELAY if none */
+static TickType_t write_due_ticks(void)
+{
+    portENTER_CRITICAL(&s_cache_lock);
+    int64_t first = s_settings.first_change_us;
+    int64_t last = s_settings.last_change_us;
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    if (first == 0) {
+        return portMAX_DELAY;
+    }
+    
+    int64_t due = last + (int64_t)CONFIG_SYSTEM_SERVICE_SETTINGS_WRITE_DELAY_MS * 1000;
+    int64_t latest = first + (int64_t)CONFIG_SYSTEM_SERVICE_SETTINGS_MAX_DELAY_MS * 1000;
+    if (latest < due) {
+        due = latest;
+    }
+    
+    int64_t wait_us = due - esp_timer_get_time();
+    return wait_us > 0 ? pdMS_TO_TICKS(wait_us / 1000 + 1) : 0;
+}
+
+static void settings_task(void *arg)
+{
+    while (s_settings.running) {
+        TickType_t wait = write_due_ticks();
+        if (wait > pdMS_TO_TICKS(SETTINGS_IDLE_MS)) {
+            wait = pdMS_TO_TICKS(SETTINGS_IDLE_MS);
+        }
+    
+        if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            // Let a burst of changes settle into one event each
+            vTaskDelay(pdMS_TO_TICKS(SYSTEM_SETTINGS_COALESCE_MS));
+            announce();
+        }
+    
+        if (write_due_ticks() == 0) {
+            xSemaphoreTake(s_settings.mutex, portMAX_DELAY);
+            write_back();
+            xSemaphoreGive(s_settings.mutex);
+        }
+    }
+    
+    announce();
+    s_settings.task = NULL;
+    vTaskDelete(NULL);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+static void settings_shutdown(void)
+{
+    system_settings_flush();
+}
+#endif
+
+/* ============================================================================
+ * Lifecycle
+ * ============================================================================ */
+
+esp_err_t settings_store_init(void)
+{
+    if (s_settings.mutex != NULL) {
+        return ESP_OK;
+    }
+    
+    s_settings.mutex = SYSTEM_MUTEX_CREATE(s_settings_mutex);
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (!nvs_ready()) {
+        ESP_LOGW(TAG, "NVS not available, settings are not persisted until it is");
+    }
+    
+    s_settings.running = true;
+    if (SYSTEM_TASK_CREATE(s_settings_task_buf, settings_task, "settings", SETTINGS_TASK_STACK,
+                           NULL, SETTINGS_TASK_PRIORITY, &s_settings.task) != pdPASS) {
+        s_settings.running = false;
+        vSemaphoreDelete(s_settings.mutex);
+        s_settings.mutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_register_shutdown_handler(settings_shutdown);
+#endif
+    
+    ESP_LOGI(TAG, "Settings: %d slots, %d bytes, write after %d ms quiet",
+             SYSTEM_SETTINGS_MAX, SETTINGS_BYTES, CONFIG_SYSTEM_SERVICE_SETTINGS_WRITE_DELAY_MS);
+    return ESP_OK;
+}
+
+void settings_store_deinit(void)
+{
+    if (s_settings.mutex == NULL) {
+        return;
+    }
+    
+#if !CONFIG_IDF_TARGET_LINUX
+    esp_unregister_shutdown_handler(settings_shutdown);
+#endif
+    
+    system_settings_flush();
+    
+    // The task sends what is still to be announced and exits within SETTINGS_IDLE_MS
+    s_settings.running = false;
+    wake_task();
+    for (int i = 0; i < SETTINGS_IDLE_MS / 10 + 20 && s_settings.task != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    
+    if (s_settings.nvs_open) {
+        nvs_close(s_settings.nvs);
+    }
+    vSemaphoreDelete(s_settings.mutex);
+    
+    // Registrations go with the store; the cached values go with them
+    memset(&s_settings, 0, sizeof(s_settings));
+    memset(s_entries, 0, sizeof(s_entries));
+    memset(g_system_setting_words, 0, sizeof(g_system_setting_words));
+}
+
+/* ============================================================================
+ * Registration
+ * ============================================================================ */
+
+static esp_err_t register_entry(system_service_id_t owner, const char *key,
+                                system_setting_type_t type, size_t size,
+                                system_setting_id_t *out_id, bool *out_created)
+{
+    if (key == NULL || key[0] == '\0' || strlen(key) >= SYSTEM_SETTING_KEY_LEN ||
+        out_id == NULL || type > SYSTEM_SETTING_BLOB) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    *out_created = false;
+    int existing = find_key(key);
+    if (existing >= 0) {
+        const setting_entry_t *entry = &s_entries[existing];
+        if (entry->type != type || (!is_scalar(type) && entry->size != size)) {
+            ESP_LOGE(TAG, "Setting %s exists with another type or size", key);
+            return ESP_ERR_INVALID_STATE;
+        }
+        *out_id = (system_setting_id_t)existing;
+        return ESP_OK;
+    }
+    
+    int slot = -1;
+    for (int i = 0; i < SYSTEM_SETTINGS_MAX; i++) {
+        if (!s_entries[i].active) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        ESP_LOGE(TAG, "No slot for setting %s, raise CONFIG_SYSTEM_SERVICE_MAX_SETTINGS", key);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    setting_entry_t *entry = &s_entries[slot];
+    memset(entry, 0, sizeof(*entry));
+    if (!is_scalar(type)) {
+        if (size == 0 || size > SETTINGS_BYTES - s_settings.bytes_used) {
+            ESP_LOGE(TAG, "No room for %u bytes of %s, raise CONFIG_SYSTEM_SERVICE_SETTINGS_BYTES",
+                     (unsigned)size, key);
+            return size == 0 ? ESP_ERR_INVALID_ARG : ESP_ERR_NO_MEM;
+        }
+        // Never returned: bytes settings are few and registered for good
+        entry->offset = s_settings.bytes_used;
+        entry->size = (uint16_t)size;
+        s_settings.bytes_used += (uint16_t)size;
+    }
+    
+    strncpy(entry->key, key, sizeof(entry->key) - 1);
+    entry->type = (uint8_t)type;
+    entry->owner = owner;
+    entry->active = true;
+    s_settings.stats.settings++;
+    
+    *out_id = (system_setting_id_t)slot;
+    *out_created = true;
+    return ESP_OK;
+}
+
+esp_err_t system_setting_register(system_service_id_t owner, const char *key,
+                                  system_setting_type_t type, uint32_t default_value,
+                                  system_setting_id_t *out_id)
+{
+    if (!is_scalar(type)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_settings.mutex, portMAX_DELAY);
+    bool created;
+    esp_err_t ret = register_entry(owner, key, type, 0, out_id, &created);
+    if (ret == ESP_OK && created) {
+        __atomic_store_n(&g_system_setting_words[*out_id], default_value, __ATOMIC_RELAXED);
+        load_value(*out_id);
+    }
+    xSemaphoreGive(s_settings.mutex);
+    
+    return ret;
+}
+
+esp_err_t system_setting_register_bytes(system_service_id_t owner, const char *key,
+                                        system_setting_type_t type, size_t size,
+                                        const void *default_value,
+                                        system_setting_id_t *out_id)
+{
+    if (is_scalar(type) || size > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_settings.mutex, portMAX_DELAY);
+    bool created;
+    esp_err_t ret = register_entry(owner, key, type, size, out_id, &created);
+    if (ret == ESP_OK && created) {
+        setting_entry_t *entry = &s_entries[*out_id];
+        uint8_t *value = &s_bytes[entry->offset];
+    
+        memset(value, 0, entry->size);
+        if (default_value != NULL) {
+            size_t length = (type == SYSTEM_SETTING_STR) ?
+                            strnlen(default_value, entry->size - 1) : entry->size;
+            memcpy(value, default_value, length);
+            entry->length = (uint16_t)length;
+        }
+        load_value(*out_id);
+    }
+    xSemaphoreGive(s_settings.mutex);
+    
+    return ret;
+}
+
+esp_err_t system_setting_find(const char *key, system_setting_id_t *out_id)
+{
+    if (key == NULL || out_id == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_settings.mutex, portMAX_DELAY);
+    int id = find_key(key);
+    xSemaphoreGive(s_settings.mutex);
+    
+    if (id < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *out_id = (system_setting_id_t)id;
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * Access
+ * ============================================================================ */
+
+esp_err_t system_setting_set_word(system_setting_id_t id, system_setting_type_t type, uint32_t value)
+{
+    const setting_entry_t *entry = get_entry(id);
+    if (entry == NULL || entry->type != type) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (type == SYSTEM_SETTING_BOOL) {
+        value = value != 0;
+    } else if (type == SYSTEM_SETTING_U8) {
+        value &= 0xFF;
+    }
+    
+    bool changed = false;
+    portENTER_CRITICAL(&s_cache_lock);
+    if (g_system_setting_words[id] != value) {
+        __atomic_store_n(&g_system_setting_words[id], value, __ATOMIC_RELAXED);
+        mark_changed(id);
+        changed = true;
+    }
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    if (changed) {
+        wake_task();
+    }
+    return ESP_OK;
+}
+
+esp_err_t system_setting_set_bytes(system_setting_id_t id, const void *data, size_t len)
+{
+    setting_entry_t *entry = (setting_entry_t *)get_entry(id);
+    if (entry == NULL || is_scalar(entry->type) || (data == NULL && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t limit = entry->size;
+    if (entry->type == SYSTEM_SETTING_STR) {
+        len = (data != NULL) ? strlen(data) : 0;
+        limit--;
+    }
+    if (len > limit) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    uint8_t *value = &s_bytes[entry->offset];
+    bool changed = false;
+    portENTER_CRITICAL(&s_cache_lock);
+    if (entry->length != len || (len > 0 && memcmp(value, data, len) != 0)) {
+        if (len > 0) {
+            memcpy(value, data, len);
+        }
+        if (entry->type == SYSTEM_SETTING_STR) {
+            value[len] = '\0';
+        }
+        entry->length = (uint16_t)len;
+        mark_changed(id);
+        changed = true;
+    }
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    if (changed) {
+        wake_task();
+    }
+    return ESP_OK;
+}
+
+esp_err_t system_setting_get_bytes(system_setting_id_t id, void *out, size_t size, size_t *out_len)
+{
+    const setting_entry_t *entry = get_entry(id);
+    if (entry == NULL || is_scalar(entry->type) || out == NULL || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    bool is_str = entry->type == SYSTEM_SETTING_STR;
+    portENTER_CRITICAL(&s_cache_lock);
+    size_t len = entry->length;
+    if (len > size - is_str) {
+        len = size - is_str;
+    }
+    memcpy(out, &s_bytes[entry->offset], len);
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    if (is_str) {
+        ((char *)out)[len] = '\0';
+    }
+    if (out_len != NULL) {
+        *out_len = len;
+    }
+    return ESP_OK;
+}
+
+esp_err_t system_settings_flush(void)
+{
+    if (s_settings.mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(s_settings.mutex, portMAX_DELAY);
+    esp_err_t ret = write_back();
+    xSemaphoreGive(s_settings.mutex);
+    
+    return ret;
+}
+
+esp_err_t system_settings_get_stats(system_settings_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&s_cache_lock);
+    *out_stats = s_settings.stats;
+    out_stats->bytes_used = s_settings.bytes_used;
+    out_stats->dirty = s_settings.first_change_us != 0;
+    portEXIT_CRITICAL(&s_cache_lock);
+    
+    return ESP_OK;
+}
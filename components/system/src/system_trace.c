@@ -0,0 +1,366 @@
+/**
+ * @file system_trace.c
+ * @brief Binary scheduling trace implementation
+ *
+ * A writer reads its core and that core's cycle counter as a pair (read
+ * again if the task migrated in between), claims the next slot of that
+ * core's ring with an atomic add, and publishes the record by storing its
+ * type last. A slot still being written reads as SYSTEM_TRACE_NONE.
+ *
+ * Rings are power-of-two sized, so the free-running head both counts the
+ * records written and, masked, indexes the next slot.
+ */
+
+#include "system_service/system_trace.h"
+
+#if CONFIG_SYSTEM_SERVICE_TRACE
+
+#include "system_service/event_bus.h"
+#include "system_service/service_manager.h"
+#include "system_service/memory_utils.h"
+#include "console_base64.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#define TRACE_CPU_FREQ_HZ   1000000
+#else
+#include "esp_cpu.h"
+#define TRACE_CPU_FREQ_HZ   (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000)
+#endif
+
+static const char *TAG = "trace";
+
+#define RING_RECORDS        CONFIG_SYSTEM_SERVICE_TRACE_RECORDS_PER_CORE
+#define RING_MASK           (RING_RECORDS - 1)
+#define SYNC_CYCLES         ((uint32_t)((uint64_t)TRACE_CPU_FREQ_HZ * CONFIG_SYSTEM_SERVICE_TRACE_SYNC_MS / 1000))
+
+_Static_assert((RING_RECORDS & RING_MASK) == 0,
+               "CONFIG_SYSTEM_SERVICE_TRACE_RECORDS_PER_CORE must be a power of two");
+_Static_assert(sizeof(system_trace_record_t) == 16, "trace records are 16 bytes");
+
+typedef struct {
+    uint32_t head;                  // Records claimed, free running
+    uint32_t last_sync;             // Cycles at the last SYNC
+    system_trace_record_t *records;
+} trace_ring_t;
+
+static trace_ring_t s_rings[portNUM_PROCESSORS];
+static volatile bool s_enabled = false;
+static bool s_initialized = false;
+
+static inline uint32_t trace_cycles(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return (uint32_t)esp_timer_get_time();
+#else
+    return esp_cpu_get_cycle_count();
+#endif
+}
+
+static inline void ring_write(trace_ring_t *ring, uint8_t core, uint32_t cycles,
+                              system_trace_type_t type, uint16_t arg0, uint32_t arg1)
+{
+    uint32_t slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED) & RING_MASK;
+    system_trace_record_t *record = &ring->records[slot];
+    
+    __atomic_store_n(&record->type, SYSTEM_TRACE_NONE, __ATOMIC_RELAXED);
+    record->cycles = cycles;
+    record->core = core;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+    record->task = (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+    __atomic_store_n(&record->type, (uint8_t)type, __ATOMIC_RELEASE);
+}
+
+void system_trace_record(system_trace_type_t type, uint16_t arg0, uint32_t arg1)
+{
+    if (!s_enabled) {
+        return;
+    }
+    
+    uint32_t core;
+    uint32_t cycles;
+    do {
+        core = xPortGetCoreID();
+        cycles = trace_cycles();
+    } while (core != xPortGetCoreID());
+    
+    trace_ring_t *ring = &s_rings[core];
+    
+    // Racing writers on one core may both sync; that only costs a slot
+    if (cycles - ring->last_sync >= SYNC_CYCLES) {
+        ring->last_sync = cycles;
+        ring_write(ring, (uint8_t)core, cycles, SYSTEM_TRACE_SYNC, 0, (uint32_t)esp_timer_get_time());
+    }
+    
+    ring_write(ring, (uint8_t)core, cycles, type, arg0, arg1);
+}
+
+void system_trace_enable(bool enable)
+{
+    s_enabled = enable && s_initialized;
+}
+
+esp_err_t system_trace_init(void)
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+    
+    // Internal RAM keeps a record to a couple of stores; PSRAM still works
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        size_t size = RING_RECORDS * sizeof(system_trace_record_t);
+        system_trace_record_t *records = heap_caps_calloc(1, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (records == NULL) {
+            records = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (records == NULL) {
+            ESP_LOGE(TAG, "No memory for %d trace records on core %d", RING_RECORDS, core);
+            for (int i = 0; i < core; i++) {
+                heap_caps_free(s_rings[i].records);
+                s_rings[i].records = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+        s_rings[core] = (trace_ring_t){
+            .records = records,
+            .last_sync = trace_cycles() - SYNC_CYCLES,
+        };
+    }
+    
+    s_initialized = true;
+    s_enabled = true;
+    
+    ESP_LOGI(TAG, "Tracing %d records per core, sync every %d ms",
+             RING_RECORDS, CONFIG_SYSTEM_SERVICE_TRACE_SYNC_MS);
+    return ESP_OK;
+}
+
+/* ============================================================================
+ * Incremental Reader
+ * ============================================================================ */
+
+uint32_t system_trace_skip(uint8_t core, uint32_t *cursor, uint32_t keep)
+{
+    if (core >= portNUM_PROCESSORS || cursor == NULL || !s_initialized) {
+        return 0;
+    }
+    
+    uint32_t head = __atomic_load_n(&s_rings[core].head, __ATOMIC_ACQUIRE);
+    if (keep > RING_RECORDS) {
+        keep = RING_RECORDS;
+    }
+    if (head - *cursor <= keep) {
+        return 0;
+    }
+    
+    uint32_t skipped = head - keep - *cursor;
+    *cursor = head - keep;
+    return skipped;
+}
+
+size_t system_trace_read(uint8_t core, uint32_t *cursor,
+                         system_trace_record_t *records, size_t max_records,
+                         uint32_t *out_lost)
+{
+    if (out_lost != NULL) {
+        *out_lost = 0;
+    }
+    if (core >= portNUM_PROCESSORS || cursor == NULL || records == NULL || !s_initialized) {
+        return 0;
+    }
+    
+    // Records already overwritten are lost
+    uint32_t lost = system_trace_skip(core, cursor, RING_RECORDS);
+    const trace_ring_t *ring = &s_rings[core];
+    uint32_t start = *cursor;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    
+    size_t copied = 0;
+    while (copied < max_records && start + copied != head) {
+        const system_trace_record_t *record = &ring->records[(start + copied) & RING_MASK];
+        if (__atomic_load_n(&record->type, __ATOMIC_ACQUIRE) == SYSTEM_TRACE_NONE) {
+            break;      // Claimed but not written yet; read it next time
+        }
+        records[copied++] = *record;
+    }
+    
+    // Slots a writer lapped while they were copied hold newer data: drop them
+    size_t count = copied;
+    uint32_t now = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (now - start > RING_RECORDS) {
+        size_t overrun = now - RING_RECORDS - start;
+        if (overrun > copied) {
+            overrun = copied;
+        }
+        memmove(records, records + overrun, (copied - overrun) * sizeof(system_trace_record_t));
+        count -= overrun;
+        lost += overrun;
+    }
+    
+    *cursor = start + copied;
+    if (out_lost != NULL) {
+        *out_lost = lost;
+    }
+    return count;
+}
+
+/* ============================================================================
+ * Dump
+ * ============================================================================ */
+
+static void name_add(system_trace_name_t *names, size_t *count, size_t max,
+                     system_trace_name_kind_t kind, uint32_t id, const char *name)
+{
+    if (*count >= max || name == NULL || name[0] == '\0') {
+        return;
+    }
+    system_trace_name_t *entry = &names[(*count)++];
+    memset(entry, 0, sizeof(*entry));
+    entry->kind = (uint8_t)kind;
+    entry->id = id;
+    strncpy(entry->name, name, sizeof(entry->name));
+}
+
+/**
+ * @brief Collect the names a decoder needs to label the records
+ */
+static size_t collect_names(system_trace_name_t *names, size_t max)
+{
+    size_t count = 0;
+    char name[SYSTEM_SERVICE_MAX_NAME_LEN > 32 ? SYSTEM_SERVICE_MAX_NAME_LEN : 32];
+    
+    for (system_event_type_t type = 0; type < SYSTEM_SERVICE_MAX_EVENT_TYPES; type++) {
+        if (system_event_get_type_name(type, name, sizeof(name)) == ESP_OK) {
+            name_add(names, &count, max, SYSTEM_TRACE_NAME_EVENT_TYPE, type, name);
+        }
+    }
+    
+    for (system_service_id_t id = 0; id < SYSTEM_SERVICE_MAX_SERVICES; id++) {
+        system_service_info_t info;
+        if (system_service_get_info(id, &info) == ESP_OK &&
+            info.state != SYSTEM_SERVICE_STATE_UNREGISTERED) {
+            name_add(names, &count, max, SYSTEM_TRACE_NAME_SERVICE, id, info.name);
+        }
+    }
+    
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    UBaseType_t task_count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = malloc(task_count * sizeof(TaskStatus_t));
+    if (tasks != NULL) {
+        task_count = uxTaskGetSystemState(tasks, task_count, NULL);
+        for (UBaseType_t i = 0; i < task_count; i++) {
+            name_add(names, &count, max, SYSTEM_TRACE_NAME_TASK,
+                     (uint32_t)(uintptr_t)tasks[i].xHandle, tasks[i].pcTaskName);
+        }
+        free(tasks);
+    }
+#else
+    // Without the trace facility, at least name the caller's task
+    name_add(names, &count, max, SYSTEM_TRACE_NAME_TASK,
+             (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle(), pcTaskGetName(NULL));
+#endif
+    
+    return count;
+}
+
+size_t system_trace_get_names(system_trace_name_t *names, size_t max_names)
+{
+    if (names == NULL || !s_initialized) {
+        return 0;
+    }
+    return collect_names(names, max_names);
+}
+
+static esp_err_t dump_ring(const trace_ring_t *ring, system_trace_write_fn_t write, void *user_data)
+{
+    uint32_t head = ring->head;
+    uint32_t count = head < RING_RECORDS ? head : RING_RECORDS;
+    uint32_t first = (head - count) & RING_MASK;
+    
+    // Oldest first: the part after the head, then the part before it
+    uint32_t tail_part = RING_RECORDS - first;
+    if (tail_part > count) {
+        tail_part = count;
+    }
+    esp_err_t ret = write(&ring->records[first], tail_part * sizeof(system_trace_record_t), user_data);
+    if (ret == ESP_OK && count > tail_part) {
+        ret = write(&ring->records[0], (count - tail_part) * sizeof(system_trace_record_t), user_data);
+    }
+    return ret;
+}
+
+esp_err_t system_trace_dump(system_trace_write_fn_t write, void *user_data)
+{
+    if (write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    size_t max_names = SYSTEM_SERVICE_MAX_EVENT_TYPES + SYSTEM_SERVICE_MAX_SERVICES + 64;
+    system_trace_name_t *names = memory_alloc_prefer_psram(max_names * sizeof(system_trace_name_t));
+    if (names == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t name_count = collect_names(names, max_names);
+    
+    // Let writers caught mid-record finish before the rings are read
+    bool was_enabled = s_enabled;
+    s_enabled = false;
+    vTaskDelay(1);
+    
+    system_trace_header_t header = {
+        .magic = SYSTEM_TRACE_MAGIC,
+        .version = SYSTEM_TRACE_VERSION,
+        .cores = portNUM_PROCESSORS,
+        .record_size = sizeof(system_trace_record_t),
+        .name_count = (uint32_t)name_count,
+        .cpu_freq_hz = TRACE_CPU_FREQ_HZ,
+    };
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t head = s_rings[core].head;
+        header.record_count += head < RING_RECORDS ? head : RING_RECORDS;
+        header.dropped += head > RING_RECORDS ? head - RING_RECORDS : 0;
+    }
+    
+    esp_err_t ret = write(&header, sizeof(header), user_data);
+    for (int core = 0; core < portNUM_PROCESSORS && ret == ESP_OK; core++) {
+        ret = dump_ring(&s_rings[core], write, user_data);
+    }
+    if (ret == ESP_OK && name_count > 0) {
+        ret = write(names, name_count * sizeof(system_trace_name_t), user_data);
+    }
+    
+    s_enabled = was_enabled;
+    free(names);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Dump aborted: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* ============================================================================
+ * Console sink
+ * ============================================================================ */
+
+esp_err_t system_trace_dump_console(void)
+{
+    console_base64_t sink;
+    
+    console_base64_begin(&sink, "KTRACE");
+    esp_err_t ret = system_trace_dump(console_base64_write, &sink);
+    console_base64_end(&sink);
+    
+    return ret;
+}
+
+#endif // CONFIG_SYSTEM_SERVICE_TRACE
@@ -0,0 +1,242 @@
+/**
+ * @file topic_trie.c
+ * @brief Prefix trie over the registered event type names
+ *
+ * A radix trie: every edge carries a run of characters, taken as a slice
+ * of one interned name, and a node has as many children as distinct next
+ * characters. Inserting a name adds one leaf and splits at most one edge,
+ * so the pool never needs more than two nodes per type plus the root.
+ */
+
+#include "topic_trie.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "topic_trie";
+
+#define TRIE_NODES          (2 * SYSTEM_SERVICE_MAX_EVENT_TYPES + 1)
+#define TRIE_NONE           0xFFFF
+#define TRIE_ROOT           0
+
+typedef struct {
+    const char *label;                  /**< Edge into this node, inside an interned name */
+    uint8_t label_len;
+    uint16_t first_child;
+    uint16_t next_sibling;
+    system_event_type_t event_type;     /**< Type whose name ends here, or INVALID */
+} trie_node_t;
+
+static trie_node_t g_nodes[TRIE_NODES];
+static uint16_t g_node_count = 0;
+
+/* ============================================================================
+ * Internal Helper Functions
+ * ============================================================================ */
+
+static uint16_t node_alloc(const char *label, uint8_t label_len)
+{
+    if (g_node_count >= TRIE_NODES) {
+        return TRIE_NONE;
+    }
+    
+    uint16_t index = g_node_count++;
+    g_nodes[index].label = label;
+    g_nodes[index].label_len = label_len;
+    g_nodes[index].first_child = TRIE_NONE;
+    g_nodes[index].next_sibling = TRIE_NONE;
+    g_nodes[index].event_type = SYSTEM_EVENT_TYPE_INVALID;
+    return index;
+}
+
+/* Child whose edge starts with c, and the link that points at it */
+static uint16_t find_child(uint16_t parent, char c, uint16_t **out_link)
+{
+    uint16_t *link = &g_nodes[parent].first_child;
+    while (*link != TRIE_NONE) {
+        if (g_nodes[*link].label[0] == c) {
+            break;
+        }
+        link = &g_nodes[*link].next_sibling;
+    }
+    
+    if (out_link != NULL) {
+        *out_link = link;
+    }
+    return *link;
+}
+
+static size_t common_prefix(const char *a, size_t a_len, const char *b)
+{
+    size_t n = 0;
+    while (n < a_len && b[n] != '\0' && a[n] == b[n]) {
+        n++;
+    }
+    return n;
+}
+
+/* Where the pattern's wildcard splits it; false if it has none */
+static bool split_pattern(const char *pattern, size_t *out_prefix_len, const char **out_suffix)
+{
+    const char *star = strchr(pattern, TOPIC_WILDCARD);
+    if (star == NULL) {
+        return false;
+    }
+    *out_prefix_len = (size_t)(star - pattern);
+    *out_suffix = star + 1;
+    return true;
+}
+
+/**
+ * @brief Visit the types of a subtree whose names end with the suffix
+ *
+ * path holds the name up to and including the node's edge. Names are
+ * shorter than SYSTEM_SERVICE_MAX_NAME_LEN, which bounds the recursion.
+ */
+static void visit_subtree(uint16_t node, char *path, size_t path_len, size_t min_len,
+                          const char *suffix, size_t suffix_len,
+                          topic_trie_visit_fn_t visit, void *arg)
+{
+    if (g_nodes[node].event_type != SYSTEM_EVENT_TYPE_INVALID && path_len >= min_len &&
+        memcmp(path + path_len - suffix_len, suffix, suffix_len) == 0) {
+        visit(g_nodes[node].event_type, arg);
+    }
+    
+    for (uint16_t child = g_nodes[node].first_child; child != TRIE_NONE;
+         child = g_nodes[child].next_sibling) {
+        size_t len = g_nodes[child].label_len;
+        if (path_len + len >= SYSTEM_SERVICE_MAX_NAME_LEN) {
+            continue;
+        }
+        memcpy(path + path_len, g_nodes[child].label, len);
+        visit_subtree(child, path, path_len + len, min_len, suffix, suffix_len, visit, arg);
+    }
+}
+
+/* ============================================================================
+ * Public API Implementation
+ * ============================================================================ */
+
+void topic_trie_reset(void)
+{
+    g_node_count = 0;
+    node_alloc("", 0);
+}
+
+esp_err_t topic_trie_insert(system_event_type_t event_type, const char *name)
+{
+    if (name == NULL || name[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (g_node_count == 0) {
+        topic_trie_reset();
+    }
+    
+    uint16_t node = TRIE_ROOT;
+    const char *rest = name;
+    
+    while (*rest != '\0') {
+        uint16_t *link;
+        uint16_t child = find_child(node, *rest, &link);
+    
+        if (child == TRIE_NONE) {
+            uint16_t leaf = node_alloc(rest, (uint8_t)strlen(rest));
+            if (leaf == TRIE_NONE) {
+                ESP_LOGW(TAG, "Trie full, '%s' will not match wildcards", name);
+                return ESP_ERR_NO_MEM;
+            }
+            *link = leaf;
+            node = leaf;
+            break;
+        }
+    
+        size_t common = common_prefix(g_nodes[child].label, g_nodes[child].label_len, rest);
+        if (common < g_nodes[child].label_len) {
+            // Split the edge where the names part
+            uint16_t mid = node_alloc(g_nodes[child].label, (uint8_t)common);
+            if (mid == TRIE_NONE) {
+                ESP_LOGW(TAG, "Trie full, '%s' will not match wildcards", name);
+                return ESP_ERR_NO_MEM;
+            }
+            g_nodes[mid].next_sibling = g_nodes[child].next_sibling;
+            g_nodes[mid].first_child = child;
+            g_nodes[child].next_sibling = TRIE_NONE;
+            g_nodes[child].label += common;
+            g_nodes[child].label_len -= (uint8_t)common;
+            *link = mid;
+            child = mid;
+        }
+    
+        node = child;
+        rest += common;
+    }
+    
+    g_nodes[node].event_type = event_type;
+    return ESP_OK;
+}
+
+void topic_trie_match(const char *pattern, topic_trie_visit_fn_t visit, void *arg)
+{
+    size_t prefix_len;
+    const char *suffix;
+    if (pattern == NULL || visit == NULL || g_node_count == 0 ||
+        !split_pattern(pattern, &prefix_len, &suffix)) {
+        return;
+    }
+    
+    char path[SYSTEM_SERVICE_MAX_NAME_LEN];
+    size_t path_len = 0;
+    uint16_t node = TRIE_ROOT;
+    size_t pos = 0;
+    
+    // Walk down the prefix; it may end halfway along an edge
+    while (pos < prefix_len) {
+        uint16_t child = find_child(node, pattern[pos], NULL);
+        if (child == TRIE_NONE) {
+            return;
+        }
+    
+        size_t len = g_nodes[child].label_len;
+        size_t want = prefix_len - pos;
+        size_t common = 0;
+        while (common < len && common < want && g_nodes[child].label[common] == pattern[pos + common]) {
+            common++;
+        }
+        if (common < len && common < want) {
+            return;
+        }
+    
+        memcpy(path + path_len, g_nodes[child].label, len);
+        path_len += len;
+        pos += common;
+        node = child;
+    }
+    
+    size_t suffix_len = strlen(suffix);
+    visit_subtree(node, path, path_len, prefix_len + suffix_len, suffix, suffix_len, visit, arg);
+}
+
+bool topic_pattern_match(const char *pattern, const char *name)
+{
+    size_t prefix_len;
+    const char *suffix;
+    if (pattern == NULL || name == NULL || !split_pattern(pattern, &prefix_len, &suffix)) {
+        return false;
+    }
+    
+    size_t name_len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return name_len >= prefix_len + suffix_len &&
+           strncmp(name, pattern, prefix_len) == 0 &&
+           memcmp(name + name_len - suffix_len, suffix, suffix_len) == 0;
+}
+
+bool topic_pattern_valid(const char *pattern)
+{
+    if (pattern == NULL || strlen(pattern) >= SYSTEM_SERVICE_MAX_NAME_LEN) {
+        return false;
+    }
+    
+    const char *star = strchr(pattern, TOPIC_WILDCARD);
+    return star != NULL && strchr(star + 1, TOPIC_WILDCARD) == NULL;
+}
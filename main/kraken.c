@@ -23,14 +23,17 @@
 #include "system_service/service_manager.h"
 #include "system_service/event_bus.h"
 #include "system_service/memory_utils.h"
+#include "system_service/boot_trace.h"
 
 // Production feature headers
 #include "memory_pool.h"
 #include "service_watchdog.h"
 #include "resource_quota.h"
 #include "service_dependencies.h"
+#include "boot_orchestrator.h"
 #include "heap_monitor.h"
 #include "log_control.h"
+#include "system_bench.h"
 
 // Application service headers
 #include "audio_service.h"
@@ -145,6 +148,24 @@ static esp_err_t init_system_service(void)
     ESP_LOGI(TAG, "✓ System service initialized");
     ESP_LOGI(TAG, "  Secure key: 0x%08lX", g_system_secure_key);
     
+    // Static event IDs go in before any service looks events up by name
+    const struct {
+        const system_event_schema_t *table;
+        size_t count;
+    } schemas[] = {
+        { NETWORK_EVENT_SCHEMA_TABLE, NETWORK_EVENT_COUNT },
+        { AUDIO_EVENT_SCHEMA_TABLE, AUDIO_EVENT_COUNT },
+        { BT_EVENT_SCHEMA_TABLE, BT_EVENT_COUNT },
+        { INPUT_EVENT_SCHEMA_TABLE, INPUT_EVENT_COUNT },
+    };
+    for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++) {
+        ret = system_event_register_schema(schemas[i].table, schemas[i].count);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register event schema: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
     // Start the event processing task
     ret = system_service_start(g_system_secure_key);
     if (ret != ESP_OK) {
@@ -162,6 +183,59 @@ static esp_err_t init_system_service(void)
     return ESP_OK;
 }
 
+/** How long a service may wait for dependencies outside the boot table */
+#define BOOT_DEPENDENCY_TIMEOUT_MS  5000
+
+/**
+ * @brief Driver services, brought up concurrently by the boot orchestrator
+ * 
+ * Display comes first so the UI is up as early as possible. Audio stays
+ * here because flash apps use its stream API directly.
+ */
+static const boot_service_t s_boot_services[] = {
+    { .name = "display_service",   .init = display_service_init,   .start = display_service_start },
+    { .name = "audio_service",     .init = audio_service_init,     .start = audio_service_start },
+    { .name = "input_service",     .init = input_service_init,     .start = input_service_start },
+    { .name = "power_service",     .init = power_service_init,     .start = power_service_start },
+};
+
+/** How long an unused radio service stays up */
+#define ACTIVATION_IDLE_TIMEOUT_MS  (CONFIG_SYSTEM_SERVICE_ACTIVATION_IDLE_TIMEOUT_S * 1000)
+
+static bool bluetooth_busy(void)
+{
+    return bluetooth_service_is_connected() || bluetooth_service_is_advertising();
+}
+
+static bool network_busy(void)
+{
+#if CONFIG_NETWORK_BRIDGE
+    // The bridge listens for other units all the time
+    return true;
+#else
+    return network_is_connected();
+#endif
+}
+
+/**
+ * @brief Radio services, brought up on first use
+ * 
+ * The BT controller and the WiFi driver cost boot time and tens of KB of
+ * internal RAM each, so they only come up once their events are
+ * subscribed to or their menu entry is opened. Activations run one at a
+ * time, so WiFi and Bluetooth no longer race for the RF PHY setup.
+ */
+static const system_service_activatable_t s_activatable_services[] = {
+    { .name = "bluetooth_service", .init = bluetooth_service_init, .start = bluetooth_service_start,
+      .stop = bluetooth_service_stop, .deinit = bluetooth_service_deinit,
+      .topics = "bluetooth.*", .ui_event = "menu.bluetooth_clicked",
+      .idle_timeout_ms = ACTIVATION_IDLE_TIMEOUT_MS, .busy = bluetooth_busy },
+    { .name = "network_service",   .init = network_service_init,   .start = network_service_start,
+      .stop = network_service_stop, .deinit = network_service_deinit,
+      .topics = "network.*", .ui_event = "menu.network_clicked",
+      .idle_timeout_ms = ACTIVATION_IDLE_TIMEOUT_MS, .busy = network_busy },
+};
+
 /**
  * @brief Initialize application services
  * 
@@ -209,43 +283,36 @@ static void init_application_services(void)
         ESP_LOGE(TAG, "Failed to initialize app manager");
     } else {
         ESP_LOGI(TAG, "✓ App manager initialized");
+        
+        // An installed app store image runs in place from flash
+        ret = app_manager_load_dynamic_from_partition("app_store", 0, NULL);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "✓ Flash app loaded from app_store");
+        } else if (ret != ESP_ERR_INVALID_VERSION && ret != ESP_ERR_NOT_FOUND) {
+            ESP_LOGW(TAG, "Flash app in app_store not loaded: %s", esp_err_to_name(ret));
+        }
     }
     
-    // Initialize Audio Service
-    ret = audio_service_init();
-    if (ret == ESP_OK) {
-        audio_service_start();
-    }
-    
-    // Initialize Bluetooth Service
-    ret = bluetooth_service_init();
-    if (ret == ESP_OK) {
-        bluetooth_service_start();
+    // Bring up driver services in parallel, dependencies first
+    ret = boot_orchestrator_run(s_boot_services,
+                                sizeof(s_boot_services) / sizeof(s_boot_services[0]),
+                                BOOT_DEPENDENCY_TIMEOUT_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Some services did not come up: %s", esp_err_to_name(ret));
     }
     
-    // Initialize Display Service
-    ret = display_service_init();
-    if (ret == ESP_OK) {
-        display_service_start();
+    for (size_t i = 0; i < sizeof(s_activatable_services) / sizeof(s_activatable_services[0]); i++) {
+        ret = system_service_register_activatable(&s_activatable_services[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s for activation: %s",
+                     s_activatable_services[i].name, esp_err_to_name(ret));
+        }
     }
     
-    // Initialize Network Service
-    ret = network_service_init();
-    if (ret == ESP_OK) {
-        network_service_start();
-    }
-
-    // Initialize Input Service
-    // ret = input_service_init();
-    // if (ret == ESP_OK) {
-    //     input_service_start();
-    // }
-    
-    // Initialize Power Service
-    ret = power_service_init();
-    if (ret == ESP_OK) {
-        power_service_start();
-    }
+#if CONFIG_NETWORK_BRIDGE
+    // Other units expect the bridge from boot, without waiting for it here
+    system_service_activate("network_service", 0, NULL);
+#endif
     
     // ESP_LOGI(TAG, "");
     // ESP_LOGI(TAG, "Registering apps...");
@@ -357,6 +424,14 @@ static void main_task(void *pvParameters)
     // Wait a bit for system to stabilize
     vTaskDelay(pdMS_TO_TICKS(3000));
     
+#if CONFIG_SYSTEM_SERVICE_BENCHMARK
+    // Before any app runs, so only the benchmark loads the bus
+    esp_err_t bench_ret = system_bench_run();
+    if (bench_ret != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmarks failed: %s", esp_err_to_name(bench_ret));
+    }
+#endif
+    
     ESP_LOGI(TAG, "");
     ESP_LOGI(TAG, "═══════════════════════════════════════");
     ESP_LOGI(TAG, "Starting apps demonstration...");
@@ -380,11 +455,21 @@ static void main_task(void *pvParameters)
             ESP_LOGI(TAG, "      State: %d, Source: %s, Dynamic: %s",
                      apps[i].state,
                      apps[i].source == APP_SOURCE_INTERNAL ? "Built-in" :
-                     apps[i].source == APP_SOURCE_STORAGE ? "Storage" : "Remote",
+                     apps[i].source == APP_SOURCE_STORAGE ? "Storage" :
+                     apps[i].source == APP_SOURCE_FLASH ? "Flash" : "Remote",
                      apps[i].is_dynamic ? "Yes" : "No");
             if (apps[i].is_dynamic) {
                 ESP_LOGI(TAG, "      Size: %lu bytes", apps[i].app_size);
             }
+            if (apps[i].source == APP_SOURCE_FLASH) {
+                ESP_LOGI(TAG, "      Image cache: %lu hits, %lu misses, last load %lu us",
+                         apps[i].cache_hits, apps[i].cache_misses, apps[i].load_time_us);
+            }
+#if CONFIG_SYSTEM_SERVICE_APP_CPU_ACCOUNTING
+            ESP_LOGI(TAG, "      CPU: %u%% (task %lu us, handlers %lu us)%s",
+                     apps[i].cpu_percent, apps[i].cpu_task_us, apps[i].cpu_handler_us,
+                     apps[i].cpu_throttled ? ", throttled" : "");
+#endif
         }
     }
     
@@ -437,10 +522,13 @@ void app_main(void)
 {
     esp_err_t ret;
     
+    boot_trace_mark("app_main");
+    
     // ========================================================================
     // STEP 0: Initialize NVS (REQUIRED for Bluetooth and WiFi)
     // ========================================================================
     ESP_LOGI(TAG, "Initializing NVS...");
+    boot_trace_id_t phase = boot_trace_begin("nvs");
     ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         // NVS partition was truncated and needs to be erased
@@ -449,6 +537,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_trace_end(phase);
     ESP_LOGI(TAG, "✓ NVS initialized");
     ESP_LOGI(TAG, "");
     
@@ -458,7 +547,9 @@ void app_main(void)
     // ========================================================================
     // STEP 1: Initialize System Service (REQUIRED FIRST)
     // ========================================================================
+    phase = boot_trace_begin("system_service");
     ret = init_system_service();
+    boot_trace_end(phase);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "CRITICAL: System service initialization failed!");
         ESP_LOGE(TAG, "System cannot continue. Rebooting in 5 seconds...");
@@ -479,7 +570,9 @@ void app_main(void)
     // - Subscribe to events
     // - Post events
     
+    phase = boot_trace_begin("app_services");
     init_application_services();
+    boot_trace_end(phase);
     
     // ========================================================================
     // STEP 3: Start Main Application Task
@@ -505,6 +598,10 @@ void app_main(void)
     ESP_LOGI(TAG, "╚════════════════════════════════════════════════════╝");
     ESP_LOGI(TAG, "");
     
+    // Boot ends here: log the waterfall and keep the profile in NVS
+    boot_trace_finish();
+    boot_trace_print_history();
+    
     // Print initial statistics
     vTaskDelay(pdMS_TO_TICKS(1000));
     print_system_stats();
@@ -0,0 +1,73 @@
+/**
+ * @file host_bench.c
+ * @brief Host-native benchmark run of the system service
+ *
+ * Builds components/system for the ESP-IDF linux target (FreeRTOS POSIX
+ * port) and runs the same micro-benchmarks as the device, followed by a
+ * many-producer load. Output is BENCH,<group>,<metric>,<value>,<unit>
+ * lines, the format CONFIG_SYSTEM_SERVICE_BENCHMARK prints on the device.
+ *
+ *     cd tools/host_bench
+ *     idf.py --preview set-target linux
+ *     idf.py build
+ *     LOAD_PRODUCERS=16 LOAD_SUBSCRIBERS=8 ./build/host_bench.elf | grep ^BENCH
+ *
+ * The binary is an ordinary process, so perf, valgrind and sanitizers
+ * work on it. The host has one FreeRTOS core and a 1 ms tick: compare
+ * trends and ratios with the device, not absolute numbers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "system_service/system_service.h"
+#include "system_bench.h"
+#include "load_gen.h"
+
+static const char *TAG = "host_bench";
+
+void app_main(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        ret = nvs_flash_init();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS unavailable: %s", esp_err_to_name(ret));
+    }
+    
+    system_secure_key_t secure_key;
+    ret = system_service_init(&secure_key);
+    if (ret == ESP_OK) {
+        ret = system_service_start(secure_key);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "System service failed to start: %s", esp_err_to_name(ret));
+        exit(1);
+    }
+    
+    int status = 0;
+    
+    ret = system_bench_run();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGE(TAG, "Benchmarks failed: %s", esp_err_to_name(ret));
+        status = 1;
+    }
+    
+    load_gen_config_t config;
+    load_gen_config_from_env(&config);
+    ret = load_gen_run(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Load run failed: %s", esp_err_to_name(ret));
+        status = 1;
+    }
+    
+    fflush(stdout);
+    system_service_stop(secure_key);
+    system_service_deinit(secure_key);
+    exit(status);
+}
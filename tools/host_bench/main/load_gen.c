@@ -0,0 +1,319 @@
+/**
+ * @file load_gen.c
+ * @brief Many-producer load generator for the event bus
+ *
+ * Producers post with system_event_try_post() and back off for a tick
+ * when the bus pushes back, so the refusal count is the backpressure the
+ * shape caused. Subscribers record post-to-handler latency in log2
+ * buckets, read out as bucket upper bounds.
+ */
+
+#include "load_gen.h"
+#include "system_service/service_manager.h"
+#include "system_service/event_bus.h"
+#include "system_service/error_codes.h"
+#include "resource_quota.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "load_gen";
+
+#define MAX_PRODUCERS       32
+#define MAX_SUBSCRIBERS     16
+#define MAX_TYPES           16
+#define MAX_PAYLOAD         512
+#define LATENCY_BUCKETS     32
+#define PRODUCER_STACK_SIZE 4096
+
+typedef struct {
+    system_service_id_t service_id;
+    uint32_t index;
+    uint32_t posted;
+    uint32_t refused;
+    uint32_t failed;
+} producer_t;
+
+typedef struct {
+    const load_gen_config_t *config;
+    system_event_type_t types[MAX_TYPES];
+    system_service_id_t subscribers[MAX_SUBSCRIBERS];
+    producer_t producers[MAX_PRODUCERS];
+    uint32_t subscriber_count;
+    uint32_t producer_count;
+    
+    SemaphoreHandle_t finished;
+    volatile bool stop;
+    
+    uint32_t delivered;
+    uint32_t latency_max_us;
+    uint32_t latency[LATENCY_BUCKETS];
+} load_run_t;
+
+static load_run_t s_run;
+
+static uint32_t env_u32(const char *name, uint32_t fallback, uint32_t max)
+{
+    const char *value = getenv(name);
+    if (value == NULL || *value == '\0') {
+        return fallback;
+    }
+    unsigned long parsed = strtoul(value, NULL, 0);
+    return parsed > max ? max : (uint32_t)parsed;
+}
+
+void load_gen_config_from_env(load_gen_config_t *config)
+{
+    config->producers = env_u32("LOAD_PRODUCERS", 8, MAX_PRODUCERS);
+    config->subscribers = env_u32("LOAD_SUBSCRIBERS", 4, MAX_SUBSCRIBERS);
+    config->event_types = env_u32("LOAD_TYPES", 4, MAX_TYPES);
+    config->payload_size = env_u32("LOAD_PAYLOAD", 32, MAX_PAYLOAD);
+    config->duration_ms = env_u32("LOAD_SECONDS", 10, 3600) * 1000;
+    config->rate_per_producer = env_u32("LOAD_RATE", 0, 1000000);
+}
+
+static void report(const char *metric, uint32_t value, const char *unit)
+{
+    printf("BENCH,load,%s,%lu,%s\n", metric, (unsigned long)value, unit);
+}
+
+static uint32_t bucket_of(uint32_t us)
+{
+    uint32_t bucket = 0;
+    while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Upper bound of the bucket holding the given fraction of samples
+ */
+static uint32_t latency_percentile(const load_run_t *run, uint32_t total, uint32_t per_mille)
+{
+    uint64_t target = ((uint64_t)total * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += run->latency[b];
+        if (seen >= target && seen > 0) {
+            return 2u << b;
+        }
+    }
+    return run->latency_max_us;
+}
+
+static void subscriber_handler(const system_event_t *event, void *user_data)
+{
+    load_run_t *run = (load_run_t *)user_data;
+    uint32_t latency = (uint32_t)esp_timer_get_time() - event->post_time_us;
+    
+    __atomic_add_fetch(&run->delivered, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&run->latency[bucket_of(latency)], 1, __ATOMIC_RELAXED);
+    
+    uint32_t max = __atomic_load_n(&run->latency_max_us, __ATOMIC_RELAXED);
+    while (latency > max &&
+           !__atomic_compare_exchange_n(&run->latency_max_us, &max, latency, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void producer_task(void *arg)
+{
+    producer_t *producer = (producer_t *)arg;
+    load_run_t *run = &s_run;
+    const load_gen_config_t *config = run->config;
+    
+    uint8_t payload[MAX_PAYLOAD];
+    memset(payload, (int)producer->index, sizeof(payload));
+    
+    // Paced producers post a tick's worth at a time
+    uint32_t per_tick = 0;
+    if (config->rate_per_producer > 0) {
+        per_tick = (config->rate_per_producer + configTICK_RATE_HZ - 1) / configTICK_RATE_HZ;
+    }
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t sequence = producer->index;
+    
+    while (!run->stop) {
+        uint32_t burst = per_tick > 0 ? per_tick : UINT32_MAX;
+        for (uint32_t i = 0; i < burst && !run->stop; i++, sequence++) {
+            system_event_type_t type = run->types[sequence % config->event_types];
+            system_event_priority_t priority = (system_event_priority_t)(sequence % 3);
+    
+            esp_err_t ret = system_event_try_post(producer->service_id, type, payload,
+                                                  config->payload_size, priority);
+            if (ret == ESP_OK) {
+                producer->posted++;
+            } else if (ret == ESP_ERR_EVENT_QUEUE_FULL || ret == ESP_ERR_QUOTA_EVENTS_EXCEEDED) {
+                producer->refused++;
+                vTaskDelay(1);
+            } else {
+                producer->failed++;
+                vTaskDelay(1);
+            }
+        }
+        if (per_tick > 0) {
+            vTaskDelayUntil(&last_wake, 1);
+        }
+    }
+    
+    xSemaphoreGive(run->finished);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t setup(load_run_t *run)
+{
+    const load_gen_config_t *config = run->config;
+    char name[24];
+    
+    for (uint32_t t = 0; t < config->event_types; t++) {
+        snprintf(name, sizeof(name), "load.type%lu", (unsigned long)t);
+        esp_err_t ret = system_event_register_type(name, &run->types[t]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s: %s", name, esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    for (uint32_t s = 0; s < config->subscribers; s++) {
+        snprintf(name, sizeof(name), "load_sub%lu", (unsigned long)s);
+        esp_err_t ret = system_service_register(name, run, &run->subscribers[s]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s: %s", name, esp_err_to_name(ret));
+            return ret;
+        }
+        run->subscriber_count++;
+    
+        service_quota_t quota;
+        if (quota_get(run->subscribers[s], &quota) == ESP_OK && quota.max_subscriptions < config->event_types) {
+            quota.max_subscriptions = config->event_types;
+            quota_set(run->subscribers[s], &quota);
+        }
+    
+        for (uint32_t t = 0; t < config->event_types; t++) {
+            ret = system_event_subscribe(run->subscribers[s], run->types[t], subscriber_handler, run);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "%s failed to subscribe: %s", name, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+    }
+    
+    for (uint32_t p = 0; p < config->producers; p++) {
+        producer_t *producer = &run->producers[p];
+        snprintf(name, sizeof(name), "load_prod%lu", (unsigned long)p);
+        esp_err_t ret = system_service_register(name, run, &producer->service_id);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register %s: %s", name, esp_err_to_name(ret));
+            return ret;
+        }
+        producer->index = p;
+        run->producer_count++;
+    
+        // The rate is the load's to set, not the default quota's
+        service_quota_t quota;
+        if (quota_get(producer->service_id, &quota) == ESP_OK) {
+            quota.max_events_per_sec = 0;
+            quota_set(producer->service_id, &quota);
+        }
+    }
+    
+    run->finished = xSemaphoreCreateCounting(MAX_PRODUCERS, 0);
+    return run->finished != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void teardown(load_run_t *run)
+{
+    for (uint32_t p = 0; p < run->producer_count; p++) {
+        system_service_unregister(run->producers[p].service_id);
+    }
+    for (uint32_t s = 0; s < run->subscriber_count; s++) {
+        system_service_unregister(run->subscribers[s]);
+    }
+    if (run->finished != NULL) {
+        vSemaphoreDelete(run->finished);
+    }
+    memset(run, 0, sizeof(*run));
+}
+
+esp_err_t load_gen_run(const load_gen_config_t *config)
+{
+    load_run_t *run = &s_run;
+    memset(run, 0, sizeof(*run));
+    run->config = config;
+    
+    if (config->producers == 0 || config->subscribers == 0 || config->event_types == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = setup(run);
+    if (ret != ESP_OK) {
+        teardown(run);
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "%" PRIu32 " producers, %" PRIu32 " subscribers, %" PRIu32 " types, "
+             "%" PRIu32 "-byte payloads for %" PRIu32 " ms",
+             config->producers, config->subscribers, config->event_types,
+             config->payload_size, config->duration_ms);
+    
+    report("producers", config->producers, "count");
+    report("subscribers", config->subscribers, "count");
+    report("event_types", config->event_types, "count");
+    report("payload", config->payload_size, "bytes");
+    report("rate_per_producer", config->rate_per_producer, "1/s");
+    
+    int64_t start = esp_timer_get_time();
+    uint32_t started = 0;
+    for (uint32_t p = 0; p < run->producer_count; p++) {
+        if (xTaskCreate(producer_task, "load_prod", PRODUCER_STACK_SIZE, &run->producers[p],
+                        uxTaskPriorityGet(NULL), NULL) == pdPASS) {
+            started++;
+        }
+    }
+    
+    vTaskDelay(pdMS_TO_TICKS(config->duration_ms));
+    run->stop = true;
+    for (uint32_t p = 0; p < started; p++) {
+        xSemaphoreTake(run->finished, portMAX_DELAY);
+    }
+    int64_t posting_us = esp_timer_get_time() - start;
+    
+    // Let the bus drain before the last count
+    vTaskDelay(pdMS_TO_TICKS(500));
+    
+    uint32_t posted = 0;
+    uint32_t refused = 0;
+    uint32_t failed = 0;
+    for (uint32_t p = 0; p < run->producer_count; p++) {
+        posted += run->producers[p].posted;
+        refused += run->producers[p].refused;
+        failed += run->producers[p].failed;
+    }
+    uint32_t delivered = __atomic_load_n(&run->delivered, __ATOMIC_RELAXED);
+    
+    report("elapsed", (uint32_t)posting_us, "us");
+    report("posted", posted, "count");
+    report("refused", refused, "count");
+    report("failed", failed, "count");
+    report("delivered", delivered, "count");
+    report("expected_deliveries", posted * run->subscriber_count, "count");
+    if (posting_us > 0) {
+        report("events_per_sec", (uint32_t)((uint64_t)posted * 1000000 / posting_us), "1/s");
+        report("deliveries_per_sec", (uint32_t)((uint64_t)delivered * 1000000 / posting_us), "1/s");
+    }
+    report("latency_p50", latency_percentile(run, delivered, 500), "us");
+    report("latency_p99", latency_percentile(run, delivered, 990), "us");
+    report("latency_p999", latency_percentile(run, delivered, 999), "us");
+    report("latency_max", run->latency_max_us, "us");
+    
+    teardown(run);
+    return ESP_OK;
+}
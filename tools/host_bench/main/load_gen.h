@@ -0,0 +1,55 @@
+/**
+ * @file load_gen.h
+ * @brief Many-producer load generator for the event bus
+ * 
+ * Producer services post round-robin over a set of event types, each of
+ * which every subscriber service handles. Results use the benchmark
+ * format, BENCH,load,<metric>,<value>,<unit>, so host and device runs
+ * can be compared line by line.
+ */
+
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load shape
+ */
+typedef struct {
+    uint32_t producers;             /**< Posting services, one task each */
+    uint32_t subscribers;           /**< Services subscribed to every type */
+    uint32_t event_types;           /**< Types the producers rotate over */
+    uint32_t payload_size;          /**< Bytes per event */
+    uint32_t duration_ms;           /**< Length of the run */
+    uint32_t rate_per_producer;     /**< Events/s per producer, 0 = as fast as accepted */
+} load_gen_config_t;
+
+/**
+ * @brief Fill a config from LOAD_PRODUCERS, LOAD_SUBSCRIBERS, LOAD_TYPES,
+ *        LOAD_PAYLOAD, LOAD_SECONDS and LOAD_RATE, with defaults for
+ *        unset variables
+ * 
+ * @param config Output config
+ */
+void load_gen_config_from_env(load_gen_config_t *config);
+
+/**
+ * @brief Run one load and print its results
+ * 
+ * @param config Load shape
+ * @return ESP_OK on success, error code if services or types could not
+ *         be registered
+ */
+esp_err_t load_gen_run(const load_gen_config_t *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOAD_GEN_H
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Build the UI asset pack for the display service's "assets" partition.
+
+Images (PNG, via Pillow) are converted to RGB565, or RGB565A8 when they have
+an alpha channel. Glyph atlases are pre-rendered A8 bitmaps taken from an
+LVGL built-in font source, so they match the compiled-in font exactly and
+the device only has to blit them.
+
+    tools/mkassets.py -o build/assets.bin \\
+        --font montserrat_14=managed_components/lvgl__lvgl/src/font/lv_font_montserrat_14.c \\
+        --image wifi=icons/wifi.png
+
+    parttool.py write_partition --partition-name assets --input build/assets.bin
+
+The layout mirrors components/display/src/display_assets.c.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+PACK_MAGIC = 0x3153414B  # "KAS1"
+PACK_VERSION = 1
+NAME_LEN = 24
+
+TYPE_IMAGE = 1
+TYPE_GLYPHS = 2
+FMT_RGB565 = 1
+FMT_RGB565A8 = 2
+
+HEADER = struct.Struct("<IHHII")
+ENTRY = struct.Struct("<24sBBHHHII")
+GLYPH = struct.Struct("<IIHH")
+
+
+def align4(data):
+    return data + b"\0" * (-len(data) % 4)
+
+
+def c_array(src, name):
+    """Body of `... name[] = { ... };` as a list of integers."""
+    m = re.search(r"\b%s\[\]\s*=\s*\{(.*?)\};" % name, src, re.S)
+    if not m:
+        return None
+    body = re.sub(r"/\*.*?\*/", "", m.group(1), flags=re.S)
+    return [int(tok, 0) for tok in re.findall(r"0x[0-9a-fA-F]+|\d+", body)]
+
+
+def parse_font(path, first, last):
+    """Glyphs of an lv_font_conv generated font as {codepoint: (w, h, a8)}."""
+    src = open(path, encoding="utf-8").read()
+
+    bpp = int(re.search(r"\.bpp\s*=\s*(\d+)", src).group(1))
+    fmt = re.search(r"\.bitmap_format\s*=\s*(\d+)", src)
+    if fmt and int(fmt.group(1)) != 0:
+        sys.exit("%s: compressed fonts are not supported" % path)
+
+    bitmap = c_array(src, "glyph_bitmap")
+    dsc = [tuple(int(v) for v in g) for g in re.findall(
+        r"\.bitmap_index\s*=\s*(\d+),\s*\.adv_w\s*=\s*\d+,\s*"
+        r"\.box_w\s*=\s*(\d+),\s*\.box_h\s*=\s*(\d+)", src)]
+
+    # codepoint -> glyph id, from the cmap table
+    glyph_ids = {}
+    for cmap in re.finditer(r"\{\s*\.range_start\s*=\s*(\d+).*?\}", src, re.S):
+        text = cmap.group(0)
+        start = int(cmap.group(1))
+        length = int(re.search(r"\.range_length\s*=\s*(\d+)", text).group(1))
+        gid_start = int(re.search(r"\.glyph_id_start\s*=\s*(\d+)", text).group(1))
+        ctype = re.search(r"\.type\s*=\s*LV_FONT_FMT_TXT_CMAP_(\w+)", text).group(1)
+        ulist = re.search(r"\.unicode_list\s*=\s*(\w+)", text).group(1)
+        olist = re.search(r"\.glyph_id_ofs_list\s*=\s*(\w+)", text).group(1)
+
+        if ctype == "FORMAT0_TINY":
+            for i in range(length):
+                glyph_ids[start + i] = gid_start + i
+        elif ctype == "FORMAT0_FULL":
+            for i, ofs in enumerate(c_array(src, olist)):
+                glyph_ids[start + i] = gid_start + ofs
+        elif ctype == "SPARSE_TINY":
+            for i, delta in enumerate(c_array(src, ulist)):
+                glyph_ids[start + delta] = gid_start + i
+        elif ctype == "SPARSE_FULL":
+            ofs = c_array(src, olist)
+            for i, delta in enumerate(c_array(src, ulist)):
+                glyph_ids[start + delta] = gid_start + ofs[i]
+
+    # Same expansion as LVGL: row bits are packed back to back, MSB first
+    scale = 255 // ((1 << bpp) - 1)
+    glyphs = {}
+    for cp, gid in sorted(glyph_ids.items()):
+        if not first <= cp <= last:
+            continue
+        index, w, h = dsc[gid]
+        if w == 0 or h == 0:
+            continue
+        out = bytearray(w * h)
+        for px in range(w * h):
+            bit = px * bpp
+            value = (bitmap[index + bit // 8] >> (8 - bpp - bit % 8)) & ((1 << bpp) - 1)
+            out[px] = value * scale
+        glyphs[cp] = (w, h, bytes(out))
+    return glyphs
+
+
+def atlas_data(glyphs):
+    table_size = 4 + GLYPH.size * len(glyphs)
+    table = struct.pack("<I", len(glyphs))
+    bitmaps = b""
+    for cp in sorted(glyphs):
+        w, h, a8 = glyphs[cp]
+        table += GLYPH.pack(cp, table_size + len(bitmaps), w, h)
+        bitmaps += align4(a8)
+    return table + bitmaps
+
+
+def image_data(path):
+    from PIL import Image
+
+    img = Image.open(path)
+    has_alpha = img.mode in ("RGBA", "LA") or "transparency" in img.info
+    img = img.convert("RGBA")
+    color = bytearray()
+    alpha = bytearray()
+    for r, g, b, a in img.getdata():
+        color += struct.pack("<H", ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3))
+        alpha.append(a)
+    data = bytes(color) + (bytes(alpha) if has_alpha else b"")
+    return img.size, FMT_RGB565A8 if has_alpha else FMT_RGB565, data
+
+
+def name_arg(text):
+    name, sep, path = text.partition("=")
+    if not sep or not name or len(name.encode()) >= NAME_LEN:
+        raise argparse.ArgumentTypeError("expected NAME=PATH, NAME under %d bytes" % NAME_LEN)
+    return name, path
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--image", type=name_arg, action="append", default=[], metavar="NAME=PNG")
+    parser.add_argument("--font", type=name_arg, action="append", default=[], metavar="NAME=FONT.c")
+    parser.add_argument("--range", default="0x20-0x7e",
+                        help="codepoints to pre-render (default printable ASCII)")
+    parser.add_argument("--size", type=lambda v: int(v, 0), default=0x100000,
+                        help="partition size to check against")
+    args = parser.parse_args()
+
+    first, last = (int(v, 0) for v in args.range.split("-"))
+
+    entries = []
+    for name, path in args.font:
+        glyphs = parse_font(path, first, last)
+        entries.append((name, TYPE_GLYPHS, 0, 0, 0, atlas_data(glyphs)))
+        print("font  %-24s %4d glyphs" % (name, len(glyphs)))
+    for name, path in args.image:
+        (w, h), fmt, data = image_data(path)
+        entries.append((name, TYPE_IMAGE, fmt, w, h, data))
+        print("image %-24s %dx%d%s" % (name, w, h, " alpha" if fmt == FMT_RGB565A8 else ""))
+
+    offset = HEADER.size + ENTRY.size * len(entries)
+    table = b""
+    blobs = b""
+    for name, etype, fmt, w, h, data in entries:
+        table += ENTRY.pack(name.encode(), etype, fmt, 0, w, h, offset + len(blobs), len(data))
+        blobs += align4(data)
+
+    total = offset + len(blobs)
+    if total > args.size:
+        sys.exit("pack is %d bytes, partition holds %d" % (total, args.size))
+
+    with open(args.output, "wb") as f:
+        f.write(HEADER.pack(PACK_MAGIC, PACK_VERSION, len(entries), total, 0) + table + blobs)
+    print("%s: %d bytes" % (args.output, total))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,386 @@
+#!/usr/bin/env python3
+"""Convert a system trace or flight recorder dump to Chrome/Perfetto trace JSON.
+
+The dump comes from CONFIG_SYSTEM_SERVICE_TRACE or
+CONFIG_SYSTEM_SERVICE_FLIGHT_RECORDER, as a raw file, as a serial log
+holding the base64 block system_trace_dump_console() prints between
+KTRACE-BEGIN and KTRACE-END (flight_recorder_dump_console(): KFLIGHT), or
+straight off the network from network_telemetry_upload_trace() or
+network_telemetry_upload_flight():
+
+    tools/trace2json.py monitor.log -o trace.json
+    tools/trace2json.py --listen 5556 --save trace.bin -o trace.json
+
+Open the JSON in https://ui.perfetto.dev or chrome://tracing. Handlers and
+system_lock waits are slices on the task that ran them; posts, dequeues and
+pool fallbacks are instants on that task; watchdog actions are global.
+A flight log has one process per boot, labelled with its reset reason,
+with the sampled metrics as counters and safe mode entries as markers.
+
+The layouts mirror system_trace.h and flight_recorder.h in
+components/system/include/system_service/.
+"""
+
+import argparse
+import base64
+import json
+import socket
+import struct
+import sys
+import zlib
+
+TRACE_MAGIC = 0x3152544B  # "KTR1"
+TRACE_VERSION = 1
+
+HEADER = struct.Struct("<IHBBIIII")
+RECORD = struct.Struct("<IBBHII")
+NAME = struct.Struct("<B3xI24s")
+
+T_SYNC = 1
+T_EVENT_POST = 2
+T_EVENT_DEQUEUE = 3
+T_HANDLER_BEGIN = 4
+T_HANDLER_END = 5
+T_POOL_FALLBACK = 6
+T_LOCK_WAIT_BEGIN = 7
+T_LOCK_WAIT_END = 8
+T_WATCHDOG = 9
+
+NAME_EVENT_TYPE = 1
+NAME_SERVICE = 2
+NAME_TASK = 3
+NAME_METRIC = 4
+
+FLIGHT_DUMP_MAGIC = 0x3144464B  # "KFD1"
+FLIGHT_SECTOR_MAGIC = 0x3152464B  # "KFR1"
+FLIGHT_VERSION = 1
+
+FLIGHT_HEADER = struct.Struct("<IHHIIII")
+SECTOR = struct.Struct("<IIIIIHHII")
+ENTRY = struct.Struct("<BBHI")
+BOOT = struct.Struct("<II")
+METRICS = struct.Struct("<IIHH")
+METRIC = struct.Struct("<HBBiII")
+
+E_BOOT = 1
+E_TRACE = 2
+E_NAMES = 3
+E_METRICS = 4
+E_MARK = 5
+
+METRIC_HISTOGRAM = 2
+
+RESET_REASONS = ["unknown", "power on", "external", "software", "panic", "interrupt watchdog",
+                 "task watchdog", "watchdog", "deep sleep", "brownout", "SDIO", "USB", "JTAG",
+                 "eFuse", "power glitch", "CPU lockup"]
+
+WATCHDOG_ACTIONS = ["timeout", "recovered", "restart", "restart failed", "safe mode"]
+
+
+def unwrap32(values):
+    """Extend free-running 32-bit counters; small steps back are reordering, not wraps."""
+    out = []
+    last = None
+    for v in values:
+        if last is None:
+            last = v
+        else:
+            last += ((v - last + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        out.append(last)
+    return out
+
+
+def from_console(text):
+    """Bytes of the last KTRACE or KFLIGHT block in a log."""
+    lines = text.splitlines()
+    ends = [(i, line.strip()[:-len("-END")]) for i, line in enumerate(lines)
+            if line.strip().endswith(("KTRACE-END", "KFLIGHT-END"))]
+    try:
+        end, marker = ends[-1]
+        begin = max(i for i, line in enumerate(lines[:end]) if line.strip().endswith(marker + "-BEGIN"))
+    except (IndexError, ValueError):
+        sys.exit("no KTRACE or KFLIGHT block found")
+    return base64.b64decode("".join(line.strip() for line in lines[begin + 1:end]))
+
+
+def receive(port, save):
+    """Accept one upload on `port` and return its bytes."""
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as srv:
+        srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        srv.bind(("", port))
+        srv.listen(1)
+        print("waiting for a trace on port %d" % port, file=sys.stderr)
+        conn, addr = srv.accept()
+        chunks = []
+        with conn:
+            while True:
+                chunk = conn.recv(65536)
+                if not chunk:
+                    break
+                chunks.append(chunk)
+    data = b"".join(chunks)
+    print("%d bytes from %s" % (len(data), addr[0]), file=sys.stderr)
+    if save:
+        with open(save, "wb") as f:
+            f.write(data)
+    return data
+
+
+def parse_names(data, offset, count):
+    names = {}
+    for i in range(count):
+        kind, ident, name = NAME.unpack_from(data, offset + i * NAME.size)
+        names[(kind, ident)] = name.split(b"\0", 1)[0].decode("utf-8", "replace")
+    return names
+
+
+def parse(data):
+    magic, version, cores, record_size, record_count, name_count, freq, dropped = \
+        HEADER.unpack_from(data, 0)
+    if magic != TRACE_MAGIC:
+        sys.exit("not a trace dump (magic 0x%08x)" % magic)
+    if version != TRACE_VERSION or record_size != RECORD.size:
+        sys.exit("unsupported trace version %d, record size %d" % (version, record_size))
+
+    offset = HEADER.size
+    need = offset + record_count * RECORD.size + name_count * NAME.size
+    if len(data) < need:
+        sys.exit("dump truncated: %d of %d bytes" % (len(data), need))
+
+    records = [RECORD.unpack_from(data, offset + i * RECORD.size) for i in range(record_count)]
+    offset += record_count * RECORD.size
+
+    names = parse_names(data, offset, name_count)
+    return cores, freq, dropped, records, names
+
+
+def timestamps(records, freq):
+    """Microseconds for each record, from cycles mapped through its core's SYNC points."""
+    by_core = {}
+    for index, rec in enumerate(records):
+        by_core.setdefault(rec[2], []).append(index)
+
+    times = [0.0] * len(records)
+    for indices in by_core.values():
+        cycles = unwrap32(records[i][0] for i in indices)
+        syncs = [(c, records[i][4]) for c, i in zip(cycles, indices) if records[i][1] == T_SYNC]
+        sync_us = unwrap32(us for _, us in syncs)
+        points = [(c, us) for (c, _), us in zip(syncs, sync_us)]
+        if not points:
+            points = [(cycles[0], 0)]
+
+        seg = 0
+        for c, i in sorted(zip(cycles, indices)):
+            while seg + 1 < len(points) and points[seg + 1][0] <= c:
+                seg += 1
+            c0, us0 = points[seg]
+            if seg + 1 < len(points) and points[seg + 1][0] > c0:
+                c1, us1 = points[seg + 1]
+                rate = (us1 - us0) / (c1 - c0)
+            elif seg > 0 and points[seg][0] > points[seg - 1][0]:
+                c1, us1 = points[seg - 1]
+                rate = (us0 - us1) / (c0 - c1)
+            else:
+                rate = 1e6 / freq
+            times[i] = us0 + (c - c0) * rate
+    return times
+
+
+def trace_events(records, times, names, pid, base):
+    """Perfetto events for trace records; returns the events and the tasks seen."""
+    def label(kind, ident, fallback):
+        return names.get((kind, ident), fallback % ident)
+
+    def event_name(t):
+        return label(NAME_EVENT_TYPE, t, "event %d")
+
+    def service_name(s):
+        return label(NAME_SERVICE, s, "service %d")
+
+    events = []
+    tasks = set()
+    for (cycles, rtype, core, arg0, arg1, task), ts in sorted(zip(records, times), key=lambda r: r[1]):
+        ev = {"pid": pid, "tid": task, "ts": round(ts - base, 3)}
+        args = {"core": core}
+        if rtype == T_HANDLER_BEGIN or rtype == T_HANDLER_END:
+            ev.update(ph="B" if rtype == T_HANDLER_BEGIN else "E", name=event_name(arg0), cat="handler")
+            args["subscriber"] = service_name(arg1)
+        elif rtype == T_LOCK_WAIT_BEGIN:
+            ev.update(ph="B", name="system_lock wait", cat="lock")
+        elif rtype == T_LOCK_WAIT_END:
+            ev.update(ph="E", name="system_lock wait", cat="lock")
+            args["acquired"] = bool(arg1)
+        elif rtype == T_EVENT_POST:
+            ev.update(ph="i", s="t", name="post " + event_name(arg0), cat="event")
+            args["sender"] = service_name(arg1 & 0xFFFF)
+            args["priority"] = arg1 >> 16
+        elif rtype == T_EVENT_DEQUEUE:
+            ev.update(ph="i", s="t", name="dequeue " + event_name(arg0), cat="event")
+            args["sender"] = service_name(arg1 & 0xFFFF)
+        elif rtype == T_POOL_FALLBACK:
+            ev.update(ph="i", s="t", name="pool fallback", cat="memory")
+            args["bytes"] = arg1
+        elif rtype == T_WATCHDOG:
+            action = WATCHDOG_ACTIONS[arg1] if arg1 < len(WATCHDOG_ACTIONS) else str(arg1)
+            ev.update(ph="i", s="g", name="watchdog %s: %s" % (action, service_name(arg0)), cat="watchdog")
+        else:
+            continue
+        ev["args"] = args
+        events.append(ev)
+        tasks.add(task)
+
+    meta = [{"ph": "M", "pid": pid, "tid": task, "name": "thread_name",
+             "args": {"name": label(NAME_TASK, task, "task 0x%08x")}} for task in sorted(tasks)]
+    return meta + events
+
+
+def convert(data):
+    cores, freq, dropped, records, names = parse(data)
+    times = timestamps(records, freq)
+    base = min(times) if times else 0
+
+    meta = [{"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "kraken"}}]
+    events = trace_events(records, times, names, 0, base)
+
+    print("%d records on %d cores, %d overwritten before the dump" % (len(records), cores, dropped),
+          file=sys.stderr)
+    return {"traceEvents": meta + events, "displayTimeUnit": "ms"}
+
+
+def parse_flight(data):
+    """Boots of a flight log, oldest first, each with its entries in order."""
+    magic, version, sector_size, sectors, boot, minutes, freq = FLIGHT_HEADER.unpack_from(data, 0)
+    if version != FLIGHT_VERSION:
+        sys.exit("unsupported flight log version %d" % version)
+
+    boots = {}
+    offset = FLIGHT_HEADER.size
+    bad = 0
+    for _ in range(sectors):
+        if len(data) < offset + SECTOR.size:
+            print("flight log truncated", file=sys.stderr)
+            break
+        smagic, seq, sboot, first_ms, last_ms, used, entries, data_crc, _ = SECTOR.unpack_from(data, offset)
+        offset += SECTOR.size
+        body = data[offset:offset + used]
+        offset += used
+        if smagic != FLIGHT_SECTOR_MAGIC:
+            continue            # Overwritten while the log was read
+        if len(body) < used or zlib.crc32(body) != data_crc:
+            bad += 1
+            continue
+
+        out = boots.setdefault(sboot, [])
+        pos = 0
+        while pos + ENTRY.size <= used:
+            etype, core, length, ms = ENTRY.unpack_from(body, pos)
+            out.append((etype, core, ms, body[pos + ENTRY.size:pos + ENTRY.size + length]))
+            pos += ENTRY.size + ((length + 3) & ~3)
+
+    if bad:
+        print("%d sectors failed their CRC" % bad, file=sys.stderr)
+    return freq, boot, [(b, boots[b]) for b in sorted(boots)]
+
+
+def convert_flight(data):
+    freq, current, boots = parse_flight(data)
+
+    # Names by boot; labels fall back to other boots', as event types and
+    # services rarely change between them
+    all_names = {}
+    boot_names = {}
+    for boot, entries in boots:
+        names = boot_names.setdefault(boot, {})
+        for etype, _, _, payload in entries:
+            if etype == E_NAMES:
+                names.update(parse_names(payload, 0, len(payload) // NAME.size))
+        all_names.update(names)
+
+    meta = []
+    events = []
+    offset_us = 0.0
+    total_records = 0
+    total_lost = 0
+    for pid, (boot, entries) in enumerate(boots, 1):
+        names = dict(all_names)
+        names.update(boot_names[boot])
+        reason = "boot %d" % boot
+        records = []
+        end_us = 0.0
+
+        for etype, core, ms, payload in entries:
+            ts = offset_us + ms * 1000.0
+            end_us = max(end_us, ms * 1000.0)
+            if etype == E_BOOT and len(payload) >= BOOT.size:
+                code, _ = BOOT.unpack_from(payload, 0)
+                cause = RESET_REASONS[code] if code < len(RESET_REASONS) else str(code)
+                reason = "boot %d (%s)" % (boot, cause)
+                events.append({"ph": "i", "s": "g", "pid": pid, "tid": 0, "ts": round(ts, 3),
+                               "name": "boot: " + cause, "cat": "boot"})
+            elif etype == E_TRACE and len(payload) >= 4:
+                lost = struct.unpack_from("<I", payload)[0]
+                count = (len(payload) - 4) // RECORD.size
+                records += [RECORD.unpack_from(payload, 4 + i * RECORD.size) for i in range(count)]
+                total_lost += lost
+                if lost:
+                    events.append({"ph": "i", "s": "p", "pid": pid, "tid": 0, "ts": round(ts, 3),
+                                   "name": "%d records lost" % lost, "cat": "flight",
+                                   "args": {"core": core}})
+            elif etype == E_METRICS and len(payload) >= METRICS.size:
+                free, largest, count, _ = METRICS.unpack_from(payload, 0)
+                events.append({"ph": "C", "pid": pid, "ts": round(ts, 3), "name": "heap internal",
+                               "args": {"free": free, "largest": largest}})
+                for i in range(min(count, (len(payload) - METRICS.size) // METRIC.size)):
+                    ident, mtype, _, value, total, peak = METRIC.unpack_from(payload, METRICS.size + i * METRIC.size)
+                    name = names.get((NAME_METRIC, ident), "metric %d" % ident)
+                    args = {"count": value, "max": peak} if mtype == METRIC_HISTOGRAM else {"value": value}
+                    events.append({"ph": "C", "pid": pid, "ts": round(ts, 3), "name": name, "args": args})
+            elif etype == E_MARK:
+                events.append({"ph": "i", "s": "g", "pid": pid, "tid": 0, "ts": round(ts, 3),
+                               "name": payload.decode("utf-8", "replace"), "cat": "mark"})
+
+        if records:
+            times = timestamps(records, freq)
+            end_us = max(end_us, max(times))
+            events += trace_events(records, times, names, pid, -offset_us)
+            total_records += len(records)
+
+        meta.append({"ph": "M", "pid": pid, "name": "process_name", "args": {"name": reason}})
+        meta.append({"ph": "M", "pid": pid, "name": "process_sort_index", "args": {"sort_index": pid}})
+        offset_us += end_us + 1e6   # Boots back to back, a second apart
+
+    print("%d boots up to boot %d, %d records, %d lost before they were stored" %
+          (len(boots), current, total_records, total_lost), file=sys.stderr)
+    return {"traceEvents": meta + events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", nargs="?", help="raw dump or serial log")
+    parser.add_argument("--listen", type=int, metavar="PORT", help="receive one upload over TCP")
+    parser.add_argument("--save", metavar="FILE", help="with --listen, also keep the raw dump")
+    parser.add_argument("-o", "--output", help="JSON output (default stdout)")
+    args = parser.parse_args()
+
+    if args.listen:
+        data = receive(args.listen, args.save)
+    elif args.input:
+        data = open(args.input, "rb").read()
+        if len(data) < 4 or struct.unpack_from("<I", data)[0] not in (TRACE_MAGIC, FLIGHT_DUMP_MAGIC):
+            data = from_console(data.decode("utf-8", "replace"))
+    else:
+        parser.error("give an input file or --listen PORT")
+
+    if len(data) >= 4 and struct.unpack_from("<I", data)[0] == FLIGHT_DUMP_MAGIC:
+        trace = convert_flight(data)
+    else:
+        trace = convert(data)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()